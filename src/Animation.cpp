@@ -0,0 +1,408 @@
+#include "Animation.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+namespace Animation
+{
+	static constexpr u64 PARALLEL_BATCH_SIZE = 16;
+
+	// Forward steps of a cursor before it falls back to a binary search.
+	static constexpr u32 MAX_CURSOR_STEPS = 4;
+
+	// ====================================
+	//  Compression
+	// ====================================
+
+	static vec4 Dequantize(Key const& key, Track const& track)
+	{
+		vec4 value;
+		for (u32 c = 0; c < 4; ++c)
+		{
+			value.data[c] = track.range_min.data[c] + (f32)key.value[c] * track.range_scale.data[c];
+		}
+		return value;
+	}
+
+	// Matches the sampling kernel, lerp and for rotations normalize.
+	static vec4 Interpolate(vec4 const& a, vec4 const& b, f32 alpha, bool b_rotation)
+	{
+		vec4 value;
+		for (u32 c = 0; c < 4; ++c)
+		{
+			value.data[c] = a.data[c] + (b.data[c] - a.data[c]) * alpha;
+		}
+
+		if (b_rotation)
+		{
+			f32 const length_sq = value.x * value.x + value.y * value.y + value.z * value.z + value.w * value.w;
+			f32 const inv_length = 1.0f / sqrtf(max(length_sq, 1e-30f));
+			for (u32 c = 0; c < 4; ++c)
+			{
+				value.data[c] *= inv_length;
+			}
+		}
+
+		return value;
+	}
+
+	static f32 MaxError(vec4 const& a, vec4 const& b, u32 num_components)
+	{
+		f32 error = 0.0f;
+		for (u32 c = 0; c < num_components; ++c)
+		{
+			error = max(error, fabsf(a.data[c] - b.data[c]));
+		}
+		return error;
+	}
+
+	u32 CompressTrack(Track* out_track, u16* out_times, Key* out_keys, SourceTrack const& source, f32 duration,
+		Tolerances const& tolerances, Memory::Arena* scratch_memory)
+	{
+		ASSERT(source.num_keys > 0);
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		bool const b_rotation = source.type == TrackType::Rotation;
+		u32 const num_components = b_rotation ? 4 : 3;
+		f32 const tolerance = (source.type == TrackType::Translation) ? tolerances.translation :
+			b_rotation ? tolerances.rotation : tolerances.scale;
+
+		// Keys that land on the same tick keep the last value, ticks of the kept keys are strictly increasing.
+		u16* ticks = Memory::PushType<u16>(scratch_memory, source.num_keys);
+		vec4* values = Memory::PushType<vec4>(scratch_memory, source.num_keys);
+		f32 const tick_scale = (duration > 0.0f) ? (f32)MAX_TICK / duration : 0.0f;
+
+		u32 num_keys = 0;
+		for (u32 i = 0; i < source.num_keys; ++i)
+		{
+			u16 const tick = (u16)Clamp(source.times[i] * tick_scale + 0.5f, 0.0f, (f32)MAX_TICK);
+			u32 const dst = (num_keys > 0 && ticks[num_keys - 1] == tick) ? num_keys - 1 : num_keys;
+
+			vec4 value = source.values[i];
+			if (b_rotation && dst > 0)
+			{
+				vec4 const& prev = values[dst - 1];
+				if (value.x * prev.x + value.y * prev.y + value.z * prev.z + value.w * prev.w < 0.0f)
+				{
+					value = vec4(-value.x, -value.y, -value.z, -value.w);
+				}
+			}
+
+			ticks[dst] = tick;
+			values[dst] = value;
+			num_keys = dst + 1;
+		}
+
+		Track track;
+		MemZeroSafe(track);
+		track.node = source.node;
+		track.type = source.type;
+
+		vec4 range_max = values[0];
+		track.range_min = values[0];
+		for (u32 i = 1; i < num_keys; ++i)
+		{
+			for (u32 c = 0; c < num_components; ++c)
+			{
+				track.range_min.data[c] = min(track.range_min.data[c], values[i].data[c]);
+				range_max.data[c] = max(range_max.data[c], values[i].data[c]);
+			}
+		}
+
+		vec4 inv_scale = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+		for (u32 c = 0; c < num_components; ++c)
+		{
+			f32 const extent = range_max.data[c] - track.range_min.data[c];
+			track.range_scale.data[c] = extent / (f32)0xFFFF;
+			inv_scale.data[c] = (extent > 0.0f) ? (f32)0xFFFF / extent : 0.0f;
+		}
+		if (!b_rotation)
+		{
+			track.range_min.w = 0.0f;
+		}
+
+		Key* keys = Memory::PushType<Key>(scratch_memory, num_keys, Memory::ZeroPush());
+		vec4* dequantized = Memory::PushType<vec4>(scratch_memory, num_keys);
+		for (u32 i = 0; i < num_keys; ++i)
+		{
+			for (u32 c = 0; c < num_components; ++c)
+			{
+				f32 const q = (values[i].data[c] - track.range_min.data[c]) * inv_scale.data[c] + 0.5f;
+				keys[i].value[c] = (u16)Clamp(q, 0.0f, (f32)0xFFFF);
+			}
+			dequantized[i] = Dequantize(keys[i], track);
+		}
+
+		// Greedy key removal: a segment grows from the last kept key as long as interpolating across
+		// it stays within the tolerance at every source key it covers. Both curves are linear between
+		// source keys, so the error can't be larger anywhere in between.
+		u32* kept = Memory::PushType<u32>(scratch_memory, num_keys);
+		u32 num_kept = 0;
+		kept[num_kept++] = 0;
+
+		bool b_constant = true;
+		for (u32 i = 1; i < num_keys && b_constant; ++i)
+		{
+			b_constant = MaxError(dequantized[0], values[i], num_components) <= tolerance;
+		}
+
+		if (!b_constant)
+		{
+			u32 anchor = 0;
+			for (u32 end = 2; end < num_keys; ++end)
+			{
+				f32 const inv_span = 1.0f / (f32)(ticks[end] - ticks[anchor]);
+
+				bool b_within = true;
+				for (u32 i = anchor + 1; i < end && b_within; ++i)
+				{
+					f32 const alpha = (f32)(ticks[i] - ticks[anchor]) * inv_span;
+					vec4 const value = Interpolate(dequantized[anchor], dequantized[end], alpha, b_rotation);
+					b_within = MaxError(value, values[i], num_components) <= tolerance;
+				}
+
+				if (!b_within)
+				{
+					anchor = end - 1;
+					kept[num_kept++] = anchor;
+				}
+			}
+
+			if (num_keys > 1)
+			{
+				kept[num_kept++] = num_keys - 1;
+			}
+		}
+
+		for (u32 i = 0; i < num_kept; ++i)
+		{
+			out_times[i] = ticks[kept[i]];
+			out_keys[i] = keys[kept[i]];
+		}
+
+		track.num_keys = num_kept;
+		*out_track = track;
+		return num_kept;
+	}
+
+	void CopyClipLibrary(ClipLibrary* out_library, ClipLibrary const* library, Memory::Arena* arena)
+	{
+		*out_library = *library;
+		out_library->clips = Memory::PushType<Clip>(arena, library->num_clips);
+		out_library->tracks = Memory::PushType<Track>(arena, library->num_tracks, Memory::AlignPush(16));
+		out_library->key_times = Memory::PushType<u16>(arena, library->num_keys);
+		out_library->keys = Memory::PushType<Key>(arena, library->num_keys);
+
+		memcpy(out_library->clips, library->clips, sizeof(Clip) * library->num_clips);
+		memcpy(out_library->tracks, library->tracks, sizeof(Track) * library->num_tracks);
+		memcpy(out_library->key_times, library->key_times, sizeof(u16) * library->num_keys);
+		memcpy(out_library->keys, library->keys, sizeof(Key) * library->num_keys);
+	}
+
+	// ====================================
+	//  Players
+	// ====================================
+
+	void InitPlayer(Player* player, ClipLibrary const* library, u32 clip, Memory::Arena* arena)
+	{
+		u32 max_tracks = 1;
+		for (u32 i = 0; i < library->num_clips; ++i)
+		{
+			max_tracks = max(max_tracks, library->clips[i].num_tracks);
+		}
+
+		MemZeroSafe(player);
+		player->cursors = Memory::PushType<u32>(arena, max_tracks);
+		SetClip(player, library, clip);
+	}
+
+	void SetClip(Player* player, ClipLibrary const* library, u32 clip)
+	{
+		ASSERT(clip < library->num_clips);
+		player->clip = clip;
+		player->time = 0.0f;
+		memzero(player->cursors, sizeof(u32) * library->clips[clip].num_tracks);
+	}
+
+	void AdvancePlayer(Player* player, ClipLibrary const* library, f32 delta_time, bool b_loop)
+	{
+		f32 const duration = library->clips[player->clip].duration;
+		player->time += delta_time;
+
+		if (b_loop && duration > 0.0f)
+		{
+			// Wrapping jumps the cursors back, they find their keys again with a search.
+			player->time = fmodf(player->time, duration);
+			if (player->time < 0.0f)
+			{
+				player->time += duration;
+			}
+		}
+		else
+		{
+			player->time = Clamp(player->time, 0.0f, duration);
+		}
+	}
+
+	// ====================================
+	//  Sampling
+	// ====================================
+
+	// Keys cursor and cursor + 1 bracket the tick, clamped to the first and last pair.
+	static MM_FORCEINL u32 FindKey(u16 const* times, u32 num_keys, f32 tick, u32 cursor)
+	{
+		u32 lo = 0;
+		if (cursor + 1 < num_keys && tick >= (f32)times[cursor])
+		{
+			for (u32 step = 0; step < MAX_CURSOR_STEPS; ++step)
+			{
+				if (cursor + 2 >= num_keys || tick < (f32)times[cursor + 1])
+				{
+					return cursor;
+				}
+				++cursor;
+			}
+			lo = cursor;
+		}
+
+		// Seeks and wrapped loops, the last key at or before the tick that still has a successor.
+		u32 hi = num_keys - 1;
+		while (hi - lo > 1)
+		{
+			u32 const mid = (lo + hi) / 2;
+			if ((f32)times[mid] <= tick)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+
+	static MM_FORCEINL __m128 MM_VECTORCALL LoadKey(Key const& key)
+	{
+		__m128i const q = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(key.value)));
+		return _mm_cvtepi32_ps(q);
+	}
+
+	// Exactly 12 bytes, the members after the vec3 belong to the same transform.
+	static MM_FORCEINL void MM_VECTORCALL StoreVec3(f32* dst, __m128 v)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+		_mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+	}
+
+	static void SamplePlayer(Scene::Hierarchy* hierarchy, ClipLibrary const* library, Player* player)
+	{
+		Clip const& clip = library->clips[player->clip];
+		f32 const tick = (clip.duration > 0.0f) ? Clamp(player->time, 0.0f, clip.duration) * ((f32)MAX_TICK / clip.duration) : 0.0f;
+
+		Scene::Transform* locals = hierarchy->locals;
+		u8* flags = hierarchy->flags;
+
+		for (u32 track_idx = 0; track_idx < clip.num_tracks; ++track_idx)
+		{
+			Track const& track = library->tracks[clip.first_track + track_idx];
+			u16 const* times = library->key_times + track.first_key;
+			Key const* keys = library->keys + track.first_key;
+
+			// Interpolated in the quantized domain, dequantizing is linear.
+			__m128 q;
+			if (track.num_keys == 1)
+			{
+				q = LoadKey(keys[0]);
+			}
+			else
+			{
+				u32 const k = FindKey(times, track.num_keys, tick, player->cursors[track_idx]);
+				player->cursors[track_idx] = k;
+
+				f32 const t0 = (f32)times[k];
+				f32 const alpha = Clamp((tick - t0) / ((f32)times[k + 1] - t0), 0.0f, 1.0f);
+
+				__m128 const q0 = LoadKey(keys[k]);
+				__m128 const q1 = LoadKey(keys[k + 1]);
+				q = _mm_add_ps(q0, _mm_mul_ps(_mm_sub_ps(q1, q0), _mm_set1_ps(alpha)));
+			}
+
+			__m128 const value = _mm_add_ps(_mm_loadu_ps(track.range_min.data), _mm_mul_ps(q, _mm_loadu_ps(track.range_scale.data)));
+
+			u32 const node = (player->node_map != nullptr) ? player->node_map[track.node] : track.node;
+			ASSERT(node < hierarchy->num_nodes);
+
+			Scene::Transform& local = locals[node];
+			switch (track.type)
+			{
+			case TrackType::Translation:
+				StoreVec3(local.translation.data, value);
+				break;
+			case TrackType::Rotation:
+			{
+				__m128 const length_sq = _mm_max_ps(_mm_dp_ps(value, value, 0xFF), _mm_set1_ps(1e-30f));
+				_mm_storeu_ps(local.rotation.data, _mm_div_ps(value, _mm_sqrt_ps(length_sq)));
+				break;
+			}
+			case TrackType::Scale:
+				StoreVec3(local.scale.data, value);
+				break;
+			default:
+				ASSERT_FAIL();
+				break;
+			}
+
+			flags[node] |= Scene::NodeFlags::LocalDirty;
+		}
+	}
+
+	struct SampleTask
+	{
+		Scene::Hierarchy* hierarchy;
+		ClipLibrary const* library;
+		Player* players;
+	};
+
+	static void SampleBatch(void* user_data, u64 begin, u64 end)
+	{
+		SampleTask const* task = static_cast<SampleTask const*>(user_data);
+		for (u64 i = begin; i < end; ++i)
+		{
+			SamplePlayer(task->hierarchy, task->library, &task->players[i]);
+		}
+	}
+
+	void Sample(Scene::Hierarchy* hierarchy, ClipLibrary const* library, Player* players, u32 num_players)
+	{
+		u32 num_tracks = 0;
+		for (u32 i = 0; i < num_players; ++i)
+		{
+			ASSERT(players[i].clip < library->num_clips);
+			num_tracks += library->clips[players[i].clip].num_tracks;
+		}
+
+		if (num_tracks == 0)
+		{
+			return;
+		}
+
+		SampleTask task;
+		task.hierarchy = hierarchy;
+		task.library = library;
+		task.players = players;
+
+		if (num_tracks < PARALLEL_MIN_TRACKS || Jobs::GetThreadCount() == 1)
+		{
+			SampleBatch(&task, 0, num_players);
+		}
+		else
+		{
+			Jobs::ParallelFor(num_players, PARALLEL_BATCH_SIZE, &SampleBatch, &task);
+		}
+
+		// Set once here instead of per node by SetLocalTransform(), the batches would all write it.
+		hierarchy->b_any_dirty = true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+#include "Memory.h"
+#include "SceneGraph.h"
+
+// ====================================
+//  Animation Clips
+//  Notes:
+//  *) A clip is a set of tracks, each animating the translation,
+//     rotation or scale of one hierarchy node with linearly
+//     interpolated keys. Step and cubic spline curves are turned
+//     into linear keys on import.
+//  *) Keys are compressed per track: values are quantized to 16 bit
+//     in the range of the track, times to 16 bit ticks of the clip.
+//     Keys that interpolation reproduces within the tolerance of
+//     the track are removed.
+//  *) Times and values are separate arrays, the key search only
+//     touches the times.
+//  *) Every player keeps a cursor per track, so playing forward
+//     advances it by at most a key or two instead of searching.
+//  *) Rotations are interpolated with nlerp, keys are stored in
+//     the same hemisphere as their predecessor.
+// ====================================
+
+namespace Animation
+{
+	struct TrackType
+	{
+		enum Enum : u32
+		{
+			Translation,
+			Rotation,
+			Scale,
+
+			EnumCount
+		};
+	};
+
+	// Key times are ticks of the clip duration, the last tick is the end of the clip.
+	static constexpr u32 MAX_TICK = 0xFFFF;
+
+	// Quantized value, xyz for translation and scale, xyzw for rotations.
+	struct Key
+	{
+		u16 value[4];
+	};
+
+	struct Track
+	{
+		// value = range_min + key * range_scale, per component.
+		vec4 range_min;
+		vec4 range_scale;
+
+		u32 node;
+		u32 type; // TrackType
+		u32 first_key;
+		u32 num_keys;
+	};
+
+	struct Clip
+	{
+		f32 duration; // Seconds.
+		u32 first_track;
+		u32 num_tracks;
+	};
+
+	// All clips of an import. Clips are ranges of the tracks, tracks are ranges of the keys.
+	struct ClipLibrary
+	{
+		Clip* clips;
+		u32 num_clips;
+
+		Track* tracks;
+		u32 num_tracks;
+
+		u16* key_times;
+		Key* keys;
+		u32 num_keys;
+	};
+
+	// Largest error that removing keys may introduce, per component. Rotations are measured on the
+	// components of the unit quaternion, 1e-4 is roughly 0.01 degrees.
+	struct Tolerances
+	{
+		f32 translation = 1e-4f;
+		f32 rotation = 1e-4f;
+		f32 scale = 1e-4f;
+	};
+
+	// Linear keys of one track before compression, in engine space. Times are seconds and ascending,
+	// rotations are unit quaternions.
+	struct SourceTrack
+	{
+		f32 const* times;
+		vec4 const* values;
+		u32 num_keys;
+
+		u32 node;
+		TrackType::Enum type;
+	};
+
+	// Writes at most source.num_keys keys and returns how many. first_key of out_track is left to the caller.
+	// scratch_memory is only used for temporaries.
+	u32 CompressTrack(Track* out_track, u16* out_times, Key* out_keys, SourceTrack const& source, f32 duration,
+		Tolerances const& tolerances, Memory::Arena* scratch_memory);
+
+	// Copies all arrays into arena, e.g. to keep the clips of a mesh file after unmapping it.
+	void CopyClipLibrary(ClipLibrary* out_library, ClipLibrary const* library, Memory::Arena* arena);
+
+	// Plays one clip on a set of nodes. Players that are sampled together may not share nodes.
+	struct Player
+	{
+		u32 clip;
+		f32 time; // Seconds, clamped to the clip when sampling.
+
+		// One per track of the clip, see InitPlayer().
+		u32* cursors;
+
+		// Hierarchy node of every node the clip was imported with, to play it on a copy of them. Null to
+		// animate the imported nodes.
+		u32 const* node_map;
+	};
+
+	// Cursors are allocated in arena, for the largest clip of the library so the player can switch clips.
+	void InitPlayer(Player* player, ClipLibrary const* library, u32 clip, Memory::Arena* arena);
+
+	void SetClip(Player* player, ClipLibrary const* library, u32 clip);
+
+	// Looping wraps the time into the clip, otherwise it stops at the end.
+	void AdvancePlayer(Player* player, ClipLibrary const* library, f32 delta_time, bool b_loop);
+
+	// Below this many tracks in total the players are sampled on the calling thread.
+	static constexpr u32 PARALLEL_MIN_TRACKS = 4 * 1024;
+
+	// Writes the animated locals of every player to the hierarchy, UpdateWorldTransforms() picks them up.
+	// Blocks until all players are done.
+	void Sample(Scene::Hierarchy* hierarchy, ClipLibrary const* library, Player* players, u32 num_players);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
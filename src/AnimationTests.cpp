@@ -0,0 +1,313 @@
+#include "Animation.h"
+#include "TestUtils.h"
+
+namespace Animation
+{
+namespace Test
+{
+	static constexpr f32 DURATION = 3.0f;
+
+	// Source keys of a track, evenly spread over the clip.
+	struct Curve
+	{
+		f32 times[256];
+		vec4 values[256];
+		u32 num_keys;
+	};
+
+	// Smooth, with a different frequency per track. Rotations turn around a fixed axis and every third key is
+	// stored in the other hemisphere, which is the same rotation.
+	static void InitCurve(Curve* curve, TrackType::Enum type, u32 num_keys, f32 frequency)
+	{
+		curve->num_keys = num_keys;
+		for (u32 i = 0; i < num_keys; ++i)
+		{
+			f32 const t = DURATION * (f32)i / (f32)(num_keys - 1);
+			curve->times[i] = t;
+
+			if (type == TrackType::Rotation)
+			{
+				vec3 const axis = Math::Normalize(vec3(1.0f, frequency, -0.5f));
+				quat const q = Math::QuatAxisAngle(axis, Math::Rad(2.5f * sinf(frequency * t)));
+				f32 const sign = (i % 3 == 2) ? -1.0f : 1.0f;
+				curve->values[i] = vec4(sign * q.x, sign * q.y, sign * q.z, sign * q.w);
+			}
+			else
+			{
+				f32 const base = (type == TrackType::Scale) ? 1.0f : 0.0f;
+				curve->values[i] = vec4(base + sinf(frequency * t), base + 0.5f * cosf(2.0f * frequency * t), base + 0.1f * t, 0.0f);
+			}
+		}
+	}
+
+	// A single clip with one track per curve, track i animates node i.
+	static void BuildLibrary(ClipLibrary* library, Memory::Arena* arena, Curve const* curves, TrackType::Enum const* types,
+		u32 num_tracks, Tolerances const& tolerances)
+	{
+		u32 max_keys = 0;
+		for (u32 i = 0; i < num_tracks; ++i)
+		{
+			max_keys += curves[i].num_keys;
+		}
+
+		library->num_clips = 1;
+		library->clips = Memory::PushType<Clip>(arena, 1);
+		library->clips[0] = { DURATION, 0, num_tracks };
+		library->num_tracks = num_tracks;
+		library->tracks = Memory::PushType<Track>(arena, num_tracks, Memory::AlignPush(16));
+		library->key_times = Memory::PushType<u16>(arena, max_keys);
+		library->keys = Memory::PushType<Key>(arena, max_keys);
+
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+
+		u32 num_keys = 0;
+		for (u32 i = 0; i < num_tracks; ++i)
+		{
+			SourceTrack const source = { curves[i].times, curves[i].values, curves[i].num_keys, i, types[i] };
+			Track& track = library->tracks[i];
+			u32 const num_written = CompressTrack(&track, library->key_times + num_keys, library->keys + num_keys, source, DURATION,
+				tolerances, &scratch);
+			track.first_key = num_keys;
+			num_keys += num_written;
+		}
+		library->num_keys = num_keys;
+	}
+
+	// All nodes are roots with identity locals, remap receives their hierarchy nodes.
+	static void BuildNodes(Scene::Hierarchy* hierarchy, Memory::Arena* arena, u32 num_nodes, u32* remap)
+	{
+		u32* parents = Memory::PushType<u32>(arena, num_nodes);
+		Scene::Transform* locals = Memory::PushType<Scene::Transform>(arena, num_nodes);
+		for (u32 i = 0; i < num_nodes; ++i)
+		{
+			parents[i] = Scene::INVALID_NODE;
+			locals[i] = Scene::IdentityTransform();
+		}
+		Scene::BuildHierarchy(hierarchy, arena, parents, locals, num_nodes, remap);
+	}
+
+	static vec4 GetAnimatedValue(Scene::Hierarchy const& hierarchy, u32 node, TrackType::Enum type)
+	{
+		Scene::Transform const& local = hierarchy.locals[node];
+		switch (type)
+		{
+		case TrackType::Translation: return vec4(local.translation);
+		case TrackType::Rotation: return vec4(local.rotation.x, local.rotation.y, local.rotation.z, local.rotation.w);
+		default: return vec4(local.scale);
+		}
+	}
+
+	// q and -q are the same rotation.
+	static f32 MaxError(vec4 const& a, vec4 const& b, TrackType::Enum type)
+	{
+		f32 const sign = (type == TrackType::Rotation && a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f) ? -1.0f : 1.0f;
+		f32 error = 0.0f;
+		for (u32 c = 0; c < (type == TrackType::Rotation ? 4u : 3u); ++c)
+		{
+			error = max(error, fabsf(a.data[c] - sign * b.data[c]));
+		}
+		return error;
+	}
+
+	// Sampled at the ticks of the source keys, the clip stays within the tolerance of every one of them,
+	// plus rounding. With the looser one the smooth curves lose most of their keys.
+	void CompressedWithinTolerance()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TrackType::Enum const types[] = { TrackType::Translation, TrackType::Rotation, TrackType::Scale, TrackType::Rotation };
+		static constexpr u32 NUM_TRACKS = ARRAY_SIZE(types);
+		Curve* curves = Memory::PushType<Curve>(&arena, NUM_TRACKS);
+		for (u32 i = 0; i < NUM_TRACKS; ++i)
+		{
+			InitCurve(&curves[i], types[i], 200 + i * 17, 0.5f + 0.5f * (f32)i);
+		}
+
+		for (f32 tolerance : { 1e-4f, 1e-3f })
+		{
+			Tolerances tolerances;
+			tolerances.translation = tolerances.rotation = tolerances.scale = tolerance;
+
+			ClipLibrary library;
+			BuildLibrary(&library, &arena, curves, types, NUM_TRACKS, tolerances);
+
+			u32 remap[NUM_TRACKS];
+			Scene::Hierarchy hierarchy;
+			BuildNodes(&hierarchy, &arena, NUM_TRACKS, remap);
+
+			Player player;
+			InitPlayer(&player, &library, 0, &arena);
+			player.node_map = remap;
+
+			for (u32 track = 0; track < NUM_TRACKS; ++track)
+			{
+				Curve const& curve = curves[track];
+				ASSERT(library.tracks[track].num_keys < (tolerance > 1e-4f ? curve.num_keys / 3 : curve.num_keys));
+
+				for (u32 i = 0; i < curve.num_keys; ++i)
+				{
+					f32 const tick = (f32)(u16)(curve.times[i] * ((f32)MAX_TICK / DURATION) + 0.5f);
+					player.time = tick * (DURATION / (f32)MAX_TICK);
+					Sample(&hierarchy, &library, &player, 1);
+					ASSERT(MaxError(GetAnimatedValue(hierarchy, remap[track], types[track]), curve.values[i], types[track]) <= tolerance + 1e-5f);
+				}
+			}
+		}
+	}
+
+	// A line keeps its end points, a constant a single key, and keys on the same tick keep the last value.
+	void RemovesRedundantKeys()
+	{
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+
+		f32 times[100];
+		vec4 line[100];
+		vec4 constant[100];
+		for (u32 i = 0; i < 100; ++i)
+		{
+			times[i] = DURATION * (f32)i / 99.0f;
+			line[i] = vec4(times[i], -2.0f * times[i], 5.0f, 0.0f);
+			constant[i] = vec4(1.0f, 2.0f, 3.0f, 0.0f);
+		}
+
+		Track track;
+		u16 out_times[100];
+		Key out_keys[100];
+		ASSERT(CompressTrack(&track, out_times, out_keys, { times, line, 100, 0, TrackType::Translation }, DURATION, {}, &scratch) == 2);
+		ASSERT(out_times[0] == 0 && out_times[1] == MAX_TICK);
+		ASSERT(CompressTrack(&track, out_times, out_keys, { times, constant, 100, 0, TrackType::Scale }, DURATION, {}, &scratch) == 1);
+
+		// The middle keys share a tick, the step between them is kept as a jump to the second value.
+		f32 const step_times[] = { 0.0f, 1.0f, 1.0f, DURATION };
+		vec4 const step_values[] = { vec4(0.0f, 0.0f, 0.0f, 0.0f), vec4(0.0f, 0.0f, 0.0f, 0.0f), vec4(1.0f, 1.0f, 1.0f, 0.0f), vec4(1.0f, 1.0f, 1.0f, 0.0f) };
+		ASSERT(CompressTrack(&track, out_times, out_keys, { step_times, step_values, 4, 0, TrackType::Translation }, DURATION, {}, &scratch) == 3);
+		ASSERT(out_keys[1].value[0] == 0xFFFF && out_keys[2].value[0] == 0xFFFF);
+	}
+
+	// Playing forward, backward and across the loop, the cursors have to land on the same keys as a
+	// search from scratch. Both interpolate the same pair of integers, so the results are identical.
+	void CursorsMatchSearch()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TrackType::Enum const types[] = { TrackType::Translation, TrackType::Rotation, TrackType::Scale };
+		static constexpr u32 NUM_TRACKS = ARRAY_SIZE(types);
+		Curve* curves = Memory::PushType<Curve>(&arena, NUM_TRACKS);
+		for (u32 i = 0; i < NUM_TRACKS; ++i)
+		{
+			InitCurve(&curves[i], types[i], 150, 3.0f + (f32)i);
+		}
+
+		ClipLibrary library;
+		BuildLibrary(&library, &arena, curves, types, NUM_TRACKS, {});
+
+		Scene::Hierarchy playing;
+		Scene::Hierarchy seeking;
+		u32 remap[NUM_TRACKS];
+		BuildNodes(&playing, &arena, NUM_TRACKS, remap);
+		BuildNodes(&seeking, &arena, NUM_TRACKS, remap);
+
+		Player player;
+		Player seeker;
+		InitPlayer(&player, &library, 0, &arena);
+		InitPlayer(&seeker, &library, 0, &arena);
+		player.node_map = seeker.node_map = remap;
+
+		TestUtils::Random random;
+		for (u32 step = 0; step < 2000; ++step)
+		{
+			// Mostly small steps forward, sometimes a jump back.
+			f32 const delta_time = (step % 50 == 49) ? -random.Float(0.0f, DURATION) : random.Float(0.0f, 0.05f);
+			AdvancePlayer(&player, &library, delta_time, true);
+			ASSERT(player.time >= 0.0f && player.time <= DURATION);
+
+			SetClip(&seeker, &library, 0);
+			seeker.time = player.time;
+
+			Sample(&playing, &library, &player, 1);
+			Sample(&seeking, &library, &seeker, 1);
+			ASSERT(memcmp(playing.locals, seeking.locals, sizeof(Scene::Transform) * NUM_TRACKS) == 0);
+		}
+
+		// Without looping the time stops at the ends.
+		AdvancePlayer(&player, &library, 10.0f, false);
+		ASSERT(player.time == DURATION);
+		AdvancePlayer(&player, &library, -10.0f, false);
+		ASSERT(player.time == 0.0f);
+	}
+
+	// Enough tracks for the job system, every player on its own copy of the nodes at its own time.
+	void ManyPlayersMatchOne()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TrackType::Enum types[16];
+		for (u32 i = 0; i < ARRAY_SIZE(types); ++i)
+		{
+			types[i] = (TrackType::Enum)(i % TrackType::EnumCount);
+		}
+		static constexpr u32 NUM_TRACKS = ARRAY_SIZE(types);
+		static constexpr u32 NUM_PLAYERS = PARALLEL_MIN_TRACKS / NUM_TRACKS + 3;
+
+		Curve* curves = Memory::PushType<Curve>(&arena, NUM_TRACKS);
+		for (u32 i = 0; i < NUM_TRACKS; ++i)
+		{
+			InitCurve(&curves[i], types[i], 40, 0.5f + (f32)i);
+		}
+
+		ClipLibrary library;
+		BuildLibrary(&library, &arena, curves, types, NUM_TRACKS, {});
+
+		Scene::Hierarchy hierarchy;
+		u32* remap = Memory::PushType<u32>(&arena, NUM_PLAYERS * NUM_TRACKS);
+		BuildNodes(&hierarchy, &arena, NUM_PLAYERS * NUM_TRACKS, remap);
+
+		TestUtils::Random random;
+		Player* players = Memory::PushType<Player>(&arena, NUM_PLAYERS);
+		for (u32 i = 0; i < NUM_PLAYERS; ++i)
+		{
+			InitPlayer(&players[i], &library, 0, &arena);
+			players[i].time = random.Float(0.0f, DURATION);
+			players[i].node_map = remap + i * NUM_TRACKS;
+		}
+		Sample(&hierarchy, &library, players, NUM_PLAYERS);
+		ASSERT(hierarchy.b_any_dirty);
+
+		Scene::Hierarchy single;
+		u32 single_remap[NUM_TRACKS];
+		BuildNodes(&single, &arena, NUM_TRACKS, single_remap);
+
+		Player player;
+		InitPlayer(&player, &library, 0, &arena);
+		player.node_map = single_remap;
+		for (u32 i = 0; i < NUM_PLAYERS; ++i)
+		{
+			player.time = players[i].time;
+			Sample(&single, &library, &player, 1);
+			for (u32 track = 0; track < NUM_TRACKS; ++track)
+			{
+				ASSERT(memcmp(&hierarchy.locals[players[i].node_map[track]], &single.locals[single_remap[track]], sizeof(Scene::Transform)) == 0);
+				ASSERT(hierarchy.flags[players[i].node_map[track]] & Scene::NodeFlags::LocalDirty);
+			}
+		}
+	}
+
+	void Run()
+	{
+		CompressedWithinTolerance();
+		RemovesRedundantKeys();
+		CursorsMatchSearch();
+		ManyPlayersMatchOne();
+	}
+}
+}
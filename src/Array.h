@@ -20,7 +20,6 @@ template<typename T, u32 Capacity, typename CounterPolicy = BasicCounterPolicy>
 class Array
 {
 public:
-	template<typename T>
 	struct ConstIterator
 	{
 		ConstIterator(T const* ptr) : elem_ptr(ptr) {}
@@ -30,17 +29,17 @@ public:
 			return *elem_ptr;
 		}
 
-		bool operator ==(ConstIterator<T> const& other) const
+		bool operator ==(ConstIterator const& other) const
 		{
 			return elem_ptr == other.elem_ptr;
 		}
 
-		bool operator !=(ConstIterator<T> const& other) const
+		bool operator !=(ConstIterator const& other) const
 		{
 			return elem_ptr != other.elem_ptr;
 		}
 
-		ConstIterator<T>& operator++()
+		ConstIterator& operator++()
 		{
 			elem_ptr++;
 			return *this;
@@ -143,14 +142,14 @@ public:
 		return m_data[index];
 	}
 
-	ConstIterator<T> const begin() const
+	ConstIterator const begin() const
 	{
-		return ConstIterator<T>( m_data );
+		return ConstIterator( m_data );
 	}
 
-	ConstIterator<T> const end() const
+	ConstIterator const end() const
 	{
-		return ConstIterator<T>( &m_data[m_size] );
+		return ConstIterator( &m_data[m_size] );
 	}
 
 private:
@@ -0,0 +1,200 @@
+#include "Base64.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+namespace Base64
+{
+	// Quads (4 characters -> 3 bytes) per job.
+	static constexpr u64 PARALLEL_BATCH_SIZE = 64 * 1024;
+
+	u64 EncodedLength(u64 num_bytes)
+	{
+		u64 const remainder = num_bytes % 3;
+		return (num_bytes / 3) * 4 + (remainder ? remainder + 1 : 0);
+	}
+
+	static MM_FORCEINL s32 DecodeChar(char ch)
+	{
+		return
+			(u32)(ch - 'A') < 26 ? (ch - 'A') :
+			(u32)(ch - 'a') < 26 ? (ch - 'a') + 26 :
+			(u32)(ch - '0') < 10 ? (ch - '0') + 52 :
+			ch == '+' ? 62 :
+			ch == '/' ? 63 :
+			-1;
+	}
+
+	// Decodes num_bytes (at most 3) from the next num_bytes + 1 characters.
+	static bool DecodeQuadScalar(u8* dst, u32 num_bytes, char const* src)
+	{
+		u32 bits = 0;
+		for (u32 i = 0; i <= num_bytes; ++i)
+		{
+			s32 const value = DecodeChar(src[i]);
+			if (value < 0)
+			{
+				return false;
+			}
+			bits |= (u32)value << (18 - 6 * i);
+		}
+
+		for (u32 i = 0; i < num_bytes; ++i)
+		{
+			dst[i] = (u8)(bits >> (16 - 8 * i));
+		}
+		return true;
+	}
+
+	// Maps ASCII to 6 bit values by adding an offset per character range, the range is
+	// found from the high nibble ('/' is the only one sharing its nibble with invalid characters).
+	// Validity is checked with one bit per high nibble that must not be set in the low nibble's mask.
+	// Both return false on invalid characters without writing anything.
+	static MM_FORCEINL bool DecodeSSE(u8* dst, char const* src)
+	{
+		__m128i const lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		__m128i const lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		__m128i const lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		__m128i const nibble_mask = _mm_set1_epi8(0x0f);
+		__m128i const slash = _mm_set1_epi8('/');
+
+		__m128i const chars = _mm_loadu_si128((__m128i const*)src);
+		__m128i const hi_nibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), nibble_mask);
+		__m128i const lo_nibbles = _mm_and_si128(chars, nibble_mask);
+
+		__m128i const hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+		__m128i const lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+		if (!_mm_testz_si128(lo, hi))
+		{
+			return false;
+		}
+
+		__m128i const roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(chars, slash), hi_nibbles));
+		__m128i const values = _mm_add_epi8(chars, roll);
+
+		// 00aaaaaa 00bbbbbb 00cccccc 00dddddd -> aaaaaabb bbbbcccc ccdddddd per 32 bit lane.
+		__m128i const ab_cd = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		__m128i const abcd = _mm_madd_epi16(ab_cd, _mm_set1_epi32(0x00011000));
+		__m128i const packed = _mm_shuffle_epi8(abcd, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+		// Writes 16 bytes, 12 of which are valid.
+		_mm_storeu_si128((__m128i*)dst, packed);
+		return true;
+	}
+
+	static SIMD_INLINE_AVX2 bool DecodeAVX2(u8* dst, char const* src)
+	{
+		__m256i const lut_lo = _mm256_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		__m256i const lut_hi = _mm256_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		__m256i const lut_roll = _mm256_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		__m256i const nibble_mask = _mm256_set1_epi8(0x0f);
+		__m256i const slash = _mm256_set1_epi8('/');
+
+		__m256i const chars = _mm256_loadu_si256((__m256i const*)src);
+		__m256i const hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(chars, 4), nibble_mask);
+		__m256i const lo_nibbles = _mm256_and_si256(chars, nibble_mask);
+
+		__m256i const hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		__m256i const lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+		if (!_mm256_testz_si256(lo, hi))
+		{
+			return false;
+		}
+
+		__m256i const roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(chars, slash), hi_nibbles));
+		__m256i const values = _mm256_add_epi8(chars, roll);
+
+		__m256i const ab_cd = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+		__m256i const abcd = _mm256_madd_epi16(ab_cd, _mm256_set1_epi32(0x00011000));
+		__m256i const packed = _mm256_shuffle_epi8(abcd, _mm256_setr_epi8(
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+		// Close the gap between the two 12 byte halves, writes 32 bytes, 24 of which are valid.
+		_mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7)));
+		return true;
+	}
+
+	// Returns the number of quads decoded, stops early at the first invalid character.
+	static SIMD_TARGET_AVX2 u64 DecodeQuadsAVX2(u8* dst, char const* src, u64 num_quads)
+	{
+		u64 quad = 0;
+		for (; quad + 11 <= num_quads; quad += 8)
+		{
+			if (!DecodeAVX2(dst + quad * 3, src + quad * 4))
+			{
+				break;
+			}
+		}
+		return quad;
+	}
+
+	struct DecodeTask
+	{
+		u8* dst;
+		char const* src;
+		bool use_avx2;
+		atomic_u32 num_failed_batches;
+	};
+
+	static void DecodeBatch(void* user_data, u64 begin, u64 end)
+	{
+		DecodeTask* task = static_cast<DecodeTask*>(user_data);
+
+		u8* dst = task->dst + begin * 3;
+		char const* src = task->src + begin * 4;
+		u64 const num_quads = end - begin;
+
+		// The vector stores write past the decoded bytes, stay clear of the next batch
+		// since that one might be written by another thread right now.
+		u64 quad = task->use_avx2 ? DecodeQuadsAVX2(dst, src, num_quads) : 0;
+
+		for (; quad + 6 <= num_quads; quad += 4)
+		{
+			if (!DecodeSSE(dst + quad * 3, src + quad * 4))
+			{
+				break;
+			}
+		}
+
+		// Remainder, and whatever the vector loops stopped at.
+		for (; quad < num_quads; ++quad)
+		{
+			if (!DecodeQuadScalar(dst + quad * 3, 3, src + quad * 4))
+			{
+				task->num_failed_batches++;
+				return;
+			}
+		}
+	}
+
+	bool Decode(u8* dst, u64 dst_size, char const* src, u64 src_length)
+	{
+		if (src_length < EncodedLength(dst_size))
+		{
+			return false;
+		}
+
+		u64 const num_quads = dst_size / 3;
+		u32 const num_tail_bytes = (u32)(dst_size % 3);
+
+		DecodeTask task;
+		task.dst = dst;
+		task.src = src;
+		task.use_avx2 = Simd::GetCpuFeatures().avx2;
+		task.num_failed_batches = 0;
+		Jobs::ParallelFor(num_quads, PARALLEL_BATCH_SIZE, &DecodeBatch, &task);
+
+		if (task.num_failed_batches > 0)
+		{
+			return false;
+		}
+
+		return num_tail_bytes == 0 || DecodeQuadScalar(dst + num_quads * 3, num_tail_bytes, src + num_quads * 4);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Core.h"
+
+// ====================================
+//  Base64 Decoding
+//  Notes:
+//  *) Standard alphabet (RFC 4648) only, no line breaks or
+//     whitespace, which is what glTF data uris contain.
+//  *) 32 (AVX2) or 16 (SSE4.1) characters per step, see
+//     Mula & Lemire, "Faster Base64 Encoding and Decoding
+//     Using AVX2 Instructions" (2018). Large inputs are split
+//     into batches that decode on the job system.
+// ====================================
+
+namespace Base64
+{
+	// Number of characters needed to encode num_bytes, without padding.
+	u64 EncodedLength(u64 num_bytes);
+
+	// Decodes the first dst_size bytes encoded in src, anything after that (padding) is ignored.
+	// Returns false if src is too short or holds characters outside of the alphabet.
+	bool Decode(u8* dst, u64 dst_size, char const* src, u64 src_length);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
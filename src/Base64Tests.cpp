@@ -0,0 +1,180 @@
+#include "Base64.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+namespace Base64
+{
+namespace Test
+{
+	static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	static constexpr u8 GUARD = 0xCD;
+
+	// Scalar reference, with padding.
+	static u64 Encode(char* dst, u8 const* src, u64 num_bytes)
+	{
+		u64 length = 0;
+		for (u64 i = 0; i < num_bytes; i += 3)
+		{
+			u32 const remaining = (u32)min<u64>(num_bytes - i, 3);
+			u32 bits = (u32)src[i] << 16;
+			bits |= remaining > 1 ? (u32)src[i + 1] << 8 : 0;
+			bits |= remaining > 2 ? (u32)src[i + 2] : 0;
+
+			for (u32 j = 0; j < 4; ++j)
+			{
+				dst[length++] = j <= remaining ? ALPHABET[(bits >> (18 - 6 * j)) & 63] : '=';
+			}
+		}
+		return length;
+	}
+
+	static void FillRandom(u8* data, u64 num_bytes, TestUtils::Random& random)
+	{
+		for (u64 i = 0; i < num_bytes; ++i)
+		{
+			data[i] = (u8)random.Next();
+		}
+	}
+
+	void EncodedLengthDropsPadding()
+	{
+		ASSERT(EncodedLength(0) == 0);
+		ASSERT(EncodedLength(1) == 2);
+		ASSERT(EncodedLength(2) == 3);
+		ASSERT(EncodedLength(3) == 4);
+		ASSERT(EncodedLength(4) == 6);
+
+		u8 decoded[2];
+		ASSERT(Decode(decoded, 2, "TWE=", 4));
+		ASSERT(decoded[0] == 'M' && decoded[1] == 'a');
+
+		// Padding is optional.
+		ASSERT(Decode(decoded, 2, "TWE", 3));
+		ASSERT(decoded[0] == 'M' && decoded[1] == 'a');
+	}
+
+	// Every length up to a few AVX2 steps covers the vector loops, their remainders and the tail bytes.
+	void DecodeMatchesScalar()
+	{
+		static constexpr u32 MAX_BYTES = 300;
+		u8 original[MAX_BYTES];
+		u8 decoded[MAX_BYTES + 32];
+		char encoded[(MAX_BYTES + 2) / 3 * 4];
+
+		TestUtils::Random random;
+		FillRandom(original, MAX_BYTES, random);
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			for (u32 num_bytes = 0; num_bytes <= MAX_BYTES; ++num_bytes)
+			{
+				u64 const length = Encode(encoded, original, num_bytes);
+				memset(decoded, GUARD, sizeof(decoded));
+
+				ASSERT(Decode(decoded, num_bytes, encoded, length));
+				ASSERT(memcmp(decoded, original, num_bytes) == 0);
+
+				// The vector stores may spill into dst, but never past dst_size.
+				for (u32 i = num_bytes; i < sizeof(decoded); ++i)
+				{
+					ASSERT(decoded[i] == GUARD);
+				}
+			}
+		});
+	}
+
+	// Large enough for several batches on the job system.
+	void DecodeParallelMatchesScalar()
+	{
+		static constexpr u64 NUM_BYTES = 1000001;
+		u8* original = new u8[NUM_BYTES];
+		u8* decoded = new u8[NUM_BYTES + 1];
+		char* encoded = new char[(NUM_BYTES + 2) / 3 * 4];
+		ON_SCOPE_EXIT(delete[] original; delete[] decoded; delete[] encoded);
+
+		TestUtils::Random random;
+		FillRandom(original, NUM_BYTES, random);
+		u64 const length = Encode(encoded, original, NUM_BYTES);
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			decoded[NUM_BYTES] = GUARD;
+			ASSERT(Decode(decoded, NUM_BYTES, encoded, length));
+			ASSERT(memcmp(decoded, original, NUM_BYTES) == 0);
+			ASSERT(decoded[NUM_BYTES] == GUARD);
+		});
+	}
+
+	// An invalid character anywhere, in a vector step, a scalar remainder or the tail, fails the decode.
+	void DecodeRejectsInvalidCharacters()
+	{
+		static constexpr u32 NUM_BYTES = 200;
+		u8 original[NUM_BYTES];
+		u8 decoded[NUM_BYTES + 32];
+		char encoded[(NUM_BYTES + 2) / 3 * 4];
+
+		TestUtils::Random random;
+		FillRandom(original, NUM_BYTES, random);
+		u64 const length = Encode(encoded, original, NUM_BYTES);
+		u64 const num_decoded_chars = EncodedLength(NUM_BYTES);
+
+		// Neighbours of the alphabet's ranges, the URL safe alphabet, padding and non ASCII.
+		char const invalid[] = { '@', '[', '`', '{', '9' + 1, '0' - 2, '+' - 1, '-', '_', '=', ' ', '\n', '\0', (char)0x80, (char)0xC1, (char)0xFF };
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			for (u64 pos = 0; pos < num_decoded_chars; ++pos)
+			{
+				char const ch = invalid[pos % ARRAY_SIZE(invalid)];
+				char const saved = encoded[pos];
+				encoded[pos] = ch;
+				ASSERT(!Decode(decoded, NUM_BYTES, encoded, length));
+				encoded[pos] = saved;
+			}
+			ASSERT(Decode(decoded, NUM_BYTES, encoded, length));
+		});
+
+		// Same on the parallel path, in the middle of a later batch.
+		static constexpr u64 NUM_LARGE_BYTES = 600000;
+		u8* large = new u8[NUM_LARGE_BYTES];
+		char* large_encoded = new char[(NUM_LARGE_BYTES + 2) / 3 * 4];
+		ON_SCOPE_EXIT(delete[] large; delete[] large_encoded);
+
+		FillRandom(large, NUM_LARGE_BYTES, random);
+		u64 const large_length = Encode(large_encoded, large, NUM_LARGE_BYTES);
+		large_encoded[large_length - 1000] = '*';
+		ASSERT(!Decode(large, NUM_LARGE_BYTES, large_encoded, large_length));
+	}
+
+	void DecodeRejectsShortInput()
+	{
+		static constexpr u32 NUM_BYTES = 100;
+		u8 original[NUM_BYTES];
+		u8 decoded[NUM_BYTES + 32];
+		char encoded[(NUM_BYTES + 2) / 3 * 4];
+
+		TestUtils::Random random;
+		FillRandom(original, NUM_BYTES, random);
+
+		for (u32 num_bytes = 1; num_bytes <= NUM_BYTES; ++num_bytes)
+		{
+			Encode(encoded, original, num_bytes);
+			u64 const needed = EncodedLength(num_bytes);
+			ASSERT(Decode(decoded, num_bytes, encoded, needed));
+			ASSERT(!Decode(decoded, num_bytes, encoded, needed - 1));
+		}
+
+		ASSERT(!Decode(decoded, 1, "", 0));
+		ASSERT(Decode(decoded, 0, "", 0));
+	}
+
+	void Run()
+	{
+		EncodedLengthDropsPadding();
+		DecodeMatchesScalar();
+		DecodeParallelMatchesScalar();
+		DecodeRejectsInvalidCharacters();
+		DecodeRejectsShortInput();
+	}
+}
+}
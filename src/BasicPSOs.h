@@ -8,6 +8,9 @@ namespace Gfx
 		{
 			VertexColorSolid,
 			VertexColorWireframe,
+			VertexColorSolidCompressed, // Expects MeshFlags::CompressedVertexStreams
+			VertexColorSolidInstanced, // Expects a transform per instance, see DrawSubMeshesInstanced
+			VertexColorSolidCompressedInstanced,
 			
 			Count
 		};
@@ -0,0 +1,1551 @@
+#include "BlockCompression.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+#include <float.h>
+
+namespace BlockCompression
+{
+	// ====================================
+	//  Shared
+	// ====================================
+
+	// Texels of a block, or of one subset of it, as floats in [0, 255] with one array per channel.
+	// Subsets are packed to the front, the slots behind them repeat texel 0 with a weight of 0.
+	struct Texels
+	{
+		alignas(16) f32 channels[4][16];
+		alignas(16) f32 weights[16];
+		u32 count;
+	};
+
+	static void LoadTexels(u8 const* rgba, Texels* out)
+	{
+		// RGBA RGBA RGBA RGBA -> RRRR GGGG BBBB AAAA
+		__m128i const to_planar = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+		for (u32 i = 0; i < 16; i += 4)
+		{
+			__m128i const planar = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)(rgba + i * 4)), to_planar);
+			_mm_store_ps(out->channels[0] + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(planar)));
+			_mm_store_ps(out->channels[1] + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 4))));
+			_mm_store_ps(out->channels[2] + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 8))));
+			_mm_store_ps(out->channels[3] + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 12))));
+			_mm_store_ps(out->weights + i, _mm_set1_ps(1.0f));
+		}
+		out->count = 16;
+	}
+
+	// Packs the texels of one subset to the front, out_texel_indices receives their position in the block.
+	static void GatherSubset(Texels const& block, u32 partition_mask, u32 subset, Texels* out, u8* out_texel_indices)
+	{
+		u32 count = 0;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			if (((partition_mask >> i) & 1) == subset)
+			{
+				for (u32 c = 0; c < 4; ++c)
+				{
+					out->channels[c][count] = block.channels[c][i];
+				}
+				out_texel_indices[count++] = (u8)i;
+			}
+		}
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			out->weights[i] = i < count ? 1.0f : 0.0f;
+			for (u32 c = 0; i >= count && c < 4; ++c)
+			{
+				out->channels[c][i] = out->channels[c][0];
+			}
+		}
+		out->count = count;
+	}
+
+	static MM_FORCEINL f32 HorizontalSum(__m128 v)
+	{
+		v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+		v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+		return _mm_cvtss_f32(v);
+	}
+
+	// Mean and unit length principal axis of the first num_channels channels. The axis is zero
+	// if all texels are the same.
+	static void ComputePrincipalAxis(Texels const& texels, u32 num_channels, f32* mean, f32* axis)
+	{
+		f32 const inv_count = 1.0f / (f32)texels.count;
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (u32 i = 0; i < 16; i += 4)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(texels.channels[c] + i), _mm_load_ps(texels.weights + i)));
+			}
+			mean[c] = HorizontalSum(sum) * inv_count;
+		}
+
+		f32 covariance[4][4];
+		for (u32 a = 0; a < num_channels; ++a)
+		{
+			for (u32 b = a; b < num_channels; ++b)
+			{
+				f32 sum = 0.0f;
+				for (u32 i = 0; i < texels.count; ++i)
+				{
+					sum += (texels.channels[a][i] - mean[a]) * (texels.channels[b][i] - mean[b]);
+				}
+				covariance[a][b] = sum;
+				covariance[b][a] = sum;
+			}
+		}
+
+		// Power iteration, starting from the row of the channel that varies the most.
+		u32 start = 0;
+		for (u32 c = 1; c < num_channels; ++c)
+		{
+			start = covariance[c][c] > covariance[start][start] ? c : start;
+		}
+
+		f32 v[4];
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			v[c] = covariance[start][c];
+		}
+
+		for (u32 iteration = 0; iteration < 8; ++iteration)
+		{
+			f32 next[4];
+			f32 largest = 0.0f;
+			for (u32 a = 0; a < num_channels; ++a)
+			{
+				next[a] = 0.0f;
+				for (u32 b = 0; b < num_channels; ++b)
+				{
+					next[a] += covariance[a][b] * v[b];
+				}
+				largest = max(largest, fabsf(next[a]));
+			}
+
+			if (largest < 1e-6f)
+			{
+				break;
+			}
+
+			for (u32 c = 0; c < num_channels; ++c)
+			{
+				v[c] = next[c] / largest;
+			}
+		}
+
+		f32 length_sq = 0.0f;
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			length_sq += v[c] * v[c];
+		}
+
+		f32 const inv_length = length_sq > 1e-12f ? 1.0f / sqrtf(length_sq) : 0.0f;
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			axis[c] = v[c] * inv_length;
+		}
+	}
+
+	// Starting endpoints: the texels with the lowest and highest projection onto the principal axis.
+	static void FindExtremeTexels(Texels const& texels, u32 num_channels, f32* out_e0, f32* out_e1)
+	{
+		f32 mean[4];
+		f32 axis[4];
+		ComputePrincipalAxis(texels, num_channels, mean, axis);
+
+		u32 lowest = 0;
+		u32 highest = 0;
+		f32 min_t = FLT_MAX;
+		f32 max_t = -FLT_MAX;
+		for (u32 i = 0; i < texels.count; ++i)
+		{
+			f32 t = 0.0f;
+			for (u32 c = 0; c < num_channels; ++c)
+			{
+				t += (texels.channels[c][i] - mean[c]) * axis[c];
+			}
+
+			if (t < min_t)
+			{
+				min_t = t;
+				lowest = i;
+			}
+			if (t > max_t)
+			{
+				max_t = t;
+				highest = i;
+			}
+		}
+
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			out_e0[c] = texels.channels[c][lowest];
+			out_e1[c] = texels.channels[c][highest];
+		}
+	}
+
+	// Picks the closest palette entry for every texel, returns the weighted sum of squared errors.
+	static f32 FindIndices(Texels const& texels, u32 num_channels, f32 const (*palette)[4], u32 num_entries, u8* out_indices)
+	{
+		__m128i const pack_bytes = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+		__m128 total = _mm_setzero_ps();
+		for (u32 i = 0; i < texels.count; i += 4)
+		{
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i best_index = _mm_setzero_si128();
+			for (u32 k = 0; k < num_entries; ++k)
+			{
+				__m128 dist = _mm_setzero_ps();
+				for (u32 c = 0; c < num_channels; ++c)
+				{
+					__m128 const diff = _mm_sub_ps(_mm_load_ps(texels.channels[c] + i), _mm_set1_ps(palette[k][c]));
+					dist = _mm_add_ps(dist, _mm_mul_ps(diff, diff));
+				}
+
+				__m128 const closer = _mm_cmplt_ps(dist, best);
+				best = _mm_min_ps(dist, best);
+				best_index = _mm_blendv_epi8(best_index, _mm_set1_epi32((s32)k), _mm_castps_si128(closer));
+			}
+
+			total = _mm_add_ps(total, _mm_mul_ps(best, _mm_load_ps(texels.weights + i)));
+
+			u32 const packed = (u32)_mm_cvtsi128_si32(_mm_shuffle_epi8(best_index, pack_bytes));
+			memcpy(out_indices + i, &packed, sizeof(packed));
+		}
+
+		return HorizontalSum(total);
+	}
+
+	// Least squares endpoints for fixed indices, texel i is approximated by lerp(e0, e1, index_weights[index]).
+	// Returns false if all texels sit on the same weight, which leaves the system singular.
+	static bool SolveEndpoints(Texels const& texels, u32 num_channels, u8 const* indices, f32 const* index_weights, f32* e0, f32* e1)
+	{
+		f32 aa = 0.0f;
+		f32 ab = 0.0f;
+		f32 bb = 0.0f;
+		f32 rhs0[4] = {};
+		f32 rhs1[4] = {};
+		for (u32 i = 0; i < texels.count; ++i)
+		{
+			f32 const t = index_weights[indices[i]];
+			f32 const s = 1.0f - t;
+			aa += s * s;
+			ab += s * t;
+			bb += t * t;
+			for (u32 c = 0; c < num_channels; ++c)
+			{
+				rhs0[c] += s * texels.channels[c][i];
+				rhs1[c] += t * texels.channels[c][i];
+			}
+		}
+
+		f32 const det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-4f)
+		{
+			return false;
+		}
+
+		f32 const inv_det = 1.0f / det;
+		for (u32 c = 0; c < num_channels; ++c)
+		{
+			e0[c] = Clamp((bb * rhs0[c] - ab * rhs1[c]) * inv_det, 0.0f, 255.0f);
+			e1[c] = Clamp((aa * rhs1[c] - ab * rhs0[c]) * inv_det, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// Bit replication to 8 bits, like the decoders do it.
+	static MM_FORCEINL u32 Expand(u32 value, u32 bits)
+	{
+		return (value << (8 - bits)) | (value >> (2 * bits - 8));
+	}
+
+	// Closest value of the given width to an 8 bit channel value once expanded. With a p-bit (0 or 1, -1
+	// for none), that gets appended as the LSB before expanding. The result doesn't include the p-bit.
+	static u32 QuantizeChannel(f32 value, u32 bits, s32 pbit)
+	{
+		s32 const max_value = (1 << bits) - 1;
+		u32 const total_bits = pbit < 0 ? bits : bits + 1;
+		f32 const scaled = value * (f32)((1u << total_bits) - 1) / 255.0f;
+		s32 const guess = pbit < 0 ? (s32)floorf(scaled + 0.5f) : (s32)floorf((scaled - pbit) * 0.5f + 0.5f);
+
+		u32 best = 0;
+		f32 best_error = FLT_MAX;
+		for (s32 q = max(guess - 1, 0); q <= min(guess + 1, max_value); ++q)
+		{
+			u32 const expanded = Expand(pbit < 0 ? (u32)q : ((u32)q << 1) | (u32)pbit, total_bits);
+			f32 const error = fabsf((f32)expanded - value);
+			if (error < best_error)
+			{
+				best_error = error;
+				best = (u32)q;
+			}
+		}
+		return best;
+	}
+
+	// ====================================
+	//  BC1, BC3 color
+	// ====================================
+
+	// Weight of the second endpoint per BC1 index.
+	static constexpr f32 BC1_INDEX_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	// Number of least squares passes after the principal axis fit.
+	static constexpr u32 BC1_REFINE_ITERATIONS = 2;
+
+	static constexpr u32 BC1_CHANNEL_BITS[3] = { 5, 6, 5 };
+
+	// Endpoint pairs whose 1/3 entry is closest to every 8 bit value, for flat blocks.
+	struct SingleColorTables
+	{
+		u8 endpoints5[256][2];
+		u8 endpoints6[256][2];
+	};
+
+	static void BuildSingleColorTable(u8 (*table)[2], u32 bits)
+	{
+		u32 const num_values = 1u << bits;
+		for (u32 value = 0; value < 256; ++value)
+		{
+			f32 best_error = FLT_MAX;
+			for (u32 q0 = 0; q0 < num_values; ++q0)
+			{
+				for (u32 q1 = 0; q1 < num_values; ++q1)
+				{
+					f32 const interpolated = (2.0f * Expand(q0, bits) + Expand(q1, bits)) / 3.0f;
+					f32 const error = fabsf(interpolated - (f32)value);
+					if (error < best_error)
+					{
+						best_error = error;
+						table[value][0] = (u8)q0;
+						table[value][1] = (u8)q1;
+					}
+				}
+			}
+		}
+	}
+
+	static SingleColorTables const& GetSingleColorTables()
+	{
+		struct Local
+		{
+			static SingleColorTables Build()
+			{
+				SingleColorTables tables;
+				BuildSingleColorTable(tables.endpoints5, 5);
+				BuildSingleColorTable(tables.endpoints6, 6);
+				return tables;
+			}
+		};
+
+		static SingleColorTables const tables = Local::Build();
+		return tables;
+	}
+
+	static MM_FORCEINL u16 Pack565(u32 const* q)
+	{
+		return (u16)((q[0] << 11) | (q[1] << 5) | q[2]);
+	}
+
+	// Always a 4 color block, which BC3 requires and BC1 gets from c0 > c1.
+	static void WriteColorBlock(u8* dst, u32 const* q0, u32 const* q1, u8 const* indices)
+	{
+		u16 c0 = Pack565(q0);
+		u16 c1 = Pack565(q1);
+
+		// Swapping the endpoints moves index 0 <-> 1 and 2 <-> 3. Equal endpoints decode the same on every index.
+		u32 bits = 0;
+		if (c0 != c1)
+		{
+			u32 const flip = c0 < c1 ? 1 : 0;
+			if (flip)
+			{
+				u16 const temp = c0;
+				c0 = c1;
+				c1 = temp;
+			}
+
+			for (u32 i = 0; i < 16; ++i)
+			{
+				bits |= (u32)(indices[i] ^ flip) << (i * 2);
+			}
+		}
+
+		memcpy(dst, &c0, sizeof(c0));
+		memcpy(dst + 2, &c1, sizeof(c1));
+		memcpy(dst + 4, &bits, sizeof(bits));
+	}
+
+	static void CompressColorBlock(u8* dst, Texels const& texels)
+	{
+		bool b_flat = true;
+		for (u32 i = 1; i < 16 && b_flat; ++i)
+		{
+			b_flat = texels.channels[0][i] == texels.channels[0][0] && texels.channels[1][i] == texels.channels[1][0] &&
+				texels.channels[2][i] == texels.channels[2][0];
+		}
+
+		if (b_flat)
+		{
+			SingleColorTables const& tables = GetSingleColorTables();
+			u32 const r = (u32)texels.channels[0][0];
+			u32 const g = (u32)texels.channels[1][0];
+			u32 const b = (u32)texels.channels[2][0];
+			u32 const q0[3] = { tables.endpoints5[r][0], tables.endpoints6[g][0], tables.endpoints5[b][0] };
+			u32 const q1[3] = { tables.endpoints5[r][1], tables.endpoints6[g][1], tables.endpoints5[b][1] };
+
+			u8 indices[16];
+			memset(indices, 2, sizeof(indices));
+			WriteColorBlock(dst, q0, q1, indices);
+			return;
+		}
+
+		f32 e0[4];
+		f32 e1[4];
+		FindExtremeTexels(texels, 3, e0, e1);
+
+		u32 best_q0[3];
+		u32 best_q1[3];
+		u8 best_indices[16];
+		f32 best_error = FLT_MAX;
+
+		for (u32 iteration = 0; iteration <= BC1_REFINE_ITERATIONS; ++iteration)
+		{
+			u32 q0[3];
+			u32 q1[3];
+			f32 palette[4][4];
+			for (u32 c = 0; c < 3; ++c)
+			{
+				q0[c] = QuantizeChannel(e0[c], BC1_CHANNEL_BITS[c], -1);
+				q1[c] = QuantizeChannel(e1[c], BC1_CHANNEL_BITS[c], -1);
+				palette[0][c] = (f32)Expand(q0[c], BC1_CHANNEL_BITS[c]);
+				palette[1][c] = (f32)Expand(q1[c], BC1_CHANNEL_BITS[c]);
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+
+			u8 indices[16];
+			f32 const error = FindIndices(texels, 3, palette, 4, indices);
+			if (error >= best_error)
+			{
+				break;
+			}
+
+			best_error = error;
+			memcpy(best_q0, q0, sizeof(q0));
+			memcpy(best_q1, q1, sizeof(q1));
+			memcpy(best_indices, indices, sizeof(indices));
+
+			if (!SolveEndpoints(texels, 3, indices, BC1_INDEX_WEIGHTS, e0, e1))
+			{
+				break;
+			}
+		}
+
+		WriteColorBlock(dst, best_q0, best_q1, best_indices);
+	}
+
+	// ====================================
+	//  BC4, BC5, BC3 alpha
+	// ====================================
+
+	// 8 step ramp from the largest to the smallest value, the ramp is evenly spaced so the closest
+	// entry comes from rounding the texel's position on it.
+	static void CompressChannelBlock(u8* dst, u8 const* rgba, u32 channel)
+	{
+		u8 values[16];
+		u8 lowest = 255;
+		u8 highest = 0;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			values[i] = rgba[i * 4 + channel];
+			lowest = min(lowest, values[i]);
+			highest = max(highest, values[i]);
+		}
+
+		dst[0] = highest;
+		dst[1] = lowest;
+
+		u64 bits = 0;
+		if (highest != lowest)
+		{
+			// Ramp position 0 is endpoint 0, 7 is endpoint 1, and 1 to 6 are indices 2 to 7.
+			__m128 const scale = _mm_set1_ps(7.0f / (f32)(highest - lowest));
+			__m128 const top = _mm_set1_ps((f32)highest);
+			__m128i const zero = _mm_setzero_si128();
+			__m128i const one = _mm_set1_epi32(1);
+			__m128i const seven = _mm_set1_epi32(7);
+
+			u32 indices[16];
+			for (u32 i = 0; i < 16; i += 4)
+			{
+				s32 quad;
+				memcpy(&quad, values + i, sizeof(quad));
+				__m128 const v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(quad)));
+				__m128i const step = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(top, v), scale));
+
+				__m128i index = _mm_add_epi32(step, one);
+				index = _mm_blendv_epi8(index, zero, _mm_cmpeq_epi32(step, zero));
+				index = _mm_blendv_epi8(index, one, _mm_cmpeq_epi32(step, seven));
+				_mm_storeu_si128((__m128i*)(indices + i), index);
+			}
+
+			for (u32 i = 0; i < 16; ++i)
+			{
+				bits |= (u64)indices[i] << (i * 3);
+			}
+		}
+
+		memcpy(dst + 2, &bits, 6);
+	}
+
+	// ====================================
+	//  BC7
+	// ====================================
+
+	// Texel i belongs to subset 1 if bit i is set.
+	static constexpr u16 BC7_PARTITIONS2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+
+	// First texel of subset 1, its index drops the MSB. Subset 0 always starts at texel 0.
+	static constexpr u8 BC7_ANCHORS2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+	};
+
+	static constexpr u8 BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+	static constexpr u8 BC7_WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	static constexpr u8 BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	static u8 const* GetIndexWeights(u32 index_bits)
+	{
+		return index_bits == 2 ? BC7_WEIGHTS2 : index_bits == 3 ? BC7_WEIGHTS3 : BC7_WEIGHTS4;
+	}
+
+	// Blocks whose mode 6 encoding is closer than this (summed squared error) don't try other modes.
+	static constexpr f32 BC7_GOOD_ENOUGH_ERROR = 16.0f;
+
+	struct PBits
+	{
+		enum Enum : u32
+		{
+			None,
+			Shared, // One per subset.
+			Unique, // One per endpoint.
+		};
+	};
+
+	// How one subset's endpoints are stored.
+	struct EndpointFormat
+	{
+		u32 num_channels;
+		u32 bits; // Per channel, without the p-bit.
+		u32 index_bits;
+		PBits::Enum pbits;
+	};
+
+	struct FitOptions
+	{
+		u32 refine_iterations; // Least squares passes after the principal axis fit.
+		bool b_all_pbits;
+	};
+
+	struct SubsetEncoding
+	{
+		u32 endpoints[2][4]; // Quantized, without the p-bits.
+		u32 pbits[2];
+		u8 indices[16]; // Per packed texel of the subset.
+		f32 error;
+	};
+
+	// Quantizes one endpoint with the given p-bit (-1 for none), returns the squared error of the expanded result.
+	static f32 QuantizeEndpoint(f32 const* e, EndpointFormat const& format, s32 pbit, u32* out_quantized, u32* out_expanded)
+	{
+		u32 const total_bits = pbit < 0 ? format.bits : format.bits + 1;
+		f32 error = 0.0f;
+		for (u32 c = 0; c < format.num_channels; ++c)
+		{
+			out_quantized[c] = QuantizeChannel(e[c], format.bits, pbit);
+			out_expanded[c] = Expand(pbit < 0 ? out_quantized[c] : (out_quantized[c] << 1) | (u32)pbit, total_bits);
+			f32 const diff = (f32)out_expanded[c] - e[c];
+			error += diff * diff;
+		}
+		return error;
+	}
+
+	// Quantizes the endpoints and keeps the result in out if it beats what out already holds. Without
+	// b_all_pbits the p-bits are the ones that keep the endpoints closest, otherwise every combination
+	// the format allows is tried on the texels.
+	static void EvaluateEndpoints(Texels const& texels, EndpointFormat const& format, f32 const* e0, f32 const* e1, bool b_all_pbits, SubsetEncoding* out)
+	{
+		u8 const* weights = GetIndexWeights(format.index_bits);
+		u32 const num_entries = 1u << format.index_bits;
+
+		// Endpoint candidates per p-bit, [endpoint][pbit].
+		u32 quantized[2][2][4];
+		u32 expanded[2][2][4];
+		f32 errors[2][2];
+		u32 const num_pbits = format.pbits == PBits::None ? 1 : 2;
+		for (u32 p = 0; p < num_pbits; ++p)
+		{
+			s32 const pbit = format.pbits == PBits::None ? -1 : (s32)p;
+			errors[0][p] = QuantizeEndpoint(e0, format, pbit, quantized[0][p], expanded[0][p]);
+			errors[1][p] = QuantizeEndpoint(e1, format, pbit, quantized[1][p], expanded[1][p]);
+		}
+
+		u32 combinations[4][2];
+		u32 num_combinations = 0;
+		if (format.pbits == PBits::None)
+		{
+			combinations[num_combinations][0] = 0;
+			combinations[num_combinations++][1] = 0;
+		}
+		else if (format.pbits == PBits::Shared)
+		{
+			for (u32 p = 0; p < 2; ++p)
+			{
+				if (b_all_pbits || errors[0][p] + errors[1][p] <= errors[0][p ^ 1] + errors[1][p ^ 1])
+				{
+					combinations[num_combinations][0] = p;
+					combinations[num_combinations++][1] = p;
+					if (!b_all_pbits)
+					{
+						break;
+					}
+				}
+			}
+		}
+		else
+		{
+			for (u32 combination = 0; combination < 4; ++combination)
+			{
+				u32 const p0 = combination & 1;
+				u32 const p1 = combination >> 1;
+				if (b_all_pbits || (errors[0][p0] <= errors[0][p0 ^ 1] && errors[1][p1] <= errors[1][p1 ^ 1]))
+				{
+					combinations[num_combinations][0] = p0;
+					combinations[num_combinations++][1] = p1;
+					if (!b_all_pbits)
+					{
+						break;
+					}
+				}
+			}
+		}
+
+		for (u32 i = 0; i < num_combinations; ++i)
+		{
+			u32 const p0 = combinations[i][0];
+			u32 const p1 = combinations[i][1];
+
+			SubsetEncoding candidate;
+			f32 palette[16][4];
+			for (u32 c = 0; c < format.num_channels; ++c)
+			{
+				candidate.endpoints[0][c] = quantized[0][p0][c];
+				candidate.endpoints[1][c] = quantized[1][p1][c];
+				u32 const u0 = expanded[0][p0][c];
+				u32 const u1 = expanded[1][p1][c];
+				for (u32 k = 0; k < num_entries; ++k)
+				{
+					palette[k][c] = (f32)(((64 - weights[k]) * u0 + weights[k] * u1 + 32) >> 6);
+				}
+			}
+
+			candidate.pbits[0] = p0;
+			candidate.pbits[1] = p1;
+			candidate.error = FindIndices(texels, format.num_channels, palette, num_entries, candidate.indices);
+			if (candidate.error < out->error)
+			{
+				*out = candidate;
+			}
+		}
+	}
+
+	static void FitSubset(Texels const& texels, EndpointFormat const& format, FitOptions const& options, SubsetEncoding* out)
+	{
+		out->error = FLT_MAX;
+
+		f32 e0[4];
+		f32 e1[4];
+		FindExtremeTexels(texels, format.num_channels, e0, e1);
+		EvaluateEndpoints(texels, format, e0, e1, options.b_all_pbits, out);
+
+		f32 index_weights[16];
+		u8 const* weights = GetIndexWeights(format.index_bits);
+		for (u32 k = 0; k < (1u << format.index_bits); ++k)
+		{
+			index_weights[k] = weights[k] / 64.0f;
+		}
+
+		for (u32 iteration = 0; iteration < options.refine_iterations; ++iteration)
+		{
+			f32 const previous_error = out->error;
+			if (previous_error == 0.0f || !SolveEndpoints(texels, format.num_channels, out->indices, index_weights, e0, e1))
+			{
+				break;
+			}
+
+			EvaluateEndpoints(texels, format, e0, e1, options.b_all_pbits, out);
+			if (out->error >= previous_error)
+			{
+				break;
+			}
+		}
+	}
+
+	// 128 bits, filled from the LSB of byte 0 on.
+	struct BitWriter
+	{
+		u64 words[2];
+		u32 pos;
+	};
+
+	static MM_FORCEINL void WriteBits(BitWriter* writer, u32 value, u32 num_bits)
+	{
+		u32 const pos = writer->pos;
+		if (pos < 64)
+		{
+			writer->words[0] |= (u64)value << pos;
+			if (pos + num_bits > 64)
+			{
+				writer->words[1] |= (u64)value >> (64 - pos);
+			}
+		}
+		else
+		{
+			writer->words[1] |= (u64)value << (pos - 64);
+		}
+		writer->pos += num_bits;
+	}
+
+	static void BeginBlock(BitWriter* writer, u32 mode)
+	{
+		writer->words[0] = 0;
+		writer->words[1] = 0;
+		writer->pos = 0;
+		WriteBits(writer, 1u << mode, mode + 1);
+	}
+
+	static void EndBlock(BitWriter const* writer, u8* dst)
+	{
+		ASSERT(writer->pos == 128);
+		memcpy(dst, writer->words, 16);
+	}
+
+	// The anchor texel's index has to have its MSB clear, otherwise the endpoints swap and the indices invert.
+	static void FixAnchor(SubsetEncoding* subset, u32 anchor, u32 index_bits)
+	{
+		u32 const max_index = (1u << index_bits) - 1;
+		if (subset->indices[anchor] <= (max_index >> 1))
+		{
+			return;
+		}
+
+		for (u32 c = 0; c < 4; ++c)
+		{
+			u32 const temp = subset->endpoints[0][c];
+			subset->endpoints[0][c] = subset->endpoints[1][c];
+			subset->endpoints[1][c] = temp;
+		}
+
+		u32 const temp = subset->pbits[0];
+		subset->pbits[0] = subset->pbits[1];
+		subset->pbits[1] = temp;
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			subset->indices[i] = (u8)(max_index - subset->indices[i]);
+		}
+	}
+
+	// Mode 6: one subset, RGBA with 7 bits and a p-bit per endpoint, 4 bit indices.
+	static f32 EncodeMode6(Texels const& block, FitOptions const& options, u8* dst)
+	{
+		EndpointFormat const format = { 4, 7, 4, PBits::Unique };
+		SubsetEncoding subset;
+		FitSubset(block, format, options, &subset);
+		FixAnchor(&subset, 0, format.index_bits);
+
+		BitWriter writer;
+		BeginBlock(&writer, 6);
+		for (u32 c = 0; c < 4; ++c)
+		{
+			WriteBits(&writer, subset.endpoints[0][c], 7);
+			WriteBits(&writer, subset.endpoints[1][c], 7);
+		}
+		WriteBits(&writer, subset.pbits[0], 1);
+		WriteBits(&writer, subset.pbits[1], 1);
+		for (u32 i = 0; i < 16; ++i)
+		{
+			WriteBits(&writer, subset.indices[i], i == 0 ? 3 : 4);
+		}
+		EndBlock(&writer, dst);
+
+		return subset.error;
+	}
+
+	// Mode 5: one subset, 7 bit RGB and 8 bit alpha endpoints with separate 2 bit indices. The rotation
+	// swaps alpha with one of the color channels first, so that one gets its own indices instead.
+	static f32 EncodeMode5(Texels const& block, u32 rotation, FitOptions const& options, u8* dst)
+	{
+		Texels color = block;
+		Texels scalar = block;
+		u32 const scalar_channel = rotation == 0 ? 3 : rotation - 1;
+		memcpy(color.channels[scalar_channel], block.channels[3], sizeof(block.channels[3]));
+		memcpy(scalar.channels[0], block.channels[scalar_channel], sizeof(block.channels[0]));
+
+		EndpointFormat const color_format = { 3, 7, 2, PBits::None };
+		EndpointFormat const scalar_format = { 1, 8, 2, PBits::None };
+		SubsetEncoding color_subset;
+		SubsetEncoding scalar_subset;
+		FitSubset(color, color_format, options, &color_subset);
+		FitSubset(scalar, scalar_format, options, &scalar_subset);
+		FixAnchor(&color_subset, 0, 2);
+		FixAnchor(&scalar_subset, 0, 2);
+
+		BitWriter writer;
+		BeginBlock(&writer, 5);
+		WriteBits(&writer, rotation, 2);
+		for (u32 c = 0; c < 3; ++c)
+		{
+			WriteBits(&writer, color_subset.endpoints[0][c], 7);
+			WriteBits(&writer, color_subset.endpoints[1][c], 7);
+		}
+		WriteBits(&writer, scalar_subset.endpoints[0][0], 8);
+		WriteBits(&writer, scalar_subset.endpoints[1][0], 8);
+		for (u32 i = 0; i < 16; ++i)
+		{
+			WriteBits(&writer, color_subset.indices[i], i == 0 ? 1 : 2);
+		}
+		for (u32 i = 0; i < 16; ++i)
+		{
+			WriteBits(&writer, scalar_subset.indices[i], i == 0 ? 1 : 2);
+		}
+		EndBlock(&writer, dst);
+
+		return color_subset.error + scalar_subset.error;
+	}
+
+	// Modes 1 (6 bit RGB, shared p-bits, 3 bit indices), 3 (7 bit RGB, 2 bit indices) and
+	// 7 (5 bit RGBA, 2 bit indices) with two subsets.
+	static f32 EncodeTwoSubsets(Texels const& block, u32 mode, u32 partition, FitOptions const& options, u8* dst)
+	{
+		EndpointFormat format;
+		switch (mode)
+		{
+		case 1:
+			format = { 3, 6, 3, PBits::Shared };
+			break;
+		case 3:
+			format = { 3, 7, 2, PBits::Unique };
+			break;
+		case 7:
+		default:
+			format = { 4, 5, 2, PBits::Unique };
+			break;
+		}
+
+		u32 const mask = BC7_PARTITIONS2[partition];
+		SubsetEncoding subsets[2];
+		u8 texel_indices[2][16];
+		for (u32 s = 0; s < 2; ++s)
+		{
+			Texels texels;
+			GatherSubset(block, mask, s, &texels, texel_indices[s]);
+			FitSubset(texels, format, options, &subsets[s]);
+
+			// Back to block order, so the anchors can be checked.
+			u8 packed[16];
+			memcpy(packed, subsets[s].indices, sizeof(packed));
+			memset(subsets[s].indices, 0, sizeof(subsets[s].indices));
+			for (u32 i = 0; i < texels.count; ++i)
+			{
+				subsets[s].indices[texel_indices[s][i]] = packed[i];
+			}
+		}
+
+		u32 const anchor = BC7_ANCHORS2[partition];
+		FixAnchor(&subsets[0], 0, format.index_bits);
+		FixAnchor(&subsets[1], anchor, format.index_bits);
+
+		BitWriter writer;
+		BeginBlock(&writer, mode);
+		WriteBits(&writer, partition, 6);
+		for (u32 c = 0; c < format.num_channels; ++c)
+		{
+			for (u32 s = 0; s < 2; ++s)
+			{
+				WriteBits(&writer, subsets[s].endpoints[0][c], format.bits);
+				WriteBits(&writer, subsets[s].endpoints[1][c], format.bits);
+			}
+		}
+
+		for (u32 s = 0; s < 2; ++s)
+		{
+			WriteBits(&writer, subsets[s].pbits[0], 1);
+			if (format.pbits == PBits::Unique)
+			{
+				WriteBits(&writer, subsets[s].pbits[1], 1);
+			}
+		}
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			u32 const s = (mask >> i) & 1;
+			WriteBits(&writer, subsets[s].indices[i], (i == 0 || i == anchor) ? format.index_bits - 1 : format.index_bits);
+		}
+		EndBlock(&writer, dst);
+
+		// Opaque modes decode alpha as 255.
+		f32 error = subsets[0].error + subsets[1].error;
+		if (format.num_channels == 3)
+		{
+			for (u32 i = 0; i < 16; ++i)
+			{
+				f32 const diff = 255.0f - block.channels[3][i];
+				error += diff * diff;
+			}
+		}
+		return error;
+	}
+
+	// Ranks the two subset partitions by how far their texels are from a line per subset: the covariance
+	// trace minus its largest eigenvalue. Writes the best num_candidates partitions, best first.
+	static void SelectPartitions(Texels const& block, u32 num_channels, u32 num_candidates, u32* out_partitions)
+	{
+		// Per texel channels and channel products. A subset adds them up under its mask, subset 0 is
+		// the block total minus subset 1.
+		static constexpr u32 MAX_MOMENTS = 4 + 10;
+		alignas(16) f32 moments[MAX_MOMENTS][16];
+		f32 totals[MAX_MOMENTS];
+		u32 num_moments = 0;
+		for (u32 a = 0; a < num_channels; ++a)
+		{
+			memcpy(moments[num_moments++], block.channels[a], sizeof(block.channels[a]));
+		}
+		for (u32 a = 0; a < num_channels; ++a)
+		{
+			for (u32 b = a; b < num_channels; ++b, ++num_moments)
+			{
+				for (u32 i = 0; i < 16; i += 4)
+				{
+					_mm_store_ps(moments[num_moments] + i, _mm_mul_ps(_mm_load_ps(block.channels[a] + i), _mm_load_ps(block.channels[b] + i)));
+				}
+			}
+		}
+		for (u32 m = 0; m < num_moments; ++m)
+		{
+			totals[m] = HorizontalSum(_mm_add_ps(_mm_add_ps(_mm_load_ps(moments[m]), _mm_load_ps(moments[m] + 4)),
+				_mm_add_ps(_mm_load_ps(moments[m] + 8), _mm_load_ps(moments[m] + 12))));
+		}
+
+		f32 candidate_errors[16];
+		for (u32 i = 0; i < num_candidates; ++i)
+		{
+			candidate_errors[i] = FLT_MAX;
+			out_partitions[i] = 0;
+		}
+
+		__m128i const lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+		for (u32 partition = 0; partition < 64; ++partition)
+		{
+			u32 const mask = BC7_PARTITIONS2[partition];
+			__m128 lane_masks[4];
+			for (u32 group = 0; group < 4; ++group)
+			{
+				__m128i const nibble = _mm_set1_epi32((s32)((mask >> (group * 4)) & 0xF));
+				lane_masks[group] = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(nibble, lane_bits), lane_bits));
+			}
+
+			f32 subset_moments[2][MAX_MOMENTS];
+			for (u32 m = 0; m < num_moments; ++m)
+			{
+				__m128 sum = _mm_and_ps(lane_masks[0], _mm_load_ps(moments[m]));
+				sum = _mm_add_ps(sum, _mm_and_ps(lane_masks[1], _mm_load_ps(moments[m] + 4)));
+				sum = _mm_add_ps(sum, _mm_and_ps(lane_masks[2], _mm_load_ps(moments[m] + 8)));
+				sum = _mm_add_ps(sum, _mm_and_ps(lane_masks[3], _mm_load_ps(moments[m] + 12)));
+				subset_moments[1][m] = HorizontalSum(sum);
+				subset_moments[0][m] = totals[m] - subset_moments[1][m];
+			}
+
+			u32 count1 = mask - ((mask >> 1) & 0x5555);
+			count1 = (count1 & 0x3333) + ((count1 >> 2) & 0x3333);
+			count1 = (count1 + (count1 >> 4)) & 0x0F0F;
+			count1 = (count1 + (count1 >> 8)) & 0x1F;
+			f32 const counts[2] = { (f32)(16 - count1), (f32)count1 };
+
+			f32 error = 0.0f;
+			for (u32 s = 0; s < 2; ++s)
+			{
+				f32 const* sum = subset_moments[s];
+				f32 const* sum_products = subset_moments[s] + num_channels;
+
+				f32 covariance[4][4];
+				f32 trace = 0.0f;
+				for (u32 a = 0, m = 0; a < num_channels; ++a)
+				{
+					for (u32 b = a; b < num_channels; ++b, ++m)
+					{
+						covariance[a][b] = sum_products[m] - sum[a] * sum[b] / counts[s];
+						covariance[b][a] = covariance[a][b];
+					}
+					trace += covariance[a][a];
+				}
+
+				// A few power iterations get close enough to the largest eigenvalue for ranking.
+				f32 v[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+				f32 eigenvalue = 0.0f;
+				for (u32 iteration = 0; iteration < 4; ++iteration)
+				{
+					f32 next[4];
+					f32 length_sq = 0.0f;
+					for (u32 a = 0; a < num_channels; ++a)
+					{
+						next[a] = 0.0f;
+						for (u32 b = 0; b < num_channels; ++b)
+						{
+							next[a] += covariance[a][b] * v[b];
+						}
+						length_sq += next[a] * next[a];
+					}
+
+					if (length_sq < 1e-12f)
+					{
+						break;
+					}
+
+					eigenvalue = sqrtf(length_sq);
+					for (u32 a = 0; a < num_channels; ++a)
+					{
+						v[a] = next[a] / eigenvalue;
+					}
+				}
+
+				error += max(trace - eigenvalue, 0.0f);
+			}
+
+			// Insertion into the sorted candidate list.
+			if (error >= candidate_errors[num_candidates - 1])
+			{
+				continue;
+			}
+
+			u32 slot = num_candidates - 1;
+			while (slot > 0 && candidate_errors[slot - 1] > error)
+			{
+				candidate_errors[slot] = candidate_errors[slot - 1];
+				out_partitions[slot] = out_partitions[slot - 1];
+				slot--;
+			}
+			candidate_errors[slot] = error;
+			out_partitions[slot] = partition;
+		}
+	}
+
+	// ====================================
+	//  Blocks
+	// ====================================
+
+	void CompressBlockBC1(u8* dst, u8 const* rgba)
+	{
+		Texels texels;
+		LoadTexels(rgba, &texels);
+		CompressColorBlock(dst, texels);
+	}
+
+	void CompressBlockBC3(u8* dst, u8 const* rgba)
+	{
+		CompressChannelBlock(dst, rgba, 3);
+
+		Texels texels;
+		LoadTexels(rgba, &texels);
+		CompressColorBlock(dst + 8, texels);
+	}
+
+	void CompressBlockBC4(u8* dst, u8 const* rgba)
+	{
+		CompressChannelBlock(dst, rgba, 0);
+	}
+
+	void CompressBlockBC5(u8* dst, u8 const* rgba)
+	{
+		CompressChannelBlock(dst, rgba, 0);
+		CompressChannelBlock(dst + 8, rgba, 1);
+	}
+
+	void CompressBlockBC7(u8* dst, u8 const* rgba, Quality::Enum quality)
+	{
+		Texels block;
+		LoadTexels(rgba, &block);
+
+		bool b_opaque = true;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			b_opaque &= block.channels[3][i] == 255.0f;
+		}
+
+		FitOptions options;
+		options.refine_iterations = quality == Quality::High ? 4 : quality == Quality::Normal ? 2 : 1;
+		options.b_all_pbits = quality == Quality::High;
+		f32 best_error = EncodeMode6(block, options, dst);
+		if (quality == Quality::Fast || best_error <= BC7_GOOD_ENOUGH_ERROR)
+		{
+			return;
+		}
+
+		u8 candidate[16];
+		auto keep_if_better = [&](f32 error)
+		{
+			if (error < best_error)
+			{
+				best_error = error;
+				memcpy(dst, candidate, sizeof(candidate));
+			}
+		};
+
+		if (!b_opaque)
+		{
+			u32 const num_rotations = quality == Quality::High ? 4 : 1;
+			for (u32 rotation = 0; rotation < num_rotations; ++rotation)
+			{
+				keep_if_better(EncodeMode5(block, rotation, options, candidate));
+			}
+		}
+
+		u32 partitions[16];
+		u32 const num_partitions = quality == Quality::High ? 16 : 4;
+		SelectPartitions(block, b_opaque ? 3 : 4, num_partitions, partitions);
+
+		for (u32 i = 0; i < num_partitions; ++i)
+		{
+			if (b_opaque)
+			{
+				keep_if_better(EncodeTwoSubsets(block, 1, partitions[i], options, candidate));
+				if (quality == Quality::High)
+				{
+					keep_if_better(EncodeTwoSubsets(block, 3, partitions[i], options, candidate));
+				}
+			}
+			else
+			{
+				keep_if_better(EncodeTwoSubsets(block, 7, partitions[i], options, candidate));
+			}
+		}
+	}
+
+	// ====================================
+	//  Decoding
+	// ====================================
+
+	// BC1 has 3 colors and transparent black when c0 <= c1, BC3 always has 4 colors.
+	static void DecompressColorBlock(u8* rgba, u8 const* src, bool b_allow_three_colors)
+	{
+		u16 c0;
+		u16 c1;
+		u32 bits;
+		memcpy(&c0, src, sizeof(c0));
+		memcpy(&c1, src + 2, sizeof(c1));
+		memcpy(&bits, src + 4, sizeof(bits));
+
+		u32 palette[4][4];
+		u32 const q0[3] = { (u32)c0 >> 11, ((u32)c0 >> 5) & 63, (u32)c0 & 31 };
+		u32 const q1[3] = { (u32)c1 >> 11, ((u32)c1 >> 5) & 63, (u32)c1 & 31 };
+		bool const b_four_colors = !b_allow_three_colors || c0 > c1;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			u32 const e0 = Expand(q0[c], BC1_CHANNEL_BITS[c]);
+			u32 const e1 = Expand(q1[c], BC1_CHANNEL_BITS[c]);
+			palette[0][c] = e0;
+			palette[1][c] = e1;
+			palette[2][c] = b_four_colors ? (2 * e0 + e1 + 1) / 3 : (e0 + e1 + 1) / 2;
+			palette[3][c] = b_four_colors ? (e0 + 2 * e1 + 1) / 3 : 0;
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = b_four_colors ? 255 : 0;
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			u32 const* entry = palette[(bits >> (i * 2)) & 3];
+			for (u32 c = 0; c < 4; ++c)
+			{
+				rgba[i * 4 + c] = (u8)entry[c];
+			}
+		}
+	}
+
+	static void DecompressChannelBlock(u8* rgba, u8 const* src, u32 channel)
+	{
+		u32 const e0 = src[0];
+		u32 const e1 = src[1];
+		u64 bits = 0;
+		memcpy(&bits, src + 2, 6);
+
+		// 6 steps between the endpoints, or 4 plus 0 and 255.
+		u32 ramp[8] = { e0, e1 };
+		for (u32 i = 1; i < 7; ++i)
+		{
+			ramp[i + 1] = e0 > e1 ? ((7 - i) * e0 + i * e1 + 3) / 7 : i < 5 ? ((5 - i) * e0 + i * e1 + 2) / 5 : i == 5 ? 0 : 255;
+		}
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			rgba[i * 4 + channel] = (u8)ramp[(bits >> (i * 3)) & 7];
+		}
+	}
+
+	void DecompressBlockBC1(u8* rgba, u8 const* src)
+	{
+		DecompressColorBlock(rgba, src, true);
+	}
+
+	void DecompressBlockBC3(u8* rgba, u8 const* src)
+	{
+		DecompressColorBlock(rgba, src + 8, false);
+		DecompressChannelBlock(rgba, src, 3);
+	}
+
+	void DecompressBlockBC4(u8* rgba, u8 const* src)
+	{
+		memset(rgba, 0, 64);
+		DecompressChannelBlock(rgba, src, 0);
+		for (u32 i = 0; i < 16; ++i)
+		{
+			rgba[i * 4 + 3] = 255;
+		}
+	}
+
+	void DecompressBlockBC5(u8* rgba, u8 const* src)
+	{
+		DecompressBlockBC4(rgba, src);
+		DecompressChannelBlock(rgba, src + 8, 1);
+	}
+
+	struct BitReader
+	{
+		u8 const* data;
+		u32 pos;
+	};
+
+	static u32 ReadBits(BitReader* reader, u32 num_bits)
+	{
+		u32 value = 0;
+		for (u32 i = 0; i < num_bits; ++i, ++reader->pos)
+		{
+			value |= (u32)((reader->data[reader->pos >> 3] >> (reader->pos & 7)) & 1) << i;
+		}
+		return value;
+	}
+
+	struct Bc7ModeInfo
+	{
+		u32 num_subsets;
+		u32 partition_bits;
+		u32 rotation_bits;
+		u32 index_selection_bits;
+		u32 color_bits;
+		u32 alpha_bits;
+		PBits::Enum pbits;
+		u32 index_bits;
+		u32 secondary_index_bits;
+	};
+
+	static constexpr Bc7ModeInfo BC7_MODES[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, PBits::Unique, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, PBits::Shared, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, PBits::None, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, PBits::Unique, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, PBits::None, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, PBits::None, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, PBits::Unique, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, PBits::Unique, 2, 0 },
+	};
+
+	// The three subset modes 0 and 2 are never written by the encoder and decode to zero like
+	// a reserved mode, their partition tables aren't needed anywhere else.
+	void DecompressBlockBC7(u8* rgba, u8 const* src)
+	{
+		u32 mode = 0;
+		while (mode < 8 && (src[0] & (1u << mode)) == 0)
+		{
+			mode++;
+		}
+
+		memset(rgba, 0, 64);
+		if (mode == 8 || BC7_MODES[mode].num_subsets == 3)
+		{
+			return;
+		}
+
+		Bc7ModeInfo const& info = BC7_MODES[mode];
+		BitReader reader = { src, mode + 1 };
+		u32 const partition = ReadBits(&reader, info.partition_bits);
+		u32 const rotation = ReadBits(&reader, info.rotation_bits);
+		u32 const index_selection = ReadBits(&reader, info.index_selection_bits);
+
+		// [subset][endpoint][channel]
+		u32 endpoints[2][2][4] = {};
+		for (u32 c = 0; c < 4; ++c)
+		{
+			u32 const bits = c < 3 ? info.color_bits : info.alpha_bits;
+			for (u32 s = 0; s < info.num_subsets; ++s)
+			{
+				endpoints[s][0][c] = ReadBits(&reader, bits);
+				endpoints[s][1][c] = ReadBits(&reader, bits);
+			}
+		}
+
+		for (u32 s = 0; s < info.num_subsets; ++s)
+		{
+			u32 pbits[2] = {};
+			if (info.pbits == PBits::Unique)
+			{
+				pbits[0] = ReadBits(&reader, 1);
+				pbits[1] = ReadBits(&reader, 1);
+			}
+			else if (info.pbits == PBits::Shared)
+			{
+				pbits[0] = pbits[1] = ReadBits(&reader, 1);
+			}
+
+			u32 const extra = info.pbits == PBits::None ? 0 : 1;
+			for (u32 e = 0; e < 2; ++e)
+			{
+				for (u32 c = 0; c < 4; ++c)
+				{
+					u32 const bits = c < 3 ? info.color_bits : info.alpha_bits;
+					endpoints[s][e][c] = bits == 0 ? 255 : Expand((endpoints[s][e][c] << extra) | pbits[e], bits + extra);
+				}
+			}
+		}
+
+		u32 const mask = info.num_subsets == 2 ? BC7_PARTITIONS2[partition] : 0;
+		u32 const anchor = info.num_subsets == 2 ? BC7_ANCHORS2[partition] : 0;
+		u32 indices[16];
+		for (u32 i = 0; i < 16; ++i)
+		{
+			indices[i] = ReadBits(&reader, (i == 0 || (mask && i == anchor)) ? info.index_bits - 1 : info.index_bits);
+		}
+		u32 secondary_indices[16] = {};
+		for (u32 i = 0; info.secondary_index_bits && i < 16; ++i)
+		{
+			secondary_indices[i] = ReadBits(&reader, i == 0 ? info.secondary_index_bits - 1 : info.secondary_index_bits);
+		}
+		ASSERT(reader.pos == 128);
+
+		for (u32 i = 0; i < 16; ++i)
+		{
+			u32 const s = (mask >> i) & 1;
+			u32 color_index = indices[i];
+			u32 alpha_index = info.secondary_index_bits ? secondary_indices[i] : indices[i];
+			u32 color_bits = info.index_bits;
+			u32 alpha_bits = info.secondary_index_bits ? info.secondary_index_bits : info.index_bits;
+			if (index_selection)
+			{
+				u32 const temp_index = color_index;
+				color_index = alpha_index;
+				alpha_index = temp_index;
+				u32 const temp_bits = color_bits;
+				color_bits = alpha_bits;
+				alpha_bits = temp_bits;
+			}
+
+			u8* texel = rgba + i * 4;
+			for (u32 c = 0; c < 4; ++c)
+			{
+				u32 const weight = c < 3 ? GetIndexWeights(color_bits)[color_index] : GetIndexWeights(alpha_bits)[alpha_index];
+				texel[c] = (u8)(((64 - weight) * endpoints[s][0][c] + weight * endpoints[s][1][c] + 32) >> 6);
+			}
+
+			if (rotation != 0)
+			{
+				u8 const temp = texel[3];
+				texel[3] = texel[rotation - 1];
+				texel[rotation - 1] = temp;
+			}
+		}
+	}
+
+	void DecompressBlock(u8* rgba, u8 const* src, Gfx::TextureFormat::Enum format)
+	{
+		switch (format)
+		{
+		case Gfx::TextureFormat::BC1:
+			DecompressBlockBC1(rgba, src);
+			break;
+		case Gfx::TextureFormat::BC3:
+			DecompressBlockBC3(rgba, src);
+			break;
+		case Gfx::TextureFormat::BC4:
+			DecompressBlockBC4(rgba, src);
+			break;
+		case Gfx::TextureFormat::BC5:
+			DecompressBlockBC5(rgba, src);
+			break;
+		case Gfx::TextureFormat::BC7:
+			DecompressBlockBC7(rgba, src);
+			break;
+		default:
+			ASSERT_FAIL_F("Not a block compressed format!");
+			break;
+		}
+	}
+
+	// ====================================
+	//  Surfaces
+	// ====================================
+
+	u32 GetBlockSize(Gfx::TextureFormat::Enum format)
+	{
+		switch (format)
+		{
+		case Gfx::TextureFormat::BC1:
+		case Gfx::TextureFormat::BC4:
+			return 8;
+		case Gfx::TextureFormat::BC3:
+		case Gfx::TextureFormat::BC5:
+		case Gfx::TextureFormat::BC7:
+			return 16;
+		default:
+			ASSERT_FAIL_F("Not a block compressed format!");
+			return 0;
+		}
+	}
+
+	u64 GetCompressedSize(Gfx::TextureFormat::Enum format, u32 width, u32 height)
+	{
+		if (format == Gfx::TextureFormat::RGBA8)
+		{
+			return (u64)width * height * 4;
+		}
+
+		return (u64)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+	}
+
+	// Edge blocks repeat the last column and row.
+	static void LoadBlock(Image::Surface const& surface, u32 block_x, u32 block_y, u8* out_rgba)
+	{
+		u32 const x0 = block_x * 4;
+		u32 const y0 = block_y * 4;
+		u64 const pitch = (u64)surface.width * 4;
+
+		if (x0 + 4 <= surface.width && y0 + 4 <= surface.height)
+		{
+			for (u32 y = 0; y < 4; ++y)
+			{
+				memcpy(out_rgba + y * 16, surface.pixels + (y0 + y) * pitch + x0 * 4, 16);
+			}
+			return;
+		}
+
+		for (u32 y = 0; y < 4; ++y)
+		{
+			u8 const* row = surface.pixels + min(y0 + y, surface.height - 1) * pitch;
+			for (u32 x = 0; x < 4; ++x)
+			{
+				memcpy(out_rgba + y * 16 + x * 4, row + min(x0 + x, surface.width - 1) * 4, 4);
+			}
+		}
+	}
+
+	struct CompressTask
+	{
+		u8* dst;
+		Image::Surface const* levels;
+		u32 num_levels;
+		Gfx::TextureFormat::Enum format;
+		Quality::Enum quality;
+
+		// Rows of blocks of all levels are numbered back to back.
+		u64 level_offsets[MAX_LEVELS];
+		u32 level_first_rows[MAX_LEVELS + 1];
+	};
+
+	static void CompressRows(void* user_data, u64 begin, u64 end)
+	{
+		CompressTask const* task = static_cast<CompressTask const*>(user_data);
+		u32 const block_size = GetBlockSize(task->format);
+
+		u32 level = 0;
+		for (u64 row = begin; row < end; ++row)
+		{
+			while (row >= task->level_first_rows[level + 1])
+			{
+				level++;
+			}
+
+			Image::Surface const& surface = task->levels[level];
+			u32 const block_y = (u32)row - task->level_first_rows[level];
+			u32 const blocks_x = (surface.width + 3) / 4;
+			u8* dst = task->dst + task->level_offsets[level] + (u64)block_y * blocks_x * block_size;
+
+			for (u32 block_x = 0; block_x < blocks_x; ++block_x, dst += block_size)
+			{
+				alignas(16) u8 rgba[64];
+				LoadBlock(surface, block_x, block_y, rgba);
+
+				switch (task->format)
+				{
+				case Gfx::TextureFormat::BC1:
+					CompressBlockBC1(dst, rgba);
+					break;
+				case Gfx::TextureFormat::BC3:
+					CompressBlockBC3(dst, rgba);
+					break;
+				case Gfx::TextureFormat::BC4:
+					CompressBlockBC4(dst, rgba);
+					break;
+				case Gfx::TextureFormat::BC5:
+					CompressBlockBC5(dst, rgba);
+					break;
+				case Gfx::TextureFormat::BC7:
+				default:
+					CompressBlockBC7(dst, rgba, task->quality);
+					break;
+				}
+			}
+		}
+	}
+
+	void Compress(u8* dst, Image::Surface const* levels, u32 num_levels, Gfx::TextureFormat::Enum format, Quality::Enum quality)
+	{
+		ASSERT(num_levels > 0 && num_levels <= MAX_LEVELS);
+		ASSERT_F(format != Gfx::TextureFormat::RGBA8, "RGBA8 is not block compressed!");
+
+		CompressTask task;
+		task.dst = dst;
+		task.levels = levels;
+		task.num_levels = num_levels;
+		task.format = format;
+		task.quality = quality;
+
+		u64 offset = 0;
+		u32 num_rows = 0;
+		for (u32 level = 0; level < num_levels; ++level)
+		{
+			task.level_offsets[level] = offset;
+			task.level_first_rows[level] = num_rows;
+			offset += GetCompressedSize(format, levels[level].width, levels[level].height);
+			num_rows += (levels[level].height + 3) / 4;
+		}
+		task.level_first_rows[num_levels] = num_rows;
+
+		// A row of BC7 blocks is plenty of work for a job, small levels share one.
+		Jobs::ParallelFor(num_rows, 1, &CompressRows, &task);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "ImageDecode.h"
+
+// ====================================
+//  Block Compression (BCn)
+//  Notes:
+//  *) Encodes RGBA8 surfaces to BC1, BC3, BC4, BC5 and BC7. Every
+//     4x4 block is encoded on its own, edge blocks repeat the last
+//     row and column.
+//  *) BC1 and the color part of BC3 fit endpoints along the principal
+//     axis of the block and refine them by least squares (Brown,
+//     "DXT Compression Techniques", and stb_dxt). BC4 and BC5 place
+//     their 8 step ramp between the block's extremes.
+//  *) BC7 searches modes 6, 5, 1, 3 and 7 depending on the quality,
+//     the two subset modes only try the partitions whose principal
+//     axis fit looks best. See Quality below.
+//  *) The 16 texels of a block sit in 4 SSE registers per channel,
+//     index search and error sums run on all of them at once.
+//  *) Rows of blocks of all levels are spread over the job system.
+// ====================================
+
+namespace BlockCompression
+{
+	struct Quality
+	{
+		enum Enum : u32
+		{
+			// BC7 mode 6 only. Enough for runtime encodes.
+			Fast,
+
+			// Adds modes 1 (opaque) or 5 and 7 (alpha) with the 4 most promising partitions.
+			Normal,
+
+			// Adds mode 3, all rotations of mode 5 and the 16 most promising partitions, and refines longer.
+			High,
+		};
+	};
+
+	// Enough for a full mip chain of Image::MAX_DIMENSION.
+	static constexpr u32 MAX_LEVELS = 15;
+
+	// Bytes per 4x4 block, 8 or 16. RGBA8 is not block compressed.
+	u32 GetBlockSize(Gfx::TextureFormat::Enum format);
+
+	// Size of one compressed level, partial blocks at the edges count as whole ones.
+	u64 GetCompressedSize(Gfx::TextureFormat::Enum format, u32 width, u32 height);
+
+	// A single block, rgba holds 4 rows of 4 texels.
+	void CompressBlockBC1(u8* dst, u8 const* rgba);
+	void CompressBlockBC3(u8* dst, u8 const* rgba);
+	void CompressBlockBC4(u8* dst, u8 const* rgba); // Red
+	void CompressBlockBC5(u8* dst, u8 const* rgba); // Red and green
+	void CompressBlockBC7(u8* dst, u8 const* rgba, Quality::Enum quality);
+
+	// Decoders for a single block, for checking the encoders. rgba receives 4 rows of 4 texels, BC4
+	// and BC5 decode to red (and green) with blue 0 and alpha 255, like the GPU does.
+	void DecompressBlockBC1(u8* rgba, u8 const* src);
+	void DecompressBlockBC3(u8* rgba, u8 const* src);
+	void DecompressBlockBC4(u8* rgba, u8 const* src);
+	void DecompressBlockBC5(u8* rgba, u8 const* src);
+	void DecompressBlockBC7(u8* rgba, u8 const* src); // Modes 0 and 2 are not supported.
+	void DecompressBlock(u8* rgba, u8 const* src, Gfx::TextureFormat::Enum format);
+
+	// Compresses every level into dst, one after the other, with GetCompressedSize() bytes each.
+	// Blocks are written row by row. Blocks until all rows are done.
+	void Compress(u8* dst, Image::Surface const* levels, u32 num_levels, Gfx::TextureFormat::Enum format, Quality::Enum quality);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
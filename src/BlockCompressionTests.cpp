@@ -0,0 +1,160 @@
+#include "BlockCompression.h"
+#include "TestUtils.h"
+
+namespace BlockCompression
+{
+namespace Test
+{
+	// Compresses a single level and compares the decoded texels inside the surface, in the first num_channels channels.
+	static f64 RoundTripPsnr(Image::Surface const& surface, Gfx::TextureFormat::Enum format, Quality::Enum quality, u32 num_channels)
+	{
+		u64 const size = GetCompressedSize(format, surface.width, surface.height);
+		u8* compressed = new u8[size];
+		ON_SCOPE_EXIT(delete[] compressed);
+		Compress(compressed, &surface, 1, format, quality);
+
+		u32 const block_size = GetBlockSize(format);
+		u32 const blocks_x = (surface.width + 3) / 4;
+		u32 const blocks_y = (surface.height + 3) / 4;
+		f64 squared_error = 0.0;
+		u64 num_samples = 0;
+		for (u32 block_y = 0; block_y < blocks_y; ++block_y)
+		{
+			for (u32 block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				u8 decoded[64];
+				DecompressBlock(decoded, compressed + ((u64)block_y * blocks_x + block_x) * block_size, format);
+
+				for (u32 y = block_y * 4; y < min(block_y * 4 + 4, surface.height); ++y)
+				{
+					for (u32 x = block_x * 4; x < min(block_x * 4 + 4, surface.width); ++x)
+					{
+						u8 const* original = surface.pixels + ((u64)y * surface.width + x) * 4;
+						u8 const* texel = decoded + ((y % 4) * 4 + x % 4) * 4;
+						for (u32 c = 0; c < num_channels; ++c)
+						{
+							f64 const diff = (f64)texel[c] - (f64)original[c];
+							squared_error += diff * diff;
+						}
+						num_samples += num_channels;
+					}
+				}
+			}
+		}
+
+		return TestUtils::Psnr(squared_error, num_samples);
+	}
+
+	// The sizes aren't multiples of 4, so the edge blocks are checked too.
+	void RoundTripPsnrAboveThreshold()
+	{
+		static constexpr u32 WIDTH = 130;
+		static constexpr u32 HEIGHT = 98;
+		u8* opaque = new u8[WIDTH * HEIGHT * 4];
+		u8* translucent = new u8[WIDTH * HEIGHT * 4];
+		ON_SCOPE_EXIT(delete[] opaque; delete[] translucent);
+
+		TestUtils::Random random;
+		TestUtils::FillImage(opaque, WIDTH, HEIGHT, true, random);
+		TestUtils::FillImage(translucent, WIDTH, HEIGHT, false, random);
+		Image::Surface const opaque_surface = { opaque, WIDTH, HEIGHT };
+		Image::Surface const translucent_surface = { translucent, WIDTH, HEIGHT };
+
+		// About 1 dB below what the encoders reach today: BC1 39.5, BC4 52.8, BC7 42.2, 45.3 and 45.6
+		// per quality, or 41.6, 42.7 and 44.4 with alpha. The noise keeps all of them from going much higher.
+		ASSERT(RoundTripPsnr(opaque_surface, Gfx::TextureFormat::BC1, Quality::Normal, 3) > 38.5);
+		ASSERT(RoundTripPsnr(opaque_surface, Gfx::TextureFormat::BC4, Quality::Normal, 1) > 51.5);
+
+		f64 opaque_psnr[3];
+		f64 translucent_psnr[3];
+		for (u32 quality = 0; quality < 3; ++quality)
+		{
+			opaque_psnr[quality] = RoundTripPsnr(opaque_surface, Gfx::TextureFormat::BC7, (Quality::Enum)quality, 3);
+			translucent_psnr[quality] = RoundTripPsnr(translucent_surface, Gfx::TextureFormat::BC7, (Quality::Enum)quality, 4);
+		}
+
+		ASSERT(opaque_psnr[0] > 41.0 && translucent_psnr[0] > 40.5);
+		ASSERT(opaque_psnr[1] > opaque_psnr[0] + 2.0 && translucent_psnr[1] > translucent_psnr[0] + 0.5);
+		ASSERT(opaque_psnr[2] >= opaque_psnr[1] && translucent_psnr[2] > translucent_psnr[1] + 1.0);
+
+		// The decoder only checks the modes the encoder picked, make sure that's all of them.
+		u32 const num_blocks = (WIDTH + 3) / 4 * ((HEIGHT + 3) / 4);
+		u8* compressed = new u8[num_blocks * 16 * 2];
+		ON_SCOPE_EXIT(delete[] compressed);
+		Compress(compressed, &opaque_surface, 1, Gfx::TextureFormat::BC7, Quality::High);
+		Compress(compressed + num_blocks * 16, &translucent_surface, 1, Gfx::TextureFormat::BC7, Quality::High);
+
+		u32 used_modes = 0;
+		for (u32 i = 0; i < num_blocks * 2; ++i)
+		{
+			used_modes |= compressed[i * 16] & (u8)(-compressed[i * 16]);
+		}
+		ASSERT(used_modes == ((1 << 1) | (1 << 3) | (1 << 5) | (1 << 6) | (1 << 7)));
+	}
+
+	// Flat blocks of every value. BC4 hits them exactly, BC1 comes as close as its 1/3 entry allows and
+	// BC7 mode 6 can be off by one where a channel doesn't agree with the p-bit of the others.
+	void FlatBlocks()
+	{
+		for (u32 value = 0; value < 256; ++value)
+		{
+			u8 rgba[64];
+			for (u32 i = 0; i < 16; ++i)
+			{
+				rgba[i * 4 + 0] = (u8)value;
+				rgba[i * 4 + 1] = (u8)(255 - value);
+				rgba[i * 4 + 2] = (u8)(value / 2 + 64);
+				rgba[i * 4 + 3] = (u8)(value ^ 0x5A);
+			}
+
+			u8 block[16];
+			u8 bc1[64];
+			u8 bc4[64];
+			u8 bc7[64];
+			CompressBlockBC1(block, rgba);
+			DecompressBlockBC1(bc1, block);
+			CompressBlockBC4(block, rgba);
+			DecompressBlockBC4(bc4, block);
+			CompressBlockBC7(block, rgba, Quality::Fast);
+			DecompressBlockBC7(bc7, block);
+
+			for (u32 i = 0; i < 16; ++i)
+			{
+				for (u32 c = 0; c < 4; ++c)
+				{
+					ASSERT(c == 3 ? bc1[i * 4 + c] == 255 : abs(bc1[i * 4 + c] - rgba[i * 4 + c]) <= 1);
+					ASSERT(abs(bc7[i * 4 + c] - rgba[i * 4 + c]) <= 1);
+				}
+				ASSERT(bc4[i * 4] == rgba[i * 4] && bc4[i * 4 + 1] == 0 && bc4[i * 4 + 2] == 0 && bc4[i * 4 + 3] == 255);
+			}
+		}
+	}
+
+	// c0 <= c1 switches BC1 to 3 colors, index 3 is transparent black. The encoder never writes those.
+	void DecodesThreeColorBC1()
+	{
+		u16 const c0 = 0x001F; // Blue
+		u16 const c1 = 0xF800; // Red
+		u32 const indices = 0xE4E4E4E4; // 0, 1, 2, 3 per row
+		u8 block[8];
+		memcpy(block, &c0, 2);
+		memcpy(block + 2, &c1, 2);
+		memcpy(block + 4, &indices, 4);
+
+		u8 rgba[64];
+		DecompressBlockBC1(rgba, block);
+		u8 const expected[4][4] = { { 0, 0, 255, 255 }, { 255, 0, 0, 255 }, { 128, 0, 128, 255 }, { 0, 0, 0, 0 } };
+		for (u32 i = 0; i < 16; ++i)
+		{
+			ASSERT(memcmp(rgba + i * 4, expected[i % 4], 4) == 0);
+		}
+	}
+
+	void Run()
+	{
+		RoundTripPsnrAboveThreshold();
+		FlatBlocks();
+		DecodesThreeColorBC1();
+	}
+}
+}
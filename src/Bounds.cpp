@@ -0,0 +1,508 @@
+#include "Bounds.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+#include <float.h>
+
+namespace Bounds
+{
+	static constexpr u64 PARALLEL_BATCH_SIZE = 16 * 1024;
+	using Jobs::MAX_THREADS;
+
+	// EPOS-14: the 3 axes and the 4 cube diagonals.
+	static constexpr u32 NUM_EPOS_DIRS = 7;
+
+	static MM_FORCEINL f32 DistanceSq(vec3 a, vec3 b)
+	{
+		f32 dx = a.x - b.x;
+		f32 dy = a.y - b.y;
+		f32 dz = a.z - b.z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	// Copies the last (count % 4) vertices into a block of 4, repeating the last one,
+	// so the kernels can always load full blocks without changing the result.
+	static void PadTail(vec3 const* positions, u64 begin, u64 end, vec3* out_block)
+	{
+		for (u32 i = 0; i < 4; ++i)
+		{
+			out_block[i] = positions[min(begin + i, end - 1)];
+		}
+	}
+
+	// ====================================
+	//  AABB
+	// ====================================
+
+	static AABB ComputeAABBRange(vec3 const* positions, u64 begin, u64 end)
+	{
+		__m128 min_x = _mm_set1_ps(FLT_MAX);
+		__m128 min_y = min_x;
+		__m128 min_z = min_x;
+		__m128 max_x = _mm_set1_ps(-FLT_MAX);
+		__m128 max_y = max_x;
+		__m128 max_z = max_x;
+
+		u64 const simd_end = begin + ((end - begin) & ~3ull);
+		for (u64 i = begin; i < end; i += 4)
+		{
+			vec3 tail[4];
+			vec3 const* block = positions + i;
+			if (i >= simd_end)
+			{
+				PadTail(positions, i, end, tail);
+				block = tail;
+			}
+
+			__m128 x, y, z;
+			Simd::LoadVec3x4(block, x, y, z);
+
+			min_x = _mm_min_ps(min_x, x);
+			min_y = _mm_min_ps(min_y, y);
+			min_z = _mm_min_ps(min_z, z);
+			max_x = _mm_max_ps(max_x, x);
+			max_y = _mm_max_ps(max_y, y);
+			max_z = _mm_max_ps(max_z, z);
+		}
+
+		AABB aabb;
+		aabb.min = vec3(Simd::HorizontalMin(min_x), Simd::HorizontalMin(min_y), Simd::HorizontalMin(min_z));
+		aabb.max = vec3(Simd::HorizontalMax(max_x), Simd::HorizontalMax(max_y), Simd::HorizontalMax(max_z));
+		return aabb;
+	}
+
+	struct AABBTask
+	{
+		vec3 const* positions;
+		AABB partials[MAX_THREADS];
+		bool b_has_partial[MAX_THREADS];
+	};
+
+	static void ComputeAABBBatch(void* user_data, u64 begin, u64 end)
+	{
+		AABBTask* task = static_cast<AABBTask*>(user_data);
+		u32 const thread_idx = Jobs::GetThreadIndex();
+
+		AABB aabb = ComputeAABBRange(task->positions, begin, end);
+		if (task->b_has_partial[thread_idx])
+		{
+			aabb = Merge(task->partials[thread_idx], aabb);
+		}
+
+		task->partials[thread_idx] = aabb;
+		task->b_has_partial[thread_idx] = true;
+	}
+
+	AABB ComputeAABB(vec3 const* positions, u64 count)
+	{
+		if (count == 0)
+		{
+			AABB empty;
+			empty.min = vec3(0.0f, 0.0f, 0.0f);
+			empty.max = vec3(0.0f, 0.0f, 0.0f);
+			return empty;
+		}
+
+		if (count < PARALLEL_MIN_VERTICES || Jobs::GetThreadCount() == 1)
+		{
+			return ComputeAABBRange(positions, 0, count);
+		}
+
+		AABBTask task;
+		task.positions = positions;
+		memzero(task.b_has_partial, sizeof(task.b_has_partial));
+
+		Jobs::ParallelFor(count, PARALLEL_BATCH_SIZE, &ComputeAABBBatch, &task);
+
+		AABB result = ComputeAABBRange(positions, 0, 1);
+		for (u32 i = 0; i < MAX_THREADS; ++i)
+		{
+			if (task.b_has_partial[i])
+			{
+				result = Merge(result, task.partials[i]);
+			}
+		}
+		return result;
+	}
+
+	AABB Merge(AABB const& a, AABB const& b)
+	{
+		AABB result;
+		result.min = vec3(min(a.min.x, b.min.x), min(a.min.y, b.min.y), min(a.min.z, b.min.z));
+		result.max = vec3(max(a.max.x, b.max.x), max(a.max.y, b.max.y), max(a.max.z, b.max.z));
+		return result;
+	}
+
+	// ====================================
+	//  Bounding Sphere
+	// ====================================
+
+	struct Extremes
+	{
+		f32 min_proj[NUM_EPOS_DIRS];
+		f32 max_proj[NUM_EPOS_DIRS];
+		u64 min_idx[NUM_EPOS_DIRS];
+		u64 max_idx[NUM_EPOS_DIRS];
+	};
+
+	static MM_FORCEINL void MM_VECTORCALL ProjectEpos(__m128 x, __m128 y, __m128 z, __m128* out_proj)
+	{
+		__m128 x_plus_y = _mm_add_ps(x, y);
+		__m128 x_minus_y = _mm_sub_ps(x, y);
+
+		out_proj[0] = x;
+		out_proj[1] = y;
+		out_proj[2] = z;
+		out_proj[3] = _mm_add_ps(x_plus_y, z);
+		out_proj[4] = _mm_sub_ps(x_plus_y, z);
+		out_proj[5] = _mm_add_ps(x_minus_y, z);
+		out_proj[6] = _mm_sub_ps(x_minus_y, z);
+	}
+
+	// Finds the vertices with the smallest and largest projection onto each EPOS direction.
+	// Vertex indices are tracked per lane, relative to begin, so the range must stay below 2^31.
+	static Extremes FindExtremesRange(vec3 const* positions, u64 begin, u64 end)
+	{
+		__m128 min_proj[NUM_EPOS_DIRS];
+		__m128 max_proj[NUM_EPOS_DIRS];
+		__m128i min_idx[NUM_EPOS_DIRS];
+		__m128i max_idx[NUM_EPOS_DIRS];
+
+		for (u32 d = 0; d < NUM_EPOS_DIRS; ++d)
+		{
+			min_proj[d] = _mm_set1_ps(FLT_MAX);
+			max_proj[d] = _mm_set1_ps(-FLT_MAX);
+			min_idx[d] = _mm_setzero_si128();
+			max_idx[d] = _mm_setzero_si128();
+		}
+
+		__m128i lane_idx = _mm_setr_epi32(0, 1, 2, 3);
+		__m128i const lane_step = _mm_set1_epi32(4);
+
+		u64 const simd_end = begin + ((end - begin) & ~3ull);
+		for (u64 i = begin; i < end; i += 4)
+		{
+			vec3 tail[4];
+			vec3 const* block = positions + i;
+			if (i >= simd_end)
+			{
+				PadTail(positions, i, end, tail);
+				block = tail;
+			}
+
+			__m128 x, y, z;
+			Simd::LoadVec3x4(block, x, y, z);
+
+			__m128 proj[NUM_EPOS_DIRS];
+			ProjectEpos(x, y, z, proj);
+
+			for (u32 d = 0; d < NUM_EPOS_DIRS; ++d)
+			{
+				__m128 is_less = _mm_cmplt_ps(proj[d], min_proj[d]);
+				__m128 is_greater = _mm_cmpgt_ps(proj[d], max_proj[d]);
+
+				min_proj[d] = _mm_min_ps(min_proj[d], proj[d]);
+				max_proj[d] = _mm_max_ps(max_proj[d], proj[d]);
+				min_idx[d] = _mm_blendv_epi8(min_idx[d], lane_idx, _mm_castps_si128(is_less));
+				max_idx[d] = _mm_blendv_epi8(max_idx[d], lane_idx, _mm_castps_si128(is_greater));
+			}
+
+			lane_idx = _mm_add_epi32(lane_idx, lane_step);
+		}
+
+		Extremes extremes;
+		for (u32 d = 0; d < NUM_EPOS_DIRS; ++d)
+		{
+			alignas(16) f32 min_lanes[4];
+			alignas(16) f32 max_lanes[4];
+			alignas(16) s32 min_lane_idx[4];
+			alignas(16) s32 max_lane_idx[4];
+			_mm_store_ps(min_lanes, min_proj[d]);
+			_mm_store_ps(max_lanes, max_proj[d]);
+			_mm_store_si128(reinterpret_cast<__m128i*>(min_lane_idx), min_idx[d]);
+			_mm_store_si128(reinterpret_cast<__m128i*>(max_lane_idx), max_idx[d]);
+
+			u32 best_min = 0;
+			u32 best_max = 0;
+			for (u32 lane = 1; lane < 4; ++lane)
+			{
+				if (min_lanes[lane] < min_lanes[best_min]) best_min = lane;
+				if (max_lanes[lane] > max_lanes[best_max]) best_max = lane;
+			}
+
+			// Padded tail lanes point past the end, but they are copies of the last vertex.
+			extremes.min_proj[d] = min_lanes[best_min];
+			extremes.max_proj[d] = max_lanes[best_max];
+			extremes.min_idx[d] = min(begin + min_lane_idx[best_min], end - 1);
+			extremes.max_idx[d] = min(begin + max_lane_idx[best_max], end - 1);
+		}
+
+		return extremes;
+	}
+
+	static void MergeExtremes(Extremes* dst, Extremes const& src)
+	{
+		for (u32 d = 0; d < NUM_EPOS_DIRS; ++d)
+		{
+			if (src.min_proj[d] < dst->min_proj[d])
+			{
+				dst->min_proj[d] = src.min_proj[d];
+				dst->min_idx[d] = src.min_idx[d];
+			}
+			if (src.max_proj[d] > dst->max_proj[d])
+			{
+				dst->max_proj[d] = src.max_proj[d];
+				dst->max_idx[d] = src.max_idx[d];
+			}
+		}
+	}
+
+	// Returns the squared distance of the farthest vertex, and grows the sphere (Ritter) if
+	// grow is set. Blocks of 4 that are fully inside are rejected without leaving SIMD.
+	static f32 MaxDistanceSqRange(vec3 const* positions, u64 begin, u64 end, Sphere* sphere, bool b_grow)
+	{
+		__m128 max_dist_sq = _mm_setzero_ps();
+		__m128 radius_sq = _mm_set1_ps(sphere->radius * sphere->radius);
+		__m128 center_x = _mm_set1_ps(sphere->center.x);
+		__m128 center_y = _mm_set1_ps(sphere->center.y);
+		__m128 center_z = _mm_set1_ps(sphere->center.z);
+
+		u64 const simd_end = begin + ((end - begin) & ~3ull);
+		for (u64 i = begin; i < end; i += 4)
+		{
+			vec3 tail[4];
+			vec3 const* block = positions + i;
+			if (i >= simd_end)
+			{
+				PadTail(positions, i, end, tail);
+				block = tail;
+			}
+
+			__m128 x, y, z;
+			Simd::LoadVec3x4(block, x, y, z);
+
+			__m128 dx = _mm_sub_ps(x, center_x);
+			__m128 dy = _mm_sub_ps(y, center_y);
+			__m128 dz = _mm_sub_ps(z, center_z);
+			__m128 dist_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			if (!b_grow)
+			{
+				max_dist_sq = _mm_max_ps(max_dist_sq, dist_sq);
+				continue;
+			}
+
+			if (_mm_movemask_ps(_mm_cmpgt_ps(dist_sq, radius_sq)) == 0)
+			{
+				continue;
+			}
+
+			for (u32 lane = 0; lane < 4; ++lane)
+			{
+				vec3 p = block[lane];
+				f32 d_sq = DistanceSq(p, sphere->center);
+				if (d_sq <= sphere->radius * sphere->radius)
+				{
+					continue;
+				}
+
+				// Move the center towards p so the new sphere touches both p and the far side of the old one.
+				f32 dist = sqrtf(d_sq);
+				f32 new_radius = (sphere->radius + dist) * 0.5f;
+				f32 shift = (new_radius - sphere->radius) / dist;
+				sphere->center.x += (p.x - sphere->center.x) * shift;
+				sphere->center.y += (p.y - sphere->center.y) * shift;
+				sphere->center.z += (p.z - sphere->center.z) * shift;
+				sphere->radius = new_radius;
+			}
+
+			radius_sq = _mm_set1_ps(sphere->radius * sphere->radius);
+			center_x = _mm_set1_ps(sphere->center.x);
+			center_y = _mm_set1_ps(sphere->center.y);
+			center_z = _mm_set1_ps(sphere->center.z);
+		}
+
+		return Simd::HorizontalMax(max_dist_sq);
+	}
+
+	struct SphereTask
+	{
+		vec3 const* positions;
+		Sphere seed;
+
+		Extremes extremes[MAX_THREADS];
+		Sphere spheres[MAX_THREADS];
+		f32 max_dist_sq[MAX_THREADS];
+		bool b_has_partial[MAX_THREADS];
+	};
+
+	static void FindExtremesBatch(void* user_data, u64 begin, u64 end)
+	{
+		SphereTask* task = static_cast<SphereTask*>(user_data);
+		u32 const thread_idx = Jobs::GetThreadIndex();
+
+		Extremes extremes = FindExtremesRange(task->positions, begin, end);
+		if (task->b_has_partial[thread_idx])
+		{
+			MergeExtremes(&task->extremes[thread_idx], extremes);
+		}
+		else
+		{
+			task->extremes[thread_idx] = extremes;
+			task->b_has_partial[thread_idx] = true;
+		}
+	}
+
+	// Every thread grows its own copy of the seed sphere, the results are merged afterwards.
+	static void GrowSphereBatch(void* user_data, u64 begin, u64 end)
+	{
+		SphereTask* task = static_cast<SphereTask*>(user_data);
+		u32 const thread_idx = Jobs::GetThreadIndex();
+
+		if (!task->b_has_partial[thread_idx])
+		{
+			task->spheres[thread_idx] = task->seed;
+			task->b_has_partial[thread_idx] = true;
+		}
+
+		MaxDistanceSqRange(task->positions, begin, end, &task->spheres[thread_idx], true);
+	}
+
+	static void MaxDistanceBatch(void* user_data, u64 begin, u64 end)
+	{
+		SphereTask* task = static_cast<SphereTask*>(user_data);
+		u32 const thread_idx = Jobs::GetThreadIndex();
+
+		Sphere center = task->seed;
+		f32 dist_sq = MaxDistanceSqRange(task->positions, begin, end, &center, false);
+		task->max_dist_sq[thread_idx] = max(task->max_dist_sq[thread_idx], dist_sq);
+	}
+
+	Sphere ComputeBoundingSphere(vec3 const* positions, u64 count)
+	{
+		Sphere result;
+		result.center = vec3(0.0f, 0.0f, 0.0f);
+		result.radius = 0.0f;
+
+		if (count == 0)
+		{
+			return result;
+		}
+
+		bool const b_parallel = count >= PARALLEL_MIN_VERTICES && Jobs::GetThreadCount() > 1;
+
+		SphereTask* task = new SphereTask();
+		ON_SCOPE_EXIT(delete task);
+		task->positions = positions;
+
+		// Seed with the most distant pair of extremal points.
+		Extremes extremes;
+		if (b_parallel)
+		{
+			memzero(task->b_has_partial, sizeof(task->b_has_partial));
+			Jobs::ParallelFor(count, PARALLEL_BATCH_SIZE, &FindExtremesBatch, task);
+
+			extremes = FindExtremesRange(positions, 0, 1);
+			for (u32 i = 0; i < MAX_THREADS; ++i)
+			{
+				if (task->b_has_partial[i])
+				{
+					MergeExtremes(&extremes, task->extremes[i]);
+				}
+			}
+		}
+		else
+		{
+			extremes = FindExtremesRange(positions, 0, count);
+		}
+
+		f32 max_pair_dist_sq = -1.0f;
+		for (u32 d = 0; d < NUM_EPOS_DIRS; ++d)
+		{
+			vec3 a = positions[extremes.min_idx[d]];
+			vec3 b = positions[extremes.max_idx[d]];
+			f32 dist_sq = DistanceSq(a, b);
+			if (dist_sq > max_pair_dist_sq)
+			{
+				max_pair_dist_sq = dist_sq;
+				result.center = vec3((a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f);
+				result.radius = sqrtf(dist_sq) * 0.5f;
+			}
+		}
+
+		// Ritter pass over all vertices.
+		if (b_parallel)
+		{
+			task->seed = result;
+			memzero(task->b_has_partial, sizeof(task->b_has_partial));
+			Jobs::ParallelFor(count, PARALLEL_BATCH_SIZE, &GrowSphereBatch, task);
+
+			for (u32 i = 0; i < MAX_THREADS; ++i)
+			{
+				if (task->b_has_partial[i])
+				{
+					result = Merge(result, task->spheres[i]);
+				}
+			}
+		}
+		else
+		{
+			MaxDistanceSqRange(positions, 0, count, &result, true);
+		}
+
+		// Second candidate: centered on the AABB. Often tighter for boxy meshes.
+		AABB aabb = ComputeAABB(positions, count);
+
+		Sphere aabb_sphere;
+		aabb_sphere.center = vec3(
+			(aabb.min.x + aabb.max.x) * 0.5f,
+			(aabb.min.y + aabb.max.y) * 0.5f,
+			(aabb.min.z + aabb.max.z) * 0.5f);
+		aabb_sphere.radius = 0.0f;
+
+		f32 max_dist_sq = 0.0f;
+		if (b_parallel)
+		{
+			task->seed = aabb_sphere;
+			memzero(task->max_dist_sq, sizeof(task->max_dist_sq));
+			Jobs::ParallelFor(count, PARALLEL_BATCH_SIZE, &MaxDistanceBatch, task);
+
+			for (u32 i = 0; i < MAX_THREADS; ++i)
+			{
+				max_dist_sq = max(max_dist_sq, task->max_dist_sq[i]);
+			}
+		}
+		else
+		{
+			max_dist_sq = MaxDistanceSqRange(positions, 0, count, &aabb_sphere, false);
+		}
+		aabb_sphere.radius = sqrtf(max_dist_sq);
+
+		return aabb_sphere.radius < result.radius ? aabb_sphere : result;
+	}
+
+	Sphere Merge(Sphere const& a, Sphere const& b)
+	{
+		vec3 delta = vec3(b.center.x - a.center.x, b.center.y - a.center.y, b.center.z - a.center.z);
+		f32 dist = sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+
+		if (dist + b.radius <= a.radius)
+		{
+			return a;
+		}
+		if (dist + a.radius <= b.radius)
+		{
+			return b;
+		}
+
+		Sphere result;
+		result.radius = (dist + a.radius + b.radius) * 0.5f;
+
+		f32 shift = (result.radius - a.radius) / dist;
+		result.center = vec3(
+			a.center.x + delta.x * shift,
+			a.center.y + delta.y * shift,
+			a.center.z + delta.z * shift);
+		return result;
+	}
+}
\ No newline at end of file
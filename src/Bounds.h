@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+
+namespace Bounds
+{
+	// Below this many vertices the kernels stay on the calling thread.
+	static constexpr u64 PARALLEL_MIN_VERTICES = 64 * 1024;
+
+	AABB ComputeAABB(vec3 const* positions, u64 count);
+
+	// Picks the tighter of two candidates: an EPOS-14 seeded Ritter sphere,
+	// and the sphere around the AABB center through the farthest vertex.
+	Sphere ComputeBoundingSphere(vec3 const* positions, u64 count);
+
+	AABB Merge(AABB const& a, AABB const& b);
+	Sphere Merge(Sphere const& a, Sphere const& b);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "Bounds.h"
+#include "TestUtils.h"
+
+#include <float.h>
+
+namespace Bounds
+{
+namespace Test
+{
+	static AABB ComputeAABBScalar(vec3 const* positions, u64 count)
+	{
+		AABB aabb;
+		aabb.min = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		aabb.max = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (u64 i = 0; i < count; ++i)
+		{
+			aabb.min = vec3(min(aabb.min.x, positions[i].x), min(aabb.min.y, positions[i].y), min(aabb.min.z, positions[i].z));
+			aabb.max = vec3(max(aabb.max.x, positions[i].x), max(aabb.max.y, positions[i].y), max(aabb.max.z, positions[i].z));
+		}
+		return aabb;
+	}
+
+	static bool SameAABB(AABB const& a, AABB const& b)
+	{
+		return memcmp(&a, &b, sizeof(AABB)) == 0;
+	}
+
+	static bool ContainsAll(Sphere const& sphere, vec3 const* positions, u64 count)
+	{
+		// Ritter moves the center in float, allow for a little rounding.
+		f32 const radius = sphere.radius * (1.0f + 1e-5f) + 1e-6f;
+		for (u64 i = 0; i < count; ++i)
+		{
+			vec3 const d(positions[i].x - sphere.center.x, positions[i].y - sphere.center.y, positions[i].z - sphere.center.z);
+			if (Math::Dot(d, d) > radius * radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void FillRandom(vec3* positions, u64 count, TestUtils::Random& random)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			positions[i] = vec3(random.Float(-10.0f, 30.0f), random.Float(-2.0f, 2.0f), random.Float(-50.0f, 5.0f));
+		}
+	}
+
+	// Every count up to a few blocks, so the padded tail is hit with 1 to 3 vertices.
+	void AABBMatchesScalar()
+	{
+		vec3 positions[19];
+		TestUtils::Random random;
+		FillRandom(positions, 19, random);
+
+		for (u64 count = 1; count <= 19; ++count)
+		{
+			ASSERT(SameAABB(ComputeAABB(positions, count), ComputeAABBScalar(positions, count)));
+		}
+
+		// The extremes in the last vertex, which only the tail sees.
+		positions[18] = vec3(100.0f, -100.0f, 100.0f);
+		ASSERT(SameAABB(ComputeAABB(positions, 19), ComputeAABBScalar(positions, 19)));
+
+		AABB const empty = ComputeAABB(positions, 0);
+		ASSERT(empty.min.x == 0.0f && empty.max.x == 0.0f);
+	}
+
+	// Large enough to be split across the job system.
+	void AABBParallelMatchesScalar()
+	{
+		u64 const count = PARALLEL_MIN_VERTICES * 3 + 7;
+		vec3* positions = new vec3[count];
+		ON_SCOPE_EXIT(delete[] positions);
+
+		TestUtils::Random random;
+		FillRandom(positions, count, random);
+		positions[count / 2] = vec3(-1000.0f, 0.0f, 0.0f);
+		positions[count - 1] = vec3(0.0f, 1000.0f, 0.0f);
+
+		ASSERT(SameAABB(ComputeAABB(positions, count), ComputeAABBScalar(positions, count)));
+	}
+
+	void SphereContainsAllVertices()
+	{
+		vec3 positions[1001];
+		TestUtils::Random random;
+		FillRandom(positions, 1001, random);
+
+		for (u64 count = 1; count <= 9; ++count)
+		{
+			ASSERT(ContainsAll(ComputeBoundingSphere(positions, count), positions, count));
+		}
+
+		Sphere const sphere = ComputeBoundingSphere(positions, 1001);
+		ASSERT(ContainsAll(sphere, positions, 1001));
+
+		// Never looser than the sphere around the AABB center, which is the second candidate.
+		AABB const aabb = ComputeAABBScalar(positions, 1001);
+		vec3 const center((aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f);
+		f32 max_dist_sq = 0.0f;
+		for (u32 i = 0; i < 1001; ++i)
+		{
+			vec3 const d(positions[i].x - center.x, positions[i].y - center.y, positions[i].z - center.z);
+			max_dist_sq = max(max_dist_sq, Math::Dot(d, d));
+		}
+		ASSERT(sphere.radius <= sqrtf(max_dist_sq) * (1.0f + 1e-6f));
+
+		// Two points, the sphere is their midpoint.
+		vec3 const pair[2] = { vec3(-1.0f, 0.0f, 0.0f), vec3(3.0f, 0.0f, 0.0f) };
+		Sphere const pair_sphere = ComputeBoundingSphere(pair, 2);
+		ASSERT(NearlyEqual(pair_sphere.center.x, 1.0f, 1e-6f) && NearlyEqual(pair_sphere.radius, 2.0f, 1e-6f));
+	}
+
+	void SphereParallelContainsAllVertices()
+	{
+		u64 const count = PARALLEL_MIN_VERTICES * 2 + 3;
+		vec3* positions = new vec3[count];
+		ON_SCOPE_EXIT(delete[] positions);
+
+		TestUtils::Random random;
+		FillRandom(positions, count, random);
+		positions[count - 1] = vec3(200.0f, 200.0f, 200.0f);
+
+		ASSERT(ContainsAll(ComputeBoundingSphere(positions, count), positions, count));
+	}
+
+	void MergeSpheres()
+	{
+		Sphere a;
+		a.center = vec3(0.0f, 0.0f, 0.0f);
+		a.radius = 1.0f;
+
+		Sphere b;
+		b.center = vec3(4.0f, 0.0f, 0.0f);
+		b.radius = 1.0f;
+
+		Sphere const merged = Merge(a, b);
+		ASSERT(NearlyEqual(merged.center.x, 2.0f, 1e-6f) && NearlyEqual(merged.radius, 3.0f, 1e-6f));
+
+		// Contained spheres merge into the outer one.
+		Sphere inner;
+		inner.center = vec3(0.5f, 0.0f, 0.0f);
+		inner.radius = 0.25f;
+		ASSERT(Merge(a, inner).radius == a.radius);
+		ASSERT(Merge(inner, a).radius == a.radius);
+	}
+
+	void Run()
+	{
+		AABBMatchesScalar();
+		AABBParallelMatchesScalar();
+		SphereContainsAllVertices();
+		SphereParallelContainsAllVertices();
+		MergeSpheres();
+	}
+}
+}
@@ -1,15 +1,30 @@
 #include "Core.h"
+#ifdef _WIN32
 #include "Win32.h"
+#endif
 #include <time.h>
+#include <wchar.h>
+
+thread_local static char g_debugFmtBuffer[MAX_DEBUG_MSG_SIZE];
+thread_local static char g_debugMsgBuffer[MAX_DEBUG_MSG_SIZE];
 
 int MiniPrintfVA(char* buffer, size_t bufferLen, const char *fmt, bool appendNewline, va_list vl)
 {
+#ifdef _WIN32
 	int lastWritePos = vsnprintf_s(buffer, bufferLen, _TRUNCATE, fmt, vl);
+#else
+	// vsnprintf returns the untruncated length, clamp to match _TRUNCATE.
+	int lastWritePos = vsnprintf(buffer, bufferLen, fmt, vl);
+	if (lastWritePos >= (int)bufferLen)
+	{
+		lastWritePos = -1;
+	}
+#endif
 
 	int const charsNeededForPostFix = appendNewline ? 2 : 1;
-	bool bEnoughSpaceForPostFix = (bufferLen - lastWritePos) >= charsNeededForPostFix;
+	bool bEnoughSpaceForPostFix = (bufferLen - lastWritePos) >= (size_t)charsNeededForPostFix;
 
-	if (lastWritePos < 0 || lastWritePos == bufferLen || !bEnoughSpaceForPostFix)
+	if (lastWritePos < 0 || (size_t)lastWritePos == bufferLen || !bEnoughSpaceForPostFix)
 	{
 		if (appendNewline)
 		{
@@ -56,7 +71,11 @@ void DebugPrintf(char const* file, int line, char const* fmt, Log::Category cate
 	time_t rawtime;
 	time(&rawtime);
 	tm timeinfo;
+#ifdef _WIN32
 	localtime_s(&timeinfo, &rawtime);
+#else
+	localtime_r(&rawtime, &timeinfo);
+#endif
 
 	lastWritePos += strftime(g_debugFmtBuffer + lastWritePos, charsAvailable, "[%T]", &timeinfo);
 	charsAvailable = MAX_DEBUG_MSG_SIZE - lastWritePos;
@@ -70,9 +89,15 @@ void DebugPrintf(char const* file, int line, char const* fmt, Log::Category cate
 	MiniPrintfVA(g_debugMsgBuffer, MAX_DEBUG_MSG_SIZE, fmt, true, vl);
 	va_end(vl);
 
+#ifdef _WIN32
 	strcat_s(g_debugFmtBuffer, charsAvailable, g_debugMsgBuffer);
 
 	OutputDebugString(g_debugFmtBuffer);
+#else
+	strncat(g_debugFmtBuffer, g_debugMsgBuffer, charsAvailable - 1);
+
+	fputs(g_debugFmtBuffer, stderr);
+#endif
 }
 
 void CStrToWChar(char const* src_c_str, wchar_t* dst_w_str, u32 str_len)
@@ -81,6 +106,12 @@ void CStrToWChar(char const* src_c_str, wchar_t* dst_w_str, u32 str_len)
 	mbstate_t state;
 	MemZeroSafe(&state);
 
+#ifdef _WIN32
 	errno_t ret_code = mbsrtowcs_s(&retval, dst_w_str, str_len, &src_c_str, _TRUNCATE, &state);
 	ASSERT(ret_code == 0);
+#else
+	retval = mbsrtowcs(dst_w_str, &src_c_str, str_len - 1, &state);
+	ASSERT(retval != (size_t)-1);
+	dst_w_str[(retval < str_len) ? retval : str_len - 1] = L'\0';
+#endif
 }
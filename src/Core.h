@@ -1,6 +1,9 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -8,6 +11,12 @@
 #include <atomic>
 #include <mutex>
 
+// The engine builds with MSVC only, offline tools (see tools/) with GCC and Clang as well.
+#ifndef _MSC_VER
+#define __forceinline inline __attribute__((always_inline))
+#define _byteswap_uint64 __builtin_bswap64
+#endif
+
 typedef uint8_t   u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -24,8 +33,6 @@ typedef double f64;
 typedef std::atomic<u32> atomic_u32;
 
 static constexpr size_t MAX_DEBUG_MSG_SIZE = 1024;
-thread_local static char g_debugFmtBuffer[MAX_DEBUG_MSG_SIZE];
-thread_local static char g_debugMsgBuffer[MAX_DEBUG_MSG_SIZE];
 
 using ScopedLock = std::lock_guard<std::mutex>;
 
@@ -51,36 +58,36 @@ ScopeExit<Invokable> MakeScopeExit(Invokable to_invoke)
 #define ON_SCOPE_EXIT(code) \
 	auto JOIN_STRING2(scope_exit, __LINE__)  = MakeScopeExit([&]() {code;});
 
-u64 static constexpr PLATFORM_DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+u64 static constexpr PLATFORM_DEFAULT_ALIGNMENT = alignof(max_align_t);
 
 static constexpr u64 Kilobyte(u64 num)
 {
-	return num * 1024i64;
+	return num * 1024ull;
 }
 
 static constexpr u64 Megabyte(u64 num)
 {
-	return num * 1024i64 * 1024i64;
+	return num * 1024ull * 1024ull;
 }
 
 static constexpr u64 Gigabyte(u64 num)
 {
-	return num * 1024i64 * 1024i64 * 1024i64;
+	return num * 1024ull * 1024ull * 1024ull;
 }
 
 static constexpr size_t BytesToKiloBytes(size_t bytes)
 {
-	return bytes / (1024Ui64);
+	return bytes / (1024ull);
 }
 
 static constexpr size_t BytesToMegaBytes(size_t bytes)
 {
-	return bytes / (1024Ui64 * 1024Ui64);
+	return bytes / (1024ull * 1024ull);
 }
 
 static constexpr size_t BytesToGigaBytes(size_t bytes)
 {
-	return bytes / (1024Ui64 * 1024Ui64 * 1024Ui64);
+	return bytes / (1024ull * 1024ull * 1024ull);
 }
 
 template <typename T>
@@ -107,7 +114,7 @@ struct Log
 		EnumFirst = Default,
 	};
 
-	static constexpr char* CategoryStrings[Category::EnumCount] = 
+	static constexpr char const* CategoryStrings[Category::EnumCount] = 
 	{
 		"Default",
 		"ASSERT",
@@ -125,7 +132,7 @@ void DebugPrintf(char const* file, int line, char const* fmt, Log::Category cate
 void CStrToWChar(char const* src_c_str, wchar_t* dst_w_str, u32 str_len);
 
 #ifdef _DEBUG
-#define LOG(category, format, ...) DebugPrintf(__FILE__, __LINE__, format, category, __VA_ARGS__); 
+#define LOG(category, format, ...) DebugPrintf(__FILE__, __LINE__, format, category, ##__VA_ARGS__); 
 #else
 #define LOG(format, ...)
 #endif
@@ -134,9 +141,9 @@ void CStrToWChar(char const* src_c_str, wchar_t* dst_w_str, u32 str_len);
 
 #ifdef _DEBUG
 #define ASSERT(x) assert(x) // TODO(): This should be messagebox so we can actually continue exection
-#define ASSERT_F(x, format, ...) if (!(x)) { LOG(Log::Assert, format, __VA_ARGS__); assert(x); }
+#define ASSERT_F(x, format, ...) if (!(x)) { LOG(Log::Assert, format, ##__VA_ARGS__); assert(x); }
 #define ASSERT_FAIL() assert(false)
-#define ASSERT_FAIL_F(format, ...) ASSERT_F(false, format, __VA_ARGS__)
+#define ASSERT_FAIL_F(format, ...) ASSERT_F(false, format, ##__VA_ARGS__)
 #define DEBUG_CODE(x) x
 #else
 #define ASSERT(x) 
@@ -156,7 +163,11 @@ void CStrToWChar(char const* src_c_str, wchar_t* dst_w_str, u32 str_len);
 	#define VERIFY(x) x		
 #endif
 
+#ifdef _MSC_VER
 #define ARRAY_SIZE(x) _countof(x)
+#else
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+#endif
 
 template <class T>
 static T max(const T& a, const T& b)
@@ -176,7 +187,7 @@ static T Clamp(const T& x, const T& low, const T& high)
 	return x < low ? low : (x > high ? high : x);
 }
 
-static bool NearlyEqual(f32 a, f32 b, f32 epsilon = /* 0.00001 */ 0.000000001)
+inline bool NearlyEqual(f32 a, f32 b, f32 epsilon = /* 0.00001 */ 0.000000001)
 {
 	return fabs(a - b) <= epsilon;
 }
@@ -1,26 +1,42 @@
 #include "FrameTimer.h"
+
+#ifdef _WIN32
 #include "Win32.h"
+#else
+#include <time.h>
+#endif
 
 FrameTimer::FrameTimer()
 	: m_startedTime(0)
-	, m_lastTickTime(0)
+	, m_timeSpentPaused(0)
 	, m_lastStopTime(0)
+	, m_lastTickTime(0)
 	, m_deltaTime(0.0)
 	, m_secondsPerClock(0.0)
 	, m_bIsStopped(false)
 {
 
+#ifdef _WIN32
 	u64 secondsPerClock;
 	QueryPerformanceFrequency((LARGE_INTEGER*)&secondsPerClock);
+#else
+	u64 secondsPerClock = 1000000000ull;
+#endif
 
 	m_secondsPerClock = 1.0 / secondsPerClock;
 }
 
 static u64 QueryHWTimer()
 {
+#ifdef _WIN32
 	u64 time;
 	QueryPerformanceCounter((LARGE_INTEGER*)&time);
 	return time;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (u64)time.tv_sec * 1000000000ull + (u64)time.tv_nsec;
+#endif
 }
 
 void ResetTimer(FrameTimer& timer)
@@ -1,12 +1,43 @@
 #pragma once
 #include "Core.h"
+#include "Animation.h"
+#include "Array.h"
+#include "Base64.h"
+#include "BlockCompression.h"
+#include "Bounds.h"
+#include "FrameTimer.h"
+#include "ImageDecode.h"
+#include "IO.h"
+#include "Jobs.h"
+#include "Json.h"
 #include "Memory.h"
+#include "MeshImport.h"
+#include "Meshlets.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "MipGeneration.h"
+#include "SceneGraph.h"
+#include "StreamCopy.h"
+#include "TangentSpace.h"
+#include "VertexQuantization.h"
 
+#ifdef _WIN32
 #include <io.h>
+#endif
+
+// cgltf counts and builds its jsmn tokens with the SIMD tokenizer, see Json.h.
+#define CGLTF_JSON_PARSE(parser, json, length, tokens, num_tokens) \
+	Json::Tokenize(json, length, reinterpret_cast<Json::Token*>(tokens), num_tokens)
 
 #define CGLTF_IMPLEMENTATION
 #include "external/cgltf/cgltf.h"
 
+static_assert(sizeof(jsmntok_t) == sizeof(Json::Token) && offsetof(jsmntok_t, parent) == offsetof(Json::Token, parent),
+	"Json::Token has to match cgltf's jsmn tokens!");
+static_assert((s32)JSMN_OBJECT == (s32)Json::TokenType::Object && (s32)JSMN_ARRAY == (s32)Json::TokenType::Array &&
+	(s32)JSMN_STRING == (s32)Json::TokenType::String && (s32)JSMN_PRIMITIVE == (s32)Json::TokenType::Primitive,
+	"Json::TokenType has to match jsmntype_t!");
+
 /*
 GLTF Notes:
 	-) Right handed coordinates:. Front of asset faces +z.
@@ -16,10 +47,18 @@ GLTF Notes:
 
 	 -) Distances in m. Angles in rad. Positive rotation is CCW
 
+	 -) .glb files hold the json and one binary chunk. cgltf_parse_file()
+	    points data->bin into the mapped file, buffer 0 reads from there
+	    without any copies.
+
 	 -) If vertex data is interleaved, accessor has a non-zero byte
 	    offset which locates the first relevant element in the buffer.
 		The bufferview will have a non-zero stride, which defines the
 		element step through the buffer.
+
+	 -) Skinned meshes ignore the transform of their node, the joints
+	    place them in world space. Skinning::ComputeJointMatrices() can
+	    make them relative to the node again.
 */
 
 namespace Mini
@@ -29,57 +68,142 @@ namespace Mini
 		char const* file_path;
 		Memory::Arena* scratch_memory;
 		Memory::Arena* mesh_memory;
+		Memory::Arena* scene_memory; // Node hierarchy, leave null to skip it.
+		Memory::Arena* texture_memory = nullptr; // Decoded material textures, leave null to skip them.
+		u32 flags;
+
+		// BC7 search effort with ImportFlags::CompressTextures. Fast picks BC1 or BC3 for color textures instead.
+		BlockCompression::Quality::Enum texture_quality = BlockCompression::Quality::Normal;
+
+		// Downsampling filter with ImportFlags::GenerateMips.
+		MipGeneration::Filter::Enum mip_filter = MipGeneration::Filter::Kaiser;
+
+		// Error bounds of the animation key removal.
+		Animation::Tolerances animation_tolerances;
+
+		// Set when mesh and scene memory are shared with imports on other threads, see BatchImport.
+		std::mutex* shared_memory_lock = nullptr;
 	};
 
-	static u8* ReadFileBuffer(char const* file_path, Memory::Arena* buffer_allocator, u64* bytes_read)
+	// Pushes to mesh and scene memory are serialized when those are shared, the memory
+	// itself is filled outside of the lock.
+	static void* PushShared(SceneImporter const* importer, Memory::Arena* arena, u64 size_bytes,
+		Memory::PushParams push_params = Memory::DefaultPushParams())
 	{
-		*bytes_read = 0;
-
-		HANDLE fstream = CreateFile(file_path, GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-		if (fstream == INVALID_HANDLE_VALUE)
+		if (importer->shared_memory_lock == nullptr)
 		{
-			ASSERT("Failed to open file %s!");
-			return nullptr;
+			return Memory::PushSize(arena, size_bytes, push_params);
 		}
 
-		ON_SCOPE_EXIT(CloseHandle(fstream));
+		ScopedLock lock(*importer->shared_memory_lock);
+		return Memory::PushSize(arena, size_bytes, push_params);
+	}
+
+	template <typename T>
+	static T* PushSharedType(SceneImporter const* importer, Memory::Arena* arena, u32 count,
+		Memory::PushParams push_params = Memory::DefaultPushParams())
+	{
+		return static_cast<T*>(PushShared(importer, arena, sizeof(T) * count, push_params));
+	}
+
+	// Every file cgltf asks for (the .gltf itself and external buffers) is mapped instead
+	// of read into memory, so accessor copies read straight from the mapped pages.
+	struct MappedFiles
+	{
+		Array<IO::MappedFile, 32> files;
+	};
+
+	static cgltf_result MapFileForCgltf(cgltf_memory_options const* memory_options, cgltf_file_options const* file_options,
+		char const* path, cgltf_size* size, void** data)
+	{
+		// Mapping doesn't allocate, cgltf's allocator isn't needed.
+		UNUSED(memory_options);
+
+		MappedFiles* mapped = static_cast<MappedFiles*>(file_options->user_data);
 
-		LARGE_INTEGER file_size_out;
-		if (!GetFileSizeEx(fstream, &file_size_out))
+		IO::MappedFile file;
+		if (!IO::MapFile(path, &file))
 		{
-			LogLastWindowsError();
-			ASSERT("Failed to get file size!");
-			return nullptr;
+			return cgltf_result_file_not_found;
 		}
 
-		u64 stream_len = file_size_out.QuadPart;
-		if (stream_len == 0)
+		IO::MappedFile* slot = mapped->files.TryPushBack();
+		if (slot == nullptr)
 		{
-			ASSERT("File stream is empty!");
-			return nullptr;
+			ASSERT_FAIL_F("Too many files mapped for a single import!");
+			IO::UnmapFile(&file);
+			return cgltf_result_out_of_memory;
 		}
+		*slot = file;
+
+		// NOTE(): cgltf wants a mutable pointer, but never writes to file data.
+		*size = file.size;
+		*data = const_cast<u8*>(file.data);
+		return cgltf_result_success;
+	}
 
-		u8* file_data = (u8*)Memory::PushSize(buffer_allocator, stream_len, Memory::ZeroPush());
+	static void ReleaseFileForCgltf(cgltf_memory_options const* memory_options, cgltf_file_options const* file_options, void* data)
+	{
+		UNUSED(memory_options);
+
+		MappedFiles* mapped = static_cast<MappedFiles*>(file_options->user_data);
 
-		DWORD num_bytes_read = 0;
-		if (!ReadFile(fstream, file_data, stream_len, &num_bytes_read, nullptr))
+		// Buffers decoded from data uris are released through here as well, those live in the arena.
+		for (u32 i = 0; i < mapped->files.Size(); ++i)
 		{
-			LogLastWindowsError();
-			ASSERT_FAIL_F("Failed to read file from stream!");
-			return nullptr;
+			if (mapped->files[i].data == data)
+			{
+				IO::UnmapFile(&mapped->files[i]);
+				mapped->files[i] = mapped->files[mapped->files.Size() - 1];
+				mapped->files.PopBack();
+				return;
+			}
 		}
+	}
 
-		if (num_bytes_read != stream_len)
+	static void UnmapAllFiles(MappedFiles* mapped)
+	{
+		for (u32 i = 0; i < mapped->files.Size(); ++i)
 		{
-			ASSERT_FAIL_F("Did not read the expected number of bytes from stream!");
-			return nullptr;
+			IO::UnmapFile(&mapped->files[i]);
+		}
+		mapped->files.Clear();
+	}
+
+	// Embedded buffers ("data:...;base64,...") are decoded here instead of by cgltf_load_buffers(),
+	// which decodes them one character at a time. Like everything else cgltf allocates, the
+	// decoded data lives in scratch memory.
+	static cgltf_result DecodeDataUris(cgltf_data* scene_data, Memory::Arena* scratch_memory)
+	{
+		for (u64 buffer_idx = 0; buffer_idx < scene_data->buffers_count; ++buffer_idx)
+		{
+			cgltf_buffer* buffer = &scene_data->buffers[buffer_idx];
+			char const* uri = buffer->uri;
+			if (buffer->data != nullptr || buffer->size == 0 || uri == nullptr || strncmp(uri, "data:", 5) != 0)
+			{
+				continue;
+			}
+
+			// Anything but base64 is left to cgltf_load_buffers() to reject.
+			char const* comma = strchr(uri, ',');
+			if (comma == nullptr || comma - uri < 7 || strncmp(comma - 7, ";base64", 7) != 0)
+			{
+				continue;
+			}
+
+			char const* base64 = comma + 1;
+			u8* data = Memory::PushType<u8>(scratch_memory, buffer->size);
+			if (!Base64::Decode(data, buffer->size, base64, strlen(base64)))
+			{
+				return cgltf_result_io_error;
+			}
+			buffer->data = data;
 		}
 
-		*bytes_read = stream_len;
-		return file_data;
+		return cgltf_result_success;
 	}
 
-	static u64 CalculateTotalBufferSize(cgltf_accessor* accessor)
+	static u64 CalculateElementSize(cgltf_accessor const* accessor)
 	{
 		u16 num_components = 0;
 		switch (accessor->type)
@@ -129,12 +253,35 @@ namespace Mini
 			break;
 		}
 
-		u64 total_buffer_size = num_components * component_size * accessor->count;
-		return total_buffer_size;
+		return num_components * component_size;
+	}
+
+	static StreamCopy::ComponentType::Enum GetComponentType(cgltf_component_type component_type)
+	{
+		switch (component_type)
+		{
+		case cgltf_component_type_r_8:   return StreamCopy::ComponentType::S8;
+		case cgltf_component_type_r_8u:  return StreamCopy::ComponentType::U8;
+		case cgltf_component_type_r_16:  return StreamCopy::ComponentType::S16;
+		case cgltf_component_type_r_16u: return StreamCopy::ComponentType::U16;
+		case cgltf_component_type_r_32u: return StreamCopy::ComponentType::U32;
+		case cgltf_component_type_r_32f: return StreamCopy::ComponentType::F32;
+		case cgltf_component_type_invalid:
+		default:
+			ASSERT_FAIL();
+			return StreamCopy::ComponentType::F32;
+		}
 	}
 
-	
-	static void CopyBuffer(u8* dst, u64 dst_size, cgltf_type dst_type, cgltf_component_type dst_component, cgltf_accessor* accessor)
+	// Components to negate for the change of basis, one bit per component. The z axis is mirrored, which
+	// flips the handedness of tangents as well.
+	static constexpr u32 BASIS_CHANGE_MASK = 1u << 2;
+	static constexpr u32 TANGENT_BASIS_CHANGE_MASK = (1u << 2) | (1u << 3);
+
+	// With src_elements, only the listed elements are copied, in that order. Components convert to dst_component
+	// (normalized integers to [0, 1] or [-1, 1]), and the ones in negate_mask change sign, all in one pass.
+	static void CopyBuffer(u8* dst, u64 dst_size, cgltf_type dst_type, cgltf_component_type dst_component, cgltf_accessor* accessor,
+		u32 const* src_elements = nullptr, u64 num_src_elements = 0, u32 negate_mask = 0)
 	{
 		if (dst_type != accessor->type)
 		{
@@ -142,200 +289,2883 @@ namespace Mini
 			return;
 		}
 
-		if (dst_component != accessor->component_type)
+		StreamCopy::ComponentType::Enum const src_format = GetComponentType(accessor->component_type);
+		StreamCopy::ComponentType::Enum const dst_format = GetComponentType(dst_component);
+		u32 const num_components = (u32)cgltf_num_components(accessor->type);
+
+		u64 const element_size = CalculateElementSize(accessor);
+		u64 const dst_element_size = (u64)StreamCopy::GetComponentSize(dst_format) * num_components;
+		u64 const count = src_elements ? num_src_elements : accessor->count;
+		if (dst_size < dst_element_size * count)
 		{
-			// NOTE(): Easy to implement, just dont need to atm.
-			ASSERT_FAIL_F("Mismatching component type copy not implemented atm!");
+			ASSERT_FAIL_F("Did not pre-allocate enough space for buffer!");
+			return;
 		}
 
-		u64 src_size = accessor->buffer_view->size;
-		ASSERT(src_size == CalculateTotalBufferSize(accessor));
-		if (dst_size < src_size)
+		// cgltf resolves the stride to the element size for tightly packed views.
+		u8 const* src = (u8 const*)accessor->buffer_view->buffer->data;
+		src += accessor->buffer_view->offset + accessor->offset;
+
+		if (src_format == dst_format && negate_mask == 0)
 		{
-			ASSERT_FAIL_F("Did not pre-allocate enough space for buffer!");
+			if (src_elements != nullptr)
+			{
+				StreamCopy::Gather(dst, src, src_elements, count, (u32)element_size, (u32)accessor->stride);
+				return;
+			}
+
+			StreamCopy::Deinterleave(dst, src, count, (u32)element_size, (u32)accessor->stride);
+			return;
+		}
+
+		ASSERT_F(num_components <= 4, "Only scalars and vectors can be converted!");
+		if (dst_format == StreamCopy::ComponentType::F32)
+		{
+			StreamCopy::ReadComponents((f32*)dst, src, src_elements, count, num_components, src_format, accessor->normalized,
+				(u32)accessor->stride, negate_mask);
 			return;
 		}
 
-		u8* src = (u8*)accessor->buffer_view->buffer->data;
-		src += accessor->buffer_view->offset;
+		// Integer destinations keep the integer values, through a small float buffer.
+		static constexpr u32 CONVERT_BATCH = 256;
+		f32 values[CONVERT_BATCH * 4];
+		for (u64 first = 0; first < count; first += CONVERT_BATCH)
+		{
+			u64 const batch = min<u64>(count - first, CONVERT_BATCH);
+			if (src_elements != nullptr)
+			{
+				StreamCopy::ReadComponents(values, src, src_elements + first, batch, num_components, src_format, false,
+					(u32)accessor->stride, negate_mask);
+			}
+			else
+			{
+				StreamCopy::ReadComponents(values, src + first * accessor->stride, nullptr, batch, num_components, src_format, false,
+					(u32)accessor->stride, negate_mask);
+			}
 
-		memcpy_s(dst, dst_size, src, src_size);
+			StreamCopy::WriteComponents(dst + first * dst_element_size, values, batch, num_components, dst_format, false,
+				(u32)dst_element_size, 0);
+		}
 	}
 
-	struct MeshImport
+	// Not used by the importer itself, see tools/GltfOptimize.cpp.
+	inline void InvertZ(vec3* vertices, u64 const count)
 	{
-		u16* index_buffer;
-		u32 num_indices;
+		for (u64 i = 0; i < count; ++i)
+		{
+			vertices[i].z = -vertices[i].z;
+		}
+	}
 
-		u32 num_vertices;
+	// Same as InvertZ, for vec3s that are interleaved with other data.
+	static void InvertZStrided(u8* vertices, u64 const count, u32 const stride)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			f32* v = reinterpret_cast<f32*>(vertices + i * stride);
+			v[2] = -v[2];
+		}
+	}
 
-		vec3* position_buffer;
-		vec3* normal_buffer;
-		vec2* texcoord_buffer;
-	};
+	// Tangents are mirrored along with the positions, which flips their handedness as well. For vec4s
+	// that are interleaved with other data.
+	static void ChangeTangentBasisStrided(u8* tangents, u64 const count, u32 const stride)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			f32* t = reinterpret_cast<f32*>(tangents + i * stride);
+			t[2] = -t[2];
+			t[3] = -t[3];
+		}
+	}
 
-	static void FlipTriangleWinding(Gfx::Index_t* vertices, u64 const count)
+	// Encodes the full precision streams into mesh memory, the source streams are expected
+	// to live in scratch memory since they are dropped afterwards.
+	static void CompressVertexStreams(MeshImport* imported, SceneImporter const* importer)
 	{
-		ASSERT(count % 3 == 0);
+		u32 const count = imported->num_vertices;
+		Memory::Arena* mesh_memory = importer->mesh_memory;
+
+		imported->compressed_position_buffer = PushSharedType<Gfx::CompressedPosition_t>(importer, mesh_memory, count);
+		Quantize::QuantizePositions(imported->position_buffer, imported->compressed_position_buffer, count, imported->bounds);
+		imported->position_buffer = nullptr;
+
+		if (imported->normal_buffer)
+		{
+			imported->compressed_normal_buffer = PushSharedType<Gfx::CompressedNormal_t>(importer, mesh_memory, count);
+			Quantize::EncodeOctahedral(imported->normal_buffer, imported->compressed_normal_buffer, count);
+			imported->normal_buffer = nullptr;
+		}
+
+		if (imported->texcoord_buffer)
+		{
+			imported->compressed_texcoord_buffer = PushSharedType<Gfx::CompressedTexCoord_t>(importer, mesh_memory, count);
+			Quantize::FloatToHalf(imported->texcoord_buffer->data, &imported->compressed_texcoord_buffer->x, count * 2);
+			imported->texcoord_buffer = nullptr;
+		}
 
-		u64 last_tri = count - 3;
-		for (u64 i = 0; i <= last_tri; i += 3)
+		if (imported->tangent_buffer)
 		{
-			Gfx::Index_t temp = vertices[i + 1];
-			vertices[i + 1] = vertices[i + 2];
-			vertices[i + 2] = temp;
+			imported->compressed_tangent_buffer = PushSharedType<Gfx::CompressedTangent_t>(importer, mesh_memory, count);
+			Quantize::EncodeSnorm8(imported->tangent_buffer, imported->compressed_tangent_buffer, count);
+			imported->tangent_buffer = nullptr;
 		}
 	}
 
-	static void InvertZ(vec3* vertices, u64 const count)
+	// Same change of basis as BASIS_CHANGE_MASK, applied to a local transform: B * T * R * S * B.
+	static Scene::Transform ChangeBasis(Scene::Transform const& transform)
 	{
-		for (u64 i = 0; i < count; ++i)
+		Scene::Transform result = transform;
+		result.translation.z = -transform.translation.z;
+		result.rotation.x = -transform.rotation.x;
+		result.rotation.y = -transform.rotation.y;
+		return result;
+	}
+
+	// Same change of basis for an affine matrix, B * M * B negates the third row and column except for their crossing.
+	static mat34 ChangeBasis(mat34 const& mat)
+	{
+		mat34 result = mat;
+		result(0, 2) = -mat(0, 2);
+		result(1, 2) = -mat(1, 2);
+		result(2, 0) = -mat(2, 0);
+		result(2, 1) = -mat(2, 1);
+		result(2, 3) = -mat(2, 3);
+		return result;
+	}
+
+	static Scene::Transform ReadLocalTransform(cgltf_node const* node)
+	{
+		Scene::Transform local = Scene::IdentityTransform();
+
+		if (node->has_matrix)
 		{
-			vertices[i].z = -vertices[i].z;
+			mat44 mat;
+			memcpy(mat.data, node->matrix, sizeof(mat.data));
+			return ChangeBasis(Scene::DecomposeTransform(mat));
+		}
+
+		if (node->has_translation)
+		{
+			local.translation = vec3(node->translation[0], node->translation[1], node->translation[2]);
+		}
+		if (node->has_rotation)
+		{
+			local.rotation = quat(node->rotation[0], node->rotation[1], node->rotation[2], node->rotation[3]);
+		}
+		if (node->has_scale)
+		{
+			local.scale = vec3(node->scale[0], node->scale[1], node->scale[2]);
 		}
+
+		return ChangeBasis(local);
 	}
 
-	static void ChangeBasis(vec3* vertices, u64 const count)
+	// Node 0 of the hierarchy is an extra scene root that all root nodes of the file
+	// are parented to, so the whole scene can be placed with a single transform.
+	// out_node_remap receives the hierarchy index of every cgltf node.
+	static void ImportHierarchy(cgltf_data const* scene_data, Memory::Arena* scene_memory, Memory::Arena* scratch_memory,
+		Scene::Hierarchy* out_hierarchy, u32* out_node_remap)
 	{
-		mat44 basis_change = mat44::Identity();
-		basis_change(2, 2) = -1.0f;
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
 
-		for (u64 i = 0; i < count; ++i)
+		u32 const num_nodes = (u32)scene_data->nodes_count + 1;
+		u32* parents = Memory::PushType<u32>(scratch_memory, num_nodes);
+		Scene::Transform* locals = Memory::PushType<Scene::Transform>(scratch_memory, num_nodes);
+		u32* remap = Memory::PushType<u32>(scratch_memory, num_nodes);
+
+		parents[0] = Scene::INVALID_NODE;
+		locals[0] = Scene::IdentityTransform();
+
+		for (u64 node_idx = 0; node_idx < scene_data->nodes_count; ++node_idx)
+		{
+			cgltf_node const* node = &scene_data->nodes[node_idx];
+			parents[node_idx + 1] = node->parent ? (u32)(node->parent - scene_data->nodes) + 1 : 0;
+			locals[node_idx + 1] = ReadLocalTransform(node);
+		}
+
+		Scene::BuildHierarchy(out_hierarchy, scene_memory, parents, locals, num_nodes, remap);
+
+		for (u64 node_idx = 0; node_idx < scene_data->nodes_count; ++node_idx)
 		{
-			vec4 v = vertices[i];
-			v.w = 1.0f;
-			vertices[i] = Math::Mul(basis_change, v).xyz;
+			out_node_remap[node_idx] = remap[node_idx + 1];
 		}
 	}
 
-	static MeshImport Import(SceneImporter* importer)
+	static cgltf_accessor* FindAttribute(cgltf_primitive const* prim, cgltf_attribute_type type)
 	{
-		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(importer->scratch_memory);
-		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(importer->scratch_memory, alloc, false));
-		
-		MeshImport imported;
-		MemZeroSafe(imported);
-
-		u64 stream_len;
-		u8* file_data = ReadFileBuffer(importer->file_path, importer->scratch_memory, &stream_len);
-		if (file_data == nullptr)
+		for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
 		{
-			return imported;
+			cgltf_attribute const* attrib = &prim->attributes[attrib_idx];
+			if (attrib->type == type && attrib->index == 0)
+			{
+				return attrib->data;
+			}
 		}
 
-		cgltf_options options;
-		MemZeroSafe(options);
+		return nullptr;
+	}
 
-		struct Local
+	// Points, lines and primitives without positions are skipped.
+	static bool IsImportable(cgltf_primitive const* prim)
+	{
+		cgltf_accessor const* positions = FindAttribute(prim, cgltf_attribute_type_position);
+		return prim->type == cgltf_primitive_type_triangles && positions != nullptr && positions->count > 0 &&
+			(prim->indices == nullptr || prim->indices->count > 0);
+	}
+
+	// Only the first set of joints and weights is imported, Gfx::Joints_t has room for 4.
+	static bool IsSkinned(cgltf_primitive const* prim)
+	{
+		return FindAttribute(prim, cgltf_attribute_type_joints) != nullptr && FindAttribute(prim, cgltf_attribute_type_weights) != nullptr;
+	}
+
+	static cgltf_accessor* FindTargetAttribute(cgltf_morph_target const* target, cgltf_attribute_type type)
+	{
+		for (u64 attrib_idx = 0; attrib_idx < target->attributes_count; ++attrib_idx)
 		{
-			static void* AllocFromArena(void* user, u64 size)
+			cgltf_attribute const* attrib = &target->attributes[attrib_idx];
+			if (attrib->type == type && attrib->index == 0)
 			{
-				Memory::Arena* arena = static_cast<Memory::Arena*>(user);
-				return Memory::PushSize(arena, size);
+				return attrib->data;
 			}
+		}
 
-			static void FreeFromArena(void* user, void* data) 
-			{ 
-				/* NO-OP */ 
-			};
-		};
+		return nullptr;
+	}
 
-		options.memory.alloc = &Local::AllocFromArena;
-		options.memory.free = &Local::FreeFromArena;
-		options.memory.user_data = importer->scratch_memory;
+	// Position and normal deltas are imported, see Morph.h. Unpacked to floats, target accessors are often sparse.
+	static bool ReadTargetDeltas(f32* out_values, cgltf_morph_target const* target, cgltf_attribute_type type, u32 num_vertices)
+	{
+		cgltf_accessor const* accessor = FindTargetAttribute(target, type);
+		if (accessor == nullptr || accessor->type != cgltf_type_vec3 || accessor->count != num_vertices)
+		{
+			return false;
+		}
 
-		cgltf_data* scene_data;
-		cgltf_result result = cgltf_parse(&options, file_data, stream_len, &scene_data);
-		ASSERT(result == cgltf_result_success);
+		return cgltf_accessor_unpack_floats(accessor, out_values, (u64)num_vertices * 3) == (u64)num_vertices * 3;
+	}
 
-		cgltf_result buffer_result = cgltf_load_buffers(&options, scene_data, importer->file_path);
-		ASSERT(buffer_result == cgltf_result_success);
+	// One hash per vertex over the imported deltas of every target, welded vertices have to morph alike as well.
+	static u64* HashTargetDeltas(cgltf_primitive const* prim, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		u64* hashes = Memory::PushType<u64>(scratch_memory, num_vertices);
+		for (u32 i = 0; i < num_vertices; ++i)
+		{
+			hashes[i] = 14695981039346656037ull;
+		}
 
-		ASSERT(scene_data->scene->nodes_count == 1);
-		cgltf_node* root_node = scene_data->scene->nodes[0];
-		cgltf_mesh* mesh = root_node->mesh;
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
 
-		ASSERT(mesh->primitives_count == 1);
-		cgltf_primitive* prim = &mesh->primitives[0];
-		cgltf_accessor* indices = prim->indices; 
-	
+		cgltf_attribute_type const types[] = { cgltf_attribute_type_position, cgltf_attribute_type_normal };
+		f32* deltas = Memory::PushType<f32>(scratch_memory, num_vertices * 3);
+		for (u64 target_idx = 0; target_idx < prim->targets_count; ++target_idx)
+		{
+			for (cgltf_attribute_type type : types)
+			{
+				if (!ReadTargetDeltas(deltas, &prim->targets[target_idx], type, num_vertices))
+				{
+					continue;
+				}
 
-		Memory::Arena* mesh_memory = importer->mesh_memory;
+				// FNV-1a over the bits of the components.
+				u32 const* bits = reinterpret_cast<u32 const*>(deltas);
+				for (u32 i = 0; i < num_vertices; ++i)
+				{
+					u64 hash = hashes[i];
+					for (u32 c = 0; c < 3; ++c)
+					{
+						hash = (hash ^ bits[i * 3 + c]) * 1099511628211ull;
+					}
+					hashes[i] = hash;
+				}
+			}
+		}
 
-		imported.num_indices = indices->count;
-		imported.index_buffer = Memory::PushType<Gfx::Index_t>(mesh_memory, indices->count);
-		CopyBuffer((u8*)imported.index_buffer, sizeof(Gfx::Index_t) * indices->count, cgltf_type_scalar, cgltf_component_type_r_16u, indices);
-		
-		FlipTriangleWinding(imported.index_buffer, indices->count);
+		return hashes;
+	}
 
-		for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
+	// Reads 8, 16 or 32 bit indices, or generates them for non-indexed primitives.
+	static void ReadIndices(cgltf_primitive const* prim, u32* dst, u32 num_indices)
+	{
+		cgltf_accessor const* accessor = prim->indices;
+		if (accessor == nullptr)
 		{
-			cgltf_attribute* attrib = &prim->attributes[attrib_idx];
-			cgltf_accessor* access = attrib->data;
+			for (u32 i = 0; i < num_indices; ++i)
+			{
+				dst[i] = i;
+			}
+			return;
+		}
+
+		u8 const* src = (u8 const*)accessor->buffer_view->buffer->data;
+		src += accessor->buffer_view->offset + accessor->offset;
+		u64 const stride = accessor->stride;
 
-			ASSERT_F(access->offset == 0 && access->buffer_view->stride == 0,
-				"Mesh contains interleaved vertex buffer, this is not currently supported!");
-			
-			switch (attrib->type)
+		switch (accessor->component_type)
+		{
+		case cgltf_component_type_r_8u:
+			for (u32 i = 0; i < num_indices; ++i)
 			{
-				case cgltf_attribute_type_position:
-				{
-					imported.num_vertices = access->count;
+				dst[i] = src[i * stride];
+			}
+			break;
+		case cgltf_component_type_r_16u:
+			for (u32 i = 0; i < num_indices; ++i)
+			{
+				u16 index;
+				memcpy(&index, src + i * stride, sizeof(index));
+				dst[i] = index;
+			}
+			break;
+		case cgltf_component_type_r_32u:
+			StreamCopy::Deinterleave(dst, src, num_indices, sizeof(u32), (u32)stride);
+			break;
+		default:
+			ASSERT_FAIL_F("Indices have to be unsigned integers!");
+			memset(dst, 0, sizeof(u32) * num_indices);
+			break;
+		}
+	}
 
-					u64 bytes_to_alloc = sizeof(Gfx::Position_t) * access->count;
-					u64 alignment = alignof(Gfx::Position_t);
+	// Vertices and indices of a primitive as they are imported. Each chunk becomes a submesh,
+	// and uses chunk_vertices[first_vertex...] of the source vertices.
+	struct PrimitiveLayout
+	{
+		MeshOpt::IndexChunk* chunks;
+		u32 num_chunks;
 
-					void* attrib_buffer = Memory::PushSize(mesh_memory, bytes_to_alloc, Memory::AlignPush(alignment));
-					CopyBuffer((u8*)attrib_buffer, bytes_to_alloc, cgltf_type_vec3, cgltf_component_type_r_32f, access);
-					
-					imported.position_buffer = (Gfx::Position_t*)attrib_buffer;
-					ChangeBasis(imported.position_buffer, access->count);
-					
-					break;
-				}
-				case cgltf_attribute_type_normal:
-				{
-					imported.num_vertices = access->count;
+		u32* chunk_vertices;
+		Gfx::Index_t* chunk_indices; // Chunk relative, in glTF winding. Flipped when copied to the index buffer.
+
+		// Generated per source vertex, before the change of basis. Null when the primitive has them, or they are not requested.
+		vec3* normals;
+		vec4* tangents;
+	};
 
-					u64 bytes_to_alloc = sizeof(Gfx::Normal_t) * access->count;
-					u64 alignment = alignof(Gfx::Normal_t);
+	// Generates the requested normals and tangents of a primitive from its (welded) source indices. Runs on the
+	// whole primitive before it is split, so the chunks don't get seams.
+	static void GenerateTangentSpace(cgltf_primitive const* prim, u32 const* indices, u32 num_indices, PrimitiveLayout* layout,
+		Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
 
-					void* attrib_buffer = Memory::PushSize(mesh_memory, bytes_to_alloc, Memory::AlignPush(alignment));
-					CopyBuffer((u8*)attrib_buffer, bytes_to_alloc, cgltf_type_vec3, cgltf_component_type_r_32f, access);
+		cgltf_accessor* position_accessor = FindAttribute(prim, cgltf_attribute_type_position);
+		u32 const num_vertices = (u32)position_accessor->count;
 
-					imported.normal_buffer = (Gfx::Normal_t*)attrib_buffer;
-					ChangeBasis(imported.normal_buffer, access->count);
+		vec3* positions = Memory::PushType<vec3>(scratch_memory, num_vertices);
+		CopyBuffer((u8*)positions, sizeof(vec3) * num_vertices, cgltf_type_vec3, cgltf_component_type_r_32f, position_accessor);
 
-					break;
-				}
-				case cgltf_attribute_type_texcoord:
-				{
-					imported.num_vertices = access->count;
+		vec3* normals = layout->normals;
+		if (normals != nullptr)
+		{
+			TangentSpace::GenerateNormals(normals, indices, num_indices, positions, num_vertices, scratch_memory);
+		}
+		else if (layout->tangents != nullptr)
+		{
+			cgltf_accessor* normal_accessor = FindAttribute(prim, cgltf_attribute_type_normal);
+			ASSERT(normal_accessor->count == num_vertices);
+			normals = Memory::PushType<vec3>(scratch_memory, num_vertices);
+			CopyBuffer((u8*)normals, sizeof(vec3) * num_vertices, cgltf_type_vec3, cgltf_component_type_r_32f, normal_accessor);
+		}
 
-					u64 bytes_to_alloc = sizeof(Gfx::TexCoord_t) * access->count;
-					u64 alignment = alignof(Gfx::TexCoord_t);
+		if (layout->tangents != nullptr)
+		{
+			cgltf_accessor* texcoord_accessor = FindAttribute(prim, cgltf_attribute_type_texcoord);
+			ASSERT(texcoord_accessor->count == num_vertices);
+			vec2* texcoords = Memory::PushType<vec2>(scratch_memory, num_vertices);
+			CopyBuffer((u8*)texcoords, sizeof(vec2) * num_vertices, cgltf_type_vec2, cgltf_component_type_r_32f, texcoord_accessor);
 
-					void* attrib_buffer = Memory::PushSize(mesh_memory, bytes_to_alloc, Memory::AlignPush(alignment));
-					CopyBuffer((u8*)attrib_buffer, bytes_to_alloc, cgltf_type_vec2, cgltf_component_type_r_32f, access);
+			TangentSpace::GenerateTangents(layout->tangents, indices, num_indices, positions, normals, texcoords, num_vertices, scratch_memory);
+		}
+	}
 
-					imported.texcoord_buffer = (Gfx::TexCoord_t*)attrib_buffer;
-					break;
-				}
-				default:
-					ASSERT_FAIL_F("Unsupported vertex attribute!");
-					break;
+	// Welds the primitive's vertices if requested, generates missing normals and tangents, and splits it
+	// into chunks that 16 bit indices can address.
+	static void PreparePrimitive(cgltf_primitive const* prim, u32 flags, PrimitiveLayout* out_layout, Memory::Arena* scratch_memory)
+	{
+		u32 const num_vertices = (u32)FindAttribute(prim, cgltf_attribute_type_position)->count;
+		u32 const num_indices = prim->indices ? (u32)prim->indices->count : num_vertices;
+		ASSERT_F(num_indices % 3 == 0, "Triangle list index count has to be a multiple of 3!");
+
+		bool const b_has_normals = FindAttribute(prim, cgltf_attribute_type_normal) != nullptr;
+		bool const b_has_texcoords = FindAttribute(prim, cgltf_attribute_type_texcoord) != nullptr;
+		bool const b_has_tangents = FindAttribute(prim, cgltf_attribute_type_tangent) != nullptr;
+		bool const b_generate_tangents = (flags & ImportFlags::GenerateTangents) && b_has_texcoords && !b_has_tangents;
+		bool const b_generate_normals = (flags & (ImportFlags::GenerateNormals | ImportFlags::GenerateTangents)) && !b_has_normals;
+
+		out_layout->normals = b_generate_normals ? Memory::PushType<vec3>(scratch_memory, num_vertices) : nullptr;
+		out_layout->tangents = b_generate_tangents ? Memory::PushType<vec4>(scratch_memory, num_vertices) : nullptr;
+
+		// Welding only merges vertices, so a primitive that fits one chunk still does after it.
+		u32 const max_chunks = MeshOpt::GetMaxIndexChunks(num_indices, Gfx::MAX_SUBMESH_VERTICES);
+		u32 const max_chunk_vertices = (num_vertices <= Gfx::MAX_SUBMESH_VERTICES) ? min(num_vertices, num_indices) : num_indices;
+
+		out_layout->chunks = Memory::PushType<MeshOpt::IndexChunk>(scratch_memory, max_chunks);
+		out_layout->chunk_vertices = Memory::PushType<u32>(scratch_memory, max_chunk_vertices);
+		out_layout->chunk_indices = Memory::PushType<Gfx::Index_t>(scratch_memory, num_indices);
+
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32* indices = Memory::PushType<u32>(scratch_memory, num_indices);
+		ReadIndices(prim, indices, num_indices);
+
+		if (flags & ImportFlags::WeldVertices)
+		{
+			u32 num_streams = (u32)prim->attributes_count;
+			MeshOpt::VertexStream* streams = Memory::PushType<MeshOpt::VertexStream>(scratch_memory, num_streams + 1);
+			for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
+			{
+				cgltf_accessor const* accessor = prim->attributes[attrib_idx].data;
+				ASSERT(accessor->count == num_vertices);
+
+				MeshOpt::VertexStream& stream = streams[attrib_idx];
+				stream.data = (u8 const*)accessor->buffer_view->buffer->data + accessor->buffer_view->offset + accessor->offset;
+				stream.size = (u32)CalculateElementSize(accessor);
+				stream.stride = (u32)accessor->stride;
+			}
+
+			if (prim->targets_count > 0)
+			{
+				MeshOpt::VertexStream& stream = streams[num_streams++];
+				stream.data = HashTargetDeltas(prim, num_vertices, scratch_memory);
+				stream.size = sizeof(u64);
+				stream.stride = sizeof(u64);
+			}
+
+			u32* remap = Memory::PushType<u32>(scratch_memory, num_vertices);
+			MeshOpt::FindDuplicateVertices(remap, streams, num_streams, num_vertices, scratch_memory);
+
+			for (u32 i = 0; i < num_indices; ++i)
+			{
+				indices[i] = remap[indices[i]];
 			}
 		}
 
-		ASSERT(imported.position_buffer != nullptr);
+		if (b_generate_normals || b_generate_tangents)
+		{
+			GenerateTangentSpace(prim, indices, num_indices, out_layout, scratch_memory);
+		}
 
-		// TODO(): Remap texcoords
+		out_layout->num_chunks = MeshOpt::SplitIndices(out_layout->chunks, out_layout->chunk_vertices, out_layout->chunk_indices,
+			indices, num_indices, num_vertices, Gfx::MAX_SUBMESH_VERTICES, scratch_memory);
+	}
 
-		if (result == cgltf_result_success)
+	// Totals over every importable primitive of the file. Gathered in a first pass, so every
+	// destination stream is allocated once and then filled front to back.
+	struct ImportSizes
+	{
+		u64 num_vertices;
+		u64 num_indices;
+		u32 num_submeshes;
+
+		// Vertices before welding and splitting.
+		u64 num_source_vertices;
+
+		bool b_has_normals;
+		bool b_has_texcoords;
+		bool b_has_tangents;
+
+		// Some primitive has joints and weights.
+		bool b_has_skin;
+
+		// Some primitive got generated normals or tangents.
+		bool b_has_generated_attributes;
+
+		// Some primitive has morph targets.
+		bool b_has_morph_targets;
+
+		// One per importable primitive, in scratch memory.
+		PrimitiveLayout* primitives;
+	};
+
+	static ImportSizes CalculateImportSizes(cgltf_data const* scene_data, u32 flags, Memory::Arena* scratch_memory)
+	{
+		ImportSizes sizes;
+		MemZeroSafe(sizes);
+
+		u32 num_primitives = 0;
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
 		{
-			cgltf_free(scene_data);
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				num_primitives += IsImportable(&mesh->primitives[prim_idx]);
+			}
 		}
 
-		return imported;
+		if (num_primitives == 0)
+		{
+			return sizes;
+		}
+
+		sizes.primitives = Memory::PushType<PrimitiveLayout>(scratch_memory, num_primitives);
+
+		u32 primitive = 0;
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
+		{
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				cgltf_primitive const* prim = &mesh->primitives[prim_idx];
+				if (!IsImportable(prim))
+				{
+					continue;
+				}
+
+				PrimitiveLayout* layout = &sizes.primitives[primitive++];
+				PreparePrimitive(prim, flags, layout, scratch_memory);
+
+				MeshOpt::IndexChunk const& last = layout->chunks[layout->num_chunks - 1];
+				sizes.num_vertices += last.first_vertex + last.num_vertices;
+				sizes.num_indices += last.first_index + last.num_indices;
+				sizes.num_submeshes += layout->num_chunks;
+				sizes.num_source_vertices += FindAttribute(prim, cgltf_attribute_type_position)->count;
+
+				sizes.b_has_normals |= FindAttribute(prim, cgltf_attribute_type_normal) != nullptr || layout->normals != nullptr;
+				sizes.b_has_texcoords |= FindAttribute(prim, cgltf_attribute_type_texcoord) != nullptr;
+				sizes.b_has_tangents |= FindAttribute(prim, cgltf_attribute_type_tangent) != nullptr || layout->tangents != nullptr;
+				sizes.b_has_skin |= IsSkinned(prim);
+				sizes.b_has_generated_attributes |= layout->normals != nullptr || layout->tangents != nullptr;
+				sizes.b_has_morph_targets |= prim->targets_count > 0;
+			}
+		}
+
+		return sizes;
+	}
+
+	// Quantized weights only sum to 1 within their precision, the skinning kernels don't renormalize.
+	static void NormalizeWeights(Gfx::Weights_t* weights, u32 count)
+	{
+		for (u32 i = 0; i < count; ++i)
+		{
+			vec4& w = weights[i];
+			f32 const sum = w.x + w.y + w.z + w.w;
+			if (sum > 0.0f)
+			{
+				f32 const inv_sum = 1.0f / sum;
+				w = vec4(w.x * inv_sum, w.y * inv_sum, w.z * inv_sum, w.w * inv_sum);
+			}
+		}
+	}
+
+	// Copies the listed source vertices of a primitive to base_vertex, generated normals and tangents come
+	// from the layout. Attributes the primitive doesn't have, but other primitives of the scene do, are left zeroed.
+	static void ImportStreams(cgltf_primitive const* prim, PrimitiveLayout const* layout, MeshImport* imported, u32 base_vertex,
+		u32 const* src_vertices, u32 count)
+	{
+		cgltf_accessor* positions = FindAttribute(prim, cgltf_attribute_type_position);
+
+		vec3* dst_positions = imported->position_buffer + base_vertex;
+		CopyBuffer((u8*)dst_positions, sizeof(Gfx::Position_t) * count, cgltf_type_vec3, cgltf_component_type_r_32f, positions, src_vertices, count,
+			BASIS_CHANGE_MASK);
+
+		if (cgltf_accessor* normals = FindAttribute(prim, cgltf_attribute_type_normal))
+		{
+			ASSERT(normals->count == positions->count);
+			vec3* dst_normals = imported->normal_buffer + base_vertex;
+			CopyBuffer((u8*)dst_normals, sizeof(Gfx::Normal_t) * count, cgltf_type_vec3, cgltf_component_type_r_32f, normals, src_vertices, count,
+				BASIS_CHANGE_MASK);
+		}
+		else if (layout->normals != nullptr)
+		{
+			vec3* dst_normals = imported->normal_buffer + base_vertex;
+			StreamCopy::ReadComponents(&dst_normals->x, layout->normals, src_vertices, count, 3, StreamCopy::ComponentType::F32, false,
+				sizeof(Gfx::Normal_t), BASIS_CHANGE_MASK);
+		}
+
+		if (cgltf_accessor* texcoords = FindAttribute(prim, cgltf_attribute_type_texcoord))
+		{
+			ASSERT(texcoords->count == positions->count);
+			vec2* dst_texcoords = imported->texcoord_buffer + base_vertex;
+			CopyBuffer((u8*)dst_texcoords, sizeof(Gfx::TexCoord_t) * count, cgltf_type_vec2, cgltf_component_type_r_32f, texcoords, src_vertices, count);
+		}
+
+		if (cgltf_accessor* tangents = FindAttribute(prim, cgltf_attribute_type_tangent))
+		{
+			ASSERT(tangents->count == positions->count);
+			vec4* dst_tangents = imported->tangent_buffer + base_vertex;
+			CopyBuffer((u8*)dst_tangents, sizeof(Gfx::Tangent_t) * count, cgltf_type_vec4, cgltf_component_type_r_32f, tangents, src_vertices, count,
+				TANGENT_BASIS_CHANGE_MASK);
+		}
+		else if (layout->tangents != nullptr)
+		{
+			vec4* dst_tangents = imported->tangent_buffer + base_vertex;
+			StreamCopy::ReadComponents(&dst_tangents->x, layout->tangents, src_vertices, count, 4, StreamCopy::ComponentType::F32, false,
+				sizeof(Gfx::Tangent_t), TANGENT_BASIS_CHANGE_MASK);
+		}
+
+		if (IsSkinned(prim))
+		{
+			cgltf_accessor* joints = FindAttribute(prim, cgltf_attribute_type_joints);
+			cgltf_accessor* weights = FindAttribute(prim, cgltf_attribute_type_weights);
+			ASSERT(joints->count == positions->count && weights->count == positions->count);
+
+			Gfx::Joints_t* dst_joints = imported->joint_buffer + base_vertex;
+			CopyBuffer((u8*)dst_joints, sizeof(Gfx::Joints_t) * count, cgltf_type_vec4, cgltf_component_type_r_16u, joints, src_vertices, count);
+
+			Gfx::Weights_t* dst_weights = imported->weight_buffer + base_vertex;
+			CopyBuffer((u8*)dst_weights, sizeof(Gfx::Weights_t) * count, cgltf_type_vec4, cgltf_component_type_r_32f, weights, src_vertices, count);
+			NormalizeWeights(dst_weights, count);
+		}
+	}
+
+	static bool GetInterleavedAttribType(cgltf_attribute const* attrib, Gfx::VertexAttribType::Enum* out_type)
+	{
+		cgltf_accessor const* access = attrib->data;
+		if (access->component_type != cgltf_component_type_r_32f || attrib->index != 0)
+		{
+			return false;
+		}
+
+		switch (attrib->type)
+		{
+		case cgltf_attribute_type_position:
+			*out_type = Gfx::VertexAttribType::Position;
+			return access->type == cgltf_type_vec3;
+		case cgltf_attribute_type_normal:
+			*out_type = Gfx::VertexAttribType::Normal;
+			return access->type == cgltf_type_vec3;
+		case cgltf_attribute_type_texcoord:
+			*out_type = Gfx::VertexAttribType::TexCoord;
+			return access->type == cgltf_type_vec2;
+		case cgltf_attribute_type_tangent:
+			*out_type = Gfx::VertexAttribType::Tangent;
+			return access->type == cgltf_type_vec4;
+		default:
+			return false;
+		}
+	}
+
+	struct InterleavedLayout
+	{
+		u32 stride;
+		u32 offsets[Gfx::VertexAttribType::EnumCount];
+	};
+
+	// Interleaved data can only be kept if every attribute lives in the same strided
+	// buffer view, and already is in the format the vertex input layout expects.
+	// out_vertex_start receives the offset of the first vertex into the view.
+	static bool GetInterleavedLayout(cgltf_primitive const* prim, InterleavedLayout* out_layout, u64* out_vertex_start)
+	{
+		cgltf_buffer_view const* view = prim->attributes_count > 0 ? prim->attributes[0].data->buffer_view : nullptr;
+		if (view == nullptr || view->stride == 0)
+		{
+			return false;
+		}
+
+		// Vertices start at the attribute with the smallest offset into the view.
+		u64 vertex_start = view->size;
+		for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
+		{
+			cgltf_attribute const* attrib = &prim->attributes[attrib_idx];
+			Gfx::VertexAttribType::Enum type;
+
+			if (attrib->data->buffer_view != view || !GetInterleavedAttribType(attrib, &type))
+			{
+				return false;
+			}
+
+			vertex_start = min<u64>(vertex_start, attrib->data->offset);
+		}
+
+		out_layout->stride = (u32)view->stride;
+		for (u32 i = 0; i < Gfx::VertexAttribType::EnumCount; ++i)
+		{
+			out_layout->offsets[i] = INTERLEAVED_ATTRIB_MISSING;
+		}
+
+		for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
+		{
+			cgltf_attribute const* attrib = &prim->attributes[attrib_idx];
+
+			Gfx::VertexAttribType::Enum type;
+			if (!GetInterleavedAttribType(attrib, &type))
+			{
+				return false;
+			}
+
+			u32 const offset = (u32)(attrib->data->offset - vertex_start);
+			ASSERT_F(offset + CalculateElementSize(attrib->data) <= view->stride, "Attribute does not fit into the vertex stride!");
+			out_layout->offsets[type] = offset;
+		}
+
+		*out_vertex_start = vertex_start;
+		return out_layout->offsets[Gfx::VertexAttribType::Position] != INTERLEAVED_ATTRIB_MISSING;
+	}
+
+	// All primitives share a single interleaved buffer, so they all need the same vertex layout.
+	static bool CanKeepInterleaved(cgltf_data const* scene_data, InterleavedLayout* out_layout)
+	{
+		bool b_found_layout = false;
+
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
+		{
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				cgltf_primitive const* prim = &mesh->primitives[prim_idx];
+				if (!IsImportable(prim))
+				{
+					continue;
+				}
+
+				InterleavedLayout layout;
+				u64 vertex_start;
+				if (!GetInterleavedLayout(prim, &layout, &vertex_start))
+				{
+					return false;
+				}
+
+				if (b_found_layout && memcmp(&layout, out_layout, sizeof(layout)) != 0)
+				{
+					return false;
+				}
+
+				*out_layout = layout;
+				b_found_layout = true;
+			}
+		}
+
+		return b_found_layout;
+	}
+
+	// Copies the listed source vertices of a primitive to base_vertex of the interleaved buffer.
+	static void ImportInterleaved(cgltf_primitive const* prim, MeshImport* imported, u32 base_vertex, u32 const* src_vertices, u32 num_vertices)
+	{
+		// CanKeepInterleaved() already checked every primitive.
+		InterleavedLayout layout;
+		u64 vertex_start;
+		VERIFY(GetInterleavedLayout(prim, &layout, &vertex_start));
+
+		cgltf_buffer_view const* view = prim->attributes[0].data->buffer_view;
+		u32 const stride = layout.stride;
+
+		for (u64 attrib_idx = 0; attrib_idx < prim->attributes_count; ++attrib_idx)
+		{
+			ASSERT(prim->attributes[attrib_idx].data->count == prim->attributes[0].data->count);
+		}
+
+		u8* vertices = imported->interleaved_buffer + (u64)base_vertex * stride;
+		u8 const* src = (u8 const*)view->buffer->data + view->offset + vertex_start;
+		u64 const src_size = view->size - vertex_start;
+
+		// The last source vertex may end before the full stride, the rest stays zeroed.
+		for (u32 i = 0; i < num_vertices; ++i)
+		{
+			u64 const src_offset = (u64)src_vertices[i] * stride;
+			memcpy(vertices + (u64)i * stride, src + src_offset, min<u64>(stride, src_size - src_offset));
+		}
+
+		u32 const* offsets = layout.offsets;
+		InvertZStrided(vertices + offsets[Gfx::VertexAttribType::Position], num_vertices, stride);
+		if (offsets[Gfx::VertexAttribType::Normal] != INTERLEAVED_ATTRIB_MISSING)
+		{
+			InvertZStrided(vertices + offsets[Gfx::VertexAttribType::Normal], num_vertices, stride);
+		}
+		if (offsets[Gfx::VertexAttribType::Tangent] != INTERLEAVED_ATTRIB_MISSING)
+		{
+			ChangeTangentBasisStrided(vertices + offsets[Gfx::VertexAttribType::Tangent], num_vertices, stride);
+		}
+	}
+
+	static void ComputeSubMeshBounds(MeshImport const* imported, Gfx::SubMesh* submesh, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		if (imported->interleaved_buffer == nullptr)
+		{
+			vec3 const* positions = imported->position_buffer + submesh->base_vertex_location;
+			submesh->aabb = Bounds::ComputeAABB(positions, num_vertices);
+			submesh->bounding_sphere = Bounds::ComputeBoundingSphere(positions, num_vertices);
+			return;
+		}
+
+		// The bounds kernels want tightly packed positions.
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 const stride = imported->interleaved_stride;
+		u8 const* vertices = imported->interleaved_buffer + (u64)submesh->base_vertex_location * stride;
+
+		vec3* positions = Memory::PushType<vec3>(scratch_memory, num_vertices);
+		StreamCopy::Deinterleave(positions, vertices + imported->interleaved_offsets[Gfx::VertexAttribType::Position], num_vertices, sizeof(vec3), stride);
+
+		submesh->aabb = Bounds::ComputeAABB(positions, num_vertices);
+		submesh->bounding_sphere = Bounds::ComputeBoundingSphere(positions, num_vertices);
+	}
+
+	// Reorders the triangles of a submesh for the vertex cache and overdraw, then its vertices for fetch.
+	// Accumulates the cache stats from before and after into the two arguments. Optional source_vertices
+	// (one per vertex of the submesh) are reordered along with the streams.
+	static void OptimizeSubMesh(MeshImport* imported, Gfx::SubMesh const* submesh, u32 num_vertices,
+		MeshOpt::VertexCacheStats* stats_before, MeshOpt::VertexCacheStats* stats_after, u32* source_vertices, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		Gfx::Index_t* indices = imported->index_buffer + submesh->first_index_location;
+		u32 const num_indices = submesh->num_indices;
+		u32 const base_vertex = submesh->base_vertex_location;
+		u32 const stride = imported->interleaved_stride;
+
+		vec3 const* positions = nullptr;
+		if (imported->interleaved_buffer == nullptr)
+		{
+			positions = imported->position_buffer + base_vertex;
+		}
+		else
+		{
+			vec3* deinterleaved = Memory::PushType<vec3>(scratch_memory, num_vertices);
+			u8 const* vertices = imported->interleaved_buffer + (u64)base_vertex * stride;
+			StreamCopy::Deinterleave(deinterleaved, vertices + imported->interleaved_offsets[Gfx::VertexAttribType::Position], num_vertices, sizeof(vec3), stride);
+			positions = deinterleaved;
+		}
+
+		MeshOpt::VertexCacheStats const before = MeshOpt::AnalyzeVertexCache(indices, num_indices, num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, scratch_memory);
+
+		MeshOpt::OptimizeVertexCache(indices, num_indices, num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, scratch_memory);
+		MeshOpt::OptimizeOverdraw(indices, num_indices, positions, num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, MeshOpt::DEFAULT_OVERDRAW_THRESHOLD, scratch_memory);
+
+		MeshOpt::VertexCacheStats const after = MeshOpt::AnalyzeVertexCache(indices, num_indices, num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, scratch_memory);
+		stats_before->vertices_transformed += before.vertices_transformed;
+		stats_after->vertices_transformed += after.vertices_transformed;
+
+		// Positions may live in scratch, so the vertices are only moved once the index order is final.
+		u32* remap = Memory::PushType<u32>(scratch_memory, num_vertices);
+		MeshOpt::OptimizeVertexFetch(remap, indices, num_indices, num_vertices);
+
+		if (source_vertices != nullptr)
+		{
+			MeshOpt::RemapVertexStream(source_vertices, num_vertices, sizeof(u32), remap, scratch_memory);
+		}
+
+		if (imported->interleaved_buffer != nullptr)
+		{
+			MeshOpt::RemapVertexStream(imported->interleaved_buffer + (u64)base_vertex * stride, num_vertices, stride, remap, scratch_memory);
+			return;
+		}
+
+		MeshOpt::RemapVertexStream(imported->position_buffer + base_vertex, num_vertices, sizeof(Gfx::Position_t), remap, scratch_memory);
+		if (imported->normal_buffer != nullptr)
+		{
+			MeshOpt::RemapVertexStream(imported->normal_buffer + base_vertex, num_vertices, sizeof(Gfx::Normal_t), remap, scratch_memory);
+		}
+		if (imported->texcoord_buffer != nullptr)
+		{
+			MeshOpt::RemapVertexStream(imported->texcoord_buffer + base_vertex, num_vertices, sizeof(Gfx::TexCoord_t), remap, scratch_memory);
+		}
+		if (imported->tangent_buffer != nullptr)
+		{
+			MeshOpt::RemapVertexStream(imported->tangent_buffer + base_vertex, num_vertices, sizeof(Gfx::Tangent_t), remap, scratch_memory);
+		}
+		if (imported->joint_buffer != nullptr)
+		{
+			MeshOpt::RemapVertexStream(imported->joint_buffer + base_vertex, num_vertices, sizeof(Gfx::Joints_t), remap, scratch_memory);
+			MeshOpt::RemapVertexStream(imported->weight_buffer + base_vertex, num_vertices, sizeof(Gfx::Weights_t), remap, scratch_memory);
+		}
+	}
+
+	// Each LOD aims for this fraction of the previous level's triangles.
+	static constexpr f32 LOD_TRIANGLE_RATIO = 0.5f;
+
+	// Simplification stops at this error per level, relative to the submesh size.
+	static constexpr f32 LOD_MAX_ERROR = 0.02f;
+
+	// Levels that don't get below this fraction of the previous one aren't kept.
+	static constexpr f32 LOD_MIN_REDUCTION = 0.8f;
+
+	static u32 GetSubMeshVertexCount(MeshImport const* imported, u32 submesh_idx)
+	{
+		u32 const end = (submesh_idx + 1 < imported->num_submeshes) ? imported->submeshes[submesh_idx + 1].base_vertex_location : imported->num_vertices;
+		return end - imported->submeshes[submesh_idx].base_vertex_location;
+	}
+
+	// Smaller deltas count as zero, exporters tend to write rounding noise for the vertices a target doesn't move.
+	static constexpr f32 MORPH_DELTA_EPSILON = 1e-6f;
+
+	// Deltas of one target in scratch memory, until every mesh is done and they move to mesh memory.
+	struct MorphTargetScratch
+	{
+		u32* chunk_offsets;
+		Morph::DeltaChunk* chunks;
+		u32 num_chunks;
+	};
+
+	static bool IsZeroDeltaChunk(Morph::DeltaChunk const& chunk)
+	{
+		f32 const* deltas = &chunk.positions[0][0];
+		for (u32 i = 0; i < sizeof(Morph::DeltaChunk) / sizeof(f32); ++i)
+		{
+			if (fabsf(deltas[i]) > MORPH_DELTA_EPSILON)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Gathers the deltas of one target into dense chunks over the vertices of a mesh, in engine space.
+	// source_vertices maps every imported vertex of the mesh back to the vertex of its primitive.
+	static void GatherTargetDeltas(Morph::DeltaChunk* dense, cgltf_mesh const* mesh, u32 target_idx, PrimitiveLayout const* layouts,
+		u32 const* source_vertices, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		memset(dense, 0, sizeof(Morph::DeltaChunk) * ((num_vertices + Morph::CHUNK_VERTICES - 1) / Morph::CHUNK_VERTICES));
+
+		u32 vertex = 0;
+		u32 primitive = 0;
+		for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+		{
+			cgltf_primitive const* prim = &mesh->primitives[prim_idx];
+			if (!IsImportable(prim))
+			{
+				continue;
+			}
+
+			MeshOpt::IndexChunk const& last = layouts[primitive].chunks[layouts[primitive].num_chunks - 1];
+			u32 const prim_vertices = last.first_vertex + last.num_vertices;
+			primitive++;
+
+			Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+			u32 const num_source_vertices = (u32)FindAttribute(prim, cgltf_attribute_type_position)->count;
+			f32* deltas = Memory::PushType<f32>(scratch_memory, num_source_vertices * 3);
+
+			cgltf_morph_target const* target = &prim->targets[target_idx];
+			for (u32 stream = 0; stream < 2; ++stream)
+			{
+				bool const b_normals = stream == 1;
+				if (b_normals && FindAttribute(prim, cgltf_attribute_type_normal) == nullptr)
+				{
+					continue;
+				}
+				if (!ReadTargetDeltas(deltas, target, b_normals ? cgltf_attribute_type_normal : cgltf_attribute_type_position, num_source_vertices))
+				{
+					continue;
+				}
+
+				for (u32 i = 0; i < prim_vertices; ++i)
+				{
+					u32 const v = vertex + i;
+					f32 const* src = deltas + (u64)source_vertices[v] * 3;
+					Morph::DeltaChunk& chunk = dense[v / Morph::CHUNK_VERTICES];
+					f32 (*dst)[Morph::CHUNK_VERTICES] = b_normals ? chunk.normals : chunk.positions;
+
+					// Same change of basis as BASIS_CHANGE_MASK.
+					dst[0][v % Morph::CHUNK_VERTICES] = src[0];
+					dst[1][v % Morph::CHUNK_VERTICES] = src[1];
+					dst[2][v % Morph::CHUNK_VERTICES] = -src[2];
+				}
+			}
+
+			vertex += prim_vertices;
+		}
+
+		ASSERT(vertex == num_vertices);
+	}
+
+	// Every glTF mesh with targets becomes a target set over the vertices of its submeshes, out_mesh_sets receives
+	// the set of every mesh or Gfx::MORPH_NONE. source_vertices has the primitive vertex of every imported vertex.
+	static void ImportMorphTargets(cgltf_data const* scene_data, PrimitiveLayout const* layouts, u32 const* source_vertices,
+		u32 const* mesh_first_submesh, u32 const* mesh_num_submeshes, u32* out_mesh_sets, MeshImport* imported, SceneImporter const* importer)
+	{
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+
+		u32 num_sets = 0;
+		u32 num_targets = 0;
+		u32 max_set_vertices = 0;
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
+		{
+			out_mesh_sets[mesh_idx] = Gfx::MORPH_NONE;
+			if (mesh_num_submeshes[mesh_idx] == 0)
+			{
+				continue;
+			}
+
+			// glTF requires the same targets on every primitive of a mesh.
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			u64 mesh_targets = ~0ull;
+			bool b_consistent = true;
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				cgltf_primitive const* prim = &mesh->primitives[prim_idx];
+				if (IsImportable(prim))
+				{
+					b_consistent &= mesh_targets == ~0ull || mesh_targets == prim->targets_count;
+					mesh_targets = prim->targets_count;
+				}
+			}
+
+			if (!b_consistent)
+			{
+				LOG(Log::IO, "%s: mesh %u has primitives with different morph targets, they are skipped", importer->file_path, (u32)mesh_idx);
+				continue;
+			}
+
+			if (mesh_targets > 0)
+			{
+				u32 const first_submesh = mesh_first_submesh[mesh_idx];
+				u32 const last_submesh = first_submesh + mesh_num_submeshes[mesh_idx] - 1;
+				u32 const set_vertices = imported->submeshes[last_submesh].base_vertex_location + GetSubMeshVertexCount(imported, last_submesh) -
+					imported->submeshes[first_submesh].base_vertex_location;
+
+				out_mesh_sets[mesh_idx] = num_sets++;
+				num_targets += (u32)mesh_targets;
+				max_set_vertices = max(max_set_vertices, set_vertices);
+			}
+		}
+
+		if (num_sets == 0)
+		{
+			return;
+		}
+
+		Morph::TargetLibrary& library = imported->morph_targets;
+		library.num_sets = num_sets;
+		library.num_targets = num_targets;
+		library.sets = PushSharedType<Morph::TargetSet>(importer, importer->mesh_memory, num_sets);
+		library.targets = PushSharedType<Morph::Target>(importer, importer->mesh_memory, num_targets);
+
+		MorphTargetScratch* target_deltas = Memory::PushType<MorphTargetScratch>(scratch_memory, num_targets);
+		u32 const max_set_chunks = (max_set_vertices + Morph::CHUNK_VERTICES - 1) / Morph::CHUNK_VERTICES;
+		Morph::DeltaChunk* dense = Memory::PushType<Morph::DeltaChunk>(scratch_memory, max_set_chunks, Memory::AlignPush(32));
+
+		u32 primitive = 0;
+		u32 target = 0;
+		u32 num_dense_chunks = 0;
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
+		{
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			PrimitiveLayout const* mesh_layouts = layouts + primitive;
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				primitive += IsImportable(&mesh->primitives[prim_idx]);
+			}
+
+			u32 const set_idx = out_mesh_sets[mesh_idx];
+			if (set_idx == Gfx::MORPH_NONE)
+			{
+				continue;
+			}
+
+			u32 const first_submesh = mesh_first_submesh[mesh_idx];
+			u32 const last_submesh = first_submesh + mesh_num_submeshes[mesh_idx] - 1;
+
+			Morph::TargetSet& set = library.sets[set_idx];
+			set.first_vertex = imported->submeshes[first_submesh].base_vertex_location;
+			set.num_vertices = imported->submeshes[last_submesh].base_vertex_location + GetSubMeshVertexCount(imported, last_submesh) - set.first_vertex;
+			set.first_target = target;
+			set.num_targets = 0;
+
+			// Targets of the first importable primitive, they are the same on all of them.
+			u64 mesh_targets = 0;
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count && mesh_targets == 0; ++prim_idx)
+			{
+				mesh_targets = IsImportable(&mesh->primitives[prim_idx]) ? mesh->primitives[prim_idx].targets_count : 0;
+			}
+
+			u32 const set_chunks = (set.num_vertices + Morph::CHUNK_VERTICES - 1) / Morph::CHUNK_VERTICES;
+			for (u32 target_idx = 0; target_idx < (u32)mesh_targets; ++target_idx)
+			{
+				GatherTargetDeltas(dense, mesh, target_idx, mesh_layouts, source_vertices + set.first_vertex, set.num_vertices, scratch_memory);
+
+				u32 num_chunks = 0;
+				for (u32 i = 0; i < set_chunks; ++i)
+				{
+					num_chunks += !IsZeroDeltaChunk(dense[i]);
+				}
+
+				MorphTargetScratch& deltas = target_deltas[target];
+				deltas.chunk_offsets = Memory::PushType<u32>(scratch_memory, num_chunks);
+				deltas.chunks = Memory::PushType<Morph::DeltaChunk>(scratch_memory, num_chunks);
+				deltas.num_chunks = 0;
+				for (u32 i = 0; i < set_chunks; ++i)
+				{
+					if (!IsZeroDeltaChunk(dense[i]))
+					{
+						deltas.chunk_offsets[deltas.num_chunks] = i * Morph::CHUNK_VERTICES;
+						deltas.chunks[deltas.num_chunks++] = dense[i];
+					}
+				}
+
+				num_dense_chunks += set_chunks;
+
+				Morph::Target& out_target = library.targets[target++];
+				out_target.num_chunks = num_chunks;
+				out_target.default_weight = (target_idx < mesh->weights_count) ? mesh->weights[target_idx] : 0.0f;
+				set.num_targets++;
+			}
+		}
+
+		ASSERT(target == num_targets);
+
+		for (u32 i = 0; i < num_targets; ++i)
+		{
+			library.targets[i].first_chunk = library.num_chunks;
+			library.num_chunks += target_deltas[i].num_chunks;
+		}
+
+		library.chunk_offsets = PushSharedType<u32>(importer, importer->mesh_memory, library.num_chunks);
+		library.chunks = PushSharedType<Morph::DeltaChunk>(importer, importer->mesh_memory, library.num_chunks, Memory::AlignPush(32));
+		for (u32 i = 0; i < num_targets; ++i)
+		{
+			MorphTargetScratch const& deltas = target_deltas[i];
+			memcpy(library.chunk_offsets + library.targets[i].first_chunk, deltas.chunk_offsets, sizeof(u32) * deltas.num_chunks);
+			memcpy(library.chunks + library.targets[i].first_chunk, deltas.chunks, sizeof(Morph::DeltaChunk) * deltas.num_chunks);
+		}
+
+		LOG(Log::IO, "%s: %u morph targets on %u meshes, %u of %u delta chunks are non-zero", importer->file_path, num_targets, num_sets,
+			library.num_chunks, num_dense_chunks);
+	}
+
+	// Scratch memory of a LOD job: the attribute copies, the LOD index lists, and Simplify() or
+	// OptimizeVertexCache() on top, whichever needs more.
+	static u64 GetLodScratchSize(u32 num_indices, u32 num_vertices)
+	{
+		u64 const attributes = (u64)num_vertices * (sizeof(vec3) * 2 + sizeof(vec2));
+		u64 const lod_indices = (u64)num_indices * sizeof(Gfx::Index_t) * Gfx::MAX_SUBMESH_LODS;
+		u64 const vertex_cache = (u64)num_vertices * sizeof(u32) * 4 + (u64)num_indices * (sizeof(u32) * 3 + sizeof(Gfx::Index_t)) + num_indices / 3;
+		return attributes + lod_indices + max(MeshOpt::GetSimplifyScratchSize(num_indices, num_vertices), vertex_cache) + 16 * PLATFORM_DEFAULT_ALIGNMENT;
+	}
+
+	struct LodTask
+	{
+		MeshImport* imported;
+		bool b_optimize_vertex_cache;
+
+		// One per submesh, carved from the import's scratch memory.
+		Memory::Arena* submesh_scratch;
+
+		// Per submesh and level, in submesh_scratch.
+		Gfx::Index_t** lod_indices;
+	};
+
+	static void GenerateSubMeshLods(LodTask const* task, u32 submesh_idx)
+	{
+		MeshImport const* imported = task->imported;
+		Gfx::SubMesh* submesh = &imported->submeshes[submesh_idx];
+		Memory::Arena* scratch_memory = &task->submesh_scratch[submesh_idx];
+
+		u32 const num_vertices = GetSubMeshVertexCount(imported, submesh_idx);
+		u32 const base_vertex = submesh->base_vertex_location;
+
+		MeshOpt::SimplifyInput input;
+		MemZeroSafe(input);
+		input.num_vertices = num_vertices;
+
+		if (imported->interleaved_buffer == nullptr)
+		{
+			input.positions = imported->position_buffer + base_vertex;
+			input.normals = imported->normal_buffer ? imported->normal_buffer + base_vertex : nullptr;
+			input.texcoords = imported->texcoord_buffer ? imported->texcoord_buffer + base_vertex : nullptr;
+		}
+		else
+		{
+			u32 const stride = imported->interleaved_stride;
+			u32 const* offsets = imported->interleaved_offsets;
+			u8 const* vertices = imported->interleaved_buffer + (u64)base_vertex * stride;
+
+			vec3* positions = Memory::PushType<vec3>(scratch_memory, num_vertices);
+			StreamCopy::Deinterleave(positions, vertices + offsets[Gfx::VertexAttribType::Position], num_vertices, sizeof(vec3), stride);
+			input.positions = positions;
+
+			if (offsets[Gfx::VertexAttribType::Normal] != INTERLEAVED_ATTRIB_MISSING)
+			{
+				vec3* normals = Memory::PushType<vec3>(scratch_memory, num_vertices);
+				StreamCopy::Deinterleave(normals, vertices + offsets[Gfx::VertexAttribType::Normal], num_vertices, sizeof(vec3), stride);
+				input.normals = normals;
+			}
+			if (offsets[Gfx::VertexAttribType::TexCoord] != INTERLEAVED_ATTRIB_MISSING)
+			{
+				vec2* texcoords = Memory::PushType<vec2>(scratch_memory, num_vertices);
+				StreamCopy::Deinterleave(texcoords, vertices + offsets[Gfx::VertexAttribType::TexCoord], num_vertices, sizeof(vec2), stride);
+				input.texcoords = texcoords;
+			}
+		}
+
+		vec3 const size = vec3(submesh->aabb.max.x - submesh->aabb.min.x, submesh->aabb.max.y - submesh->aabb.min.y, submesh->aabb.max.z - submesh->aabb.min.z);
+		f32 const extent = max(size.x, max(size.y, size.z));
+
+		// Every level is simplified from the previous one, so their errors add up.
+		input.indices = imported->index_buffer + submesh->first_index_location;
+		input.num_indices = submesh->num_indices;
+		f32 error = 0.0f;
+
+		for (u32 lod = 0; lod < Gfx::MAX_SUBMESH_LODS; ++lod)
+		{
+			u32 const target_num_indices = (u32)(input.num_indices / 3 * LOD_TRIANGLE_RATIO) * 3;
+
+			Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(scratch_memory, input.num_indices);
+			f32 level_error;
+			u32 const num_indices = MeshOpt::Simplify(indices, &input, target_num_indices, LOD_MAX_ERROR, &level_error, scratch_memory);
+
+			if (num_indices == 0 || num_indices > input.num_indices * LOD_MIN_REDUCTION)
+			{
+				break;
+			}
+
+			if (task->b_optimize_vertex_cache)
+			{
+				MeshOpt::OptimizeVertexCache(indices, num_indices, num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, scratch_memory);
+			}
+
+			error += level_error * extent;
+			submesh->lods[lod].num_indices = num_indices;
+			submesh->lods[lod].error = error;
+			submesh->num_lods++;
+			task->lod_indices[submesh_idx * Gfx::MAX_SUBMESH_LODS + lod] = indices;
+
+			input.indices = indices;
+			input.num_indices = num_indices;
+		}
+	}
+
+	static void GenerateLodsBatch(void* user_data, u64 begin, u64 end)
+	{
+		LodTask const* task = static_cast<LodTask const*>(user_data);
+		for (u64 submesh_idx = begin; submesh_idx < end; ++submesh_idx)
+		{
+			GenerateSubMeshLods(task, (u32)submesh_idx);
+		}
+	}
+
+	// Simplifies all submeshes in parallel, then moves the full detail indices and all LODs to one
+	// index buffer in mesh memory. Expects imported->index_buffer in scratch memory.
+	static void GenerateLods(MeshImport* imported, SceneImporter const* importer)
+	{
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+
+		LodTask task;
+		task.imported = imported;
+		task.b_optimize_vertex_cache = (importer->flags & ImportFlags::OptimizeVertexOrder) != 0;
+		task.submesh_scratch = Memory::PushType<Memory::Arena>(scratch_memory, imported->num_submeshes);
+		task.lod_indices = Memory::PushType<Gfx::Index_t*>(scratch_memory, imported->num_submeshes * Gfx::MAX_SUBMESH_LODS);
+
+		// Jobs can't share an arena, so every submesh gets a slice of the import's scratch memory.
+		for (u32 i = 0; i < imported->num_submeshes; ++i)
+		{
+			u64 const size = GetLodScratchSize(imported->submeshes[i].num_indices, GetSubMeshVertexCount(imported, i));
+
+			Memory::Arena& submesh_scratch = task.submesh_scratch[i];
+			submesh_scratch.m_memory_block = (u8*)Memory::PushSize(scratch_memory, size);
+			submesh_scratch.m_bytes_used = 0;
+			submesh_scratch.m_size = size;
+		}
+
+		Jobs::ParallelFor(imported->num_submeshes, 1, &GenerateLodsBatch, &task);
+
+		u32 num_indices = imported->num_indices;
+		for (u32 i = 0; i < imported->num_submeshes; ++i)
+		{
+			for (u32 lod = 0; lod < imported->submeshes[i].num_lods; ++lod)
+			{
+				num_indices += imported->submeshes[i].lods[lod].num_indices;
+			}
+		}
+
+		Gfx::Index_t* index_buffer = PushSharedType<Gfx::Index_t>(importer, importer->mesh_memory, num_indices);
+		memcpy(index_buffer, imported->index_buffer, sizeof(Gfx::Index_t) * imported->num_indices);
+
+		// LODs go behind the full detail indices, submesh by submesh.
+		u32 first_index = imported->num_indices;
+		for (u32 i = 0; i < imported->num_submeshes; ++i)
+		{
+			Gfx::SubMesh* submesh = &imported->submeshes[i];
+			for (u32 lod = 0; lod < submesh->num_lods; ++lod)
+			{
+				Gfx::SubMeshLod* level = &submesh->lods[lod];
+				memcpy(index_buffer + first_index, task.lod_indices[i * Gfx::MAX_SUBMESH_LODS + lod], sizeof(Gfx::Index_t) * level->num_indices);
+				level->first_index_location = first_index;
+				first_index += level->num_indices;
+			}
+		}
+
+		imported->index_buffer = index_buffer;
+		imported->num_indices = num_indices;
+	}
+
+	// Clusters the full detail indices of every submesh, then moves all meshlets to mesh memory.
+	static void BuildMeshlets(MeshImport* imported, SceneImporter const* importer)
+	{
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+
+		u32 max_meshlets = 0;
+		for (u32 i = 0; i < imported->num_submeshes; ++i)
+		{
+			max_meshlets += Meshlets::GetMaxMeshlets(imported->submeshes[i].num_indices);
+		}
+
+		if (max_meshlets == 0)
+		{
+			return;
+		}
+
+		// Every meshlet vertex and triangle corner stands for at least one index.
+		Gfx::Meshlet* meshlets = Memory::PushType<Gfx::Meshlet>(scratch_memory, max_meshlets);
+		Gfx::Index_t* meshlet_vertices = Memory::PushType<Gfx::Index_t>(scratch_memory, imported->num_indices);
+		u8* meshlet_triangles = Memory::PushType<u8>(scratch_memory, imported->num_indices);
+
+		u32 num_meshlets = 0;
+		u32 num_meshlet_vertices = 0;
+		u32 num_meshlet_triangles = 0;
+
+		for (u32 i = 0; i < imported->num_submeshes; ++i)
+		{
+			Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+			Gfx::SubMesh* submesh = &imported->submeshes[i];
+			u32 const num_vertices = GetSubMeshVertexCount(imported, i);
+			u32 const base_vertex = submesh->base_vertex_location;
+
+			vec3 const* positions = nullptr;
+			if (imported->interleaved_buffer == nullptr)
+			{
+				positions = imported->position_buffer + base_vertex;
+			}
+			else
+			{
+				u32 const stride = imported->interleaved_stride;
+				vec3* deinterleaved = Memory::PushType<vec3>(scratch_memory, num_vertices);
+				u8 const* vertices = imported->interleaved_buffer + (u64)base_vertex * stride;
+				StreamCopy::Deinterleave(deinterleaved, vertices + imported->interleaved_offsets[Gfx::VertexAttribType::Position], num_vertices, sizeof(vec3), stride);
+				positions = deinterleaved;
+			}
+
+			Gfx::Meshlet* submesh_meshlets = meshlets + num_meshlets;
+			u32 const count = Meshlets::BuildMeshlets(submesh_meshlets, meshlet_vertices + num_meshlet_vertices,
+				meshlet_triangles + (u64)num_meshlet_triangles * 3, imported->index_buffer + submesh->first_index_location,
+				submesh->num_indices, positions, num_vertices, scratch_memory);
+
+			// Meshlet ranges come back relative to the submesh.
+			for (u32 j = 0; j < count; ++j)
+			{
+				submesh_meshlets[j].first_vertex += num_meshlet_vertices;
+				submesh_meshlets[j].first_triangle += num_meshlet_triangles;
+			}
+
+			submesh->first_meshlet = num_meshlets;
+			submesh->num_meshlets = count;
+
+			if (count > 0)
+			{
+				Gfx::Meshlet const& last = submesh_meshlets[count - 1];
+				num_meshlet_vertices = last.first_vertex + last.num_vertices;
+				num_meshlet_triangles = last.first_triangle + last.num_triangles;
+			}
+			num_meshlets += count;
+		}
+
+		imported->meshlets = PushSharedType<Gfx::Meshlet>(importer, importer->mesh_memory, num_meshlets);
+		imported->meshlet_vertices = PushSharedType<Gfx::Index_t>(importer, importer->mesh_memory, num_meshlet_vertices);
+		imported->meshlet_triangles = PushSharedType<u8>(importer, importer->mesh_memory, num_meshlet_triangles * 3);
+		memcpy(imported->meshlets, meshlets, sizeof(Gfx::Meshlet) * num_meshlets);
+		memcpy(imported->meshlet_vertices, meshlet_vertices, sizeof(Gfx::Index_t) * num_meshlet_vertices);
+		memcpy(imported->meshlet_triangles, meshlet_triangles, num_meshlet_triangles * 3);
+
+		imported->num_meshlets = num_meshlets;
+		imported->num_meshlet_vertices = num_meshlet_vertices;
+		imported->num_meshlet_triangles = num_meshlet_triangles;
+	}
+
+	// Images referenced by materials decode on the job system while the meshes are processed, every
+	// job decodes one range of one image (see Image::DecodeRange()) and takes the next one in line.
+	struct TextureDecodeItem
+	{
+		u32 texture;
+		u32 range;
+	};
+
+	struct TextureTask
+	{
+		TextureImport* textures;
+		Image::Decoder* decoders; // One per texture.
+		TextureDecodeItem* items;
+		u32 num_textures;
+		u32 num_items;
+
+		u64 scratch_size_per_thread;
+
+		// Per texture, bits of the MaterialSlots that reference it.
+		u32* slot_masks;
+
+		// Per texture, the alpha test reference of the first alpha masked material that uses it as
+		// base color, in texel alpha. Negative if there is none.
+		f32* alpha_cutoffs;
+
+		// Per texture, summed over its ranges.
+		atomic_u32* decode_time_us;
+		atomic_u32* num_failed_ranges;
+
+		Jobs::Counter counter;
+		atomic_u32 next_item;
+		Memory::Arena thread_scratch[Jobs::MAX_THREADS];
+	};
+
+	static void RunTextureDecodeJob(void* user_data)
+	{
+		TextureTask* task = static_cast<TextureTask*>(user_data);
+
+		u32 const item_idx = task->next_item.fetch_add(1, std::memory_order_relaxed);
+		ASSERT(item_idx < task->num_items);
+		TextureDecodeItem const& item = task->items[item_idx];
+
+		// Decoding never waits, so jobs don't nest on a thread's scratch arena.
+		Memory::Arena* scratch = &task->thread_scratch[Jobs::GetThreadIndex()];
+		if (scratch->m_memory_block == nullptr)
+		{
+			Memory::InitArena(scratch, task->scratch_size_per_thread);
+		}
+
+		FrameTimer timer;
+		ResetTimer(timer);
+
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch);
+		bool const b_decoded = Image::DecodeRange(&task->decoders[item.texture], item.range, task->textures[item.texture].surface.pixels, scratch);
+		Memory::RewindTemporaryAlloc(scratch, alloc, false);
+
+		TickTimer(timer);
+		task->decode_time_us[item.texture].fetch_add((u32)(GetTotalTimeS(timer) * 1000000.0f), std::memory_order_relaxed);
+		if (!b_decoded)
+		{
+			task->num_failed_ranges[item.texture].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Finds the encoded bytes of an image: a buffer view (.glb), a data uri, or a file next to the
+	// .gltf that is mapped like the buffers are. Returns false if there are none.
+	static bool ReadImageData(cgltf_image const* image, cgltf_options const* options, char const* gltf_path,
+		Memory::Arena* scratch_memory, u8 const** out_data, u64* out_size)
+	{
+		if (image->buffer_view != nullptr)
+		{
+			cgltf_buffer_view const* view = image->buffer_view;
+			if (view->buffer->data == nullptr)
+			{
+				return false;
+			}
+
+			*out_data = (u8 const*)view->buffer->data + view->offset;
+			*out_size = view->size;
+			return true;
+		}
+
+		char const* uri = image->uri;
+		if (uri == nullptr)
+		{
+			return false;
+		}
+
+		if (strncmp(uri, "data:", 5) == 0)
+		{
+			char const* comma = strchr(uri, ',');
+			if (comma == nullptr || comma - uri < 7 || strncmp(comma - 7, ";base64", 7) != 0)
+			{
+				return false;
+			}
+
+			// Unlike buffers, images don't state their size, every 4 characters hold 3 bytes.
+			char const* base64 = comma + 1;
+			u64 length = strlen(base64);
+			while (length > 0 && base64[length - 1] == '=')
+			{
+				length--;
+			}
+
+			u64 const size = length / 4 * 3 + (length % 4) * 3 / 4;
+			if (size == 0)
+			{
+				return false;
+			}
+
+			u8* data = Memory::PushType<u8>(scratch_memory, (u32)size);
+			if (!Base64::Decode(data, size, base64, length))
+			{
+				return false;
+			}
+
+			*out_data = data;
+			*out_size = size;
+			return true;
+		}
+
+		void* data = nullptr;
+		if (cgltf_load_buffer_file(options, 0, uri, gltf_path, &data) != cgltf_result_success)
+		{
+			return false;
+		}
+
+		// The mapping stays alive until the end of the import, look up its size.
+		MappedFiles const* mapped = static_cast<MappedFiles const*>(options->file.user_data);
+		for (u32 i = 0; i < mapped->files.Size(); ++i)
+		{
+			if (mapped->files[i].data == data)
+			{
+				*out_data = mapped->files[i].data;
+				*out_size = mapped->files[i].size;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static cgltf_texture_view const* GetMaterialTexture(cgltf_material const* material, MaterialSlot::Enum slot)
+	{
+		switch (slot)
+		{
+		case MaterialSlot::BaseColor:
+			return &material->pbr_metallic_roughness.base_color_texture;
+		case MaterialSlot::MetallicRoughness:
+			return &material->pbr_metallic_roughness.metallic_roughness_texture;
+		case MaterialSlot::Normal:
+			return &material->normal_texture;
+		case MaterialSlot::Occlusion:
+			return &material->occlusion_texture;
+		case MaterialSlot::Emissive:
+		default:
+			return &material->emissive_texture;
+		}
+	}
+
+	// Reads the materials into mesh memory. With texture memory, every image they reference becomes a
+	// texture, is opened and gets its pixels allocated here, and then decodes on the job system until
+	// WaitForTextureImport(). Returns null if there is nothing to decode.
+	static TextureTask* BeginTextureImport(cgltf_data const* scene_data, cgltf_options const* options, MeshImport* imported,
+		SceneImporter const* importer)
+	{
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+		u32 const num_materials = (u32)scene_data->materials_count;
+		if (num_materials == 0)
+		{
+			return nullptr;
+		}
+
+		imported->materials = PushSharedType<MaterialImport>(importer, importer->mesh_memory, num_materials);
+		imported->num_materials = num_materials;
+
+		// Images are shared between materials, they map to textures in the order they are first referenced.
+		u32 const num_images = (u32)scene_data->images_count;
+		u32* image_textures = num_images > 0 ? Memory::PushType<u32>(scratch_memory, num_images) : nullptr;
+		u32* texture_images = num_images > 0 ? Memory::PushType<u32>(scratch_memory, num_images) : nullptr;
+		u32* slot_masks = num_images > 0 ? Memory::PushType<u32>(scratch_memory, num_images, Memory::ZeroPush()) : nullptr;
+		f32* alpha_cutoffs = num_images > 0 ? Memory::PushType<f32>(scratch_memory, num_images) : nullptr;
+		for (u32 i = 0; i < num_images; ++i)
+		{
+			image_textures[i] = TEXTURE_NONE;
+			alpha_cutoffs[i] = -1.0f;
+		}
+
+		u32 num_textures = 0;
+		for (u32 material_idx = 0; material_idx < num_materials; ++material_idx)
+		{
+			cgltf_material const* src = &scene_data->materials[material_idx];
+			cgltf_pbr_metallic_roughness const& pbr = src->pbr_metallic_roughness;
+
+			MaterialImport* material = &imported->materials[material_idx];
+			material->base_color_factor = vec4(pbr.base_color_factor[0], pbr.base_color_factor[1], pbr.base_color_factor[2], pbr.base_color_factor[3]);
+			material->emissive_factor = vec3(src->emissive_factor[0], src->emissive_factor[1], src->emissive_factor[2]);
+			material->metallic_factor = pbr.metallic_factor;
+			material->roughness_factor = pbr.roughness_factor;
+
+			for (u32 slot = 0; slot < MaterialSlot::EnumCount; ++slot)
+			{
+				material->textures[slot] = TEXTURE_NONE;
+
+				cgltf_texture const* texture = GetMaterialTexture(src, (MaterialSlot::Enum)slot)->texture;
+				if (importer->texture_memory == nullptr || texture == nullptr || texture->image == nullptr)
+				{
+					continue;
+				}
+
+				u32 const image_idx = (u32)(texture->image - scene_data->images);
+				if (image_textures[image_idx] == TEXTURE_NONE)
+				{
+					texture_images[num_textures] = image_idx;
+					image_textures[image_idx] = num_textures++;
+				}
+
+				u32 const texture_idx = image_textures[image_idx];
+				slot_masks[texture_idx] |= 1u << slot;
+				material->textures[slot] = texture_idx;
+
+				// The test runs on the texel alpha times the factor, so move the reference into texel alpha.
+				if (slot == MaterialSlot::BaseColor && src->alpha_mode == cgltf_alpha_mode_mask && alpha_cutoffs[texture_idx] < 0.0f)
+				{
+					f32 const factor = pbr.base_color_factor[3];
+					alpha_cutoffs[texture_idx] = factor > 0.0f ? Clamp(src->alpha_cutoff / factor, 0.0f, 1.0f) : 1.0f;
+				}
+			}
+		}
+
+		if (num_textures == 0)
+		{
+			return nullptr;
+		}
+
+		imported->textures = PushSharedType<TextureImport>(importer, importer->texture_memory, num_textures, Memory::ZeroPush());
+		imported->num_textures = num_textures;
+
+		TextureTask* task = Memory::PushType<TextureTask>(scratch_memory, 1, Memory::ZeroPush());
+		task->textures = imported->textures;
+		task->decoders = Memory::PushType<Image::Decoder>(scratch_memory, num_textures, Memory::ZeroPush());
+		task->num_textures = num_textures;
+		task->slot_masks = slot_masks;
+		task->alpha_cutoffs = alpha_cutoffs;
+		task->decode_time_us = Memory::PushType<atomic_u32>(scratch_memory, num_textures, Memory::ZeroPush());
+		task->num_failed_ranges = Memory::PushType<atomic_u32>(scratch_memory, num_textures, Memory::ZeroPush());
+
+		// Headers are parsed up front, so the pixels can be allocated before any job runs.
+		u32 num_items = 0;
+		for (u32 texture_idx = 0; texture_idx < num_textures; ++texture_idx)
+		{
+			TextureImport* texture = &imported->textures[texture_idx];
+			texture->format = Gfx::TextureFormat::RGBA8;
+			texture->b_srgb = (slot_masks[texture_idx] & ((1u << MaterialSlot::BaseColor) | (1u << MaterialSlot::Emissive))) != 0;
+
+			cgltf_image const* image = &scene_data->images[texture_images[texture_idx]];
+
+			u8 const* data = nullptr;
+			u64 size = 0;
+			Image::Decoder* decoder = &task->decoders[texture_idx];
+			if (!ReadImageData(image, options, importer->file_path, scratch_memory, &data, &size) || !Image::OpenImage(decoder, data, size, scratch_memory))
+			{
+				char const* name = image->uri ? (strncmp(image->uri, "data:", 5) == 0 ? "data uri" : image->uri) : image->name;
+				UNUSED(name); // Only logged.
+				LOG(Log::IO, "%s: can't open image %u (%s), only PNG and baseline JPEG are supported", importer->file_path,
+					texture_images[texture_idx], name ? name : "unnamed");
+				decoder->num_ranges = 0;
+				continue;
+			}
+
+			texture->surface.width = decoder->width;
+			texture->surface.height = decoder->height;
+			texture->num_levels = (importer->flags & ImportFlags::GenerateMips) ? MipGeneration::GetNumLevels(decoder->width, decoder->height) : 1;
+
+			// Level 0 decodes to the front, the rest of the chain is filled in by GenerateTextureMips().
+			// Pixels that get compressed only need to last until CompressTextures().
+			u64 const pixels_size = MipGeneration::GetChainSize(decoder->width, decoder->height, texture->num_levels);
+			texture->surface.pixels = (importer->flags & ImportFlags::CompressTextures) ?
+				(u8*)Memory::PushSize(scratch_memory, pixels_size) : (u8*)PushShared(importer, importer->texture_memory, pixels_size);
+
+			num_items += decoder->num_ranges;
+			task->scratch_size_per_thread = max(task->scratch_size_per_thread, decoder->scratch_size);
+		}
+
+		if (num_items == 0)
+		{
+			return nullptr;
+		}
+
+		task->items = Memory::PushType<TextureDecodeItem>(scratch_memory, num_items);
+		for (u32 texture_idx = 0; texture_idx < num_textures; ++texture_idx)
+		{
+			for (u32 range = 0; range < task->decoders[texture_idx].num_ranges; ++range)
+			{
+				task->items[task->num_items++] = { texture_idx, range };
+			}
+		}
+
+		// Room for the alignment of every push a decoder makes.
+		task->scratch_size_per_thread += 16 * PLATFORM_DEFAULT_ALIGNMENT;
+
+		static constexpr u32 JOBS_PER_SUBMIT = 64;
+		Jobs::Job jobs[JOBS_PER_SUBMIT];
+		for (Jobs::Job& job : jobs)
+		{
+			job.func = &RunTextureDecodeJob;
+			job.user_data = task;
+		}
+
+		for (u32 submitted = 0; submitted < num_items; submitted += JOBS_PER_SUBMIT)
+		{
+			Jobs::Submit(jobs, min<u32>(num_items - submitted, JOBS_PER_SUBMIT), &task->counter);
+		}
+
+		return task;
+	}
+
+	// Helps out with the remaining decode jobs. Textures that failed to decode lose their pixels.
+	static void WaitForTextureImport(TextureTask* task, char const* file_path)
+	{
+		UNUSED(file_path); // Only logged.
+
+		Jobs::WaitForCounter(&task->counter);
+
+		for (Memory::Arena& scratch : task->thread_scratch)
+		{
+			if (scratch.m_memory_block != nullptr)
+			{
+				Memory::FreeArena(&scratch);
+			}
+		}
+
+		for (u32 texture_idx = 0; texture_idx < task->num_textures; ++texture_idx)
+		{
+			TextureImport* texture = &task->textures[texture_idx];
+			if (texture->surface.pixels == nullptr)
+			{
+				continue;
+			}
+
+			texture->decode_time_ms = task->decode_time_us[texture_idx] / 1000.0f;
+
+			u32 const num_ranges = task->decoders[texture_idx].num_ranges;
+			UNUSED(num_ranges); // Only logged.
+
+			u32 const num_failed = task->num_failed_ranges[texture_idx];
+			if (num_failed > 0)
+			{
+				LOG(Log::IO, "%s: texture %u is corrupt (%u of %u ranges failed)", file_path, texture_idx, num_failed, num_ranges);
+				texture->surface.pixels = nullptr;
+				continue;
+			}
+
+			LOG(Log::IO, "%s: texture %u %ux%u%s decoded in %.2f ms (%u ranges)", file_path, texture_idx, texture->surface.width,
+				texture->surface.height, texture->b_srgb ? " sRGB" : "", texture->decode_time_ms, num_ranges);
+		}
+	}
+
+	// Fills in the lower levels of every decoded texture, color is filtered in linear space.
+	static void GenerateTextureMips(TextureTask const* task, SceneImporter const* importer)
+	{
+		for (u32 texture_idx = 0; texture_idx < task->num_textures; ++texture_idx)
+		{
+			TextureImport* texture = &task->textures[texture_idx];
+			if (texture->surface.pixels == nullptr || texture->num_levels < 2)
+			{
+				continue;
+			}
+
+			FrameTimer timer;
+			ResetTimer(timer);
+
+			MipGeneration::Settings settings;
+			settings.filter = importer->mip_filter;
+			settings.flags = texture->b_srgb ? MipGeneration::MipFlags::SRGB : MipGeneration::MipFlags::None;
+			settings.alpha_cutoff = task->alpha_cutoffs[texture_idx];
+			if (settings.alpha_cutoff >= 0.0f)
+			{
+				settings.flags |= MipGeneration::MipFlags::PreserveAlphaCoverage;
+			}
+
+			Image::Surface levels[BlockCompression::MAX_LEVELS];
+			levels[0] = texture->surface;
+			MipGeneration::Generate(levels, texture->num_levels, settings, importer->scratch_memory);
+
+			TickTimer(timer);
+			texture->mip_time_ms = GetTotalTimeS(timer) * 1000.0f;
+
+			LOG(Log::IO, "%s: texture %u got %u mip levels in %.2f ms%s", importer->file_path, texture_idx, texture->num_levels,
+				texture->mip_time_ms, (settings.flags & MipGeneration::MipFlags::PreserveAlphaCoverage) ? " (alpha coverage)" : "");
+		}
+	}
+
+	// Normal maps go to BC5 and occlusion maps to BC4, everything else to BC7, or BC1/BC3 (with alpha)
+	// at Quality::Fast.
+	static Gfx::TextureFormat::Enum ChooseTextureFormat(TextureImport const* texture, u32 slot_mask, BlockCompression::Quality::Enum quality)
+	{
+		if (slot_mask == (1u << MaterialSlot::Normal))
+		{
+			return Gfx::TextureFormat::BC5;
+		}
+
+		if (slot_mask == (1u << MaterialSlot::Occlusion))
+		{
+			return Gfx::TextureFormat::BC4;
+		}
+
+		if (quality != BlockCompression::Quality::Fast)
+		{
+			return Gfx::TextureFormat::BC7;
+		}
+
+		u8 const* pixels = texture->surface.pixels;
+		u64 const num_pixels = (u64)texture->surface.width * texture->surface.height;
+		for (u64 i = 0; i < num_pixels; ++i)
+		{
+			if (pixels[i * 4 + 3] != 255)
+			{
+				return Gfx::TextureFormat::BC3;
+			}
+		}
+		return Gfx::TextureFormat::BC1;
+	}
+
+	// Moves the decoded textures to texture memory as BCn, rows of blocks are spread over the job system.
+	static void CompressTextures(TextureTask const* task, SceneImporter const* importer)
+	{
+		for (u32 texture_idx = 0; texture_idx < task->num_textures; ++texture_idx)
+		{
+			TextureImport* texture = &task->textures[texture_idx];
+			if (texture->surface.pixels == nullptr)
+			{
+				continue;
+			}
+
+			FrameTimer timer;
+			ResetTimer(timer);
+
+			Gfx::TextureFormat::Enum const format = ChooseTextureFormat(texture, task->slot_masks[texture_idx], importer->texture_quality);
+			texture->format = format;
+
+			// The levels follow each other in the pixels.
+			Image::Surface levels[BlockCompression::MAX_LEVELS];
+			u8* level_pixels = texture->surface.pixels;
+			texture->compressed_size = 0;
+			for (u32 level = 0; level < texture->num_levels; ++level)
+			{
+				levels[level].pixels = level_pixels;
+				levels[level].width = MipGeneration::GetLevelSize(texture->surface.width, level);
+				levels[level].height = MipGeneration::GetLevelSize(texture->surface.height, level);
+				level_pixels += (u64)levels[level].width * levels[level].height * 4;
+				texture->compressed_size += BlockCompression::GetCompressedSize(format, levels[level].width, levels[level].height);
+			}
+
+			texture->compressed_data = (u8*)PushShared(importer, importer->texture_memory, texture->compressed_size);
+			BlockCompression::Compress(texture->compressed_data, levels, texture->num_levels, format, importer->texture_quality);
+			texture->surface.pixels = nullptr;
+
+			TickTimer(timer);
+			texture->compress_time_ms = GetTotalTimeS(timer) * 1000.0f;
+
+			[[maybe_unused]] static char const* const FORMAT_NAMES[Gfx::TextureFormat::EnumCount] = { "RGBA8", "BC1", "BC3", "BC4", "BC5", "BC7" };
+			LOG(Log::IO, "%s: texture %u compressed to %s in %.2f ms", importer->file_path, texture_idx, FORMAT_NAMES[format],
+				texture->compress_time_ms);
+		}
+	}
+
+	// Joints of all skins go into one list, remapped to hierarchy nodes. Skins without inverse bind
+	// matrices use the identity, as glTF specifies.
+	static void ImportSkins(cgltf_data const* scene_data, u32 const* node_remap, MeshImport* imported, SceneImporter const* importer)
+	{
+		if (scene_data->skins_count == 0)
+		{
+			return;
+		}
+
+		u32 num_skin_joints = 0;
+		for (u64 skin_idx = 0; skin_idx < scene_data->skins_count; ++skin_idx)
+		{
+			num_skin_joints += (u32)scene_data->skins[skin_idx].joints_count;
+		}
+
+		imported->num_skins = (u32)scene_data->skins_count;
+		imported->num_skin_joints = num_skin_joints;
+		imported->skins = PushSharedType<SkinImport>(importer, importer->scene_memory, imported->num_skins);
+		imported->skin_joints = PushSharedType<u32>(importer, importer->scene_memory, num_skin_joints);
+		imported->inverse_bind_matrices = PushSharedType<mat34>(importer, importer->scene_memory, num_skin_joints);
+
+		u32 first_joint = 0;
+		for (u64 skin_idx = 0; skin_idx < scene_data->skins_count; ++skin_idx)
+		{
+			cgltf_skin const* skin = &scene_data->skins[skin_idx];
+			u32 const num_joints = (u32)skin->joints_count;
+
+			SkinImport& dst = imported->skins[skin_idx];
+			dst.first_joint = first_joint;
+			dst.num_joints = num_joints;
+
+			for (u32 joint_idx = 0; joint_idx < num_joints; ++joint_idx)
+			{
+				imported->skin_joints[first_joint + joint_idx] = node_remap[skin->joints[joint_idx] - scene_data->nodes];
+				imported->inverse_bind_matrices[first_joint + joint_idx] = mat34::Identity();
+			}
+
+			cgltf_accessor* accessor = skin->inverse_bind_matrices;
+			if (accessor != nullptr && accessor->type == cgltf_type_mat4 && accessor->component_type == cgltf_component_type_r_32f &&
+				accessor->count >= num_joints)
+			{
+				Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(importer->scratch_memory);
+				ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(importer->scratch_memory, alloc, false));
+
+				// Column major, same as mat44.
+				mat44* matrices = Memory::PushType<mat44>(importer->scratch_memory, (u32)accessor->count);
+				CopyBuffer((u8*)matrices, sizeof(mat44) * accessor->count, cgltf_type_mat4, cgltf_component_type_r_32f, accessor);
+
+				for (u32 joint_idx = 0; joint_idx < num_joints; ++joint_idx)
+				{
+					imported->inverse_bind_matrices[first_joint + joint_idx] = ChangeBasis(Math::ToMat34(matrices[joint_idx]));
+				}
+			}
+
+			first_joint += num_joints;
+		}
+	}
+
+	// Linear keys per cubic spline segment, key removal drops the ones a line covers anyway.
+	static constexpr u32 CUBIC_SPLINE_SUBDIVISIONS = 8;
+
+	// Node transform channels only, morph target weights are not animated.
+	static bool IsSupportedChannel(cgltf_animation_channel const* channel)
+	{
+		if (channel->target_node == nullptr || channel->sampler == nullptr)
+		{
+			return false;
+		}
+
+		cgltf_type value_type;
+		switch (channel->target_path)
+		{
+		case cgltf_animation_path_type_translation:
+		case cgltf_animation_path_type_scale:
+			value_type = cgltf_type_vec3;
+			break;
+		case cgltf_animation_path_type_rotation:
+			value_type = cgltf_type_vec4;
+			break;
+		default:
+			return false;
+		}
+
+		cgltf_animation_sampler const* sampler = channel->sampler;
+		u64 const values_per_key = (sampler->interpolation == cgltf_interpolation_type_cubic_spline) ? 3 : 1;
+		return sampler->input != nullptr && sampler->output != nullptr && sampler->input->count > 0 &&
+			sampler->input->type == cgltf_type_scalar && sampler->output->type == value_type &&
+			sampler->output->count == sampler->input->count * values_per_key;
+	}
+
+	static u32 GetLinearKeyCount(cgltf_animation_sampler const* sampler)
+	{
+		u32 const num_keys = (u32)sampler->input->count;
+		switch (sampler->interpolation)
+		{
+		case cgltf_interpolation_type_step:
+			return 2 * num_keys - 1;
+		case cgltf_interpolation_type_cubic_spline:
+			return (num_keys - 1) * CUBIC_SPLINE_SUBDIVISIONS + 1;
+		default:
+			return num_keys;
+		}
+	}
+
+	static vec4 ReadChannelValue(f32 const* values, bool b_rotation, u32 idx)
+	{
+		if (b_rotation)
+		{
+			f32 const* v = values + idx * 4;
+			return vec4(v[0], v[1], v[2], v[3]);
+		}
+
+		f32 const* v = values + idx * 3;
+		return vec4(v[0], v[1], v[2], 0.0f);
+	}
+
+	// Converts the keys of a channel to linear keys in engine space. Steps hold their value until a tick
+	// before the next key, cubic splines are sampled.
+	static void ReadAnimationChannel(f32* out_times, vec4* out_values, cgltf_animation_channel const* channel, f32 duration,
+		Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		cgltf_animation_sampler const* sampler = channel->sampler;
+		bool const b_rotation = channel->target_path == cgltf_animation_path_type_rotation;
+		u32 const num_components = b_rotation ? 4 : 3;
+		u32 const num_keys = (u32)sampler->input->count;
+		u32 const num_values = (u32)sampler->output->count;
+
+		f32* times = Memory::PushType<f32>(scratch_memory, num_keys);
+		CopyBuffer((u8*)times, sizeof(f32) * num_keys, cgltf_type_scalar, cgltf_component_type_r_32f, sampler->input);
+
+		// Mirroring z negates the z translation and the x and y rotation axis, tangents transform the same way.
+		u32 const negate_mask = b_rotation ? (1u << 0) | (1u << 1) : (channel->target_path == cgltf_animation_path_type_translation) ? BASIS_CHANGE_MASK : 0;
+		f32* values = Memory::PushType<f32>(scratch_memory, num_values * num_components);
+		CopyBuffer((u8*)values, sizeof(f32) * num_values * num_components, sampler->output->type, cgltf_component_type_r_32f, sampler->output,
+			nullptr, 0, negate_mask);
+
+		u32 num_out = 0;
+		switch (sampler->interpolation)
+		{
+		case cgltf_interpolation_type_step:
+		{
+			f32 const tick = duration / (f32)Animation::MAX_TICK;
+			for (u32 i = 0; i < num_keys; ++i)
+			{
+				out_times[num_out] = times[i];
+				out_values[num_out++] = ReadChannelValue(values, b_rotation, i);
+				if (i + 1 < num_keys)
+				{
+					out_times[num_out] = max(times[i], times[i + 1] - tick);
+					out_values[num_out++] = ReadChannelValue(values, b_rotation, i);
+				}
+			}
+			break;
+		}
+		case cgltf_interpolation_type_cubic_spline:
+		{
+			// Hermite segments, every key has an in-tangent, the value and an out-tangent.
+			for (u32 i = 0; i + 1 < num_keys; ++i)
+			{
+				f32 const dt = times[i + 1] - times[i];
+				vec4 const v0 = ReadChannelValue(values, b_rotation, 3 * i + 1);
+				vec4 const b0 = ReadChannelValue(values, b_rotation, 3 * i + 2);
+				vec4 const a1 = ReadChannelValue(values, b_rotation, 3 * (i + 1));
+				vec4 const v1 = ReadChannelValue(values, b_rotation, 3 * (i + 1) + 1);
+
+				for (u32 j = 0; j < CUBIC_SPLINE_SUBDIVISIONS; ++j)
+				{
+					f32 const t = (f32)j / (f32)CUBIC_SPLINE_SUBDIVISIONS;
+					f32 const t2 = t * t;
+					f32 const t3 = t2 * t;
+					f32 const h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+					f32 const h10 = (t3 - 2.0f * t2 + t) * dt;
+					f32 const h01 = -2.0f * t3 + 3.0f * t2;
+					f32 const h11 = (t3 - t2) * dt;
+
+					vec4 value;
+					for (u32 c = 0; c < 4; ++c)
+					{
+						value.data[c] = h00 * v0.data[c] + h10 * b0.data[c] + h01 * v1.data[c] + h11 * a1.data[c];
+					}
+
+					out_times[num_out] = times[i] + t * dt;
+					out_values[num_out++] = value;
+				}
+			}
+
+			out_times[num_out] = times[num_keys - 1];
+			out_values[num_out++] = ReadChannelValue(values, b_rotation, 3 * (num_keys - 1) + 1);
+			break;
+		}
+		default:
+			for (u32 i = 0; i < num_keys; ++i)
+			{
+				out_times[num_out] = times[i];
+				out_values[num_out++] = ReadChannelValue(values, b_rotation, i);
+			}
+			break;
+		}
+
+		ASSERT(num_out == GetLinearKeyCount(sampler));
+
+		if (b_rotation)
+		{
+			for (u32 i = 0; i < num_out; ++i)
+			{
+				vec4& q = out_values[i];
+				f32 const length_sq = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+				f32 const inv_length = (length_sq > 0.0f) ? 1.0f / sqrtf(length_sq) : 0.0f;
+				q = (length_sq > 0.0f) ? vec4(q.x * inv_length, q.y * inv_length, q.z * inv_length, q.w * inv_length) : vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	// Every glTF animation becomes a clip, its channels become compressed tracks on hierarchy nodes.
+	static void ImportAnimations(cgltf_data const* scene_data, u32 const* node_remap, MeshImport* imported, SceneImporter const* importer)
+	{
+		if (scene_data->animations_count == 0)
+		{
+			return;
+		}
+
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 max_tracks = 0;
+		u32 max_keys = 0;
+		u32 max_channel_keys = 0;
+		for (u64 anim_idx = 0; anim_idx < scene_data->animations_count; ++anim_idx)
+		{
+			cgltf_animation const* anim = &scene_data->animations[anim_idx];
+			for (u64 channel_idx = 0; channel_idx < anim->channels_count; ++channel_idx)
+			{
+				cgltf_animation_channel const* channel = &anim->channels[channel_idx];
+				if (IsSupportedChannel(channel))
+				{
+					u32 const num_keys = GetLinearKeyCount(channel->sampler);
+					max_tracks++;
+					max_keys += num_keys;
+					max_channel_keys = max(max_channel_keys, num_keys);
+				}
+			}
+		}
+
+		u32 const num_clips = (u32)scene_data->animations_count;
+		Animation::Clip* clips = Memory::PushType<Animation::Clip>(scratch_memory, num_clips);
+		Animation::Track* tracks = Memory::PushType<Animation::Track>(scratch_memory, max_tracks);
+		u16* key_times = Memory::PushType<u16>(scratch_memory, max_keys);
+		Animation::Key* keys = Memory::PushType<Animation::Key>(scratch_memory, max_keys);
+		f32* source_times = Memory::PushType<f32>(scratch_memory, max_channel_keys);
+		vec4* source_values = Memory::PushType<vec4>(scratch_memory, max_channel_keys);
+
+		u32 num_tracks = 0;
+		u32 num_keys = 0;
+		for (u64 anim_idx = 0; anim_idx < scene_data->animations_count; ++anim_idx)
+		{
+			cgltf_animation const* anim = &scene_data->animations[anim_idx];
+
+			f32 duration = 0.0f;
+			for (u64 channel_idx = 0; channel_idx < anim->channels_count; ++channel_idx)
+			{
+				cgltf_animation_channel const* channel = &anim->channels[channel_idx];
+				if (IsSupportedChannel(channel))
+				{
+					f32 end_time = 0.0f;
+					cgltf_accessor_read_float(channel->sampler->input, channel->sampler->input->count - 1, &end_time, 1);
+					duration = max(duration, end_time);
+				}
+			}
+
+			Animation::Clip& clip = clips[anim_idx];
+			clip.duration = duration;
+			clip.first_track = num_tracks;
+			clip.num_tracks = 0;
+
+			for (u64 channel_idx = 0; channel_idx < anim->channels_count; ++channel_idx)
+			{
+				cgltf_animation_channel const* channel = &anim->channels[channel_idx];
+				if (!IsSupportedChannel(channel))
+				{
+					LOG(Log::IO, "%s: animation %u channel %u is skipped", importer->file_path, (u32)anim_idx, (u32)channel_idx);
+					continue;
+				}
+
+				ReadAnimationChannel(source_times, source_values, channel, duration, scratch_memory);
+
+				Animation::SourceTrack source;
+				source.times = source_times;
+				source.values = source_values;
+				source.num_keys = GetLinearKeyCount(channel->sampler);
+				source.node = node_remap[channel->target_node - scene_data->nodes];
+				source.type = (channel->target_path == cgltf_animation_path_type_translation) ? Animation::TrackType::Translation :
+					(channel->target_path == cgltf_animation_path_type_rotation) ? Animation::TrackType::Rotation : Animation::TrackType::Scale;
+
+				Animation::Track* track = &tracks[num_tracks++];
+				u32 const num_track_keys = Animation::CompressTrack(track, key_times + num_keys, keys + num_keys, source, duration,
+					importer->animation_tolerances, scratch_memory);
+				track->first_key = num_keys;
+				num_keys += num_track_keys;
+				clip.num_tracks++;
+			}
+		}
+
+		Animation::ClipLibrary& library = imported->animations;
+		library.num_clips = num_clips;
+		library.num_tracks = num_tracks;
+		library.num_keys = num_keys;
+		library.clips = PushSharedType<Animation::Clip>(importer, importer->scene_memory, num_clips);
+		library.tracks = PushSharedType<Animation::Track>(importer, importer->scene_memory, num_tracks, Memory::AlignPush(16));
+		library.key_times = PushSharedType<u16>(importer, importer->scene_memory, num_keys);
+		library.keys = PushSharedType<Animation::Key>(importer, importer->scene_memory, num_keys);
+
+		memcpy(library.clips, clips, sizeof(Animation::Clip) * num_clips);
+		memcpy(library.tracks, tracks, sizeof(Animation::Track) * num_tracks);
+		memcpy(library.key_times, key_times, sizeof(u16) * num_keys);
+		memcpy(library.keys, keys, sizeof(Animation::Key) * num_keys);
+
+		LOG(Log::IO, "%s: %u clips, %u tracks, %u -> %u keys", importer->file_path, num_clips, num_tracks, max_keys, num_keys);
+	}
+
+	// The skinning kernels read the matrices of all 4 joints of a vertex, zero weights included, so every
+	// joint index the instance's vertices use has to be in range.
+	static bool CanSkinInstance(MeshImport const* imported, Gfx::MeshInstance const& instance, u32 num_joints)
+	{
+		if (imported->joint_buffer == nullptr)
+		{
+			return false;
+		}
+
+		for (u32 submesh_idx = instance.first_submesh; submesh_idx < instance.first_submesh + instance.num_submeshes; ++submesh_idx)
+		{
+			Gfx::Joints_t const* joints = imported->joint_buffer + imported->submeshes[submesh_idx].base_vertex_location;
+			u32 const num_vertices = GetSubMeshVertexCount(imported, submesh_idx);
+
+			u32 max_joint = 0;
+			for (u32 i = 0; i < num_vertices; ++i)
+			{
+				max_joint = max(max_joint, (u32)max(max(joints[i].index[0], joints[i].index[1]), max(joints[i].index[2], joints[i].index[3])));
+			}
+
+			if (max_joint >= num_joints)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Meshes need at least this many rigid nodes to be batched with ImportFlags::InstanceMeshes.
+	static constexpr u32 MIN_INSTANCE_BATCH_NODES = 2;
+
+	static constexpr u32 BATCH_NONE = ~0u;
+
+	// Attributes of a node's EXT_mesh_gpu_instancing extension, missing ones are null.
+	struct GpuInstancing
+	{
+		cgltf_accessor const* translation;
+		cgltf_accessor const* rotation;
+		cgltf_accessor const* scale;
+		u32 count;
+	};
+
+	static cgltf_accessor const* FindInstancingAttribute(cgltf_data const* scene_data, char const* json, Json::Token const* tokens,
+		s32 num_tokens, s32 attributes, char const* name, cgltf_type type)
+	{
+		s32 const value = Json::FindValue(json, tokens, num_tokens, attributes, name);
+		if (value < 0 || tokens[value].type != Json::TokenType::Primitive)
+		{
+			return nullptr;
+		}
+
+		// The primitive is followed by a delimiter, strtoul stops there.
+		u64 const accessor_idx = strtoul(json + tokens[value].start, nullptr, 10);
+		if (accessor_idx >= scene_data->accessors_count || scene_data->accessors[accessor_idx].type != type)
+		{
+			return nullptr;
+		}
+
+		return &scene_data->accessors[accessor_idx];
+	}
+
+	// cgltf keeps extensions it doesn't know as raw JSON. Returns false if the node has no usable instancing,
+	// every attribute it has needs the same number of elements.
+	static bool ReadGpuInstancing(cgltf_data const* scene_data, cgltf_node const* node, GpuInstancing* out_instancing, SceneImporter const* importer)
+	{
+		MemZeroSafe(out_instancing);
+
+		cgltf_extension const* extension = nullptr;
+		for (u64 ext_idx = 0; ext_idx < node->extensions_count; ++ext_idx)
+		{
+			if (strcmp(node->extensions[ext_idx].name, "EXT_mesh_gpu_instancing") == 0)
+			{
+				extension = &node->extensions[ext_idx];
+				break;
+			}
+		}
+
+		if (extension == nullptr)
+		{
+			return false;
+		}
+
+		Memory::Arena* scratch_memory = importer->scratch_memory;
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		char const* json = extension->data;
+		u64 const length = strlen(json);
+		s32 const num_tokens = Json::Tokenize(json, length, nullptr, 0);
+		Json::Token* tokens = num_tokens > 0 ? Memory::PushType<Json::Token>(scratch_memory, (u32)num_tokens) : nullptr;
+
+		s32 const attributes = (num_tokens > 0 && Json::Tokenize(json, length, tokens, num_tokens) == num_tokens) ?
+			Json::FindValue(json, tokens, num_tokens, 0, "attributes") : -1;
+		if (attributes >= 0)
+		{
+			out_instancing->translation = FindInstancingAttribute(scene_data, json, tokens, num_tokens, attributes, "TRANSLATION", cgltf_type_vec3);
+			out_instancing->rotation = FindInstancingAttribute(scene_data, json, tokens, num_tokens, attributes, "ROTATION", cgltf_type_vec4);
+			out_instancing->scale = FindInstancingAttribute(scene_data, json, tokens, num_tokens, attributes, "SCALE", cgltf_type_vec3);
+		}
+
+		cgltf_accessor const* accessors[] = { out_instancing->translation, out_instancing->rotation, out_instancing->scale };
+		u64 count = 0;
+		bool b_valid = true;
+		for (cgltf_accessor const* accessor : accessors)
+		{
+			if (accessor != nullptr)
+			{
+				b_valid &= count == 0 || accessor->count == count;
+				count = accessor->count;
+			}
+		}
+
+		if (!b_valid || count == 0 || count > UINT32_MAX)
+		{
+			LOG(Log::IO, "%s: node %u has invalid EXT_mesh_gpu_instancing attributes, it is drawn once", importer->file_path,
+				(u32)(node - scene_data->nodes));
+			MemZeroSafe(out_instancing);
+			return false;
+		}
+
+		out_instancing->count = (u32)count;
+		return true;
+	}
+
+	// Instance transforms are relative to the node, in engine space like node transforms.
+	static void ReadGpuInstanceTransforms(GpuInstancing const& instancing, mat34* out_transforms, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 const count = instancing.count;
+		vec3* translations = Memory::PushType<vec3>(scratch_memory, count);
+		quat* rotations = Memory::PushType<quat>(scratch_memory, count);
+		vec3* scales = Memory::PushType<vec3>(scratch_memory, count);
+
+		// Normalized integer rotations and scales are unpacked to floats.
+		bool const b_translation = instancing.translation != nullptr &&
+			cgltf_accessor_unpack_floats(instancing.translation, translations->data, (u64)count * 3) == (u64)count * 3;
+		bool const b_rotation = instancing.rotation != nullptr &&
+			cgltf_accessor_unpack_floats(instancing.rotation, rotations->data, (u64)count * 4) == (u64)count * 4;
+		bool const b_scale = instancing.scale != nullptr &&
+			cgltf_accessor_unpack_floats(instancing.scale, scales->data, (u64)count * 3) == (u64)count * 3;
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			Scene::Transform local = Scene::IdentityTransform();
+			if (b_translation)
+			{
+				local.translation = translations[i];
+			}
+			if (b_rotation)
+			{
+				local.rotation = rotations[i];
+			}
+			if (b_scale)
+			{
+				local.scale = scales[i];
+			}
+
+			local = ChangeBasis(local);
+			out_transforms[i] = Math::TRS<mat34>(local.translation, local.rotation, local.scale);
+		}
+	}
+
+	// Imports every mesh of the file into one set of vertex and index streams, each primitive
+	// becomes a submesh. Every node that references a mesh becomes a Gfx::MeshInstance, or part
+	// of the Gfx::InstanceBatch of the mesh.
+	static MeshImport Import(SceneImporter* importer)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(importer->scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(importer->scratch_memory, alloc, false));
+
+		MeshImport imported;
+		MemZeroSafe(imported);
+
+		FrameTimer import_timer;
+		ResetTimer(import_timer);
+
+		MappedFiles mapped_files;
+		ON_SCOPE_EXIT(UnmapAllFiles(&mapped_files));
+
+		cgltf_options options;
+		MemZeroSafe(options);
+
+		struct Local
+		{
+			static void* AllocFromArena(void* user, u64 size)
+			{
+				Memory::Arena* arena = static_cast<Memory::Arena*>(user);
+				return Memory::PushSize(arena, size);
+			}
+
+			static void FreeFromArena(void* user, void* data)
+			{
+				// The scratch arena is rewound as a whole.
+				UNUSED(user);
+				UNUSED(data);
+			};
+		};
+
+		options.memory.alloc = &Local::AllocFromArena;
+		options.memory.free = &Local::FreeFromArena;
+		options.memory.user_data = importer->scratch_memory;
+		options.file.read = &MapFileForCgltf;
+		options.file.release = &ReleaseFileForCgltf;
+		options.file.user_data = &mapped_files;
+
+		cgltf_data* scene_data;
+		cgltf_result result = cgltf_parse_file(&options, importer->file_path, &scene_data);
+		if (result != cgltf_result_success)
+		{
+			ASSERT_FAIL_F("Failed to parse %s!", importer->file_path);
+			return imported;
+		}
+
+		// A missing or corrupt buffer leaves nothing to import, like a file that doesn't parse.
+		cgltf_result buffer_result = DecodeDataUris(scene_data, importer->scratch_memory);
+		if (buffer_result == cgltf_result_success)
+		{
+			buffer_result = cgltf_load_buffers(&options, scene_data, importer->file_path);
+		}
+		if (buffer_result != cgltf_result_success)
+		{
+			ASSERT_FAIL_F("Failed to load the buffers of %s!", importer->file_path);
+			cgltf_free(scene_data);
+			return imported;
+		}
+
+		// Textures decode in the background from here on.
+		TextureTask* texture_task = BeginTextureImport(scene_data, &options, &imported, importer);
+
+		ImportSizes const sizes = CalculateImportSizes(scene_data, importer->flags, importer->scratch_memory);
+		ASSERT_F(sizes.num_submeshes > 0, "Scene does not contain a mesh!");
+
+		Memory::Arena* mesh_memory = importer->mesh_memory;
+
+		// When compressing, the float streams are only an intermediate.
+		bool const compress_streams = (importer->flags & ImportFlags::CompressVertexStreams) != 0;
+		Memory::Arena* vertex_memory = compress_streams ? importer->scratch_memory : mesh_memory;
+		imported.flags = importer->flags;
+
+		InterleavedLayout interleaved_layout;
+		// Generated attributes have no place in the source vertices.
+		bool const keep_interleaved = (importer->flags & ImportFlags::KeepInterleavedStreams) && !compress_streams &&
+			!sizes.b_has_generated_attributes && CanKeepInterleaved(scene_data, &interleaved_layout);
+		if (!keep_interleaved)
+		{
+			imported.flags &= ~ImportFlags::KeepInterleavedStreams;
+		}
+
+		imported.num_vertices = (u32)sizes.num_vertices;
+		imported.num_indices = (u32)sizes.num_indices;
+
+		// With LODs the index buffer size is only known at the end, see GenerateLods().
+		bool const generate_lods = (importer->flags & ImportFlags::GenerateLods) != 0;
+		if (generate_lods)
+		{
+			imported.index_buffer = Memory::PushType<Gfx::Index_t>(importer->scratch_memory, imported.num_indices);
+		}
+		else
+		{
+			imported.index_buffer = PushSharedType<Gfx::Index_t>(importer, mesh_memory, imported.num_indices);
+		}
+
+		imported.submeshes = PushSharedType<Gfx::SubMesh>(importer, mesh_memory, sizes.num_submeshes, Memory::ZeroPush());
+		imported.submesh_materials = PushSharedType<u32>(importer, mesh_memory, sizes.num_submeshes);
+
+		if (keep_interleaved)
+		{
+			u64 const buffer_size = (u64)interleaved_layout.stride * sizes.num_vertices;
+			imported.interleaved_buffer = (u8*)PushShared(importer, mesh_memory, buffer_size, Memory::ZeroAndAlignPush(alignof(f32)));
+			imported.interleaved_stride = interleaved_layout.stride;
+			memcpy(imported.interleaved_offsets, interleaved_layout.offsets, sizeof(imported.interleaved_offsets));
+		}
+		else
+		{
+			imported.position_buffer = PushSharedType<Gfx::Position_t>(importer, vertex_memory, imported.num_vertices, Memory::AlignPush(alignof(Gfx::Position_t)));
+			if (sizes.b_has_normals)
+			{
+				imported.normal_buffer = PushSharedType<Gfx::Normal_t>(importer, vertex_memory, imported.num_vertices, Memory::ZeroAndAlignPush(alignof(Gfx::Normal_t)));
+			}
+			if (sizes.b_has_texcoords)
+			{
+				imported.texcoord_buffer = PushSharedType<Gfx::TexCoord_t>(importer, vertex_memory, imported.num_vertices, Memory::ZeroAndAlignPush(alignof(Gfx::TexCoord_t)));
+			}
+			if (sizes.b_has_tangents)
+			{
+				imported.tangent_buffer = PushSharedType<Gfx::Tangent_t>(importer, vertex_memory, imported.num_vertices, Memory::ZeroAndAlignPush(alignof(Gfx::Tangent_t)));
+			}
+		}
+
+		// Joints and weights are never interleaved (see GetInterleavedAttribType), and stay uncompressed.
+		if (sizes.b_has_skin)
+		{
+			imported.joint_buffer = PushSharedType<Gfx::Joints_t>(importer, mesh_memory, imported.num_vertices, Memory::ZeroAndAlignPush(alignof(Gfx::Joints_t)));
+			imported.weight_buffer = PushSharedType<Gfx::Weights_t>(importer, mesh_memory, imported.num_vertices, Memory::ZeroAndAlignPush(alignof(Gfx::Weights_t)));
+		}
+
+		// Submeshes of a mesh are contiguous, remember where each mesh starts for the instances.
+		u32* mesh_first_submesh = Memory::PushType<u32>(importer->scratch_memory, (u32)scene_data->meshes_count);
+		u32* mesh_num_submeshes = Memory::PushType<u32>(importer->scratch_memory, (u32)scene_data->meshes_count);
+
+		// Morph targets are gathered by the primitive vertex each imported vertex came from.
+		u32* source_vertices = sizes.b_has_morph_targets ? Memory::PushType<u32>(importer->scratch_memory, imported.num_vertices) : nullptr;
+
+		bool const optimize_vertex_order = (importer->flags & ImportFlags::OptimizeVertexOrder) != 0;
+		MeshOpt::VertexCacheStats stats_before;
+		MeshOpt::VertexCacheStats stats_after;
+		MemZeroSafe(stats_before);
+		MemZeroSafe(stats_after);
+
+		u32 base_vertex = 0;
+		u32 first_index = 0;
+		u32 primitive = 0;
+		for (u64 mesh_idx = 0; mesh_idx < scene_data->meshes_count; ++mesh_idx)
+		{
+			cgltf_mesh const* mesh = &scene_data->meshes[mesh_idx];
+			mesh_first_submesh[mesh_idx] = imported.num_submeshes;
+
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				cgltf_primitive const* prim = &mesh->primitives[prim_idx];
+				if (!IsImportable(prim))
+				{
+					continue;
+				}
+
+				// Primitives with more vertices than 16 bit indices can address become several submeshes.
+				PrimitiveLayout const* layout = &sizes.primitives[primitive++];
+				for (u32 chunk_idx = 0; chunk_idx < layout->num_chunks; ++chunk_idx)
+				{
+					MeshOpt::IndexChunk const& chunk = layout->chunks[chunk_idx];
+					u32 const num_vertices = chunk.num_vertices;
+					u32 const num_indices = chunk.num_indices;
+					u32 const* src_vertices = layout->chunk_vertices + chunk.first_vertex;
+
+					imported.submesh_materials[imported.num_submeshes] = prim->material ? (u32)(prim->material - scene_data->materials) : MATERIAL_NONE;
+					Gfx::SubMesh* submesh = &imported.submeshes[imported.num_submeshes++];
+					submesh->num_indices = num_indices;
+					submesh->first_index_location = first_index;
+					submesh->base_vertex_location = base_vertex;
+
+					StreamCopy::CopyFlippedWinding(imported.index_buffer + first_index, layout->chunk_indices + chunk.first_index, num_indices);
+
+					if (source_vertices != nullptr)
+					{
+						memcpy(source_vertices + base_vertex, src_vertices, sizeof(u32) * num_vertices);
+					}
+
+					if (keep_interleaved)
+					{
+						ImportInterleaved(prim, &imported, base_vertex, src_vertices, num_vertices);
+					}
+					else
+					{
+						ImportStreams(prim, layout, &imported, base_vertex, src_vertices, num_vertices);
+					}
+
+					if (optimize_vertex_order)
+					{
+						OptimizeSubMesh(&imported, submesh, num_vertices, &stats_before, &stats_after,
+							source_vertices ? source_vertices + base_vertex : nullptr, importer->scratch_memory);
+					}
+
+					ComputeSubMeshBounds(&imported, submesh, num_vertices, importer->scratch_memory);
+
+					base_vertex += num_vertices;
+					first_index += num_indices;
+				}
+			}
+
+			mesh_num_submeshes[mesh_idx] = imported.num_submeshes - mesh_first_submesh[mesh_idx];
+		}
+
+		ASSERT(imported.num_submeshes == sizes.num_submeshes);
+		ASSERT(base_vertex == imported.num_vertices && first_index == imported.num_indices);
+
+		u32* mesh_morph_sets = Memory::PushType<u32>(importer->scratch_memory, (u32)scene_data->meshes_count);
+		ImportMorphTargets(scene_data, sizes.primitives, source_vertices, mesh_first_submesh, mesh_num_submeshes, mesh_morph_sets, &imported, importer);
+
+		imported.bounds = imported.submeshes[0].aabb;
+		imported.bounding_sphere = imported.submeshes[0].bounding_sphere;
+		for (u32 i = 1; i < imported.num_submeshes; ++i)
+		{
+			imported.bounds = Bounds::Merge(imported.bounds, imported.submeshes[i].aabb);
+			imported.bounding_sphere = Bounds::Merge(imported.bounding_sphere, imported.submeshes[i].bounding_sphere);
+		}
+
+		if (importer->flags & ImportFlags::WeldVertices)
+		{
+			LOG(Log::IO, "%s welded %u -> %u vertices", importer->file_path, (u32)sizes.num_source_vertices, imported.num_vertices);
+		}
+
+#ifdef _DEBUG
+		if (optimize_vertex_order && imported.num_indices > 0)
+		{
+			f32 const num_triangles = (f32)(imported.num_indices / 3);
+			LOG(Log::IO, "%s vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", importer->file_path,
+				stats_before.vertices_transformed / num_triangles, stats_after.vertices_transformed / num_triangles,
+				stats_before.vertices_transformed / (f32)imported.num_vertices, stats_after.vertices_transformed / (f32)imported.num_vertices);
+		}
+#endif
+
+		// Before compression, meshlet bounds are built from the float positions.
+		if (importer->flags & ImportFlags::BuildMeshlets)
+		{
+			BuildMeshlets(&imported, importer);
+		}
+
+		if (generate_lods)
+		{
+			GenerateLods(&imported, importer);
+		}
+
+		if (compress_streams)
+		{
+			CompressVertexStreams(&imported, importer);
+		}
+
+		if (importer->scene_memory != nullptr)
+		{
+			u32* node_remap = Memory::PushType<u32>(importer->scratch_memory, (u32)scene_data->nodes_count);
+
+			// BuildHierarchy uses scene memory for temporaries as well, so the lock is held throughout.
+			{
+				std::unique_lock<std::mutex> lock;
+				if (importer->shared_memory_lock != nullptr)
+				{
+					lock = std::unique_lock<std::mutex>(*importer->shared_memory_lock);
+				}
+
+				ImportHierarchy(scene_data, importer->scene_memory, importer->scratch_memory, &imported.hierarchy, node_remap);
+				imported.instances = Memory::PushType<Gfx::MeshInstance>(importer->scene_memory, (u32)scene_data->nodes_count);
+			}
+
+			ImportSkins(scene_data, node_remap, &imported, importer);
+			ImportAnimations(scene_data, node_remap, &imported, importer);
+
+			// Batches are per mesh. Nodes with instancing attributes always get one, rigid nodes join if their mesh is
+			// referenced often enough or has a batch anyway.
+			u32 const num_meshes = (u32)scene_data->meshes_count;
+			bool const b_instance_meshes = (importer->flags & ImportFlags::InstanceMeshes) != 0;
+			GpuInstancing* node_instancing = Memory::PushType<GpuInstancing>(importer->scratch_memory, (u32)scene_data->nodes_count);
+			u32* mesh_rigid_nodes = Memory::PushType<u32>(importer->scratch_memory, num_meshes, Memory::ZeroPush());
+			u32* mesh_batch_sizes = Memory::PushType<u32>(importer->scratch_memory, num_meshes, Memory::ZeroPush());
+			u32* mesh_batches = Memory::PushType<u32>(importer->scratch_memory, num_meshes);
+
+			for (u64 node_idx = 0; node_idx < scene_data->nodes_count; ++node_idx)
+			{
+				cgltf_node const* node = &scene_data->nodes[node_idx];
+				MemZeroSafe(node_instancing[node_idx]);
+				if (node->mesh == nullptr)
+				{
+					continue;
+				}
+
+				u64 const mesh_idx = node->mesh - scene_data->meshes;
+				if (mesh_num_submeshes[mesh_idx] == 0)
+				{
+					continue;
+				}
+
+				if (ReadGpuInstancing(scene_data, node, &node_instancing[node_idx], importer))
+				{
+					mesh_batch_sizes[mesh_idx] += node_instancing[node_idx].count;
+				}
+				else if (node->skin == nullptr && mesh_morph_sets[mesh_idx] == Gfx::MORPH_NONE)
+				{
+					mesh_rigid_nodes[mesh_idx]++;
+				}
+			}
+
+			u32 num_batch_instances = 0;
+			for (u32 mesh_idx = 0; mesh_idx < num_meshes; ++mesh_idx)
+			{
+				if (b_instance_meshes && (mesh_rigid_nodes[mesh_idx] >= MIN_INSTANCE_BATCH_NODES || mesh_batch_sizes[mesh_idx] > 0))
+				{
+					mesh_batch_sizes[mesh_idx] += mesh_rigid_nodes[mesh_idx];
+				}
+				else
+				{
+					mesh_rigid_nodes[mesh_idx] = 0;
+				}
+
+				mesh_batches[mesh_idx] = BATCH_NONE;
+				if (mesh_batch_sizes[mesh_idx] > 0)
+				{
+					mesh_batches[mesh_idx] = imported.num_instance_batches++;
+					num_batch_instances += mesh_batch_sizes[mesh_idx];
+				}
+			}
+
+			if (imported.num_instance_batches > 0)
+			{
+				imported.instance_batches = PushSharedType<Gfx::InstanceBatch>(importer, importer->scene_memory, imported.num_instance_batches);
+				imported.batch_instance_nodes = PushSharedType<u32>(importer, importer->scene_memory, num_batch_instances);
+				imported.batch_instance_transforms = PushSharedType<mat34>(importer, importer->scene_memory, num_batch_instances);
+
+				for (u32 mesh_idx = 0; mesh_idx < num_meshes; ++mesh_idx)
+				{
+					if (mesh_batches[mesh_idx] != BATCH_NONE)
+					{
+						Gfx::InstanceBatch* batch = &imported.instance_batches[mesh_batches[mesh_idx]];
+						batch->first_submesh = mesh_first_submesh[mesh_idx];
+						batch->num_submeshes = mesh_num_submeshes[mesh_idx];
+						batch->first_instance = imported.num_batch_instances;
+						batch->num_instances = 0;
+						imported.num_batch_instances += mesh_batch_sizes[mesh_idx];
+					}
+				}
+			}
+
+			for (u64 node_idx = 0; node_idx < scene_data->nodes_count; ++node_idx)
+			{
+				cgltf_node const* node = &scene_data->nodes[node_idx];
+				if (node->mesh == nullptr)
+				{
+					continue;
+				}
+
+				u64 const mesh_idx = node->mesh - scene_data->meshes;
+				if (mesh_num_submeshes[mesh_idx] == 0)
+				{
+					continue;
+				}
+
+				GpuInstancing const& instancing = node_instancing[node_idx];
+				bool const b_rigid = node->skin == nullptr && mesh_morph_sets[mesh_idx] == Gfx::MORPH_NONE;
+				if (instancing.count > 0 || (b_rigid && mesh_rigid_nodes[mesh_idx] > 0))
+				{
+					Gfx::InstanceBatch* batch = &imported.instance_batches[mesh_batches[mesh_idx]];
+					u32 const first_instance = batch->first_instance + batch->num_instances;
+					u32 const num_instances = max(instancing.count, 1u);
+
+					if (instancing.count > 0)
+					{
+						ReadGpuInstanceTransforms(instancing, imported.batch_instance_transforms + first_instance, importer->scratch_memory);
+					}
+					else
+					{
+						imported.batch_instance_transforms[first_instance] = mat34::Identity();
+					}
+
+					for (u32 i = 0; i < num_instances; ++i)
+					{
+						imported.batch_instance_nodes[first_instance + i] = node_remap[node_idx];
+					}
+					batch->num_instances += num_instances;
+
+					if (instancing.count > 0 && !b_rigid)
+					{
+						LOG(Log::IO, "%s: node %u is instanced, it is drawn without skin and morph targets", importer->file_path, (u32)node_idx);
+					}
+					continue;
+				}
+
+				Gfx::MeshInstance* instance = &imported.instances[imported.num_instances++];
+				instance->node = node_remap[node_idx];
+				instance->first_submesh = mesh_first_submesh[mesh_idx];
+				instance->num_submeshes = mesh_num_submeshes[mesh_idx];
+				instance->skin = Gfx::SKIN_NONE;
+				instance->morph = mesh_morph_sets[mesh_idx];
+
+				if (node->skin != nullptr)
+				{
+					u32 const skin_idx = (u32)(node->skin - scene_data->skins);
+					if (CanSkinInstance(&imported, *instance, imported.skins[skin_idx].num_joints))
+					{
+						instance->skin = skin_idx;
+					}
+					else
+					{
+						LOG(Log::IO, "%s: node %u has joints that its skin doesn't have, it is drawn unskinned", importer->file_path, (u32)node_idx);
+					}
+				}
+			}
+
+			if (imported.num_instance_batches > 0)
+			{
+				LOG(Log::IO, "%s: %u instances in %u batches, %u single instances", importer->file_path, imported.num_batch_instances,
+					imported.num_instance_batches, imported.num_instances);
+			}
+		}
+
+		// TODO(): Remap texcoords
+
+		// Image data may point into the file mappings and cgltf's buffers.
+		if (texture_task != nullptr)
+		{
+			WaitForTextureImport(texture_task, importer->file_path);
+			if (importer->flags & ImportFlags::GenerateMips)
+			{
+				GenerateTextureMips(texture_task, importer);
+			}
+			if (importer->flags & ImportFlags::CompressTextures)
+			{
+				CompressTextures(texture_task, importer);
+			}
+		}
+
+		if (result == cgltf_result_success)
+		{
+			cgltf_free(scene_data);
+		}
+
+		TickTimer(import_timer);
+		LOG(Log::IO, "Imported %s (%u submeshes, %u instances, %u textures) in %.2f ms", importer->file_path,
+			imported.num_submeshes, imported.num_instances, imported.num_textures, GetTotalTimeS(import_timer) * 1000.0f);
+
+		return imported;
+	}
+
+	typedef void (*ImportCallback)(void* user_data, u32 import_idx, MeshImport const* imported);
+
+	// Imports a list of files on the job system, one job per file.
+	struct BatchImport
+	{
+		// SceneImporter::scratch_memory is ignored, every thread imports with its own scratch
+		// arena instead. Mesh and scene memory may be shared between the importers.
+		SceneImporter* importers;
+		MeshImport* results; // One per importer.
+		u32 count;
+
+		u64 scratch_size_per_thread;
+
+		// Optional, called on the thread that finished an import, results[import_idx] is valid from then on.
+		ImportCallback on_imported;
+		void* user_data;
+
+		// Internal, set up by BeginBatchImport.
+		Jobs::Counter counter;
+		atomic_u32 next_import;
+		std::mutex shared_memory_lock;
+		Memory::Arena thread_scratch[Jobs::MAX_THREADS];
+	};
+
+	static void RunBatchImportJob(void* user_data)
+	{
+		BatchImport* batch = static_cast<BatchImport*>(user_data);
+
+		// Jobs are interchangeable, each one takes the next import in line.
+		u32 const import_idx = batch->next_import.fetch_add(1, std::memory_order_relaxed);
+		ASSERT(import_idx < batch->count);
+
+		// Waits inside an import (e.g. on the bounds jobs) only help with their own jobs, see Jobs.h,
+		// so a thread never runs two imports at once and one import's worth of scratch is enough.
+		Memory::Arena* scratch = &batch->thread_scratch[Jobs::GetThreadIndex()];
+		if (scratch->m_memory_block == nullptr)
+		{
+			Memory::InitArena(scratch, batch->scratch_size_per_thread);
+		}
+
+		SceneImporter* importer = &batch->importers[import_idx];
+		importer->scratch_memory = scratch;
+		importer->shared_memory_lock = &batch->shared_memory_lock;
+
+		batch->results[import_idx] = Import(importer);
+
+		if (batch->on_imported != nullptr)
+		{
+			batch->on_imported(batch->user_data, import_idx, &batch->results[import_idx]);
+		}
+	}
+
+	// Kicks off the imports and returns right away.
+	inline void BeginBatchImport(BatchImport* batch)
+	{
+		ASSERT(batch->scratch_size_per_thread > 0);
+
+		batch->counter.pending = 0;
+		batch->next_import = 0;
+		memzero(batch->thread_scratch, sizeof(batch->thread_scratch));
+
+		// All jobs look the same, submit them in chunks from a single array.
+		static constexpr u32 JOBS_PER_SUBMIT = 64;
+		Jobs::Job jobs[JOBS_PER_SUBMIT];
+		for (Jobs::Job& job : jobs)
+		{
+			job.func = &RunBatchImportJob;
+			job.user_data = batch;
+		}
+
+		for (u32 submitted = 0; submitted < batch->count; submitted += JOBS_PER_SUBMIT)
+		{
+			Jobs::Submit(jobs, min<u32>(batch->count - submitted, JOBS_PER_SUBMIT), &batch->counter);
+		}
+	}
+
+	inline bool IsBatchImportDone(BatchImport const* batch)
+	{
+		return Jobs::IsDone(&batch->counter);
+	}
+
+	// Helps out with the remaining imports, then releases the per-thread scratch memory.
+	inline void WaitForBatchImport(BatchImport* batch)
+	{
+		Jobs::WaitForCounter(&batch->counter);
+
+		for (Memory::Arena& scratch : batch->thread_scratch)
+		{
+			if (scratch.m_memory_block != nullptr)
+			{
+				Memory::FreeArena(&scratch);
+			}
+		}
 	}
 }
\ No newline at end of file
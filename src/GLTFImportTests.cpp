@@ -0,0 +1,524 @@
+#include "GLTFImport.h"
+#include "MeshFile.h"
+#include "TestUtils.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// ====================================
+//  glTF Import Tests
+//  Notes:
+//  *) Only built into the tools test runner. GLTFImport.h compiles
+//     cgltf, which MiniApp.cpp already does in the engine.
+//  *) The input files are written next to the test binary and
+//     removed again.
+// ====================================
+
+namespace Mini
+{
+namespace Test
+{
+	static constexpr u32 MAX_JSON_SIZE = 16 * 1024;
+
+	struct JsonWriter
+	{
+		char text[MAX_JSON_SIZE];
+		u32 length;
+	};
+
+	static void Append(JsonWriter* json, char const* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		s32 const written = vsnprintf(json->text + json->length, MAX_JSON_SIZE - json->length, format, args);
+		va_end(args);
+		ASSERT(written >= 0 && json->length + written < MAX_JSON_SIZE);
+		json->length += (u32)written;
+	}
+
+	static void WriteGlb(char const* path, JsonWriter* json, void const* bin, u64 bin_size)
+	{
+		while (json->length % 4 != 0)
+		{
+			json->text[json->length++] = ' ';
+		}
+
+		u32 const header[3] = { 0x46546C67, 2, (u32)(12 + 8 + json->length + 8 + bin_size) };
+		u32 const json_chunk[2] = { json->length, 0x4E4F534A };
+		u32 const bin_chunk[2] = { (u32)bin_size, 0x004E4942 };
+
+		FILE* file = fopen(path, "wb");
+		VERIFY(file != nullptr);
+		fwrite(header, sizeof(header), 1, file);
+		fwrite(json_chunk, sizeof(json_chunk), 1, file);
+		fwrite(json->text, json->length, 1, file);
+		fwrite(bin_chunk, sizeof(bin_chunk), 1, file);
+		fwrite(bin, bin_size, 1, file);
+		fclose(file);
+	}
+
+	// A bumpy grid of quads x quads, positions and 32 bit indices only.
+	static void WriteGridFile(char const* path, u32 quads, TestUtils::Random& random)
+	{
+		u32 const num_vertices = (quads + 1) * (quads + 1);
+		u32 const num_indices = quads * quads * 6;
+		u64 const positions_size = (u64)num_vertices * sizeof(vec3);
+		u64 const bin_size = positions_size + (u64)num_indices * sizeof(u32);
+
+		u8* bin = new u8[bin_size];
+		ON_SCOPE_EXIT(delete[] bin);
+
+		vec3* positions = reinterpret_cast<vec3*>(bin);
+		for (u32 y = 0; y <= quads; ++y)
+		{
+			for (u32 x = 0; x <= quads; ++x)
+			{
+				positions[y * (quads + 1) + x] = vec3((f32)x, random.Float(-0.25f, 0.25f), (f32)y);
+			}
+		}
+
+		u32* index = reinterpret_cast<u32*>(bin + positions_size);
+		for (u32 y = 0; y < quads; ++y)
+		{
+			for (u32 x = 0; x < quads; ++x)
+			{
+				u32 const a = y * (quads + 1) + x;
+				u32 const b = a + quads + 1;
+				*index++ = a; *index++ = b; *index++ = a + 1;
+				*index++ = a + 1; *index++ = b; *index++ = b + 1;
+			}
+		}
+
+		JsonWriter json = {};
+		Append(&json, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],");
+		Append(&json, "\"buffers\":[{\"byteLength\":%llu}],", (unsigned long long)bin_size);
+		Append(&json, "\"bufferViews\":[{\"buffer\":0,\"byteLength\":%llu},{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}],",
+			(unsigned long long)positions_size, (unsigned long long)positions_size, (unsigned long long)(bin_size - positions_size));
+		Append(&json, "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[0,-0.25,0],\"max\":[%u,0.25,%u]},",
+			num_vertices, quads, quads);
+		Append(&json, "{\"bufferView\":1,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}],", num_indices);
+		Append(&json, "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}]}");
+
+		WriteGlb(path, &json, bin, bin_size);
+	}
+
+	// How much scratch an import of the file takes at most: the arena is filled with a pattern
+	// first, everything up to the last overwritten byte was used.
+	static u64 MeasureScratchSize(SceneImporter importer, u64 arena_size)
+	{
+		static constexpr u8 PATTERN = 0xA5;
+
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, arena_size);
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+		memset(scratch.m_memory_block, PATTERN, scratch.m_size);
+
+		importer.scratch_memory = &scratch;
+		MeshImport const imported = Import(&importer);
+		VERIFY(imported.num_submeshes > 0);
+
+		u64 used = scratch.m_size;
+		while (used > 0 && scratch.m_memory_block[used - 1] == PATTERN)
+		{
+			--used;
+		}
+		return used;
+	}
+
+	// Imports wait on jobs of their own (bounds, LODs), and with more files than threads the rest of
+	// the batch is queued ahead of those. Every thread has to finish an import before it starts the next,
+	// so scratch for a single file has to be enough, with any number of files and threads.
+	void BatchImportFitsOneFileOfScratch()
+	{
+		static constexpr u32 NUM_FILES = 16;
+		static constexpr u32 GRID_QUADS = 280; // Above Bounds::PARALLEL_MIN_VERTICES.
+		static constexpr u64 MESH_MEMORY_SIZE = Megabyte(512);
+		static constexpr u32 FLAGS = ImportFlags::OptimizeVertexOrder | ImportFlags::GenerateLods;
+
+		char paths[NUM_FILES][64];
+		TestUtils::Random random;
+		for (u32 i = 0; i < NUM_FILES; ++i)
+		{
+			snprintf(paths[i], sizeof(paths[i]), "gltf_import_test_%u.glb", i);
+			WriteGridFile(paths[i], GRID_QUADS, random);
+		}
+		ON_SCOPE_EXIT(for (char const* path : paths) { remove(path); });
+
+		Memory::Arena mesh_memory;
+		Memory::InitArena(&mesh_memory, MESH_MEMORY_SIZE);
+		ON_SCOPE_EXIT(Memory::FreeArena(&mesh_memory));
+
+		SceneImporter importers[NUM_FILES];
+		MeshImport results[NUM_FILES];
+		for (u32 i = 0; i < NUM_FILES; ++i)
+		{
+			importers[i].file_path = paths[i];
+			importers[i].scratch_memory = nullptr;
+			importers[i].mesh_memory = &mesh_memory;
+			importers[i].scene_memory = nullptr;
+			importers[i].flags = FLAGS;
+		}
+
+		// The grids only differ in their bumps, an eighth on top covers that and the alignment. Every import
+		// nested into another one's bounds wait would add the outer one's few megabytes on top.
+		u64 const scratch_size = MeasureScratchSize(importers[0], MESH_MEMORY_SIZE);
+		Memory::ClearArena(&mesh_memory, false);
+
+		Jobs::Exit();
+		Jobs::Init(3);
+		ON_SCOPE_EXIT(Jobs::Exit(); Jobs::Init());
+
+		BatchImport* batch = new BatchImport();
+		ON_SCOPE_EXIT(delete batch);
+		batch->importers = importers;
+		batch->results = results;
+		batch->count = NUM_FILES;
+		batch->scratch_size_per_thread = scratch_size + scratch_size / 8;
+		batch->on_imported = nullptr;
+		batch->user_data = nullptr;
+
+		BeginBatchImport(batch);
+		WaitForBatchImport(batch);
+
+		for (MeshImport const& imported : results)
+		{
+			ASSERT(imported.num_submeshes > 0 && imported.num_indices > 0);
+		}
+	}
+
+	// Instances of the EXT_mesh_gpu_instancing nodes, see WriteInstancingFile().
+	static constexpr u32 NUM_GPU_INSTANCES[2] = { 3, 2 };
+
+	struct InstancingData
+	{
+		Scene::Transform root;
+		Scene::Transform nodes[6];
+		Scene::Transform gpu_instances[2][3];
+	};
+
+	static void AppendTransform(JsonWriter* json, Scene::Transform const& transform)
+	{
+		Append(json, "\"translation\":[%.9g,%.9g,%.9g],\"rotation\":[%.9g,%.9g,%.9g,%.9g],\"scale\":[%.9g,%.9g,%.9g]",
+			transform.translation.x, transform.translation.y, transform.translation.z,
+			transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+			transform.scale.x, transform.scale.y, transform.scale.z);
+	}
+
+	// Three meshes with the same quad. Under a root node, mesh 0 is drawn by two nodes and a child of one of them,
+	// mesh 1 by a single node. Two more roots have EXT_mesh_gpu_instancing, for mesh 2 and for mesh 0 again.
+	// With b_expand, those carry no mesh and their instances are child nodes instead, which draw the same.
+	static void WriteInstancingFile(char const* path, InstancingData const& data, bool b_expand)
+	{
+		static constexpr u32 NUM_ACCESSORS = 8;
+
+		vec3 const positions[4] = { vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(1.0f, 0.0f, 1.0f) };
+		u32 const indices[6] = { 0, 2, 1, 1, 2, 3 };
+
+		u8 bin[4096];
+		u64 bin_size = 0;
+		u64 view_offsets[NUM_ACCESSORS];
+		u64 view_sizes[NUM_ACCESSORS];
+		u32 num_views = 0;
+
+		auto const push_view = [&](void const* data, u64 size)
+		{
+			ASSERT(bin_size + size <= sizeof(bin));
+			memcpy(bin + bin_size, data, size);
+			view_offsets[num_views] = bin_size;
+			view_sizes[num_views++] = size;
+			bin_size += size;
+		};
+
+		push_view(positions, sizeof(positions));
+		push_view(indices, sizeof(indices));
+		for (u32 gpu_node = 0; gpu_node < 2; ++gpu_node)
+		{
+			vec3 translations[3];
+			quat rotations[3];
+			vec3 scales[3];
+			u32 const count = NUM_GPU_INSTANCES[gpu_node];
+			for (u32 i = 0; i < count; ++i)
+			{
+				translations[i] = data.gpu_instances[gpu_node][i].translation;
+				rotations[i] = data.gpu_instances[gpu_node][i].rotation;
+				scales[i] = data.gpu_instances[gpu_node][i].scale;
+			}
+			push_view(translations, sizeof(vec3) * count);
+			push_view(rotations, sizeof(quat) * count);
+			push_view(scales, sizeof(vec3) * count);
+		}
+
+		JsonWriter json = {};
+		Append(&json, "{\"asset\":{\"version\":\"2.0\"},%s\"scene\":0,\"scenes\":[{\"nodes\":[0,5,6]}],\"nodes\":[{",
+			b_expand ? "" : "\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],");
+		AppendTransform(&json, data.root);
+		Append(&json, ",\"children\":[1,2,3]}");
+
+		u32 const meshes[6] = { 0, 0, 1, 0, 2, 0 };
+		for (u32 node = 0; node < 6; ++node)
+		{
+			Append(&json, ",{");
+			AppendTransform(&json, data.nodes[node]);
+			if (node == 1)
+			{
+				Append(&json, ",\"children\":[4]");
+			}
+
+			u32 const gpu_node = node - 4;
+			if (node < 4)
+			{
+				Append(&json, ",\"mesh\":%u}", meshes[node]);
+			}
+			else if (b_expand)
+			{
+				u32 const first_child = gpu_node == 0 ? 7 : 7 + NUM_GPU_INSTANCES[0];
+				Append(&json, ",\"children\":[%u", first_child);
+				for (u32 i = 1; i < NUM_GPU_INSTANCES[gpu_node]; ++i)
+				{
+					Append(&json, ",%u", first_child + i);
+				}
+				Append(&json, "]}");
+			}
+			else
+			{
+				u32 const first_accessor = 2 + gpu_node * 3;
+				Append(&json, ",\"mesh\":%u,\"extensions\":{\"EXT_mesh_gpu_instancing\":{\"attributes\":"
+					"{\"TRANSLATION\":%u,\"ROTATION\":%u,\"SCALE\":%u}}}}", meshes[node], first_accessor, first_accessor + 1, first_accessor + 2);
+			}
+		}
+
+		if (b_expand)
+		{
+			for (u32 gpu_node = 0; gpu_node < 2; ++gpu_node)
+			{
+				for (u32 i = 0; i < NUM_GPU_INSTANCES[gpu_node]; ++i)
+				{
+					Append(&json, ",{");
+					AppendTransform(&json, data.gpu_instances[gpu_node][i]);
+					Append(&json, ",\"mesh\":%u}", meshes[4 + gpu_node]);
+				}
+			}
+		}
+		Append(&json, "],");
+
+		Append(&json, "\"buffers\":[{\"byteLength\":%llu}],\"bufferViews\":[", (unsigned long long)bin_size);
+		for (u32 view = 0; view < num_views; ++view)
+		{
+			Append(&json, "%s{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}", view > 0 ? "," : "",
+				(unsigned long long)view_offsets[view], (unsigned long long)view_sizes[view]);
+		}
+		Append(&json, "],\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,0,1]},");
+		Append(&json, "{\"bufferView\":1,\"componentType\":5125,\"count\":6,\"type\":\"SCALAR\"}");
+		for (u32 gpu_node = 0; gpu_node < 2; ++gpu_node)
+		{
+			u32 const first_view = 2 + gpu_node * 3;
+			u32 const count = NUM_GPU_INSTANCES[gpu_node];
+			Append(&json, ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"}", first_view, count);
+			Append(&json, ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC4\"}", first_view + 1, count);
+			Append(&json, ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"}", first_view + 2, count);
+		}
+		Append(&json, "],\"meshes\":[");
+		for (u32 mesh = 0; mesh < 3; ++mesh)
+		{
+			Append(&json, "%s{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}", mesh > 0 ? "," : "");
+		}
+		Append(&json, "]}");
+
+		WriteGlb(path, &json, bin, bin_size);
+	}
+
+	static Scene::Transform RandomTransform(TestUtils::Random& random)
+	{
+		Scene::Transform transform;
+		transform.translation = vec3(random.Float(-8.0f, 8.0f), random.Float(-8.0f, 8.0f), random.Float(-8.0f, 8.0f));
+		vec3 axis = vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(0.1f, 1.0f));
+		f32 const length = Math::Length(axis);
+		axis = vec3(axis.x / length, axis.y / length, axis.z / length);
+		transform.rotation = Math::QuatAxisAngle(axis, Math::Rad(random.Float(-Math::Pi, Math::Pi)));
+		transform.scale = vec3(random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f));
+		return transform;
+	}
+
+	static constexpr u32 MAX_DRAWN_INSTANCES = 16;
+
+	// Every submesh range a mesh instance or batch instance draws, with its world transform.
+	struct DrawnInstance
+	{
+		u32 first_submesh;
+		u32 num_submeshes;
+		mat34 world;
+	};
+
+	static u32 GatherDrawnInstances(MeshImport const& imported, DrawnInstance* out_drawn)
+	{
+		ASSERT(imported.num_instances + imported.num_batch_instances <= MAX_DRAWN_INSTANCES);
+		Scene::Hierarchy const* hierarchy = &imported.hierarchy;
+		u32 num_drawn = 0;
+		for (u32 i = 0; i < imported.num_instances; ++i)
+		{
+			Gfx::MeshInstance const& instance = imported.instances[i];
+			out_drawn[num_drawn++] = { instance.first_submesh, instance.num_submeshes, Scene::GetWorldTransform(hierarchy, instance.node) };
+		}
+
+		for (u32 batch_idx = 0; batch_idx < imported.num_instance_batches; ++batch_idx)
+		{
+			Gfx::InstanceBatch const& batch = imported.instance_batches[batch_idx];
+			for (u32 i = batch.first_instance; i < batch.first_instance + batch.num_instances; ++i)
+			{
+				mat34 const& node_world = Scene::GetWorldTransform(hierarchy, imported.batch_instance_nodes[i]);
+				out_drawn[num_drawn++] = { batch.first_submesh, batch.num_submeshes, node_world * imported.batch_instance_transforms[i] };
+			}
+		}
+		return num_drawn;
+	}
+
+	// Both imports draw the same submeshes with the same world transforms, in any order.
+	static void CheckSameDrawnInstances(MeshImport const& imported, MeshImport const& reference)
+	{
+		DrawnInstance drawn[MAX_DRAWN_INSTANCES];
+		DrawnInstance reference_drawn[MAX_DRAWN_INSTANCES];
+		u32 const num_drawn = GatherDrawnInstances(imported, drawn);
+		u32 const num_reference_drawn = GatherDrawnInstances(reference, reference_drawn);
+		ASSERT(num_drawn == num_reference_drawn);
+
+		bool b_matched[MAX_DRAWN_INSTANCES] = {};
+		for (u32 i = 0; i < num_drawn; ++i)
+		{
+			bool b_found = false;
+			for (u32 j = 0; j < num_reference_drawn && !b_found; ++j)
+			{
+				if (b_matched[j] || drawn[i].first_submesh != reference_drawn[j].first_submesh ||
+					drawn[i].num_submeshes != reference_drawn[j].num_submeshes)
+				{
+					continue;
+				}
+
+				f32 max_difference = 0.0f;
+				for (u32 element = 0; element < 12; ++element)
+				{
+					max_difference = max(max_difference, fabsf(drawn[i].world.data[element] - reference_drawn[j].world.data[element]));
+				}
+				b_matched[j] = b_found = max_difference < 1e-4f;
+			}
+			ASSERT(b_found);
+		}
+	}
+
+	// Rigid nodes that share a mesh become one batch with identity instance transforms, EXT_mesh_gpu_instancing nodes
+	// get one whether or not meshes are instanced. Either way the file draws what the same file with the instances
+	// as child nodes draws without batches, and the batches survive a mesh file round trip.
+	void InstancesSharedMeshes()
+	{
+		static char const* const INSTANCED_PATH = "gltf_import_instancing_test.glb";
+		static char const* const EXPANDED_PATH = "gltf_import_instancing_test_expanded.glb";
+		static char const* const MESH_FILE_PATH = "gltf_import_instancing_test.mmesh";
+
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(64));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, Megabyte(64));
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+
+		TestUtils::Random random;
+		InstancingData data;
+		data.root = RandomTransform(random);
+		for (Scene::Transform& node : data.nodes)
+		{
+			node = RandomTransform(random);
+		}
+		for (auto& gpu_node : data.gpu_instances)
+		{
+			for (Scene::Transform& instance : gpu_node)
+			{
+				instance = RandomTransform(random);
+			}
+		}
+
+		WriteInstancingFile(INSTANCED_PATH, data, false);
+		WriteInstancingFile(EXPANDED_PATH, data, true);
+		ON_SCOPE_EXIT(remove(INSTANCED_PATH); remove(EXPANDED_PATH); remove(MESH_FILE_PATH));
+
+		SceneImporter importer;
+		importer.scratch_memory = &scratch;
+		importer.mesh_memory = &arena;
+		importer.scene_memory = &arena;
+
+		importer.file_path = INSTANCED_PATH;
+		importer.flags = ImportFlags::InstanceMeshes;
+		MeshImport const instanced = Import(&importer);
+		importer.flags = 0;
+		MeshImport const plain = Import(&importer);
+		importer.file_path = EXPANDED_PATH;
+		MeshImport const expanded = Import(&importer);
+
+		// Mesh 0 draws three rigid nodes and two GPU instances, mesh 1 once, mesh 2 three GPU instances. The hierarchy
+		// has the seven nodes of the file under the import's scene root.
+		ASSERT(instanced.num_submeshes == 3 && instanced.hierarchy.num_nodes == 8);
+		ASSERT(instanced.num_instances == 1 && instanced.instances[0].first_submesh == 1);
+		ASSERT(instanced.num_instance_batches == 2 && instanced.num_batch_instances == 8);
+		Gfx::InstanceBatch const& shared_batch = instanced.instance_batches[0];
+		ASSERT(shared_batch.first_submesh == 0 && shared_batch.num_submeshes == 1);
+		ASSERT(shared_batch.first_instance == 0 && shared_batch.num_instances == 5);
+		Gfx::InstanceBatch const& gpu_batch = instanced.instance_batches[1];
+		ASSERT(gpu_batch.first_submesh == 2 && gpu_batch.num_submeshes == 1);
+		ASSERT(gpu_batch.first_instance == 5 && gpu_batch.num_instances == 3);
+
+		// Without instancing only the GPU instances are batched, the rigid nodes are single instances in file order.
+		ASSERT(plain.num_instances == 4 && plain.num_instance_batches == 2 && plain.num_batch_instances == 5);
+		ASSERT(plain.instance_batches[0].first_submesh == 0 && plain.instance_batches[0].num_instances == 2);
+		ASSERT(plain.instance_batches[1].first_submesh == 2 && plain.instance_batches[1].num_instances == 3);
+		ASSERT(expanded.num_instances == 9 && expanded.num_instance_batches == 0 && expanded.num_batch_instances == 0);
+
+		// The hierarchy doesn't depend on the flag, so node indices of both imports match.
+		ASSERT(memcmp(instanced.hierarchy.parents, plain.hierarchy.parents, sizeof(u32) * 8) == 0);
+		ASSERT(memcmp(instanced.hierarchy.worlds, plain.hierarchy.worlds, sizeof(mat34) * 8) == 0);
+
+		u32 const rigid_instances[3] = { 0, 1, 3 };
+		for (u32 i = 0; i < 3; ++i)
+		{
+			Gfx::MeshInstance const& instance = plain.instances[rigid_instances[i]];
+			ASSERT(instance.first_submesh == 0 && instance.node == instanced.batch_instance_nodes[i]);
+			ASSERT(memcmp(&instanced.batch_instance_transforms[i], &mat34::Identity(), sizeof(mat34)) == 0);
+		}
+
+		// GPU instances share their node and have the same transforms with or without the flag.
+		ASSERT(instanced.batch_instance_nodes[3] == instanced.batch_instance_nodes[4]);
+		ASSERT(instanced.batch_instance_nodes[5] == instanced.batch_instance_nodes[6] &&
+			instanced.batch_instance_nodes[6] == instanced.batch_instance_nodes[7]);
+		ASSERT(memcmp(instanced.batch_instance_nodes + 3, plain.batch_instance_nodes, sizeof(u32) * 5) == 0);
+		ASSERT(memcmp(instanced.batch_instance_transforms + 3, plain.batch_instance_transforms, sizeof(mat34) * 5) == 0);
+
+		CheckSameDrawnInstances(instanced, expanded);
+		CheckSameDrawnInstances(plain, expanded);
+
+		// Mesh files keep the node order, loaded batches draw the same bits.
+		VERIFY(MeshFile::Write(MESH_FILE_PATH, &instanced, &scratch));
+		MeshImport loaded;
+		IO::MappedFile mapping;
+		VERIFY(MeshFile::Load(MESH_FILE_PATH, &loaded, &mapping, &arena));
+		ON_SCOPE_EXIT(IO::UnmapFile(&mapping));
+
+		ASSERT(loaded.num_instances == instanced.num_instances && loaded.num_instance_batches == instanced.num_instance_batches &&
+			loaded.num_batch_instances == instanced.num_batch_instances);
+		ASSERT(memcmp(loaded.instances, instanced.instances, sizeof(Gfx::MeshInstance) * instanced.num_instances) == 0);
+		ASSERT(memcmp(loaded.instance_batches, instanced.instance_batches, sizeof(Gfx::InstanceBatch) * instanced.num_instance_batches) == 0);
+		ASSERT(memcmp(loaded.batch_instance_nodes, instanced.batch_instance_nodes, sizeof(u32) * instanced.num_batch_instances) == 0);
+		ASSERT(memcmp(loaded.batch_instance_transforms, instanced.batch_instance_transforms,
+			sizeof(mat34) * instanced.num_batch_instances) == 0);
+
+		DrawnInstance loaded_drawn[MAX_DRAWN_INSTANCES];
+		DrawnInstance instanced_drawn[MAX_DRAWN_INSTANCES];
+		u32 const num_drawn = GatherDrawnInstances(loaded, loaded_drawn);
+		ASSERT(num_drawn == 9 && GatherDrawnInstances(instanced, instanced_drawn) == num_drawn);
+		ASSERT(memcmp(loaded_drawn, instanced_drawn, sizeof(DrawnInstance) * num_drawn) == 0);
+	}
+
+	void Run()
+	{
+		BatchImportFitsOneFileOfScratch();
+		InstancesSharedMeshes();
+	}
+}
+}
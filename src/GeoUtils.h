@@ -84,30 +84,30 @@ namespace GeoUtils
 		g.normal[22] = { 1.0f, 0.0f, 0.0f };
 		g.normal[23] = { 1.0f, 0.0f, 0.0f };
 
-		g.tangent_u[0] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[1] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[2] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[3] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[4] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[5] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[6] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[7] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[8] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[9] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[10] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[11] = { 1.0f, 0.0f, 0.0f };
-		g.tangent_u[12] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[13] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[14] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[15] = { -1.0f, 0.0f, 0.0f };
-		g.tangent_u[16] = { 0.0f, 0.0f, -1.0f };
-		g.tangent_u[17] = { 0.0f, 0.0f, -1.0f };
-		g.tangent_u[18] = { 0.0f, 0.0f, -1.0f };
-		g.tangent_u[19] = { 0.0f, 0.0f, -1.0f };
-		g.tangent_u[20] = { 0.0f, 0.0f, 1.0f };
-		g.tangent_u[21] = { 0.0f, 0.0f, 1.0f };
-		g.tangent_u[22] = { 0.0f, 0.0f, 1.0f };
-		g.tangent_u[23] = { 0.0f, 0.0f, 1.0f };
+		g.tangent_u[0] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[1] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[2] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[3] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[4] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[5] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[6] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[7] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[8] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[9] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[10] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[11] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[12] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[13] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[14] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[15] = { -1.0f, 0.0f, 0.0f, 1.0f };
+		g.tangent_u[16] = { 0.0f, 0.0f, -1.0f, 1.0f };
+		g.tangent_u[17] = { 0.0f, 0.0f, -1.0f, 1.0f };
+		g.tangent_u[18] = { 0.0f, 0.0f, -1.0f, 1.0f };
+		g.tangent_u[19] = { 0.0f, 0.0f, -1.0f, 1.0f };
+		g.tangent_u[20] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		g.tangent_u[21] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		g.tangent_u[22] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		g.tangent_u[23] = { 0.0f, 0.0f, 1.0f, 1.0f };
 
 		g.texcoord[0] = { 0.0f, 1.0f };
 		g.texcoord[1] = { 0.0f, 0.0f };
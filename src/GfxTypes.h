@@ -1,11 +1,17 @@
 #pragma once
 
-#include "Win32.h"
-#include "d3dx12.h"
 #include "Array.h"
 #include "Math.h"
+#include "VertexQuantization.h"
+
+// GPU types are D3D12 and only exist on Windows. The CPU side mesh and texture
+// types are used by the offline tools on other platforms as well.
+#ifdef _WIN32
+#include "Win32.h"
+#include "d3dx12.h"
 
 using Microsoft::WRL::ComPtr;
+#endif
 
 namespace Gfx
 {
@@ -95,6 +101,7 @@ namespace Gfx
 		};
 	};
 
+#ifdef _WIN32
 	struct Shader
 	{
 		ID3DBlob* blob = nullptr;
@@ -143,6 +150,7 @@ namespace Gfx
 	{
 		ComPtr<ID3DBlob> blob;
 	};
+#endif
 
 	struct Commandlist
 	{
@@ -156,19 +164,136 @@ namespace Gfx
 		}
 	};
 
+	static constexpr u32 MAX_SUBMESH_LODS = 3;
+
+	// Simplified index range of a submesh, drawn with the submesh's base vertex.
+	struct SubMeshLod
+	{
+		u32 num_indices = 0;
+		u32 first_index_location = 0;
+
+		// Object space distance to the full detail surface.
+		f32 error = 0.0f;
+	};
+
 	struct SubMesh
 	{
 		u32 num_indices = 0;
 		u32 first_index_location = 0;
 		u32 base_vertex_location = 0;
+
+		// Object space, computed on import.
+		AABB aabb;
+		Sphere bounding_sphere;
+
+		// Coarser with every level, LOD 0 is the range above and LOD i is lods[i - 1].
+		SubMeshLod lods[MAX_SUBMESH_LODS];
+		u32 num_lods = 0;
+
+		// Clusters of LOD 0, ranges into Mesh::meshlets.
+		u32 first_meshlet = 0;
+		u32 num_meshlets = 0;
+	};
+
+	static constexpr u32 MAX_MESHLET_VERTICES = 64;
+	static constexpr u32 MAX_MESHLET_TRIANGLES = 124;
+
+	// Small cluster of a submesh's triangles, culled as a whole. See Meshlets.h.
+	struct Meshlet
+	{
+		// Ranges into Mesh::meshlet_vertices and Mesh::meshlet_triangles. Triangles are
+		// 3 u8 indices into the meshlet's vertices, which are relative to the submesh's base vertex.
+		u32 first_vertex = 0;
+		u32 first_triangle = 0;
+		u32 num_vertices = 0;
+		u32 num_triangles = 0;
+
+		// Object space.
+		Sphere bounding_sphere;
+
+		// All triangles face away from viewers with dot(normalize(cone_apex - eye), cone_axis) >= cone_cutoff.
+		// The cutoff is above 1 for clusters that are too curved to ever be culled.
+		vec3 cone_apex;
+		vec3 cone_axis;
+		f32 cone_cutoff = 2.0f;
+	};
+
+	// Pixels an object space distance of 1 covers at a view distance of 1.
+	inline f32 GetLodScreenScale(f32 fov_y_rad, f32 viewport_height)
+	{
+		return viewport_height / (2.0f * tanf(fov_y_rad * 0.5f));
+	}
+
+	// Coarsest LOD whose error projects to at most max_error_pixels. world_scale takes
+	// object space errors to world space, e.g. the largest scale of the instance transform.
+	inline u32 SelectLod(SubMesh const& submesh, f32 distance, f32 world_scale, f32 screen_scale, f32 max_error_pixels)
+	{
+		f32 const pixels_per_unit = world_scale * screen_scale / max(distance, 1e-4f);
+
+		u32 lod = 0;
+		while (lod < submesh.num_lods && submesh.lods[lod].error * pixels_per_unit <= max_error_pixels)
+		{
+			lod++;
+		}
+		return lod;
+	}
+
+	static constexpr u32 SKIN_NONE = ~0u;
+	static constexpr u32 MORPH_NONE = ~0u;
+
+	// Draws a range of a mesh's submeshes with the world transform of a scene node.
+	struct MeshInstance
+	{
+		u32 node = 0;
+		u32 first_submesh = 0;
+		u32 num_submeshes = 0;
+
+		// Skin that deforms the submeshes, see Skinning.h. SKIN_NONE for rigid instances.
+		u32 skin = SKIN_NONE;
+
+		// Morph target set of the submeshes, see Morph.h. Blended before skinning. MORPH_NONE without targets.
+		u32 morph = MORPH_NONE;
+	};
+
+	// Draws a range of a mesh's submeshes once per instance with a single instanced draw per submesh. Every
+	// instance has a scene node and a transform relative to it, see Mini::MeshImport::batch_instance_nodes.
+	// Batched instances are always rigid.
+	struct InstanceBatch
+	{
+		u32 first_submesh = 0;
+		u32 num_submeshes = 0;
+		u32 first_instance = 0;
+		u32 num_instances = 0;
 	};
 
 	using Position_t = vec3;
 	using Normal_t = vec3;
-	using Tangent_t = vec3;
+	using Tangent_t = vec4; // Handedness in w, bitangent = cross(normal, tangent.xyz) * w.
 	using TexCoord_t = vec2;
 	using Index_t = u16;
 
+	// Up to 4 joints per vertex, indices into the joint list of the skin. The weights sum to 1,
+	// unused joints have a weight of 0.
+	struct Joints_t
+	{
+		u16 index[4];
+	};
+	using Weights_t = vec4;
+
+	// Vertices a submesh can address from its base vertex. Larger meshes are split, see MeshOpt::SplitIndices.
+	static constexpr u32 MAX_SUBMESH_VERTICES = 1 << 16;
+
+	// Compressed vertex streams, 20 instead of 48 bytes per vertex.
+	using CompressedPosition_t = unorm16x4; // Relative to the mesh bounds.
+	using CompressedNormal_t = snorm16x2;   // Octahedral.
+	using CompressedTangent_t = snorm8x4;   // Handedness in w.
+	using CompressedTexCoord_t = half2;
+
+	// Per-instance world transform as uploaded to constant and instance buffers,
+	// read as a row_major float3x4 (3 x float4) in shaders.
+	using InstanceTransform_t = mat34;
+	static_assert(sizeof(InstanceTransform_t) == 48, "Instance transforms should be 3 x float4!");
+
 	struct VertexAttribType
 	{
 		enum Enum
@@ -183,11 +308,109 @@ namespace Gfx
 		};
 	};
 
+#ifdef _WIN32
+	static DXGI_FORMAT GetVertexAttribFormat(VertexAttribType::Enum type, bool compressed)
+	{
+		switch (type)
+		{
+		case VertexAttribType::Position:
+			return compressed ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+		case VertexAttribType::Normal:
+			return compressed ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+		case VertexAttribType::TexCoord:
+			return compressed ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+		case VertexAttribType::Tangent:
+			return compressed ? DXGI_FORMAT_R8G8B8A8_SNORM : DXGI_FORMAT_R32G32B32A32_FLOAT;
+		default:
+			ASSERT_FAIL_F("Unknown vertex attribute type!");
+			return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+#endif
+
+	// Instanced draws read one mat34 per instance from the vertex buffer in this slot, after the attribute slots.
+	static constexpr u8 INSTANCE_TRANSFORM_SLOT = VertexAttribType::EnumCount;
+
+	// Texel formats of CPU side textures, the BCn ones are encoded by BlockCompression.h.
+	struct TextureFormat
+	{
+		enum Enum : u32
+		{
+			RGBA8,
+			BC1, // RGB, 4 bits per texel.
+			BC3, // RGBA, BC1 color with BC4 alpha.
+			BC4, // R, 4 bits per texel.
+			BC5, // RG, two BC4 channels.
+			BC7, // RGB(A), 8 bits per texel.
+
+			EnumCount
+		};
+	};
+
+#ifdef _WIN32
+	// BC4 and BC5 hold linear data, they have no sRGB variant.
+	static DXGI_FORMAT GetTextureFormat(TextureFormat::Enum format, bool srgb)
+	{
+		switch (format)
+		{
+		case TextureFormat::RGBA8:
+			return srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		case TextureFormat::BC1:
+			return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+		case TextureFormat::BC3:
+			return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+		case TextureFormat::BC4:
+			return DXGI_FORMAT_BC4_UNORM;
+		case TextureFormat::BC5:
+			return DXGI_FORMAT_BC5_UNORM;
+		case TextureFormat::BC7:
+			return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+		default:
+			ASSERT_FAIL_F("Unknown texture format!");
+			return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+#endif
+
+	struct MeshFlags
+	{
+		enum Enum : u32
+		{
+			CompressedVertexStreams = 1 << 0,
+
+			// All attributes share one vertex buffer, see Mesh::vertex_attrib_offsets.
+			InterleavedVertexStreams = 1 << 1,
+		};
+	};
+
+#ifdef _WIN32
 	struct Mesh
 	{
 		GpuBuffer vertex_attribs_gpu[VertexAttribType::EnumCount];
 		GpuBuffer index_buffer_gpu;
 
-		Array<SubMesh, 8> submeshes;
+		// Byte offset of each attribute into its vertex buffer, non-zero for interleaved streams.
+		u32 vertex_attrib_offsets[VertexAttribType::EnumCount] = {};
+
+		// Allocated by whoever creates the mesh.
+		SubMesh* submeshes = nullptr;
+		u32 num_submeshes = 0;
+
+		// Optional, see SubMesh::first_meshlet. CPU side only, for cluster culling.
+		Meshlet* meshlets = nullptr;
+		u32 num_meshlets = 0;
+		Index_t* meshlet_vertices = nullptr;
+		u8* meshlet_triangles = nullptr;
+
+		u32 flags = 0;
+
+		// Compressed positions are stored as unorm relative to these bounds,
+		// see Quantize::DequantizeTransform.
+		AABB quantization_bounds;
+
+		// Object space bounds of all submeshes.
+		AABB aabb;
+		Sphere bounding_sphere;
 	};
-}
+#endif
+}
\ No newline at end of file
@@ -2315,7 +2315,7 @@ namespace Gfx
 		command_list->IASetPrimitiveTopology(ConvertToPrimitiveTopology(pso->desc.PrimitiveTopologyType));
 	}
 
-	GpuBuffer CreateVertexBuffer(Commandlist cmd_list_handle, void* vertex_data, u32 vertex_bytes, u32 vertex_stride_bytes)
+	GpuBuffer CreateVertexBuffer(Commandlist cmd_list_handle, void* vertex_data, u32 vertex_bytes, u32 vertex_stride_bytes, DXGI_FORMAT format)
 	{
 		ID3D12GraphicsCommandList* command_list = g_gpu_device->HandleToCommandList(cmd_list_handle);
 
@@ -2325,6 +2325,7 @@ namespace Gfx
 		desc.sizes_bytes = vertex_bytes;
 		desc.bind_flags = BindFlags::VertexBuffer;
 		desc.stride_in_bytes = vertex_stride_bytes;
+		desc.format = format;
 
 		GpuBuffer vertex_buffer = g_gpu_device->CreateBuffer(command_list, desc, vertex_data, L"VertexBuffer");
 
@@ -2337,13 +2338,13 @@ namespace Gfx
 		return vertex_buffer;
 	}
 
-	GpuBuffer CreateIndexBuffer(Commandlist cmd_list_handle, void* index_data, u32 index_bytes)
+	GpuBuffer CreateIndexBuffer(Commandlist cmd_list_handle, void* index_data, u32 index_bytes, BufferUsage::Enum usage)
 	{
 		ID3D12GraphicsCommandList* command_list = g_gpu_device->HandleToCommandList(cmd_list_handle);
 
 		GpuBufferDesc desc;
 		MemZeroSafe(desc);
-		desc.usage = BufferUsage::Immutable;
+		desc.usage = usage;
 		desc.sizes_bytes = index_bytes;
 		desc.bind_flags = BindFlags::IndexBuffer;
 		desc.format = DXGI_FORMAT_R16_UINT;
@@ -2389,6 +2390,11 @@ namespace Gfx
 	}
 
 	void DrawMesh(Commandlist cmd_list_handle, Mesh const* mesh)
+	{
+		DrawSubMeshes(cmd_list_handle, mesh, 0, mesh->num_submeshes);
+	}
+
+	static void BindMeshVertexBuffers(Commandlist cmd_list_handle, Mesh const* mesh)
 	{
 		struct Local
 		{
@@ -2396,7 +2402,7 @@ namespace Gfx
 			{
 				if (mesh->vertex_attribs_gpu[attrib].resource != nullptr)
 				{
-					BindVertexBuffer(cmd, &mesh->vertex_attribs_gpu[attrib], slot, 0);
+					BindVertexBuffer(cmd, &mesh->vertex_attribs_gpu[attrib], slot, mesh->vertex_attrib_offsets[attrib]);
 				}
 			}
 		};
@@ -2406,6 +2412,13 @@ namespace Gfx
 		Local::BindVB(cmd_list_handle, mesh, VertexAttribType::Normal,   1);
 		Local::BindVB(cmd_list_handle, mesh, VertexAttribType::TexCoord, 2);
 		Local::BindVB(cmd_list_handle, mesh, VertexAttribType::Tangent,  3);
+	}
+
+	void DrawSubMeshes(Commandlist cmd_list_handle, Mesh const* mesh, u32 first_submesh, u32 num_submeshes, u32 lod)
+	{
+		ASSERT(first_submesh + num_submeshes <= mesh->num_submeshes);
+
+		BindMeshVertexBuffers(cmd_list_handle, mesh);
 		BindIndexBuffer(cmd_list_handle, &mesh->index_buffer_gpu, 0);
 
 		ID3D12GraphicsCommandList* command_list = g_gpu_device->HandleToCommandList(cmd_list_handle);
@@ -2413,9 +2426,73 @@ namespace Gfx
 		// TODO(): can we hold off on this?
 		g_gpu_device->UpdateConstantBindings(command_list);
 		
-		for (SubMesh const& submesh : mesh->submeshes)
+		for (u32 i = first_submesh; i < first_submesh + num_submeshes; ++i)
 		{
+			SubMesh const& submesh = mesh->submeshes[i];
+
+			u32 const submesh_lod = min(lod, submesh.num_lods);
+			if (submesh_lod > 0)
+			{
+				SubMeshLod const& level = submesh.lods[submesh_lod - 1];
+				command_list->DrawIndexedInstanced(level.num_indices, 1, level.first_index_location, submesh.base_vertex_location, 0);
+				continue;
+			}
+
 			command_list->DrawIndexedInstanced(submesh.num_indices, 1, submesh.first_index_location, submesh.base_vertex_location, 0);
 		}
 	}
+
+	void DrawSubMeshIndices(Commandlist cmd_list_handle, Mesh const* mesh, u32 submesh, GpuBuffer const* index_buffer, u32 num_indices)
+	{
+		ASSERT(submesh < mesh->num_submeshes);
+		ASSERT(num_indices * sizeof(Index_t) <= index_buffer->desc.sizes_bytes);
+
+		if (num_indices == 0)
+		{
+			return;
+		}
+
+		BindMeshVertexBuffers(cmd_list_handle, mesh);
+		BindIndexBuffer(cmd_list_handle, index_buffer, 0);
+
+		ID3D12GraphicsCommandList* command_list = g_gpu_device->HandleToCommandList(cmd_list_handle);
+		g_gpu_device->UpdateConstantBindings(command_list);
+
+		command_list->DrawIndexedInstanced(num_indices, 1, 0, mesh->submeshes[submesh].base_vertex_location, 0);
+	}
+
+	void DrawSubMeshesInstanced(Commandlist cmd_list_handle, Mesh const* mesh, u32 first_submesh, u32 num_submeshes,
+		GpuBuffer const* instance_buffer, u32 first_instance, u32 num_instances, u32 lod)
+	{
+		ASSERT(first_submesh + num_submeshes <= mesh->num_submeshes);
+		ASSERT((u64)(first_instance + num_instances) * sizeof(mat34) <= instance_buffer->desc.sizes_bytes);
+
+		if (num_instances == 0)
+		{
+			return;
+		}
+
+		BindMeshVertexBuffers(cmd_list_handle, mesh);
+		BindVertexBuffer(cmd_list_handle, instance_buffer, INSTANCE_TRANSFORM_SLOT, 0);
+		BindIndexBuffer(cmd_list_handle, &mesh->index_buffer_gpu, 0);
+
+		ID3D12GraphicsCommandList* command_list = g_gpu_device->HandleToCommandList(cmd_list_handle);
+		g_gpu_device->UpdateConstantBindings(command_list);
+
+		// Per instance elements start at the start instance location, so every batch can live in the same buffer.
+		for (u32 i = first_submesh; i < first_submesh + num_submeshes; ++i)
+		{
+			SubMesh const& submesh = mesh->submeshes[i];
+
+			u32 const submesh_lod = min(lod, submesh.num_lods);
+			if (submesh_lod > 0)
+			{
+				SubMeshLod const& level = submesh.lods[submesh_lod - 1];
+				command_list->DrawIndexedInstanced(level.num_indices, num_instances, level.first_index_location, submesh.base_vertex_location, first_instance);
+				continue;
+			}
+
+			command_list->DrawIndexedInstanced(submesh.num_indices, num_instances, submesh.first_index_location, submesh.base_vertex_location, first_instance);
+		}
+	}
 }
\ No newline at end of file
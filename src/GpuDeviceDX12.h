@@ -50,8 +50,8 @@ namespace Gfx
 	void BindPSO(Commandlist cmd_list, BasicPSO::Enum basicPSOType);
 	void BindPSO(Commandlist cmd_list, PSO pso_handle);
 
-	GpuBuffer CreateVertexBuffer(Commandlist cmd_list, void* vertex_data, u32 vertex_bytes, u32 vertex_stride_bytes);
-	GpuBuffer CreateIndexBuffer(Commandlist cmd_list, void* index_data, u32 index_bytes);
+	GpuBuffer CreateVertexBuffer(Commandlist cmd_list, void* vertex_data, u32 vertex_bytes, u32 vertex_stride_bytes, DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
+	GpuBuffer CreateIndexBuffer(Commandlist cmd_list, void* index_data, u32 index_bytes, BufferUsage::Enum usage = BufferUsage::Immutable);
 
 	GpuBuffer CreateBuffer(Commandlist cmd_list, GpuBufferDesc const& desc, wchar_t* name, void* initial_data = nullptr);
 	void UpdateBuffer(Commandlist cmd_list, GpuBuffer const* buffer, void* data, u32 size_bytes);
@@ -63,4 +63,12 @@ namespace Gfx
 	void BindIndexBuffer(Commandlist cmd_list, GpuBuffer const* index_buffer, u32 offset);
 
 	void DrawMesh(Commandlist cmd_list, Mesh const* mesh);
+	// Draws the given LOD of each submesh, or its coarsest one if it has fewer.
+	void DrawSubMeshes(Commandlist cmd_list, Mesh const* mesh, u32 first_submesh, u32 num_submeshes, u32 lod = 0);
+	// Draws a submesh with indices from another buffer, e.g. the output of Meshlets::CullMeshlets().
+	void DrawSubMeshIndices(Commandlist cmd_list, Mesh const* mesh, u32 submesh, GpuBuffer const* index_buffer, u32 num_indices);
+	// Draws the given LOD of each submesh num_instances times, with a mat34 per instance from instance_buffer
+	// (see INSTANCE_TRANSFORM_SLOT) starting at first_instance. Needs one of the instanced PSOs.
+	void DrawSubMeshesInstanced(Commandlist cmd_list, Mesh const* mesh, u32 first_submesh, u32 num_submeshes,
+		GpuBuffer const* instance_buffer, u32 first_instance, u32 num_instances, u32 lod = 0);
 }
@@ -1,5 +1,13 @@
 #include "IO.h"
+
+#ifdef _WIN32
 #include "Win32.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace IO
 {
@@ -17,10 +25,21 @@ namespace IO
 		//SetCurrentDirectory(project_mount_path);
 
 		char cwd_buffer[s_max_path];
+#ifdef _WIN32
 		GetCurrentDirectory(s_max_path, cwd_buffer);
+#else
+		if (!getcwd(cwd_buffer, s_max_path))
+		{
+			cwd_buffer[0] = '\0';
+		}
+#endif
 		LOG(Log::IO, "Program working directory: %s", cwd_buffer);
 		
+#ifdef _WIN32
 		strcpy_s(s_file_sys.m_project_path, project_mount_path);
+#else
+		snprintf(s_file_sys.m_project_path, s_max_path, "%s", project_mount_path);
+#endif
 	
 		// Strip delimiter if present for consistency.
 		char* project_path = s_file_sys.m_project_path;
@@ -49,4 +68,185 @@ namespace IO
 		
 		MiniPrintf(out_abs_path->m_str, s_max_path, fmt_str, false, s_file_sys.m_project_path, rel_path);
 	}
+
+#ifdef _WIN32
+	bool MapFile(char const* path, MappedFile* out_file, u32 flags)
+	{
+		MemZeroSafe(out_file);
+
+		DWORD const file_flags = (flags & MapFlags::SequentialAccess) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+		HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, file_flags, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			LOG(Log::IO, "Failed to open file %s!", path);
+			return false;
+		}
+
+		// The view keeps its own reference to the file, so both handles can be closed after mapping.
+		ON_SCOPE_EXIT(CloseHandle(file));
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			LogLastWindowsError();
+			return false;
+		}
+
+		if (file_size.QuadPart == 0)
+		{
+			LOG(Log::IO, "Can't map empty file %s!", path);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			LogLastWindowsError();
+			return false;
+		}
+
+		ON_SCOPE_EXIT(CloseHandle(mapping));
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			LogLastWindowsError();
+			return false;
+		}
+
+		out_file->data = static_cast<u8 const*>(view);
+		out_file->size = file_size.QuadPart;
+
+		if (flags & MapFlags::Prefetch)
+		{
+			WIN32_MEMORY_RANGE_ENTRY range;
+			range.VirtualAddress = view;
+			range.NumberOfBytes = out_file->size;
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+
+		return true;
+	}
+
+	void UnmapFile(MappedFile* file)
+	{
+		if (file->data != nullptr)
+		{
+			UnmapViewOfFile(file->data);
+		}
+
+		MemZeroSafe(file);
+	}
+
+	bool SaveFile(char const* path, void const* data, u64 size)
+	{
+		HANDLE file = CreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			LOG(Log::IO, "Failed to create file %s!", path);
+			return false;
+		}
+
+		ON_SCOPE_EXIT(CloseHandle(file));
+
+		// WriteFile takes 32 bit sizes.
+		u8 const* bytes = static_cast<u8 const*>(data);
+		while (size > 0)
+		{
+			DWORD const chunk = (DWORD)min<u64>(size, Gigabyte(1));
+			DWORD written = 0;
+			if (!::WriteFile(file, bytes, chunk, &written, nullptr) || written == 0)
+			{
+				LogLastWindowsError();
+				return false;
+			}
+
+			bytes += written;
+			size -= written;
+		}
+
+		return true;
+	}
+#else
+	bool MapFile(char const* path, MappedFile* out_file, u32 flags)
+	{
+		MemZeroSafe(out_file);
+
+		s32 fd = open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			LOG(Log::IO, "Failed to open file %s!", path);
+			return false;
+		}
+
+		// The mapping keeps its own reference to the file.
+		ON_SCOPE_EXIT(close(fd));
+
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			LOG(Log::IO, "Can't map empty file %s!", path);
+			return false;
+		}
+
+		void* view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED)
+		{
+			LOG(Log::IO, "Failed to map file %s!", path);
+			return false;
+		}
+
+		out_file->data = static_cast<u8 const*>(view);
+		out_file->size = file_stat.st_size;
+
+		if (flags & MapFlags::SequentialAccess)
+		{
+			madvise(view, out_file->size, MADV_SEQUENTIAL);
+		}
+		if (flags & MapFlags::Prefetch)
+		{
+			madvise(view, out_file->size, MADV_WILLNEED);
+		}
+
+		return true;
+	}
+
+	void UnmapFile(MappedFile* file)
+	{
+		if (file->data != nullptr)
+		{
+			munmap(const_cast<u8*>(file->data), file->size);
+		}
+
+		MemZeroSafe(file);
+	}
+
+	bool SaveFile(char const* path, void const* data, u64 size)
+	{
+		s32 fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+		{
+			LOG(Log::IO, "Failed to create file %s!", path);
+			return false;
+		}
+
+		ON_SCOPE_EXIT(close(fd));
+
+		u8 const* bytes = static_cast<u8 const*>(data);
+		while (size > 0)
+		{
+			ssize_t written = write(fd, bytes, size);
+			if (written <= 0)
+			{
+				LOG(Log::IO, "Failed to write file %s!", path);
+				return false;
+			}
+
+			bytes += written;
+			size -= written;
+		}
+
+		return true;
+	}
+#endif
 }
\ No newline at end of file
@@ -15,4 +15,38 @@ namespace IO
 	};
 
 	void GetAbsoluteFilePath(char const* rel_path, Path* out_abs_path);
+
+	struct MapFlags
+	{
+		enum Enum : u32
+		{
+			None = 0,
+
+			// Hint that the file is read front to back, so the OS reads ahead aggressively.
+			SequentialAccess = 1 << 0,
+
+			// Start paging in the whole file right away instead of faulting on first touch.
+			Prefetch = 1 << 1,
+		};
+	};
+
+	// Read-only view of a whole file. Pages are read on first access straight
+	// into the page cache, there is no intermediate copy like with ReadFile.
+	struct MappedFile
+	{
+		u8 const* data;
+		u64 size;
+	};
+
+	// Returns false if the file can't be opened or is empty.
+	bool MapFile(char const* path, MappedFile* out_file, u32 flags = MapFlags::SequentialAccess);
+	void UnmapFile(MappedFile* file);
+
+	// Creates or overwrites path with size bytes of data.
+	bool SaveFile(char const* path, void const* data, u64 size);
+
+	namespace Test
+	{
+		void Run();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "IO.h"
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+namespace IO
+{
+namespace Test
+{
+	static char const* const TEST_PATH = "io_test.bin";
+
+	static bool IsUnmapped(MappedFile const& file)
+	{
+		return file.data == nullptr && file.size == 0;
+	}
+
+	// Sizes around the page size, with every flag combination.
+	void MapsFileContents()
+	{
+		static constexpr u64 SIZES[] = { 1, 4095, 4096, 4097, 3 * 4096 + 123 };
+		static constexpr u32 FLAGS[] = { MapFlags::None, MapFlags::SequentialAccess, MapFlags::Prefetch,
+			MapFlags::SequentialAccess | MapFlags::Prefetch };
+
+		u8* bytes = new u8[SIZES[ARRAY_SIZE(SIZES) - 1]];
+		ON_SCOPE_EXIT(delete[] bytes);
+		ON_SCOPE_EXIT(remove(TEST_PATH));
+
+		TestUtils::Random random;
+		for (u64 size : SIZES)
+		{
+			for (u64 i = 0; i < size; ++i)
+			{
+				bytes[i] = (u8)random.Next();
+			}
+			VERIFY(SaveFile(TEST_PATH, bytes, size));
+
+			for (u32 flags : FLAGS)
+			{
+				MappedFile file;
+				ASSERT(MapFile(TEST_PATH, &file, flags));
+				ASSERT(file.size == size && memcmp(file.data, bytes, size) == 0);
+
+				UnmapFile(&file);
+				ASSERT(IsUnmapped(file));
+			}
+		}
+
+		// Saving again truncates, the mapping only covers the new contents.
+		VERIFY(SaveFile(TEST_PATH, bytes, 7));
+		MappedFile file;
+		ASSERT(MapFile(TEST_PATH, &file));
+		ASSERT(file.size == 7 && memcmp(file.data, bytes, 7) == 0);
+		UnmapFile(&file);
+	}
+
+	// Failures leave an empty MappedFile behind, which is fine to unmap.
+	void RejectsEmptyAndMissingFiles()
+	{
+		MappedFile file;
+		file.data = reinterpret_cast<u8 const*>(TEST_PATH);
+		file.size = 1;
+
+		remove(TEST_PATH);
+		ASSERT(!MapFile(TEST_PATH, &file));
+		ASSERT(IsUnmapped(file));
+		UnmapFile(&file);
+
+		VERIFY(SaveFile(TEST_PATH, nullptr, 0));
+		ON_SCOPE_EXIT(remove(TEST_PATH));
+		file.size = 1;
+		ASSERT(!MapFile(TEST_PATH, &file, MapFlags::Prefetch));
+		ASSERT(IsUnmapped(file));
+		UnmapFile(&file);
+	}
+
+	void Run()
+	{
+		MapsFileContents();
+		RejectsEmptyAndMissingFiles();
+	}
+}
+}
@@ -0,0 +1,64 @@
+#include "ImageDecode.h"
+
+namespace Image
+{
+	Format::Enum DetectFormat(u8 const* data, u64 data_size)
+	{
+		static u8 const PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+		if (data_size >= sizeof(PNG_SIGNATURE) && memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0)
+		{
+			return Format::Png;
+		}
+
+		// SOI marker, followed by the first segment's marker.
+		if (data_size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff)
+		{
+			return Format::Jpeg;
+		}
+
+		return Format::Unknown;
+	}
+
+	bool OpenImage(Decoder* out_decoder, u8 const* data, u64 data_size, Memory::Arena* memory)
+	{
+		MemZeroSafe(out_decoder);
+		out_decoder->format = DetectFormat(data, data_size);
+		out_decoder->data = data;
+		out_decoder->data_size = data_size;
+
+		bool b_ok = false;
+		switch (out_decoder->format)
+		{
+		case Format::Png:
+			b_ok = Png::Open(out_decoder, memory);
+			break;
+		case Format::Jpeg:
+			b_ok = Jpeg::Open(out_decoder, memory);
+			break;
+		case Format::Unknown:
+			break;
+		}
+
+		return b_ok && out_decoder->num_ranges > 0 &&
+			out_decoder->width > 0 && out_decoder->width <= MAX_DIMENSION &&
+			out_decoder->height > 0 && out_decoder->height <= MAX_DIMENSION;
+	}
+
+	bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory)
+	{
+		ASSERT(range < decoder->num_ranges);
+
+		switch (decoder->format)
+		{
+		case Format::Png:
+			return Png::DecodeRange(decoder, range, pixels, scratch_memory);
+		case Format::Jpeg:
+			return Jpeg::DecodeRange(decoder, range, pixels, scratch_memory);
+		case Format::Unknown:
+			break;
+		}
+
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Core.h"
+#include "Memory.h"
+
+// ====================================
+//  Image Decoding
+//  Notes:
+//  *) PNG (every color type and bit depth, Adam7) and baseline
+//     JPEG (huffman coded, sequential, grayscale or YCbCr/RGB)
+//     into RGBA8. Progressive and arithmetic coded JPEGs are
+//     rejected, as are 16 bit channels which get cut to 8 bit.
+//  *) Decoding is split in two. OpenImage() parses the headers,
+//     DecodeRange() decodes rows into the caller's pixels.
+//  *) Ranges are independent and can run on different threads at
+//     the same time. JPEGs with restart markers have a range per
+//     group of restart intervals, everything else has one range.
+// ====================================
+
+namespace Image
+{
+	// D3D12's limit for 2D textures, also keeps every size below in 32 bits.
+	static constexpr u32 MAX_DIMENSION = 16384;
+
+	struct Format
+	{
+		enum Enum : u32
+		{
+			Unknown,
+			Png,
+			Jpeg,
+		};
+	};
+
+	// Tightly packed RGBA8 rows, top to bottom.
+	struct Surface
+	{
+		u8* pixels;
+		u32 width;
+		u32 height;
+	};
+
+	struct Decoder
+	{
+		Format::Enum format;
+		u32 width;
+		u32 height;
+
+		u32 num_ranges;
+
+		// Scratch memory a single DecodeRange() call needs at most.
+		u64 scratch_size;
+
+		// Has to stay valid until all ranges are decoded.
+		u8 const* data;
+		u64 data_size;
+
+		// Format specific, lives in the memory passed to OpenImage().
+		void* state;
+	};
+
+	Format::Enum DetectFormat(u8 const* data, u64 data_size);
+
+	// Returns false if the format is unknown or unsupported, if the headers are broken,
+	// or if the image is larger than MAX_DIMENSION.
+	bool OpenImage(Decoder* out_decoder, u8 const* data, u64 data_size, Memory::Arena* memory);
+
+	// Writes the rows of one range to pixels, which holds the whole RGBA8 image. Returns false
+	// on corrupt data, the rows of the range are undefined in that case.
+	bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory);
+
+	// Format specific halves of the above, see PngDecode.cpp and JpegDecode.cpp.
+	namespace Png
+	{
+		bool Open(Decoder* decoder, Memory::Arena* memory);
+		bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory);
+	}
+
+	namespace Jpeg
+	{
+		bool Open(Decoder* decoder, Memory::Arena* memory);
+		bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory);
+	}
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "ImageDecode.h"
+#include "TestUtils.h"
+
+#include <math.h>
+
+namespace Image
+{
+namespace Test
+{
+	// Written with Python's zlib, so the stream comes from an encoder other than ours. 13x11, every
+	// row filtered with the next of the five filter types, the zlib stream split over two IDAT chunks.
+	// The pixels are the ones ExpectedRgba8() and ExpectedPalette4() compute.
+	static u8 const PNG_RGBA8[] =
+	{
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0d,
+		0x00, 0x00, 0x00, 0x0b, 0x08, 0x06, 0x00, 0x00, 0x00, 0xa4, 0xb2, 0x07, 0x61, 0x00, 0x00, 0x00, 0xbc, 0x49, 0x44, 0x41,
+		0x54, 0x78, 0xda, 0x6d, 0xd0, 0xbb, 0x4b, 0x42, 0x51, 0x1c, 0x07, 0xf0, 0xdf, 0xf5, 0x78, 0x7c, 0x9c, 0x1b, 0x79, 0x09,
+		0x1b, 0x24, 0xb8, 0x09, 0x22, 0x08, 0x61, 0x89, 0x10, 0x0e, 0x49, 0x35, 0x44, 0xd4, 0x62, 0x2e, 0x2d, 0x0e, 0x29, 0x11,
+		0xb4, 0x84, 0x05, 0x2d, 0x42, 0x64, 0x41, 0x4b, 0x4b, 0x0f, 0x5a, 0x5a, 0xa2, 0x5c, 0x5a, 0x1a, 0xb2, 0xa1, 0xa5, 0xc5,
+		0x5a, 0x5a, 0xab, 0xbf, 0xa0, 0xcd, 0xa1, 0x2c, 0xbd, 0xbe, 0x5f, 0xe5, 0xe9, 0x77, 0xbd, 0x12, 0x52, 0x0e, 0x1f, 0xce,
+		0x03, 0x0e, 0xdf, 0xf3, 0xfb, 0x02, 0x00, 0x70, 0x89, 0x42, 0xcb, 0xce, 0xe0, 0xdb, 0x63, 0x81, 0xaf, 0x69, 0x2b, 0x34,
+		0x83, 0x36, 0x68, 0x44, 0x64, 0xa8, 0x6f, 0x38, 0xa0, 0xb6, 0xeb, 0x82, 0xea, 0xb1, 0x1b, 0x2a, 0x09, 0x2f, 0x94, 0x6f,
+		0x7c, 0x50, 0x7a, 0xf0, 0x43, 0x51, 0x20, 0x12, 0xb4, 0x24, 0x2a, 0xf0, 0x5f, 0xe9, 0xae, 0xbd, 0xb3, 0xf7, 0xbd, 0x0e,
+		0x1f, 0x71, 0x22, 0x09, 0x48, 0x87, 0x08, 0x27, 0x1e, 0x3d, 0xa2, 0xc8, 0xc0, 0xc9, 0x8b, 0x11, 0x99, 0x90, 0x99, 0x13,
+		0x85, 0x21, 0x11, 0xf5, 0x71, 0x62, 0xb0, 0x43, 0x9c, 0x89, 0x3a, 0xce, 0x44, 0xa2, 0xc9, 0xe8, 0x39, 0x6b, 0xaa, 0xa8,
+		0x46, 0x34, 0x68, 0x32, 0x46, 0x3c, 0xab, 0x4c, 0x5c, 0x0e, 0xcc, 0x43, 0x48, 0x00, 0x00, 0x00, 0xbc, 0x49, 0x44, 0x41,
+		0x54, 0xdf, 0x4e, 0xc2, 0x48, 0x42, 0x31, 0x89, 0x62, 0xd2, 0x20, 0x26, 0xd1, 0x8e, 0xf1, 0xae, 0x7d, 0x17, 0xb0, 0x04,
+		0xa1, 0x31, 0xbc, 0x48, 0xeb, 0x63, 0x21, 0x56, 0x9b, 0x0a, 0x5b, 0xaa, 0x0b, 0x33, 0xd6, 0x4a, 0x78, 0xde, 0x56, 0x5e,
+		0x0f, 0xc8, 0xa5, 0x9d, 0x4d, 0x47, 0xf1, 0x28, 0xe6, 0x2a, 0x5c, 0x6c, 0xbb, 0xf3, 0xc9, 0x65, 0xaf, 0x72, 0xbf, 0xea,
+		0xcb, 0x3d, 0xaf, 0xf9, 0xb3, 0xc2, 0x40, 0x04, 0xea, 0x12, 0x35, 0xf0, 0x9e, 0x1e, 0x7b, 0xdf, 0xff, 0x2f, 0x42, 0xc1,
+		0x2f, 0x28, 0x58, 0x84, 0x82, 0x45, 0x48, 0x58, 0x84, 0x84, 0x45, 0x48, 0x7f, 0x8a, 0xe8, 0x9f, 0x83, 0x2d, 0x26, 0xaa,
+		0x03, 0x77, 0x86, 0x1e, 0x52, 0x19, 0x35, 0x23, 0xa6, 0x0e, 0x33, 0x67, 0x13, 0x2a, 0xd6, 0xf6, 0xbf, 0x88, 0xb4, 0x3a,
+		0x2c, 0x26, 0xe1, 0x37, 0x88, 0x13, 0x93, 0x28, 0x26, 0x51, 0x4c, 0x4a, 0x9b, 0xb5, 0x15, 0x81, 0x9c, 0x80, 0xf2, 0xe8,
+		0x25, 0x2b, 0x4d, 0x5e, 0x59, 0x8b, 0x81, 0xa4, 0x5c, 0x58, 0xba, 0x75, 0xe5, 0xa3, 0x77, 0x5e, 0x25, 0x9e, 0xf2, 0xe7,
+		0x0e, 0xf7, 0x66, 0xb3, 0xe7, 0xfb, 0xc1, 0xcf, 0xeb, 0x83, 0xd0, 0x47, 0xea, 0x64, 0x25, 0xf3, 0x74, 0x1a, 0x7d, 0x7f,
+		0x3d, 0x8b, 0xbd, 0xfd, 0x00, 0xfa, 0x77, 0xd0, 0x57, 0x37, 0x29, 0xd0, 0xa2, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e,
+		0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+
+	static u8 const PNG_PALETTE4[] =
+	{
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0d,
+		0x00, 0x00, 0x00, 0x0b, 0x04, 0x03, 0x00, 0x00, 0x00, 0x56, 0x9c, 0x1a, 0x52, 0x00, 0x00, 0x00, 0x30, 0x50, 0x4c, 0x54,
+		0x45, 0x00, 0xff, 0x00, 0x11, 0xee, 0x28, 0x22, 0xdd, 0x50, 0x33, 0xcc, 0x78, 0x44, 0xbb, 0xa0, 0x55, 0xaa, 0xc8, 0x66,
+		0x99, 0xf0, 0x77, 0x88, 0x18, 0x88, 0x77, 0x40, 0x99, 0x66, 0x68, 0xaa, 0x55, 0x90, 0xbb, 0x44, 0xb8, 0xcc, 0x33, 0xe0,
+		0xdd, 0x22, 0x08, 0xee, 0x11, 0x30, 0xff, 0x00, 0x58, 0x5e, 0x37, 0x5f, 0x44, 0x00, 0x00, 0x00, 0x23, 0x49, 0x44, 0x41,
+		0x54, 0x78, 0xda, 0x63, 0x60, 0x54, 0x76, 0x4d, 0xef, 0x5c, 0x7d, 0x80, 0x51, 0x59, 0x09, 0x04, 0x84, 0x99, 0xc0, 0x94,
+		0x92, 0x02, 0xb3, 0x2b, 0x88, 0x12, 0x52, 0x60, 0x01, 0x53, 0x4a, 0xb2, 0x0c, 0xab, 0xcf, 0xbe, 0x17, 0xf5, 0xf6, 0x5a,
+		0x00, 0x00, 0x00, 0x23, 0x49, 0x44, 0x41, 0x54, 0x07, 0x2a, 0x4d, 0x60, 0x3c, 0x0b, 0xe4, 0x29, 0x29, 0x49, 0x32, 0x81,
+		0x29, 0xa0, 0xba, 0x2e, 0xb0, 0x7a, 0x69, 0x16, 0x88, 0x3e, 0x61, 0x06, 0x90, 0x69, 0x67, 0xdf, 0x33, 0x00, 0x00, 0xe5,
+		0x95, 0x11, 0xd3, 0xaa, 0x3a, 0x5d, 0x80, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+
+	static void ExpectedRgba8(u32 x, u32 y, u8* rgba)
+	{
+		rgba[0] = (u8)(x * 16 + y * 3);
+		rgba[1] = (u8)((y * 16) ^ (x * 5));
+		rgba[2] = (u8)(x * y);
+		rgba[3] = (u8)(255 - x - y);
+	}
+
+	static void ExpectedPalette4(u32 x, u32 y, u8* rgba)
+	{
+		u32 const index = (x + 2 * y) % 16;
+		rgba[0] = (u8)(index * 17);
+		rgba[1] = (u8)(255 - index * 17);
+		rgba[2] = (u8)(index * 40);
+		rgba[3] = 255;
+	}
+
+	template <typename Expected>
+	static void CheckPng(u8 const* data, u64 data_size, Expected expected, Memory::Arena* arena)
+	{
+		Decoder decoder;
+		ASSERT(OpenImage(&decoder, data, data_size, arena));
+		ASSERT(decoder.format == Format::Png && decoder.width == 13 && decoder.height == 11 && decoder.num_ranges == 1);
+
+		u8* pixels = (u8*)Memory::PushSize(arena, decoder.width * decoder.height * 4);
+		ASSERT(DecodeRange(&decoder, 0, pixels, arena));
+
+		for (u32 y = 0; y < decoder.height; ++y)
+		{
+			for (u32 x = 0; x < decoder.width; ++x)
+			{
+				u8 rgba[4];
+				expected(x, y, rgba);
+				ASSERT(memcmp(pixels + (y * decoder.width + x) * 4, rgba, 4) == 0);
+			}
+		}
+
+		// Cut off in the middle of the image data.
+		ASSERT(!OpenImage(&decoder, data, data_size / 2 + 40, arena) || !DecodeRange(&decoder, 0, pixels, arena));
+	}
+
+	void PngFixtures()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		CheckPng(PNG_RGBA8, sizeof(PNG_RGBA8), &ExpectedRgba8, &arena);
+		CheckPng(PNG_PALETTE4, sizeof(PNG_PALETTE4), &ExpectedPalette4, &arena);
+	}
+
+	// ====================================
+	//  Baseline JPEG writer for the fixture below. YCbCr 4:2:0 with restart markers,
+	//  every block holds a DC term and a few low frequencies. Both huffman tables
+	//  only use 4 bit codes, so a symbol's code is its index in the table.
+	// ====================================
+
+	static constexpr u32 JPEG_WIDTH = 330;
+	static constexpr u32 JPEG_HEIGHT = 410;
+	static constexpr u32 JPEG_MCUS_X = (JPEG_WIDTH + 15) / 16;
+	static constexpr u32 JPEG_MCUS_Y = (JPEG_HEIGHT + 15) / 16;
+	static constexpr u32 JPEG_RESTART_INTERVAL = 4;
+
+	// Coefficients 1 to 5 in zigzag order, row major in the block.
+	static constexpr u32 NUM_AC = 5;
+	static constexpr u32 ZIGZAG[NUM_AC + 1] = { 0, 1, 8, 16, 9, 2 };
+
+	static u8 const DC_SYMBOLS[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	static u8 const AC_SYMBOLS[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x11, 0x12, 0x13, 0x14, 0x15 };
+
+	struct JpegBlock
+	{
+		// Quantized, in zigzag order.
+		s32 coefficients[NUM_AC + 1];
+	};
+
+	struct JpegWriter
+	{
+		u8* data;
+		u64 size;
+		u32 bits;
+		u32 num_bits;
+	};
+
+	static void PutByte(JpegWriter* writer, u8 value)
+	{
+		writer->data[writer->size++] = value;
+	}
+
+	static void PutU16(JpegWriter* writer, u32 value)
+	{
+		PutByte(writer, (u8)(value >> 8));
+		PutByte(writer, (u8)value);
+	}
+
+	static void PutBits(JpegWriter* writer, u32 value, u32 num_bits)
+	{
+		for (u32 i = num_bits; i-- > 0;)
+		{
+			writer->bits = (writer->bits << 1) | ((value >> i) & 1);
+			if (++writer->num_bits == 8)
+			{
+				PutByte(writer, (u8)writer->bits);
+				if (writer->bits == 0xff)
+				{
+					PutByte(writer, 0); // Stuffing
+				}
+				writer->bits = 0;
+				writer->num_bits = 0;
+			}
+		}
+	}
+
+	// Pads the last byte with ones, like the spec asks for before a marker.
+	static void FlushBits(JpegWriter* writer)
+	{
+		if (writer->num_bits > 0)
+		{
+			PutBits(writer, 0x7f, 8 - writer->num_bits);
+		}
+	}
+
+	static void PutSymbol(JpegWriter* writer, u8 const* symbols, u32 num_symbols, u8 symbol)
+	{
+		for (u32 i = 0; i < num_symbols; ++i)
+		{
+			if (symbols[i] == symbol)
+			{
+				PutBits(writer, i, 4);
+				return;
+			}
+		}
+		ASSERT_FAIL();
+	}
+
+	static u32 MagnitudeSize(s32 value)
+	{
+		u32 size = 0;
+		for (u32 magnitude = (u32)abs(value); magnitude != 0; magnitude >>= 1)
+		{
+			size++;
+		}
+		return size;
+	}
+
+	static void PutValue(JpegWriter* writer, s32 value, u32 size)
+	{
+		PutBits(writer, value < 0 ? (u32)(value + (1 << size) - 1) : (u32)value, size);
+	}
+
+	static void PutHuffmanTable(JpegWriter* writer, u32 table_class, u8 const* symbols, u32 num_symbols)
+	{
+		PutU16(writer, 0xffc4);
+		PutU16(writer, 2 + 17 + num_symbols);
+		PutByte(writer, (u8)(table_class << 4));
+		for (u32 length = 1; length <= 16; ++length)
+		{
+			PutByte(writer, length == 4 ? (u8)num_symbols : 0);
+		}
+		for (u32 i = 0; i < num_symbols; ++i)
+		{
+			PutByte(writer, symbols[i]);
+		}
+	}
+
+	static void PutBlock(JpegWriter* writer, JpegBlock const& block, s32* dc_prediction)
+	{
+		s32 const dc_diff = block.coefficients[0] - *dc_prediction;
+		*dc_prediction = block.coefficients[0];
+		u32 const dc_size = MagnitudeSize(dc_diff);
+		PutSymbol(writer, DC_SYMBOLS, ARRAY_SIZE(DC_SYMBOLS), (u8)dc_size);
+		PutValue(writer, dc_diff, dc_size);
+
+		u32 run = 0;
+		for (u32 k = 1; k <= NUM_AC; ++k)
+		{
+			s32 const value = block.coefficients[k];
+			if (value == 0)
+			{
+				run++;
+				continue;
+			}
+			u32 const size = MagnitudeSize(value);
+			PutSymbol(writer, AC_SYMBOLS, ARRAY_SIZE(AC_SYMBOLS), (u8)((run << 4) | size));
+			PutValue(writer, value, size);
+			run = 0;
+		}
+		PutSymbol(writer, AC_SYMBOLS, ARRAY_SIZE(AC_SYMBOLS), 0x00);
+	}
+
+	static u8 Quant(u32 k)
+	{
+		return (u8)(1 + (k & 3));
+	}
+
+	// Y blocks come first in an MCU, top left to bottom right, then Cb and Cr.
+	static u64 WriteJpeg(u8* data, JpegBlock const* blocks)
+	{
+		JpegWriter writer = { data, 0, 0, 0 };
+		PutU16(&writer, 0xffd8);
+
+		PutU16(&writer, 0xffdb);
+		PutU16(&writer, 2 + 65);
+		PutByte(&writer, 0);
+		for (u32 k = 0; k < 64; ++k)
+		{
+			PutByte(&writer, Quant(k));
+		}
+
+		PutU16(&writer, 0xffc0);
+		PutU16(&writer, 2 + 6 + 3 * 3);
+		PutByte(&writer, 8);
+		PutU16(&writer, JPEG_HEIGHT);
+		PutU16(&writer, JPEG_WIDTH);
+		PutByte(&writer, 3);
+		u8 const components[3][3] = { { 1, 0x22, 0 }, { 2, 0x11, 0 }, { 3, 0x11, 0 } };
+		for (u32 c = 0; c < 3; ++c)
+		{
+			PutByte(&writer, components[c][0]);
+			PutByte(&writer, components[c][1]);
+			PutByte(&writer, components[c][2]);
+		}
+
+		PutHuffmanTable(&writer, 0, DC_SYMBOLS, ARRAY_SIZE(DC_SYMBOLS));
+		PutHuffmanTable(&writer, 1, AC_SYMBOLS, ARRAY_SIZE(AC_SYMBOLS));
+
+		PutU16(&writer, 0xffdd);
+		PutU16(&writer, 4);
+		PutU16(&writer, JPEG_RESTART_INTERVAL);
+
+		PutU16(&writer, 0xffda);
+		PutU16(&writer, 2 + 1 + 3 * 2 + 3);
+		PutByte(&writer, 3);
+		for (u32 c = 0; c < 3; ++c)
+		{
+			PutByte(&writer, components[c][0]);
+			PutByte(&writer, 0x00);
+		}
+		PutByte(&writer, 0);
+		PutByte(&writer, 63);
+		PutByte(&writer, 0);
+
+		u32 const num_mcus = JPEG_MCUS_X * JPEG_MCUS_Y;
+		s32 dc_predictions[3] = {};
+		for (u32 mcu = 0; mcu < num_mcus; ++mcu)
+		{
+			if (mcu > 0 && mcu % JPEG_RESTART_INTERVAL == 0)
+			{
+				FlushBits(&writer);
+				PutU16(&writer, 0xffd0 + (mcu / JPEG_RESTART_INTERVAL - 1) % 8);
+				memset(dc_predictions, 0, sizeof(dc_predictions));
+			}
+
+			for (u32 block = 0; block < 6; ++block)
+			{
+				PutBlock(&writer, blocks[mcu * 6 + block], &dc_predictions[block < 4 ? 0 : block - 3]);
+			}
+		}
+		FlushBits(&writer);
+		PutU16(&writer, 0xffd9);
+		return writer.size;
+	}
+
+	// Straight from the IDCT's definition, with the level shift.
+	static void ReferenceIdct(JpegBlock const& block, f32* samples, u32 pitch)
+	{
+		for (u32 y = 0; y < 8; ++y)
+		{
+			for (u32 x = 0; x < 8; ++x)
+			{
+				f32 sum = 0.0f;
+				for (u32 k = 0; k <= NUM_AC; ++k)
+				{
+					u32 const u = ZIGZAG[k] % 8;
+					u32 const v = ZIGZAG[k] / 8;
+					f32 const cu = u == 0 ? 0.70710678f : 1.0f;
+					f32 const cv = v == 0 ? 0.70710678f : 1.0f;
+					sum += cu * cv * (f32)(block.coefficients[k] * Quant(k)) * cosf((2 * x + 1) * u * 3.14159265f / 16.0f) *
+						cosf((2 * y + 1) * v * 3.14159265f / 16.0f);
+				}
+				samples[y * pitch + x] = sum / 4.0f + 128.0f;
+			}
+		}
+	}
+
+	static u8 ClampToByte(f32 value)
+	{
+		return (u8)Clamp(value + 0.5f, 0.0f, 255.0f);
+	}
+
+	// Restart intervals end mid row and the last one is short. There are enough of them for
+	// several ranges, which are decoded back to front to show that they don't depend on each other.
+	void JpegRestartFixture()
+	{
+		static constexpr u32 NUM_BLOCKS = JPEG_MCUS_X * JPEG_MCUS_Y * 6;
+		static constexpr u32 PLANE_WIDTH = JPEG_MCUS_X * 16;
+		static constexpr u32 PLANE_HEIGHT = JPEG_MCUS_Y * 16;
+
+		JpegBlock* blocks = new JpegBlock[NUM_BLOCKS];
+		u8* data = new u8[NUM_BLOCKS * 64];
+		f32* planes = new f32[PLANE_WIDTH * PLANE_HEIGHT * 3];
+		ON_SCOPE_EXIT(delete[] blocks; delete[] data; delete[] planes);
+
+		// Block averages stay within [60, 196], the AC terms add at most +-25, so nothing clamps
+		// before the color conversion.
+		TestUtils::Random random;
+		for (u32 i = 0; i < NUM_BLOCKS; ++i)
+		{
+			JpegBlock& block = blocks[i];
+			block.coefficients[0] = (s32)random.Index(137) * 8 - 68 * 8;
+			for (u32 k = 1; k <= NUM_AC; ++k)
+			{
+				s32 const magnitude = (s32)random.Index(10) + 1;
+				block.coefficients[k] = (random.Next() & 1) ? magnitude : -magnitude;
+			}
+
+			// Every other block skips a coefficient, that's a run of one zero.
+			block.coefficients[3] = (i % 2) ? 0 : block.coefficients[3];
+		}
+
+		u64 const data_size = WriteJpeg(data, blocks);
+
+		f32* const y_plane = planes;
+		f32* const cb_plane = planes + PLANE_WIDTH * PLANE_HEIGHT;
+		f32* const cr_plane = cb_plane + PLANE_WIDTH * PLANE_HEIGHT;
+		for (u32 mcu = 0; mcu < JPEG_MCUS_X * JPEG_MCUS_Y; ++mcu)
+		{
+			u32 const x0 = (mcu % JPEG_MCUS_X) * 16;
+			u32 const y0 = (mcu / JPEG_MCUS_X) * 16;
+			for (u32 block = 0; block < 4; ++block)
+			{
+				ReferenceIdct(blocks[mcu * 6 + block], y_plane + (y0 + (block / 2) * 8) * PLANE_WIDTH + x0 + (block % 2) * 8, PLANE_WIDTH);
+			}
+			ReferenceIdct(blocks[mcu * 6 + 4], cb_plane + (y0 / 2) * PLANE_WIDTH + x0 / 2, PLANE_WIDTH);
+			ReferenceIdct(blocks[mcu * 6 + 5], cr_plane + (y0 / 2) * PLANE_WIDTH + x0 / 2, PLANE_WIDTH);
+		}
+
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		Decoder decoder;
+		ASSERT(OpenImage(&decoder, data, data_size, &arena));
+		ASSERT(decoder.format == Format::Jpeg && decoder.width == JPEG_WIDTH && decoder.height == JPEG_HEIGHT);
+		ASSERT(decoder.num_ranges == 3);
+
+		u8* pixels = (u8*)Memory::PushSize(&arena, JPEG_WIDTH * JPEG_HEIGHT * 4);
+		for (u32 range = decoder.num_ranges; range-- > 0;)
+		{
+			ASSERT(DecodeRange(&decoder, range, pixels, &arena));
+		}
+
+		// The integer IDCT is within a step or two, chroma errors grow by up to 1.8 in the conversion.
+		for (u32 y = 0; y < JPEG_HEIGHT; ++y)
+		{
+			for (u32 x = 0; x < JPEG_WIDTH; ++x)
+			{
+				f32 const luma = y_plane[y * PLANE_WIDTH + x];
+				f32 const cb = cb_plane[(y / 2) * PLANE_WIDTH + x / 2] - 128.0f;
+				f32 const cr = cr_plane[(y / 2) * PLANE_WIDTH + x / 2] - 128.0f;
+				u8 const expected[4] = { ClampToByte(luma + 1.402f * cr), ClampToByte(luma - 0.344136f * cb - 0.714136f * cr),
+					ClampToByte(luma + 1.772f * cb), 255 };
+
+				u8 const* pixel = pixels + (y * JPEG_WIDTH + x) * 4;
+				for (u32 c = 0; c < 4; ++c)
+				{
+					ASSERT(abs((s32)pixel[c] - (s32)expected[c]) <= 3);
+				}
+			}
+		}
+
+		// A restart marker that isn't where the interval count says leaves the scan unreadable.
+		u8* marker = nullptr;
+		for (u64 pos = data_size / 2; marker == nullptr; ++pos)
+		{
+			marker = (data[pos] == 0xff && data[pos + 1] >= 0xd0 && data[pos + 1] <= 0xd7) ? data + pos : nullptr;
+		}
+		marker[1] = 0xfe;
+		ASSERT(!OpenImage(&decoder, data, data_size, &arena));
+	}
+
+	void Run()
+	{
+		PngFixtures();
+		JpegRestartFixture();
+	}
+}
+}
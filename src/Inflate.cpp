@@ -0,0 +1,427 @@
+#include "Inflate.h"
+
+namespace Inflate
+{
+	static constexpr u32 MAX_CODE_LENGTH = 15;
+	static constexpr u32 FAST_BITS = 10;
+	static constexpr u32 FAST_MASK = (1u << FAST_BITS) - 1;
+
+	static constexpr u32 NUM_LITERAL_CODES = 288;
+	static constexpr u32 NUM_DISTANCE_CODES = 32;
+	static constexpr u32 NUM_CODE_LENGTH_CODES = 19;
+
+	static u16 const LENGTH_BASE[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static u8 const LENGTH_EXTRA[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static u16 const DISTANCE_BASE[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static u8 const DISTANCE_EXTRA[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	static u8 const CODE_LENGTH_ORDER[NUM_CODE_LENGTH_CODES] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// Deflate stores Huffman codes starting with their most significant bit, while everything
+	// else is read from the least significant bit up. The fast table is indexed by the next
+	// FAST_BITS input bits as they come, the slow path compares bit reversed codes.
+	struct Huffman
+	{
+		// (length << 9) | symbol, 0 for codes longer than FAST_BITS.
+		u16 fast[1 << FAST_BITS];
+
+		// Per length: first canonical code, index of its symbol in symbols, and the first code
+		// past the last one of that length, left aligned to 16 bits.
+		u16 first_code[MAX_CODE_LENGTH + 1];
+		u16 first_symbol[MAX_CODE_LENGTH + 1];
+		u32 max_code[MAX_CODE_LENGTH + 2];
+
+		// Sorted by code.
+		u16 symbols[NUM_LITERAL_CODES];
+	};
+
+	static u32 ReverseBits(u32 value, u32 num_bits)
+	{
+		u32 result = 0;
+		for (u32 i = 0; i < num_bits; ++i)
+		{
+			result = (result << 1) | (value & 1);
+			value >>= 1;
+		}
+		return result;
+	}
+
+	static bool BuildHuffman(Huffman* huffman, u8 const* lengths, u32 num_symbols)
+	{
+		u32 counts[MAX_CODE_LENGTH + 1] = {};
+		for (u32 i = 0; i < num_symbols; ++i)
+		{
+			counts[lengths[i]]++;
+		}
+		counts[0] = 0;
+
+		memset(huffman->fast, 0, sizeof(huffman->fast));
+
+		u32 next_code[MAX_CODE_LENGTH + 1];
+		u32 code = 0;
+		u32 symbol = 0;
+		for (u32 length = 1; length <= MAX_CODE_LENGTH; ++length)
+		{
+			next_code[length] = code;
+			huffman->first_code[length] = (u16)code;
+			huffman->first_symbol[length] = (u16)symbol;
+			code += counts[length];
+
+			// Over-subscribed, incomplete codes are fine (e.g. a single distance code).
+			if (counts[length] > 0 && code > (1u << length))
+			{
+				return false;
+			}
+
+			huffman->max_code[length] = code << (16 - length);
+			code <<= 1;
+			symbol += counts[length];
+		}
+		huffman->max_code[MAX_CODE_LENGTH + 1] = 0x10000;
+
+		for (u32 i = 0; i < num_symbols; ++i)
+		{
+			u32 const length = lengths[i];
+			if (length == 0)
+			{
+				continue;
+			}
+
+			u32 const sorted_idx = next_code[length] - huffman->first_code[length] + huffman->first_symbol[length];
+			huffman->symbols[sorted_idx] = (u16)i;
+
+			if (length <= FAST_BITS)
+			{
+				u16 const entry = (u16)((length << 9) | i);
+				for (u32 fast_idx = ReverseBits(next_code[length], length); fast_idx < (1u << FAST_BITS); fast_idx += 1u << length)
+				{
+					huffman->fast[fast_idx] = entry;
+				}
+			}
+			next_code[length]++;
+		}
+
+		return true;
+	}
+
+	struct BitReader
+	{
+		u8 const* src;
+		u64 src_size;
+		u64 pos; // Next byte to load, may run past src_size, see Refill().
+
+		u64 bits;
+		u32 num_bits;
+	};
+
+	// Keeps at least 56 bits buffered. Reads past the end load zeros, which corrupt streams
+	// may consume, callers check for that with Overran().
+	static __forceinline void Refill(BitReader* reader)
+	{
+		if (reader->pos + 8 <= reader->src_size)
+		{
+			u64 word;
+			memcpy(&word, reader->src + reader->pos, sizeof(word));
+			reader->bits |= word << reader->num_bits;
+			reader->pos += (63 - reader->num_bits) >> 3;
+			reader->num_bits |= 56;
+			return;
+		}
+
+		while (reader->num_bits <= 56)
+		{
+			u64 const byte = (reader->pos < reader->src_size) ? reader->src[reader->pos] : 0;
+			reader->bits |= byte << reader->num_bits;
+			reader->pos++;
+			reader->num_bits += 8;
+		}
+	}
+
+	static __forceinline u32 ReadBits(BitReader* reader, u32 count)
+	{
+		ASSERT(count <= reader->num_bits);
+		u32 const value = (u32)(reader->bits & ((1ull << count) - 1));
+		reader->bits >>= count;
+		reader->num_bits -= count;
+		return value;
+	}
+
+	static bool Overran(BitReader const* reader)
+	{
+		return reader->pos - reader->num_bits / 8 > reader->src_size;
+	}
+
+	// Needs at least MAX_CODE_LENGTH buffered bits. Returns ~0u for bit patterns without a code.
+	static __forceinline u32 DecodeSymbol(BitReader* reader, Huffman const* huffman)
+	{
+		u32 const entry = huffman->fast[reader->bits & FAST_MASK];
+		if (entry != 0)
+		{
+			u32 const length = entry >> 9;
+			reader->bits >>= length;
+			reader->num_bits -= length;
+			return entry & 511;
+		}
+
+		u32 const code = ReverseBits((u32)(reader->bits & 0xffff), 16);
+		u32 length = FAST_BITS + 1;
+		while (code >= huffman->max_code[length])
+		{
+			length++;
+		}
+		if (length > MAX_CODE_LENGTH)
+		{
+			return ~0u;
+		}
+
+		u32 const sorted_idx = (code >> (16 - length)) - huffman->first_code[length] + huffman->first_symbol[length];
+		reader->bits >>= length;
+		reader->num_bits -= length;
+		return huffman->symbols[sorted_idx];
+	}
+
+	static bool ReadDynamicTables(BitReader* reader, Huffman* literals, Huffman* distances)
+	{
+		Refill(reader);
+		u32 const num_literals = ReadBits(reader, 5) + 257;
+		u32 const num_distances = ReadBits(reader, 5) + 1;
+		u32 const num_code_lengths = ReadBits(reader, 4) + 4;
+
+		u8 code_length_lengths[NUM_CODE_LENGTH_CODES] = {};
+		for (u32 i = 0; i < num_code_lengths; ++i)
+		{
+			Refill(reader);
+			code_length_lengths[CODE_LENGTH_ORDER[i]] = (u8)ReadBits(reader, 3);
+		}
+
+		Huffman code_lengths;
+		if (!BuildHuffman(&code_lengths, code_length_lengths, NUM_CODE_LENGTH_CODES))
+		{
+			return false;
+		}
+
+		// Literal and distance lengths are one sequence, repeats may cross from one into the other.
+		u8 lengths[NUM_LITERAL_CODES + NUM_DISTANCE_CODES];
+		u32 const num_lengths = num_literals + num_distances;
+		u32 count = 0;
+		while (count < num_lengths)
+		{
+			Refill(reader);
+			u32 const symbol = DecodeSymbol(reader, &code_lengths);
+			if (symbol < 16)
+			{
+				lengths[count++] = (u8)symbol;
+				continue;
+			}
+
+			u8 fill = 0;
+			u32 repeat = 0;
+			if (symbol == 16)
+			{
+				if (count == 0)
+				{
+					return false;
+				}
+				fill = lengths[count - 1];
+				repeat = 3 + ReadBits(reader, 2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + ReadBits(reader, 3);
+			}
+			else if (symbol == 18)
+			{
+				repeat = 11 + ReadBits(reader, 7);
+			}
+			else
+			{
+				return false;
+			}
+
+			if (count + repeat > num_lengths)
+			{
+				return false;
+			}
+			memset(lengths + count, fill, repeat);
+			count += repeat;
+		}
+
+		return BuildHuffman(literals, lengths, num_literals) &&
+			BuildHuffman(distances, lengths + num_literals, num_distances);
+	}
+
+	static void BuildFixedTables(Huffman* literals, Huffman* distances)
+	{
+		u8 lengths[NUM_LITERAL_CODES];
+		memset(lengths + 0, 8, 144);
+		memset(lengths + 144, 9, 112);
+		memset(lengths + 256, 7, 24);
+		memset(lengths + 280, 8, 8);
+		BuildHuffman(literals, lengths, NUM_LITERAL_CODES);
+
+		memset(lengths, 5, NUM_DISTANCE_CODES);
+		BuildHuffman(distances, lengths, NUM_DISTANCE_CODES);
+	}
+
+	static bool InflateBlock(BitReader* reader, Huffman const* literals, Huffman const* distances, u8* dst, u64 dst_size, u64* cursor)
+	{
+		u8* out = dst + *cursor;
+		u8* const out_end = dst + dst_size;
+
+		for (;;)
+		{
+			// Enough bits for a literal/length code with its extra bits and a distance code,
+			// the distance's extra bits get another refill.
+			Refill(reader);
+			u32 const symbol = DecodeSymbol(reader, literals);
+			if (symbol < 256)
+			{
+				if (out == out_end)
+				{
+					return false;
+				}
+				*out++ = (u8)symbol;
+				continue;
+			}
+
+			if (symbol == 256)
+			{
+				break;
+			}
+
+			u32 const length_code = symbol - 257;
+			if (length_code >= 29)
+			{
+				return false;
+			}
+			u32 const length = LENGTH_BASE[length_code] + ReadBits(reader, LENGTH_EXTRA[length_code]);
+
+			u32 const distance_code = DecodeSymbol(reader, distances);
+			if (distance_code >= 30)
+			{
+				return false;
+			}
+			Refill(reader);
+			u32 const distance = DISTANCE_BASE[distance_code] + ReadBits(reader, DISTANCE_EXTRA[distance_code]);
+
+			if (distance > (u64)(out - dst) || length > (u64)(out_end - out))
+			{
+				return false;
+			}
+
+			// Matches may overlap their own output, only copy in words when they can't.
+			u8 const* match = out - distance;
+			if (distance >= 8 && (u64)(out_end - out) >= length + 8)
+			{
+				for (u32 i = 0; i < length; i += 8)
+				{
+					memcpy(out + i, match + i, 8);
+				}
+			}
+			else
+			{
+				for (u32 i = 0; i < length; ++i)
+				{
+					out[i] = match[i];
+				}
+			}
+			out += length;
+		}
+
+		*cursor = out - dst;
+		return true;
+	}
+
+	static bool CopyStoredBlock(BitReader* reader, u8* dst, u64 dst_size, u64* cursor)
+	{
+		// Drop the bits up to the next byte boundary, then hand the buffered bytes back.
+		ReadBits(reader, reader->num_bits & 7);
+		reader->pos -= reader->num_bits / 8;
+		reader->bits = 0;
+		reader->num_bits = 0;
+
+		if (reader->pos + 4 > reader->src_size)
+		{
+			return false;
+		}
+
+		u8 const* header = reader->src + reader->pos;
+		u32 const length = header[0] | (header[1] << 8);
+		u32 const inverted_length = header[2] | (header[3] << 8);
+		reader->pos += 4;
+
+		if ((length ^ 0xffff) != inverted_length || reader->pos + length > reader->src_size || *cursor + length > dst_size)
+		{
+			return false;
+		}
+
+		memcpy(dst + *cursor, reader->src + reader->pos, length);
+		reader->pos += length;
+		*cursor += length;
+		return true;
+	}
+
+	bool DecodeZlib(u8* dst, u64 dst_size, u8 const* src, u64 src_size, u64* out_written)
+	{
+		*out_written = 0;
+		if (src_size < 2)
+		{
+			return false;
+		}
+
+		// Deflate with at most a 32K window, no preset dictionary.
+		u32 const cmf = src[0];
+		u32 const flags = src[1];
+		if ((cmf & 15) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flags) % 31 != 0 || (flags & 0x20))
+		{
+			return false;
+		}
+
+		BitReader reader;
+		reader.src = src;
+		reader.src_size = src_size;
+		reader.pos = 2;
+		reader.bits = 0;
+		reader.num_bits = 0;
+
+		Huffman literals;
+		Huffman distances;
+
+		u64 cursor = 0;
+		bool b_final_block = false;
+		while (!b_final_block)
+		{
+			Refill(&reader);
+			b_final_block = ReadBits(&reader, 1) != 0;
+			u32 const block_type = ReadBits(&reader, 2);
+
+			bool b_ok = false;
+			if (block_type == 0)
+			{
+				b_ok = CopyStoredBlock(&reader, dst, dst_size, &cursor);
+			}
+			else if (block_type == 1)
+			{
+				BuildFixedTables(&literals, &distances);
+				b_ok = InflateBlock(&reader, &literals, &distances, dst, dst_size, &cursor);
+			}
+			else if (block_type == 2)
+			{
+				b_ok = ReadDynamicTables(&reader, &literals, &distances) &&
+					InflateBlock(&reader, &literals, &distances, dst, dst_size, &cursor);
+			}
+
+			if (!b_ok || Overran(&reader))
+			{
+				return false;
+			}
+		}
+
+		*out_written = cursor;
+		return true;
+	}
+}
\ No newline at end of file
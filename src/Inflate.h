@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Core.h"
+
+// ====================================
+//  Inflate (RFC 1950 / 1951)
+//  Notes:
+//  *) Decodes a whole zlib stream into a buffer of known size,
+//     which is all PNG needs. No streaming, no preset dictionaries.
+//  *) Huffman codes up to 10 bits resolve with a single table
+//     lookup, longer ones fall back to a canonical code search.
+//  *) The adler32 checksum is not verified.
+// ====================================
+
+namespace Inflate
+{
+	// Returns false on corrupt or truncated data and if dst is too small. On success
+	// out_written holds the number of bytes decoded, the rest of dst is untouched.
+	bool DecodeZlib(u8* dst, u64 dst_size, u8 const* src, u64 src_size, u64* out_written);
+}
\ No newline at end of file
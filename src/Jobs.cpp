@@ -0,0 +1,289 @@
+#include "Jobs.h"
+
+#include <condition_variable>
+
+namespace Jobs
+{
+	static constexpr u32 MAX_WORKERS = MAX_THREADS - 1;
+	static constexpr u32 MAX_QUEUED_JOBS = 4096;
+
+	struct QueuedJob
+	{
+		Job job;
+		Counter* counter;
+	};
+
+	struct JobSystem
+	{
+		std::thread m_workers[MAX_WORKERS];
+		u32 m_num_workers;
+
+		std::mutex m_lock;
+		std::condition_variable m_wake;
+		bool m_b_exit;
+
+		// Ring buffer, guarded by m_lock.
+		QueuedJob m_queue[MAX_QUEUED_JOBS];
+		u32 m_head;
+		u32 m_count;
+	};
+
+	static JobSystem* s_jobs = nullptr;
+	thread_local static u32 s_thread_index = 0;
+
+	static bool TryPop(JobSystem* jobs, QueuedJob* out_job)
+	{
+		if (jobs->m_count == 0)
+		{
+			return false;
+		}
+
+		*out_job = jobs->m_queue[jobs->m_head];
+		jobs->m_head = (jobs->m_head + 1) % MAX_QUEUED_JOBS;
+		jobs->m_count--;
+		return true;
+	}
+
+	// Like TryPop, but only takes the oldest job of the given counter. The jobs queued
+	// behind it move up one slot, so the queue stays in submission order.
+	static bool TryPopFor(JobSystem* jobs, Counter const* counter, QueuedJob* out_job)
+	{
+		for (u32 i = 0; i < jobs->m_count; ++i)
+		{
+			u32 slot = (jobs->m_head + i) % MAX_QUEUED_JOBS;
+			if (jobs->m_queue[slot].counter != counter)
+			{
+				continue;
+			}
+
+			*out_job = jobs->m_queue[slot];
+			for (u32 j = i + 1; j < jobs->m_count; ++j)
+			{
+				u32 next = (jobs->m_head + j) % MAX_QUEUED_JOBS;
+				jobs->m_queue[slot] = jobs->m_queue[next];
+				slot = next;
+			}
+			jobs->m_count--;
+			return true;
+		}
+		return false;
+	}
+
+	static void Execute(QueuedJob const& queued)
+	{
+		queued.job.func(queued.job.user_data);
+		queued.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	static void WorkerMain(u32 thread_index)
+	{
+		s_thread_index = thread_index;
+
+		while (true)
+		{
+			QueuedJob queued;
+			{
+				std::unique_lock<std::mutex> lock(s_jobs->m_lock);
+				s_jobs->m_wake.wait(lock, []() { return s_jobs->m_b_exit || s_jobs->m_count > 0; });
+
+				if (!TryPop(s_jobs, &queued))
+				{
+					return; // Exit was requested and the queue is drained.
+				}
+			}
+
+			Execute(queued);
+		}
+	}
+
+	void Init(u32 num_workers)
+	{
+		ASSERT(s_jobs == nullptr);
+
+		if (num_workers == 0)
+		{
+			u32 hw_threads = std::thread::hardware_concurrency();
+			num_workers = (hw_threads > 1) ? hw_threads - 1 : 0;
+		}
+
+		s_jobs = new JobSystem();
+		s_jobs->m_num_workers = min(num_workers, MAX_WORKERS);
+		s_jobs->m_b_exit = false;
+		s_jobs->m_head = 0;
+		s_jobs->m_count = 0;
+
+		for (u32 i = 0; i < s_jobs->m_num_workers; ++i)
+		{
+			s_jobs->m_workers[i] = std::thread(WorkerMain, i + 1);
+		}
+
+		LOG(Log::Default, "Started job system with %u workers", s_jobs->m_num_workers);
+	}
+
+	void Exit()
+	{
+		if (s_jobs == nullptr)
+		{
+			return;
+		}
+
+		{
+			ScopedLock lock(s_jobs->m_lock);
+			s_jobs->m_b_exit = true;
+		}
+		s_jobs->m_wake.notify_all();
+
+		for (u32 i = 0; i < s_jobs->m_num_workers; ++i)
+		{
+			s_jobs->m_workers[i].join();
+		}
+
+		delete s_jobs;
+		s_jobs = nullptr;
+	}
+
+	u32 GetThreadCount()
+	{
+		return s_jobs ? s_jobs->m_num_workers + 1 : 1;
+	}
+
+	u32 GetThreadIndex()
+	{
+		return s_thread_index;
+	}
+
+	void Submit(Job const* jobs, u32 count, Counter* counter)
+	{
+		counter->pending.fetch_add(count, std::memory_order_relaxed);
+
+		if (s_jobs == nullptr || s_jobs->m_num_workers == 0)
+		{
+			for (u32 i = 0; i < count; ++i)
+			{
+				QueuedJob queued = { jobs[i], counter };
+				Execute(queued);
+			}
+			return;
+		}
+
+		u32 submitted = 0;
+		while (submitted < count)
+		{
+			{
+				ScopedLock lock(s_jobs->m_lock);
+				while (submitted < count && s_jobs->m_count < MAX_QUEUED_JOBS)
+				{
+					u32 tail = (s_jobs->m_head + s_jobs->m_count) % MAX_QUEUED_JOBS;
+					s_jobs->m_queue[tail].job = jobs[submitted++];
+					s_jobs->m_queue[tail].counter = counter;
+					s_jobs->m_count++;
+				}
+			}
+			s_jobs->m_wake.notify_all();
+
+			// Queue is full, run the next one ourselves instead of blocking. Not some other
+			// queued job, that could be anything and would nest on top of the caller.
+			if (submitted < count)
+			{
+				QueuedJob queued = { jobs[submitted++], counter };
+				Execute(queued);
+			}
+		}
+	}
+
+	bool IsDone(Counter const* counter)
+	{
+		return counter->pending.load(std::memory_order_acquire) == 0;
+	}
+
+	void WaitForCounter(Counter* counter)
+	{
+		while (!IsDone(counter))
+		{
+			QueuedJob queued;
+			bool popped = false;
+			if (s_jobs)
+			{
+				ScopedLock lock(s_jobs->m_lock);
+				popped = TryPopFor(s_jobs, counter, &queued);
+			}
+
+			if (popped)
+			{
+				Execute(queued);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	struct ParallelForTask
+	{
+		RangeFunc func;
+		void* user_data;
+		u64 count;
+		u64 batch_size;
+		std::atomic<u64> next_batch;
+	};
+
+	static void RunParallelForBatches(void* user_data)
+	{
+		ParallelForTask* task = static_cast<ParallelForTask*>(user_data);
+
+		while (true)
+		{
+			u64 begin = task->next_batch.fetch_add(1, std::memory_order_relaxed) * task->batch_size;
+			if (begin >= task->count)
+			{
+				break;
+			}
+
+			u64 end = min(begin + task->batch_size, task->count);
+			task->func(task->user_data, begin, end);
+		}
+	}
+
+	void ParallelFor(u64 count, u64 batch_size, RangeFunc func, void* user_data)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		batch_size = max<u64>(batch_size, 1);
+		u64 const num_batches = (count + batch_size - 1) / batch_size;
+
+		if (num_batches == 1 || GetThreadCount() == 1)
+		{
+			func(user_data, 0, count);
+			return;
+		}
+
+		ParallelForTask task;
+		task.func = func;
+		task.user_data = user_data;
+		task.count = count;
+		task.batch_size = batch_size;
+		task.next_batch = 0;
+
+		// Every helper pulls batches until none are left, so we never need more
+		// helpers than there are batches, and the calling thread is one of them.
+		u32 const num_helpers = static_cast<u32>(min<u64>(num_batches, GetThreadCount()) - 1);
+
+		Job helper_jobs[MAX_WORKERS];
+		for (u32 i = 0; i < num_helpers; ++i)
+		{
+			helper_jobs[i].func = &RunParallelForBatches;
+			helper_jobs[i].user_data = &task;
+		}
+
+		Counter counter;
+		counter.pending = 0;
+		Submit(helper_jobs, num_helpers, &counter);
+
+		RunParallelForBatches(&task);
+		WaitForCounter(&counter);
+	}
+}
\ No newline at end of file
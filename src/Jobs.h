@@ -0,0 +1,55 @@
+#pragma once
+#include "Core.h"
+
+// ====================================
+//  Job System
+//  Notes:
+//  *) Fixed pool of worker threads pulling from a single locked queue.
+//  *) Waiting threads help execute the jobs of the counter they wait on, so
+//     waiting from inside a job is fine. They never pick up unrelated jobs,
+//     those would nest on top of the waiting one (its stack, its per-thread
+//     scratch memory) for as long as they run.
+//  *) Without Init() everything executes inline on the calling thread.
+// ====================================
+
+namespace Jobs
+{
+	// Upper bound of GetThreadCount(), for sizing per-thread data.
+	static constexpr u32 MAX_THREADS = 64;
+
+	// Pass 0 to use one worker per hardware thread, minus the calling thread.
+	void Init(u32 num_workers = 0);
+	void Exit();
+
+	// Number of threads that execute jobs, including the main thread.
+	u32 GetThreadCount();
+
+	// 0 for threads not owned by the job system, [1, GetThreadCount()) for workers.
+	// Use this to index per-thread data (e.g. scratch arenas), which means only one
+	// outside thread (the app thread) should be kicking off jobs at a time.
+	u32 GetThreadIndex();
+
+	struct Counter
+	{
+		atomic_u32 pending;
+	};
+
+	typedef void (*JobFunc)(void* user_data);
+
+	struct Job
+	{
+		JobFunc func;
+		void* user_data;
+	};
+
+	// Increments the counter by count, each finished job decrements it again.
+	// Runs jobs inline when the queue is full.
+	void Submit(Job const* jobs, u32 count, Counter* counter);
+	bool IsDone(Counter const* counter);
+	void WaitForCounter(Counter* counter);
+
+	typedef void (*RangeFunc)(void* user_data, u64 begin, u64 end);
+
+	// Splits [0, count) into batches of at most batch_size and blocks until all of them ran.
+	void ParallelFor(u64 count, u64 batch_size, RangeFunc func, void* user_data);
+}
\ No newline at end of file
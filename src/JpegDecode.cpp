@@ -0,0 +1,950 @@
+#include "ImageDecode.h"
+#include "Simd.h"
+
+namespace Image
+{
+	namespace Jpeg
+	{
+		static constexpr u32 MAX_COMPONENTS = 3;
+		static constexpr u32 MAX_SAMPLING = 4;
+		static constexpr u32 FAST_BITS = 9;
+
+		// Ranges are sized to about this many pixels, enough to make a job worth it.
+		static constexpr u32 PIXELS_PER_RANGE = 256 * 256;
+
+		// Zigzag position -> row major position in the 8x8 block.
+		static u8 const ZIGZAG[64] = {
+			0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+			12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+			35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+			58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+		struct Huffman
+		{
+			// (length << 8) | symbol, 0 for codes longer than FAST_BITS.
+			u16 fast[1 << FAST_BITS];
+
+			// Same canonical code search as in Inflate.cpp, without the bit reversal.
+			u16 first_code[17];
+			u16 first_symbol[17];
+			u32 max_code[18];
+			u8 symbols[256];
+
+			bool b_defined;
+		};
+
+		struct Component
+		{
+			u8 id;
+			u8 h;
+			u8 v;
+			u8 quant_table;
+			u8 dc_table;
+			u8 ac_table;
+
+			// log2(max sampling / sampling), chroma is upsampled by replication.
+			u8 shift_x;
+			u8 shift_y;
+		};
+
+		struct State
+		{
+			// In zigzag order, like the coefficients in the stream.
+			u16 quant[4][64];
+			bool b_quant_defined[4];
+
+			Huffman dc[4];
+			Huffman ac[4];
+
+			Component components[MAX_COMPONENTS];
+			u32 num_components;
+			u32 max_h;
+			u32 max_v;
+			bool b_rgb;
+
+			u32 mcus_x;
+			u32 mcus_y;
+
+			// MCUs per restart interval, the whole image without restart markers.
+			u32 restart_interval;
+			u32 num_intervals;
+			u64* interval_offsets; // Start of each interval's entropy coded data.
+			u32 intervals_per_range;
+		};
+
+		static u32 ReadU16BE(u8 const* bytes)
+		{
+			return (bytes[0] << 8) | bytes[1];
+		}
+
+		static bool BuildHuffman(Huffman* huffman, u8 const* counts, u8 const* symbols, u32 num_symbols)
+		{
+			memset(huffman->fast, 0, sizeof(huffman->fast));
+			memcpy(huffman->symbols, symbols, num_symbols);
+
+			u32 code = 0;
+			u32 symbol = 0;
+			for (u32 length = 1; length <= 16; ++length)
+			{
+				u32 const count = counts[length - 1];
+				huffman->first_code[length] = (u16)code;
+				huffman->first_symbol[length] = (u16)symbol;
+
+				for (u32 i = 0; i < count; ++i, ++code, ++symbol)
+				{
+					if (length <= FAST_BITS)
+					{
+						u32 const first = code << (FAST_BITS - length);
+						u32 const num_entries = 1u << (FAST_BITS - length);
+						for (u32 entry = 0; entry < num_entries; ++entry)
+						{
+							huffman->fast[first + entry] = (u16)((length << 8) | symbols[symbol]);
+						}
+					}
+				}
+
+				if (code > (1u << length))
+				{
+					return false;
+				}
+				huffman->max_code[length] = code << (16 - length);
+				code <<= 1;
+			}
+			huffman->max_code[17] = ~0u;
+
+			huffman->b_defined = true;
+			return true;
+		}
+
+		// ====================================
+		//  Headers
+		// ====================================
+
+		static bool ReadQuantTables(State* jpeg, u8 const* segment, u32 length)
+		{
+			u32 pos = 0;
+			while (pos < length)
+			{
+				u32 const precision = segment[pos] >> 4;
+				u32 const table = segment[pos] & 15;
+				u32 const entry_size = precision ? 2 : 1;
+				pos++;
+
+				if (table >= 4 || precision > 1 || pos + 64 * entry_size > length)
+				{
+					return false;
+				}
+
+				for (u32 i = 0; i < 64; ++i)
+				{
+					jpeg->quant[table][i] = (u16)(precision ? ReadU16BE(segment + pos + i * 2) : segment[pos + i]);
+				}
+				jpeg->b_quant_defined[table] = true;
+				pos += 64 * entry_size;
+			}
+			return true;
+		}
+
+		static bool ReadHuffmanTables(State* jpeg, u8 const* segment, u32 length)
+		{
+			u32 pos = 0;
+			while (pos < length)
+			{
+				if (pos + 17 > length)
+				{
+					return false;
+				}
+
+				u32 const table_class = segment[pos] >> 4;
+				u32 const table = segment[pos] & 15;
+				u8 const* counts = segment + pos + 1;
+				pos += 17;
+
+				u32 num_symbols = 0;
+				for (u32 i = 0; i < 16; ++i)
+				{
+					num_symbols += counts[i];
+				}
+
+				if (table_class > 1 || table >= 4 || num_symbols > 256 || pos + num_symbols > length)
+				{
+					return false;
+				}
+
+				Huffman* huffman = table_class ? &jpeg->ac[table] : &jpeg->dc[table];
+				if (!BuildHuffman(huffman, counts, segment + pos, num_symbols))
+				{
+					return false;
+				}
+				pos += num_symbols;
+			}
+			return true;
+		}
+
+		static bool ReadFrame(State* jpeg, Decoder* decoder, u8 const* segment, u32 length)
+		{
+			if (length < 6)
+			{
+				return false;
+			}
+
+			u32 const precision = segment[0];
+			decoder->height = ReadU16BE(segment + 1);
+			decoder->width = ReadU16BE(segment + 3);
+			jpeg->num_components = segment[5];
+
+			// A height of 0 would come later in a DNL marker.
+			if (precision != 8 || decoder->width == 0 || decoder->height == 0 ||
+				(jpeg->num_components != 1 && jpeg->num_components != 3) || length < 6 + jpeg->num_components * 3)
+			{
+				return false;
+			}
+
+			jpeg->max_h = 1;
+			jpeg->max_v = 1;
+			for (u32 comp_idx = 0; comp_idx < jpeg->num_components; ++comp_idx)
+			{
+				Component* comp = &jpeg->components[comp_idx];
+				u8 const* spec = segment + 6 + comp_idx * 3;
+				comp->id = spec[0];
+				comp->h = spec[1] >> 4;
+				comp->v = spec[1] & 15;
+				comp->quant_table = spec[2];
+
+				if (comp->h == 0 || comp->h > MAX_SAMPLING || comp->v == 0 || comp->v > MAX_SAMPLING || comp->quant_table >= 4)
+				{
+					return false;
+				}
+				jpeg->max_h = max<u32>(jpeg->max_h, comp->h);
+				jpeg->max_v = max<u32>(jpeg->max_v, comp->v);
+			}
+
+			// A single component scan isn't interleaved, its MCU is one block whatever the sampling says.
+			if (jpeg->num_components == 1)
+			{
+				jpeg->components[0].h = jpeg->components[0].v = 1;
+				jpeg->max_h = jpeg->max_v = 1;
+			}
+
+			for (u32 comp_idx = 0; comp_idx < jpeg->num_components; ++comp_idx)
+			{
+				Component* comp = &jpeg->components[comp_idx];
+				u32 const ratio_x = jpeg->max_h / comp->h;
+				u32 const ratio_y = jpeg->max_v / comp->v;
+				if (ratio_x * comp->h != jpeg->max_h || ratio_y * comp->v != jpeg->max_v ||
+					(ratio_x & (ratio_x - 1)) != 0 || (ratio_y & (ratio_y - 1)) != 0)
+				{
+					return false;
+				}
+				comp->shift_x = (u8)(ratio_x == 4 ? 2 : ratio_x - 1);
+				comp->shift_y = (u8)(ratio_y == 4 ? 2 : ratio_y - 1);
+			}
+
+			jpeg->mcus_x = (decoder->width + jpeg->max_h * 8 - 1) / (jpeg->max_h * 8);
+			jpeg->mcus_y = (decoder->height + jpeg->max_v * 8 - 1) / (jpeg->max_v * 8);
+			return true;
+		}
+
+		static bool ReadScanHeader(State* jpeg, u8 const* segment, u32 length)
+		{
+			// Only scans that hold every component, i.e. a single scan for the whole image.
+			u32 const num_scan_components = (length > 0) ? segment[0] : 0;
+			if (num_scan_components != jpeg->num_components || length < 4 + num_scan_components * 2)
+			{
+				return false;
+			}
+
+			for (u32 scan_idx = 0; scan_idx < num_scan_components; ++scan_idx)
+			{
+				u8 const id = segment[1 + scan_idx * 2];
+				u8 const tables = segment[2 + scan_idx * 2];
+
+				Component* comp = nullptr;
+				for (u32 comp_idx = 0; comp_idx < jpeg->num_components; ++comp_idx)
+				{
+					if (jpeg->components[comp_idx].id == id)
+					{
+						comp = &jpeg->components[comp_idx];
+					}
+				}
+
+				// Scan order has to match frame order, that's the order blocks come in.
+				if (comp != &jpeg->components[scan_idx])
+				{
+					return false;
+				}
+
+				comp->dc_table = tables >> 4;
+				comp->ac_table = tables & 15;
+				if (comp->dc_table >= 4 || comp->ac_table >= 4 || !jpeg->dc[comp->dc_table].b_defined ||
+					!jpeg->ac[comp->ac_table].b_defined || !jpeg->b_quant_defined[comp->quant_table])
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Finds where each restart interval's data starts, so ranges of them can be decoded
+		// independently. Stops at the first marker that isn't a restart marker.
+		static bool FindRestartIntervals(State* jpeg, u8 const* data, u64 data_size, u64 scan_start, Memory::Arena* memory)
+		{
+			u32 const num_mcus = jpeg->mcus_x * jpeg->mcus_y;
+			if (jpeg->restart_interval == 0 || jpeg->restart_interval > num_mcus)
+			{
+				jpeg->restart_interval = num_mcus;
+			}
+
+			jpeg->num_intervals = (num_mcus + jpeg->restart_interval - 1) / jpeg->restart_interval;
+			jpeg->interval_offsets = Memory::PushType<u64>(memory, jpeg->num_intervals);
+			jpeg->interval_offsets[0] = scan_start;
+
+			u32 num_found = 1;
+			u64 pos = scan_start;
+			while (num_found < jpeg->num_intervals && pos + 1 < data_size)
+			{
+				u8 const* marker = static_cast<u8 const*>(memchr(data + pos, 0xff, data_size - pos - 1));
+				if (marker == nullptr)
+				{
+					break;
+				}
+
+				pos = marker - data;
+				u8 const code = data[pos + 1];
+				if (code == 0x00 || code == 0xff)
+				{
+					// Stuffed 0xff byte in the data, or fill bytes before a marker.
+					pos += (code == 0x00) ? 2 : 1;
+				}
+				else if (code >= 0xd0 && code <= 0xd7)
+				{
+					pos += 2;
+					jpeg->interval_offsets[num_found++] = pos;
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			return num_found == jpeg->num_intervals;
+		}
+
+		bool Open(Decoder* decoder, Memory::Arena* memory)
+		{
+			State* jpeg = Memory::PushType<State>(memory, 1, Memory::ZeroPush());
+			decoder->state = jpeg;
+
+			u8 const* data = decoder->data;
+			u64 const data_size = decoder->data_size;
+
+			bool b_has_frame = false;
+			s32 adobe_transform = -1;
+			u64 pos = 2;
+			for (;;)
+			{
+				if (pos + 2 > data_size || data[pos] != 0xff)
+				{
+					return false;
+				}
+
+				u8 const marker = data[pos + 1];
+				pos += 2;
+
+				// Fill bytes, and markers without a segment.
+				if (marker == 0xff)
+				{
+					pos--;
+					continue;
+				}
+				if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8))
+				{
+					continue;
+				}
+				if (marker == 0xd9)
+				{
+					return false;
+				}
+
+				if (pos + 2 > data_size)
+				{
+					return false;
+				}
+				u32 const segment_size = ReadU16BE(data + pos);
+				if (segment_size < 2 || pos + segment_size > data_size)
+				{
+					return false;
+				}
+				u8 const* segment = data + pos + 2;
+				u32 const length = segment_size - 2;
+
+				bool b_ok = true;
+				switch (marker)
+				{
+				case 0xdb: // DQT
+					b_ok = ReadQuantTables(jpeg, segment, length);
+					break;
+				case 0xc4: // DHT
+					b_ok = ReadHuffmanTables(jpeg, segment, length);
+					break;
+				case 0xc0: // SOF0, baseline
+				case 0xc1: // SOF1, extended sequential
+					b_ok = !b_has_frame && ReadFrame(jpeg, decoder, segment, length);
+					b_has_frame = true;
+					break;
+				case 0xc2: case 0xc3: case 0xc5: case 0xc6: case 0xc7: // Progressive, lossless, hierarchical
+				case 0xc9: case 0xca: case 0xcb: case 0xcd: case 0xce: case 0xcf: // Arithmetic coding
+					b_ok = false;
+					break;
+				case 0xdd: // DRI
+					b_ok = length >= 2;
+					jpeg->restart_interval = b_ok ? ReadU16BE(segment) : 0;
+					break;
+				case 0xee: // APP14, Adobe. The transform flag tells RGB from YCbCr.
+					if (length >= 12 && memcmp(segment, "Adobe", 5) == 0)
+					{
+						adobe_transform = segment[11];
+					}
+					break;
+				case 0xda: // SOS, the entropy coded data follows right after
+				{
+					if (!b_has_frame || !ReadScanHeader(jpeg, segment, length))
+					{
+						return false;
+					}
+
+					Component const* comps = jpeg->components;
+					jpeg->b_rgb = (jpeg->num_components == 3) &&
+						(adobe_transform == 0 || (adobe_transform < 0 && comps[0].id == 'R' && comps[1].id == 'G' && comps[2].id == 'B'));
+
+					if (!FindRestartIntervals(jpeg, data, data_size, pos + segment_size, memory))
+					{
+						return false;
+					}
+
+					u32 const pixels_per_interval = jpeg->restart_interval * jpeg->max_h * jpeg->max_v * 64;
+					jpeg->intervals_per_range = max<u32>(PIXELS_PER_RANGE / pixels_per_interval, 1);
+					decoder->num_ranges = (jpeg->num_intervals + jpeg->intervals_per_range - 1) / jpeg->intervals_per_range;
+
+					// One MCU worth of samples per component, plus room for the arena's alignment.
+					decoder->scratch_size = MAX_COMPONENTS * (MAX_SAMPLING * 8) * (MAX_SAMPLING * 8) + MAX_COMPONENTS * 64;
+					return true;
+				}
+				default: // APPn, COM, ...
+					break;
+				}
+
+				if (!b_ok)
+				{
+					return false;
+				}
+				pos += segment_size;
+			}
+		}
+
+		// ====================================
+		//  Entropy decoding
+		// ====================================
+
+		struct BitReader
+		{
+			u8 const* data;
+			u64 data_size;
+			u64 pos;
+
+			// Left aligned, the next bit is the top one.
+			u64 bits;
+			u32 num_bits;
+
+			// Past the end of the interval's data, zeros are shifted in from there on.
+			bool b_hit_marker;
+		};
+
+		static __forceinline void Refill(BitReader* reader)
+		{
+			// Whole words while there is no 0xff byte that could be stuffing or a marker. The bytes
+			// past the counted ones are the stream's next bytes, the next refill ORs in the same bits.
+			if (!reader->b_hit_marker && reader->pos + 8 <= reader->data_size)
+			{
+				u64 word;
+				memcpy(&word, reader->data + reader->pos, sizeof(word));
+				u64 const inverted = ~word;
+				bool const b_has_ff = ((inverted - 0x0101010101010101ull) & ~inverted & 0x8080808080808080ull) != 0;
+				if (!b_has_ff)
+				{
+					reader->bits |= _byteswap_uint64(word) >> reader->num_bits;
+					reader->pos += (63 - reader->num_bits) >> 3;
+					reader->num_bits |= 56;
+					return;
+				}
+			}
+
+			while (reader->num_bits <= 56)
+			{
+				u32 byte = 0;
+				if (!reader->b_hit_marker && reader->pos < reader->data_size)
+				{
+					byte = reader->data[reader->pos];
+					if (byte != 0xff)
+					{
+						reader->pos++;
+					}
+					else if (reader->pos + 1 < reader->data_size && reader->data[reader->pos + 1] == 0x00)
+					{
+						reader->pos += 2;
+					}
+					else
+					{
+						reader->b_hit_marker = true;
+						byte = 0;
+					}
+				}
+
+				reader->bits |= (u64)byte << (56 - reader->num_bits);
+				reader->num_bits += 8;
+			}
+		}
+
+		// Needs at least 16 buffered bits. Returns ~0u for bit patterns without a code.
+		static __forceinline u32 DecodeSymbol(BitReader* reader, Huffman const* huffman)
+		{
+			u32 const entry = huffman->fast[reader->bits >> (64 - FAST_BITS)];
+			if (entry != 0)
+			{
+				u32 const length = entry >> 8;
+				reader->bits <<= length;
+				reader->num_bits -= length;
+				return entry & 255;
+			}
+
+			u32 const code = (u32)(reader->bits >> 48);
+			u32 length = FAST_BITS + 1;
+			while (code >= huffman->max_code[length])
+			{
+				length++;
+			}
+			if (length > 16)
+			{
+				return ~0u;
+			}
+
+			u32 const sorted_idx = (code >> (16 - length)) - huffman->first_code[length] + huffman->first_symbol[length];
+			reader->bits <<= length;
+			reader->num_bits -= length;
+			return huffman->symbols[sorted_idx & 255];
+		}
+
+		// Reads a size bits magnitude, values with a leading zero bit are negative.
+		static __forceinline s32 ReceiveExtend(BitReader* reader, u32 size)
+		{
+			if (size == 0)
+			{
+				return 0;
+			}
+
+			u32 const bits = (u32)(reader->bits >> (64 - size));
+			reader->bits <<= size;
+			reader->num_bits -= size;
+
+			s32 const value = (s32)bits;
+			return (value < (1 << (size - 1))) ? value - (1 << size) + 1 : value;
+		}
+
+		// Dequantized coefficients in row major order.
+		static bool DecodeBlock(BitReader* reader, Huffman const* dc, Huffman const* ac, u16 const* quant, s32* dc_prediction, s32* coefficients)
+		{
+			memset(coefficients, 0, sizeof(s32) * 64);
+
+			Refill(reader);
+			u32 const dc_size = DecodeSymbol(reader, dc);
+			if (dc_size > 11)
+			{
+				return false;
+			}
+			*dc_prediction += ReceiveExtend(reader, dc_size);
+			coefficients[0] = *dc_prediction * quant[0];
+
+			for (u32 k = 1; k < 64;)
+			{
+				// Code plus magnitude take at most 16 + 15 bits.
+				if (reader->num_bits < 32)
+				{
+					Refill(reader);
+				}
+
+				u32 const symbol = DecodeSymbol(reader, ac);
+				if (symbol == ~0u)
+				{
+					return false;
+				}
+
+				u32 const run = symbol >> 4;
+				u32 const size = symbol & 15;
+				if (size == 0)
+				{
+					if (run != 15)
+					{
+						break; // End of block
+					}
+					k += 16;
+					continue;
+				}
+
+				k += run;
+				if (k >= 64)
+				{
+					return false;
+				}
+				coefficients[ZIGZAG[k]] = ReceiveExtend(reader, size) * quant[k];
+				k++;
+			}
+
+			return true;
+		}
+
+		// ====================================
+		//  Reconstruction
+		// ====================================
+
+		// Separable integer IDCT with 13 bit constants, the same arithmetic as libjpeg's
+		// jidctint.c (Loeffler, Ligtenberg & Moschytz). Columns first, then rows.
+		static constexpr s32 CONST_BITS = 13;
+		static constexpr s32 PASS1_BITS = 2;
+
+		static constexpr s32 FIX_0_298631336 = 2446;
+		static constexpr s32 FIX_0_390180644 = 3196;
+		static constexpr s32 FIX_0_541196100 = 4433;
+		static constexpr s32 FIX_0_765366865 = 6270;
+		static constexpr s32 FIX_0_899976223 = 7373;
+		static constexpr s32 FIX_1_175875602 = 9633;
+		static constexpr s32 FIX_1_501321110 = 12299;
+		static constexpr s32 FIX_1_847759065 = 15137;
+		static constexpr s32 FIX_1_961570560 = 16069;
+		static constexpr s32 FIX_2_053119869 = 16819;
+		static constexpr s32 FIX_2_562915447 = 20995;
+		static constexpr s32 FIX_3_072711026 = 25172;
+
+		// One 1D IDCT over 4 lanes at once, in[k] holds coefficient k of every lane. The results carry the
+		// constants' 2^CONST_BITS scale.
+		static __forceinline void Idct1D(__m128i const in[8], __m128i out[8])
+		{
+			auto mul = [](__m128i a, s32 factor) { return _mm_mullo_epi32(a, _mm_set1_epi32(factor)); };
+
+			// Even part
+			__m128i z2 = in[2];
+			__m128i z3 = in[6];
+			__m128i z1 = mul(_mm_add_epi32(z2, z3), FIX_0_541196100);
+			__m128i tmp2 = _mm_sub_epi32(z1, mul(z3, FIX_1_847759065));
+			__m128i tmp3 = _mm_add_epi32(z1, mul(z2, FIX_0_765366865));
+
+			z2 = in[0];
+			z3 = in[4];
+			__m128i tmp0 = _mm_slli_epi32(_mm_add_epi32(z2, z3), CONST_BITS);
+			__m128i tmp1 = _mm_slli_epi32(_mm_sub_epi32(z2, z3), CONST_BITS);
+
+			__m128i const tmp10 = _mm_add_epi32(tmp0, tmp3);
+			__m128i const tmp13 = _mm_sub_epi32(tmp0, tmp3);
+			__m128i const tmp11 = _mm_add_epi32(tmp1, tmp2);
+			__m128i const tmp12 = _mm_sub_epi32(tmp1, tmp2);
+
+			// Odd part
+			tmp0 = in[7];
+			tmp1 = in[5];
+			tmp2 = in[3];
+			tmp3 = in[1];
+
+			z1 = _mm_add_epi32(tmp0, tmp3);
+			z2 = _mm_add_epi32(tmp1, tmp2);
+			z3 = _mm_add_epi32(tmp0, tmp2);
+			__m128i z4 = _mm_add_epi32(tmp1, tmp3);
+			__m128i const z5 = mul(_mm_add_epi32(z3, z4), FIX_1_175875602);
+
+			tmp0 = mul(tmp0, FIX_0_298631336);
+			tmp1 = mul(tmp1, FIX_2_053119869);
+			tmp2 = mul(tmp2, FIX_3_072711026);
+			tmp3 = mul(tmp3, FIX_1_501321110);
+			z1 = mul(z1, -FIX_0_899976223);
+			z2 = mul(z2, -FIX_2_562915447);
+			z3 = _mm_add_epi32(mul(z3, -FIX_1_961570560), z5);
+			z4 = _mm_add_epi32(mul(z4, -FIX_0_390180644), z5);
+
+			tmp0 = _mm_add_epi32(tmp0, _mm_add_epi32(z1, z3));
+			tmp1 = _mm_add_epi32(tmp1, _mm_add_epi32(z2, z4));
+			tmp2 = _mm_add_epi32(tmp2, _mm_add_epi32(z2, z3));
+			tmp3 = _mm_add_epi32(tmp3, _mm_add_epi32(z1, z4));
+
+			out[0] = _mm_add_epi32(tmp10, tmp3);
+			out[7] = _mm_sub_epi32(tmp10, tmp3);
+			out[1] = _mm_add_epi32(tmp11, tmp2);
+			out[6] = _mm_sub_epi32(tmp11, tmp2);
+			out[2] = _mm_add_epi32(tmp12, tmp1);
+			out[5] = _mm_sub_epi32(tmp12, tmp1);
+			out[3] = _mm_add_epi32(tmp13, tmp0);
+			out[4] = _mm_sub_epi32(tmp13, tmp0);
+		}
+
+		static __forceinline __m128i Descale(__m128i value, s32 shift)
+		{
+			return _mm_srai_epi32(_mm_add_epi32(value, _mm_set1_epi32(1 << (shift - 1))), shift);
+		}
+
+		static __forceinline void Transpose4x4(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+		{
+			__m128i const ab_lo = _mm_unpacklo_epi32(a, b);
+			__m128i const cd_lo = _mm_unpacklo_epi32(c, d);
+			__m128i const ab_hi = _mm_unpackhi_epi32(a, b);
+			__m128i const cd_hi = _mm_unpackhi_epi32(c, d);
+			a = _mm_unpacklo_epi64(ab_lo, cd_lo);
+			b = _mm_unpackhi_epi64(ab_lo, cd_lo);
+			c = _mm_unpacklo_epi64(ab_hi, cd_hi);
+			d = _mm_unpackhi_epi64(ab_hi, cd_hi);
+		}
+
+		static void InverseDct(s32 const* coefficients, u8* dst, u32 dst_pitch)
+		{
+			__m128i const* in = (__m128i const*)coefficients;
+
+			// Most blocks only have a DC term, which spreads out evenly. Both passes together round it like
+			// (dc + 4) >> 3.
+			__m128i ac = _mm_and_si128(_mm_loadu_si128(in), _mm_setr_epi32(0, -1, -1, -1));
+			for (u32 i = 1; i < 16; ++i)
+			{
+				ac = _mm_or_si128(ac, _mm_loadu_si128(in + i));
+			}
+			if (_mm_testz_si128(ac, ac))
+			{
+				s32 const value = Clamp(((coefficients[0] + 4) >> 3) + 128, 0, 255);
+				u64 const row = 0x0101010101010101ull * (u64)value;
+				for (u32 y = 0; y < 8; ++y, dst += dst_pitch)
+				{
+					memcpy(dst, &row, sizeof(row));
+				}
+				return;
+			}
+
+			// Columns first, four at a time, rows[r][half] ends up holding row r, columns half * 4 to half * 4 + 3.
+			__m128i rows[8][2];
+			for (u32 half = 0; half < 2; ++half)
+			{
+				__m128i column_in[8];
+				__m128i column_out[8];
+				for (u32 k = 0; k < 8; ++k)
+				{
+					column_in[k] = _mm_loadu_si128(in + k * 2 + half);
+				}
+				Idct1D(column_in, column_out);
+				for (u32 k = 0; k < 8; ++k)
+				{
+					rows[k][half] = Descale(column_out[k], CONST_BITS - PASS1_BITS);
+				}
+			}
+
+			// Then rows, four at a time after a transpose, and back. The extra 3 bits undo the 8x scale of the
+			// 2D transform, 128 the level shift. The saturating packs clamp to [0, 255].
+			__m128i const level_shift = _mm_set1_epi32(128);
+			for (u32 quad = 0; quad < 2; ++quad)
+			{
+				__m128i (*r)[2] = rows + quad * 4;
+				__m128i row_in[8] = { r[0][0], r[1][0], r[2][0], r[3][0], r[0][1], r[1][1], r[2][1], r[3][1] };
+				Transpose4x4(row_in[0], row_in[1], row_in[2], row_in[3]);
+				Transpose4x4(row_in[4], row_in[5], row_in[6], row_in[7]);
+
+				__m128i row_out[8];
+				Idct1D(row_in, row_out);
+				for (u32 k = 0; k < 8; ++k)
+				{
+					row_out[k] = _mm_add_epi32(Descale(row_out[k], CONST_BITS + PASS1_BITS + 3), level_shift);
+				}
+				Transpose4x4(row_out[0], row_out[1], row_out[2], row_out[3]);
+				Transpose4x4(row_out[4], row_out[5], row_out[6], row_out[7]);
+
+				for (u32 y = 0; y < 4; ++y, dst += dst_pitch)
+				{
+					__m128i const words = _mm_packs_epi32(row_out[y], row_out[y + 4]);
+					_mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(words, words));
+				}
+			}
+		}
+
+		static __forceinline u8 ClampToByte(s32 value)
+		{
+			return (u8)Clamp(value, 0, 255);
+		}
+
+		// Samples of one MCU per component, (h * 8) x (v * 8) each.
+		struct McuSamples
+		{
+			u8* planes[MAX_COMPONENTS];
+			u32 pitches[MAX_COMPONENTS];
+		};
+
+		// JFIF YCbCr with 16 bit fixed point factors, rounds like libjpeg's jdcolor.c.
+		static constexpr s32 CR_TO_R = 91881;
+		static constexpr s32 CB_TO_G = -22554;
+		static constexpr s32 CR_TO_G = -46802;
+		static constexpr s32 CB_TO_B = 116130;
+
+		static void YCbCrToRgba(u8 const* y, u8 const* cb, u8 const* cr, u8* dst, u32 count)
+		{
+			u32 x = 0;
+
+			__m128i const center = _mm_set1_epi32(128);
+			__m128i const half = _mm_set1_epi32(1 << 15);
+			__m128i const alpha = _mm_set1_epi32((s32)0xff000000);
+			for (; x + 4 <= count; x += 4, dst += 16)
+			{
+				u32 y4, cb4, cr4;
+				memcpy(&y4, y + x, 4);
+				memcpy(&cb4, cb + x, 4);
+				memcpy(&cr4, cr + x, 4);
+
+				__m128i const luma = _mm_cvtepu8_epi32(_mm_cvtsi32_si128((s32)y4));
+				__m128i const blue_diff = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128((s32)cb4)), center);
+				__m128i const red_diff = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128((s32)cr4)), center);
+
+				__m128i const r = _mm_add_epi32(luma, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(red_diff, _mm_set1_epi32(CR_TO_R)), half), 16));
+				__m128i const g = _mm_add_epi32(luma, _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(
+					_mm_mullo_epi32(blue_diff, _mm_set1_epi32(CB_TO_G)), _mm_mullo_epi32(red_diff, _mm_set1_epi32(CR_TO_G))), half), 16));
+				__m128i const b = _mm_add_epi32(luma, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(blue_diff, _mm_set1_epi32(CB_TO_B)), half), 16));
+
+				// Saturate to bytes, then shift each channel into its place of the RGBA8 pixel.
+				__m128i const rg = _mm_packus_epi16(_mm_packs_epi32(r, g), _mm_setzero_si128());
+				__m128i const b_ = _mm_packus_epi16(_mm_packs_epi32(b, b), _mm_setzero_si128());
+				__m128i const red = _mm_cvtepu8_epi32(rg);
+				__m128i const green = _mm_slli_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(rg, 4)), 8);
+				__m128i const blue = _mm_slli_epi32(_mm_cvtepu8_epi32(b_), 16);
+				_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_or_si128(red, green), _mm_or_si128(blue, alpha)));
+			}
+
+			for (; x < count; ++x, dst += 4)
+			{
+				s32 const blue_diff = cb[x] - 128;
+				s32 const red_diff = cr[x] - 128;
+				dst[0] = ClampToByte(y[x] + ((CR_TO_R * red_diff + (1 << 15)) >> 16));
+				dst[1] = ClampToByte(y[x] + ((CB_TO_G * blue_diff + CR_TO_G * red_diff + (1 << 15)) >> 16));
+				dst[2] = ClampToByte(y[x] + ((CB_TO_B * blue_diff + (1 << 15)) >> 16));
+				dst[3] = 0xff;
+			}
+		}
+
+		static void WriteMcu(State const* jpeg, McuSamples const* samples, u32 mcu_x, u32 mcu_y, u8* pixels, u32 width, u32 height)
+		{
+			u32 const x0 = mcu_x * jpeg->max_h * 8;
+			u32 const y0 = mcu_y * jpeg->max_v * 8;
+			u32 const mcu_width = min(jpeg->max_h * 8, width - x0);
+			u32 const mcu_height = min(jpeg->max_v * 8, height - y0);
+
+			Component const* comps = jpeg->components;
+			for (u32 y = 0; y < mcu_height; ++y)
+			{
+				u8* dst = pixels + ((u64)(y0 + y) * width + x0) * 4;
+
+				if (jpeg->num_components == 1)
+				{
+					u8 const* gray = samples->planes[0] + y * samples->pitches[0];
+					for (u32 x = 0; x < mcu_width; ++x, dst += 4)
+					{
+						dst[0] = dst[1] = dst[2] = gray[x];
+						dst[3] = 0xff;
+					}
+					continue;
+				}
+
+				// Subsampled rows are stretched to full width first.
+				u8 upsampled[MAX_COMPONENTS][MAX_SAMPLING * 8];
+				u8 const* rows[MAX_COMPONENTS];
+				for (u32 c = 0; c < MAX_COMPONENTS; ++c)
+				{
+					rows[c] = samples->planes[c] + (y >> comps[c].shift_y) * samples->pitches[c];
+					if (comps[c].shift_x != 0)
+					{
+						for (u32 x = 0; x < mcu_width; ++x)
+						{
+							upsampled[c][x] = rows[c][x >> comps[c].shift_x];
+						}
+						rows[c] = upsampled[c];
+					}
+				}
+
+				if (jpeg->b_rgb)
+				{
+					for (u32 x = 0; x < mcu_width; ++x, dst += 4)
+					{
+						dst[0] = rows[0][x];
+						dst[1] = rows[1][x];
+						dst[2] = rows[2][x];
+						dst[3] = 0xff;
+					}
+				}
+				else
+				{
+					YCbCrToRgba(rows[0], rows[1], rows[2], dst, mcu_width);
+				}
+			}
+		}
+
+		bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory)
+		{
+			State const* jpeg = static_cast<State const*>(decoder->state);
+
+			Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+			McuSamples samples;
+			for (u32 c = 0; c < jpeg->num_components; ++c)
+			{
+				Component const& comp = jpeg->components[c];
+				samples.pitches[c] = comp.h * 8;
+				samples.planes[c] = Memory::PushType<u8>(scratch_memory, comp.h * 8 * comp.v * 8);
+			}
+
+			u32 const num_mcus = jpeg->mcus_x * jpeg->mcus_y;
+			u32 const first_interval = range * jpeg->intervals_per_range;
+			u32 const end_interval = min(first_interval + jpeg->intervals_per_range, jpeg->num_intervals);
+
+			alignas(16) s32 coefficients[64];
+			for (u32 interval = first_interval; interval < end_interval; ++interval)
+			{
+				BitReader reader;
+				reader.data = decoder->data;
+				reader.data_size = decoder->data_size;
+				reader.pos = jpeg->interval_offsets[interval];
+				reader.bits = 0;
+				reader.num_bits = 0;
+				reader.b_hit_marker = false;
+
+				// Every interval starts over with its DC predictions.
+				s32 dc_predictions[MAX_COMPONENTS] = {};
+
+				u32 const first_mcu = interval * jpeg->restart_interval;
+				u32 const end_mcu = min(first_mcu + jpeg->restart_interval, num_mcus);
+				for (u32 mcu = first_mcu; mcu < end_mcu; ++mcu)
+				{
+					for (u32 c = 0; c < jpeg->num_components; ++c)
+					{
+						Component const& comp = jpeg->components[c];
+						for (u32 block_y = 0; block_y < comp.v; ++block_y)
+						{
+							for (u32 block_x = 0; block_x < comp.h; ++block_x)
+							{
+								if (!DecodeBlock(&reader, &jpeg->dc[comp.dc_table], &jpeg->ac[comp.ac_table], jpeg->quant[comp.quant_table],
+									&dc_predictions[c], coefficients))
+								{
+									return false;
+								}
+
+								u8* dst = samples.planes[c] + block_y * 8 * samples.pitches[c] + block_x * 8;
+								InverseDct(coefficients, dst, samples.pitches[c]);
+							}
+						}
+					}
+
+					WriteMcu(jpeg, &samples, mcu % jpeg->mcus_x, mcu / jpeg->mcus_x, pixels, decoder->width, decoder->height);
+				}
+			}
+
+			return true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,605 @@
+#include "Json.h"
+#include "Simd.h"
+
+namespace Json
+{
+	static constexpr u64 BLOCK_SIZE = 64;
+
+	// Bytes per stage 1 pass, every byte may be an index entry, so the index is 64 KB.
+	static constexpr u64 CHUNK_SIZE = 16 * 1024;
+
+	static constexpr u64 ODD_BITS = 0xAAAAAAAAAAAAAAAAull;
+
+	// One bit per byte of a block.
+	struct BlockMasks
+	{
+		u64 quote;
+		u64 backslash;
+		u64 structural; // , : [ ] { }
+		u64 whitespace; // space \t \n \r
+	};
+
+	// Carried from one block to the next.
+	struct Stage1State
+	{
+		u64 in_string;       // All ones if the last block ended inside a string.
+		u64 next_is_escaped; // 1 if the last block ended on an escaping backslash.
+		u64 prev_scalar;     // 1 if the last block ended inside a primitive.
+		bool invalid;
+	};
+
+	// The last token or one of its parents. Stage 2 only looks at these, so it doesn't need the tokens
+	// and runs the same way when they are only counted.
+	struct OpenToken
+	{
+		s32 token;
+		TokenType::Enum type;
+		s32 size;
+		bool b_open; // Container that isn't closed yet.
+	};
+
+	struct Stage2State
+	{
+		Token* tokens;      // nullptr when counting.
+		u64 max_tokens;
+		s32 num_tokens;
+		s32 super;          // Chain entry the next value belongs to, like jsmn's toksuper.
+		s32 open_string;    // String token waiting for its closing quote.
+		u32 num_open_containers;
+		u64 primitive_end;  // Index entries before this are part of the last primitive.
+
+		// The last token and its parents, root first, so chain[i - 1] is the parent of chain[i].
+		u32 chain_size;
+		OpenToken chain[MAX_DEPTH];
+	};
+
+	static MM_FORCEINL u32 FirstBit(u64 bits)
+	{
+#ifdef _MSC_VER
+		unsigned long idx;
+		_BitScanForward64(&idx, bits);
+		return (u32)idx;
+#else
+		return (u32)__builtin_ctzll(bits);
+#endif
+	}
+
+	// Bit i is the xor of bits 0..i, turns quote bits into "inside a string" ranges.
+	static MM_FORCEINL u64 PrefixXor(u64 bits)
+	{
+		bits ^= bits << 1;
+		bits ^= bits << 2;
+		bits ^= bits << 4;
+		bits ^= bits << 8;
+		bits ^= bits << 16;
+		bits ^= bits << 32;
+		return bits;
+	}
+
+	// Whitespace and structural characters are found with one lookup each on the low nibble, a
+	// byte matches if the table holds the byte itself. [ and { (] and }) share a nibble, or'ing in
+	// 0x20 folds them together. Bytes with the high bit set look up zero and never match.
+	static MM_FORCEINL void Classify16(char const* src, u32 shift, BlockMasks* masks)
+	{
+		__m128i const chars = _mm_loadu_si128((__m128i const*)src);
+		__m128i const whitespace_lut = _mm_setr_epi8(' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0);
+		__m128i const structural_lut = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0);
+
+		__m128i const folded = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+		__m128i const whitespace = _mm_cmpeq_epi8(_mm_shuffle_epi8(whitespace_lut, chars), chars);
+		__m128i const structural = _mm_cmpeq_epi8(_mm_shuffle_epi8(structural_lut, folded), folded);
+
+		masks->quote |= (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('"'))) << shift;
+		masks->backslash |= (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))) << shift;
+		masks->structural |= (u64)(u32)_mm_movemask_epi8(structural) << shift;
+		masks->whitespace |= (u64)(u32)_mm_movemask_epi8(whitespace) << shift;
+	}
+
+	static SIMD_INLINE_AVX2 void Classify32(char const* src, u32 shift, BlockMasks* masks)
+	{
+		__m256i const chars = _mm256_loadu_si256((__m256i const*)src);
+		__m256i const whitespace_lut = _mm256_setr_epi8(
+			' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0,
+			' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0);
+		__m256i const structural_lut = _mm256_setr_epi8(
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0);
+
+		__m256i const folded = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+		__m256i const whitespace = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(whitespace_lut, chars), chars);
+		__m256i const structural = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(structural_lut, folded), folded);
+
+		masks->quote |= (u64)(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('"'))) << shift;
+		masks->backslash |= (u64)(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\\'))) << shift;
+		masks->structural |= (u64)(u32)_mm256_movemask_epi8(structural) << shift;
+		masks->whitespace |= (u64)(u32)_mm256_movemask_epi8(whitespace) << shift;
+	}
+
+	template <bool USE_AVX2>
+	static MM_FORCEINL void ClassifyBlock(char const* src, BlockMasks* masks)
+	{
+		MemZeroSafe(masks);
+		if (USE_AVX2)
+		{
+			Classify32(src + 0, 0, masks);
+			Classify32(src + 32, 32, masks);
+		}
+		else
+		{
+			Classify16(src + 0, 0, masks);
+			Classify16(src + 16, 16, masks);
+			Classify16(src + 32, 32, masks);
+			Classify16(src + 48, 48, masks);
+		}
+	}
+
+	// Characters escaped by a backslash. A run of backslashes escapes the character after it
+	// if the run has odd length, counted from where it starts.
+	static MM_FORCEINL u64 FindEscaped(u64 backslash, Stage1State* state)
+	{
+		if (backslash == 0)
+		{
+			u64 const escaped = state->next_is_escaped;
+			state->next_is_escaped = 0;
+			return escaped;
+		}
+
+		// Subtracting the run starts carries through each run, which leaves the parity of
+		// every position relative to its run start in the odd bits.
+		u64 const potential_escape = backslash & ~state->next_is_escaped;
+		u64 const maybe_escaped = (potential_escape << 1) | ODD_BITS;
+		u64 const escape_and_terminal = (maybe_escaped - potential_escape) ^ ODD_BITS;
+		u64 const escaped = escape_and_terminal ^ (backslash | state->next_is_escaped);
+		u64 const escape = escape_and_terminal & backslash;
+		state->next_is_escaped = escape >> 63;
+		return escaped;
+	}
+
+	static bool IsHexDigit(char ch)
+	{
+		return (u32)(ch - '0') < 10 || (u32)((ch | 0x20) - 'a') < 6;
+	}
+
+	// Escapes are rare, they are checked one at a time.
+	static bool AreEscapesValid(char const* json, u64 length, u64 block_begin, u64 escaped)
+	{
+		for (; escaped != 0; escaped &= escaped - 1)
+		{
+			u64 const pos = block_begin + FirstBit(escaped);
+			switch (json[pos])
+			{
+			case '"': case '\\': case '/': case 'b':
+			case 'f': case 'n': case 'r': case 't':
+				break;
+			case 'u':
+				for (u64 i = pos + 1; i < min(pos + 5, length); ++i)
+				{
+					if (!IsHexDigit(json[i]))
+					{
+						return false;
+					}
+				}
+				break;
+			default:
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Turns the masks of one block into the bits of the index entries.
+	static MM_FORCEINL u64 FindIndexBits(BlockMasks const& masks, u64 valid_bits, char const* json, u64 length,
+		u64 block_begin, Stage1State* state)
+	{
+		u64 const escaped = FindEscaped(masks.backslash, state) & valid_bits;
+		u64 const quotes = masks.quote & ~escaped & valid_bits;
+
+		// Opening quotes are inside, closing quotes outside.
+		u64 const in_string = PrefixXor(quotes) ^ state->in_string;
+		state->in_string = (u64)((s64)in_string >> 63);
+
+		if ((escaped & in_string) != 0 && !AreEscapesValid(json, length, block_begin, escaped & in_string))
+		{
+			state->invalid = true;
+		}
+
+		// Primitives (numbers, true, false, null) start where a run of other characters starts.
+		u64 const scalar = ~(masks.structural | masks.whitespace | masks.quote | in_string) & valid_bits;
+		u64 const primitive_starts = scalar & ~((scalar << 1) | state->prev_scalar);
+		state->prev_scalar = scalar >> 63;
+
+		return (masks.structural & ~in_string) | quotes | primitive_starts;
+	}
+
+	// Runs stage 1 over [begin, end), end is a multiple of BLOCK_SIZE unless it is the end of the input.
+	// Returns the number of index entries.
+	template <bool USE_AVX2>
+	static MM_FORCEINL u32 BuildStructuralIndex(u32* index, char const* json, u64 length, u64 begin, u64 end,
+		Stage1State* state)
+	{
+		u32 num_entries = 0;
+		for (u64 block_begin = begin; block_begin < end; block_begin += BLOCK_SIZE)
+		{
+			BlockMasks masks;
+			u64 valid_bits = ~0ull;
+			if (block_begin + BLOCK_SIZE <= length)
+			{
+				ClassifyBlock<USE_AVX2>(json + block_begin, &masks);
+			}
+			else
+			{
+				// The last block is padded with whitespace, which ends nothing that isn't ended anyways.
+				char padded[BLOCK_SIZE];
+				memset(padded, ' ', BLOCK_SIZE);
+				memcpy(padded, json + block_begin, length - block_begin);
+				ClassifyBlock<USE_AVX2>(padded, &masks);
+				valid_bits = (1ull << (length - block_begin)) - 1;
+			}
+
+			u64 bits = FindIndexBits(masks, valid_bits, json, length, block_begin, state);
+			for (; bits != 0; bits &= bits - 1)
+			{
+				index[num_entries++] = (u32)(block_begin + FirstBit(bits));
+			}
+		}
+		return num_entries;
+	}
+
+	typedef u32 (*BuildStructuralIndexFunc)(u32* index, char const* json, u64 length, u64 begin, u64 end, Stage1State* state);
+
+	static u32 BuildStructuralIndexSSE(u32* index, char const* json, u64 length, u64 begin, u64 end, Stage1State* state)
+	{
+		return BuildStructuralIndex<false>(index, json, length, begin, end, state);
+	}
+
+	static SIMD_TARGET_AVX2 u32 BuildStructuralIndexAVX2(u32* index, char const* json, u64 length, u64 begin, u64 end,
+		Stage1State* state)
+	{
+		return BuildStructuralIndex<true>(index, json, length, begin, end, state);
+	}
+
+	// Adds a token as the next child of the super, end is -1 for strings and containers until they
+	// are closed. Fails without room for the token or too deep in the document.
+	static MM_FORCEINL bool AllocToken(Stage2State* state, TokenType::Enum type, s32 start, s32 end)
+	{
+		u32 const depth = (u32)(state->super + 1);
+		if ((state->tokens != nullptr && (u64)state->num_tokens >= state->max_tokens) || depth >= MAX_DEPTH)
+		{
+			return false;
+		}
+
+		s32 parent = -1;
+		if (state->super != -1)
+		{
+			OpenToken& super = state->chain[state->super];
+			super.size++;
+			parent = super.token;
+		}
+
+		// Everything after the super belongs to an earlier sibling.
+		state->chain[depth] = { state->num_tokens, type, 0, type == TokenType::Object || type == TokenType::Array };
+		state->chain_size = depth + 1;
+
+		if (state->tokens != nullptr)
+		{
+			Token* token = &state->tokens[state->num_tokens];
+			token->type = type;
+			token->start = start;
+			token->end = end;
+			token->size = 0;
+			token->parent = parent;
+			if (parent != -1)
+			{
+				state->tokens[parent].size++;
+			}
+		}
+		state->num_tokens++;
+		return true;
+	}
+
+	static MM_FORCEINL void SetEnd(Stage2State* state, s32 token, s32 end)
+	{
+		if (state->tokens != nullptr)
+		{
+			state->tokens[token].end = end;
+		}
+	}
+
+	// Like jsmn in strict mode, a colon doesn't end a primitive. Opening brackets and quotes end
+	// it as well, they are rejected by AddPrimitive.
+	static MM_FORCEINL bool EndsPrimitive(char ch)
+	{
+		switch (ch)
+		{
+		case ' ': case '\t': case '\n': case '\r':
+		case ',': case '[': case ']':
+		case '{': case '}': case '"':
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static constexpr u64 INVALID_PRIMITIVE = ~0ull;
+
+	static u64 FindPrimitiveEndScalar(char const* json, u64 pos, u64 length)
+	{
+		u64 end = pos;
+		for (; end < length && !EndsPrimitive(json[end]); ++end)
+		{
+			if ((u8)json[end] < 32 || (u8)json[end] >= 127)
+			{
+				return INVALID_PRIMITIVE;
+			}
+		}
+		return end;
+	}
+
+	// Primitives are short, most of them end within the next 16 bytes. Returns INVALID_PRIMITIVE
+	// if there is a control character or anything outside of ASCII before the end.
+	static MM_FORCEINL u64 FindPrimitiveEnd(char const* json, u64 pos, u64 length)
+	{
+		if (pos + 16 > length)
+		{
+			return FindPrimitiveEndScalar(json, pos, length);
+		}
+
+		// Same lookups as Classify16(), minus the colon.
+		__m128i const whitespace_lut = _mm_setr_epi8(' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0);
+		__m128i const structural_lut = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '{', ',', '}', 0, 0);
+
+		__m128i const chars = _mm_loadu_si128((__m128i const*)(json + pos));
+		__m128i const folded = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+		__m128i const whitespace = _mm_cmpeq_epi8(_mm_shuffle_epi8(whitespace_lut, chars), chars);
+		__m128i const structural = _mm_cmpeq_epi8(_mm_shuffle_epi8(structural_lut, folded), folded);
+		__m128i const quote = _mm_cmpeq_epi8(chars, _mm_set1_epi8('"'));
+
+		// Signed compare, bytes from 0x80 up are negative.
+		__m128i const invalid = _mm_or_si128(_mm_cmplt_epi8(chars, _mm_set1_epi8(32)), _mm_cmpeq_epi8(chars, _mm_set1_epi8(127)));
+
+		u32 const end_bits = (u32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(whitespace, structural), quote));
+		if (end_bits == 0)
+		{
+			return FindPrimitiveEndScalar(json, pos, length);
+		}
+
+		u32 const num_chars = FirstBit(end_bits);
+		u32 const invalid_bits = (u32)_mm_movemask_epi8(invalid) & ((1u << num_chars) - 1);
+		return invalid_bits == 0 ? pos + num_chars : INVALID_PRIMITIVE;
+	}
+
+	// Numbers, true, false and null, in strict mode primitives can't be keys.
+	static s32 AddPrimitive(Stage2State* state, u32 pos, char const* json, u64 length)
+	{
+		switch (json[pos])
+		{
+		case '-': case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+		case 't': case 'f': case 'n':
+			break;
+		default:
+			return Error::Invalid;
+		}
+
+		if (state->super != -1)
+		{
+			OpenToken const& super = state->chain[state->super];
+			if (super.type == TokenType::Object || (super.type == TokenType::String && super.size != 0))
+			{
+				return Error::Invalid;
+			}
+		}
+
+		u64 end = FindPrimitiveEnd(json, pos, length);
+		if (end == INVALID_PRIMITIVE)
+		{
+			return Error::Invalid;
+		}
+
+		// A primitive has to be followed by something, jsmn would read on over a bracket or quote.
+		if (end == length)
+		{
+			return Error::Partial;
+		}
+		if (json[end] == '[' || json[end] == '{' || json[end] == '"')
+		{
+			return Error::Invalid;
+		}
+
+		if (!AllocToken(state, TokenType::Primitive, (s32)pos, (s32)end))
+		{
+			return Error::NoMemory;
+		}
+		state->primitive_end = end;
+		return 0;
+	}
+
+	// Stage 2, follows jsmn_parse() one index entry at a time.
+	static s32 BuildTokens(Stage2State* state, u32 const* index, u32 num_entries, char const* json, u64 length)
+	{
+		for (u32 entry = 0; entry < num_entries; ++entry)
+		{
+			u32 const pos = index[entry];
+			if (pos < state->primitive_end)
+			{
+				continue;
+			}
+
+			char const ch = json[pos];
+			switch (ch)
+			{
+			case '{': case '[':
+			{
+				TokenType::Enum const type = ch == '{' ? TokenType::Object : TokenType::Array;
+				if (!AllocToken(state, type, (s32)pos, -1))
+				{
+					return Error::NoMemory;
+				}
+				state->super = (s32)state->chain_size - 1;
+				state->num_open_containers++;
+				break;
+			}
+			case '}': case ']':
+			{
+				if (state->chain_size == 0)
+				{
+					return Error::Invalid;
+				}
+
+				// The innermost open container is the last token or one of its parents.
+				TokenType::Enum const type = ch == '}' ? TokenType::Object : TokenType::Array;
+				for (s32 i = (s32)state->chain_size - 1;; --i)
+				{
+					OpenToken& token = state->chain[i];
+					if (token.b_open)
+					{
+						if (token.type != type)
+						{
+							return Error::Invalid;
+						}
+						token.b_open = false;
+						SetEnd(state, token.token, (s32)pos + 1);
+						state->super = i - 1;
+						state->num_open_containers--;
+						break;
+					}
+					if (i == 0)
+					{
+						if (token.type != type || state->super == -1)
+						{
+							return Error::Invalid;
+						}
+						break;
+					}
+				}
+				break;
+			}
+			case '"':
+			{
+				// Stage 1 dropped escaped quotes, so quotes alternate between opening and closing.
+				if (state->open_string != -1)
+				{
+					SetEnd(state, state->open_string, (s32)pos);
+					state->open_string = -1;
+					break;
+				}
+
+				// Nothing inside of a string is indexed, the closing quote is the next entry unless
+				// it is in the next chunk.
+				bool const b_closed = entry + 1 < num_entries;
+				if (!AllocToken(state, TokenType::String, (s32)pos + 1, b_closed ? (s32)index[entry + 1] : -1))
+				{
+					return Error::NoMemory;
+				}
+
+				if (b_closed)
+				{
+					++entry;
+				}
+				else
+				{
+					state->open_string = state->num_tokens - 1;
+				}
+				break;
+			}
+			case ':':
+				state->super = (s32)state->chain_size - 1;
+				break;
+			case ',':
+				// After a key's value, the next value belongs to the object again.
+				if (state->super != -1 && state->chain[state->super].type != TokenType::Object && state->chain[state->super].type != TokenType::Array)
+				{
+					state->super--;
+				}
+				break;
+			default:
+			{
+				s32 const result = AddPrimitive(state, pos, json, length);
+				if (result < 0)
+				{
+					return result;
+				}
+				break;
+			}
+			}
+		}
+		return 0;
+	}
+
+	s32 Tokenize(char const* json, u64 length, Token* tokens, u64 max_tokens)
+	{
+		// Like jsmn, stop at the first null character.
+		char const* terminator = static_cast<char const*>(memchr(json, 0, length));
+		if (terminator != nullptr)
+		{
+			length = terminator - json;
+		}
+
+		// Offsets are 32 bit, as are jsmn's.
+		if (length > INT32_MAX)
+		{
+			return Error::Invalid;
+		}
+
+		BuildStructuralIndexFunc const build_structural_index = Simd::GetCpuFeatures().avx2 ? &BuildStructuralIndexAVX2 : &BuildStructuralIndexSSE;
+
+		Stage1State stage1;
+		MemZeroSafe(stage1);
+
+		u32 index[CHUNK_SIZE];
+
+		// Counting runs the whole of stage 2 as well, so both passes fail the same way.
+		Stage2State stage2;
+		stage2.tokens = tokens;
+		stage2.max_tokens = max_tokens;
+		stage2.num_tokens = 0;
+		stage2.super = -1;
+		stage2.open_string = -1;
+		stage2.num_open_containers = 0;
+		stage2.primitive_end = 0;
+		stage2.chain_size = 0;
+
+		for (u64 begin = 0; begin < length; begin += CHUNK_SIZE)
+		{
+			u32 const num_entries = build_structural_index(index, json, length, begin, min(begin + CHUNK_SIZE, length), &stage1);
+			if (stage1.invalid)
+			{
+				return Error::Invalid;
+			}
+
+			s32 const result = BuildTokens(&stage2, index, num_entries, json, length);
+			if (result < 0)
+			{
+				return result;
+			}
+		}
+
+		if (stage2.open_string != -1 || stage2.num_open_containers > 0)
+		{
+			return Error::Partial;
+		}
+
+		return stage2.num_tokens;
+	}
+
+	s32 FindValue(char const* json, Token const* tokens, s32 num_tokens, s32 object, char const* key)
+	{
+		ASSERT(object >= 0 && object < num_tokens);
+		if (tokens[object].type != TokenType::Object)
+		{
+			return -1;
+		}
+
+		// Keys are the only tokens that have the object as parent, nested keys have their own.
+		u64 const key_length = strlen(key);
+		for (s32 i = object + 1; i + 1 < num_tokens && tokens[i].start < tokens[object].end; ++i)
+		{
+			Token const& token = tokens[i];
+			if (token.parent == object && (u64)(token.end - token.start) == key_length && memcmp(json + token.start, key, key_length) == 0)
+			{
+				return i + 1;
+			}
+		}
+		return -1;
+	}
+}
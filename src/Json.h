@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Core.h"
+
+// ====================================
+//  JSON Tokenizer
+//  Notes:
+//  *) Drop-in replacement for jsmn_parse() as cgltf builds it
+//     (JSMN_STRICT, JSMN_PARENT_LINKS), so cgltf can parse with
+//     our tokens as they are. For valid JSON the tokens are
+//     identical to jsmn's, invalid JSON is rejected.
+//  *) Two stages, see Langdale & Lemire, "Parsing Gigabytes of
+//     JSON per Second" (2019). Stage 1 classifies 64 bytes at a
+//     time with SSE4.1 (or AVX2) into bit masks, resolves escapes
+//     and string ranges with bit arithmetic, and writes the offsets
+//     of every structural character, quote and primitive start.
+//     Stage 2 walks those offsets and builds the tokens, only
+//     primitives look at the bytes in between.
+//  *) Input is processed in chunks, the structural index of one
+//     chunk stays in cache until stage 2 consumed it.
+//  *) Stage 2 only keeps the chain from the last token up to its
+//     root, like simdjson it limits how deep that goes.
+// ====================================
+
+namespace Json
+{
+	// Values match jsmntype_t.
+	namespace TokenType
+	{
+		enum Enum : s32
+		{
+			Undefined = 0,
+			Object = 1,
+			Array = 2,
+			String = 3,
+			Primitive = 4,
+		};
+	}
+
+	// Values match jsmnerr.
+	namespace Error
+	{
+		enum Enum : s32
+		{
+			NoMemory = -1, // More tokens than max_tokens.
+			Invalid = -2,  // Invalid character or mismatched bracket.
+			Partial = -3,  // Unterminated string, object or array.
+		};
+	}
+
+	// Containers, keys and values nested deeper than this fail with Error::NoMemory. glTF needs about 10.
+	static constexpr u32 MAX_DEPTH = 1024;
+
+	// Same layout as jsmntok_t. Offsets are in bytes, end is exclusive and strings exclude their quotes.
+	// size counts the children: keys of an object, elements of an array and 1 for a key. Values
+	// have their key as parent, keys their object.
+	struct Token
+	{
+		TokenType::Enum type;
+		s32 start;
+		s32 end;
+		s32 size;
+		s32 parent;
+	};
+
+	// Tokenizes json up to length or the first null character, whichever comes first. With tokens
+	// set to nullptr the tokens are only counted and max_tokens is ignored, the input is checked the
+	// same way and fails with the same Error. Returns the number of tokens or an Error.
+	s32 Tokenize(char const* json, u64 length, Token* tokens, u64 max_tokens);
+
+	// Value of key in the object tokens[object], or -1 if it has no such key.
+	s32 FindValue(char const* json, Token const* tokens, s32 num_tokens, s32 object, char const* key);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
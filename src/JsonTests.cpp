@@ -0,0 +1,220 @@
+#include "Json.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+namespace Json
+{
+namespace Test
+{
+	static constexpr u32 MAX_TEST_TOKENS = 64 * 1024;
+
+	// Both passes, on both dispatch paths. They have to agree on the result, and with the same tokens.
+	static s32 TokenizeChecked(char const* json, u64 length, Token* tokens, u64 max_tokens)
+	{
+		s32 results[2][2];
+		u32 path = 0;
+		Token* baseline = new Token[max_tokens];
+		ON_SCOPE_EXIT(delete[] baseline);
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			results[path][0] = Tokenize(json, length, nullptr, 0);
+			results[path][1] = Tokenize(json, length, path == 0 ? baseline : tokens, max_tokens);
+			++path;
+		});
+
+		ASSERT(results[0][1] == results[1][1]);
+		ASSERT(results[0][1] <= 0 || memcmp(baseline, tokens, sizeof(Token) * results[0][1]) == 0);
+
+		// Running out of tokens is the only thing counting can't run into. The token pass stops there,
+		// counting goes on and may still find an error further on.
+		for (u32 i = 0; i < 2; ++i)
+		{
+			ASSERT(results[i][0] == results[i][1] || (results[i][1] == Error::NoMemory && (results[i][0] > (s32)max_tokens || results[i][0] < 0)));
+		}
+		return results[0][1];
+	}
+
+	static s32 TokenizeChecked(char const* json, Token* tokens, u64 max_tokens)
+	{
+		return TokenizeChecked(json, strlen(json), tokens, max_tokens);
+	}
+
+	static bool IsToken(Token const& token, TokenType::Enum type, s32 start, s32 end, s32 size, s32 parent)
+	{
+		return token.type == type && token.start == start && token.end == end && token.size == size && token.parent == parent;
+	}
+
+	void TokensMatchJsmn()
+	{
+		char const* json = "{\"a\": [1, \"x\", {\"b\": null}], \"c\\\"d\": true}";
+		Token tokens[16];
+		ASSERT(TokenizeChecked(json, tokens, ARRAY_SIZE(tokens)) == 10);
+
+		ASSERT(IsToken(tokens[0], TokenType::Object, 0, 42, 2, -1));
+		ASSERT(IsToken(tokens[1], TokenType::String, 2, 3, 1, 0));
+		ASSERT(IsToken(tokens[2], TokenType::Array, 6, 27, 3, 1));
+		ASSERT(IsToken(tokens[3], TokenType::Primitive, 7, 8, 0, 2));
+		ASSERT(IsToken(tokens[4], TokenType::String, 11, 12, 0, 2));
+		ASSERT(IsToken(tokens[5], TokenType::Object, 15, 26, 1, 2));
+		ASSERT(IsToken(tokens[6], TokenType::String, 17, 18, 1, 5));
+		ASSERT(IsToken(tokens[7], TokenType::Primitive, 21, 25, 0, 6));
+		ASSERT(IsToken(tokens[8], TokenType::String, 30, 34, 1, 0));
+		ASSERT(IsToken(tokens[9], TokenType::Primitive, 37, 41, 0, 8));
+
+		ASSERT(FindValue(json, tokens, 10, 0, "a") == 2);
+		ASSERT(FindValue(json, tokens, 10, 0, "c\\\"d") == 9);
+		ASSERT(FindValue(json, tokens, 10, 0, "b") == -1);
+		ASSERT(FindValue(json, tokens, 10, 5, "b") == 7);
+		ASSERT(FindValue(json, tokens, 10, 2, "a") == -1);
+
+		// Not enough tokens, counting still finds all of them.
+		ASSERT(TokenizeChecked(json, tokens, 9) == Error::NoMemory);
+
+		// Stops at the first null character.
+		ASSERT(TokenizeChecked("[1, 2]\0]]]", 10, tokens, ARRAY_SIZE(tokens)) == 3);
+	}
+
+	// Errors are the same in both passes. The trailing colon used to be Partial when counting and
+	// fine otherwise, jsmn accepts it.
+	void CountMatchesTokenPass()
+	{
+		struct Case
+		{
+			char const* json;
+			s32 result;
+		};
+
+		Case const cases[] =
+		{
+			{ "3.5e10\n:", 1 },
+			{ "3.5e10:", Error::Partial },
+			{ "[1, 2", Error::Partial },
+			{ "{\"a\": 1", Error::Partial },
+			{ "\"abc", Error::Partial },
+			{ "[1, 2]]", Error::Invalid },
+			{ "[1, 2}", Error::Invalid },
+			{ "{\"a\" 1}", Error::Invalid },
+			{ "{1: 2}", Error::Invalid },
+			{ "{\"a\": 1 2}", Error::Invalid },
+			{ "[1\"a\"]", Error::Invalid },
+			{ "[1[]]", Error::Invalid },
+			{ "[\"\\q\"]", Error::Invalid },
+			{ "[\"\\u12G4\"]", Error::Invalid },
+			{ "[x]", Error::Invalid },
+			{ "[1\x01]", Error::Invalid },
+			{ "]", Error::Invalid },
+			{ "", 0 },
+			{ "  \n", 0 },
+			{ "[] {}", 2 },
+			{ "[\"\\u12aF\", \"\\\\\", \"\\\"\"]", 4 },
+		};
+
+		Token tokens[16];
+		for (Case const& test : cases)
+		{
+			ASSERT(TokenizeChecked(test.json, tokens, ARRAY_SIZE(tokens)) == test.result);
+		}
+
+		// Single byte changes and truncations of a valid document, all both passes have to agree on.
+		char const* valid = "{\"nodes\": [{\"name\": \"a\\\"b\", \"mesh\": 0, \"scale\": [1.5, -2e3, 0.25]}, {\"children\": [0], "
+			"\"matrix\": null}], \"asset\": {\"version\": \"2.0\", \"extras\": {\"flag\": true, \"list\": [false, {}]}}}";
+		u32 const length = (u32)strlen(valid);
+		Token document_tokens[64];
+		ASSERT(TokenizeChecked(valid, document_tokens, ARRAY_SIZE(document_tokens)) == 31);
+
+		char const replacements[] = "{}[]\":,\\ \n0-.etfnaxu\x01\x80";
+		char mutated[256];
+		TestUtils::Random random;
+		for (u32 i = 0; i < 4000; ++i)
+		{
+			memcpy(mutated, valid, length);
+			u32 mutated_length = length;
+			if (i % 4 == 3)
+			{
+				mutated_length = random.Index(length);
+			}
+			else
+			{
+				mutated[random.Index(length)] = replacements[random.Index(ARRAY_SIZE(replacements) - 1)];
+			}
+			TokenizeChecked(mutated, mutated_length, document_tokens, ARRAY_SIZE(document_tokens));
+		}
+	}
+
+	// Large enough for several chunks, with strings, escapes and primitives across the chunk boundaries.
+	void ManyChunks()
+	{
+		static constexpr u32 NUM_OBJECTS = 3000;
+		static constexpr u32 CAPACITY = NUM_OBJECTS * 160;
+		char* json = new char[CAPACITY];
+		Token* tokens = new Token[MAX_TEST_TOKENS];
+		ON_SCOPE_EXIT(delete[] json; delete[] tokens);
+
+		TestUtils::Random random;
+		u32 length = 0;
+		u32 string_starts[NUM_OBJECTS];
+		u32 string_lengths[NUM_OBJECTS];
+
+		json[length++] = '[';
+		for (u32 i = 0; i < NUM_OBJECTS; ++i)
+		{
+			length += snprintf(json + length, CAPACITY - length, "%s{\"id\": %u, \"name\": \"", i > 0 ? ",\n" : "", random.Next());
+			string_starts[i] = length;
+			string_lengths[i] = 1 + random.Index(60);
+			for (u32 j = 0; j < string_lengths[i]; ++j)
+			{
+				// Escaped quotes and backslashes, sometimes a run of them.
+				u32 const kind = random.Index(8);
+				json[length++] = kind == 0 ? '\\' : (char)('a' + random.Index(26));
+				if (kind == 0)
+				{
+					json[length++] = random.Index(2) ? '"' : '\\';
+					++j;
+				}
+			}
+			string_lengths[i] = length - string_starts[i];
+			length += snprintf(json + length, CAPACITY - length, "\", \"v\": [%d.%u, true]}", (s32)random.Index(200) - 100, random.Next() % 1000);
+		}
+		json[length++] = ']';
+		ASSERT(length > 4 * 16 * 1024);
+
+		// Array, and per object the object, 3 keys, 3 values and 2 elements.
+		s32 const num_tokens = TokenizeChecked(json, length, tokens, MAX_TEST_TOKENS);
+		ASSERT(num_tokens == 1 + (s32)NUM_OBJECTS * 9);
+		ASSERT(tokens[0].size == (s32)NUM_OBJECTS && tokens[0].end == (s32)length);
+
+		for (u32 i = 0; i < NUM_OBJECTS; ++i)
+		{
+			Token const* object = tokens + 1 + i * 9;
+			ASSERT(object->type == TokenType::Object && object->size == 3 && object->parent == 0);
+			ASSERT(object[4].start == (s32)string_starts[i] && object[4].end == (s32)(string_starts[i] + string_lengths[i]));
+			ASSERT(object[6].type == TokenType::Array && object[6].size == 2 && object[8].type == TokenType::Primitive);
+		}
+	}
+
+	// Every container and key is one level, MAX_DEPTH of them fit.
+	void DepthLimit()
+	{
+		char* json = new char[MAX_DEPTH * 2 + 2];
+		Token* tokens = new Token[MAX_DEPTH + 1];
+		ON_SCOPE_EXIT(delete[] json; delete[] tokens);
+
+		for (u32 depth : { MAX_DEPTH, MAX_DEPTH + 1 })
+		{
+			memset(json, '[', depth);
+			memset(json + depth, ']', depth);
+			s32 const expected = depth <= MAX_DEPTH ? (s32)depth : Error::NoMemory;
+			ASSERT(TokenizeChecked(json, depth * 2, tokens, MAX_DEPTH + 1) == expected);
+		}
+	}
+
+	void Run()
+	{
+		TokensMatchJsmn();
+		CountMatchesTokenPass();
+		ManyChunks();
+		DepthLimit();
+	}
+}
+}
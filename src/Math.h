@@ -2,10 +2,15 @@
 
 #include "Core.h"
 #include <math.h>
+#include <immintrin.h>
 
 #define MM_INLINE inline
 #define MM_FORCEINL __forceinline
+#ifdef _MSC_VER
 #define MM_VECTORCALL __vectorcall
+#else
+#define MM_VECTORCALL
+#endif
 #define MM_DEFAULT_INL MM_INLINE
 
 // ====================================
@@ -14,8 +19,10 @@
 //  *) Uses column major convention
 // ====================================
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable:4201) // warning C4201: nonstandard extension used : nameless struct/union
+#endif
 
 struct vec2
 {
@@ -69,6 +76,22 @@ struct vec4
 	}
 };
 
+// NOTE(): xyz is the imaginary part, w the real part (same as glTF).
+struct quat
+{
+	union
+	{
+		f32 data[4];
+		struct { f32 x; f32 y; f32 z; f32 w; };
+	};
+
+	quat() = default;
+
+	quat(f32 _x, f32 _y, f32 _z, f32 _w)
+		: x(_x), y(_y), z(_z), w(_w)
+	{}
+};
+
 struct mat44
 {
 	union
@@ -135,7 +158,78 @@ struct mat44
 	}
 };
 
+// Affine transform, the implicit last row is (0, 0, 0, 1).
+// NOTE(): Unlike mat44 this is row major. Every row is one __m128, and the
+// layout matches a row_major float3x4 in HLSL so it can be uploaded as is.
+struct mat34
+{
+	union
+	{
+		f32 data[12];
+	};
+
+	mat34() = default;
+
+	mat34(
+		f32 m00, f32 m01, f32 m02, f32 m03,
+		f32 m10, f32 m11, f32 m12, f32 m13,
+		f32 m20, f32 m21, f32 m22, f32 m23)
+	{
+		data[0] = m00;
+		data[1] = m01;
+		data[2] = m02;
+		data[3] = m03;
+
+		data[4] = m10;
+		data[5] = m11;
+		data[6] = m12;
+		data[7] = m13;
+
+		data[8] = m20;
+		data[9] = m21;
+		data[10] = m22;
+		data[11] = m23;
+	}
+
+	MM_DEFAULT_INL f32& operator()(u32 row, u32 col)
+	{
+		ASSERT(row < 3 && col < 4);
+		return data[row * 4 + col];
+	}
+
+	MM_DEFAULT_INL f32 const& operator()(u32 row, u32 col) const
+	{
+		ASSERT(row < 3 && col < 4);
+		return data[row * 4 + col];
+	}
+
+	static mat34 const& Identity()
+	{
+		static const mat34 s_identity = mat34(
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0
+		);
+
+		return s_identity;
+	}
+};
+
+struct AABB
+{
+	vec3 min;
+	vec3 max;
+};
+
+struct Sphere
+{
+	vec3 center;
+	f32 radius;
+};
+
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 namespace Math
 {
@@ -248,6 +342,63 @@ namespace Math
 		return mat;
 	}
 
+	template <typename Matrix>
+	static MM_DEFAULT_INL Matrix MM_VECTORCALL Scale(f32 x, f32 y, f32 z)
+	{
+		Matrix mat = Matrix::Identity();
+		mat(0, 0) = x;
+		mat(1, 1) = y;
+		mat(2, 2) = z;
+
+		return mat;
+	}
+
+	// Expects a unit quaternion.
+	template <typename Matrix>
+	static MM_DEFAULT_INL Matrix MM_VECTORCALL Rotation(quat q)
+	{
+		f32 const xx = q.x * q.x;
+		f32 const yy = q.y * q.y;
+		f32 const zz = q.z * q.z;
+		f32 const xy = q.x * q.y;
+		f32 const xz = q.x * q.z;
+		f32 const yz = q.y * q.z;
+		f32 const wx = q.w * q.x;
+		f32 const wy = q.w * q.y;
+		f32 const wz = q.w * q.z;
+
+		Matrix mat = Matrix::Identity();
+		mat(0, 0) = 1.0f - 2.0f * (yy + zz);
+		mat(0, 1) = 2.0f * (xy - wz);
+		mat(0, 2) = 2.0f * (xz + wy);
+		mat(1, 0) = 2.0f * (xy + wz);
+		mat(1, 1) = 1.0f - 2.0f * (xx + zz);
+		mat(1, 2) = 2.0f * (yz - wx);
+		mat(2, 0) = 2.0f * (xz - wy);
+		mat(2, 1) = 2.0f * (yz + wx);
+		mat(2, 2) = 1.0f - 2.0f * (xx + yy);
+
+		return mat;
+	}
+
+	// Same as Translation * Rotation * Scale, without the two full matrix multiplies.
+	template <typename Matrix>
+	static MM_DEFAULT_INL Matrix MM_VECTORCALL TRS(vec3 translation, quat rotation, vec3 scale)
+	{
+		Matrix mat = Rotation<Matrix>(rotation);
+		for (u32 row = 0; row < 3; ++row)
+		{
+			mat(row, 0) *= scale.x;
+			mat(row, 1) *= scale.y;
+			mat(row, 2) *= scale.z;
+		}
+		mat(0, 3) = translation.x;
+		mat(1, 3) = translation.y;
+		mat(2, 3) = translation.z;
+
+		return mat;
+	}
+
 	template <typename Matrix>
 	static MM_DEFAULT_INL Matrix MM_VECTORCALL RotationX(Rad angle_rad)
 	{
@@ -292,7 +443,7 @@ namespace Math
 	template <typename Matrix>
 	static MM_FORCEINL Matrix MM_VECTORCALL RotationXYZ(vec3 euler_angles)
 	{
-		return RotationXYZ(DegreeToRad(euler_angles.x), DegreeToRad(euler_angles.y), DegreeToRad(euler_angles.z));
+		return RotationXYZ<Matrix>(Rad(Deg(euler_angles.x)), Rad(Deg(euler_angles.y)), Rad(Deg(euler_angles.z)));
 	}
 
 
@@ -333,6 +484,106 @@ namespace Math
 		return dst;
 	}
 
+	// Composes two affine transforms, a is applied last (same as mat44).
+	static MM_DEFAULT_INL mat34 MM_VECTORCALL Mul(mat34 const& a, mat34 const& b)
+	{
+		__m128 const b_row0 = _mm_loadu_ps(b.data + 0);
+		__m128 const b_row1 = _mm_loadu_ps(b.data + 4);
+		__m128 const b_row2 = _mm_loadu_ps(b.data + 8);
+		__m128 const b_row3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+		mat34 dst;
+		for (u32 row = 0; row < 3; ++row)
+		{
+			__m128 const a_row = _mm_loadu_ps(a.data + row * 4);
+
+			__m128 res = _mm_mul_ps(_mm_shuffle_ps(a_row, a_row, _MM_SHUFFLE(0, 0, 0, 0)), b_row0);
+			res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(a_row, a_row, _MM_SHUFFLE(1, 1, 1, 1)), b_row1));
+			res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(a_row, a_row, _MM_SHUFFLE(2, 2, 2, 2)), b_row2));
+			res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(a_row, a_row, _MM_SHUFFLE(3, 3, 3, 3)), b_row3));
+
+			_mm_storeu_ps(dst.data + row * 4, res);
+		}
+
+		return dst;
+	}
+
+	static MM_DEFAULT_INL vec4 MM_VECTORCALL Mul(mat34 const& mat, vec4 const& vec)
+	{
+		return vec4(
+			mat(0, 0) * vec.x + mat(0, 1) * vec.y + mat(0, 2) * vec.z + mat(0, 3) * vec.w,
+			mat(1, 0) * vec.x + mat(1, 1) * vec.y + mat(1, 2) * vec.z + mat(1, 3) * vec.w,
+			mat(2, 0) * vec.x + mat(2, 1) * vec.y + mat(2, 2) * vec.z + mat(2, 3) * vec.w,
+			vec.w);
+	}
+
+	static MM_FORCEINL __m128 MM_VECTORCALL Cross(__m128 a, __m128 b)
+	{
+		__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	// Full affine inverse, the upper 3x3 does not need to be orthonormal.
+	static MM_DEFAULT_INL mat34 MM_VECTORCALL Inverse(mat34 const& mat)
+	{
+		__m128 const xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+		__m128 const row0 = _mm_loadu_ps(mat.data + 0);
+		__m128 const row1 = _mm_loadu_ps(mat.data + 4);
+		__m128 const row2 = _mm_loadu_ps(mat.data + 8);
+		__m128 const translation = _mm_setr_ps(mat(0, 3), mat(1, 3), mat(2, 3), 0.0f);
+
+		__m128 const r0 = _mm_and_ps(row0, xyz_mask);
+		__m128 const r1 = _mm_and_ps(row1, xyz_mask);
+		__m128 const r2 = _mm_and_ps(row2, xyz_mask);
+
+		// The inverse of a 3x3 has the cross products of its rows as columns, over the determinant.
+		__m128 inv0 = Cross(r1, r2);
+		__m128 inv1 = Cross(r2, r0);
+		__m128 inv2 = Cross(r0, r1);
+		__m128 inv3 = _mm_setzero_ps();
+
+		__m128 const det = _mm_dp_ps(r0, inv0, 0x7F);
+		ASSERT(_mm_cvtss_f32(det) != 0.0f);
+		__m128 const inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		inv0 = _mm_mul_ps(inv0, inv_det);
+		inv1 = _mm_mul_ps(inv1, inv_det);
+		inv2 = _mm_mul_ps(inv2, inv_det);
+		_MM_TRANSPOSE4_PS(inv0, inv1, inv2, inv3);
+
+		// Translation is -inverse(R) * t, written into the w lane of each row.
+		inv0 = _mm_sub_ps(inv0, _mm_dp_ps(inv0, translation, 0x78));
+		inv1 = _mm_sub_ps(inv1, _mm_dp_ps(inv1, translation, 0x78));
+		inv2 = _mm_sub_ps(inv2, _mm_dp_ps(inv2, translation, 0x78));
+
+		mat34 dst;
+		_mm_storeu_ps(dst.data + 0, inv0);
+		_mm_storeu_ps(dst.data + 4, inv1);
+		_mm_storeu_ps(dst.data + 8, inv2);
+		return dst;
+	}
+
+	static MM_DEFAULT_INL mat44 MM_VECTORCALL ToMat44(mat34 const& mat)
+	{
+		return mat44(
+			mat(0, 0), mat(0, 1), mat(0, 2), mat(0, 3),
+			mat(1, 0), mat(1, 1), mat(1, 2), mat(1, 3),
+			mat(2, 0), mat(2, 1), mat(2, 2), mat(2, 3),
+			0.0f,      0.0f,      0.0f,      1.0f);
+	}
+
+	// Drops the last row, only meaningful for affine matrices.
+	static MM_DEFAULT_INL mat34 MM_VECTORCALL ToMat34(mat44 const& mat)
+	{
+		return mat34(
+			mat(0, 0), mat(0, 1), mat(0, 2), mat(0, 3),
+			mat(1, 0), mat(1, 1), mat(1, 2), mat(1, 3),
+			mat(2, 0), mat(2, 1), mat(2, 2), mat(2, 3));
+	}
+
 	static MM_DEFAULT_INL vec4 MM_VECTORCALL Mul(mat44 const& mat, vec4 const& vec)
 	{
 		return vec4(
@@ -357,6 +608,11 @@ namespace Math
 		 return memcmp(a.data, b.data, 16 * sizeof(f32)) == 0;
 	}
 
+	static MM_DEFAULT_INL bool MM_VECTORCALL Cmp(mat34 const& a, mat34 const& b)
+	{
+		 return memcmp(a.data, b.data, 12 * sizeof(f32)) == 0;
+	}
+
 	static MM_DEFAULT_INL mat44 MM_VECTORCALL Transpose(mat44 const& mat)
 	{
 		return mat44(
@@ -394,6 +650,65 @@ namespace Math
 			0, 0, 1.0f, 0);
 	}
 
+	static MM_DEFAULT_INL quat MM_VECTORCALL QuatIdentity()
+	{
+		return quat(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	// Expects a normalized axis.
+	static MM_DEFAULT_INL quat MM_VECTORCALL QuatAxisAngle(vec3 axis, Rad angle)
+	{
+		f32 const s = sinf(angle.m_value * 0.5f);
+		return quat(axis.x * s, axis.y * s, axis.z * s, cosf(angle.m_value * 0.5f));
+	}
+
+	// Extracts the rotation from the upper 3x3 of an affine matrix, the
+	// columns are normalized first so scale doesn't leak into the result.
+	static MM_DEFAULT_INL quat MM_VECTORCALL QuatFromMatrix(mat44 const& mat)
+	{
+		vec3 const x_axis = Normalize(vec3(mat(0, 0), mat(1, 0), mat(2, 0)));
+		vec3 const y_axis = Normalize(vec3(mat(0, 1), mat(1, 1), mat(2, 1)));
+		vec3 const z_axis = Normalize(vec3(mat(0, 2), mat(1, 2), mat(2, 2)));
+
+		f32 const trace = x_axis.x + y_axis.y + z_axis.z;
+
+		quat q;
+		if (trace > 0.0f)
+		{
+			f32 const s = 0.5f / sqrtf(trace + 1.0f);
+			q.w = 0.25f / s;
+			q.x = (y_axis.z - z_axis.y) * s;
+			q.y = (z_axis.x - x_axis.z) * s;
+			q.z = (x_axis.y - y_axis.x) * s;
+		}
+		else if (x_axis.x > y_axis.y && x_axis.x > z_axis.z)
+		{
+			f32 const s = 2.0f * sqrtf(1.0f + x_axis.x - y_axis.y - z_axis.z);
+			q.w = (y_axis.z - z_axis.y) / s;
+			q.x = 0.25f * s;
+			q.y = (y_axis.x + x_axis.y) / s;
+			q.z = (z_axis.x + x_axis.z) / s;
+		}
+		else if (y_axis.y > z_axis.z)
+		{
+			f32 const s = 2.0f * sqrtf(1.0f + y_axis.y - x_axis.x - z_axis.z);
+			q.w = (z_axis.x - x_axis.z) / s;
+			q.x = (y_axis.x + x_axis.y) / s;
+			q.y = 0.25f * s;
+			q.z = (z_axis.y + y_axis.z) / s;
+		}
+		else
+		{
+			f32 const s = 2.0f * sqrtf(1.0f + z_axis.z - x_axis.x - y_axis.y);
+			q.w = (x_axis.y - y_axis.x) / s;
+			q.x = (z_axis.x + x_axis.z) / s;
+			q.y = (z_axis.y + y_axis.z) / s;
+			q.z = 0.25f * s;
+		}
+
+		return q;
+	}
+
 	// Returns a vec3 (0,0,0).
 	static MM_DEFAULT_INL vec3 MM_VECTORCALL Vec3Zero()
 	{
@@ -432,12 +747,22 @@ static MM_FORCEINL mat44 MM_VECTORCALL operator*(mat44 const& a, mat44 const& b)
 	return Math::Mul(a, b);
 }
 
+static MM_FORCEINL mat34 MM_VECTORCALL operator*(mat34 const& a, mat34 const& b)
+{
+	return Math::Mul(a, b);
+}
+
 static MM_FORCEINL vec4 MM_VECTORCALL operator*(vec4 const& vec, f32 scalar)
 {
 	return Math::Mul(vec, scalar);
 }
 
 static MM_FORCEINL bool MM_VECTORCALL operator==(mat44 const& a, mat44 const& b)
+{
+	return Math::Cmp(a, b);
+}
+
+static MM_FORCEINL bool MM_VECTORCALL operator==(mat34 const& a, mat34 const& b)
 {
 	return Math::Cmp(a, b);
 }
\ No newline at end of file
@@ -97,6 +97,41 @@ namespace Test
 		ASSERT(mat_expected == mat_actual);
 	}
 
+	void Mat34Mul()
+	{
+		mat34 mat_a(
+			1, 4, 2, 3,
+			2, 5, 2, 1,
+			2, 5, 8, 1);
+
+		mat34 mat_b(
+			0, 1, 2, 0,
+			5, 7, 0, 9,
+			3, 4, 2, 6);
+
+		ASSERT(mat_a * mat34::Identity() == mat_a);
+
+		// Has to match the full 4x4 multiply with an implicit (0, 0, 0, 1) last row.
+		mat34 mat_expected = ToMat34(ToMat44(mat_a) * ToMat44(mat_b));
+		mat34 mat_actual = mat_a * mat_b;
+
+		ASSERT(mat_expected == mat_actual);
+	}
+
+	void Mat34Inverse()
+	{
+		mat34 mat = TRS<mat34>(vec3(1.0f, -2.0f, 3.0f), QuatAxisAngle(Normalize(vec3(1.0f, 2.0f, 3.0f)), Rad(0.5f)), vec3(2.0f, 0.5f, 4.0f));
+		mat34 identity = mat * Inverse(mat);
+
+		for (u32 row = 0; row < 3; ++row)
+		{
+			for (u32 col = 0; col < 4; ++col)
+			{
+				ASSERT(NearlyEqual(identity(row, col), mat34::Identity()(row, col), 0.0001f));
+			}
+		}
+	}
+
 	void RadDegreeConverions()
 	{
 		{
@@ -125,6 +160,8 @@ namespace Test
 		Mat44IndexAccess();
 		Mat44Cmp();
 		Mat44Mul();
+		Mat34Mul();
+		Mat34Inverse();
 		RadDegreeConverions();
 	}
 }
@@ -1,5 +1,11 @@
 #include "Memory.h"
+
+#ifdef _WIN32
 #include "Win32.h"
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace Memory
 {
@@ -7,6 +13,7 @@ namespace Memory
 	{
 		MemZeroSafe(arena);
 
+#ifdef _WIN32
 		// Nothing fancy, we just always commit. If we need anything
 		// more complex than this, we'll solve it bespokely.
 		u32 alloc_type = MEM_RESERVE | MEM_COMMIT;
@@ -34,6 +41,20 @@ namespace Memory
 			ASSERT_FAIL_F("Failed to allocate memory for arena!");
 			return;
 		}
+#else
+		// Pages are committed on first touch, huge pages are left to transparent huge pages.
+		u64 aligned_size = AlignValue(size_bytes, alignment);
+		aligned_size = AlignValue(aligned_size, (u64)sysconf(_SC_PAGESIZE));
+
+		void* mapping = mmap(nullptr, aligned_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		u8* allocation = (mapping != MAP_FAILED) ? (u8*)mapping : nullptr;
+
+		if (allocation == nullptr)
+		{
+			ASSERT_FAIL_F("Failed to allocate memory for arena!");
+			return;
+		}
+#endif
 
 		arena->m_memory_block = allocation;
 		arena->m_bytes_used = 0;
@@ -51,7 +72,11 @@ namespace Memory
 
 	void FreeArena(Arena* arena)
 	{
+#ifdef _WIN32
 		VirtualFree(arena->m_memory_block, 0, MEM_RELEASE);
+#else
+		munmap(arena->m_memory_block, arena->m_size);
+#endif
 		MemZeroSafe(arena);
 	}
 
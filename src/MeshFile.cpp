@@ -0,0 +1,631 @@
+#include "MeshFile.h"
+#include "BlockCompression.h"
+#include "MipGeneration.h"
+
+namespace MeshFile
+{
+	static u64 AlignSection(u64 offset)
+	{
+		return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+	}
+
+	// Size a section has to have if it is present, derived from the counts in the header.
+	static u64 GetExpectedSectionSize(Header const* header, SectionType::Enum type)
+	{
+		u64 const num_vertices = header->num_vertices;
+
+		switch (type)
+		{
+		case SectionType::Indices:             return sizeof(Gfx::Index_t) * header->num_indices;
+		case SectionType::Positions:           return sizeof(Gfx::Position_t) * num_vertices;
+		case SectionType::Normals:             return sizeof(Gfx::Normal_t) * num_vertices;
+		case SectionType::TexCoords:           return sizeof(Gfx::TexCoord_t) * num_vertices;
+		case SectionType::Tangents:            return sizeof(Gfx::Tangent_t) * num_vertices;
+		case SectionType::CompressedPositions: return sizeof(Gfx::CompressedPosition_t) * num_vertices;
+		case SectionType::CompressedNormals:   return sizeof(Gfx::CompressedNormal_t) * num_vertices;
+		case SectionType::CompressedTexCoords: return sizeof(Gfx::CompressedTexCoord_t) * num_vertices;
+		case SectionType::CompressedTangents:  return sizeof(Gfx::CompressedTangent_t) * num_vertices;
+		case SectionType::Interleaved:         return (u64)header->interleaved_stride * num_vertices;
+		case SectionType::SubMeshes:           return sizeof(Gfx::SubMesh) * header->num_submeshes;
+		case SectionType::Instances:           return sizeof(Gfx::MeshInstance) * header->num_instances;
+		case SectionType::NodeLocals:          return sizeof(Scene::Transform) * header->num_nodes;
+		case SectionType::NodeParents:         return sizeof(u32) * header->num_nodes;
+		case SectionType::Meshlets:            return sizeof(Gfx::Meshlet) * header->num_meshlets;
+		case SectionType::MeshletVertices:     return sizeof(Gfx::Index_t) * header->num_meshlet_vertices;
+		case SectionType::MeshletTriangles:    return sizeof(u8) * 3 * header->num_meshlet_triangles;
+		case SectionType::Materials:           return sizeof(Mini::MaterialImport) * header->num_materials;
+		case SectionType::SubMeshMaterials:    return sizeof(u32) * header->num_submeshes;
+		case SectionType::Textures:            return sizeof(TextureRecord) * header->num_textures;
+		case SectionType::TextureData:         return header->texture_data_size;
+		case SectionType::Joints:              return sizeof(Gfx::Joints_t) * num_vertices;
+		case SectionType::Weights:             return sizeof(Gfx::Weights_t) * num_vertices;
+		case SectionType::Skins:               return sizeof(Mini::SkinImport) * header->num_skins;
+		case SectionType::SkinJoints:          return sizeof(u32) * header->num_skin_joints;
+		case SectionType::InverseBindMatrices: return sizeof(mat34) * header->num_skin_joints;
+		case SectionType::AnimationClips:      return sizeof(Animation::Clip) * header->num_animation_clips;
+		case SectionType::AnimationTracks:     return sizeof(Animation::Track) * header->num_animation_tracks;
+		case SectionType::AnimationKeyTimes:   return sizeof(u16) * header->num_animation_keys;
+		case SectionType::AnimationKeys:       return sizeof(Animation::Key) * header->num_animation_keys;
+		case SectionType::MorphSets:           return sizeof(Morph::TargetSet) * header->num_morph_sets;
+		case SectionType::MorphTargets:        return sizeof(Morph::Target) * header->num_morph_targets;
+		case SectionType::MorphChunkOffsets:   return sizeof(u32) * header->num_morph_chunks;
+		case SectionType::MorphChunks:         return sizeof(Morph::DeltaChunk) * header->num_morph_chunks;
+		case SectionType::InstanceBatches:     return sizeof(Gfx::InstanceBatch) * header->num_instance_batches;
+		case SectionType::BatchNodes:          return sizeof(u32) * header->num_batch_instances;
+		case SectionType::BatchTransforms:     return sizeof(mat34) * header->num_batch_instances;
+		default:
+			ASSERT_FAIL();
+			return 0;
+		}
+	}
+
+	static u64 GetTextureDataSize(Gfx::TextureFormat::Enum format, u32 width, u32 height, u32 num_levels)
+	{
+		u64 size = 0;
+		for (u32 level = 0; level < num_levels; ++level)
+		{
+			size += BlockCompression::GetCompressedSize(format, MipGeneration::GetLevelSize(width, level), MipGeneration::GetLevelSize(height, level));
+		}
+		return size;
+	}
+
+	bool Write(char const* path, Mini::MeshImport const* imported, Memory::Arena* scratch_memory)
+	{
+		Header header;
+		MemZeroSafe(header);
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.import_flags = imported->flags;
+		header.num_vertices = imported->num_vertices;
+		header.num_indices = imported->num_indices;
+		header.num_submeshes = imported->num_submeshes;
+		header.num_instances = imported->num_instances;
+		header.num_nodes = imported->hierarchy.num_nodes;
+		header.num_meshlets = imported->num_meshlets;
+		header.num_meshlet_vertices = imported->num_meshlet_vertices;
+		header.num_meshlet_triangles = imported->num_meshlet_triangles;
+		header.num_materials = imported->num_materials;
+		header.num_textures = imported->num_textures;
+		header.num_skins = imported->num_skins;
+		header.num_skin_joints = imported->num_skin_joints;
+		header.num_animation_clips = imported->animations.num_clips;
+		header.num_animation_tracks = imported->animations.num_tracks;
+		header.num_animation_keys = imported->animations.num_keys;
+		header.num_morph_sets = imported->morph_targets.num_sets;
+		header.num_morph_targets = imported->morph_targets.num_targets;
+		header.num_morph_chunks = imported->morph_targets.num_chunks;
+		header.num_instance_batches = imported->num_instance_batches;
+		header.num_batch_instances = imported->num_batch_instances;
+		header.interleaved_stride = imported->interleaved_stride;
+		memcpy(header.interleaved_offsets, imported->interleaved_offsets, sizeof(header.interleaved_offsets));
+		header.bounds = imported->bounds;
+		header.bounding_sphere = imported->bounding_sphere;
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		// Texture data is packed into one blob, with the records pointing into it.
+		TextureRecord* texture_records = nullptr;
+		u8* texture_data = nullptr;
+		if (imported->num_textures > 0)
+		{
+			texture_records = Memory::PushType<TextureRecord>(scratch_memory, imported->num_textures, Memory::ZeroPush());
+			for (u32 i = 0; i < imported->num_textures; ++i)
+			{
+				Mini::TextureImport const& texture = imported->textures[i];
+				u8 const* data = texture.compressed_data ? texture.compressed_data : texture.surface.pixels;
+
+				TextureRecord& record = texture_records[i];
+				record.format = texture.format;
+				record.width = texture.surface.width;
+				record.height = texture.surface.height;
+				record.b_srgb = texture.b_srgb;
+				record.num_levels = texture.num_levels;
+				record.data_offset = (header.texture_data_size + 15) & ~15ull;
+				record.data_size = data ? GetTextureDataSize(texture.format, texture.surface.width, texture.surface.height, texture.num_levels) : 0;
+				header.texture_data_size = record.data_offset + record.data_size;
+			}
+
+			if (header.texture_data_size > 0)
+			{
+				texture_data = (u8*)Memory::PushSize(scratch_memory, header.texture_data_size, Memory::ZeroPush());
+				for (u32 i = 0; i < imported->num_textures; ++i)
+				{
+					Mini::TextureImport const& texture = imported->textures[i];
+					u8 const* data = texture.compressed_data ? texture.compressed_data : texture.surface.pixels;
+					if (data != nullptr)
+					{
+						memcpy(texture_data + texture_records[i].data_offset, data, texture_records[i].data_size);
+					}
+				}
+			}
+		}
+
+		// The hierarchy is stored in its sorted order, so rebuilding it on load keeps the node indices.
+		void const* section_data[SectionType::EnumCount];
+		section_data[SectionType::Indices] = imported->index_buffer;
+		section_data[SectionType::Positions] = imported->position_buffer;
+		section_data[SectionType::Normals] = imported->normal_buffer;
+		section_data[SectionType::TexCoords] = imported->texcoord_buffer;
+		section_data[SectionType::Tangents] = imported->tangent_buffer;
+		section_data[SectionType::CompressedPositions] = imported->compressed_position_buffer;
+		section_data[SectionType::CompressedNormals] = imported->compressed_normal_buffer;
+		section_data[SectionType::CompressedTexCoords] = imported->compressed_texcoord_buffer;
+		section_data[SectionType::CompressedTangents] = imported->compressed_tangent_buffer;
+		section_data[SectionType::Interleaved] = imported->interleaved_buffer;
+		section_data[SectionType::SubMeshes] = imported->submeshes;
+		section_data[SectionType::Instances] = imported->instances;
+		section_data[SectionType::NodeLocals] = imported->hierarchy.locals;
+		section_data[SectionType::NodeParents] = imported->hierarchy.parents;
+		section_data[SectionType::Meshlets] = imported->meshlets;
+		section_data[SectionType::MeshletVertices] = imported->meshlet_vertices;
+		section_data[SectionType::MeshletTriangles] = imported->meshlet_triangles;
+		section_data[SectionType::Materials] = imported->materials;
+		section_data[SectionType::SubMeshMaterials] = imported->submesh_materials;
+		section_data[SectionType::Textures] = texture_records;
+		section_data[SectionType::TextureData] = texture_data;
+		section_data[SectionType::Joints] = imported->joint_buffer;
+		section_data[SectionType::Weights] = imported->weight_buffer;
+		section_data[SectionType::Skins] = imported->skins;
+		section_data[SectionType::SkinJoints] = imported->skin_joints;
+		section_data[SectionType::InverseBindMatrices] = imported->inverse_bind_matrices;
+		section_data[SectionType::AnimationClips] = imported->animations.clips;
+		section_data[SectionType::AnimationTracks] = imported->animations.tracks;
+		section_data[SectionType::AnimationKeyTimes] = imported->animations.key_times;
+		section_data[SectionType::AnimationKeys] = imported->animations.keys;
+		section_data[SectionType::MorphSets] = imported->morph_targets.sets;
+		section_data[SectionType::MorphTargets] = imported->morph_targets.targets;
+		section_data[SectionType::MorphChunkOffsets] = imported->morph_targets.chunk_offsets;
+		section_data[SectionType::MorphChunks] = imported->morph_targets.chunks;
+		section_data[SectionType::InstanceBatches] = imported->instance_batches;
+		section_data[SectionType::BatchNodes] = imported->batch_instance_nodes;
+		section_data[SectionType::BatchTransforms] = imported->batch_instance_transforms;
+
+		u64 file_size = sizeof(Header);
+		for (u32 i = 0; i < SectionType::EnumCount; ++i)
+		{
+			if (section_data[i] == nullptr)
+			{
+				continue;
+			}
+
+			Section& section = header.sections[i];
+			section.size = GetExpectedSectionSize(&header, (SectionType::Enum)i);
+			if (section.size > 0)
+			{
+				section.offset = AlignSection(file_size);
+				file_size = section.offset + section.size;
+			}
+		}
+
+		// Zeroed, so the padding between sections is deterministic.
+		u8* image = (u8*)Memory::PushSize(scratch_memory, file_size, Memory::ZeroPush());
+		memcpy(image, &header, sizeof(header));
+
+		for (u32 i = 0; i < SectionType::EnumCount; ++i)
+		{
+			Section const& section = header.sections[i];
+			if (section.size > 0)
+			{
+				memcpy(image + section.offset, section_data[i], section.size);
+			}
+		}
+
+		return IO::SaveFile(path, image, file_size);
+	}
+
+	static bool ValidateHeader(char const* path, IO::MappedFile const* mapping)
+	{
+		UNUSED(path); // Only logged.
+
+		if (mapping->size < sizeof(Header))
+		{
+			LOG(Log::IO, "%s is too small to be a mesh file!", path);
+			return false;
+		}
+
+		Header const* header = reinterpret_cast<Header const*>(mapping->data);
+		if (header->magic != MAGIC || header->version != VERSION)
+		{
+			LOG(Log::IO, "%s is not a mesh file of version %u!", path, VERSION);
+			return false;
+		}
+
+		for (u32 i = 0; i < SectionType::EnumCount; ++i)
+		{
+			Section const& section = header->sections[i];
+			if (section.size == 0)
+			{
+				continue;
+			}
+
+			bool const b_in_file = section.offset % SECTION_ALIGNMENT == 0 && section.offset <= mapping->size &&
+				section.size <= mapping->size - section.offset;
+
+			if (!b_in_file || section.size != GetExpectedSectionSize(header, (SectionType::Enum)i))
+			{
+				LOG(Log::IO, "%s has a corrupt section table!", path);
+				return false;
+			}
+		}
+
+		bool const b_has_positions = header->sections[SectionType::Positions].size > 0 ||
+			header->sections[SectionType::CompressedPositions].size > 0 ||
+			header->sections[SectionType::Interleaved].size > 0;
+
+		bool const b_has_nodes = header->num_nodes == 0 ||
+			(header->sections[SectionType::NodeLocals].size > 0 && header->sections[SectionType::NodeParents].size > 0);
+		bool const b_has_instances = header->num_instances == 0 || header->sections[SectionType::Instances].size > 0;
+		bool const b_has_meshlets = header->num_meshlets == 0 ||
+			(header->sections[SectionType::Meshlets].size > 0 && header->sections[SectionType::MeshletVertices].size > 0 &&
+			header->sections[SectionType::MeshletTriangles].size > 0);
+
+		bool const b_has_materials = header->num_materials == 0 ||
+			(header->sections[SectionType::Materials].size > 0 && header->sections[SectionType::SubMeshMaterials].size > 0);
+		bool const b_has_textures = (header->num_textures == 0 || header->sections[SectionType::Textures].size > 0) &&
+			(header->texture_data_size == 0 || header->sections[SectionType::TextureData].size > 0);
+		bool const b_has_skins = header->num_skins == 0 ||
+			(header->sections[SectionType::Skins].size > 0 && header->sections[SectionType::SkinJoints].size > 0 &&
+			header->sections[SectionType::InverseBindMatrices].size > 0);
+		bool const b_has_weights = (header->sections[SectionType::Joints].size > 0) == (header->sections[SectionType::Weights].size > 0);
+		bool const b_has_animations = (header->num_animation_clips == 0 || header->sections[SectionType::AnimationClips].size > 0) &&
+			(header->num_animation_tracks == 0 || header->sections[SectionType::AnimationTracks].size > 0) &&
+			(header->num_animation_keys == 0 ||
+			(header->sections[SectionType::AnimationKeyTimes].size > 0 && header->sections[SectionType::AnimationKeys].size > 0));
+		bool const b_has_morph_targets = (header->num_morph_sets == 0 || header->sections[SectionType::MorphSets].size > 0) &&
+			(header->num_morph_targets == 0 || header->sections[SectionType::MorphTargets].size > 0) &&
+			(header->num_morph_chunks == 0 ||
+			(header->sections[SectionType::MorphChunkOffsets].size > 0 && header->sections[SectionType::MorphChunks].size > 0));
+		bool const b_has_instance_batches = (header->num_instance_batches == 0 || header->sections[SectionType::InstanceBatches].size > 0) &&
+			(header->num_batch_instances == 0 ||
+			(header->sections[SectionType::BatchNodes].size > 0 && header->sections[SectionType::BatchTransforms].size > 0));
+
+		if (header->sections[SectionType::Indices].size == 0 || !b_has_positions || header->sections[SectionType::SubMeshes].size == 0 ||
+			!b_has_nodes || !b_has_instances || !b_has_meshlets || !b_has_materials || !b_has_textures || !b_has_skins || !b_has_weights ||
+			!b_has_animations || !b_has_morph_targets || !b_has_instance_batches)
+		{
+			LOG(Log::IO, "%s is missing mesh data!", path);
+			return false;
+		}
+
+		// Drawing trusts the index, vertex and meshlet ranges of the submeshes.
+		Gfx::SubMesh const* submeshes = reinterpret_cast<Gfx::SubMesh const*>(mapping->data + header->sections[SectionType::SubMeshes].offset);
+		Gfx::Index_t const* indices = reinterpret_cast<Gfx::Index_t const*>(mapping->data + header->sections[SectionType::Indices].offset);
+
+		bool b_valid_submeshes = true;
+		for (u32 i = 0; i < header->num_submeshes && b_valid_submeshes; ++i)
+		{
+			Gfx::SubMesh const& submesh = submeshes[i];
+			b_valid_submeshes &= submesh.base_vertex_location <= header->num_vertices && submesh.num_lods <= Gfx::MAX_SUBMESH_LODS &&
+				submesh.first_meshlet <= header->num_meshlets && submesh.num_meshlets <= header->num_meshlets - submesh.first_meshlet;
+
+			for (u32 lod = 0; lod <= submesh.num_lods && b_valid_submeshes; ++lod)
+			{
+				u32 const first_index = lod == 0 ? submesh.first_index_location : submesh.lods[lod - 1].first_index_location;
+				u32 const num_indices = lod == 0 ? submesh.num_indices : submesh.lods[lod - 1].num_indices;
+				b_valid_submeshes &= first_index <= header->num_indices && num_indices <= header->num_indices - first_index;
+
+				// Indices are relative to the base vertex.
+				u32 const num_submesh_vertices = header->num_vertices - submesh.base_vertex_location;
+				for (u32 index = first_index; index < first_index + num_indices && b_valid_submeshes; ++index)
+				{
+					b_valid_submeshes &= indices[index] < num_submesh_vertices;
+				}
+			}
+		}
+
+		Gfx::Meshlet const* meshlets = reinterpret_cast<Gfx::Meshlet const*>(mapping->data + header->sections[SectionType::Meshlets].offset);
+		for (u32 i = 0; i < header->num_meshlets; ++i)
+		{
+			Gfx::Meshlet const& meshlet = meshlets[i];
+			b_valid_submeshes &= meshlet.num_vertices <= Gfx::MAX_MESHLET_VERTICES && meshlet.num_triangles <= Gfx::MAX_MESHLET_TRIANGLES &&
+				meshlet.first_vertex <= header->num_meshlet_vertices && meshlet.num_vertices <= header->num_meshlet_vertices - meshlet.first_vertex &&
+				meshlet.first_triangle <= header->num_meshlet_triangles && meshlet.num_triangles <= header->num_meshlet_triangles - meshlet.first_triangle;
+		}
+
+		if (!b_valid_submeshes)
+		{
+			LOG(Log::IO, "%s has a corrupt submesh!", path);
+			return false;
+		}
+
+		// Rebuilding the hierarchy expects the depth sorted order it was written in, parents come before their children.
+		// Instances index the nodes and submeshes.
+		u32 const* node_parents = reinterpret_cast<u32 const*>(mapping->data + header->sections[SectionType::NodeParents].offset);
+		Gfx::MeshInstance const* instances = reinterpret_cast<Gfx::MeshInstance const*>(mapping->data + header->sections[SectionType::Instances].offset);
+
+		bool b_valid_nodes = true;
+		for (u32 i = 0; i < header->num_nodes; ++i)
+		{
+			b_valid_nodes &= node_parents[i] == Scene::INVALID_NODE || node_parents[i] < i;
+		}
+		for (u32 i = 0; i < header->num_instances; ++i)
+		{
+			b_valid_nodes &= instances[i].node < header->num_nodes && instances[i].first_submesh <= header->num_submeshes &&
+				instances[i].num_submeshes <= header->num_submeshes - instances[i].first_submesh;
+		}
+
+		if (!b_valid_nodes)
+		{
+			LOG(Log::IO, "%s has a corrupt node hierarchy!", path);
+			return false;
+		}
+
+		TextureRecord const* records = reinterpret_cast<TextureRecord const*>(mapping->data + header->sections[SectionType::Textures].offset);
+		for (u32 i = 0; i < header->num_textures; ++i)
+		{
+			TextureRecord const& record = records[i];
+			bool const b_valid = record.format < Gfx::TextureFormat::EnumCount && record.width <= Image::MAX_DIMENSION &&
+				record.height <= Image::MAX_DIMENSION && record.data_offset <= header->texture_data_size &&
+				record.data_size <= header->texture_data_size - record.data_offset &&
+				(record.data_size == 0 || (record.width > 0 && record.height > 0 && record.num_levels > 0 &&
+				record.num_levels <= MipGeneration::GetNumLevels(record.width, record.height) &&
+				record.data_size == GetTextureDataSize((Gfx::TextureFormat::Enum)record.format, record.width, record.height, record.num_levels)));
+
+			if (!b_valid)
+			{
+				LOG(Log::IO, "%s has a corrupt texture record!", path);
+				return false;
+			}
+		}
+
+		// Skinning indexes the joint nodes and matrices with these, without further checks.
+		Mini::SkinImport const* skins = reinterpret_cast<Mini::SkinImport const*>(mapping->data + header->sections[SectionType::Skins].offset);
+		u32 const* skin_joints = reinterpret_cast<u32 const*>(mapping->data + header->sections[SectionType::SkinJoints].offset);
+
+		bool b_valid_skins = true;
+		for (u32 i = 0; i < header->num_skins; ++i)
+		{
+			b_valid_skins &= skins[i].first_joint <= header->num_skin_joints && skins[i].num_joints <= header->num_skin_joints - skins[i].first_joint;
+		}
+		for (u32 i = 0; i < header->num_skin_joints; ++i)
+		{
+			b_valid_skins &= skin_joints[i] < header->num_nodes;
+		}
+		for (u32 i = 0; i < header->num_instances; ++i)
+		{
+			b_valid_skins &= instances[i].skin == Gfx::SKIN_NONE || (instances[i].skin < header->num_skins && header->sections[SectionType::Joints].size > 0);
+		}
+
+		if (!b_valid_skins)
+		{
+			LOG(Log::IO, "%s has a corrupt skin!", path);
+			return false;
+		}
+
+		// Sampling trusts the ranges and targets of the tracks as well.
+		Animation::Clip const* clips = reinterpret_cast<Animation::Clip const*>(mapping->data + header->sections[SectionType::AnimationClips].offset);
+		Animation::Track const* tracks = reinterpret_cast<Animation::Track const*>(mapping->data + header->sections[SectionType::AnimationTracks].offset);
+
+		bool b_valid_animations = true;
+		for (u32 i = 0; i < header->num_animation_clips; ++i)
+		{
+			b_valid_animations &= clips[i].first_track <= header->num_animation_tracks &&
+				clips[i].num_tracks <= header->num_animation_tracks - clips[i].first_track && clips[i].duration >= 0.0f;
+		}
+		for (u32 i = 0; i < header->num_animation_tracks; ++i)
+		{
+			b_valid_animations &= tracks[i].node < header->num_nodes && tracks[i].type < Animation::TrackType::EnumCount &&
+				tracks[i].num_keys > 0 && tracks[i].first_key <= header->num_animation_keys &&
+				tracks[i].num_keys <= header->num_animation_keys - tracks[i].first_key;
+		}
+
+		if (!b_valid_animations)
+		{
+			LOG(Log::IO, "%s has a corrupt animation!", path);
+			return false;
+		}
+
+		// Blending writes every vertex of a set and adds the chunks of its targets to them.
+		Morph::TargetSet const* morph_sets = reinterpret_cast<Morph::TargetSet const*>(mapping->data + header->sections[SectionType::MorphSets].offset);
+		Morph::Target const* morph_targets = reinterpret_cast<Morph::Target const*>(mapping->data + header->sections[SectionType::MorphTargets].offset);
+		u32 const* chunk_offsets = reinterpret_cast<u32 const*>(mapping->data + header->sections[SectionType::MorphChunkOffsets].offset);
+
+		bool b_valid_morph_targets = true;
+		for (u32 i = 0; i < header->num_morph_sets; ++i)
+		{
+			Morph::TargetSet const& set = morph_sets[i];
+			b_valid_morph_targets &= set.first_vertex <= header->num_vertices && set.num_vertices <= header->num_vertices - set.first_vertex &&
+				set.first_target <= header->num_morph_targets && set.num_targets <= header->num_morph_targets - set.first_target;
+			if (!b_valid_morph_targets)
+			{
+				break;
+			}
+
+			for (u32 target_idx = set.first_target; target_idx < set.first_target + set.num_targets && b_valid_morph_targets; ++target_idx)
+			{
+				Morph::Target const& target = morph_targets[target_idx];
+				b_valid_morph_targets &= target.first_chunk <= header->num_morph_chunks && target.num_chunks <= header->num_morph_chunks - target.first_chunk;
+				for (u32 chunk_idx = 0; chunk_idx < target.num_chunks && b_valid_morph_targets; ++chunk_idx)
+				{
+					u32 const offset = chunk_offsets[target.first_chunk + chunk_idx];
+					b_valid_morph_targets &= offset % Morph::CHUNK_VERTICES == 0 && offset < set.num_vertices &&
+						(chunk_idx == 0 || offset > chunk_offsets[target.first_chunk + chunk_idx - 1]);
+				}
+			}
+		}
+		for (u32 i = 0; i < header->num_instances; ++i)
+		{
+			b_valid_morph_targets &= instances[i].morph == Gfx::MORPH_NONE || instances[i].morph < header->num_morph_sets;
+		}
+
+		if (!b_valid_morph_targets)
+		{
+			LOG(Log::IO, "%s has a corrupt morph target!", path);
+			return false;
+		}
+
+		// Drawing a batch reads its submeshes, and the world transforms of its instance nodes.
+		Gfx::InstanceBatch const* batches = reinterpret_cast<Gfx::InstanceBatch const*>(mapping->data + header->sections[SectionType::InstanceBatches].offset);
+		u32 const* batch_nodes = reinterpret_cast<u32 const*>(mapping->data + header->sections[SectionType::BatchNodes].offset);
+
+		bool b_valid_batches = true;
+		for (u32 i = 0; i < header->num_instance_batches; ++i)
+		{
+			Gfx::InstanceBatch const& batch = batches[i];
+			b_valid_batches &= batch.first_submesh <= header->num_submeshes && batch.num_submeshes <= header->num_submeshes - batch.first_submesh &&
+				batch.first_instance <= header->num_batch_instances && batch.num_instances <= header->num_batch_instances - batch.first_instance;
+		}
+		for (u32 i = 0; i < header->num_batch_instances; ++i)
+		{
+			b_valid_batches &= batch_nodes[i] < header->num_nodes;
+		}
+
+		if (!b_valid_batches)
+		{
+			LOG(Log::IO, "%s has a corrupt instance batch!", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Load(char const* path, Mini::MeshImport* out_imported, IO::MappedFile* out_mapping, Memory::Arena* scene_memory)
+	{
+		MemZeroSafe(out_imported);
+
+		if (!IO::MapFile(path, out_mapping))
+		{
+			return false;
+		}
+
+		if (!ValidateHeader(path, out_mapping))
+		{
+			IO::UnmapFile(out_mapping);
+			return false;
+		}
+
+		Header const* header = reinterpret_cast<Header const*>(out_mapping->data);
+
+		struct Local
+		{
+			// The mapping is read-only, the MeshImport streams just aren't const.
+			static void* GetSection(IO::MappedFile const* mapping, SectionType::Enum type)
+			{
+				Section const& section = reinterpret_cast<Header const*>(mapping->data)->sections[type];
+				return section.size > 0 ? const_cast<u8*>(mapping->data + section.offset) : nullptr;
+			}
+		};
+
+		Mini::MeshImport& imported = *out_imported;
+		imported.flags = header->import_flags;
+		imported.num_vertices = header->num_vertices;
+		imported.num_indices = header->num_indices;
+		imported.num_submeshes = header->num_submeshes;
+		imported.bounds = header->bounds;
+		imported.bounding_sphere = header->bounding_sphere;
+		imported.interleaved_stride = header->interleaved_stride;
+		memcpy(imported.interleaved_offsets, header->interleaved_offsets, sizeof(imported.interleaved_offsets));
+
+		imported.index_buffer = (Gfx::Index_t*)Local::GetSection(out_mapping, SectionType::Indices);
+		imported.position_buffer = (Gfx::Position_t*)Local::GetSection(out_mapping, SectionType::Positions);
+		imported.normal_buffer = (Gfx::Normal_t*)Local::GetSection(out_mapping, SectionType::Normals);
+		imported.texcoord_buffer = (Gfx::TexCoord_t*)Local::GetSection(out_mapping, SectionType::TexCoords);
+		imported.tangent_buffer = (Gfx::Tangent_t*)Local::GetSection(out_mapping, SectionType::Tangents);
+		imported.compressed_position_buffer = (Gfx::CompressedPosition_t*)Local::GetSection(out_mapping, SectionType::CompressedPositions);
+		imported.compressed_normal_buffer = (Gfx::CompressedNormal_t*)Local::GetSection(out_mapping, SectionType::CompressedNormals);
+		imported.compressed_texcoord_buffer = (Gfx::CompressedTexCoord_t*)Local::GetSection(out_mapping, SectionType::CompressedTexCoords);
+		imported.compressed_tangent_buffer = (Gfx::CompressedTangent_t*)Local::GetSection(out_mapping, SectionType::CompressedTangents);
+		imported.interleaved_buffer = (u8*)Local::GetSection(out_mapping, SectionType::Interleaved);
+		imported.joint_buffer = (Gfx::Joints_t*)Local::GetSection(out_mapping, SectionType::Joints);
+		imported.weight_buffer = (Gfx::Weights_t*)Local::GetSection(out_mapping, SectionType::Weights);
+		imported.submeshes = (Gfx::SubMesh*)Local::GetSection(out_mapping, SectionType::SubMeshes);
+
+		imported.num_meshlets = header->num_meshlets;
+		imported.num_meshlet_vertices = header->num_meshlet_vertices;
+		imported.num_meshlet_triangles = header->num_meshlet_triangles;
+		imported.meshlets = (Gfx::Meshlet*)Local::GetSection(out_mapping, SectionType::Meshlets);
+		imported.meshlet_vertices = (Gfx::Index_t*)Local::GetSection(out_mapping, SectionType::MeshletVertices);
+		imported.meshlet_triangles = (u8*)Local::GetSection(out_mapping, SectionType::MeshletTriangles);
+
+		imported.num_materials = header->num_materials;
+		imported.materials = (Mini::MaterialImport*)Local::GetSection(out_mapping, SectionType::Materials);
+		imported.submesh_materials = (u32*)Local::GetSection(out_mapping, SectionType::SubMeshMaterials);
+
+		Morph::TargetLibrary& morph_targets = imported.morph_targets;
+		morph_targets.num_sets = header->num_morph_sets;
+		morph_targets.num_targets = header->num_morph_targets;
+		morph_targets.num_chunks = header->num_morph_chunks;
+		morph_targets.sets = (Morph::TargetSet*)Local::GetSection(out_mapping, SectionType::MorphSets);
+		morph_targets.targets = (Morph::Target*)Local::GetSection(out_mapping, SectionType::MorphTargets);
+		morph_targets.chunk_offsets = (u32*)Local::GetSection(out_mapping, SectionType::MorphChunkOffsets);
+		morph_targets.chunks = (Morph::DeltaChunk*)Local::GetSection(out_mapping, SectionType::MorphChunks);
+
+		if (scene_memory != nullptr && header->num_nodes > 0)
+		{
+			// Nodes were written sorted by depth, the rebuild keeps their order.
+			Scene::Transform const* locals = (Scene::Transform const*)Local::GetSection(out_mapping, SectionType::NodeLocals);
+			u32 const* parents = (u32 const*)Local::GetSection(out_mapping, SectionType::NodeParents);
+			Scene::BuildHierarchy(&imported.hierarchy, scene_memory, parents, locals, header->num_nodes, nullptr);
+
+			imported.num_instances = header->num_instances;
+			imported.instances = Memory::PushType<Gfx::MeshInstance>(scene_memory, header->num_instances);
+			if (header->num_instances > 0)
+			{
+				memcpy(imported.instances, Local::GetSection(out_mapping, SectionType::Instances), sizeof(Gfx::MeshInstance) * header->num_instances);
+			}
+
+			if (header->num_instance_batches > 0)
+			{
+				imported.num_instance_batches = header->num_instance_batches;
+				imported.num_batch_instances = header->num_batch_instances;
+				imported.instance_batches = Memory::PushType<Gfx::InstanceBatch>(scene_memory, header->num_instance_batches);
+				imported.batch_instance_nodes = Memory::PushType<u32>(scene_memory, header->num_batch_instances);
+				imported.batch_instance_transforms = Memory::PushType<mat34>(scene_memory, header->num_batch_instances);
+				memcpy(imported.instance_batches, Local::GetSection(out_mapping, SectionType::InstanceBatches),
+					sizeof(Gfx::InstanceBatch) * header->num_instance_batches);
+				memcpy(imported.batch_instance_nodes, Local::GetSection(out_mapping, SectionType::BatchNodes),
+					sizeof(u32) * header->num_batch_instances);
+				memcpy(imported.batch_instance_transforms, Local::GetSection(out_mapping, SectionType::BatchTransforms),
+					sizeof(mat34) * header->num_batch_instances);
+			}
+
+			imported.num_skins = header->num_skins;
+			imported.num_skin_joints = header->num_skin_joints;
+			imported.skins = (Mini::SkinImport*)Local::GetSection(out_mapping, SectionType::Skins);
+			imported.skin_joints = (u32*)Local::GetSection(out_mapping, SectionType::SkinJoints);
+			imported.inverse_bind_matrices = (mat34*)Local::GetSection(out_mapping, SectionType::InverseBindMatrices);
+
+			Animation::ClipLibrary& animations = imported.animations;
+			animations.num_clips = header->num_animation_clips;
+			animations.num_tracks = header->num_animation_tracks;
+			animations.num_keys = header->num_animation_keys;
+			animations.clips = (Animation::Clip*)Local::GetSection(out_mapping, SectionType::AnimationClips);
+			animations.tracks = (Animation::Track*)Local::GetSection(out_mapping, SectionType::AnimationTracks);
+			animations.key_times = (u16*)Local::GetSection(out_mapping, SectionType::AnimationKeyTimes);
+			animations.keys = (Animation::Key*)Local::GetSection(out_mapping, SectionType::AnimationKeys);
+		}
+
+		if (scene_memory != nullptr && header->num_textures > 0)
+		{
+			TextureRecord const* records = (TextureRecord const*)Local::GetSection(out_mapping, SectionType::Textures);
+			u8* texture_data = (u8*)Local::GetSection(out_mapping, SectionType::TextureData);
+
+			imported.num_textures = header->num_textures;
+			imported.textures = Memory::PushType<Mini::TextureImport>(scene_memory, header->num_textures, Memory::ZeroPush());
+			for (u32 i = 0; i < header->num_textures; ++i)
+			{
+				TextureRecord const& record = records[i];
+				Mini::TextureImport& texture = imported.textures[i];
+				texture.format = (Gfx::TextureFormat::Enum)record.format;
+				texture.surface.width = record.width;
+				texture.surface.height = record.height;
+				texture.b_srgb = record.b_srgb != 0;
+				texture.num_levels = record.num_levels;
+
+				u8* data = record.data_size > 0 ? texture_data + record.data_offset : nullptr;
+				if (texture.format == Gfx::TextureFormat::RGBA8)
+				{
+					texture.surface.pixels = data;
+				}
+				else
+				{
+					texture.compressed_data = data;
+					texture.compressed_size = record.data_size;
+				}
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
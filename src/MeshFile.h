@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Core.h"
+#include "IO.h"
+#include "Memory.h"
+#include "MeshImport.h"
+
+// ====================================
+//  Baked Mesh Files (.mmesh)
+//  Notes:
+//  *) A cooked MeshImport. Streams are stored in engine layout and
+//     handedness, loading maps the file and points into it, there is
+//     no parsing or copying of vertex data.
+//  *) Header, followed by page aligned sections, one per stream.
+//     The header holds the section table.
+//  *) Sections are memory images of engine types, so files are tied
+//     to the version below and not portable across architectures.
+//  *) Textures are stored as they were imported, block compressed
+//     or RGBA8, back to back in one data section that the texture
+//     records point into.
+// ====================================
+
+namespace MeshFile
+{
+	static constexpr u32 MAGIC = 0x48534D4D; // "MMSH"
+	static constexpr u32 VERSION = 10;
+	static constexpr u64 SECTION_ALIGNMENT = 4096;
+
+	struct SectionType
+	{
+		enum Enum : u32
+		{
+			Indices,
+			Positions,
+			Normals,
+			TexCoords,
+			Tangents,
+			CompressedPositions,
+			CompressedNormals,
+			CompressedTexCoords,
+			CompressedTangents,
+			Interleaved,
+			SubMeshes,
+			Instances,
+			NodeLocals,
+			NodeParents,
+			Meshlets,
+			MeshletVertices,
+			MeshletTriangles,
+			Materials,
+			SubMeshMaterials,
+			Textures,
+			TextureData,
+			Joints,
+			Weights,
+			Skins,
+			SkinJoints,
+			InverseBindMatrices,
+			AnimationClips,
+			AnimationTracks,
+			AnimationKeyTimes,
+			AnimationKeys,
+			MorphSets,
+			MorphTargets,
+			MorphChunkOffsets,
+			MorphChunks,
+			InstanceBatches,
+			BatchNodes,
+			BatchTransforms,
+
+			EnumCount
+		};
+	};
+
+	// Sections that are not part of the mesh have a size of 0.
+	struct Section
+	{
+		u64 offset;
+		u64 size;
+	};
+
+	struct TextureRecord
+	{
+		u32 format; // Gfx::TextureFormat
+		u32 width;
+		u32 height;
+		u32 b_srgb;
+		u32 num_levels;
+		u32 unused;
+
+		// Into the texture data section, a size of 0 for textures that failed to import. Holds all
+		// levels, largest first.
+		u64 data_offset;
+		u64 data_size;
+	};
+
+	struct Header
+	{
+		u32 magic;
+		u32 version;
+
+		u32 import_flags;
+		u32 num_vertices;
+		u32 num_indices;
+		u32 num_submeshes;
+		u32 num_instances;
+		u32 num_nodes;
+		u32 num_meshlets;
+		u32 num_meshlet_vertices;
+		u32 num_meshlet_triangles;
+		u32 num_materials;
+		u32 num_textures;
+		u64 texture_data_size;
+		u32 num_skins;
+		u32 num_skin_joints;
+		u32 num_animation_clips;
+		u32 num_animation_tracks;
+		u32 num_animation_keys;
+		u32 num_morph_sets;
+		u32 num_morph_targets;
+		u32 num_morph_chunks;
+		u32 num_instance_batches;
+		u32 num_batch_instances;
+
+		u32 interleaved_stride;
+		u32 interleaved_offsets[Gfx::VertexAttribType::EnumCount];
+
+		AABB bounds;
+		Sphere bounding_sphere;
+
+		Section sections[SectionType::EnumCount];
+	};
+
+	// The file image is assembled in scratch_memory, and released again before returning.
+	bool Write(char const* path, Mini::MeshImport const* imported, Memory::Arena* scratch_memory);
+
+	// Streams and submeshes of out_imported point into out_mapping, and stay valid until it is unmapped.
+	// The node hierarchy, instances and instance batches are rebuilt in scene_memory, since those are updated at runtime.
+	// The texture array is built there as well, its data points into the mapping. Pass null to skip them.
+	// Skins and animation clips are only loaded along with the nodes, but point into the mapping since they never change.
+	// Morph targets belong to the vertices and are always loaded.
+	bool Load(char const* path, Mini::MeshImport* out_imported, IO::MappedFile* out_mapping, Memory::Arena* scene_memory);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "MeshFile.h"
+
+#include <stdio.h>
+
+namespace MeshFile
+{
+namespace Test
+{
+	static char const* const TEST_PATH = "mesh_file_test.mmesh";
+
+	// A quad split into two submeshes, drawn by two instances of a two node hierarchy.
+	struct TestMesh
+	{
+		u16 indices[6] = { 0, 1, 2, 0, 2, 3 };
+		vec3 positions[4] = { vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f) };
+		Gfx::SubMesh submeshes[2];
+		Gfx::MeshInstance instances[2];
+		u32 submesh_materials[2] = { Mini::MATERIAL_NONE, Mini::MATERIAL_NONE };
+	};
+
+	static void BuildTestMesh(TestMesh* mesh, Mini::MeshImport* imported, Memory::Arena* arena)
+	{
+		MemZeroSafe(imported);
+		imported->index_buffer = mesh->indices;
+		imported->num_indices = 6;
+		imported->position_buffer = mesh->positions;
+		imported->num_vertices = 4;
+
+		mesh->submeshes[0].num_indices = 3;
+		mesh->submeshes[1].num_indices = 3;
+		mesh->submeshes[1].first_index_location = 3;
+		imported->submeshes = mesh->submeshes;
+		imported->num_submeshes = 2;
+		imported->submesh_materials = mesh->submesh_materials;
+
+		u32 const parents[2] = { Scene::INVALID_NODE, 0 };
+		Scene::Transform const locals[2] = { Scene::IdentityTransform(), Scene::IdentityTransform() };
+		Scene::BuildHierarchy(&imported->hierarchy, arena, parents, locals, 2, nullptr);
+
+		mesh->instances[0].num_submeshes = 1;
+		mesh->instances[1].node = 1;
+		mesh->instances[1].first_submesh = 1;
+		mesh->instances[1].num_submeshes = 1;
+		imported->instances = mesh->instances;
+		imported->num_instances = 2;
+	}
+
+	// Overwrites a u32 in a section of the test file, and reports whether it still loads.
+	static bool LoadsWithPatch(SectionType::Enum section, u64 offset_in_section, u32 value, Memory::Arena* arena)
+	{
+		IO::MappedFile original;
+		VERIFY(IO::MapFile(TEST_PATH, &original));
+
+		u64 const size = original.size;
+		u8* patched = (u8*)Memory::PushSize(arena, size);
+		memcpy(patched, original.data, size);
+		IO::UnmapFile(&original);
+
+		Header const* header = reinterpret_cast<Header const*>(patched);
+		memcpy(patched + header->sections[section].offset + offset_in_section, &value, sizeof(u32));
+
+		char patched_path[64];
+		snprintf(patched_path, sizeof(patched_path), "%s.patched", TEST_PATH);
+		VERIFY(IO::SaveFile(patched_path, patched, size));
+		ON_SCOPE_EXIT(remove(patched_path));
+
+		Mini::MeshImport loaded;
+		IO::MappedFile mapping;
+		if (!Load(patched_path, &loaded, &mapping, arena))
+		{
+			return false;
+		}
+		IO::UnmapFile(&mapping);
+		return true;
+	}
+
+	// Everything the draw and hierarchy code indexes without checks has to be rejected on load.
+	void RejectsOutOfRangeIndices()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestMesh mesh;
+		Mini::MeshImport imported;
+		BuildTestMesh(&mesh, &imported, &arena);
+		VERIFY(Write(TEST_PATH, &imported, &arena));
+		ON_SCOPE_EXIT(remove(TEST_PATH));
+
+		Mini::MeshImport loaded;
+		IO::MappedFile mapping;
+		VERIFY(Load(TEST_PATH, &loaded, &mapping, &arena));
+		ASSERT(loaded.num_submeshes == 2 && loaded.num_instances == 2 && loaded.hierarchy.num_nodes == 2);
+		ASSERT(loaded.instances[1].node == 1 && loaded.submeshes[1].first_index_location == 3);
+		IO::UnmapFile(&mapping);
+
+		// Unchanged values still load.
+		ASSERT(LoadsWithPatch(SectionType::Instances, offsetof(Gfx::MeshInstance, node), 0, &arena));
+
+		ASSERT(!LoadsWithPatch(SectionType::Instances, offsetof(Gfx::MeshInstance, node), 2, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::Instances, offsetof(Gfx::MeshInstance, first_submesh), 3, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::Instances, sizeof(Gfx::MeshInstance) + offsetof(Gfx::MeshInstance, num_submeshes), 2, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::Instances, offsetof(Gfx::MeshInstance, num_submeshes), ~0u, &arena));
+
+		// A node that is its own parent would be a cycle.
+		ASSERT(!LoadsWithPatch(SectionType::NodeParents, sizeof(u32), 1, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::NodeParents, 0, 5, &arena));
+
+		ASSERT(!LoadsWithPatch(SectionType::SubMeshes, offsetof(Gfx::SubMesh, first_index_location), 4, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::SubMeshes, offsetof(Gfx::SubMesh, num_indices), ~0u, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::SubMeshes, offsetof(Gfx::SubMesh, base_vertex_location), 2, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::SubMeshes, offsetof(Gfx::SubMesh, num_meshlets), 1, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::SubMeshes, offsetof(Gfx::SubMesh, num_lods), Gfx::MAX_SUBMESH_LODS + 1, &arena));
+
+		// Index 3 is the last vertex, 4 is past it.
+		ASSERT(LoadsWithPatch(SectionType::Indices, 0, 3, &arena));
+		ASSERT(!LoadsWithPatch(SectionType::Indices, 0, 4, &arena));
+	}
+
+	void Run()
+	{
+		RejectsOutOfRangeIndices();
+	}
+}
+}
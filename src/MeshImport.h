@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Core.h"
+#include "Animation.h"
+#include "GfxTypes.h"
+#include "ImageDecode.h"
+#include "Math.h"
+#include "Morph.h"
+#include "SceneGraph.h"
+
+// ====================================
+//  Imported Meshes
+//  Notes:
+//  *) Output of the glTF importer (GLTFImport.h) and the baked
+//     mesh file loader (MeshFile.h), input to the GPU upload.
+// ====================================
+
+namespace Mini
+{
+	struct ImportFlags
+	{
+		enum Enum : u32
+		{
+			None = 0,
+
+			// Emit Gfx::Compressed*_t streams instead of full precision floats.
+			CompressVertexStreams = 1 << 0,
+
+			// Keep interleaved source vertex data as is, for an interleaved GPU layout.
+			// Ignored when compressing, when the attributes can't be used directly, or when normals or tangents are generated.
+			KeepInterleavedStreams = 1 << 1,
+
+			// Reorder triangles for the post-transform cache and overdraw, and vertices for fetch
+			// locality, per submesh. See MeshOptimize.h.
+			OptimizeVertexOrder = 1 << 2,
+
+			// Simplified index ranges per submesh, see Gfx::SubMesh::lods and MeshSimplify.h.
+			GenerateLods = 1 << 3,
+
+			// Clusters per submesh for CPU culling, see Gfx::Meshlet and Meshlets.h.
+			BuildMeshlets = 1 << 4,
+
+			// Merge vertices that are bitwise identical in every attribute, per primitive.
+			WeldVertices = 1 << 5,
+
+			// Smooth normals for primitives without normals, see TangentSpace.h.
+			GenerateNormals = 1 << 6,
+
+			// Tangents for primitives with texcoords but without tangents, see TangentSpace.h.
+			// Implies GenerateNormals, tangents need them.
+			GenerateTangents = 1 << 7,
+
+			// Block compress material textures, see BlockCompression.h and SceneImporter::texture_quality.
+			// The decoded pixels are held in scratch memory until then.
+			CompressTextures = 1 << 8,
+
+			// Full mip chains for material textures, see MipGeneration.h and SceneImporter::mip_filter.
+			// Base color of alpha tested materials keeps its alpha coverage on every level.
+			GenerateMips = 1 << 9,
+
+			// Nodes without skin or morph targets that reference the same mesh are drawn as one Gfx::InstanceBatch
+			// instead of a Gfx::MeshInstance each. Nodes with EXT_mesh_gpu_instancing are batched regardless.
+			InstanceMeshes = 1 << 10,
+		};
+	};
+
+	static constexpr u32 INTERLEAVED_ATTRIB_MISSING = ~0u;
+
+	static constexpr u32 TEXTURE_NONE = ~0u;
+	static constexpr u32 MATERIAL_NONE = ~0u;
+
+	// One per source image that a material references, decoded to RGBA8.
+	struct TextureImport
+	{
+		// Pixels are null if the image couldn't be read or decoded, and once the texture is compressed.
+		Image::Surface surface;
+
+		// RGBA8 for the surface, otherwise the format of compressed_data. BC5 is used for normal maps
+		// and holds x and y only, z has to be reconstructed.
+		Gfx::TextureFormat::Enum format;
+		u8* compressed_data;
+		u64 compressed_size;
+
+		// Levels follow each other in pixels or compressed_data, largest first. The surface is level 0.
+		u32 num_levels;
+
+		// Referenced as color (base color, emissive), the texels are sRGB encoded.
+		bool b_srgb;
+
+		// Summed over all decode jobs of the image.
+		f32 decode_time_ms;
+		f32 mip_time_ms;
+		f32 compress_time_ms;
+	};
+
+	struct MaterialSlot
+	{
+		enum Enum : u32
+		{
+			BaseColor,
+			MetallicRoughness,
+			Normal,
+			Occlusion,
+			Emissive,
+
+			EnumCount
+		};
+	};
+
+	// Range of MeshImport::skin_joints.
+	struct SkinImport
+	{
+		u32 first_joint;
+		u32 num_joints;
+	};
+
+	// glTF metallic roughness material, factors multiply the texels.
+	struct MaterialImport
+	{
+		vec4 base_color_factor;
+		vec3 emissive_factor;
+		f32 metallic_factor;
+		f32 roughness_factor;
+
+		// Into MeshImport::textures, TEXTURE_NONE for unused slots and without texture memory.
+		u32 textures[MaterialSlot::EnumCount];
+	};
+
+	// Streams and submeshes of a mesh loaded from a MeshFile point into the read-only file mapping.
+	struct MeshImport
+	{
+		u16* index_buffer;
+		u32 num_indices;
+
+		u32 num_vertices;
+
+		// ImportFlags the streams were produced with.
+		u32 flags;
+		AABB bounds;
+		Sphere bounding_sphere;
+
+		// Only valid without ImportFlags::CompressVertexStreams.
+		vec3* position_buffer;
+		vec3* normal_buffer;
+		vec2* texcoord_buffer;
+		vec4* tangent_buffer;
+
+		// Only valid with ImportFlags::CompressVertexStreams.
+		Gfx::CompressedPosition_t* compressed_position_buffer;
+		Gfx::CompressedNormal_t* compressed_normal_buffer;
+		Gfx::CompressedTexCoord_t* compressed_texcoord_buffer;
+		Gfx::CompressedTangent_t* compressed_tangent_buffer;
+
+		// Only valid for meshes with skinned primitives, never compressed or interleaved. Vertices of
+		// primitives without a skin keep zero weights.
+		Gfx::Joints_t* joint_buffer;
+		Gfx::Weights_t* weight_buffer;
+
+		// Only valid for meshes with morph targets, in mesh memory. Deltas apply to the full precision streams,
+		// compressed or interleaved ones have to be unpacked first.
+		Morph::TargetLibrary morph_targets;
+
+		// Only valid with ImportFlags::KeepInterleavedStreams. Attributes that are not
+		// part of the vertex have an offset of INTERLEAVED_ATTRIB_MISSING.
+		u8* interleaved_buffer;
+		u32 interleaved_stride;
+		u32 interleaved_offsets[Gfx::VertexAttribType::EnumCount];
+
+		// One per imported primitive, ranges into the shared vertex and index streams.
+		Gfx::SubMesh* submeshes;
+		u32 num_submeshes;
+
+		// Only valid with ImportFlags::BuildMeshlets, see Gfx::Mesh::meshlets.
+		Gfx::Meshlet* meshlets;
+		u32 num_meshlets;
+		Gfx::Index_t* meshlet_vertices;
+		u32 num_meshlet_vertices;
+		u8* meshlet_triangles;
+		u32 num_meshlet_triangles;
+
+		// Materials live in mesh memory, submesh_materials has one entry per submesh
+		// (MATERIAL_NONE for the default material).
+		MaterialImport* materials;
+		u32 num_materials;
+		u32* submesh_materials;
+
+		// Only valid when imported with texture memory, the pixels or compressed data live in there as well.
+		// Mesh files build the array in scene memory, see MeshFile::Load().
+		TextureImport* textures;
+		u32 num_textures;
+
+		// Only valid when imported with scene memory, both live in there.
+		// There is one instance per node that references a mesh and isn't part of a batch.
+		Scene::Hierarchy hierarchy;
+		Gfx::MeshInstance* instances;
+		u32 num_instances;
+
+		// Only valid when imported with scene memory, and live in there as well. One batch per mesh that is
+		// instanced, see ImportFlags::InstanceMeshes. Each batch instance is drawn with the world transform of
+		// its node times its own transform, which is the identity for plain nodes.
+		Gfx::InstanceBatch* instance_batches;
+		u32 num_instance_batches;
+		u32* batch_instance_nodes;
+		mat34* batch_instance_transforms;
+		u32 num_batch_instances;
+
+		// Only valid when imported with scene memory, and live in there as well. Skins are referenced by
+		// Gfx::MeshInstance::skin. Joints are hierarchy nodes, their inverse bind matrices are in engine space.
+		SkinImport* skins;
+		u32 num_skins;
+		u32* skin_joints;
+		mat34* inverse_bind_matrices;
+		u32 num_skin_joints;
+
+		// Only valid when imported with scene memory, and live in there as well. Tracks target hierarchy nodes.
+		Animation::ClipLibrary animations;
+	};
+
+	namespace Test
+	{
+		// The glTF importer tests, see GLTFImportTests.cpp. Declared here, GLTFImport.h can only be included once.
+		void Run();
+	}
+}
@@ -0,0 +1,626 @@
+#include "MeshOptimize.h"
+
+namespace MeshOpt
+{
+	static constexpr u32 INVALID_VERTEX = ~0u;
+
+	// FIFO cache as timestamps: a vertex is cached while fewer than cache_size
+	// vertices were transformed after it. Advancing the timestamp by more than
+	// cache_size flushes the whole cache.
+	struct CacheSim
+	{
+		u32* vertex_times;
+		u32 timestamp;
+		u32 cache_size;
+	};
+
+	static void InitCacheSim(CacheSim* sim, u32 num_vertices, u32 cache_size, Memory::Arena* scratch_memory)
+	{
+		sim->vertex_times = Memory::PushType<u32>(scratch_memory, num_vertices, Memory::ZeroPush());
+		sim->timestamp = cache_size + 1;
+		sim->cache_size = cache_size;
+	}
+
+	static void FlushCacheSim(CacheSim* sim)
+	{
+		sim->timestamp += sim->cache_size + 1;
+	}
+
+	static u32 SimulateTriangle(CacheSim* sim, Gfx::Index_t const* triangle)
+	{
+		u32 misses = 0;
+		for (u32 i = 0; i < 3; ++i)
+		{
+			u32 const vertex = triangle[i];
+			if (sim->timestamp - sim->vertex_times[vertex] > sim->cache_size)
+			{
+				sim->vertex_times[vertex] = sim->timestamp++;
+				misses++;
+			}
+		}
+
+		return misses;
+	}
+
+	VertexCacheStats AnalyzeVertexCache(Gfx::Index_t const* indices, u64 num_indices, u32 num_vertices,
+		u32 cache_size, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		CacheSim sim;
+		InitCacheSim(&sim, num_vertices, cache_size, scratch_memory);
+
+		VertexCacheStats stats;
+		MemZeroSafe(stats);
+
+		for (u64 i = 0; i < num_indices; i += 3)
+		{
+			stats.vertices_transformed += SimulateTriangle(&sim, indices + i);
+		}
+
+		u64 const num_triangles = num_indices / 3;
+		stats.acmr = num_triangles ? (f32)stats.vertices_transformed / (f32)num_triangles : 0.0f;
+		stats.atvr = num_vertices ? (f32)stats.vertices_transformed / (f32)num_vertices : 0.0f;
+		return stats;
+	}
+
+	void BuildTriangleAdjacency(TriangleAdjacency* adjacency, Gfx::Index_t const* indices, u64 num_indices, u32 num_vertices,
+		Memory::Arena* scratch_memory)
+	{
+		adjacency->counts = Memory::PushType<u32>(scratch_memory, num_vertices, Memory::ZeroPush());
+		adjacency->offsets = Memory::PushType<u32>(scratch_memory, num_vertices);
+		adjacency->triangles = Memory::PushType<u32>(scratch_memory, (u32)num_indices);
+		adjacency->max_valence = 0;
+
+		for (u64 i = 0; i < num_indices; ++i)
+		{
+			ASSERT(indices[i] < num_vertices);
+			adjacency->counts[indices[i]]++;
+		}
+
+		u32 offset = 0;
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			adjacency->offsets[vertex] = offset;
+			offset += adjacency->counts[vertex];
+			adjacency->max_valence = max(adjacency->max_valence, adjacency->counts[vertex]);
+		}
+
+		// Use the offsets as write cursors, then move them back to the range starts.
+		for (u64 i = 0; i < num_indices; ++i)
+		{
+			adjacency->triangles[adjacency->offsets[indices[i]]++] = (u32)(i / 3);
+		}
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			adjacency->offsets[vertex] -= adjacency->counts[vertex];
+		}
+	}
+
+	struct TipsifyState
+	{
+		u32* live_triangles; // Not yet emitted triangles per vertex.
+		u32* cache_times;
+		u32 timestamp;
+		u32 cache_size;
+
+		u32* dead_ends;
+		u32 num_dead_ends;
+
+		u32* candidates; // 1-ring of the vertex that was fanned last.
+		u32 num_candidates;
+
+		u32 cursor; // Next vertex to look at once the dead-end stack is empty.
+	};
+
+	static u32 SkipDeadEnd(TipsifyState* state, u32 num_vertices)
+	{
+		while (state->num_dead_ends > 0)
+		{
+			u32 const vertex = state->dead_ends[--state->num_dead_ends];
+			if (state->live_triangles[vertex] > 0)
+			{
+				return vertex;
+			}
+		}
+
+		for (; state->cursor < num_vertices; ++state->cursor)
+		{
+			if (state->live_triangles[state->cursor] > 0)
+			{
+				return state->cursor;
+			}
+		}
+
+		return INVALID_VERTEX;
+	}
+
+	// Prefers the candidate that entered the cache earliest, as long as fanning it
+	// (which transforms up to 2 new vertices per live triangle) won't evict it.
+	static u32 GetNextVertex(TipsifyState* state, u32 num_vertices)
+	{
+		u32 best_vertex = INVALID_VERTEX;
+		s32 best_priority = -1;
+
+		for (u32 i = 0; i < state->num_candidates; ++i)
+		{
+			u32 const vertex = state->candidates[i];
+			if (state->live_triangles[vertex] == 0)
+			{
+				continue;
+			}
+
+			s32 priority = 0;
+			u32 const age = state->timestamp - state->cache_times[vertex];
+			if (age + 2 * state->live_triangles[vertex] <= state->cache_size)
+			{
+				priority = (s32)age;
+			}
+
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				best_vertex = vertex;
+			}
+		}
+
+		return (best_vertex != INVALID_VERTEX) ? best_vertex : SkipDeadEnd(state, num_vertices);
+	}
+
+	void OptimizeVertexCache(Gfx::Index_t* indices, u64 num_indices, u32 num_vertices,
+		u32 cache_size, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+		if (num_indices == 0)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 const num_triangles = (u32)(num_indices / 3);
+
+		TriangleAdjacency adjacency;
+		BuildTriangleAdjacency(&adjacency, indices, num_indices, num_vertices, scratch_memory);
+
+		TipsifyState state;
+		state.live_triangles = Memory::PushType<u32>(scratch_memory, num_vertices);
+		memcpy(state.live_triangles, adjacency.counts, sizeof(u32) * num_vertices);
+		state.cache_times = Memory::PushType<u32>(scratch_memory, num_vertices, Memory::ZeroPush());
+		state.timestamp = cache_size + 1;
+		state.cache_size = cache_size;
+		state.dead_ends = Memory::PushType<u32>(scratch_memory, (u32)num_indices);
+		state.num_dead_ends = 0;
+		state.candidates = Memory::PushType<u32>(scratch_memory, 3 * adjacency.max_valence);
+		state.num_candidates = 0;
+		state.cursor = 0;
+
+		u8* emitted = Memory::PushType<u8>(scratch_memory, num_triangles, Memory::ZeroPush());
+		Gfx::Index_t* output = Memory::PushType<Gfx::Index_t>(scratch_memory, (u32)num_indices);
+		u64 num_output = 0;
+
+		u32 fan_vertex = indices[0];
+		while (fan_vertex != INVALID_VERTEX)
+		{
+			state.num_candidates = 0;
+
+			u32 const adjacent_begin = adjacency.offsets[fan_vertex];
+			u32 const adjacent_end = adjacent_begin + adjacency.counts[fan_vertex];
+			for (u32 adjacent = adjacent_begin; adjacent < adjacent_end; ++adjacent)
+			{
+				u32 const triangle = adjacency.triangles[adjacent];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				emitted[triangle] = 1;
+
+				for (u32 corner = 0; corner < 3; ++corner)
+				{
+					Gfx::Index_t const vertex = indices[triangle * 3 + corner];
+
+					output[num_output++] = vertex;
+					state.dead_ends[state.num_dead_ends++] = vertex;
+					state.candidates[state.num_candidates++] = vertex;
+					state.live_triangles[vertex]--;
+
+					if (state.timestamp - state.cache_times[vertex] > cache_size)
+					{
+						state.cache_times[vertex] = state.timestamp++;
+					}
+				}
+			}
+
+			fan_vertex = GetNextVertex(&state, num_vertices);
+		}
+
+		ASSERT(num_output == num_indices);
+		memcpy(indices, output, sizeof(Gfx::Index_t) * num_indices);
+	}
+
+	u32 FloatToSortable(f32 value)
+	{
+		u32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+	}
+
+	void RadixSort(u32 const* keys, u32* out_order, u32 count, Memory::Arena* scratch_memory)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32* temp = Memory::PushType<u32>(scratch_memory, count);
+		for (u32 i = 0; i < count; ++i)
+		{
+			out_order[i] = i;
+		}
+
+		// 4 passes, so the result ends up back in out_order.
+		u32* src = out_order;
+		u32* dst = temp;
+		for (u32 shift = 0; shift < 32; shift += 8)
+		{
+			u32 histogram[256] = {};
+			for (u32 i = 0; i < count; ++i)
+			{
+				histogram[(keys[src[i]] >> shift) & 0xFF]++;
+			}
+
+			u32 sum = 0;
+			for (u32 bucket = 0; bucket < 256; ++bucket)
+			{
+				u32 const bucket_count = histogram[bucket];
+				histogram[bucket] = sum;
+				sum += bucket_count;
+			}
+
+			for (u32 i = 0; i < count; ++i)
+			{
+				dst[histogram[(keys[src[i]] >> shift) & 0xFF]++] = src[i];
+			}
+
+			u32* swap = src;
+			src = dst;
+			dst = swap;
+		}
+	}
+
+	void OptimizeOverdraw(Gfx::Index_t* indices, u64 num_indices, vec3 const* positions, u32 num_vertices,
+		u32 cache_size, f32 threshold, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+
+		u32 const num_triangles = (u32)(num_indices / 3);
+		if (num_triangles < 2)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		CacheSim sim;
+		InitCacheSim(&sim, num_vertices, cache_size, scratch_memory);
+
+		// Hard boundaries: a triangle missing all three vertices is where Tipsify had to
+		// restart, moving clusters around at those points costs nothing.
+		u32* hard_starts = Memory::PushType<u32>(scratch_memory, num_triangles + 1);
+		u32 num_hard = 0;
+		for (u32 triangle = 0; triangle < num_triangles; ++triangle)
+		{
+			if (SimulateTriangle(&sim, indices + triangle * 3) == 3 || triangle == 0)
+			{
+				hard_starts[num_hard++] = triangle;
+			}
+		}
+		hard_starts[num_hard] = num_triangles;
+
+		// Soft boundaries: split hard clusters further, wherever the piece so far (starting
+		// with a cold cache) is within threshold of the ACMR of the whole cluster.
+		u32* cluster_starts = Memory::PushType<u32>(scratch_memory, num_triangles + 1);
+		u32 num_clusters = 0;
+		for (u32 hard = 0; hard < num_hard; ++hard)
+		{
+			u32 const begin = hard_starts[hard];
+			u32 const end = hard_starts[hard + 1];
+
+			FlushCacheSim(&sim);
+			u32 cluster_misses = 0;
+			for (u32 triangle = begin; triangle < end; ++triangle)
+			{
+				cluster_misses += SimulateTriangle(&sim, indices + triangle * 3);
+			}
+			f32 const cluster_acmr = (f32)cluster_misses / (f32)(end - begin);
+
+			FlushCacheSim(&sim);
+			cluster_starts[num_clusters++] = begin;
+
+			u32 piece_misses = 0;
+			u32 piece_begin = begin;
+			for (u32 triangle = begin; triangle < end; ++triangle)
+			{
+				piece_misses += SimulateTriangle(&sim, indices + triangle * 3);
+
+				u32 const piece_triangles = triangle + 1 - piece_begin;
+				if (triangle + 1 < end && (f32)piece_misses <= threshold * cluster_acmr * (f32)piece_triangles)
+				{
+					cluster_starts[num_clusters++] = triangle + 1;
+					piece_begin = triangle + 1;
+					piece_misses = 0;
+					FlushCacheSim(&sim);
+				}
+			}
+		}
+		cluster_starts[num_clusters] = num_triangles;
+
+		// Area weighted centroid and normal per cluster, and of the whole mesh.
+		vec3* cluster_centroids = Memory::PushType<vec3>(scratch_memory, num_clusters);
+		vec3* cluster_normals = Memory::PushType<vec3>(scratch_memory, num_clusters);
+		vec3 mesh_centroid = vec3(0.0f, 0.0f, 0.0f);
+		f32 mesh_area = 0.0f;
+
+		for (u32 cluster = 0; cluster < num_clusters; ++cluster)
+		{
+			vec3 centroid = vec3(0.0f, 0.0f, 0.0f);
+			vec3 normal = vec3(0.0f, 0.0f, 0.0f);
+			f32 cluster_area = 0.0f;
+
+			for (u32 triangle = cluster_starts[cluster]; triangle < cluster_starts[cluster + 1]; ++triangle)
+			{
+				vec3 const a = positions[indices[triangle * 3 + 0]];
+				vec3 const b = positions[indices[triangle * 3 + 1]];
+				vec3 const c = positions[indices[triangle * 3 + 2]];
+
+				vec3 const n = Math::Cross(vec3(b.x - a.x, b.y - a.y, b.z - a.z), vec3(c.x - a.x, c.y - a.y, c.z - a.z));
+				f32 const area = Math::Length(n);
+
+				centroid.x += (a.x + b.x + c.x) * area;
+				centroid.y += (a.y + b.y + c.y) * area;
+				centroid.z += (a.z + b.z + c.z) * area;
+				normal.x += n.x;
+				normal.y += n.y;
+				normal.z += n.z;
+				cluster_area += area;
+			}
+
+			mesh_centroid.x += centroid.x;
+			mesh_centroid.y += centroid.y;
+			mesh_centroid.z += centroid.z;
+			mesh_area += cluster_area;
+
+			f32 const inv_area = (cluster_area > 0.0f) ? 1.0f / (3.0f * cluster_area) : 0.0f;
+			cluster_centroids[cluster] = vec3(centroid.x * inv_area, centroid.y * inv_area, centroid.z * inv_area);
+			cluster_normals[cluster] = normal;
+		}
+
+		f32 const inv_mesh_area = (mesh_area > 0.0f) ? 1.0f / (3.0f * mesh_area) : 0.0f;
+		mesh_centroid = vec3(mesh_centroid.x * inv_mesh_area, mesh_centroid.y * inv_mesh_area, mesh_centroid.z * inv_mesh_area);
+
+		// Clusters far out along their normal are likely to occlude the rest, so they go first.
+		u32* sort_keys = Memory::PushType<u32>(scratch_memory, num_clusters);
+		for (u32 cluster = 0; cluster < num_clusters; ++cluster)
+		{
+			vec3 const n = cluster_normals[cluster];
+			f32 const length = Math::Length(n);
+			vec3 const offset = vec3(cluster_centroids[cluster].x - mesh_centroid.x,
+				cluster_centroids[cluster].y - mesh_centroid.y,
+				cluster_centroids[cluster].z - mesh_centroid.z);
+
+			f32 const key = (length > 0.0f) ? Math::Dot(offset, n) / length : 0.0f;
+			sort_keys[cluster] = ~FloatToSortable(key); // Descending.
+		}
+
+		u32* cluster_order = Memory::PushType<u32>(scratch_memory, num_clusters);
+		RadixSort(sort_keys, cluster_order, num_clusters, scratch_memory);
+
+		Gfx::Index_t* output = Memory::PushType<Gfx::Index_t>(scratch_memory, (u32)num_indices);
+		u64 num_output = 0;
+		for (u32 i = 0; i < num_clusters; ++i)
+		{
+			u32 const cluster = cluster_order[i];
+			u64 const first = (u64)cluster_starts[cluster] * 3;
+			u64 const count = (u64)(cluster_starts[cluster + 1] - cluster_starts[cluster]) * 3;
+
+			memcpy(output + num_output, indices + first, sizeof(Gfx::Index_t) * count);
+			num_output += count;
+		}
+
+		ASSERT(num_output == num_indices);
+		memcpy(indices, output, sizeof(Gfx::Index_t) * num_indices);
+	}
+
+	u32 OptimizeVertexFetch(u32* out_remap, Gfx::Index_t* indices, u64 num_indices, u32 num_vertices)
+	{
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			out_remap[vertex] = INVALID_VERTEX;
+		}
+
+		u32 next_vertex = 0;
+		for (u64 i = 0; i < num_indices; ++i)
+		{
+			u32 const vertex = indices[i];
+			if (out_remap[vertex] == INVALID_VERTEX)
+			{
+				out_remap[vertex] = next_vertex++;
+			}
+
+			indices[i] = (Gfx::Index_t)out_remap[vertex];
+		}
+
+		u32 const num_referenced = next_vertex;
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			if (out_remap[vertex] == INVALID_VERTEX)
+			{
+				out_remap[vertex] = next_vertex++;
+			}
+		}
+
+		return num_referenced;
+	}
+
+	void RemapVertexStream(void* vertices, u32 num_vertices, u32 stride, u32 const* remap, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u64 const size = (u64)num_vertices * stride;
+		u8* source = (u8*)Memory::PushSize(scratch_memory, size);
+		memcpy(source, vertices, size);
+
+		u8* dst = static_cast<u8*>(vertices);
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			memcpy(dst + (u64)remap[vertex] * stride, source + (u64)vertex * stride, stride);
+		}
+	}
+
+	// FNV-1a over the bytes of every stream.
+	static u32 HashVertex(VertexStream const* streams, u32 num_streams, u32 vertex)
+	{
+		u32 hash = 2166136261u;
+		for (u32 i = 0; i < num_streams; ++i)
+		{
+			u8 const* bytes = static_cast<u8 const*>(streams[i].data) + (u64)vertex * streams[i].stride;
+			for (u32 j = 0; j < streams[i].size; ++j)
+			{
+				hash = (hash ^ bytes[j]) * 16777619u;
+			}
+		}
+		return hash;
+	}
+
+	static bool AreVerticesEqual(VertexStream const* streams, u32 num_streams, u32 a, u32 b)
+	{
+		for (u32 i = 0; i < num_streams; ++i)
+		{
+			u8 const* data = static_cast<u8 const*>(streams[i].data);
+			if (memcmp(data + (u64)a * streams[i].stride, data + (u64)b * streams[i].stride, streams[i].size) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	u32 FindDuplicateVertices(u32* out_remap, VertexStream const* streams, u32 num_streams, u32 num_vertices,
+		Memory::Arena* scratch_memory)
+	{
+		if (num_vertices == 0)
+		{
+			return 0;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		// Open addressing, at most half full.
+		u32 table_size = 1;
+		while (table_size < num_vertices * 2)
+		{
+			table_size *= 2;
+		}
+
+		u32* table = Memory::PushType<u32>(scratch_memory, table_size);
+		memset(table, 0xFF, sizeof(u32) * table_size);
+
+		u32 num_unique = 0;
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			u32 slot = HashVertex(streams, num_streams, vertex) & (table_size - 1);
+			while (table[slot] != INVALID_VERTEX && !AreVerticesEqual(streams, num_streams, table[slot], vertex))
+			{
+				slot = (slot + 1) & (table_size - 1);
+			}
+
+			if (table[slot] == INVALID_VERTEX)
+			{
+				table[slot] = vertex;
+				num_unique++;
+			}
+			out_remap[vertex] = table[slot];
+		}
+
+		return num_unique;
+	}
+
+	u32 GetMaxIndexChunks(u32 num_indices, u32 max_vertices)
+	{
+		// A chunk is only closed when the next triangle doesn't fit, so it has more than
+		// max_vertices - 3 vertices, each of which takes at least one index.
+		return max(1u, (num_indices + max_vertices - 3) / (max_vertices - 2));
+	}
+
+	u32 SplitIndices(IndexChunk* out_chunks, u32* out_vertices, Gfx::Index_t* out_indices, u32 const* indices, u32 num_indices,
+		u32 num_vertices, u32 max_vertices, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+		ASSERT(max_vertices >= 3 && max_vertices <= Gfx::MAX_SUBMESH_VERTICES);
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		// Index of every source vertex in the current chunk.
+		u32* local_vertex = Memory::PushType<u32>(scratch_memory, num_vertices);
+		memset(local_vertex, 0xFF, sizeof(u32) * num_vertices);
+
+		u32 num_chunks = 0;
+		IndexChunk chunk;
+		MemZeroSafe(chunk);
+
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			u32 new_vertices = 0;
+			for (u32 j = 0; j < 3; ++j)
+			{
+				ASSERT(indices[i + j] < num_vertices);
+				new_vertices += local_vertex[indices[i + j]] == INVALID_VERTEX;
+			}
+
+			if (chunk.num_vertices + new_vertices > max_vertices)
+			{
+				for (u32 j = 0; j < chunk.num_vertices; ++j)
+				{
+					local_vertex[out_vertices[chunk.first_vertex + j]] = INVALID_VERTEX;
+				}
+
+				out_chunks[num_chunks++] = chunk;
+				chunk.first_index += chunk.num_indices;
+				chunk.first_vertex += chunk.num_vertices;
+				chunk.num_indices = 0;
+				chunk.num_vertices = 0;
+			}
+
+			for (u32 j = 0; j < 3; ++j)
+			{
+				u32 const vertex = indices[i + j];
+				if (local_vertex[vertex] == INVALID_VERTEX)
+				{
+					local_vertex[vertex] = chunk.num_vertices;
+					out_vertices[chunk.first_vertex + chunk.num_vertices++] = vertex;
+				}
+
+				out_indices[chunk.first_index + chunk.num_indices++] = (Gfx::Index_t)local_vertex[vertex];
+			}
+		}
+
+		if (chunk.num_indices > 0 || num_chunks == 0)
+		{
+			out_chunks[num_chunks++] = chunk;
+		}
+
+		ASSERT(num_chunks <= GetMaxIndexChunks(num_indices, max_vertices));
+		return num_chunks;
+	}
+}
\ No newline at end of file
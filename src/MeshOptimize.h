@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "Math.h"
+#include "Memory.h"
+
+// ====================================
+//  Mesh Optimization
+//  Notes:
+//  *) Index order is optimized for the post-transform vertex cache with
+//     Tipsify (Sander et al. 2007, Fast Triangle Reordering for Vertex
+//     Locality and Reduced Overdraw), which only needs a cache size.
+//  *) Overdraw is reduced by sorting clusters of the cache optimized
+//     order, so that triangles facing away from the mesh center (likely
+//     occluders) are drawn first. Clusters keep the cache locality.
+//  *) Vertices are then renumbered in first use order, so the vertex
+//     streams are read front to back.
+//  *) All functions work on a single submesh, indices relative to its
+//     base vertex.
+//  *) Welding and splitting work on source meshes before they become
+//     submeshes, with 32 bit indices: vertices that are bitwise equal in
+//     every attribute are merged, then meshes that address more vertices
+//     than 16 bit indices can are split into chunks that each do.
+// ====================================
+
+namespace MeshOpt
+{
+	// Typical post-transform cache size, FIFO.
+	static constexpr u32 DEFAULT_CACHE_SIZE = 16;
+
+	// How much worse than the cache optimized ACMR the overdraw clusters may get, 1.05 = 5%.
+	static constexpr f32 DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+	struct VertexCacheStats
+	{
+		u64 vertices_transformed;
+		f32 acmr; // Average cache miss ratio, transformed vertices per triangle. 3 worst case, 0.5 for large regular grids.
+		f32 atvr; // Average transformed to vertex ratio. 1 is optimal.
+	};
+
+	// Simulates a FIFO post-transform cache over the index buffer.
+	VertexCacheStats AnalyzeVertexCache(Gfx::Index_t const* indices, u64 num_indices, u32 num_vertices,
+		u32 cache_size, Memory::Arena* scratch_memory);
+
+	void OptimizeVertexCache(Gfx::Index_t* indices, u64 num_indices, u32 num_vertices,
+		u32 cache_size, Memory::Arena* scratch_memory);
+
+	// Expects indices that already went through OptimizeVertexCache.
+	void OptimizeOverdraw(Gfx::Index_t* indices, u64 num_indices, vec3 const* positions, u32 num_vertices,
+		u32 cache_size, f32 threshold, Memory::Arena* scratch_memory);
+
+	// Renumbers the vertices in order of first use and rewrites the indices. out_remap[old] receives
+	// the new index of every vertex, unreferenced vertices go last. Returns the number of referenced vertices.
+	u32 OptimizeVertexFetch(u32* out_remap, Gfx::Index_t* indices, u64 num_indices, u32 num_vertices);
+
+	// Moves every vertex of a stride bytes stream to the place given by remap.
+	void RemapVertexStream(void* vertices, u32 num_vertices, u32 stride, u32 const* remap, Memory::Arena* scratch_memory);
+
+	// One attribute of the vertices, size bytes per vertex, stride bytes apart.
+	struct VertexStream
+	{
+		void const* data;
+		u32 size;
+		u32 stride;
+	};
+
+	// out_remap[v] receives the first vertex that equals v in all streams, byte for byte.
+	// Returns the number of unique vertices.
+	u32 FindDuplicateVertices(u32* out_remap, VertexStream const* streams, u32 num_streams, u32 num_vertices,
+		Memory::Arena* scratch_memory);
+
+	// Range of a split index list, and of the vertices it uses.
+	struct IndexChunk
+	{
+		u32 first_index;
+		u32 num_indices;
+		u32 first_vertex;
+		u32 num_vertices;
+	};
+
+	// Upper bound of the chunks SplitIndices() emits.
+	u32 GetMaxIndexChunks(u32 num_indices, u32 max_vertices);
+
+	// Splits triangles into chunks of consecutive triangles that use at most max_vertices vertices.
+	// out_vertices receives the source vertex of every chunk vertex, in order of first use, and
+	// needs room for num_indices. out_indices receives the chunk relative indices. Returns the
+	// number of chunks.
+	u32 SplitIndices(IndexChunk* out_chunks, u32* out_vertices, Gfx::Index_t* out_indices, u32 const* indices, u32 num_indices,
+		u32 num_vertices, u32 max_vertices, Memory::Arena* scratch_memory);
+
+	// Triangles using each vertex, as ranges into one shared list.
+	struct TriangleAdjacency
+	{
+		u32* counts;
+		u32* offsets;
+		u32* triangles;
+		u32 max_valence;
+	};
+
+	void BuildTriangleAdjacency(TriangleAdjacency* adjacency, Gfx::Index_t const* indices, u64 num_indices, u32 num_vertices,
+		Memory::Arena* scratch_memory);
+
+	// Maps floats to u32s with the same ordering, as sort keys.
+	u32 FloatToSortable(f32 value);
+
+	// Stable radix sort, out_order receives the indices of keys in ascending order.
+	void RadixSort(u32 const* keys, u32* out_order, u32 count, Memory::Arena* scratch_memory);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,475 @@
+#include "MeshOptimize.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+
+namespace MeshOpt
+{
+namespace Test
+{
+	// A bumpy grid of quads x quads, with its vertices numbered and its triangles ordered at random.
+	struct TestGrid
+	{
+		Gfx::Index_t* indices;
+		vec3* positions;
+		u32 num_indices;
+		u32 num_vertices;
+	};
+
+	template <typename T>
+	static void Shuffle(T* values, u32 count, TestUtils::Random& random)
+	{
+		for (u32 i = count; i > 1; --i)
+		{
+			std::swap(values[i - 1], values[random.Index(i)]);
+		}
+	}
+
+	static void BuildShuffledGrid(TestGrid* grid, u32 quads, Memory::Arena* arena, TestUtils::Random& random)
+	{
+		grid->num_vertices = (quads + 1) * (quads + 1);
+		grid->num_indices = quads * quads * 6;
+		grid->indices = Memory::PushType<Gfx::Index_t>(arena, grid->num_indices);
+		grid->positions = Memory::PushType<vec3>(arena, grid->num_vertices);
+
+		u32* numbering = Memory::PushType<u32>(arena, grid->num_vertices);
+		for (u32 vertex = 0; vertex < grid->num_vertices; ++vertex)
+		{
+			numbering[vertex] = vertex;
+		}
+		Shuffle(numbering, grid->num_vertices, random);
+
+		for (u32 y = 0; y <= quads; ++y)
+		{
+			for (u32 x = 0; x <= quads; ++x)
+			{
+				grid->positions[numbering[y * (quads + 1) + x]] = vec3((f32)x, random.Float(-0.5f, 0.5f), (f32)y);
+			}
+		}
+
+		// Triangles are shuffled as a whole, three indices at a time.
+		u64* triangles = Memory::PushType<u64>(arena, quads * quads * 2);
+		u32 num_triangles = 0;
+		for (u32 y = 0; y < quads; ++y)
+		{
+			for (u32 x = 0; x < quads; ++x)
+			{
+				u64 const a = numbering[y * (quads + 1) + x];
+				u64 const b = numbering[(y + 1) * (quads + 1) + x];
+				u64 const c = numbering[y * (quads + 1) + x + 1];
+				u64 const d = numbering[(y + 1) * (quads + 1) + x + 1];
+				triangles[num_triangles++] = a | (b << 16) | (c << 32);
+				triangles[num_triangles++] = c | (b << 16) | (d << 32);
+			}
+		}
+		Shuffle(triangles, num_triangles, random);
+
+		for (u32 triangle = 0; triangle < num_triangles; ++triangle)
+		{
+			grid->indices[triangle * 3 + 0] = (Gfx::Index_t)(triangles[triangle] & 0xFFFF);
+			grid->indices[triangle * 3 + 1] = (Gfx::Index_t)((triangles[triangle] >> 16) & 0xFFFF);
+			grid->indices[triangle * 3 + 2] = (Gfx::Index_t)(triangles[triangle] >> 32);
+		}
+	}
+
+	// The triangles as sorted keys, each rotated to start at its smallest index, so the winding counts.
+	static u64* SortedTriangles(Gfx::Index_t const* indices, u32 num_indices, Memory::Arena* arena)
+	{
+		u64* keys = Memory::PushType<u64>(arena, num_indices / 3);
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			u32 first = 0;
+			for (u32 corner = 1; corner < 3; ++corner)
+			{
+				first = indices[i + corner] < indices[i + first] ? corner : first;
+			}
+
+			u64 const a = indices[i + first];
+			u64 const b = indices[i + (first + 1) % 3];
+			u64 const c = indices[i + (first + 2) % 3];
+			keys[i / 3] = (a << 32) | (b << 16) | c;
+		}
+		std::sort(keys, keys + num_indices / 3);
+		return keys;
+	}
+
+	static bool IsTrianglePermutation(Gfx::Index_t const* a, Gfx::Index_t const* b, u32 num_indices, Memory::Arena* arena)
+	{
+		u64 const* keys_a = SortedTriangles(a, num_indices, arena);
+		u64 const* keys_b = SortedTriangles(b, num_indices, arena);
+		return memcmp(keys_a, keys_b, sizeof(u64) * (num_indices / 3)) == 0;
+	}
+
+	// Cache and overdraw optimization only reorder the triangles. A shuffled grid starts out close to the
+	// worst case of 3 misses per triangle, Tipsify gets it to 0.63 (0.5 is a perfect order of a large grid).
+	void ReordersTrianglesForTheCache()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(16));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestUtils::Random random;
+		TestGrid grid;
+		BuildShuffledGrid(&grid, 96, &arena, random);
+
+		Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+		memcpy(indices, grid.indices, sizeof(Gfx::Index_t) * grid.num_indices);
+
+		VertexCacheStats const shuffled = AnalyzeVertexCache(indices, grid.num_indices, grid.num_vertices, DEFAULT_CACHE_SIZE, &arena);
+		OptimizeVertexCache(indices, grid.num_indices, grid.num_vertices, DEFAULT_CACHE_SIZE, &arena);
+		VertexCacheStats const optimized = AnalyzeVertexCache(indices, grid.num_indices, grid.num_vertices, DEFAULT_CACHE_SIZE, &arena);
+
+		ASSERT(IsTrianglePermutation(indices, grid.indices, grid.num_indices, &arena));
+		ASSERT(shuffled.acmr > 2.9f && shuffled.atvr > 5.5f);
+		ASSERT(optimized.acmr < 0.7f && optimized.atvr < 1.3f);
+
+		// Every cluster is within the threshold with a cold cache. Reordering them loses the reuse across
+		// cluster boundaries on top of that, which the threshold doesn't cover, so it's allowed twice.
+		OptimizeOverdraw(indices, grid.num_indices, grid.positions, grid.num_vertices, DEFAULT_CACHE_SIZE,
+			DEFAULT_OVERDRAW_THRESHOLD, &arena);
+		VertexCacheStats const sorted = AnalyzeVertexCache(indices, grid.num_indices, grid.num_vertices, DEFAULT_CACHE_SIZE, &arena);
+
+		ASSERT(IsTrianglePermutation(indices, grid.indices, grid.num_indices, &arena));
+		ASSERT(sorted.acmr <= optimized.acmr * (2.0f * DEFAULT_OVERDRAW_THRESHOLD - 1.0f));
+	}
+
+	// Vertices are renumbered in order of first use, the ones no triangle uses go last.
+	void RenumbersVerticesInFirstUseOrder()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestUtils::Random random;
+		TestGrid grid;
+		BuildShuffledGrid(&grid, 40, &arena, random);
+
+		// Drop the triangles of the first row, its vertices end up unreferenced all over the numbering.
+		u32 const num_vertices = grid.num_vertices;
+		Gfx::Index_t* source = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+		u32 num_indices = 0;
+		for (u32 i = 0; i < grid.num_indices; i += 3)
+		{
+			Gfx::Index_t const* triangle = grid.indices + i;
+			if (grid.positions[triangle[0]].z > 0.0f && grid.positions[triangle[1]].z > 0.0f && grid.positions[triangle[2]].z > 0.0f)
+			{
+				memcpy(source + num_indices, triangle, sizeof(Gfx::Index_t) * 3);
+				num_indices += 3;
+			}
+		}
+
+		Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(&arena, num_indices);
+		memcpy(indices, source, sizeof(Gfx::Index_t) * num_indices);
+
+		bool* b_referenced = Memory::PushType<bool>(&arena, num_vertices, Memory::ZeroPush());
+		u32 expected_referenced = 0;
+		for (u32 i = 0; i < num_indices; ++i)
+		{
+			expected_referenced += b_referenced[indices[i]] ? 0 : 1;
+			b_referenced[indices[i]] = true;
+		}
+		ASSERT(expected_referenced == num_vertices - 41);
+
+		u32* remap = Memory::PushType<u32>(&arena, num_vertices);
+		u32 const num_referenced = OptimizeVertexFetch(remap, indices, num_indices, num_vertices);
+		ASSERT(num_referenced == expected_referenced);
+
+		// Every index is one that was seen before, or the next new one.
+		u32 next_vertex = 0;
+		for (u32 i = 0; i < num_indices; ++i)
+		{
+			ASSERT(indices[i] <= next_vertex && indices[i] == remap[source[i]]);
+			next_vertex += indices[i] == next_vertex ? 1 : 0;
+		}
+		ASSERT(next_vertex == num_referenced);
+
+		// The remap is a permutation, with the unreferenced vertices after the referenced ones.
+		bool* b_used = Memory::PushType<bool>(&arena, num_vertices, Memory::ZeroPush());
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			ASSERT(remap[vertex] < num_vertices && !b_used[remap[vertex]]);
+			ASSERT(b_referenced[vertex] == (remap[vertex] < num_referenced));
+			b_used[remap[vertex]] = true;
+		}
+	}
+
+	// Hand counted FIFO cache misses.
+	void AnalyzesKnownIndexOrders()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		// A strip of 8 quads as a list: the first triangle misses 3 times, every one after that once.
+		static constexpr u32 QUADS = 8;
+		Gfx::Index_t strip[QUADS * 6];
+		for (u32 quad = 0; quad < QUADS; ++quad)
+		{
+			Gfx::Index_t const a = (Gfx::Index_t)(quad * 2);
+			Gfx::Index_t* triangles = strip + quad * 6;
+			triangles[0] = a; triangles[1] = a + 1; triangles[2] = a + 2;
+			triangles[3] = a + 2; triangles[4] = a + 1; triangles[5] = a + 3;
+		}
+
+		// Even with a cache of 3, the two vertices a strip triangle shares were used by the one before.
+		for (u32 cache_size : { 3u, DEFAULT_CACHE_SIZE })
+		{
+			VertexCacheStats const stats = AnalyzeVertexCache(strip, QUADS * 6, QUADS * 2 + 2, cache_size, &arena);
+			ASSERT(stats.vertices_transformed == QUADS * 2 + 2);
+			ASSERT(stats.acmr == (f32)(QUADS * 2 + 2) / (f32)(QUADS * 2) && stats.atvr == 1.0f);
+		}
+
+		// The first two quads twice: all hits the second time with a cache of 16. With a cache of 3, the
+		// repeat of triangle 0 follows triangle 3, which left 3 4 5 in the cache, and misses all over again.
+		Gfx::Index_t twice[24];
+		memcpy(twice, strip, sizeof(Gfx::Index_t) * 12);
+		memcpy(twice + 12, strip, sizeof(Gfx::Index_t) * 12);
+
+		VertexCacheStats const cached = AnalyzeVertexCache(twice, 24, 6, DEFAULT_CACHE_SIZE, &arena);
+		ASSERT(cached.vertices_transformed == 6 && cached.acmr == 0.75f && cached.atvr == 1.0f);
+
+		VertexCacheStats const thrashed = AnalyzeVertexCache(twice, 24, 6, 3, &arena);
+		ASSERT(thrashed.vertices_transformed == 12 && thrashed.acmr == 1.5f && thrashed.atvr == 2.0f);
+
+		// Triangles that share nothing, the worst case.
+		Gfx::Index_t disjoint[12];
+		for (u32 i = 0; i < 12; ++i)
+		{
+			disjoint[i] = (Gfx::Index_t)i;
+		}
+		VertexCacheStats const worst = AnalyzeVertexCache(disjoint, 12, 12, DEFAULT_CACHE_SIZE, &arena);
+		ASSERT(worst.vertices_transformed == 12 && worst.acmr == 3.0f && worst.atvr == 1.0f);
+	}
+
+	// Position and texcoord streams, interleaved like a glTF buffer view: exact copies of earlier vertices
+	// weld, copies that differ in a single bit of either stream don't, -0 and 0 included.
+	void WeldsBitwiseEqualVertices()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		struct Vertex
+		{
+			vec3 position;
+			vec2 texcoord;
+		};
+
+		static constexpr u32 NUM_VERTICES = 2000;
+		Vertex* vertices = Memory::PushType<Vertex>(&arena, NUM_VERTICES);
+		TestUtils::Random random;
+
+		for (u32 vertex = 0; vertex < NUM_VERTICES; ++vertex)
+		{
+			Vertex& v = vertices[vertex];
+			if (vertex < 16)
+			{
+				v.position = vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+				v.texcoord = vec2(random.Float(0.0f, 1.0f), random.Float(0.0f, 1.0f));
+				continue;
+			}
+
+			v = vertices[random.Index(vertex)];
+			switch (random.Index(4))
+			{
+			case 0:
+				break;
+			case 1:
+				v.position.y = nextafterf(v.position.y, 2.0f);
+				break;
+			case 2:
+				v.texcoord.x = nextafterf(v.texcoord.x, -1.0f);
+				break;
+			case 3:
+				v.position.z = v.position.z == 0.0f ? -v.position.z : 0.0f;
+				break;
+			}
+		}
+
+		VertexStream const streams[2] =
+		{
+			{ &vertices[0].position, sizeof(vec3), sizeof(Vertex) },
+			{ &vertices[0].texcoord, sizeof(vec2), sizeof(Vertex) },
+		};
+
+		u32* remap = Memory::PushType<u32>(&arena, NUM_VERTICES);
+		u32 const num_unique = FindDuplicateVertices(remap, streams, 2, NUM_VERTICES, &arena);
+
+		// Brute force: the first earlier vertex with the same bytes.
+		u32 expected_unique = 0;
+		for (u32 vertex = 0; vertex < NUM_VERTICES; ++vertex)
+		{
+			u32 first = vertex;
+			for (u32 other = 0; other < vertex && first == vertex; ++other)
+			{
+				first = memcmp(&vertices[other], &vertices[vertex], sizeof(Vertex)) == 0 ? other : vertex;
+			}
+			ASSERT(remap[vertex] == first);
+			expected_unique += first == vertex ? 1 : 0;
+		}
+		ASSERT(num_unique == expected_unique && num_unique > 16 && num_unique < NUM_VERTICES);
+
+		// Signed zeros compare equal as floats, never as bits.
+		vertices[1] = vertices[0];
+		vertices[0].position.x = 0.0f;
+		vertices[1].position.x = -0.0f;
+		FindDuplicateVertices(remap, streams, 2, 2, &arena);
+		ASSERT(remap[1] == 1);
+	}
+
+	struct SplitMesh
+	{
+		u32* indices;
+		vec3* positions;
+		u32 num_indices;
+		u32 num_vertices;
+	};
+
+	// Chunks cover the triangles in order. Copying every chunk's vertices after each other, the way the import
+	// lays out submeshes, its indices plus the chunk's base vertex address the source triangle's corners.
+	static void CheckSplit(SplitMesh const& mesh, u32 max_vertices, Memory::Arena* arena)
+	{
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(arena);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(arena, alloc, false));
+
+		u32 const max_chunks = GetMaxIndexChunks(mesh.num_indices, max_vertices);
+		IndexChunk* chunks = Memory::PushType<IndexChunk>(arena, max_chunks);
+		u32* chunk_vertices = Memory::PushType<u32>(arena, mesh.num_indices);
+		Gfx::Index_t* chunk_indices = Memory::PushType<Gfx::Index_t>(arena, mesh.num_indices);
+
+		u32 const num_chunks = SplitIndices(chunks, chunk_vertices, chunk_indices, mesh.indices, mesh.num_indices,
+			mesh.num_vertices, max_vertices, arena);
+		ASSERT(num_chunks > 0 && num_chunks <= max_chunks);
+
+		IndexChunk const& last = chunks[num_chunks - 1];
+		u32 const num_chunk_vertices = last.first_vertex + last.num_vertices;
+		vec3* stream = Memory::PushType<vec3>(arena, num_chunk_vertices);
+		for (u32 vertex = 0; vertex < num_chunk_vertices; ++vertex)
+		{
+			stream[vertex] = mesh.positions[chunk_vertices[vertex]];
+		}
+
+		u32* chunk_of_vertex = Memory::PushType<u32>(arena, mesh.num_vertices);
+		memset(chunk_of_vertex, 0xFF, sizeof(u32) * mesh.num_vertices);
+
+		u32 next_index = 0;
+		u32 next_vertex = 0;
+		for (u32 chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+		{
+			IndexChunk const& chunk = chunks[chunk_idx];
+			ASSERT(chunk.first_index == next_index && chunk.first_vertex == next_vertex);
+			ASSERT(chunk.num_indices % 3 == 0 && chunk.num_vertices <= max_vertices && max_vertices <= Gfx::MAX_SUBMESH_VERTICES);
+			next_index += chunk.num_indices;
+			next_vertex += chunk.num_vertices;
+
+			// The chunk before was only closed because this one's first triangle didn't fit.
+			if (chunk_idx > 0)
+			{
+				u32 new_vertices = 0;
+				for (u32 corner = 0; corner < 3; ++corner)
+				{
+					new_vertices += chunk_of_vertex[mesh.indices[chunk.first_index + corner]] != chunk_idx - 1 ? 1 : 0;
+				}
+				ASSERT(chunks[chunk_idx - 1].num_vertices + new_vertices > max_vertices);
+			}
+
+			// No vertex is in a chunk twice.
+			for (u32 i = 0; i < chunk.num_vertices; ++i)
+			{
+				u32 const vertex = chunk_vertices[chunk.first_vertex + i];
+				ASSERT(chunk_of_vertex[vertex] != chunk_idx);
+				chunk_of_vertex[vertex] = chunk_idx;
+			}
+
+			u32 const base_vertex_location = chunk.first_vertex;
+			for (u32 i = chunk.first_index; i < chunk.first_index + chunk.num_indices; ++i)
+			{
+				ASSERT(chunk_indices[i] < chunk.num_vertices);
+				ASSERT(chunk_vertices[base_vertex_location + chunk_indices[i]] == mesh.indices[i]);
+				ASSERT(memcmp(&stream[base_vertex_location + chunk_indices[i]], &mesh.positions[mesh.indices[i]], sizeof(vec3)) == 0);
+			}
+		}
+		ASSERT(next_index == mesh.num_indices);
+	}
+
+	// A grid too large for 16 bit indices at the real limit, the same grid shuffled at small limits, and
+	// triangles that share nothing, which close every chunk as early as possible.
+	void SplitsIndicesIntoChunks()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(48));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		static constexpr u32 QUADS = 300;
+		SplitMesh grid;
+		grid.num_vertices = (QUADS + 1) * (QUADS + 1);
+		grid.num_indices = QUADS * QUADS * 6;
+		grid.indices = Memory::PushType<u32>(&arena, grid.num_indices);
+		grid.positions = Memory::PushType<vec3>(&arena, grid.num_vertices);
+		ASSERT(grid.num_vertices > Gfx::MAX_SUBMESH_VERTICES);
+
+		for (u32 vertex = 0; vertex < grid.num_vertices; ++vertex)
+		{
+			grid.positions[vertex] = vec3((f32)(vertex % (QUADS + 1)), 0.0f, (f32)(vertex / (QUADS + 1)));
+		}
+
+		u32* index = grid.indices;
+		for (u32 y = 0; y < QUADS; ++y)
+		{
+			for (u32 x = 0; x < QUADS; ++x)
+			{
+				u32 const a = y * (QUADS + 1) + x;
+				u32 const b = (y + 1) * (QUADS + 1) + x;
+				*index++ = a; *index++ = b; *index++ = a + 1;
+				*index++ = a + 1; *index++ = b; *index++ = b + 1;
+			}
+		}
+
+		CheckSplit(grid, Gfx::MAX_SUBMESH_VERTICES, &arena);
+
+		// Random triangles of the grid, so chunks close on one, two or three new vertices.
+		TestUtils::Random random;
+		SplitMesh shuffled = grid;
+		shuffled.num_indices = 6000 * 3;
+		shuffled.indices = Memory::PushType<u32>(&arena, shuffled.num_indices);
+		for (u32 i = 0; i < shuffled.num_indices; i += 3)
+		{
+			memcpy(shuffled.indices + i, grid.indices + random.Index(grid.num_indices / 3) * 3, sizeof(u32) * 3);
+		}
+
+		for (u32 max_vertices : { 3u, 16u, 64u, 1000u })
+		{
+			CheckSplit(shuffled, max_vertices, &arena);
+		}
+
+		SplitMesh disjoint = grid;
+		disjoint.num_indices = 3000;
+		disjoint.num_vertices = 3000;
+		disjoint.indices = Memory::PushType<u32>(&arena, disjoint.num_indices);
+		for (u32 i = 0; i < disjoint.num_indices; ++i)
+		{
+			disjoint.indices[i] = i;
+		}
+
+		for (u32 max_vertices : { 3u, 4u, 5u, 16u, 100u, 3000u })
+		{
+			CheckSplit(disjoint, max_vertices, &arena);
+		}
+
+		// Vertices without triangles still make one empty chunk.
+		IndexChunk chunk;
+		ASSERT(GetMaxIndexChunks(0, Gfx::MAX_SUBMESH_VERTICES) == 1);
+		ASSERT(SplitIndices(&chunk, nullptr, nullptr, nullptr, 0, 4, Gfx::MAX_SUBMESH_VERTICES, &arena) == 1);
+		ASSERT(chunk.num_indices == 0 && chunk.num_vertices == 0);
+	}
+
+	void Run()
+	{
+		ReordersTrianglesForTheCache();
+		RenumbersVerticesInFirstUseOrder();
+		AnalyzesKnownIndexOrders();
+		WeldsBitwiseEqualVertices();
+		SplitsIndicesIntoChunks();
+	}
+}
+}
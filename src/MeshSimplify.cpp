@@ -0,0 +1,892 @@
+#include "MeshSimplify.h"
+#include "MeshOptimize.h"
+#include <float.h>
+
+namespace MeshOpt
+{
+	static constexpr u32 INVALID_VERTEX = ~0u;
+
+	// Quadrics work on position, normal and texcoord.
+	static constexpr u32 QUADRIC_DIM = 8;
+	static constexpr u32 QUADRIC_MATRIX_SIZE = QUADRIC_DIM * (QUADRIC_DIM + 1) / 2;
+
+	// Attribute scales, relative to positions normalized to the unit cube.
+	static constexpr f32 NORMAL_WEIGHT = 0.5f;
+	static constexpr f32 TEXCOORD_WEIGHT = 1.0f;
+
+	// Border planes are weighted up, so holes and silhouettes keep their shape.
+	static constexpr f32 BORDER_WEIGHT = 10.0f;
+
+	struct VertexKind
+	{
+		enum Enum : u8
+		{
+			Manifold, // Collapses onto any neighbor.
+			Border,   // Collapses along the border only.
+			Locked,   // Never moves.
+		};
+	};
+
+	struct QuadricPoint
+	{
+		f32 v[QUADRIC_DIM];
+	};
+
+	// Area weighted sum of squared distances to a set of planes, in QUADRIC_DIM dimensions.
+	struct Quadric
+	{
+		f32 a[QUADRIC_MATRIX_SIZE]; // Upper triangle of the symmetric matrix, row by row.
+		f32 b[QUADRIC_DIM];
+		f32 c;
+		f32 weight;
+	};
+
+	static void AddQuadric(Quadric* dst, Quadric const* src, f32 scale)
+	{
+		for (u32 i = 0; i < QUADRIC_MATRIX_SIZE; ++i)
+		{
+			dst->a[i] += src->a[i] * scale;
+		}
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			dst->b[i] += src->b[i] * scale;
+		}
+		dst->c += src->c * scale;
+		dst->weight += src->weight * scale;
+	}
+
+	static f32 EvaluateQuadric(Quadric const* q, QuadricPoint const* p)
+	{
+		f32 error = q->c;
+		u32 k = 0;
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			f32 const pi = p->v[i];
+			error += 2.0f * q->b[i] * pi + q->a[k++] * pi * pi;
+			for (u32 j = i + 1; j < QUADRIC_DIM; ++j)
+			{
+				error += 2.0f * q->a[k++] * pi * p->v[j];
+			}
+		}
+
+		return error;
+	}
+
+	static f32 Dot(QuadricPoint const& a, QuadricPoint const& b)
+	{
+		f32 result = 0.0f;
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			result += a.v[i] * b.v[i];
+		}
+		return result;
+	}
+
+	// Squared distance to the plane of the triangle, in all dimensions. Garland & Heckbert 1998, section 3.
+	static bool MakeTriangleQuadric(Quadric* q, QuadricPoint const& p0, QuadricPoint const& p1, QuadricPoint const& p2, f32 weight)
+	{
+		QuadricPoint e1;
+		QuadricPoint e2;
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			e1.v[i] = p1.v[i] - p0.v[i];
+			e2.v[i] = p2.v[i] - p0.v[i];
+		}
+
+		f32 const length1 = sqrtf(Dot(e1, e1));
+		if (length1 < 1e-12f)
+		{
+			return false;
+		}
+		for (f32& value : e1.v)
+		{
+			value /= length1;
+		}
+
+		f32 const projection = Dot(e1, e2);
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			e2.v[i] -= projection * e1.v[i];
+		}
+
+		f32 const length2 = sqrtf(Dot(e2, e2));
+		if (length2 < 1e-12f)
+		{
+			return false;
+		}
+		for (f32& value : e2.v)
+		{
+			value /= length2;
+		}
+
+		f32 const d1 = Dot(p0, e1);
+		f32 const d2 = Dot(p0, e2);
+
+		u32 k = 0;
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			for (u32 j = i; j < QUADRIC_DIM; ++j)
+			{
+				f32 const identity = (i == j) ? 1.0f : 0.0f;
+				q->a[k++] = weight * (identity - e1.v[i] * e1.v[j] - e2.v[i] * e2.v[j]);
+			}
+			q->b[i] = weight * (d1 * e1.v[i] + d2 * e2.v[i] - p0.v[i]);
+		}
+		q->c = weight * (Dot(p0, p0) - d1 * d1 - d2 * d2);
+		q->weight = weight;
+		return true;
+	}
+
+	// Squared distance to a plane in position space, the attributes are unconstrained.
+	static void AddPlaneQuadric(Quadric* q, vec3 const& normal, f32 distance, f32 weight)
+	{
+		f32 const n[3] = { normal.x, normal.y, normal.z };
+
+		u32 k = 0;
+		for (u32 i = 0; i < QUADRIC_DIM; ++i)
+		{
+			for (u32 j = i; j < QUADRIC_DIM; ++j, ++k)
+			{
+				if (i < 3 && j < 3)
+				{
+					q->a[k] += weight * n[i] * n[j];
+				}
+			}
+			if (i < 3)
+			{
+				q->b[i] += weight * distance * n[i];
+			}
+		}
+		q->c += weight * distance * distance;
+	}
+
+	static vec3 GetPosition(QuadricPoint const& p)
+	{
+		return vec3(p.v[0], p.v[1], p.v[2]);
+	}
+
+	static u32 GetHashTableSize(u32 count)
+	{
+		u32 size = 16;
+		while (size < count * 2)
+		{
+			size *= 2;
+		}
+		return size;
+	}
+
+	static u32 HashPosition(vec3 const& position)
+	{
+		u32 bits[3];
+		memcpy(bits, &position, sizeof(bits));
+		return (bits[0] * 73856093) ^ (bits[1] * 19349663) ^ (bits[2] * 83492791);
+	}
+
+	// out_canonical[v] receives the first vertex with the same position as v.
+	static void BuildPositionRemap(u32* out_canonical, vec3 const* positions, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 const table_size = GetHashTableSize(num_vertices);
+		u32* table = Memory::PushType<u32>(scratch_memory, table_size);
+		memset(table, 0xFF, sizeof(u32) * table_size);
+
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			u32 slot = HashPosition(positions[vertex]) & (table_size - 1);
+			while (table[slot] != INVALID_VERTEX && memcmp(&positions[table[slot]], &positions[vertex], sizeof(vec3)) != 0)
+			{
+				slot = (slot + 1) & (table_size - 1);
+			}
+
+			if (table[slot] == INVALID_VERTEX)
+			{
+				table[slot] = vertex;
+			}
+			out_canonical[vertex] = table[slot];
+		}
+	}
+
+	// Directed edges between canonical vertices.
+	struct EdgeSet
+	{
+		u64* keys;
+		u32 mask;
+	};
+
+	static constexpr u64 EMPTY_EDGE = ~0ull;
+
+	static u64 MakeEdgeKey(u32 from, u32 to)
+	{
+		return ((u64)from << 32) | to;
+	}
+
+	static u32 HashEdge(u64 key)
+	{
+		key ^= key >> 33;
+		key *= 0xFF51AFD7ED558CCDull;
+		key ^= key >> 33;
+		return (u32)key;
+	}
+
+	static void InitEdgeSet(EdgeSet* set, u32 max_edges, Memory::Arena* scratch_memory)
+	{
+		u32 const table_size = GetHashTableSize(max_edges);
+		set->keys = Memory::PushType<u64>(scratch_memory, table_size);
+		set->mask = table_size - 1;
+		memset(set->keys, 0xFF, sizeof(u64) * table_size);
+	}
+
+	// Returns false if the edge was in the set already.
+	static bool InsertEdge(EdgeSet* set, u64 key)
+	{
+		u32 slot = HashEdge(key) & set->mask;
+		while (set->keys[slot] != EMPTY_EDGE)
+		{
+			if (set->keys[slot] == key)
+			{
+				return false;
+			}
+			slot = (slot + 1) & set->mask;
+		}
+
+		set->keys[slot] = key;
+		return true;
+	}
+
+	static bool HasEdge(EdgeSet const* set, u64 key)
+	{
+		u32 slot = HashEdge(key) & set->mask;
+		while (set->keys[slot] != EMPTY_EDGE)
+		{
+			if (set->keys[slot] == key)
+			{
+				return true;
+			}
+			slot = (slot + 1) & set->mask;
+		}
+
+		return false;
+	}
+
+	static void BuildEdgeSet(EdgeSet* set, Gfx::Index_t const* indices, u32 num_indices, u32 const* canonical,
+		u8* vertex_kinds, Memory::Arena* scratch_memory)
+	{
+		InitEdgeSet(set, num_indices, scratch_memory);
+
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const from = canonical[indices[i + corner]];
+				u32 const to = canonical[indices[i + (corner + 1) % 3]];
+
+				// An edge used twice in the same direction is non-manifold.
+				if (!InsertEdge(set, MakeEdgeKey(from, to)) && vertex_kinds != nullptr)
+				{
+					vertex_kinds[from] = VertexKind::Locked;
+					vertex_kinds[to] = VertexKind::Locked;
+				}
+			}
+		}
+	}
+
+	static bool IsBorderEdge(EdgeSet const* set, u32 from, u32 to)
+	{
+		return HasEdge(set, MakeEdgeKey(from, to)) != HasEdge(set, MakeEdgeKey(to, from));
+	}
+
+	// Classifies by position, then locks vertices that share their position with others.
+	static void ClassifyVertices(u8* out_kinds, EdgeSet* out_edges, Gfx::Index_t const* indices, u32 num_indices,
+		u32 const* canonical, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		memset(out_kinds, VertexKind::Manifold, num_vertices);
+		BuildEdgeSet(out_edges, indices, num_indices, canonical, out_kinds, scratch_memory);
+
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const from = canonical[indices[i + corner]];
+				u32 const to = canonical[indices[i + (corner + 1) % 3]];
+
+				if (!HasEdge(out_edges, MakeEdgeKey(to, from)))
+				{
+					if (out_kinds[from] == VertexKind::Manifold)
+					{
+						out_kinds[from] = VertexKind::Border;
+					}
+					if (out_kinds[to] == VertexKind::Manifold)
+					{
+						out_kinds[to] = VertexKind::Border;
+					}
+				}
+			}
+		}
+
+		// Kinds were stored at the canonical vertex, any position with several vertices is a seam.
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			if (canonical[vertex] != vertex)
+			{
+				out_kinds[canonical[vertex]] = VertexKind::Locked;
+			}
+		}
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			out_kinds[vertex] = out_kinds[canonical[vertex]];
+		}
+	}
+
+	// Drops triangles that became degenerate, by position.
+	static u32 CompactTriangles(Gfx::Index_t* indices, u32 num_indices, u32 const* remap, u32 const* canonical)
+	{
+		u32 num_kept = 0;
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			u32 const a = remap[indices[i + 0]];
+			u32 const b = remap[indices[i + 1]];
+			u32 const c = remap[indices[i + 2]];
+
+			if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[c] == canonical[a])
+			{
+				continue;
+			}
+
+			indices[num_kept + 0] = (Gfx::Index_t)a;
+			indices[num_kept + 1] = (Gfx::Index_t)b;
+			indices[num_kept + 2] = (Gfx::Index_t)c;
+			num_kept += 3;
+		}
+
+		return num_kept;
+	}
+
+	struct SimplifyState
+	{
+		Gfx::Index_t* indices;
+		u32 num_indices;
+
+		QuadricPoint const* points;
+		u32 const* canonical;
+		u8 const* kinds;
+		Quadric* quadrics;
+
+		// Error of each quadric at its own vertex, for the current pass.
+		f32* resting_errors;
+
+		// Collapses of the current pass.
+		u32* remap;
+		u8* collapse_locked;
+	};
+
+	static f32 GetCollapseError(SimplifyState const* state, u32 from, u32 to)
+	{
+		Quadric const* q_from = &state->quadrics[from];
+		Quadric const* q_to = &state->quadrics[to];
+
+		f32 const error = EvaluateQuadric(q_from, &state->points[to]) + state->resting_errors[to];
+		f32 const weight = q_from->weight + q_to->weight;
+		return max(error, 0.0f) / (weight > 0.0f ? weight : 1.0f);
+	}
+
+	static bool CanCollapse(SimplifyState const* state, EdgeSet const* edges, u32 from, u32 to)
+	{
+		switch (state->kinds[from])
+		{
+		case VertexKind::Manifold:
+			return true;
+		case VertexKind::Border:
+			return state->kinds[to] != VertexKind::Manifold &&
+				IsBorderEdge(edges, state->canonical[from], state->canonical[to]);
+		default:
+			return false;
+		}
+	}
+
+	// Checks the triangles around from for flipped normals, and counts the ones that would degenerate.
+	static bool HasTriangleFlips(SimplifyState const* state, TriangleAdjacency const* adjacency, u32 from, u32 to,
+		u32* out_num_collapsed)
+	{
+		*out_num_collapsed = 0;
+
+		vec3 const target = GetPosition(state->points[to]);
+		u32 const adjacent_begin = adjacency->offsets[from];
+		u32 const adjacent_end = adjacent_begin + adjacency->counts[from];
+
+		for (u32 adjacent = adjacent_begin; adjacent < adjacent_end; ++adjacent)
+		{
+			u32 const triangle = adjacency->triangles[adjacent];
+
+			u32 corners[3];
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				corners[corner] = state->remap[state->indices[triangle * 3 + corner]];
+			}
+
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+			{
+				(*out_num_collapsed)++;
+				continue;
+			}
+
+			vec3 const a = GetPosition(state->points[corners[0]]);
+			vec3 const b = GetPosition(state->points[corners[1]]);
+			vec3 const c = GetPosition(state->points[corners[2]]);
+			vec3 const before = Math::Cross(vec3(b.x - a.x, b.y - a.y, b.z - a.z), vec3(c.x - a.x, c.y - a.y, c.z - a.z));
+
+			vec3 const a1 = corners[0] == from ? target : a;
+			vec3 const b1 = corners[1] == from ? target : b;
+			vec3 const c1 = corners[2] == from ? target : c;
+			vec3 const after = Math::Cross(vec3(b1.x - a1.x, b1.y - a1.y, b1.z - a1.z), vec3(c1.x - a1.x, c1.y - a1.y, c1.z - a1.z));
+
+			// Turning by more than about 75 degrees counts as a flip. Allowing anything short of 90 lets
+			// triangles stand up on their edge, and a few collapses in a row turn them over.
+			if (Math::Dot(before, after) <= 0.25f * Math::Length(before) * Math::Length(after))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5).
+	static vec3 GetClosestPoint(vec3 const& p, vec3 const& a, vec3 const& b, vec3 const& c)
+	{
+		vec3 const ab = vec3(b.x - a.x, b.y - a.y, b.z - a.z);
+		vec3 const ac = vec3(c.x - a.x, c.y - a.y, c.z - a.z);
+		vec3 const ap = vec3(p.x - a.x, p.y - a.y, p.z - a.z);
+		f32 const d1 = Math::Dot(ab, ap);
+		f32 const d2 = Math::Dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			return a;
+		}
+
+		vec3 const bp = vec3(p.x - b.x, p.y - b.y, p.z - b.z);
+		f32 const d3 = Math::Dot(ab, bp);
+		f32 const d4 = Math::Dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			return b;
+		}
+
+		f32 const vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			f32 const t = d1 / (d1 - d3);
+			return vec3(a.x + ab.x * t, a.y + ab.y * t, a.z + ab.z * t);
+		}
+
+		vec3 const cp = vec3(p.x - c.x, p.y - c.y, p.z - c.z);
+		f32 const d5 = Math::Dot(ab, cp);
+		f32 const d6 = Math::Dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			return c;
+		}
+
+		f32 const vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			f32 const t = d2 / (d2 - d6);
+			return vec3(a.x + ac.x * t, a.y + ac.y * t, a.z + ac.z * t);
+		}
+
+		f32 const va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		{
+			f32 const t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			return vec3(b.x + (c.x - b.x) * t, b.y + (c.y - b.y) * t, b.z + (c.z - b.z) * t);
+		}
+
+		f32 const denom = 1.0f / (va + vb + vc);
+		f32 const v = vb * denom;
+		f32 const w = vc * denom;
+		return vec3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+	}
+
+	static f32 GetDistanceSq(vec3 const& p, QuadricPoint const* points, Gfx::Index_t const* triangle)
+	{
+		vec3 const closest = GetClosestPoint(p, GetPosition(points[triangle[0]]), GetPosition(points[triangle[1]]),
+			GetPosition(points[triangle[2]]));
+		vec3 const offset = vec3(p.x - closest.x, p.y - closest.y, p.z - closest.z);
+		return Math::Dot(offset, offset);
+	}
+
+	// Closest triangle around any corner of triangle, if it's closer than distance_sq.
+	static u32 FindCloserNeighbor(vec3 const& p, QuadricPoint const* points, TriangleAdjacency const* adjacency,
+		Gfx::Index_t const* indices, u32 triangle, f32* distance_sq)
+	{
+		u32 closest = INVALID_VERTEX;
+		for (u32 corner = 0; corner < 3; ++corner)
+		{
+			u32 const vertex = indices[triangle * 3 + corner];
+			u32 const adjacent_begin = adjacency->offsets[vertex];
+			u32 const adjacent_end = adjacent_begin + adjacency->counts[vertex];
+
+			for (u32 adjacent = adjacent_begin; adjacent < adjacent_end; ++adjacent)
+			{
+				u32 const neighbor = adjacency->triangles[adjacent];
+				f32 const neighbor_distance_sq = GetDistanceSq(p, points, indices + neighbor * 3);
+				if (neighbor_distance_sq < *distance_sq)
+				{
+					*distance_sq = neighbor_distance_sq;
+					closest = neighbor;
+				}
+			}
+		}
+		return closest;
+	}
+
+	// Distance of every source vertex to the result, found by walking from a triangle around the vertex it was
+	// collapsed into towards closer ones. The walk can stop short of the closest triangle, which only makes
+	// the distance larger, so it bounds the distance to the result from above. The quadrics don't: they average
+	// over the planes they were built from.
+	static f32 MeasureCollapseDistanceSq(QuadricPoint const* points, u32 const* representatives, u32 num_vertices,
+		Gfx::Index_t const* source_indices, u32 num_source_indices, Gfx::Index_t const* indices, u32 num_indices,
+		Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		TriangleAdjacency adjacency;
+		BuildTriangleAdjacency(&adjacency, indices, num_indices, num_vertices, scratch_memory);
+
+		// Vertices that lost all their triangles without moving, a corner whose two neighbors were merged,
+		// start from a source neighbor instead.
+		u32* starts = Memory::PushType<u32>(scratch_memory, num_vertices);
+		memset(starts, 0xFF, sizeof(u32) * num_vertices);
+		for (u32 i = 0; i < num_source_indices; i += 3)
+		{
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const vertex = source_indices[i + corner];
+				for (u32 other = 0; other < 3 && starts[vertex] == INVALID_VERTEX; ++other)
+				{
+					u32 const representative = representatives[source_indices[i + (corner + other) % 3]];
+					if (adjacency.counts[representative] > 0)
+					{
+						starts[vertex] = adjacency.triangles[adjacency.offsets[representative]];
+					}
+				}
+			}
+		}
+
+		// Unreferenced vertices, and the few whose neighborhood collapsed away entirely, have no triangles to start from.
+		f32 max_distance_sq = 0.0f;
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			if (starts[vertex] == INVALID_VERTEX || (representatives[vertex] == vertex && adjacency.counts[vertex] > 0))
+			{
+				continue;
+			}
+
+			vec3 const p = GetPosition(points[vertex]);
+			u32 triangle = starts[vertex];
+			f32 distance_sq = GetDistanceSq(p, points, indices + triangle * 3);
+
+			// Every step gets strictly closer, so the walk ends.
+			for (u32 closer = triangle; closer != INVALID_VERTEX; closer = FindCloserNeighbor(p, points, &adjacency, indices, triangle, &distance_sq))
+			{
+				triangle = closer;
+			}
+			max_distance_sq = max(max_distance_sq, distance_sq);
+		}
+
+		return max_distance_sq;
+	}
+
+	u64 GetSimplifyScratchSize(u32 num_indices, u32 num_vertices)
+	{
+		u64 const table_vertices = GetHashTableSize(num_vertices);
+		u64 const table_edges = GetHashTableSize(num_indices);
+
+		// Persistent: points, canonical, kinds, quadrics, remap, representatives, locks, edge set of the kinds.
+		u64 size = num_vertices * (sizeof(QuadricPoint) + sizeof(u32) * 3 + sizeof(u8) * 2 + sizeof(Quadric));
+		size += table_edges * sizeof(u64);
+
+		// Position hash table, or per pass: adjacency, edge set, candidates and sort. The final distance
+		// measurement only needs the adjacency and a start per vertex.
+		u64 const position_table = table_vertices * sizeof(u32);
+		u64 const pass = num_vertices * sizeof(u32) * 9 + num_indices * sizeof(u32) + table_edges * sizeof(u64);
+		size += max(position_table, pass);
+
+		// Alignment of every push.
+		return size + 32 * PLATFORM_DEFAULT_ALIGNMENT;
+	}
+
+	u32 Simplify(Gfx::Index_t* out_indices, SimplifyInput const* input, u32 target_num_indices, f32 max_error,
+		f32* out_error, Memory::Arena* scratch_memory)
+	{
+		ASSERT(input->num_indices % 3 == 0);
+		*out_error = 0.0f;
+
+		if (input->num_indices == 0)
+		{
+			return 0;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32 const num_vertices = input->num_vertices;
+
+		// Positions go to the unit cube, so errors and attribute weights don't depend on the mesh scale.
+		vec3 min_position = input->positions[0];
+		vec3 max_position = input->positions[0];
+		for (u32 vertex = 1; vertex < num_vertices; ++vertex)
+		{
+			vec3 const& p = input->positions[vertex];
+			min_position = vec3(min(min_position.x, p.x), min(min_position.y, p.y), min(min_position.z, p.z));
+			max_position = vec3(max(max_position.x, p.x), max(max_position.y, p.y), max(max_position.z, p.z));
+		}
+
+		f32 const extent = max(max_position.x - min_position.x, max(max_position.y - min_position.y, max_position.z - min_position.z));
+		f32 const inv_extent = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+		QuadricPoint* points = Memory::PushType<QuadricPoint>(scratch_memory, num_vertices, Memory::ZeroPush());
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			QuadricPoint& point = points[vertex];
+			vec3 const& p = input->positions[vertex];
+			point.v[0] = (p.x - min_position.x) * inv_extent;
+			point.v[1] = (p.y - min_position.y) * inv_extent;
+			point.v[2] = (p.z - min_position.z) * inv_extent;
+
+			if (input->normals != nullptr)
+			{
+				point.v[3] = input->normals[vertex].x * NORMAL_WEIGHT;
+				point.v[4] = input->normals[vertex].y * NORMAL_WEIGHT;
+				point.v[5] = input->normals[vertex].z * NORMAL_WEIGHT;
+			}
+			if (input->texcoords != nullptr)
+			{
+				point.v[6] = input->texcoords[vertex].x * TEXCOORD_WEIGHT;
+				point.v[7] = input->texcoords[vertex].y * TEXCOORD_WEIGHT;
+			}
+		}
+
+		u32* canonical = Memory::PushType<u32>(scratch_memory, num_vertices);
+		BuildPositionRemap(canonical, input->positions, num_vertices, scratch_memory);
+
+		// Vertex every source vertex ended up collapsed into, across all passes.
+		u32* remap = Memory::PushType<u32>(scratch_memory, num_vertices);
+		u32* representatives = Memory::PushType<u32>(scratch_memory, num_vertices);
+		for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+		{
+			remap[vertex] = vertex;
+			representatives[vertex] = vertex;
+		}
+
+		// Degenerate input triangles would only get in the way of classification.
+		memcpy(out_indices, input->indices, sizeof(Gfx::Index_t) * input->num_indices);
+		u32 num_indices = CompactTriangles(out_indices, input->num_indices, remap, canonical);
+
+		u8* kinds = Memory::PushType<u8>(scratch_memory, num_vertices);
+		EdgeSet input_edges;
+		ClassifyVertices(kinds, &input_edges, out_indices, num_indices, canonical, num_vertices, scratch_memory);
+
+		Quadric* quadrics = Memory::PushType<Quadric>(scratch_memory, num_vertices, Memory::ZeroPush());
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			u32 const v[3] = { out_indices[i + 0], out_indices[i + 1], out_indices[i + 2] };
+			vec3 const p0 = GetPosition(points[v[0]]);
+			vec3 const p1 = GetPosition(points[v[1]]);
+			vec3 const p2 = GetPosition(points[v[2]]);
+
+			vec3 const normal = Math::Cross(vec3(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z), vec3(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z));
+			f32 const double_area = Math::Length(normal);
+
+			Quadric triangle_quadric;
+			if (MakeTriangleQuadric(&triangle_quadric, points[v[0]], points[v[1]], points[v[2]], 0.5f * double_area))
+			{
+				AddQuadric(&quadrics[v[0]], &triangle_quadric, 1.0f);
+				AddQuadric(&quadrics[v[1]], &triangle_quadric, 1.0f);
+				AddQuadric(&quadrics[v[2]], &triangle_quadric, 1.0f);
+			}
+
+			if (double_area <= 0.0f)
+			{
+				continue;
+			}
+
+			// Planes through border edges, perpendicular to the triangle, keep the border from moving inwards.
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const from = v[corner];
+				u32 const to = v[(corner + 1) % 3];
+				if (HasEdge(&input_edges, MakeEdgeKey(canonical[to], canonical[from])))
+				{
+					continue;
+				}
+
+				vec3 const a = GetPosition(points[from]);
+				vec3 const b = GetPosition(points[to]);
+				vec3 const edge = vec3(b.x - a.x, b.y - a.y, b.z - a.z);
+				vec3 const plane_normal = Math::Cross(edge, normal);
+				f32 const plane_length = Math::Length(plane_normal);
+				if (plane_length <= 0.0f)
+				{
+					continue;
+				}
+
+				vec3 const n = vec3(plane_normal.x / plane_length, plane_normal.y / plane_length, plane_normal.z / plane_length);
+				f32 const weight = Math::Dot(edge, edge) * BORDER_WEIGHT;
+				AddPlaneQuadric(&quadrics[from], n, -Math::Dot(n, a), weight);
+				AddPlaneQuadric(&quadrics[to], n, -Math::Dot(n, a), weight);
+			}
+		}
+
+		SimplifyState state;
+		state.indices = out_indices;
+		state.points = points;
+		state.canonical = canonical;
+		state.kinds = kinds;
+		state.quadrics = quadrics;
+		state.remap = remap;
+		state.collapse_locked = Memory::PushType<u8>(scratch_memory, num_vertices);
+
+		u32 const target_num_triangles = target_num_indices / 3;
+		f32 const max_error_sq = max_error * max_error;
+		f32 result_error_sq = 0.0f;
+
+		// Every pass collapses a set of independent edges, cheapest first.
+		while (num_indices / 3 > target_num_triangles)
+		{
+			Memory::TemporaryAllocation pass_alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, pass_alloc, false));
+
+			state.num_indices = num_indices;
+			u32 const num_triangles = num_indices / 3;
+
+			TriangleAdjacency adjacency;
+			BuildTriangleAdjacency(&adjacency, out_indices, num_indices, num_vertices, scratch_memory);
+
+			EdgeSet edges;
+			BuildEdgeSet(&edges, out_indices, num_indices, canonical, nullptr, scratch_memory);
+
+			state.resting_errors = Memory::PushType<f32>(scratch_memory, num_vertices);
+			for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+			{
+				state.resting_errors[vertex] = EvaluateQuadric(&quadrics[vertex], &points[vertex]);
+			}
+
+			// Cheapest collapse per vertex.
+			u32* targets = Memory::PushType<u32>(scratch_memory, num_vertices);
+			f32* errors = Memory::PushType<f32>(scratch_memory, num_vertices);
+			memset(targets, 0xFF, sizeof(u32) * num_vertices);
+
+			for (u32 i = 0; i < num_indices; i += 3)
+			{
+				for (u32 corner = 0; corner < 3; ++corner)
+				{
+					u32 const a = out_indices[i + corner];
+					u32 const b = out_indices[i + (corner + 1) % 3];
+
+					// Interior edges show up in two triangles, once in each direction.
+					if (a > b && HasEdge(&edges, MakeEdgeKey(canonical[b], canonical[a])))
+					{
+						continue;
+					}
+
+					u32 const edge[2][2] = { { a, b }, { b, a } };
+					for (u32 const* collapse : edge)
+					{
+						u32 const from = collapse[0];
+						u32 const to = collapse[1];
+						if (!CanCollapse(&state, &edges, from, to))
+						{
+							continue;
+						}
+
+						f32 const error = GetCollapseError(&state, from, to);
+						if (targets[from] == INVALID_VERTEX || error < errors[from])
+						{
+							targets[from] = to;
+							errors[from] = error;
+						}
+					}
+				}
+			}
+
+			u32* candidates = Memory::PushType<u32>(scratch_memory, num_vertices);
+			u32* sort_keys = Memory::PushType<u32>(scratch_memory, num_vertices);
+			u32 num_candidates = 0;
+			for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+			{
+				if (targets[vertex] != INVALID_VERTEX)
+				{
+					sort_keys[num_candidates] = FloatToSortable(errors[vertex]);
+					candidates[num_candidates++] = vertex;
+				}
+			}
+
+			if (num_candidates == 0)
+			{
+				break;
+			}
+
+			u32* order = Memory::PushType<u32>(scratch_memory, num_candidates);
+			RadixSort(sort_keys, order, num_candidates, scratch_memory);
+
+			memset(state.collapse_locked, 0, num_vertices);
+			u32 num_removed = 0;
+			u32 num_collapses = 0;
+
+			for (u32 i = 0; i < num_candidates; ++i)
+			{
+				u32 const from = candidates[order[i]];
+				u32 const to = targets[from];
+				f32 const error = errors[from];
+
+				if (num_triangles - num_removed <= target_num_triangles || error > max_error_sq)
+				{
+					break;
+				}
+
+				// Neighborhoods of this pass' collapses aren't up to date, so each vertex takes part in one.
+				if (state.collapse_locked[from] || state.collapse_locked[to])
+				{
+					continue;
+				}
+
+				u32 num_collapsed;
+				if (HasTriangleFlips(&state, &adjacency, from, to, &num_collapsed))
+				{
+					continue;
+				}
+
+				remap[from] = to;
+				state.collapse_locked[from] = 1;
+				state.collapse_locked[to] = 1;
+				AddQuadric(&quadrics[to], &quadrics[from], 1.0f);
+
+				num_removed += num_collapsed;
+				num_collapses++;
+				result_error_sq = max(result_error_sq, error);
+			}
+
+			if (num_collapses == 0)
+			{
+				break;
+			}
+
+			// Collapse targets are locked for the pass, so one lookup follows every chain.
+			num_indices = CompactTriangles(out_indices, num_indices, remap, canonical);
+			for (u32 vertex = 0; vertex < num_vertices; ++vertex)
+			{
+				representatives[vertex] = remap[representatives[vertex]];
+				remap[vertex] = vertex;
+			}
+		}
+
+		// The quadric error picks the collapses, the measured distance makes the reported error an upper bound.
+		f32 const distance_sq = MeasureCollapseDistanceSq(points, representatives, num_vertices, input->indices,
+			input->num_indices, out_indices, num_indices, scratch_memory);
+		*out_error = sqrtf(max(result_error_sq, distance_sq));
+		return num_indices;
+	}
+}
\ No newline at end of file
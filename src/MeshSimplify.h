@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "Math.h"
+#include "Memory.h"
+
+// ====================================
+//  Mesh Simplification
+//  Notes:
+//  *) Edge collapse driven by quadric error metrics (Garland & Heckbert
+//     1997), extended to normals and texcoords (Garland & Heckbert 1998),
+//     so shading discontinuities are preserved along with the shape.
+//  *) Collapses move a vertex onto one of its neighbors, no new vertices
+//     are created. The result is an index list for the input vertices,
+//     so all LODs of a submesh share its vertex streams.
+//  *) Open borders only collapse along themselves, vertices that have
+//     several attribute sets (UV seams, hard edges) are never moved.
+//  *) Errors are relative to the largest extent of the positions' AABB.
+//     max_error limits the quadric error of each collapse, which is an
+//     area weighted average. The reported error is an upper bound of
+//     how far any source vertex is from the result, so it can be larger.
+// ====================================
+
+namespace MeshOpt
+{
+	struct SimplifyInput
+	{
+		Gfx::Index_t const* indices;
+		u32 num_indices;
+
+		// Normals and texcoords are optional.
+		vec3 const* positions;
+		vec3 const* normals;
+		vec2 const* texcoords;
+		u32 num_vertices;
+	};
+
+	// Upper bound of the scratch memory Simplify() uses.
+	u64 GetSimplifyScratchSize(u32 num_indices, u32 num_vertices);
+
+	// Collapses edges until target_num_indices is reached, or the next collapse would exceed max_error.
+	// out_indices needs room for input->num_indices. Returns the number of indices written, and the
+	// distance bound of the result in out_error.
+	u32 Simplify(Gfx::Index_t* out_indices, SimplifyInput const* input, u32 target_num_indices, f32 max_error,
+		f32* out_error, Memory::Arena* scratch_memory);
+
+	namespace Test
+	{
+		// See MeshSimplifyTests.cpp, Run() in MeshOptimize.h covers the rest of MeshOpt.
+		void RunSimplify();
+	}
+}
@@ -0,0 +1,324 @@
+#include "MeshSimplify.h"
+#include "TestUtils.h"
+
+namespace MeshOpt
+{
+namespace Test
+{
+	// A heightfield over the unit square, quads x quads. With a seam, the right half maps to another
+	// part of the texture, and the vertices of the middle column are there twice, once for each half.
+	struct TestGrid
+	{
+		Gfx::Index_t* indices;
+		vec3* positions;
+		vec3* normals;
+		vec2* texcoords;
+		u32* grid_x; // Column of every vertex, seam copies included.
+		u32 num_indices;
+		u32 num_vertices;
+		u32 quads;
+	};
+
+	static f32 Height(f32 x, f32 z, f32 amplitude)
+	{
+		return amplitude * sinf(x * 7.0f) * cosf(z * 5.0f);
+	}
+
+	static void BuildGrid(TestGrid* grid, u32 quads, f32 amplitude, bool b_seam, Memory::Arena* arena)
+	{
+		u32 const seam = quads / 2;
+		u32 const grid_vertices = (quads + 1) * (quads + 1);
+
+		grid->quads = quads;
+		grid->num_vertices = grid_vertices + (b_seam ? quads + 1 : 0);
+		grid->num_indices = quads * quads * 6;
+		grid->indices = Memory::PushType<Gfx::Index_t>(arena, grid->num_indices);
+		grid->positions = Memory::PushType<vec3>(arena, grid->num_vertices);
+		grid->normals = Memory::PushType<vec3>(arena, grid->num_vertices);
+		grid->texcoords = Memory::PushType<vec2>(arena, grid->num_vertices);
+		grid->grid_x = Memory::PushType<u32>(arena, grid->num_vertices);
+
+		for (u32 z = 0; z <= quads; ++z)
+		{
+			for (u32 x = 0; x <= quads; ++x)
+			{
+				f32 const fx = (f32)x / quads;
+				f32 const fz = (f32)z / quads;
+				f32 const dx = 7.0f * amplitude * cosf(fx * 7.0f) * cosf(fz * 5.0f);
+				f32 const dz = -5.0f * amplitude * sinf(fx * 7.0f) * sinf(fz * 5.0f);
+
+				u32 const vertex = z * (quads + 1) + x;
+				grid->positions[vertex] = vec3(fx, Height(fx, fz, amplitude), fz);
+				grid->normals[vertex] = Math::Normalize(vec3(-dx, 1.0f, -dz));
+				grid->texcoords[vertex] = vec2(b_seam && x > seam ? fx + 0.5f : fx, fz);
+				grid->grid_x[vertex] = x;
+
+				if (b_seam && x == seam)
+				{
+					u32 const copy = grid_vertices + z;
+					grid->positions[copy] = grid->positions[vertex];
+					grid->normals[copy] = grid->normals[vertex];
+					grid->texcoords[copy] = vec2(fx + 0.5f, fz);
+					grid->grid_x[copy] = x;
+				}
+			}
+		}
+
+		Gfx::Index_t* index = grid->indices;
+		for (u32 z = 0; z < quads; ++z)
+		{
+			for (u32 x = 0; x < quads; ++x)
+			{
+				u32 const right_side = b_seam && x == seam ? 1 : 0;
+				u32 const a = right_side ? grid_vertices + z : z * (quads + 1) + x;
+				u32 const b = right_side ? grid_vertices + z + 1 : (z + 1) * (quads + 1) + x;
+				u32 const c = z * (quads + 1) + x + 1;
+				u32 const d = (z + 1) * (quads + 1) + x + 1;
+				*index++ = (Gfx::Index_t)a; *index++ = (Gfx::Index_t)b; *index++ = (Gfx::Index_t)c;
+				*index++ = (Gfx::Index_t)c; *index++ = (Gfx::Index_t)b; *index++ = (Gfx::Index_t)d;
+			}
+		}
+	}
+
+	static SimplifyInput MakeInput(TestGrid const& grid, bool b_attributes)
+	{
+		SimplifyInput input;
+		input.indices = grid.indices;
+		input.num_indices = grid.num_indices;
+		input.positions = grid.positions;
+		input.normals = b_attributes ? grid.normals : nullptr;
+		input.texcoords = b_attributes ? grid.texcoords : nullptr;
+		input.num_vertices = grid.num_vertices;
+		return input;
+	}
+
+	static u32 SimplifyGrid(Gfx::Index_t* out_indices, TestGrid const& grid, bool b_attributes, u32 target_num_indices,
+		f32 max_error, f32* out_error)
+	{
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, GetSimplifyScratchSize(grid.num_indices, grid.num_vertices));
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+
+		SimplifyInput const input = MakeInput(grid, b_attributes);
+		return Simplify(out_indices, &input, target_num_indices, max_error, out_error, &scratch);
+	}
+
+	static vec3 Sub(vec3 a, vec3 b)
+	{
+		return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	static vec3 GetFaceNormal(vec3 const* positions, Gfx::Index_t const* triangle)
+	{
+		vec3 const a = positions[triangle[0]];
+		return Math::Cross(Sub(positions[triangle[1]], a), Sub(positions[triangle[2]], a));
+	}
+
+	// Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5).
+	static vec3 ClosestPointOnTriangle(vec3 p, vec3 a, vec3 b, vec3 c)
+	{
+		auto lerp = [](vec3 from, vec3 to, f32 t) { return vec3(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, from.z + (to.z - from.z) * t); };
+
+		vec3 const ab = Sub(b, a);
+		vec3 const ac = Sub(c, a);
+		vec3 const ap = Sub(p, a);
+		f32 const d1 = Math::Dot(ab, ap);
+		f32 const d2 = Math::Dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			return a;
+		}
+
+		vec3 const bp = Sub(p, b);
+		f32 const d3 = Math::Dot(ab, bp);
+		f32 const d4 = Math::Dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			return b;
+		}
+
+		f32 const vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			return lerp(a, b, d1 / (d1 - d3));
+		}
+
+		vec3 const cp = Sub(p, c);
+		f32 const d5 = Math::Dot(ab, cp);
+		f32 const d6 = Math::Dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			return c;
+		}
+
+		f32 const vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			return lerp(a, c, d2 / (d2 - d6));
+		}
+
+		f32 const va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			return lerp(b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		f32 const denom = 1.0f / (va + vb + vc);
+		f32 const v = vb * denom;
+		f32 const w = vc * denom;
+		return vec3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+	}
+
+	// Indices stay in range, no triangle collapses to a line or flips, and the target is met without
+	// overshooting it by much: a collapse removes two triangles inside the grid, one on its border.
+	void ReachesTargetWithValidTriangles()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestGrid grid;
+		BuildGrid(&grid, 64, 0.05f, false, &arena);
+		Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+
+		for (u32 percent : { 50u, 25u, 10u })
+		{
+			u32 const target_num_indices = grid.num_indices / 300 * percent * 3;
+
+			f32 error = -1.0f;
+			u32 const num_indices = SimplifyGrid(indices, grid, true, target_num_indices, 1.0f, &error);
+			ASSERT(num_indices % 3 == 0 && num_indices <= target_num_indices && num_indices + 6 >= target_num_indices);
+			ASSERT(error >= 0.0f && error <= 1.0f);
+
+			for (u32 i = 0; i < num_indices; i += 3)
+			{
+				Gfx::Index_t const* triangle = indices + i;
+				ASSERT(triangle[0] < grid.num_vertices && triangle[1] < grid.num_vertices && triangle[2] < grid.num_vertices);
+				ASSERT(triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0]);
+
+				// Collapses never flip a triangle, the bumps are too shallow for any to face down.
+				ASSERT(GetFaceNormal(grid.positions, triangle).y > 0.0f);
+			}
+		}
+	}
+
+	// Borders only collapse along themselves, so the outline of the result is the square's. Moving a corner
+	// along one side costs it the plane of the other, which the import's error budget never allows. Seam
+	// vertices are locked, and no triangle ends up spanning the seam.
+	void KeepsBordersAndSeams()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestGrid grid;
+		BuildGrid(&grid, 32, 0.05f, true, &arena);
+		u32 const quads = grid.quads;
+		u32 const seam = quads / 2;
+		u32 const grid_vertices = (quads + 1) * (quads + 1);
+
+		Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+		f32 error;
+		u32 const num_indices = SimplifyGrid(indices, grid, true, 0, 0.02f, &error);
+		ASSERT(num_indices > 0 && num_indices < grid.num_indices / 2);
+
+		bool* b_referenced = Memory::PushType<bool>(&arena, grid.num_vertices, Memory::ZeroPush());
+		// Edges are compared by grid position, so the seam copies don't make a border of their own.
+		auto position_id = [&](u32 vertex) { return vertex < grid_vertices ? vertex : (vertex - grid_vertices) * (quads + 1) + seam; };
+
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			bool b_left = false;
+			bool b_right = false;
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const vertex = indices[i + corner];
+				b_referenced[vertex] = true;
+
+				// Seam copies belong to the right half, the originals to the left.
+				u32 const x = grid.grid_x[vertex];
+				bool const b_copy = vertex >= grid_vertices;
+				b_left |= x < seam || (x == seam && !b_copy);
+				b_right |= x > seam || (x == seam && b_copy);
+			}
+			ASSERT(b_left != b_right);
+		}
+
+		for (u32 z = 0; z <= quads; ++z)
+		{
+			ASSERT(b_referenced[z * (quads + 1) + seam] && b_referenced[grid_vertices + z]);
+		}
+		ASSERT(b_referenced[0] && b_referenced[quads] && b_referenced[quads * (quads + 1)] && b_referenced[grid_vertices - 1]);
+
+		// An edge without its reverse is on the outline, which has to run along the square's sides.
+		auto on_side = [&](u32 a, u32 b)
+		{
+			vec3 const pa = grid.positions[a];
+			vec3 const pb = grid.positions[b];
+			return (pa.x == 0.0f && pb.x == 0.0f) || (pa.x == 1.0f && pb.x == 1.0f) || (pa.z == 0.0f && pb.z == 0.0f) ||
+				(pa.z == 1.0f && pb.z == 1.0f);
+		};
+
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				u32 const from = position_id(indices[i + corner]);
+				u32 const to = position_id(indices[i + (corner + 1) % 3]);
+
+				bool b_reverse = false;
+				for (u32 j = 0; j < num_indices && !b_reverse; j += 3)
+				{
+					for (u32 other = 0; other < 3; ++other)
+					{
+						b_reverse |= position_id(indices[j + other]) == to && position_id(indices[j + (other + 1) % 3]) == from;
+					}
+				}
+				ASSERT(b_reverse || on_side(indices[i + corner], indices[i + (corner + 1) % 3]));
+			}
+		}
+	}
+
+	// The error is relative to the largest extent, 1 for the unit square, and bounds how far any source vertex
+	// ends up from the result. Checked against every result triangle, not just the ones the simplifier measures.
+	void ErrorBoundsDistanceToSource()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestGrid grid;
+		BuildGrid(&grid, 40, 0.1f, false, &arena);
+		Gfx::Index_t* indices = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+
+		for (f32 max_error : { 0.002f, 0.01f, 0.05f })
+		{
+			f32 error;
+			u32 const num_indices = SimplifyGrid(indices, grid, false, 0, max_error, &error);
+			ASSERT(num_indices > 0 && num_indices < grid.num_indices);
+
+			f32 max_distance = 0.0f;
+			for (u32 vertex = 0; vertex < grid.num_vertices; ++vertex)
+			{
+				vec3 const p = grid.positions[vertex];
+				f32 distance = 1e30f;
+				for (u32 i = 0; i < num_indices; i += 3)
+				{
+					vec3 const closest = ClosestPointOnTriangle(p, grid.positions[indices[i]], grid.positions[indices[i + 1]],
+						grid.positions[indices[i + 2]]);
+					distance = min(distance, Math::Length(Sub(p, closest)));
+				}
+				max_distance = max(max_distance, distance);
+			}
+			ASSERT(max_distance > 0.0f && max_distance <= error * 1.0001f);
+		}
+	}
+
+	void RunSimplify()
+	{
+		ReachesTargetWithValidTriangles();
+		KeepsBordersAndSeams();
+		ErrorBoundsDistanceToSource();
+	}
+}
+}
@@ -0,0 +1,404 @@
+#include "Meshlets.h"
+#include "Bounds.h"
+#include "MeshOptimize.h"
+
+#include <float.h>
+
+namespace Meshlets
+{
+	static constexpr u8 NOT_IN_MESHLET = 0xFF;
+	static constexpr u32 INVALID_TRIANGLE = ~0u;
+
+	// Triangles checked for the closest one when a meshlet has no connected triangles left.
+	static constexpr u32 SEED_SEARCH_WINDOW = 64;
+
+	// Normal cones whose least aligned normal is closer to perpendicular than this are never culled,
+	// the cone is so wide that it would only pass at grazing angles.
+	static constexpr f32 MIN_CONE_NORMAL_DOT = 0.1f;
+
+	static_assert(Gfx::MAX_MESHLET_VERTICES <= NOT_IN_MESHLET, "Meshlet vertices have to fit u8 triangle indices!");
+
+	struct BuildState
+	{
+		Gfx::Index_t const* indices;
+		vec3 const* positions;
+		MeshOpt::TriangleAdjacency adjacency;
+
+		u8* emitted;      // Per triangle.
+		u8* local_vertex; // Per vertex, its index into the current meshlet or NOT_IN_MESHLET.
+
+		vec3 centroid_sum; // Of the current meshlet's triangles.
+	};
+
+	static vec3 GetTriangleCentroid(BuildState const* state, u32 triangle)
+	{
+		vec3 const& a = state->positions[state->indices[triangle * 3 + 0]];
+		vec3 const& b = state->positions[state->indices[triangle * 3 + 1]];
+		vec3 const& c = state->positions[state->indices[triangle * 3 + 2]];
+		return vec3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+	}
+
+	static f32 GetDistanceSq(vec3 const& a, vec3 const& b)
+	{
+		vec3 const d = vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+		return d.x * d.x + d.y * d.y + d.z * d.z;
+	}
+
+	static u32 CountNewVertices(BuildState const* state, u32 triangle)
+	{
+		u32 count = 0;
+		for (u32 i = 0; i < 3; ++i)
+		{
+			count += state->local_vertex[state->indices[triangle * 3 + i]] == NOT_IN_MESHLET;
+		}
+		return count;
+	}
+
+	static vec3 GetMeshletCenter(BuildState const* state, Gfx::Meshlet const* meshlet)
+	{
+		f32 const inv_count = 1.0f / meshlet->num_triangles;
+		return vec3(state->centroid_sum.x * inv_count, state->centroid_sum.y * inv_count, state->centroid_sum.z * inv_count);
+	}
+
+	// Triangle sharing vertices with the meshlet that adds the fewest new ones, the closest to the
+	// meshlet's center on ties. Keeps meshlets round instead of growing along strips.
+	static u32 FindConnectedTriangle(BuildState const* state, Gfx::Meshlet const* meshlet, Gfx::Index_t const* meshlet_vertices)
+	{
+		if (meshlet->num_triangles == 0)
+		{
+			return INVALID_TRIANGLE;
+		}
+
+		vec3 const center = GetMeshletCenter(state, meshlet);
+
+		u32 best_triangle = INVALID_TRIANGLE;
+		u32 best_new_vertices = 3;
+		f32 best_distance = FLT_MAX;
+
+		for (u32 i = 0; i < meshlet->num_vertices; ++i)
+		{
+			u32 const vertex = meshlet_vertices[meshlet->first_vertex + i];
+			u32 const* triangles = state->adjacency.triangles + state->adjacency.offsets[vertex];
+
+			for (u32 j = 0; j < state->adjacency.counts[vertex]; ++j)
+			{
+				u32 const triangle = triangles[j];
+				if (state->emitted[triangle])
+				{
+					continue;
+				}
+
+				u32 const new_vertices = CountNewVertices(state, triangle);
+				if (new_vertices > best_new_vertices)
+				{
+					continue;
+				}
+
+				f32 const distance = GetDistanceSq(GetTriangleCentroid(state, triangle), center);
+				if (new_vertices < best_new_vertices || distance < best_distance)
+				{
+					best_triangle = triangle;
+					best_new_vertices = new_vertices;
+					best_distance = distance;
+				}
+			}
+		}
+
+		return best_triangle;
+	}
+
+	// Next triangle in index order, or the closest of the few after it if the meshlet isn't empty.
+	// Index order is cache optimized, so those are usually nearby.
+	static u32 FindSeedTriangle(BuildState const* state, Gfx::Meshlet const* meshlet, u32* scan_cursor, u32 num_triangles)
+	{
+		while (state->emitted[*scan_cursor])
+		{
+			(*scan_cursor)++;
+		}
+
+		if (meshlet->num_triangles == 0)
+		{
+			return *scan_cursor;
+		}
+
+		vec3 const center = GetMeshletCenter(state, meshlet);
+
+		u32 best_triangle = INVALID_TRIANGLE;
+		f32 best_distance = FLT_MAX;
+
+		u32 const end = min(*scan_cursor + SEED_SEARCH_WINDOW, num_triangles);
+		for (u32 triangle = *scan_cursor; triangle < end; ++triangle)
+		{
+			if (state->emitted[triangle])
+			{
+				continue;
+			}
+
+			f32 const distance = GetDistanceSq(GetTriangleCentroid(state, triangle), center);
+			if (distance < best_distance)
+			{
+				best_triangle = triangle;
+				best_distance = distance;
+			}
+		}
+
+		return best_triangle;
+	}
+
+	static void AddTriangle(BuildState* state, Gfx::Meshlet* meshlet, u32 triangle, Gfx::Index_t* out_vertices, u8* out_triangles)
+	{
+		u8* local_triangle = out_triangles + (u64)(meshlet->first_triangle + meshlet->num_triangles) * 3;
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			Gfx::Index_t const vertex = state->indices[triangle * 3 + i];
+			if (state->local_vertex[vertex] == NOT_IN_MESHLET)
+			{
+				state->local_vertex[vertex] = (u8)meshlet->num_vertices;
+				out_vertices[meshlet->first_vertex + meshlet->num_vertices++] = vertex;
+			}
+
+			local_triangle[i] = state->local_vertex[vertex];
+		}
+
+		vec3 const centroid = GetTriangleCentroid(state, triangle);
+		state->centroid_sum = vec3(state->centroid_sum.x + centroid.x, state->centroid_sum.y + centroid.y, state->centroid_sum.z + centroid.z);
+
+		state->emitted[triangle] = 1;
+		meshlet->num_triangles++;
+	}
+
+	// Bounding sphere, and a normal cone with its apex placed so that every triangle's plane
+	// is on the far side of it. Viewers inside the cone around -axis see only back faces.
+	static void ComputeMeshletBounds(Gfx::Meshlet* meshlet, Gfx::Index_t const* meshlet_vertices, u8 const* meshlet_triangles,
+		vec3 const* positions)
+	{
+		vec3 points[Gfx::MAX_MESHLET_VERTICES];
+		for (u32 i = 0; i < meshlet->num_vertices; ++i)
+		{
+			points[i] = positions[meshlet_vertices[meshlet->first_vertex + i]];
+		}
+
+		meshlet->bounding_sphere = Bounds::ComputeBoundingSphere(points, meshlet->num_vertices);
+
+		vec3 normals[Gfx::MAX_MESHLET_TRIANGLES];
+		vec3 corners[Gfx::MAX_MESHLET_TRIANGLES];
+		u32 num_normals = 0;
+		vec3 axis = vec3(0.0f, 0.0f, 0.0f);
+
+		u8 const* triangles = meshlet_triangles + (u64)meshlet->first_triangle * 3;
+		for (u32 i = 0; i < meshlet->num_triangles; ++i)
+		{
+			vec3 const& a = points[triangles[i * 3 + 0]];
+			vec3 const& b = points[triangles[i * 3 + 1]];
+			vec3 const& c = points[triangles[i * 3 + 2]];
+
+			vec3 const normal = Math::Cross(vec3(b.x - a.x, b.y - a.y, b.z - a.z), vec3(c.x - a.x, c.y - a.y, c.z - a.z));
+			f32 const length = Math::Length(normal);
+			if (length <= 0.0f)
+			{
+				continue;
+			}
+
+			normals[num_normals] = vec3(normal.x / length, normal.y / length, normal.z / length);
+			corners[num_normals] = a;
+			axis = vec3(axis.x + normals[num_normals].x, axis.y + normals[num_normals].y, axis.z + normals[num_normals].z);
+			num_normals++;
+		}
+
+		vec3 const center = meshlet->bounding_sphere.center;
+		f32 const axis_length = Math::Length(axis);
+
+		meshlet->cone_apex = center;
+		meshlet->cone_axis = axis_length > 0.0f ? vec3(axis.x / axis_length, axis.y / axis_length, axis.z / axis_length) : vec3(0.0f, 0.0f, 1.0f);
+		meshlet->cone_cutoff = 2.0f;
+
+		if (num_normals == 0 || axis_length <= 0.0f)
+		{
+			return;
+		}
+
+		f32 min_dot = 1.0f;
+		for (u32 i = 0; i < num_normals; ++i)
+		{
+			min_dot = min(min_dot, Math::Dot(meshlet->cone_axis, normals[i]));
+		}
+
+		if (min_dot <= MIN_CONE_NORMAL_DOT)
+		{
+			return;
+		}
+
+		// Moving the apex back along the axis until it is behind every triangle's plane makes the
+		// cone test conservative for the whole cluster, not just for its center.
+		f32 max_offset = -FLT_MAX;
+		for (u32 i = 0; i < num_normals; ++i)
+		{
+			vec3 const to_center = vec3(center.x - corners[i].x, center.y - corners[i].y, center.z - corners[i].z);
+			max_offset = max(max_offset, Math::Dot(to_center, normals[i]) / Math::Dot(meshlet->cone_axis, normals[i]));
+		}
+
+		meshlet->cone_apex = vec3(center.x - meshlet->cone_axis.x * max_offset, center.y - meshlet->cone_axis.y * max_offset,
+			center.z - meshlet->cone_axis.z * max_offset);
+		meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+	}
+
+	static void FinishMeshlet(BuildState* state, Gfx::Meshlet* meshlet, Gfx::Index_t const* meshlet_vertices, u8 const* meshlet_triangles)
+	{
+		ComputeMeshletBounds(meshlet, meshlet_vertices, meshlet_triangles, state->positions);
+
+		for (u32 i = 0; i < meshlet->num_vertices; ++i)
+		{
+			state->local_vertex[meshlet_vertices[meshlet->first_vertex + i]] = NOT_IN_MESHLET;
+		}
+
+		state->centroid_sum = vec3(0.0f, 0.0f, 0.0f);
+	}
+
+	u32 GetMaxMeshlets(u32 num_indices)
+	{
+		// A meshlet is only closed when the next triangle doesn't fit. So it has more than
+		// MAX_MESHLET_VERTICES - 3 vertices, each of which takes at least one index.
+		u32 const by_vertices = (num_indices + Gfx::MAX_MESHLET_VERTICES - 3) / (Gfx::MAX_MESHLET_VERTICES - 2);
+		u32 const by_triangles = (num_indices / 3 + Gfx::MAX_MESHLET_TRIANGLES - 1) / Gfx::MAX_MESHLET_TRIANGLES;
+		return max(by_vertices, by_triangles);
+	}
+
+	u32 BuildMeshlets(Gfx::Meshlet* out_meshlets, Gfx::Index_t* out_vertices, u8* out_triangles,
+		Gfx::Index_t const* indices, u32 num_indices, vec3 const* positions, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+
+		u32 const num_triangles = num_indices / 3;
+		if (num_triangles == 0)
+		{
+			return 0;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		BuildState state;
+		state.indices = indices;
+		state.positions = positions;
+		MeshOpt::BuildTriangleAdjacency(&state.adjacency, indices, num_indices, num_vertices, scratch_memory);
+		state.emitted = Memory::PushType<u8>(scratch_memory, num_triangles, Memory::ZeroPush());
+		state.local_vertex = Memory::PushType<u8>(scratch_memory, num_vertices);
+		memset(state.local_vertex, NOT_IN_MESHLET, num_vertices);
+		state.centroid_sum = vec3(0.0f, 0.0f, 0.0f);
+
+		u32 num_meshlets = 0;
+		Gfx::Meshlet meshlet;
+		u32 scan_cursor = 0;
+
+		for (u32 i = 0; i < num_triangles; ++i)
+		{
+			u32 triangle = FindConnectedTriangle(&state, &meshlet, out_vertices);
+			if (triangle == INVALID_TRIANGLE)
+			{
+				triangle = FindSeedTriangle(&state, &meshlet, &scan_cursor, num_triangles);
+			}
+
+			bool const b_full = meshlet.num_triangles == Gfx::MAX_MESHLET_TRIANGLES ||
+				meshlet.num_vertices + CountNewVertices(&state, triangle) > Gfx::MAX_MESHLET_VERTICES;
+
+			// The triangle that didn't fit seeds the next meshlet, which keeps it next to this one.
+			if (b_full)
+			{
+				FinishMeshlet(&state, &meshlet, out_vertices, out_triangles);
+				out_meshlets[num_meshlets++] = meshlet;
+
+				Gfx::Meshlet next;
+				next.first_vertex = meshlet.first_vertex + meshlet.num_vertices;
+				next.first_triangle = meshlet.first_triangle + meshlet.num_triangles;
+				meshlet = next;
+			}
+
+			AddTriangle(&state, &meshlet, triangle, out_vertices, out_triangles);
+		}
+
+		FinishMeshlet(&state, &meshlet, out_vertices, out_triangles);
+		out_meshlets[num_meshlets++] = meshlet;
+
+		ASSERT(num_meshlets <= GetMaxMeshlets(num_indices));
+		return num_meshlets;
+	}
+
+	void MakeCullParams(CullParams* out_params, mat44 const& view_proj, mat34 const& world, vec3 const& eye)
+	{
+		// Planes of the clip space volume, 0 <= z <= w, taken to object space through the combined
+		// matrix (Gribb & Hartmann). Nothing has to be transformed per meshlet.
+		mat44 const clip = view_proj * Math::ToMat44(world);
+
+		vec4 rows[4];
+		for (u32 row = 0; row < 4; ++row)
+		{
+			rows[row] = vec4(clip(row, 0), clip(row, 1), clip(row, 2), clip(row, 3));
+		}
+
+		vec4* planes = out_params->planes;
+		planes[0] = vec4(rows[3].x + rows[0].x, rows[3].y + rows[0].y, rows[3].z + rows[0].z, rows[3].w + rows[0].w); // Left
+		planes[1] = vec4(rows[3].x - rows[0].x, rows[3].y - rows[0].y, rows[3].z - rows[0].z, rows[3].w - rows[0].w); // Right
+		planes[2] = vec4(rows[3].x + rows[1].x, rows[3].y + rows[1].y, rows[3].z + rows[1].z, rows[3].w + rows[1].w); // Bottom
+		planes[3] = vec4(rows[3].x - rows[1].x, rows[3].y - rows[1].y, rows[3].z - rows[1].z, rows[3].w - rows[1].w); // Top
+		planes[4] = rows[2];                                                                                           // Near
+		planes[5] = vec4(rows[3].x - rows[2].x, rows[3].y - rows[2].y, rows[3].z - rows[2].z, rows[3].w - rows[2].w); // Far
+
+		// Normalized, so sphere radii can be compared with the plane distances.
+		for (u32 i = 0; i < 6; ++i)
+		{
+			f32 const inv_length = 1.0f / Math::Length(vec3(planes[i].x, planes[i].y, planes[i].z));
+			planes[i] = planes[i] * inv_length;
+		}
+
+		out_params->eye = Math::Mul(Math::Inverse(world), vec4(eye.x, eye.y, eye.z, 1.0f)).xyz;
+	}
+
+	static bool IsVisible(CullParams const* params, Gfx::Meshlet const& meshlet)
+	{
+		if (meshlet.cone_cutoff <= 1.0f)
+		{
+			vec3 const to_apex = vec3(meshlet.cone_apex.x - params->eye.x, meshlet.cone_apex.y - params->eye.y, meshlet.cone_apex.z - params->eye.z);
+			if (Math::Dot(to_apex, meshlet.cone_axis) >= meshlet.cone_cutoff * Math::Length(to_apex))
+			{
+				return false;
+			}
+		}
+
+		vec3 const& center = meshlet.bounding_sphere.center;
+		for (u32 i = 0; i < 6; ++i)
+		{
+			vec4 const& plane = params->planes[i];
+			if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -meshlet.bounding_sphere.radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	u32 CullMeshlets(Gfx::Index_t* out_indices, CullParams const* params, Gfx::Meshlet const* meshlets, u32 num_meshlets,
+		Gfx::Index_t const* meshlet_vertices, u8 const* meshlet_triangles)
+	{
+		u32 num_indices = 0;
+		for (u32 i = 0; i < num_meshlets; ++i)
+		{
+			Gfx::Meshlet const& meshlet = meshlets[i];
+			if (!IsVisible(params, meshlet))
+			{
+				continue;
+			}
+
+			Gfx::Index_t const* vertices = meshlet_vertices + meshlet.first_vertex;
+			u8 const* triangles = meshlet_triangles + (u64)meshlet.first_triangle * 3;
+
+			for (u32 j = 0; j < meshlet.num_triangles * 3; ++j)
+			{
+				out_indices[num_indices++] = vertices[triangles[j]];
+			}
+		}
+
+		return num_indices;
+	}
+}
\ No newline at end of file
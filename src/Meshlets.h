@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "Math.h"
+#include "Memory.h"
+
+// ====================================
+//  Meshlets
+//  Notes:
+//  *) Submeshes are split into clusters of at most Gfx::MAX_MESHLET_VERTICES
+//     vertices and Gfx::MAX_MESHLET_TRIANGLES triangles. Clusters grow
+//     greedily over shared vertices and stay spatially compact, so their
+//     bounds are tight.
+//  *) Every meshlet has a bounding sphere and a normal cone (apex, axis,
+//     cutoff), for frustum and backface culling of whole clusters.
+//  *) Culling runs on the CPU in object space and writes the triangles
+//     of the visible clusters as a compacted index list, relative to the
+//     submesh's base vertex like the submesh's own indices.
+// ====================================
+
+namespace Meshlets
+{
+	// Upper bound of the meshlets BuildMeshlets() emits for num_indices. It writes at most
+	// num_indices meshlet vertices and num_indices meshlet triangle bytes.
+	u32 GetMaxMeshlets(u32 num_indices);
+
+	// Builds the meshlets of one submesh, best after MeshOpt::OptimizeVertexCache. Meshlet ranges
+	// start at 0, returns the number of meshlets written.
+	u32 BuildMeshlets(Gfx::Meshlet* out_meshlets, Gfx::Index_t* out_vertices, u8* out_triangles,
+		Gfx::Index_t const* indices, u32 num_indices, vec3 const* positions, u32 num_vertices, Memory::Arena* scratch_memory);
+
+	// Frustum planes and eye in the object space of one instance.
+	struct CullParams
+	{
+		vec4 planes[6]; // Normalized, inside where dot(plane.xyz, p) + plane.w >= 0.
+		vec3 eye;
+	};
+
+	// view_proj takes world to D3D clip space, world is the instance's object to world transform.
+	void MakeCullParams(CullParams* out_params, mat44 const& view_proj, mat34 const& world, vec3 const& eye);
+
+	// Writes the triangles of the visible meshlets to out_indices, which needs room for all of their
+	// triangles. Returns the number of indices written.
+	u32 CullMeshlets(Gfx::Index_t* out_indices, CullParams const* params, Gfx::Meshlet const* meshlets, u32 num_meshlets,
+		Gfx::Index_t const* meshlet_vertices, u8 const* meshlet_triangles);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
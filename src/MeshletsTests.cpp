@@ -0,0 +1,440 @@
+#include "Meshlets.h"
+#include "MeshOptimize.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+
+namespace Meshlets
+{
+namespace Test
+{
+	struct TestMesh
+	{
+		Gfx::Index_t* indices;
+		vec3* positions;
+		u32 num_indices;
+		u32 num_vertices;
+	};
+
+	struct MeshletSet
+	{
+		Gfx::Meshlet* meshlets;
+		Gfx::Index_t* vertices;
+		u8* triangles;
+		u32 num_meshlets;
+	};
+
+	static vec3 Sub(vec3 a, vec3 b)
+	{
+		return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	static vec3 GetFaceNormal(vec3 a, vec3 b, vec3 c)
+	{
+		return Math::Cross(Sub(b, a), Sub(c, a));
+	}
+
+	// Unit sphere with a vertex at each pole, wound outwards.
+	static void BuildSphere(TestMesh* mesh, u32 segments, u32 rings, Memory::Arena* arena)
+	{
+		mesh->num_vertices = 2 + (rings - 1) * segments;
+		mesh->num_indices = segments * (rings - 1) * 6;
+		mesh->positions = Memory::PushType<vec3>(arena, mesh->num_vertices);
+		mesh->indices = Memory::PushType<Gfx::Index_t>(arena, mesh->num_indices);
+
+		mesh->positions[0] = vec3(0.0f, 1.0f, 0.0f);
+		mesh->positions[1] = vec3(0.0f, -1.0f, 0.0f);
+		for (u32 ring = 1; ring < rings; ++ring)
+		{
+			f32 const theta = Math::Pi * ring / rings;
+			for (u32 segment = 0; segment < segments; ++segment)
+			{
+				f32 const phi = 2.0f * Math::Pi * segment / segments;
+				mesh->positions[2 + (ring - 1) * segments + segment] = vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+			}
+		}
+
+		auto ring_vertex = [&](u32 ring, u32 segment) { return (Gfx::Index_t)(2 + (ring - 1) * segments + segment % segments); };
+
+		Gfx::Index_t* index = mesh->indices;
+		for (u32 segment = 0; segment < segments; ++segment)
+		{
+			*index++ = 0; *index++ = ring_vertex(1, segment); *index++ = ring_vertex(1, segment + 1);
+			*index++ = 1; *index++ = ring_vertex(rings - 1, segment); *index++ = ring_vertex(rings - 1, segment + 1);
+		}
+		for (u32 ring = 1; ring < rings - 1; ++ring)
+		{
+			for (u32 segment = 0; segment < segments; ++segment)
+			{
+				Gfx::Index_t const a = ring_vertex(ring, segment);
+				Gfx::Index_t const b = ring_vertex(ring, segment + 1);
+				Gfx::Index_t const c = ring_vertex(ring + 1, segment);
+				Gfx::Index_t const d = ring_vertex(ring + 1, segment + 1);
+				*index++ = a; *index++ = b; *index++ = c;
+				*index++ = c; *index++ = b; *index++ = d;
+			}
+		}
+
+		// Every face normal points away from the center.
+		for (u32 i = 0; i < mesh->num_indices; i += 3)
+		{
+			Gfx::Index_t* triangle = mesh->indices + i;
+			vec3 const a = mesh->positions[triangle[0]];
+			if (Math::Dot(GetFaceNormal(a, mesh->positions[triangle[1]], mesh->positions[triangle[2]]), a) < 0.0f)
+			{
+				std::swap(triangle[1], triangle[2]);
+			}
+		}
+	}
+
+	// Gentle bumps over the unit square, all faces point up.
+	static void BuildGrid(TestMesh* mesh, u32 quads, Memory::Arena* arena)
+	{
+		mesh->num_vertices = (quads + 1) * (quads + 1);
+		mesh->num_indices = quads * quads * 6;
+		mesh->positions = Memory::PushType<vec3>(arena, mesh->num_vertices);
+		mesh->indices = Memory::PushType<Gfx::Index_t>(arena, mesh->num_indices);
+
+		for (u32 z = 0; z <= quads; ++z)
+		{
+			for (u32 x = 0; x <= quads; ++x)
+			{
+				f32 const fx = (f32)x / quads;
+				f32 const fz = (f32)z / quads;
+				mesh->positions[z * (quads + 1) + x] = vec3(fx, 0.02f * sinf(fx * 9.0f) * cosf(fz * 7.0f), fz);
+			}
+		}
+
+		Gfx::Index_t* index = mesh->indices;
+		for (u32 z = 0; z < quads; ++z)
+		{
+			for (u32 x = 0; x < quads; ++x)
+			{
+				Gfx::Index_t const a = (Gfx::Index_t)(z * (quads + 1) + x);
+				Gfx::Index_t const b = (Gfx::Index_t)((z + 1) * (quads + 1) + x);
+				Gfx::Index_t const c = (Gfx::Index_t)(z * (quads + 1) + x + 1);
+				Gfx::Index_t const d = (Gfx::Index_t)((z + 1) * (quads + 1) + x + 1);
+				*index++ = a; *index++ = b; *index++ = c;
+				*index++ = c; *index++ = b; *index++ = d;
+			}
+		}
+	}
+
+	static void BuildMeshletSet(MeshletSet* set, TestMesh const& mesh, Memory::Arena* arena)
+	{
+		set->meshlets = Memory::PushType<Gfx::Meshlet>(arena, GetMaxMeshlets(mesh.num_indices));
+		set->vertices = Memory::PushType<Gfx::Index_t>(arena, mesh.num_indices);
+		set->triangles = Memory::PushType<u8>(arena, mesh.num_indices);
+		set->num_meshlets = BuildMeshlets(set->meshlets, set->vertices, set->triangles, mesh.indices, mesh.num_indices,
+			mesh.positions, mesh.num_vertices, arena);
+	}
+
+	// A triangle as a key, rotated to start at its smallest index, so the winding counts.
+	static u64 GetTriangleKey(u32 a, u32 b, u32 c)
+	{
+		u32 const v[3] = { a, b, c };
+		u32 first = 0;
+		for (u32 corner = 1; corner < 3; ++corner)
+		{
+			first = v[corner] < v[first] ? corner : first;
+		}
+		return ((u64)v[first] << 32) | ((u64)v[(first + 1) % 3] << 16) | v[(first + 2) % 3];
+	}
+
+	static u64* SortedTriangles(Gfx::Index_t const* indices, u32 num_indices, Memory::Arena* arena)
+	{
+		u64* keys = Memory::PushType<u64>(arena, num_indices / 3);
+		for (u32 i = 0; i < num_indices; i += 3)
+		{
+			keys[i / 3] = GetTriangleKey(indices[i], indices[i + 1], indices[i + 2]);
+		}
+		std::sort(keys, keys + num_indices / 3);
+		return keys;
+	}
+
+	static bool ContainsAll(Sphere const& sphere, vec3 const* positions, Gfx::Index_t const* vertices, u32 count)
+	{
+		// Ritter moves the center in float, allow for a little rounding.
+		f32 const radius = sphere.radius * (1.0f + 1e-5f) + 1e-6f;
+		for (u32 i = 0; i < count; ++i)
+		{
+			vec3 const d = Sub(positions[vertices[i]], sphere.center);
+			if (Math::Dot(d, d) > radius * radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Limits and ranges of every meshlet, and that they hold the submesh's triangles, no more no less.
+	// Returns the largest vertex and triangle counts.
+	static void CheckMeshlets(MeshletSet const& set, TestMesh const& mesh, u32* out_max_vertices, u32* out_max_triangles,
+		Memory::Arena* arena)
+	{
+		ASSERT(set.num_meshlets > 0 && set.num_meshlets <= GetMaxMeshlets(mesh.num_indices));
+
+		Gfx::Index_t* rebuilt = Memory::PushType<Gfx::Index_t>(arena, mesh.num_indices);
+		u32 num_rebuilt = 0;
+		u32 next_vertex = 0;
+		u32 next_triangle = 0;
+		*out_max_vertices = 0;
+		*out_max_triangles = 0;
+
+		for (u32 i = 0; i < set.num_meshlets; ++i)
+		{
+			Gfx::Meshlet const& meshlet = set.meshlets[i];
+			ASSERT(meshlet.num_vertices > 0 && meshlet.num_vertices <= Gfx::MAX_MESHLET_VERTICES);
+			ASSERT(meshlet.num_triangles > 0 && meshlet.num_triangles <= Gfx::MAX_MESHLET_TRIANGLES);
+			ASSERT(meshlet.first_vertex == next_vertex && meshlet.first_triangle == next_triangle);
+			next_vertex += meshlet.num_vertices;
+			next_triangle += meshlet.num_triangles;
+			*out_max_vertices = max(*out_max_vertices, meshlet.num_vertices);
+			*out_max_triangles = max(*out_max_triangles, meshlet.num_triangles);
+
+			Gfx::Index_t const* vertices = set.vertices + meshlet.first_vertex;
+			ASSERT(ContainsAll(meshlet.bounding_sphere, mesh.positions, vertices, meshlet.num_vertices));
+
+			u8 const* triangles = set.triangles + (u64)meshlet.first_triangle * 3;
+			for (u32 j = 0; j < meshlet.num_triangles * 3; ++j)
+			{
+				ASSERT(triangles[j] < meshlet.num_vertices);
+				rebuilt[num_rebuilt++] = vertices[triangles[j]];
+			}
+		}
+
+		ASSERT(next_vertex <= mesh.num_indices && num_rebuilt == mesh.num_indices);
+		u64 const* expected = SortedTriangles(mesh.indices, mesh.num_indices, arena);
+		u64 const* actual = SortedTriangles(rebuilt, num_rebuilt, arena);
+		ASSERT(memcmp(expected, actual, sizeof(u64) * (mesh.num_indices / 3)) == 0);
+	}
+
+	// A sphere in source, cache optimized and shuffled triangle order, the last leans on the seed search.
+	void SplitsWithinLimits()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(8));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestMesh sphere;
+		BuildSphere(&sphere, 48, 32, &arena);
+
+		TestMesh optimized = sphere;
+		optimized.indices = Memory::PushType<Gfx::Index_t>(&arena, sphere.num_indices);
+		memcpy(optimized.indices, sphere.indices, sizeof(Gfx::Index_t) * sphere.num_indices);
+		MeshOpt::OptimizeVertexCache(optimized.indices, optimized.num_indices, optimized.num_vertices, MeshOpt::DEFAULT_CACHE_SIZE, &arena);
+
+		TestMesh shuffled = sphere;
+		shuffled.indices = Memory::PushType<Gfx::Index_t>(&arena, sphere.num_indices);
+		memcpy(shuffled.indices, sphere.indices, sizeof(Gfx::Index_t) * sphere.num_indices);
+		TestUtils::Random random;
+		for (u32 i = shuffled.num_indices / 3; i > 1; --i)
+		{
+			u32 const other = random.Index(i);
+			for (u32 corner = 0; corner < 3; ++corner)
+			{
+				std::swap(shuffled.indices[(i - 1) * 3 + corner], shuffled.indices[other * 3 + corner]);
+			}
+		}
+
+		TestMesh grid;
+		BuildGrid(&grid, 40, &arena);
+
+		for (TestMesh const* mesh : { &sphere, &optimized, &shuffled, &grid })
+		{
+			MeshletSet set;
+			BuildMeshletSet(&set, *mesh, &arena);
+
+			u32 max_vertices;
+			u32 max_triangles;
+			CheckMeshlets(set, *mesh, &max_vertices, &max_triangles, &arena);
+
+			// Meshlets are only closed when the next triangle doesn't fit, on a connected mesh that's by vertices.
+			ASSERT(max_vertices > Gfx::MAX_MESHLET_VERTICES - 3);
+		}
+	}
+
+	// Meshes made to hit each limit: disjoint triangles fill meshlets with 21 triangles and 63 vertices, one
+	// triangle repeated fills them with 124 triangles and 3 vertices. The counts go just past each multiple.
+	void MaxMeshletsIsAnUpperBound()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestUtils::Random random;
+		u32 const per_disjoint = Gfx::MAX_MESHLET_VERTICES / 3;
+
+		for (u32 num_triangles : { 1u, per_disjoint, per_disjoint + 1, per_disjoint * 3 - 1, per_disjoint * 3 + 1, 1000u })
+		{
+			Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(&arena);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(&arena, alloc, false));
+
+			TestMesh disjoint;
+			disjoint.num_indices = num_triangles * 3;
+			disjoint.num_vertices = num_triangles * 3;
+			disjoint.indices = Memory::PushType<Gfx::Index_t>(&arena, disjoint.num_indices);
+			disjoint.positions = Memory::PushType<vec3>(&arena, disjoint.num_vertices);
+			for (u32 i = 0; i < disjoint.num_indices; ++i)
+			{
+				disjoint.indices[i] = (Gfx::Index_t)i;
+				disjoint.positions[i] = vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+			}
+
+			MeshletSet set;
+			BuildMeshletSet(&set, disjoint, &arena);
+
+			u32 max_vertices;
+			u32 max_triangles;
+			CheckMeshlets(set, disjoint, &max_vertices, &max_triangles, &arena);
+			ASSERT(set.num_meshlets == (num_triangles + per_disjoint - 1) / per_disjoint);
+		}
+
+		vec3 const corners[3] = { vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f) };
+		for (u32 num_triangles : { 1u, Gfx::MAX_MESHLET_TRIANGLES, Gfx::MAX_MESHLET_TRIANGLES + 1, 1000u })
+		{
+			Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(&arena);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(&arena, alloc, false));
+
+			TestMesh repeated;
+			repeated.num_indices = num_triangles * 3;
+			repeated.num_vertices = 3;
+			repeated.indices = Memory::PushType<Gfx::Index_t>(&arena, repeated.num_indices);
+			repeated.positions = Memory::PushType<vec3>(&arena, 3);
+			memcpy(repeated.positions, corners, sizeof(corners));
+			for (u32 i = 0; i < repeated.num_indices; ++i)
+			{
+				repeated.indices[i] = (Gfx::Index_t)(i % 3);
+			}
+
+			MeshletSet set;
+			BuildMeshletSet(&set, repeated, &arena);
+
+			u32 max_vertices;
+			u32 max_triangles;
+			CheckMeshlets(set, repeated, &max_vertices, &max_triangles, &arena);
+			ASSERT(set.num_meshlets == (num_triangles + Gfx::MAX_MESHLET_TRIANGLES - 1) / Gfx::MAX_MESHLET_TRIANGLES);
+			ASSERT(max_triangles == min(num_triangles, Gfx::MAX_MESHLET_TRIANGLES));
+		}
+	}
+
+	// The brute force reference: front facing in world space, and a corner inside the D3D clip volume. Both
+	// with a little margin, the cull tests are exact in theory but run in float on another basis.
+	static bool IsTriangleVisible(vec3 const* positions, Gfx::Index_t const* triangle, mat34 const& world, mat44 const& view_proj,
+		vec3 const& eye)
+	{
+		vec3 corners[3];
+		bool b_inside = false;
+		for (u32 corner = 0; corner < 3; ++corner)
+		{
+			vec3 const& p = positions[triangle[corner]];
+			corners[corner] = Math::Mul(world, vec4(p.x, p.y, p.z, 1.0f)).xyz;
+
+			vec4 const clip = Math::Mul(view_proj, vec4(corners[corner].x, corners[corner].y, corners[corner].z, 1.0f));
+			f32 const w = clip.w * (1.0f - 1e-3f);
+			b_inside |= clip.x > -w && clip.x < w && clip.y > -w && clip.y < w && clip.z > 1e-3f * clip.w && clip.z < w;
+		}
+
+		vec3 const normal = GetFaceNormal(corners[0], corners[1], corners[2]);
+		vec3 const to_eye = Sub(eye, corners[0]);
+		return b_inside && Math::Dot(normal, to_eye) > 1e-3f * Math::Length(normal) * Math::Length(to_eye);
+	}
+
+	// Random cameras around an instance that is scaled unevenly, rotated and moved: every triangle that is
+	// visible by the reference survives culling. The cameras mostly look past the mesh, so the frustum
+	// cuts through it, and the back of it always faces away.
+	void CullingKeepsVisibleTriangles()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(8));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestMesh sphere;
+		BuildSphere(&sphere, 48, 32, &arena);
+		TestMesh grid;
+		BuildGrid(&grid, 40, &arena);
+
+		mat34 const world = Math::TRS<mat34>(vec3(3.0f, -1.0f, 8.0f), Math::QuatAxisAngle(Math::Normalize(vec3(1.0f, 2.0f, 0.5f)), Math::Rad(0.7f)),
+			vec3(1.5f, 0.8f, 2.0f));
+		vec3 const center = Math::Mul(world, vec4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+		mat44 const proj = Math::MatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 30.0f);
+
+		TestUtils::Random random;
+		Gfx::Index_t* culled = Memory::PushType<Gfx::Index_t>(&arena, max(sphere.num_indices, grid.num_indices));
+
+		for (TestMesh const* mesh : { &sphere, &grid })
+		{
+			MeshletSet set;
+			BuildMeshletSet(&set, *mesh, &arena);
+
+			u64 num_culled = 0;
+			u64 num_visible = 0;
+			for (u32 trial = 0; trial < 64; ++trial)
+			{
+				Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(&arena);
+				ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(&arena, alloc, false));
+
+				vec3 const eye = vec3(center.x + random.Float(-8.0f, 8.0f), center.y + random.Float(-8.0f, 8.0f), center.z + random.Float(-8.0f, 8.0f));
+				vec3 const look_at = vec3(center.x + random.Float(-3.0f, 3.0f), center.y + random.Float(-3.0f, 3.0f), center.z + random.Float(-3.0f, 3.0f));
+				mat44 const view_proj = proj * Math::MatrixLookAtLH(eye, look_at, vec3(0.0f, 1.0f, 0.0f));
+
+				CullParams params;
+				MakeCullParams(&params, view_proj, world, eye);
+				u32 const num_indices = CullMeshlets(culled, &params, set.meshlets, set.num_meshlets, set.vertices, set.triangles);
+				ASSERT(num_indices % 3 == 0 && num_indices <= mesh->num_indices);
+
+				u64 const* kept = num_indices > 0 ? SortedTriangles(culled, num_indices, &arena) : nullptr;
+				for (u32 i = 0; i < mesh->num_indices; i += 3)
+				{
+					Gfx::Index_t const* triangle = mesh->indices + i;
+					if (IsTriangleVisible(mesh->positions, triangle, world, view_proj, eye))
+					{
+						ASSERT(std::binary_search(kept, kept + num_indices / 3, GetTriangleKey(triangle[0], triangle[1], triangle[2])));
+						num_visible++;
+					}
+				}
+				num_culled += mesh->num_indices - num_indices;
+			}
+
+			// Not trivially passing: there was something to keep, and something was culled.
+			ASSERT(num_visible > 0 && num_culled > 0);
+		}
+	}
+
+	// The grid seen from below with all of it in view: every meshlet faces away, the cones alone cull them all.
+	// Seen from above, none of them are.
+	void ConesCullBackFacingClusters()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestMesh grid;
+		BuildGrid(&grid, 40, &arena);
+
+		MeshletSet set;
+		BuildMeshletSet(&set, grid, &arena);
+		Gfx::Index_t* culled = Memory::PushType<Gfx::Index_t>(&arena, grid.num_indices);
+
+		mat44 const proj = Math::MatrixPerspectiveFovLH(1.5f, 1.0f, 0.1f, 30.0f);
+		for (f32 height : { -3.0f, 3.0f })
+		{
+			vec3 const eye = vec3(0.5f, height, 0.5f);
+			mat44 const view_proj = proj * Math::MatrixLookAtLH(eye, vec3(0.5f, 0.0f, 0.5f), vec3(0.0f, 0.0f, 1.0f));
+
+			CullParams params;
+			MakeCullParams(&params, view_proj, mat34::Identity(), eye);
+			u32 const num_indices = CullMeshlets(culled, &params, set.meshlets, set.num_meshlets, set.vertices, set.triangles);
+			ASSERT(num_indices == (height < 0.0f ? 0 : grid.num_indices));
+		}
+	}
+
+	void Run()
+	{
+		SplitsWithinLimits();
+		MaxMeshletsIsAnUpperBound();
+		CullingKeepsVisibleTriangles();
+		ConesCullBackFacingClusters();
+	}
+}
+}
@@ -4,10 +4,32 @@
 #include "WindowConfig.h"
 #include "InputMessageQueue.h"
 #include "GeoUtils.h"
+#include "Bounds.h"
 
 #include "GLTFImport.h"
+#include "MeshFile.h"
+#include "Meshlets.h"
 
-static void CreateCubeMesh(Gfx::Commandlist cmds, Gfx::Mesh* out_mesh)
+// Coarser LODs are drawn as long as their error stays below this size on screen.
+static constexpr f32 MAX_LOD_ERROR_PIXELS = 1.0f;
+
+// Errors scale with the largest axis of the transform.
+static f32 GetMaxScale(mat34 const& world)
+{
+	return max(Math::Length(vec3(world(0, 0), world(1, 0), world(2, 0))),
+		max(Math::Length(vec3(world(0, 1), world(1, 1), world(2, 1))), Math::Length(vec3(world(0, 2), world(1, 2), world(2, 2)))));
+}
+
+// The distance is to the closest point of the submesh's bounding sphere.
+static u32 SelectSubMeshLod(Gfx::SubMesh const& submesh, mat34 const& world, f32 world_scale, vec3 eye_pos, f32 screen_scale)
+{
+	vec3 const center = Math::Mul(world, vec4(submesh.bounding_sphere.center.x, submesh.bounding_sphere.center.y, submesh.bounding_sphere.center.z, 1.0f)).xyz;
+	f32 const distance = Math::Length(vec3(center.x - eye_pos.x, center.y - eye_pos.y, center.z - eye_pos.z)) - submesh.bounding_sphere.radius * world_scale;
+
+	return Gfx::SelectLod(submesh, distance, world_scale, screen_scale, MAX_LOD_ERROR_PIXELS);
+}
+
+static void CreateCubeMesh(Gfx::Commandlist cmds, Memory::Arena* arena, Gfx::Mesh* out_mesh)
 {
 	GeoUtils::CubeGeometry cube;
 	GeoUtils::CreateBox(1.5f, 1.5f, 1.5f, &cube);
@@ -28,55 +50,152 @@ static void CreateCubeMesh(Gfx::Commandlist cmds, Gfx::Mesh* out_mesh)
 
 	out_mesh->index_buffer_gpu = Gfx::CreateIndexBuffer(cmds, cube.indices, index_size * GeoUtils::CubeGeometry::num_indices);
 
-	Gfx::SubMesh* submesh = out_mesh->submeshes.PushBack();
+	Gfx::SubMesh* submesh = Memory::PushType<Gfx::SubMesh>(arena, 1, Memory::ZeroPush());
 	submesh->num_indices = cube.num_indices;
 	submesh->base_vertex_location = 0;
 	submesh->first_index_location = 0;
+	submesh->aabb = Bounds::ComputeAABB(cube.position, GeoUtils::CubeGeometry::num_vertices);
+	submesh->bounding_sphere = Bounds::ComputeBoundingSphere(cube.position, GeoUtils::CubeGeometry::num_vertices);
+
+	out_mesh->submeshes = submesh;
+	out_mesh->num_submeshes = 1;
+	out_mesh->aabb = submesh->aabb;
+	out_mesh->bounding_sphere = submesh->bounding_sphere;
 }
 
-static void UploadMeshImport(Gfx::Commandlist cmds, Mini::MeshImport const* imported, Gfx::Mesh* out_mesh)
+static void UploadMeshImport(Gfx::Commandlist cmds, Mini::MeshImport const* imported, Memory::Arena* arena, Gfx::Mesh* out_mesh)
 {
-	u32 const position_size = sizeof(Gfx::Position_t);
-	u32 const normal_size = sizeof(Gfx::Normal_t);
-	u32 const texcoord_size = sizeof(Gfx::TexCoord_t);
 	u32 const index_size = sizeof(Gfx::Index_t);
 
-	out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Position] = Gfx::CreateVertexBuffer(
-		cmds, imported->position_buffer, position_size * imported->num_vertices, position_size);
+	if (imported->flags & Mini::ImportFlags::KeepInterleavedStreams)
+	{
+		u32 const stride = imported->interleaved_stride;
 
-	out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Normal] = Gfx::CreateVertexBuffer(
-		cmds, imported->normal_buffer, normal_size * imported->num_vertices, normal_size);
+		Gfx::GpuBuffer vertex_buffer = Gfx::CreateVertexBuffer(
+			cmds, imported->interleaved_buffer, stride * imported->num_vertices, stride);
 
-	out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::TexCoord] = Gfx::CreateVertexBuffer(
-		cmds, imported->texcoord_buffer, texcoord_size * imported->num_vertices, texcoord_size);
+		// Every attribute views the same buffer at its own offset, the input layout stays the same.
+		for (u32 i = 0; i < Gfx::VertexAttribType::EnumCount; ++i)
+		{
+			if (imported->interleaved_offsets[i] != Mini::INTERLEAVED_ATTRIB_MISSING)
+			{
+				out_mesh->vertex_attribs_gpu[i] = vertex_buffer;
+				out_mesh->vertex_attrib_offsets[i] = imported->interleaved_offsets[i];
+			}
+		}
+
+		out_mesh->flags |= Gfx::MeshFlags::InterleavedVertexStreams;
+	}
+	else if (imported->flags & Mini::ImportFlags::CompressVertexStreams)
+	{
+		u32 const position_size = sizeof(Gfx::CompressedPosition_t);
+		u32 const normal_size = sizeof(Gfx::CompressedNormal_t);
+		u32 const texcoord_size = sizeof(Gfx::CompressedTexCoord_t);
+		u32 const tangent_size = sizeof(Gfx::CompressedTangent_t);
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Position] = Gfx::CreateVertexBuffer(
+			cmds, imported->compressed_position_buffer, position_size * imported->num_vertices, position_size,
+			Gfx::GetVertexAttribFormat(Gfx::VertexAttribType::Position, true));
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Normal] = Gfx::CreateVertexBuffer(
+			cmds, imported->compressed_normal_buffer, normal_size * imported->num_vertices, normal_size,
+			Gfx::GetVertexAttribFormat(Gfx::VertexAttribType::Normal, true));
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::TexCoord] = Gfx::CreateVertexBuffer(
+			cmds, imported->compressed_texcoord_buffer, texcoord_size * imported->num_vertices, texcoord_size,
+			Gfx::GetVertexAttribFormat(Gfx::VertexAttribType::TexCoord, true));
+
+		if (imported->compressed_tangent_buffer)
+		{
+			out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Tangent] = Gfx::CreateVertexBuffer(
+				cmds, imported->compressed_tangent_buffer, tangent_size * imported->num_vertices, tangent_size,
+				Gfx::GetVertexAttribFormat(Gfx::VertexAttribType::Tangent, true));
+		}
+
+		out_mesh->flags |= Gfx::MeshFlags::CompressedVertexStreams;
+		out_mesh->quantization_bounds = imported->bounds;
+	}
+	else
+	{
+		u32 const position_size = sizeof(Gfx::Position_t);
+		u32 const normal_size = sizeof(Gfx::Normal_t);
+		u32 const texcoord_size = sizeof(Gfx::TexCoord_t);
+		u32 const tangent_size = sizeof(Gfx::Tangent_t);
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Position] = Gfx::CreateVertexBuffer(
+			cmds, imported->position_buffer, position_size * imported->num_vertices, position_size);
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Normal] = Gfx::CreateVertexBuffer(
+			cmds, imported->normal_buffer, normal_size * imported->num_vertices, normal_size);
+
+		out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::TexCoord] = Gfx::CreateVertexBuffer(
+			cmds, imported->texcoord_buffer, texcoord_size * imported->num_vertices, texcoord_size);
+
+		if (imported->tangent_buffer)
+		{
+			out_mesh->vertex_attribs_gpu[Gfx::VertexAttribType::Tangent] = Gfx::CreateVertexBuffer(
+				cmds, imported->tangent_buffer, tangent_size * imported->num_vertices, tangent_size);
+		}
+	}
 
 	out_mesh->index_buffer_gpu = Gfx::CreateIndexBuffer(cmds, imported->index_buffer, index_size * imported->num_indices);
 
-	Gfx::SubMesh* submesh = out_mesh->submeshes.PushBack();
-	submesh->num_indices = imported->num_indices;
-	submesh->base_vertex_location = 0;
-	submesh->first_index_location = 0;
+	// The import memory is released after upload, the submeshes have to outlive it.
+	out_mesh->num_submeshes = imported->num_submeshes;
+	out_mesh->submeshes = Memory::PushType<Gfx::SubMesh>(arena, imported->num_submeshes);
+	memcpy(out_mesh->submeshes, imported->submeshes, sizeof(Gfx::SubMesh) * imported->num_submeshes);
+
+	if (imported->num_meshlets > 0)
+	{
+		out_mesh->num_meshlets = imported->num_meshlets;
+		out_mesh->meshlets = Memory::PushType<Gfx::Meshlet>(arena, imported->num_meshlets);
+		out_mesh->meshlet_vertices = Memory::PushType<Gfx::Index_t>(arena, imported->num_meshlet_vertices);
+		out_mesh->meshlet_triangles = Memory::PushType<u8>(arena, imported->num_meshlet_triangles * 3);
+		memcpy(out_mesh->meshlets, imported->meshlets, sizeof(Gfx::Meshlet) * imported->num_meshlets);
+		memcpy(out_mesh->meshlet_vertices, imported->meshlet_vertices, sizeof(Gfx::Index_t) * imported->num_meshlet_vertices);
+		memcpy(out_mesh->meshlet_triangles, imported->meshlet_triangles, imported->num_meshlet_triangles * 3);
+	}
+
+	out_mesh->aabb = imported->bounds;
+	out_mesh->bounding_sphere = imported->bounding_sphere;
 }
 
 void MiniApp::Init()
 {
 	__super::Init();
 
-	Memory::Arena import_scratch;
-	Memory::InitArena(&import_scratch, Megabyte(16)); // Just reuse a larger game memory arena 
-
 	Memory::Arena mesh_resource_memory;
 	Memory::InitArena(&mesh_resource_memory, Megabyte(128));
+	ON_SCOPE_EXIT(Memory::FreeArena(&mesh_resource_memory));
+
+	Memory::InitArena(&m_scene_memory, Megabyte(16));
+
+	// The cooked mesh is used straight from the file mapping, the glTF is only imported (and cooked) if it doesn't exist yet.
+	char const* mesh_file_path = "C:\\Users\\Philipp\\Documents\\work\\glTF-Sample-Models\\2.0\\DamagedHelmet\\glTF\\DamagedHelmet.mmesh";
+
+	Mini::MeshImport mesh_data;
+	IO::MappedFile mesh_file;
+	bool const b_cooked = MeshFile::Load(mesh_file_path, &mesh_data, &mesh_file, &m_scene_memory);
+	ON_SCOPE_EXIT(IO::UnmapFile(&mesh_file));
 
 	Mini::SceneImporter importer;
 	importer.file_path = "C:\\Users\\Philipp\\Documents\\work\\glTF-Sample-Models\\2.0\\DamagedHelmet\\glTF\\DamagedHelmet.gltf";
-	importer.scratch_memory = &import_scratch;
+	importer.scratch_memory = nullptr; // Every import thread brings its own.
 	importer.mesh_memory = &mesh_resource_memory;
-
-	Mini::MeshImport mesh_data = Mini::Import(&importer);
-	
-	ON_SCOPE_EXIT(Memory::FreeArena(&import_scratch));
-	ON_SCOPE_EXIT(Memory::FreeArena(&mesh_resource_memory));
+	importer.scene_memory = &m_scene_memory;
+	importer.flags = Mini::ImportFlags::CompressVertexStreams | Mini::ImportFlags::OptimizeVertexOrder | Mini::ImportFlags::GenerateLods |
+		Mini::ImportFlags::BuildMeshlets | Mini::ImportFlags::WeldVertices | Mini::ImportFlags::GenerateTangents |
+		Mini::ImportFlags::InstanceMeshes;
+
+	// Import on the job system while the device is being created.
+	Mini::BatchImport import_batch;
+	import_batch.importers = &importer;
+	import_batch.results = &mesh_data;
+	import_batch.count = b_cooked ? 0 : 1;
+	import_batch.scratch_size_per_thread = Megabyte(16);
+	import_batch.on_imported = nullptr;
+	import_batch.user_data = nullptr;
+	Mini::BeginBatchImport(&import_batch);
 
 #ifdef _DEBUG
 	u32 gfx_flags = Gfx::InitFlags::Enable_Debug_Layer | Gfx::InitFlags::Allow_Tearing;
@@ -93,9 +212,55 @@ void MiniApp::Init()
 		m_present_cmds = Gfx::CreateCommandList(D3D12_COMMAND_LIST_TYPE_DIRECT, L"present_cmds");
 	}
 
+	Mini::WaitForBatchImport(&import_batch);
+
+	if (!b_cooked)
+	{
+		MeshFile::Write(mesh_file_path, &mesh_data, &mesh_resource_memory);
+	}
+
+	m_scene = mesh_data.hierarchy;
+	m_mesh_instances = mesh_data.instances;
+	m_num_mesh_instances = mesh_data.num_instances;
+	m_instance_batches = mesh_data.instance_batches;
+	m_num_instance_batches = mesh_data.num_instance_batches;
+	m_batch_instance_nodes = mesh_data.batch_instance_nodes;
+	m_batch_instance_transforms = mesh_data.batch_instance_transforms;
+	m_num_batch_instances = mesh_data.num_batch_instances;
+
+	// Place the whole imported scene through its root node.
+	Scene::Transform scene_root = Scene::IdentityTransform();
+	scene_root.rotation = Math::QuatAxisAngle(vec3(1.0f, 0.0f, 0.0f), Math::Rad(-0.7f));
+	Scene::SetLocalTransform(&m_scene, 0, scene_root);
+
+	// Loops the first clip, if there is one. The clips of a cooked mesh point into the file mapping, which is closed below.
+	Animation::CopyClipLibrary(&m_animations, &mesh_data.animations, &m_scene_memory);
+	if (m_animations.num_clips > 0)
+	{
+		Animation::InitPlayer(&m_animation_player, &m_animations, 0, &m_scene_memory);
+	}
+
 	Gfx::OpenCommandList(m_upload_cmds);
-	CreateCubeMesh(m_upload_cmds, &m_cube_mesh);
-	UploadMeshImport(m_upload_cmds, &mesh_data, &m_import_mesh);
+	CreateCubeMesh(m_upload_cmds, &m_scene_memory, &m_cube_mesh);
+	UploadMeshImport(m_upload_cmds, &mesh_data, &m_scene_memory, &m_import_mesh);
+
+	// Submeshes with meshlets draw the culled index list, which is rewritten for every draw.
+	{
+		u32 max_culled_indices = 0;
+		for (u32 i = 0; i < m_import_mesh.num_submeshes; ++i)
+		{
+			if (m_import_mesh.submeshes[i].num_meshlets > 0)
+			{
+				max_culled_indices = max(max_culled_indices, m_import_mesh.submeshes[i].num_indices);
+			}
+		}
+
+		if (max_culled_indices > 0)
+		{
+			m_culled_indices = Memory::PushType<Gfx::Index_t>(&m_scene_memory, max_culled_indices);
+			m_culled_index_buffer = Gfx::CreateIndexBuffer(m_upload_cmds, nullptr, sizeof(Gfx::Index_t) * max_culled_indices, Gfx::BufferUsage::Default);
+		}
+	}
 
 	// Generate per-frame and per-object constant buffers
 	{
@@ -114,6 +279,21 @@ void MiniApp::Init()
 		m_obj_constants = Gfx::CreateBuffer(m_upload_cmds, obj, L"ObjectConstants");
 	}
 
+	// Instance stream of the batches, rewritten every frame.
+	if (m_num_batch_instances > 0)
+	{
+		m_batch_instance_worlds = Memory::PushType<mat34>(&m_scene_memory, m_num_batch_instances);
+		m_batch_instance_models = Memory::PushType<mat34>(&m_scene_memory, m_num_batch_instances);
+
+		Gfx::GpuBufferDesc instances;
+		instances.bind_flags = Gfx::BindFlags::VertexBuffer;
+		instances.usage = Gfx::BufferUsage::Dynamic;
+		instances.cpu_access_flags = 0;
+		instances.sizes_bytes = sizeof(mat34) * m_num_batch_instances;
+		instances.stride_in_bytes = sizeof(mat34);
+		m_batch_instance_buffer = Gfx::CreateBuffer(m_upload_cmds, instances, L"BatchInstanceTransforms");
+	}
+
 	u64 upload_fence = Gfx::SubmitCommandList(m_upload_cmds);
 
 	Gfx::CompileBasicPSOs();
@@ -127,18 +307,89 @@ void MiniApp::render()
 
 	PerFrameData frame_constants;
 	frame_constants.view_proj = m_proj * m_view;
+	mat44 const view_proj = frame_constants.view_proj;
 	Gfx::UpdateBuffer(m_draw_cmds, &m_frame_constants, &frame_constants, sizeof(frame_constants));
 
 	// TODO(): Surely I should be able to record this into upload_cmds, then submit and make draw_cmds wait on the fence.
-	PerObjectData obj_constants;
-	obj_constants.model = m_world;
-	Gfx::UpdateBuffer(m_draw_cmds, &m_obj_constants, &obj_constants, sizeof(obj_constants));
+	bool const compressed_streams = (m_import_mesh.flags & Gfx::MeshFlags::CompressedVertexStreams) != 0;
 
-	Gfx::BindPSO(m_draw_cmds, Gfx::BasicPSO::VertexColorSolid);
+	mat34 const dequantize = compressed_streams ? Quantize::DequantizeTransform(m_import_mesh.quantization_bounds) : mat34::Identity();
+
+	Gfx::BindPSO(m_draw_cmds, compressed_streams ? Gfx::BasicPSO::VertexColorSolidCompressed : Gfx::BasicPSO::VertexColorSolid);
 	Gfx::BindConstantBuffer(&m_frame_constants, Gfx::ShaderStage::Vertex, 0);
 	Gfx::BindConstantBuffer(&m_obj_constants, Gfx::ShaderStage::Vertex, 1);
 
-	Gfx::DrawMesh(m_draw_cmds, &m_import_mesh);
+	for (u32 i = 0; i < m_num_mesh_instances; ++i)
+	{
+		Gfx::MeshInstance const& instance = m_mesh_instances[i];
+
+		mat34 const world = Scene::GetWorldTransform(&m_scene, instance.node);
+
+		PerObjectData obj_constants;
+		obj_constants.model = world * dequantize;
+		Gfx::UpdateBuffer(m_draw_cmds, &m_obj_constants, &obj_constants, sizeof(obj_constants));
+
+		f32 const world_scale = GetMaxScale(world);
+
+		Meshlets::CullParams cull_params;
+		Meshlets::MakeCullParams(&cull_params, view_proj, world, m_eye_pos);
+
+		for (u32 submesh_idx = instance.first_submesh; submesh_idx < instance.first_submesh + instance.num_submeshes; ++submesh_idx)
+		{
+			Gfx::SubMesh const& submesh = m_import_mesh.submeshes[submesh_idx];
+			u32 const lod = SelectSubMeshLod(submesh, world, world_scale, m_eye_pos, m_lod_screen_scale);
+
+			// Meshlets only cover the full detail indices, coarser LODs are drawn as a whole.
+			if (lod == 0 && submesh.num_meshlets > 0)
+			{
+				u32 const num_indices = Meshlets::CullMeshlets(m_culled_indices, &cull_params, m_import_mesh.meshlets + submesh.first_meshlet,
+					submesh.num_meshlets, m_import_mesh.meshlet_vertices, m_import_mesh.meshlet_triangles);
+
+				if (num_indices > 0)
+				{
+					Gfx::UpdateBuffer(m_draw_cmds, &m_culled_index_buffer, m_culled_indices, sizeof(Gfx::Index_t) * num_indices);
+					Gfx::DrawSubMeshIndices(m_draw_cmds, &m_import_mesh, submesh_idx, &m_culled_index_buffer, num_indices);
+				}
+				continue;
+			}
+
+			Gfx::DrawSubMeshes(m_draw_cmds, &m_import_mesh, submesh_idx, 1, lod);
+		}
+	}
+
+	// One draw per batch submesh for all of its instances. Meshlet culling is per instance, so batches
+	// skip it, and draw the finest LOD any of their instances needs.
+	if (m_num_batch_instances > 0)
+	{
+		for (u32 i = 0; i < m_num_batch_instances; ++i)
+		{
+			m_batch_instance_worlds[i] = Scene::GetWorldTransform(&m_scene, m_batch_instance_nodes[i]) * m_batch_instance_transforms[i];
+			m_batch_instance_models[i] = m_batch_instance_worlds[i] * dequantize;
+		}
+		Gfx::UpdateBuffer(m_draw_cmds, &m_batch_instance_buffer, m_batch_instance_models, sizeof(mat34) * m_num_batch_instances);
+
+		Gfx::BindPSO(m_draw_cmds, compressed_streams ? Gfx::BasicPSO::VertexColorSolidCompressedInstanced : Gfx::BasicPSO::VertexColorSolidInstanced);
+
+		for (u32 i = 0; i < m_num_instance_batches; ++i)
+		{
+			Gfx::InstanceBatch const& batch = m_instance_batches[i];
+
+			for (u32 submesh_idx = batch.first_submesh; submesh_idx < batch.first_submesh + batch.num_submeshes; ++submesh_idx)
+			{
+				Gfx::SubMesh const& submesh = m_import_mesh.submeshes[submesh_idx];
+
+				u32 lod = submesh.num_lods;
+				for (u32 instance_idx = batch.first_instance; instance_idx < batch.first_instance + batch.num_instances && lod > 0; ++instance_idx)
+				{
+					mat34 const& world = m_batch_instance_worlds[instance_idx];
+					lod = min(lod, SelectSubMeshLod(submesh, world, GetMaxScale(world), m_eye_pos, m_lod_screen_scale));
+				}
+
+				Gfx::DrawSubMeshesInstanced(m_draw_cmds, &m_import_mesh, submesh_idx, 1, &m_batch_instance_buffer,
+					batch.first_instance, batch.num_instances, lod);
+			}
+		}
+	}
 
 	Gfx::SubmitCommandList(m_draw_cmds);
 
@@ -228,18 +479,14 @@ bool MiniApp::Update()
 		return false;
 	}
 
-	f32 total_time = GetTotalTimeS(m_timer);
-
-	// Calc single object world matrix
+	if (m_animations.num_clips > 0)
 	{
-		f32 angle = sin(total_time);
-
-		mat44 translate = Math::Translation<mat44>(0.0f, 0.0f, 0.0f);
-		mat44 rotation = Math::RotationXYZ<mat44>(Math::Rad(-0.7f), Math::Rad(0.0f), Math::Rad(0.0f));
-
-		m_world = translate * rotation;
+		Animation::AdvancePlayer(&m_animation_player, &m_animations, GetDeltaTimeS(m_timer), true);
+		Animation::Sample(&m_scene, &m_animations, &m_animation_player, 1);
 	}
 
+	Scene::UpdateWorldTransforms(&m_scene);
+
 	static ArcBallCamera s_camera;
 	ProcessCameraInput(&input, &s_camera);
 	EvaluateCameraMatrices(&s_camera);
@@ -251,6 +498,7 @@ bool MiniApp::Update()
 		vec3 up = Math::UpDir();
 
 		m_view = Math::MatrixLookAtLH(eye_pos, look_at, up);
+		m_eye_pos = eye_pos;
 	}
 
 	// Calc proj mat
@@ -259,6 +507,7 @@ bool MiniApp::Update()
 		f32 fov_y = Math::DegreeToRad(70.0f);
 
 		m_proj = Math::MatrixPerspectiveFovLH(fov_y, aspect_ratio, 0.01f, 1000.0f);
+		m_lod_screen_scale = Gfx::GetLodScreenScale(fov_y, (f32)m_window_cfg->height);
 	}
 
 	render();
@@ -270,4 +519,5 @@ void MiniApp::Exit()
 {
 	__super::Exit();
 	Gfx::DestroyGpuDevice();
+	Memory::FreeArena(&m_scene_memory);
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "BaseApp.h"
+#include "Animation.h"
 #include "Math.h"
+#include "Memory.h"
+#include "SceneGraph.h"
 
 #include "GpuDeviceDX12.h"
 
@@ -19,13 +22,38 @@ private:
 
 	Gfx::GpuBuffer m_frame_constants;
 	Gfx::GpuBuffer m_obj_constants;
+
+	// Visible meshlet triangles of the submesh being drawn.
+	Gfx::GpuBuffer m_culled_index_buffer;
+	Gfx::Index_t* m_culled_indices;
 	
 	Gfx::Mesh m_import_mesh;
 	Gfx::Mesh m_cube_mesh;
 
-	mat44 m_world;
+	Memory::Arena m_scene_memory;
+	Scene::Hierarchy m_scene;
+	Gfx::MeshInstance* m_mesh_instances;
+	u32 m_num_mesh_instances;
+
+	Gfx::InstanceBatch* m_instance_batches;
+	u32 m_num_instance_batches;
+	u32* m_batch_instance_nodes;
+	mat34* m_batch_instance_transforms;
+	u32 m_num_batch_instances;
+
+	// World and model matrix of every batch instance, rebuilt each frame. The model matrices
+	// are uploaded as the instance stream of all batches.
+	mat34* m_batch_instance_worlds;
+	mat34* m_batch_instance_models;
+	Gfx::GpuBuffer m_batch_instance_buffer;
+
+	Animation::ClipLibrary m_animations;
+	Animation::Player m_animation_player;
+
 	mat44 m_view;
 	mat44 m_proj;
+	vec3 m_eye_pos;
+	f32 m_lod_screen_scale;
 
 	struct PerFrameData
 	{
@@ -35,7 +63,7 @@ private:
 
 	struct PerObjectData
 	{
-		mat44 model;
-		//u8 pad[192]; - Internally padded by gfx
+		mat34 model;
+		//u8 pad[208]; - Internally padded by gfx
 	};
 };
\ No newline at end of file
@@ -0,0 +1,609 @@
+#include "MipGeneration.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+namespace MipGeneration
+{
+	// Output rows per job. Every band filters the source rows under its kernels horizontally first,
+	// wider bands redo fewer of the rows that are shared with the next band.
+	static constexpr u32 BAND_ROWS = 32;
+
+	static constexpr f32 KAISER_RADIUS = 3.0f;
+	static constexpr f32 KAISER_ALPHA = 4.0f;
+	static constexpr f32 LANCZOS_RADIUS = 3.0f;
+
+	// Linear values are encoded to sRGB through a table of this size, fine enough that
+	// even the steepest (darkest) part of the curve rounds like the exact conversion.
+	static constexpr u32 SRGB_ENCODE_ENTRIES = 16384;
+
+	struct ColorTables
+	{
+		f32 unorm_to_linear[256];
+		f32 srgb_to_linear[256];
+		u8 linear_to_srgb[SRGB_ENCODE_ENTRIES];
+	};
+
+	static ColorTables const& GetColorTables()
+	{
+		struct Local
+		{
+			static ColorTables Build()
+			{
+				ColorTables tables;
+				for (u32 i = 0; i < 256; ++i)
+				{
+					f32 const v = i / 255.0f;
+					tables.unorm_to_linear[i] = v;
+					tables.srgb_to_linear[i] = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+				}
+
+				for (u32 i = 0; i < SRGB_ENCODE_ENTRIES; ++i)
+				{
+					f32 const v = i / (f32)(SRGB_ENCODE_ENTRIES - 1);
+					f32 const srgb = v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+					tables.linear_to_srgb[i] = (u8)(srgb * 255.0f + 0.5f);
+				}
+				return tables;
+			}
+		};
+
+		static ColorTables const tables = Local::Build();
+		return tables;
+	}
+
+	// ====================================
+	//  Filter Weights
+	// ====================================
+
+	static f32 Sinc(f32 x)
+	{
+		x *= Math::Pi;
+		return fabsf(x) < 1e-5f ? 1.0f : sinf(x) / x;
+	}
+
+	// Modified Bessel function of the first kind, order 0, from its power series.
+	static f32 BesselI0(f32 x)
+	{
+		f32 sum = 1.0f;
+		f32 term = 1.0f;
+		f32 const half_x_sq = x * x * 0.25f;
+		for (u32 k = 1; k < 32 && term > sum * 1e-7f; ++k)
+		{
+			term *= half_x_sq / (f32)(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	static f32 GetFilterRadius(Filter::Enum filter)
+	{
+		return filter == Filter::Kaiser ? KAISER_RADIUS : filter == Filter::Lanczos ? LANCZOS_RADIUS : 0.5f;
+	}
+
+	// x in destination texels.
+	static f32 EvaluateFilter(Filter::Enum filter, f32 x)
+	{
+		x = fabsf(x);
+		if (filter == Filter::Kaiser)
+		{
+			if (x >= KAISER_RADIUS)
+			{
+				return 0.0f;
+			}
+
+			f32 const t = x / KAISER_RADIUS;
+			return Sinc(x) * BesselI0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+		}
+
+		return x < LANCZOS_RADIUS ? Sinc(x) * Sinc(x / LANCZOS_RADIUS) : 0.0f;
+	}
+
+	// Weights of one axis: output texel i reads num_taps source texels from first[i] on. Taps that fall
+	// off the edge are added to the edge texel, windows near the end are moved back so they stay inside.
+	struct Axis
+	{
+		u32* first;
+		f32* weights; // Per output, stride floats, or stride * 4 broadcast floats when built for rows.
+		u32 num_taps;
+		u32 stride; // num_taps, rounded up to a multiple of 2 for rows.
+	};
+
+	// Unclamped range of source texels under output texel i.
+	static void GetFootprint(Filter::Enum filter, u32 i, f32 scale, s32* out_lo, s32* out_hi)
+	{
+		if (filter == Filter::Box)
+		{
+			*out_lo = (s32)floorf(i * scale);
+			*out_hi = (s32)ceilf((i + 1) * scale) - 1;
+			return;
+		}
+
+		f32 const center = (i + 0.5f) * scale;
+		f32 const support = GetFilterRadius(filter) * scale;
+		*out_lo = (s32)floorf(center - support);
+		*out_hi = (s32)ceilf(center + support) - 1;
+	}
+
+	static Axis BuildAxis(u32 src_size, u32 dst_size, Filter::Enum filter, bool b_rows, Memory::Arena* scratch_memory)
+	{
+		f32 const scale = (f32)src_size / (f32)dst_size;
+
+		u32 max_taps = 1;
+		for (u32 i = 0; i < dst_size; ++i)
+		{
+			s32 lo, hi;
+			GetFootprint(filter, i, scale, &lo, &hi);
+			lo = Clamp<s32>(lo, 0, src_size - 1);
+			hi = Clamp<s32>(hi, 0, src_size - 1);
+			max_taps = max(max_taps, (u32)(hi - lo + 1));
+		}
+
+		Axis axis;
+		axis.num_taps = min(max_taps, src_size);
+		axis.stride = b_rows ? (axis.num_taps + 1) & ~1u : axis.num_taps;
+		axis.first = Memory::PushType<u32>(scratch_memory, dst_size);
+
+		u32 const floats_per_weight = b_rows ? 4 : 1;
+		axis.weights = Memory::PushType<f32>(scratch_memory, dst_size * axis.stride * floats_per_weight, Memory::ZeroAndAlignPush(32));
+
+		f32 weights[64];
+		ASSERT(axis.num_taps <= ARRAY_SIZE(weights));
+
+		for (u32 i = 0; i < dst_size; ++i)
+		{
+			s32 lo, hi;
+			GetFootprint(filter, i, scale, &lo, &hi);
+			u32 const first = min((u32)Clamp<s32>(lo, 0, src_size - 1), src_size - axis.num_taps);
+			axis.first[i] = first;
+
+			memset(weights, 0, sizeof(weights));
+			f32 sum = 0.0f;
+			for (s32 s = lo; s <= hi; ++s)
+			{
+				f32 w;
+				if (filter == Filter::Box)
+				{
+					// Overlap of the source texel with the output texel's footprint.
+					w = min((f32)(s + 1), (i + 1) * scale) - max((f32)s, i * scale);
+				}
+				else
+				{
+					w = EvaluateFilter(filter, ((f32)s + 0.5f - (i + 0.5f) * scale) / scale);
+				}
+
+				weights[Clamp<s32>(s, 0, src_size - 1) - first] += w;
+				sum += w;
+			}
+
+			f32 const inv_sum = 1.0f / sum;
+			for (u32 k = 0; k < axis.num_taps; ++k)
+			{
+				f32* dst = axis.weights + ((u64)i * axis.stride + k) * floats_per_weight;
+				for (u32 c = 0; c < floats_per_weight; ++c)
+				{
+					dst[c] = weights[k] * inv_sum;
+				}
+			}
+		}
+
+		return axis;
+	}
+
+	// ====================================
+	//  Kernels
+	// ====================================
+
+	struct LevelTask
+	{
+		Image::Surface const* src;
+		Image::Surface const* dst;
+		Axis rows;
+		Axis columns;
+
+		f32 const* color_to_linear;
+		f32 const* alpha_to_linear;
+		u8 const* linear_to_srgb; // Null for linear color.
+		bool use_avx2;
+
+		u64 scratch_size_per_thread;
+		Memory::Arena* thread_scratch; // Jobs::MAX_THREADS
+		u32* alpha_histograms; // 256 per thread, null without PreserveAlphaCoverage.
+	};
+
+	// Source texels to floats, with one extra zero texel behind the row for the paired taps.
+	static void DecodeRow(LevelTask const* task, u8 const* src, u32 width, f32* out)
+	{
+		for (u32 x = 0; x < width; ++x, src += 4, out += 4)
+		{
+			_mm_store_ps(out, _mm_setr_ps(task->color_to_linear[src[0]], task->color_to_linear[src[1]],
+				task->color_to_linear[src[2]], task->alpha_to_linear[src[3]]));
+		}
+		_mm_store_ps(out, _mm_setzero_ps());
+	}
+
+	static void FilterRowSSE(Axis const& axis, f32 const* src, u32 width, f32* out)
+	{
+		for (u32 x = 0; x < width; ++x, out += 4)
+		{
+			f32 const* texels = src + (u64)axis.first[x] * 4;
+			f32 const* weights = axis.weights + (u64)x * axis.stride * 4;
+
+			__m128 sum = _mm_setzero_ps();
+			for (u32 k = 0; k < axis.stride; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(weights + k * 4), _mm_load_ps(texels + k * 4)));
+			}
+			_mm_store_ps(out, sum);
+		}
+	}
+
+	// Two taps per step, the weights of neighboring taps sit next to each other like the texels do.
+	static SIMD_TARGET_AVX2 void FilterRowAVX2(Axis const& axis, f32 const* src, u32 width, f32* out)
+	{
+		for (u32 x = 0; x < width; ++x, out += 4)
+		{
+			f32 const* texels = src + (u64)axis.first[x] * 4;
+			f32 const* weights = axis.weights + (u64)x * axis.stride * 4;
+
+			__m256 sum = _mm256_setzero_ps();
+			for (u32 k = 0; k < axis.stride; k += 2)
+			{
+				sum = _mm256_fmadd_ps(_mm256_load_ps(weights + k * 4), _mm256_loadu_ps(texels + k * 4), sum);
+			}
+			_mm_store_ps(out, _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+		}
+	}
+
+	// Weighted sum of num_taps rows, row_stride floats apart.
+	static void FilterColumnsSSE(f32 const* rows, u64 row_stride, f32 const* weights, u32 num_taps, u32 num_floats, f32* out)
+	{
+		for (u32 i = 0; i < num_floats; i += 4)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (u32 k = 0; k < num_taps; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_load_ps(rows + k * row_stride + i)));
+			}
+			_mm_store_ps(out + i, sum);
+		}
+	}
+
+	static SIMD_TARGET_AVX2 void FilterColumnsAVX2(f32 const* rows, u64 row_stride, f32 const* weights, u32 num_taps, u32 num_floats, f32* out)
+	{
+		u32 i = 0;
+		for (; i + 8 <= num_floats; i += 8)
+		{
+			__m256 sum = _mm256_setzero_ps();
+			for (u32 k = 0; k < num_taps; ++k)
+			{
+				sum = _mm256_fmadd_ps(_mm256_broadcast_ss(weights + k), _mm256_loadu_ps(rows + k * row_stride + i), sum);
+			}
+			_mm256_storeu_ps(out + i, sum);
+		}
+
+		// Odd widths leave one texel.
+		FilterColumnsSSE(rows + i, row_stride, weights, num_taps, num_floats - i, out + i);
+	}
+
+	static void EncodeRow(LevelTask const* task, f32 const* src, u32 width, u8* out, u32* alpha_histogram)
+	{
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const one = _mm_set1_ps(1.0f);
+		__m128 const to_unorm = _mm_set1_ps(255.0f);
+
+		if (task->linear_to_srgb == nullptr)
+		{
+			u32 x = 0;
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i const t0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4 + 0), zero), one), to_unorm));
+				__m128i const t1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4 + 4), zero), one), to_unorm));
+				__m128i const t2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4 + 8), zero), one), to_unorm));
+				__m128i const t3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4 + 12), zero), one), to_unorm));
+				_mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(_mm_packs_epi32(t0, t1), _mm_packs_epi32(t2, t3)));
+			}
+
+			for (; x < width; ++x)
+			{
+				__m128i const t = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4), zero), one), to_unorm));
+				u32 const packed = (u32)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(t, t), t));
+				memcpy(out + x * 4, &packed, sizeof(packed));
+			}
+		}
+		else
+		{
+			// Color through the table, alpha stays linear.
+			__m128 const to_index = _mm_setr_ps(SRGB_ENCODE_ENTRIES - 1, SRGB_ENCODE_ENTRIES - 1, SRGB_ENCODE_ENTRIES - 1, 255.0f);
+			for (u32 x = 0; x < width; ++x)
+			{
+				alignas(16) s32 t[4];
+				_mm_store_si128((__m128i*)t, _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(src + x * 4), zero), one), to_index)));
+				out[x * 4 + 0] = task->linear_to_srgb[t[0]];
+				out[x * 4 + 1] = task->linear_to_srgb[t[1]];
+				out[x * 4 + 2] = task->linear_to_srgb[t[2]];
+				out[x * 4 + 3] = (u8)t[3];
+			}
+		}
+
+		if (alpha_histogram != nullptr)
+		{
+			for (u32 x = 0; x < width; ++x)
+			{
+				alpha_histogram[out[x * 4 + 3]]++;
+			}
+		}
+	}
+
+	static u32 GetBandSourceRows(Axis const& columns, u64 begin, u64 end)
+	{
+		return columns.first[end - 1] + columns.num_taps - columns.first[begin];
+	}
+
+	// Memory FilterBand() needs for the widest band of the level.
+	static u64 GetScratchSize(LevelTask const* task)
+	{
+		u32 max_band_rows = 0;
+		for (u64 begin = 0; begin < task->dst->height; begin += BAND_ROWS)
+		{
+			max_band_rows = max(max_band_rows, GetBandSourceRows(task->columns, begin, min<u64>(begin + BAND_ROWS, task->dst->height)));
+		}
+
+		u64 const row_bytes = (u64)task->dst->width * 4 * sizeof(f32);
+		return (max_band_rows + 1) * row_bytes + (task->src->width + 1) * 4 * sizeof(f32) + 3 * 32;
+	}
+
+	static void FilterBand(void* user_data, u64 begin, u64 end)
+	{
+		LevelTask const* task = static_cast<LevelTask const*>(user_data);
+		u32 const thread_idx = Jobs::GetThreadIndex();
+
+		Memory::Arena* scratch = &task->thread_scratch[thread_idx];
+		if (scratch->m_memory_block == nullptr)
+		{
+			Memory::InitArena(scratch, task->scratch_size_per_thread);
+		}
+
+		Image::Surface const& src = *task->src;
+		Image::Surface const& dst = *task->dst;
+		u32 const row_floats = dst.width * 4;
+		u32* alpha_histogram = task->alpha_histograms ? task->alpha_histograms + thread_idx * 256 : nullptr;
+
+		// Without workers the whole level comes in one range.
+		for (u64 band_begin = begin; band_begin < end; band_begin += BAND_ROWS)
+		{
+			u64 const band_end = min<u64>(band_begin + BAND_ROWS, end);
+
+			Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch);
+
+			// Source rows under the band's column kernels, filtered horizontally.
+			u32 const band_first = task->columns.first[band_begin];
+			u32 const band_rows = GetBandSourceRows(task->columns, band_begin, band_end);
+			f32* band = Memory::PushType<f32>(scratch, band_rows * row_floats, Memory::AlignPush(32));
+			f32* decoded = Memory::PushType<f32>(scratch, (src.width + 1) * 4, Memory::AlignPush(32));
+			f32* filtered = Memory::PushType<f32>(scratch, row_floats, Memory::AlignPush(32));
+
+			for (u32 row = 0; row < band_rows; ++row)
+			{
+				DecodeRow(task, src.pixels + (u64)(band_first + row) * src.width * 4, src.width, decoded);
+				if (task->use_avx2)
+				{
+					FilterRowAVX2(task->rows, decoded, dst.width, band + (u64)row * row_floats);
+				}
+				else
+				{
+					FilterRowSSE(task->rows, decoded, dst.width, band + (u64)row * row_floats);
+				}
+			}
+
+			for (u64 y = band_begin; y < band_end; ++y)
+			{
+				f32 const* rows = band + (u64)(task->columns.first[y] - band_first) * row_floats;
+				f32 const* weights = task->columns.weights + y * task->columns.stride;
+				if (task->use_avx2)
+				{
+					FilterColumnsAVX2(rows, row_floats, weights, task->columns.num_taps, row_floats, filtered);
+				}
+				else
+				{
+					FilterColumnsSSE(rows, row_floats, weights, task->columns.num_taps, row_floats, filtered);
+				}
+
+				EncodeRow(task, filtered, dst.width, dst.pixels + y * dst.width * 4, alpha_histogram);
+			}
+
+			Memory::RewindTemporaryAlloc(scratch, alloc, false);
+		}
+	}
+
+	// ====================================
+	//  Alpha Coverage
+	// ====================================
+
+	// Share of texels whose alpha, scaled, ends up above the cutoff.
+	static f32 GetCoverage(u32 const* histogram, u64 num_texels, f32 scale, f32 cutoff)
+	{
+		u64 covered = 0;
+		for (u32 a = 0; a < 256; ++a)
+		{
+			covered += (a / 255.0f) * scale > cutoff ? histogram[a] : 0;
+		}
+		return (f32)covered / (f32)num_texels;
+	}
+
+	// Bisection, coverage only grows with the scale.
+	static f32 FindCoverageScale(u32 const* histogram, u64 num_texels, f32 target, f32 cutoff)
+	{
+		f32 lo = 0.0f;
+		f32 hi = 4.0f;
+		for (u32 iteration = 0; iteration < 16; ++iteration)
+		{
+			f32 const mid = (lo + hi) * 0.5f;
+			if (GetCoverage(histogram, num_texels, mid, cutoff) < target)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		return hi;
+	}
+
+	struct ScaleAlphaTask
+	{
+		Image::Surface const* level;
+		u8 remap[256];
+	};
+
+	static void ScaleAlphaRows(void* user_data, u64 begin, u64 end)
+	{
+		ScaleAlphaTask const* task = static_cast<ScaleAlphaTask const*>(user_data);
+		u8* pixels = task->level->pixels + begin * task->level->width * 4;
+		u64 const num_texels = (end - begin) * task->level->width;
+		for (u64 i = 0; i < num_texels; ++i)
+		{
+			pixels[i * 4 + 3] = task->remap[pixels[i * 4 + 3]];
+		}
+	}
+
+	// ====================================
+	//  Chains
+	// ====================================
+
+	u32 GetNumLevels(u32 width, u32 height)
+	{
+		u32 num_levels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = max(width / 2, 1u);
+			height = max(height / 2, 1u);
+			num_levels++;
+		}
+		return num_levels;
+	}
+
+	u32 GetLevelSize(u32 size, u32 level)
+	{
+		return max(size >> level, 1u);
+	}
+
+	u64 GetChainSize(u32 width, u32 height, u32 num_levels)
+	{
+		u64 size = 0;
+		for (u32 level = 0; level < num_levels; ++level)
+		{
+			size += (u64)GetLevelSize(width, level) * GetLevelSize(height, level) * 4;
+		}
+		return size;
+	}
+
+	static void FreeThreadScratch(Memory::Arena* thread_scratch)
+	{
+		for (u32 thread_idx = 0; thread_idx < Jobs::MAX_THREADS; ++thread_idx)
+		{
+			if (thread_scratch[thread_idx].m_memory_block != nullptr)
+			{
+				Memory::FreeArena(&thread_scratch[thread_idx]);
+			}
+		}
+	}
+
+	void Generate(Image::Surface* levels, u32 num_levels, Settings const& settings, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_levels > 0 && num_levels <= GetNumLevels(levels[0].width, levels[0].height));
+		if (num_levels == 1)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		ColorTables const& tables = GetColorTables();
+		bool const b_srgb = (settings.flags & MipFlags::SRGB) != 0;
+		bool const b_coverage = (settings.flags & MipFlags::PreserveAlphaCoverage) != 0;
+
+		Simd::CpuFeatures const& features = Simd::GetCpuFeatures();
+
+		LevelTask task;
+		task.color_to_linear = b_srgb ? tables.srgb_to_linear : tables.unorm_to_linear;
+		task.alpha_to_linear = tables.unorm_to_linear;
+		task.linear_to_srgb = b_srgb ? tables.linear_to_srgb : nullptr;
+		task.use_avx2 = features.avx2 && features.fma;
+		task.thread_scratch = Memory::PushType<Memory::Arena>(scratch_memory, Jobs::MAX_THREADS, Memory::ZeroPush());
+		task.alpha_histograms = b_coverage ? Memory::PushType<u32>(scratch_memory, Jobs::MAX_THREADS * 256) : nullptr;
+
+		task.scratch_size_per_thread = 0;
+
+		f32 coverage = 0.0f;
+		if (b_coverage)
+		{
+			u32 histogram[256] = {};
+			u64 const num_texels = (u64)levels[0].width * levels[0].height;
+			for (u64 i = 0; i < num_texels; ++i)
+			{
+				histogram[levels[0].pixels[i * 4 + 3]]++;
+			}
+			coverage = GetCoverage(histogram, num_texels, 1.0f, settings.alpha_cutoff);
+		}
+
+		u8* pixels = levels[0].pixels + (u64)levels[0].width * levels[0].height * 4;
+		for (u32 level = 1; level < num_levels; ++level)
+		{
+			Image::Surface& dst = levels[level];
+			dst.width = GetLevelSize(levels[0].width, level);
+			dst.height = GetLevelSize(levels[0].height, level);
+			dst.pixels = pixels;
+			pixels += (u64)dst.width * dst.height * 4;
+
+			Memory::TemporaryAllocation level_alloc = Memory::BeginTemporaryAlloc(scratch_memory);
+
+			task.src = &levels[level - 1];
+			task.dst = &dst;
+			task.rows = BuildAxis(task.src->width, dst.width, settings.filter, true, scratch_memory);
+			task.columns = BuildAxis(task.src->height, dst.height, settings.filter, false, scratch_memory);
+			// Usually level 1 needs the most, the thread arenas only grow if a later level needs more.
+			u64 const scratch_size = GetScratchSize(&task);
+			if (scratch_size > task.scratch_size_per_thread)
+			{
+				FreeThreadScratch(task.thread_scratch);
+				task.scratch_size_per_thread = scratch_size;
+			}
+
+			if (b_coverage)
+			{
+				memset(task.alpha_histograms, 0, sizeof(u32) * Jobs::MAX_THREADS * 256);
+			}
+
+			Jobs::ParallelFor(dst.height, BAND_ROWS, &FilterBand, &task);
+
+			if (b_coverage)
+			{
+				u32 histogram[256] = {};
+				for (u32 thread_idx = 0; thread_idx < Jobs::MAX_THREADS; ++thread_idx)
+				{
+					for (u32 a = 0; a < 256; ++a)
+					{
+						histogram[a] += task.alpha_histograms[thread_idx * 256 + a];
+					}
+				}
+
+				u64 const num_texels = (u64)dst.width * dst.height;
+				f32 const scale = FindCoverageScale(histogram, num_texels, coverage, settings.alpha_cutoff);
+
+				ScaleAlphaTask scale_task;
+				scale_task.level = &dst;
+				for (u32 a = 0; a < 256; ++a)
+				{
+					scale_task.remap[a] = (u8)min(a * scale + 0.5f, 255.0f);
+				}
+				Jobs::ParallelFor(dst.height, BAND_ROWS * 4, &ScaleAlphaRows, &scale_task);
+			}
+
+			Memory::RewindTemporaryAlloc(scratch_memory, level_alloc, false);
+		}
+
+		FreeThreadScratch(task.thread_scratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Core.h"
+#include "ImageDecode.h"
+#include "Memory.h"
+
+// ====================================
+//  Mip Chain Generation
+//  Notes:
+//  *) CPU side ResourceFlags::GenerateMips for RGBA8 surfaces. Every
+//     level is filtered from the one above it, with a separable
+//     filter that is stretched to the size ratio, so odd (non power
+//     of two) sizes are resampled instead of dropping texels. Edges
+//     are clamped.
+//  *) Filtering happens on linear floats. sRGB color is decoded
+//     first and encoded again afterwards, alpha is always linear.
+//  *) Alpha coverage (the share of texels above the alpha test
+//     cutoff) can be kept the same on every level by scaling alpha,
+//     see Castano, "Computing Alpha Mipmaps" (2010). Otherwise
+//     alpha tested foliage thins out in the distance.
+//  *) Jobs filter bands of output rows, the filter kernels are AVX2
+//     and FMA when available and SSE4.1 otherwise.
+// ====================================
+
+namespace MipGeneration
+{
+	struct Filter
+	{
+		enum Enum : u32
+		{
+			// Area average, the classic 2x2 average for even sizes. Fastest, but blurs and aliases.
+			Box,
+
+			// Kaiser windowed sinc, 3 texels wide with alpha 4. Sharp with little ringing.
+			Kaiser,
+
+			// Lanczos windowed sinc, 3 lobes. Sharpest, rings a bit more on hard edges.
+			Lanczos,
+		};
+	};
+
+	struct MipFlags
+	{
+		enum Enum : u32
+		{
+			None = 0,
+
+			// RGB is sRGB encoded, filter it in linear space.
+			SRGB = 1 << 0,
+
+			// Scale alpha per level to keep the coverage of level 0 at Settings::alpha_cutoff.
+			PreserveAlphaCoverage = 1 << 1,
+		};
+	};
+
+	struct Settings
+	{
+		Filter::Enum filter;
+		u32 flags;
+
+		// Alpha test reference in [0, 1], only used with MipFlags::PreserveAlphaCoverage.
+		f32 alpha_cutoff;
+	};
+
+	// Levels of a full chain, down to 1x1.
+	u32 GetNumLevels(u32 width, u32 height);
+
+	// Size of a level, halved and rounded down per level, but at least 1.
+	u32 GetLevelSize(u32 size, u32 level);
+
+	// Bytes of num_levels RGBA8 levels, including level 0.
+	u64 GetChainSize(u32 width, u32 height, u32 num_levels);
+
+	// levels[0] is the source, its pixels have to point to GetChainSize() bytes, the other levels
+	// are written behind it and get their surfaces set up here. scratch_memory holds the filter
+	// weights, the jobs bring their own memory. Blocks until all levels are done.
+	void Generate(Image::Surface* levels, u32 num_levels, Settings const& settings, Memory::Arena* scratch_memory);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "MipGeneration.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+#include <math.h>
+
+namespace MipGeneration
+{
+namespace Test
+{
+	struct Chain
+	{
+		Image::Surface levels[16];
+		u32 num_levels;
+		u8* pixels;
+	};
+
+	static void InitChain(Chain* chain, u8 const* level0, u32 width, u32 height)
+	{
+		chain->num_levels = GetNumLevels(width, height);
+		chain->pixels = new u8[GetChainSize(width, height, chain->num_levels)];
+		memcpy(chain->pixels, level0, (u64)width * height * 4);
+		chain->levels[0] = { chain->pixels, width, height };
+	}
+
+	static void GenerateChain(Chain* chain, Settings const& settings)
+	{
+		Memory::Arena scratch;
+		Memory::InitArena(&scratch, Megabyte(16));
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch));
+		Generate(chain->levels, chain->num_levels, settings, &scratch);
+	}
+
+	static f32 SrgbToLinear(u8 value)
+	{
+		f32 const v = value / 255.0f;
+		return v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static u8 LinearToSrgb(f32 v)
+	{
+		f32 const srgb = v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+		return (u8)(Clamp(srgb, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	void LevelSizes()
+	{
+		ASSERT(GetNumLevels(1, 1) == 1);
+		ASSERT(GetNumLevels(256, 64) == 9);
+		ASSERT(GetNumLevels(5, 3) == 3);
+		ASSERT(GetNumLevels(1, 1000) == 10);
+
+		ASSERT(GetLevelSize(5, 1) == 2 && GetLevelSize(5, 2) == 1 && GetLevelSize(5, 7) == 1);
+		ASSERT(GetChainSize(4, 2, 3) == (8 + 2 + 1) * 4);
+	}
+
+	// Even sizes halve exactly, so the box filter is the plain 2x2 average of the level above,
+	// in linear space for sRGB color. Every level is checked against the scalar reference of the level above it.
+	void BoxMatchesScalar()
+	{
+		static constexpr u32 SIZE = 64;
+		u8* level0 = new u8[SIZE * SIZE * 4];
+		ON_SCOPE_EXIT(delete[] level0);
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < SIZE * SIZE * 4; ++i)
+		{
+			level0[i] = (u8)random.Next();
+		}
+
+		for (u32 flags : { (u32)MipFlags::None, (u32)MipFlags::SRGB })
+		{
+			Simd::ForEachDispatchPath([&]()
+			{
+				Chain chain;
+				InitChain(&chain, level0, SIZE, SIZE);
+				ON_SCOPE_EXIT(delete[] chain.pixels);
+				GenerateChain(&chain, { Filter::Box, flags, 0.5f });
+
+				for (u32 level = 1; level < chain.num_levels; ++level)
+				{
+					Image::Surface const& src = chain.levels[level - 1];
+					Image::Surface const& dst = chain.levels[level];
+					ASSERT(dst.width == src.width / 2 && dst.height == src.height / 2);
+
+					for (u32 y = 0; y < dst.height; ++y)
+					{
+						for (u32 x = 0; x < dst.width; ++x)
+						{
+							for (u32 c = 0; c < 4; ++c)
+							{
+								bool const b_srgb = flags == MipFlags::SRGB && c < 3;
+								f32 sum = 0.0f;
+								for (u32 i = 0; i < 4; ++i)
+								{
+									u8 const value = src.pixels[((y * 2 + i / 2) * src.width + x * 2 + i % 2) * 4 + c];
+									sum += b_srgb ? SrgbToLinear(value) : value / 255.0f;
+								}
+
+								f32 const average = sum * 0.25f;
+								s32 const expected = b_srgb ? LinearToSrgb(average) : (s32)(average * 255.0f + 0.5f);
+								ASSERT(abs(dst.pixels[(y * dst.width + x) * 4 + c] - expected) <= 1);
+							}
+						}
+					}
+				}
+			});
+		}
+
+		// Black and white average to the middle of linear light, not of the encoding.
+		u8 const black_white[4 * 4] = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 };
+		Chain chain;
+		InitChain(&chain, black_white, 2, 2);
+		ON_SCOPE_EXIT(delete[] chain.pixels);
+		GenerateChain(&chain, { Filter::Box, MipFlags::SRGB, 0.5f });
+		u8 const expected[4] = { 188, 188, 188, 255 };
+		ASSERT(memcmp(chain.levels[1].pixels, expected, 4) == 0);
+	}
+
+	// The weights of every filter add up to 1, also where taps are clamped at the edges and for odd sizes.
+	void ConstantStaysConstant()
+	{
+		static constexpr u32 WIDTH = 37;
+		static constexpr u32 HEIGHT = 23;
+		u8 level0[WIDTH * HEIGHT * 4];
+		u8 const color[4] = { 17, 128, 240, 99 };
+		for (u32 i = 0; i < WIDTH * HEIGHT; ++i)
+		{
+			memcpy(level0 + i * 4, color, 4);
+		}
+
+		for (Filter::Enum filter : { Filter::Box, Filter::Kaiser, Filter::Lanczos })
+		{
+			for (u32 flags : { (u32)MipFlags::None, (u32)MipFlags::SRGB })
+			{
+				Chain chain;
+				InitChain(&chain, level0, WIDTH, HEIGHT);
+				ON_SCOPE_EXIT(delete[] chain.pixels);
+				GenerateChain(&chain, { filter, flags, 0.5f });
+
+				for (u32 level = 1; level < chain.num_levels; ++level)
+				{
+					Image::Surface const& surface = chain.levels[level];
+					for (u32 i = 0; i < surface.width * surface.height * 4; ++i)
+					{
+						ASSERT(abs(surface.pixels[i] - color[i % 4]) <= 1);
+					}
+				}
+			}
+		}
+	}
+
+	// The AVX2 kernels pair taps and use FMA, so they only round differently from the SSE ones.
+	void DispatchPathsAgree()
+	{
+		static constexpr u32 WIDTH = 75;
+		static constexpr u32 HEIGHT = 41;
+		u8* level0 = new u8[WIDTH * HEIGHT * 4];
+		ON_SCOPE_EXIT(delete[] level0);
+
+		TestUtils::Random random;
+		TestUtils::FillImage(level0, WIDTH, HEIGHT, false, random);
+
+		u64 const chain_size = GetChainSize(WIDTH, HEIGHT, GetNumLevels(WIDTH, HEIGHT));
+		u8* baseline = new u8[chain_size];
+		ON_SCOPE_EXIT(delete[] baseline);
+
+		for (Filter::Enum filter : { Filter::Box, Filter::Kaiser, Filter::Lanczos })
+		{
+			bool b_first_path = true;
+			Simd::ForEachDispatchPath([&]()
+			{
+				Chain chain;
+				InitChain(&chain, level0, WIDTH, HEIGHT);
+				ON_SCOPE_EXIT(delete[] chain.pixels);
+				GenerateChain(&chain, { filter, MipFlags::SRGB, 0.5f });
+
+				if (b_first_path)
+				{
+					memcpy(baseline, chain.pixels, chain_size);
+					b_first_path = false;
+					return;
+				}
+
+				for (u64 i = 0; i < chain_size; ++i)
+				{
+					ASSERT(abs(chain.pixels[i] - baseline[i]) <= 1);
+				}
+			});
+		}
+	}
+
+	// A noisy alpha tested image, 30% opaque and the rest well below the cutoff. Without scaling the
+	// averages sink below the cutoff and the coverage goes towards 0, with it every level stays close to level 0.
+	void AlphaCoveragePreserved()
+	{
+		static constexpr u32 SIZE = 128;
+		static constexpr f32 CUTOFF = 0.5f;
+		u8* level0 = new u8[SIZE * SIZE * 4];
+		ON_SCOPE_EXIT(delete[] level0);
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < SIZE * SIZE; ++i)
+		{
+			level0[i * 4 + 0] = level0[i * 4 + 1] = level0[i * 4 + 2] = 200;
+			level0[i * 4 + 3] = random.Index(10) < 3 ? 255 : (u8)random.Index(100);
+		}
+
+		auto coverage = [](Image::Surface const& surface)
+		{
+			u32 covered = 0;
+			for (u32 i = 0; i < surface.width * surface.height; ++i)
+			{
+				covered += surface.pixels[i * 4 + 3] / 255.0f > CUTOFF ? 1 : 0;
+			}
+			return covered / (f32)(surface.width * surface.height);
+		};
+
+		Chain plain;
+		Chain preserved;
+		InitChain(&plain, level0, SIZE, SIZE);
+		InitChain(&preserved, level0, SIZE, SIZE);
+		ON_SCOPE_EXIT(delete[] plain.pixels; delete[] preserved.pixels);
+		GenerateChain(&plain, { Filter::Box, MipFlags::None, CUTOFF });
+		GenerateChain(&preserved, { Filter::Box, MipFlags::PreserveAlphaCoverage, CUTOFF });
+
+		f32 const target = coverage(preserved.levels[0]);
+		for (u32 level = 1; level < 5; ++level)
+		{
+			ASSERT(level < 3 || coverage(plain.levels[level]) < target * 0.5f);
+			ASSERT(fabsf(coverage(preserved.levels[level]) - target) < 0.03f);
+		}
+	}
+
+	void Run()
+	{
+		LevelSizes();
+		BoxMatchesScalar();
+		ConstantStaysConstant();
+		DispatchPathsAgree();
+		AlphaCoveragePreserved();
+	}
+}
+}
@@ -0,0 +1,258 @@
+#include "Morph.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+namespace Morph
+{
+	// Vertices that share one accumulator, small enough that it stays in L1.
+	static constexpr u32 BLOCK_VERTICES = 1024;
+	static constexpr u32 BLOCK_CHUNKS = BLOCK_VERTICES / CHUNK_VERTICES;
+
+	static constexpr u64 PARALLEL_BATCH_SIZE = 4 * BLOCK_VERTICES;
+
+	struct BlendTask
+	{
+		Gfx::Position_t* out_positions;
+		Gfx::Normal_t* out_normals;
+		Gfx::Position_t const* positions;
+		Gfx::Normal_t const* normals;
+		TargetLibrary const* library;
+		TargetSet set;
+		f32 const* weights;
+	};
+
+	// First chunk of a target at or after the vertex, chunk offsets are ascending.
+	static u32 FindChunk(u32 const* offsets, u32 num_chunks, u32 vertex)
+	{
+		u32 first = 0;
+		u32 count = num_chunks;
+		while (count > 0)
+		{
+			u32 const half = count / 2;
+			if (offsets[first + half] < vertex)
+			{
+				first += half + 1;
+				count -= half + 1;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+		return first;
+	}
+
+	// Adds the weighted deltas of every target to the chunks of the block, ACCUMULATE(acc, chunk, weight)
+	// does one chunk.
+	template <void (*ACCUMULATE)(DeltaChunk*, DeltaChunk const*, f32)>
+	static void AccumulateBlock(DeltaChunk* acc, BlendTask const* task, u32 block_begin, u32 block_end)
+	{
+		TargetLibrary const* library = task->library;
+		for (u32 target_idx = 0; target_idx < task->set.num_targets; ++target_idx)
+		{
+			f32 const weight = task->weights[target_idx];
+			if (weight == 0.0f)
+			{
+				continue;
+			}
+
+			Target const& target = library->targets[task->set.first_target + target_idx];
+			u32 const* offsets = library->chunk_offsets + target.first_chunk;
+			DeltaChunk const* chunks = library->chunks + target.first_chunk;
+
+			for (u32 i = FindChunk(offsets, target.num_chunks, block_begin); i < target.num_chunks && offsets[i] < block_end; ++i)
+			{
+				ACCUMULATE(&acc[(offsets[i] - block_begin) / CHUNK_VERTICES], &chunks[i], weight);
+			}
+		}
+	}
+
+	// Vertices past the last full chunk of the set.
+	template <bool HAS_NORMALS>
+	static void FinishTail(BlendTask const* task, DeltaChunk const& acc, u32 vertex, u32 count)
+	{
+		for (u32 i = 0; i < count; ++i)
+		{
+			vec3 const& p = task->positions[vertex + i];
+			task->out_positions[vertex + i] = vec3(p.x + acc.positions[0][i], p.y + acc.positions[1][i], p.z + acc.positions[2][i]);
+
+			if (HAS_NORMALS)
+			{
+				vec3 const& n = task->normals[vertex + i];
+				vec3 const sum(n.x + acc.normals[0][i], n.y + acc.normals[1][i], n.z + acc.normals[2][i]);
+				f32 const inv_length = 1.0f / sqrtf(max(Math::Dot(sum, sum), 1e-30f));
+				task->out_normals[vertex + i] = vec3(sum.x * inv_length, sum.y * inv_length, sum.z * inv_length);
+			}
+		}
+	}
+
+	// ====================================
+	//  4 Wide (SSE4.1)
+	// ====================================
+
+	static void AccumulateChunkSSE(DeltaChunk* acc, DeltaChunk const* chunk, f32 weight)
+	{
+		__m128 const w = _mm_set1_ps(weight);
+		f32* dst = &acc->positions[0][0];
+		f32 const* src = &chunk->positions[0][0];
+		for (u32 i = 0; i < sizeof(DeltaChunk) / sizeof(f32); i += 4)
+		{
+			_mm_store_ps(dst + i, _mm_add_ps(_mm_load_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+		}
+	}
+
+	template <bool HAS_NORMALS>
+	static void BlendBlockSSE(BlendTask const* task, u32 block_begin, u32 block_end)
+	{
+		alignas(32) DeltaChunk acc[BLOCK_CHUNKS];
+		u32 const num_chunks = (block_end - block_begin + CHUNK_VERTICES - 1) / CHUNK_VERTICES;
+		memset(acc, 0, num_chunks * sizeof(DeltaChunk));
+
+		AccumulateBlock<&AccumulateChunkSSE>(acc, task, block_begin, block_end);
+
+		for (u32 chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+		{
+			u32 const vertex = block_begin + chunk_idx * CHUNK_VERTICES;
+			DeltaChunk const& deltas = acc[chunk_idx];
+			if (vertex + CHUNK_VERTICES > block_end)
+			{
+				FinishTail<HAS_NORMALS>(task, deltas, vertex, block_end - vertex);
+				break;
+			}
+
+			for (u32 half = 0; half < CHUNK_VERTICES; half += 4)
+			{
+				__m128 x, y, z;
+				Simd::LoadVec3x4(task->positions + vertex + half, x, y, z);
+				x = _mm_add_ps(x, _mm_load_ps(&deltas.positions[0][half]));
+				y = _mm_add_ps(y, _mm_load_ps(&deltas.positions[1][half]));
+				z = _mm_add_ps(z, _mm_load_ps(&deltas.positions[2][half]));
+				Simd::StoreVec3x4(task->out_positions + vertex + half, x, y, z);
+
+				if (HAS_NORMALS)
+				{
+					Simd::LoadVec3x4(task->normals + vertex + half, x, y, z);
+					x = _mm_add_ps(x, _mm_load_ps(&deltas.normals[0][half]));
+					y = _mm_add_ps(y, _mm_load_ps(&deltas.normals[1][half]));
+					z = _mm_add_ps(z, _mm_load_ps(&deltas.normals[2][half]));
+
+					__m128 const length_sq = _mm_add_ps(_mm_mul_ps(x, x), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+					__m128 const inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(length_sq, _mm_set1_ps(1e-30f))));
+					Simd::StoreVec3x4(task->out_normals + vertex + half, _mm_mul_ps(x, inv_length), _mm_mul_ps(y, inv_length), _mm_mul_ps(z, inv_length));
+				}
+			}
+		}
+	}
+
+	// ====================================
+	//  8 Wide (AVX2)
+	// ====================================
+
+	static SIMD_INLINE_AVX2 void AccumulateChunkAVX2(DeltaChunk* acc, DeltaChunk const* chunk, f32 weight)
+	{
+		__m256 const w = _mm256_set1_ps(weight);
+		f32* dst = &acc->positions[0][0];
+		f32 const* src = &chunk->positions[0][0];
+		for (u32 i = 0; i < sizeof(DeltaChunk) / sizeof(f32); i += 8)
+		{
+			_mm256_store_ps(dst + i, _mm256_fmadd_ps(w, _mm256_loadu_ps(src + i), _mm256_load_ps(dst + i)));
+		}
+	}
+
+	template <bool HAS_NORMALS>
+	static SIMD_TARGET_AVX2 void BlendBlockAVX2(BlendTask const* task, u32 block_begin, u32 block_end)
+	{
+		alignas(32) DeltaChunk acc[BLOCK_CHUNKS];
+		u32 const num_chunks = (block_end - block_begin + CHUNK_VERTICES - 1) / CHUNK_VERTICES;
+		memset(acc, 0, num_chunks * sizeof(DeltaChunk));
+
+		AccumulateBlock<&AccumulateChunkAVX2>(acc, task, block_begin, block_end);
+
+		for (u32 chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+		{
+			u32 const vertex = block_begin + chunk_idx * CHUNK_VERTICES;
+			DeltaChunk const& deltas = acc[chunk_idx];
+			if (vertex + CHUNK_VERTICES > block_end)
+			{
+				FinishTail<HAS_NORMALS>(task, deltas, vertex, block_end - vertex);
+				break;
+			}
+
+			__m256 x, y, z;
+			Simd::LoadVec3x8(task->positions + vertex, x, y, z);
+			x = _mm256_add_ps(x, _mm256_load_ps(deltas.positions[0]));
+			y = _mm256_add_ps(y, _mm256_load_ps(deltas.positions[1]));
+			z = _mm256_add_ps(z, _mm256_load_ps(deltas.positions[2]));
+			Simd::StoreVec3x8(task->out_positions + vertex, x, y, z);
+
+			if (HAS_NORMALS)
+			{
+				Simd::LoadVec3x8(task->normals + vertex, x, y, z);
+				x = _mm256_add_ps(x, _mm256_load_ps(deltas.normals[0]));
+				y = _mm256_add_ps(y, _mm256_load_ps(deltas.normals[1]));
+				z = _mm256_add_ps(z, _mm256_load_ps(deltas.normals[2]));
+				Simd::NormalizeVec3x8(x, y, z);
+				Simd::StoreVec3x8(task->out_normals + vertex, x, y, z);
+			}
+		}
+	}
+
+	// ====================================
+	//  Jobs
+	// ====================================
+
+	typedef void (*BlendBlockFunc)(BlendTask const* task, u32 block_begin, u32 block_end);
+
+	struct BlendJob
+	{
+		BlendTask task;
+		BlendBlockFunc func;
+	};
+
+	// Batches are multiples of the block size, so blocks never straddle two of them.
+	static void BlendBatch(void* user_data, u64 begin, u64 end)
+	{
+		BlendJob const* job = static_cast<BlendJob const*>(user_data);
+		for (u64 block_begin = begin; block_begin < end; block_begin += BLOCK_VERTICES)
+		{
+			job->func(&job->task, (u32)block_begin, (u32)min(block_begin + BLOCK_VERTICES, end));
+		}
+	}
+
+	void Blend(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, Gfx::Position_t const* positions,
+		Gfx::Normal_t const* normals, TargetLibrary const* library, u32 set, f32 const* weights)
+	{
+		ASSERT(set < library->num_sets);
+
+		Simd::CpuFeatures const& features = Simd::GetCpuFeatures();
+		bool const use_avx2 = features.avx2 && features.fma;
+		bool const has_normals = normals != nullptr && out_normals != nullptr;
+
+		BlendJob job;
+		job.task.out_positions = out_positions;
+		job.task.out_normals = out_normals;
+		job.task.positions = positions;
+		job.task.normals = normals;
+		job.task.library = library;
+		job.task.set = library->sets[set];
+		job.task.weights = weights;
+
+		if (use_avx2)
+		{
+			job.func = has_normals ? &BlendBlockAVX2<true> : &BlendBlockAVX2<false>;
+		}
+		else
+		{
+			job.func = has_normals ? &BlendBlockSSE<true> : &BlendBlockSSE<false>;
+		}
+
+		u32 const num_vertices = job.task.set.num_vertices;
+		if (num_vertices < PARALLEL_MIN_VERTICES || Jobs::GetThreadCount() == 1)
+		{
+			BlendBatch(&job, 0, num_vertices);
+			return;
+		}
+
+		Jobs::ParallelFor(num_vertices, PARALLEL_BATCH_SIZE, &BlendBatch, &job);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "Math.h"
+
+// ====================================
+//  Morph Targets
+//  Notes:
+//  *) Blend shapes of glTF meshes, the posed vertices are the base
+//     vertices plus the weighted position and normal deltas of
+//     every target. Tangent deltas are not imported.
+//  *) Deltas are sparse: a target only keeps the chunks of 8
+//     vertices that have a non-zero delta, a facial expression
+//     usually touches a small part of the head.
+//  *) Chunks are SoA, so blending is 8 wide FMAs without any
+//     shuffles. Targets with a zero weight are skipped.
+//  *) Large sets are split into ranges of vertices on the job
+//     system, the kernels are AVX2 and FMA when available and
+//     SSE4.1 otherwise.
+// ====================================
+
+namespace Morph
+{
+	static constexpr u32 CHUNK_VERTICES = 8;
+
+	// Deltas of 8 consecutive vertices, x, y and z in separate rows.
+	struct DeltaChunk
+	{
+		f32 positions[3][CHUNK_VERTICES];
+		f32 normals[3][CHUNK_VERTICES];
+	};
+
+	struct Target
+	{
+		u32 first_chunk;
+		u32 num_chunks;
+
+		// glTF mesh weight, the pose without animation.
+		f32 default_weight;
+	};
+
+	// Targets of one glTF mesh, over the vertices of all its submeshes.
+	struct TargetSet
+	{
+		u32 first_vertex;
+		u32 num_vertices;
+
+		u32 first_target;
+		u32 num_targets;
+	};
+
+	// All morph targets of an import. Sets are referenced by Gfx::MeshInstance::morph, and are ranges of
+	// the targets, targets are ranges of the chunks.
+	struct TargetLibrary
+	{
+		TargetSet* sets;
+		u32 num_sets;
+
+		Target* targets;
+		u32 num_targets;
+
+		// First vertex of every chunk relative to its set, a multiple of CHUNK_VERTICES and ascending per target.
+		u32* chunk_offsets;
+		DeltaChunk* chunks;
+		u32 num_chunks;
+	};
+
+	// Below this many vertices a set is blended on the calling thread.
+	static constexpr u32 PARALLEL_MIN_VERTICES = 8 * 1024;
+
+	// Writes the posed vertices of a set, one per vertex of the set. positions and normals are the full precision
+	// base vertices of the set, e.g. the streams of a MeshImport from set.first_vertex on, and may not alias the
+	// outputs. Normals are optional and normalized after blending. weights has one entry per target of the set.
+	// Blocks until all vertices are done.
+	void Blend(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, Gfx::Position_t const* positions,
+		Gfx::Normal_t const* normals, TargetLibrary const* library, u32 set, f32 const* weights);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
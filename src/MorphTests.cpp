@@ -0,0 +1,231 @@
+#include "Memory.h"
+#include "Morph.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+namespace Morph
+{
+namespace Test
+{
+	static constexpr u32 NUM_TARGETS = 4;
+	static constexpr f32 GUARD = 12345.0f;
+
+	// Sizes around the chunk, block and parallel thresholds, every set but the first ends in a partial chunk.
+	static constexpr u32 SET_SIZES[] = { 8, 5, 37, 1029, 2 * 1024 + 8, PARALLEL_MIN_VERTICES + 21 };
+	static constexpr u32 NUM_SETS = ARRAY_SIZE(SET_SIZES);
+
+	// Library plus the dense deltas it was built from, for the scalar reference.
+	struct Fixture
+	{
+		TargetLibrary library;
+		Gfx::Position_t* positions;
+		Gfx::Normal_t* normals;
+		vec3* position_deltas; // NUM_TARGETS per vertex.
+		vec3* normal_deltas;
+		u32 num_vertices;
+	};
+
+	// Every target keeps about a third of its chunks, the others are zero. Every 11th base normal is zero.
+	static void InitFixture(Fixture* fixture, Memory::Arena* arena, TestUtils::Random& random)
+	{
+		u32 num_vertices = 0;
+		u32 max_chunks = 0;
+		for (u32 size : SET_SIZES)
+		{
+			num_vertices += size;
+			max_chunks += (size + CHUNK_VERTICES - 1) / CHUNK_VERTICES * NUM_TARGETS;
+		}
+
+		fixture->num_vertices = num_vertices;
+		fixture->positions = Memory::PushType<Gfx::Position_t>(arena, num_vertices);
+		fixture->normals = Memory::PushType<Gfx::Normal_t>(arena, num_vertices);
+		fixture->position_deltas = Memory::PushType<vec3>(arena, num_vertices * NUM_TARGETS, Memory::ZeroPush());
+		fixture->normal_deltas = Memory::PushType<vec3>(arena, num_vertices * NUM_TARGETS, Memory::ZeroPush());
+
+		for (u32 i = 0; i < num_vertices; ++i)
+		{
+			fixture->positions[i] = vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+			vec3 const normal(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(1.0f, 2.0f));
+			fixture->normals[i] = (i % 11 == 0) ? vec3(0.0f, 0.0f, 0.0f) : Math::Normalize(normal);
+		}
+
+		TargetLibrary& library = fixture->library;
+		library.num_sets = NUM_SETS;
+		library.sets = Memory::PushType<TargetSet>(arena, NUM_SETS);
+		library.num_targets = NUM_SETS * NUM_TARGETS;
+		library.targets = Memory::PushType<Target>(arena, library.num_targets);
+		library.chunk_offsets = Memory::PushType<u32>(arena, max_chunks);
+		library.chunks = Memory::PushType<DeltaChunk>(arena, max_chunks, Memory::ZeroAndAlignPush(32));
+		library.num_chunks = 0;
+
+		u32 first_vertex = 0;
+		for (u32 set_idx = 0; set_idx < NUM_SETS; ++set_idx)
+		{
+			TargetSet& set = library.sets[set_idx];
+			set = { first_vertex, SET_SIZES[set_idx], set_idx * NUM_TARGETS, NUM_TARGETS };
+
+			for (u32 target_idx = 0; target_idx < NUM_TARGETS; ++target_idx)
+			{
+				Target& target = library.targets[set.first_target + target_idx];
+				target = { library.num_chunks, 0, 0.0f };
+
+				for (u32 offset = 0; offset < set.num_vertices; offset += CHUNK_VERTICES)
+				{
+					if (random.Index(3) != 0)
+					{
+						continue;
+					}
+
+					library.chunk_offsets[library.num_chunks] = offset;
+					DeltaChunk& chunk = library.chunks[library.num_chunks++];
+					++target.num_chunks;
+
+					// The part of the last chunk past the set stays zero.
+					for (u32 i = 0; i < min(CHUNK_VERTICES, set.num_vertices - offset); ++i)
+					{
+						u32 const vertex = first_vertex + offset + i;
+						vec3& dp = fixture->position_deltas[vertex * NUM_TARGETS + target_idx];
+						vec3& dn = fixture->normal_deltas[vertex * NUM_TARGETS + target_idx];
+						dp = vec3(random.Float(-0.5f, 0.5f), random.Float(-0.5f, 0.5f), random.Float(-0.5f, 0.5f));
+						dn = vec3(random.Float(-0.3f, 0.3f), random.Float(-0.3f, 0.3f), random.Float(-0.3f, 0.3f));
+						for (u32 c = 0; c < 3; ++c)
+						{
+							chunk.positions[c][i] = dp.data[c];
+							chunk.normals[c][i] = dn.data[c];
+						}
+					}
+				}
+			}
+			first_vertex += set.num_vertices;
+		}
+	}
+
+	static bool Near(vec3 a, vec3 b)
+	{
+		for (u32 i = 0; i < 3; ++i)
+		{
+			if (fabsf(a.data[i] - b.data[i]) > 1e-5f * (1.0f + fabsf(b.data[i])))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Scalar reference over the dense deltas. Zero normals stay zero, like in the kernels.
+	static void BlendScalar(vec3* out_p, vec3* out_n, Fixture const& fixture, u32 vertex, f32 const* weights)
+	{
+		vec3 p = fixture.positions[vertex];
+		vec3 n = fixture.normals[vertex];
+		for (u32 t = 0; t < NUM_TARGETS; ++t)
+		{
+			vec3 const& dp = fixture.position_deltas[vertex * NUM_TARGETS + t];
+			vec3 const& dn = fixture.normal_deltas[vertex * NUM_TARGETS + t];
+			p = vec3(p.x + weights[t] * dp.x, p.y + weights[t] * dp.y, p.z + weights[t] * dp.z);
+			n = vec3(n.x + weights[t] * dn.x, n.y + weights[t] * dn.y, n.z + weights[t] * dn.z);
+		}
+
+		f32 const length = Math::Length(n);
+		*out_p = p;
+		*out_n = length > 0.0f ? vec3(n.x / length, n.y / length, n.z / length) : n;
+	}
+
+	// Both dispatch paths against the scalar reference, with and without normals. The outputs of a set
+	// have a guard vertex past the end, the kernels may not write past the set.
+	void BlendMatchesScalar()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(16));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestUtils::Random random;
+		Fixture fixture;
+		InitFixture(&fixture, &arena, random);
+
+		vec3* out_positions = Memory::PushType<vec3>(&arena, fixture.num_vertices + 1);
+		vec3* out_normals = Memory::PushType<vec3>(&arena, fixture.num_vertices + 1);
+
+		// A zero weight skips its target, negative weights are valid.
+		f32 const weight_sets[][NUM_TARGETS] =
+		{
+			{ 0.0f, 0.0f, 0.0f, 0.0f },
+			{ 1.0f, 0.0f, 0.0f, 0.0f },
+			{ 0.25f, 0.0f, -0.7f, 1.3f },
+			{ 0.6f, 0.9f, 0.1f, -0.2f },
+		};
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			for (u32 set_idx = 0; set_idx < NUM_SETS; ++set_idx)
+			{
+				TargetSet const& set = fixture.library.sets[set_idx];
+				for (f32 const* weights : weight_sets)
+				{
+					for (bool b_normals : { true, false })
+					{
+						for (u32 i = 0; i <= set.num_vertices; ++i)
+						{
+							out_positions[i] = out_normals[i] = vec3(GUARD, GUARD, GUARD);
+						}
+
+						Blend(out_positions, b_normals ? out_normals : nullptr, fixture.positions + set.first_vertex,
+							b_normals ? fixture.normals + set.first_vertex : nullptr, &fixture.library, set_idx, weights);
+
+						for (u32 i = 0; i < set.num_vertices; ++i)
+						{
+							vec3 expected_p, expected_n;
+							BlendScalar(&expected_p, &expected_n, fixture, set.first_vertex + i, weights);
+							ASSERT(Near(out_positions[i], expected_p));
+							ASSERT(b_normals ? Near(out_normals[i], expected_n) : out_normals[i].x == GUARD);
+						}
+						ASSERT(out_positions[set.num_vertices].x == GUARD && out_positions[set.num_vertices].z == GUARD);
+						ASSERT(out_normals[set.num_vertices].x == GUARD && out_normals[set.num_vertices].z == GUARD);
+					}
+				}
+			}
+		});
+	}
+
+	// The AVX2 kernels use FMA, so they may only round differently from the SSE ones.
+	void DispatchPathsAgree()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(16));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestUtils::Random random;
+		Fixture fixture;
+		InitFixture(&fixture, &arena, random);
+
+		u32 const set_idx = NUM_SETS - 1;
+		u32 const num_vertices = fixture.library.sets[set_idx].num_vertices;
+		u32 const first_vertex = fixture.library.sets[set_idx].first_vertex;
+		vec3* baseline = Memory::PushType<vec3>(&arena, num_vertices * 2);
+		vec3* out = Memory::PushType<vec3>(&arena, num_vertices * 2);
+		f32 const weights[NUM_TARGETS] = { 0.8f, -0.4f, 0.0f, 0.35f };
+
+		bool b_first_path = true;
+		Simd::ForEachDispatchPath([&]()
+		{
+			vec3* dst = b_first_path ? baseline : out;
+			Blend(dst, dst + num_vertices, fixture.positions + first_vertex, fixture.normals + first_vertex, &fixture.library, set_idx, weights);
+			if (b_first_path)
+			{
+				b_first_path = false;
+				return;
+			}
+
+			for (u32 i = 0; i < num_vertices * 2; ++i)
+			{
+				ASSERT(Near(out[i], baseline[i]));
+			}
+		});
+	}
+
+	void Run()
+	{
+		BlendMatchesScalar();
+		DispatchPathsAgree();
+	}
+}
+}
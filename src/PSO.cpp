@@ -74,7 +74,10 @@ namespace Gfx
 		}
 	}
 
-	static Shader CreateShader(wchar_t const* filename, ShaderStage::Enum stage)
+	static constexpr u32 MAX_SHADER_DEFINES = 8;
+
+	// defines is an optional, null terminated list that is passed on top of the stage define.
+	static Shader CreateShader(wchar_t const* filename, ShaderStage::Enum stage, D3D_SHADER_MACRO const* defines = nullptr)
 	{
 		Shader shader;
 		shader.blob = nullptr;
@@ -83,6 +86,19 @@ namespace Gfx
 		ShaderCompilationSettings settings;
 		MemZeroSafe(settings);
 
+		// Slot 0 is reserved for the stage define, the zeroed tail terminates the list.
+		D3D_SHADER_MACRO macros[MAX_SHADER_DEFINES + 2];
+		MemZeroSafe(macros);
+
+		u32 num_macros = 1;
+		for (D3D_SHADER_MACRO const* define = defines; define && define->Name; ++define)
+		{
+			ASSERT_F(num_macros <= MAX_SHADER_DEFINES, "Exceeded max number of shader defines!");
+			macros[num_macros++] = *define;
+		}
+
+		settings.macros = macros;
+
 		// Since this is a content setting, we'd want smarter options for this later.
 		// But for now this will do.
 #ifdef _DEBUG
@@ -97,8 +113,7 @@ namespace Gfx
 		{
 		case ShaderStage::Vertex:
 		{
-			D3D_SHADER_MACRO macros[2] = { "VERTEX_SHADER" , "1" };
-			settings.macros = macros;
+			macros[0] = { "VERTEX_SHADER" , "1" };
 			settings.entry_point = "vs_main";
 			settings.target = "vs_5_1";
 			shader.blob = CompileShader(filename, &settings);
@@ -107,8 +122,7 @@ namespace Gfx
 		}
 		case ShaderStage::Pixel:
 		{
-			D3D_SHADER_MACRO macros[2] = { "PIXEL_SHADER" , "1" };
-			settings.macros = macros;
+			macros[0] = { "PIXEL_SHADER" , "1" };
 			settings.entry_point = "ps_main";
 			settings.target = "ps_5_1";
 			shader.blob = CompileShader(filename, &settings);
@@ -117,8 +131,7 @@ namespace Gfx
 		}
 		case ShaderStage::Compute:
 		{
-			D3D_SHADER_MACRO macros[2] = { "COMPUTE_SHADER" , "1" };
-			settings.macros = macros;
+			macros[0] = { "COMPUTE_SHADER" , "1" };
 			settings.entry_point = "cs_main";
 			settings.target = "cs_5_1";
 			shader.blob = CompileShader(filename, &settings);
@@ -179,6 +192,50 @@ namespace Gfx
 		}
 	}
 
+	static constexpr u32 NUM_VERTEX_INPUT_ELEMENTS = VertexAttribType::EnumCount;
+
+	// One attribute per input slot, matching the bindings in Gfx::DrawMesh.
+	static void FillVertexInputLayout(D3D12_INPUT_ELEMENT_DESC* elements, bool compressed_streams)
+	{
+		static char const* const s_semantic_names[VertexAttribType::EnumCount] =
+		{
+			"POSITION",
+			"NORMAL",
+			"TEXCOORD",
+			"TANGENT"
+		};
+
+		for (u32 i = 0; i < NUM_VERTEX_INPUT_ELEMENTS; ++i)
+		{
+			VertexAttribType::Enum type = static_cast<VertexAttribType::Enum>(i);
+
+			elements[i].SemanticName = s_semantic_names[i];
+			elements[i].SemanticIndex = 0;
+			elements[i].Format = GetVertexAttribFormat(type, compressed_streams);
+			elements[i].InputSlot = i;
+			elements[i].AlignedByteOffset = 0;
+			elements[i].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+			elements[i].InstanceDataStepRate = 0;
+		}
+	}
+
+	static constexpr u32 NUM_INSTANCE_INPUT_ELEMENTS = 3;
+
+	// The rows of a mat34 per instance, see Gfx::DrawSubMeshesInstanced.
+	static void FillInstanceInputLayout(D3D12_INPUT_ELEMENT_DESC* elements)
+	{
+		for (u32 i = 0; i < NUM_INSTANCE_INPUT_ELEMENTS; ++i)
+		{
+			elements[i].SemanticName = "INSTANCE_TRANSFORM";
+			elements[i].SemanticIndex = i;
+			elements[i].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			elements[i].InputSlot = INSTANCE_TRANSFORM_SLOT;
+			elements[i].AlignedByteOffset = i * sizeof(vec4);
+			elements[i].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+			elements[i].InstanceDataStepRate = 1;
+		}
+	}
+
 	void PSOCache::CompileBasicPSOs()
 	{
 		IO::Path shader_path;
@@ -199,45 +256,12 @@ namespace Gfx
 		pso_desc.PS.pShaderBytecode = pixl_shader->blob->GetBufferPointer();
 		pso_desc.PS.BytecodeLength = pixl_shader->blob->GetBufferSize();
 
-		D3D12_INPUT_ELEMENT_DESC elements[4];
+		D3D12_INPUT_ELEMENT_DESC elements[NUM_VERTEX_INPUT_ELEMENTS + NUM_INSTANCE_INPUT_ELEMENTS];
+		FillVertexInputLayout(elements, false);
 
-		pso_desc.InputLayout;
-		pso_desc.InputLayout.NumElements = 4;
+		pso_desc.InputLayout.NumElements = NUM_VERTEX_INPUT_ELEMENTS;
 		pso_desc.InputLayout.pInputElementDescs = elements;
 
-		elements[0].SemanticName = "POSITION";
-		elements[0].SemanticIndex = 0;
-		elements[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		elements[0].InputSlot = 0;
-		elements[0].AlignedByteOffset = 0;
-		elements[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-		elements[0].InstanceDataStepRate = 0;
-
-		elements[1].SemanticName = "NORMAL";
-		elements[1].SemanticIndex = 0;
-		elements[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		elements[1].InputSlot = 1;
-		elements[1].AlignedByteOffset = 0;
-		elements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-		elements[1].InstanceDataStepRate = 0;
-
-		elements[2].SemanticName = "TEXCOORD";
-		elements[2].SemanticIndex = 0;
-		elements[2].Format = DXGI_FORMAT_R32G32_FLOAT;
-		elements[2].InputSlot = 2;
-		elements[2].AlignedByteOffset = 0;
-		elements[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-		elements[2].InstanceDataStepRate = 0;
-
-		elements[3].SemanticName = "TANGENT";
-		elements[3].SemanticIndex = 0;
-		elements[3].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		elements[3].InputSlot = 3;
-		elements[3].AlignedByteOffset = 0;
-		elements[3].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-		elements[3].InstanceDataStepRate = 0;
-
-		
 		pso_desc.DepthStencilState.DepthEnable = true;
 		pso_desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
 		pso_desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
@@ -250,6 +274,37 @@ namespace Gfx
 		pso_desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
 		GraphicsPSO vert_color_wire = CreateGraphicsPSO(&pso_desc);
 
+		D3D_SHADER_MACRO const compressed_defines[] = { { "COMPRESSED_VERTEX_STREAMS", "1" }, { nullptr, nullptr } };
+		Shader* vert_shader_compressed = m_Shaders.PushBack(CreateShader(w_path, ShaderStage::Vertex, compressed_defines));
+
+		pso_desc.VS.pShaderBytecode = vert_shader_compressed->blob->GetBufferPointer();
+		pso_desc.VS.BytecodeLength = vert_shader_compressed->blob->GetBufferSize();
+
+		FillVertexInputLayout(elements, true);
+		pso_desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+		GraphicsPSO vert_color_solid_compressed = CreateGraphicsPSO(&pso_desc);
+
+		// Instanced variants take their model matrix from the instance stream instead of the per-object constants.
+		D3D_SHADER_MACRO const instanced_defines[] = { { "INSTANCED", "1" }, { nullptr, nullptr } };
+		Shader* vert_shader_instanced = m_Shaders.PushBack(CreateShader(w_path, ShaderStage::Vertex, instanced_defines));
+
+		pso_desc.VS.pShaderBytecode = vert_shader_instanced->blob->GetBufferPointer();
+		pso_desc.VS.BytecodeLength = vert_shader_instanced->blob->GetBufferSize();
+
+		FillVertexInputLayout(elements, false);
+		FillInstanceInputLayout(elements + NUM_VERTEX_INPUT_ELEMENTS);
+		pso_desc.InputLayout.NumElements = NUM_VERTEX_INPUT_ELEMENTS + NUM_INSTANCE_INPUT_ELEMENTS;
+		GraphicsPSO vert_color_solid_instanced = CreateGraphicsPSO(&pso_desc);
+
+		D3D_SHADER_MACRO const compressed_instanced_defines[] = { { "COMPRESSED_VERTEX_STREAMS", "1" }, { "INSTANCED", "1" }, { nullptr, nullptr } };
+		Shader* vert_shader_compressed_instanced = m_Shaders.PushBack(CreateShader(w_path, ShaderStage::Vertex, compressed_instanced_defines));
+
+		pso_desc.VS.pShaderBytecode = vert_shader_compressed_instanced->blob->GetBufferPointer();
+		pso_desc.VS.BytecodeLength = vert_shader_compressed_instanced->blob->GetBufferSize();
+
+		FillVertexInputLayout(elements, true);
+		GraphicsPSO vert_color_solid_compressed_instanced = CreateGraphicsPSO(&pso_desc);
+
 		if (vert_color_solid.pso != nullptr)
 		{
 			u32 handle_solid = m_PSOs.Size();
@@ -277,6 +332,48 @@ namespace Gfx
 		{
 			ASSERT_FAIL_F("Failed to compile pso vert_color_wire!");
 		}
+
+		if (vert_color_solid_compressed.pso != nullptr)
+		{
+			u32 handle_compressed = m_PSOs.Size();
+			m_PSOs.PushBack(vert_color_solid_compressed);
+
+			ASSERT(m_BasicPSOHandles.Size() == BasicPSO::VertexColorSolidCompressed);
+			Gfx::PSO* pso = m_BasicPSOHandles.PushBack();
+			pso->handle = handle_compressed;
+		}
+		else
+		{
+			ASSERT_FAIL_F("Failed to compile pso vert_color_solid_compressed!");
+		}
+
+		if (vert_color_solid_instanced.pso != nullptr)
+		{
+			u32 handle_instanced = m_PSOs.Size();
+			m_PSOs.PushBack(vert_color_solid_instanced);
+
+			ASSERT(m_BasicPSOHandles.Size() == BasicPSO::VertexColorSolidInstanced);
+			Gfx::PSO* pso = m_BasicPSOHandles.PushBack();
+			pso->handle = handle_instanced;
+		}
+		else
+		{
+			ASSERT_FAIL_F("Failed to compile pso vert_color_solid_instanced!");
+		}
+
+		if (vert_color_solid_compressed_instanced.pso != nullptr)
+		{
+			u32 handle_compressed_instanced = m_PSOs.Size();
+			m_PSOs.PushBack(vert_color_solid_compressed_instanced);
+
+			ASSERT(m_BasicPSOHandles.Size() == BasicPSO::VertexColorSolidCompressedInstanced);
+			Gfx::PSO* pso = m_BasicPSOHandles.PushBack();
+			pso->handle = handle_compressed_instanced;
+		}
+		else
+		{
+			ASSERT_FAIL_F("Failed to compile pso vert_color_solid_compressed_instanced!");
+		}
 	}
 
 	PSO PSOCache::GetBasicPSO(BasicPSO::Enum type)
@@ -0,0 +1,519 @@
+#include "ImageDecode.h"
+#include "Inflate.h"
+
+namespace Image
+{
+	namespace Png
+	{
+		struct ColorType
+		{
+			enum Enum : u8
+			{
+				Gray = 0,
+				Rgb = 2,
+				Palette = 3,
+				GrayAlpha = 4,
+				Rgba = 6,
+			};
+		};
+
+		// Adam7 passes, a non-interlaced image is a single pass covering every pixel.
+		static constexpr u32 NUM_ADAM7_PASSES = 7;
+		static u8 const ADAM7_START_X[NUM_ADAM7_PASSES] = { 0, 4, 0, 2, 0, 1, 0 };
+		static u8 const ADAM7_START_Y[NUM_ADAM7_PASSES] = { 0, 0, 4, 0, 2, 0, 1 };
+		static u8 const ADAM7_STEP_X[NUM_ADAM7_PASSES] = { 8, 8, 4, 4, 2, 2, 1 };
+		static u8 const ADAM7_STEP_Y[NUM_ADAM7_PASSES] = { 8, 8, 8, 4, 4, 2, 2 };
+
+		struct Pass
+		{
+			u32 start_x;
+			u32 start_y;
+			u32 step_x;
+			u32 step_y;
+			u32 width;
+			u32 height;
+		};
+
+		struct State
+		{
+			u8 bit_depth;
+			u8 color_type;
+			u32 num_channels;
+			u32 bytes_per_pixel; // Filters work on whole bytes, at least 1.
+
+			Pass passes[NUM_ADAM7_PASSES];
+			u32 num_passes;
+
+			u8 palette[256][4];
+			u32 palette_size;
+
+			// tRNS for gray and RGB images, at the image's bit depth.
+			bool b_has_color_key;
+			u16 color_key[3];
+
+			// IDAT chunks are consecutive, together they hold one zlib stream.
+			u64 first_idat_chunk;
+			u32 num_idat_chunks;
+			u64 compressed_size;
+
+			u64 inflated_size; // Filter byte plus row bytes, for every row of every pass.
+			u64 max_row_bytes;
+		};
+
+		static u32 ReadU32BE(u8 const* bytes)
+		{
+			return ((u32)bytes[0] << 24) | ((u32)bytes[1] << 16) | ((u32)bytes[2] << 8) | bytes[3];
+		}
+
+		static u32 ChunkType(char const (&name)[5])
+		{
+			return ReadU32BE((u8 const*)name);
+		}
+
+		static u64 RowBytes(State const* png, u32 width)
+		{
+			return ((u64)width * png->num_channels * png->bit_depth + 7) / 8;
+		}
+
+		static bool IsValidFormat(u8 color_type, u8 bit_depth)
+		{
+			switch (color_type)
+			{
+			case ColorType::Gray:
+				return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16;
+			case ColorType::Palette:
+				return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8;
+			case ColorType::Rgb:
+			case ColorType::GrayAlpha:
+			case ColorType::Rgba:
+				return bit_depth == 8 || bit_depth == 16;
+			}
+			return false;
+		}
+
+		static bool ReadHeader(State* png, Decoder* decoder, u8 const* chunk, u32 length)
+		{
+			if (length != 13)
+			{
+				return false;
+			}
+
+			decoder->width = ReadU32BE(chunk + 0);
+			decoder->height = ReadU32BE(chunk + 4);
+			png->bit_depth = chunk[8];
+			png->color_type = chunk[9];
+			u8 const compression = chunk[10];
+			u8 const filter = chunk[11];
+			u8 const interlace = chunk[12];
+
+			if (!IsValidFormat(png->color_type, png->bit_depth) || compression != 0 || filter != 0 || interlace > 1)
+			{
+				return false;
+			}
+			if (decoder->width == 0 || decoder->width > MAX_DIMENSION || decoder->height == 0 || decoder->height > MAX_DIMENSION)
+			{
+				return false;
+			}
+
+			static u8 const CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+			png->num_channels = CHANNELS[png->color_type];
+			png->bytes_per_pixel = max<u32>(png->num_channels * png->bit_depth / 8, 1);
+
+			png->num_passes = 0;
+			png->inflated_size = 0;
+			png->max_row_bytes = 0;
+			for (u32 pass_idx = 0; pass_idx < NUM_ADAM7_PASSES; ++pass_idx)
+			{
+				Pass pass;
+				if (interlace)
+				{
+					pass.start_x = ADAM7_START_X[pass_idx];
+					pass.start_y = ADAM7_START_Y[pass_idx];
+					pass.step_x = ADAM7_STEP_X[pass_idx];
+					pass.step_y = ADAM7_STEP_Y[pass_idx];
+				}
+				else
+				{
+					pass.start_x = pass.start_y = 0;
+					pass.step_x = pass.step_y = 1;
+				}
+
+				// Small images leave some passes empty, those don't even have filter bytes.
+				pass.width = (decoder->width > pass.start_x) ? (decoder->width - pass.start_x + pass.step_x - 1) / pass.step_x : 0;
+				pass.height = (decoder->height > pass.start_y) ? (decoder->height - pass.start_y + pass.step_y - 1) / pass.step_y : 0;
+				if (pass.width > 0 && pass.height > 0)
+				{
+					u64 const row_bytes = RowBytes(png, pass.width);
+					png->passes[png->num_passes++] = pass;
+					png->inflated_size += pass.height * (1 + row_bytes);
+					png->max_row_bytes = max(png->max_row_bytes, row_bytes);
+				}
+
+				if (!interlace)
+				{
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool Open(Decoder* decoder, Memory::Arena* memory)
+		{
+			State* png = Memory::PushType<State>(memory, 1, Memory::ZeroPush());
+			decoder->state = png;
+
+			// Opaque white, palette entries that tRNS doesn't mention keep their alpha.
+			memset(png->palette, 0xff, sizeof(png->palette));
+
+			u8 const* data = decoder->data;
+			u64 const data_size = decoder->data_size;
+
+			bool b_has_header = false;
+			bool b_in_idat_run = false;
+			u64 pos = 8;
+			while (pos + 12 <= data_size)
+			{
+				u32 const length = ReadU32BE(data + pos);
+				u32 const type = ReadU32BE(data + pos + 4);
+				u8 const* chunk = data + pos + 8;
+				if (length > data_size - pos - 12)
+				{
+					return false;
+				}
+
+				// IHDR comes first, everything else needs it.
+				if (!b_has_header && type != ChunkType("IHDR"))
+				{
+					return false;
+				}
+
+				if (type == ChunkType("IDAT"))
+				{
+					if (png->num_idat_chunks > 0 && !b_in_idat_run)
+					{
+						return false;
+					}
+					if (png->num_idat_chunks++ == 0)
+					{
+						png->first_idat_chunk = pos;
+					}
+					png->compressed_size += length;
+					b_in_idat_run = true;
+				}
+				else
+				{
+					b_in_idat_run = false;
+				}
+
+				if (type == ChunkType("IHDR"))
+				{
+					if (b_has_header || !ReadHeader(png, decoder, chunk, length))
+					{
+						return false;
+					}
+					b_has_header = true;
+				}
+				else if (type == ChunkType("PLTE"))
+				{
+					if (length % 3 != 0 || length / 3 > 256)
+					{
+						return false;
+					}
+					png->palette_size = length / 3;
+					for (u32 i = 0; i < png->palette_size; ++i)
+					{
+						png->palette[i][0] = chunk[i * 3 + 0];
+						png->palette[i][1] = chunk[i * 3 + 1];
+						png->palette[i][2] = chunk[i * 3 + 2];
+					}
+				}
+				else if (type == ChunkType("tRNS"))
+				{
+					if (png->color_type == ColorType::Palette)
+					{
+						if (length > 256)
+						{
+							return false;
+						}
+						for (u32 i = 0; i < length; ++i)
+						{
+							png->palette[i][3] = chunk[i];
+						}
+					}
+					else if (png->color_type == ColorType::Gray || png->color_type == ColorType::Rgb)
+					{
+						if (length != png->num_channels * 2)
+						{
+							return false;
+						}
+						for (u32 i = 0; i < png->num_channels; ++i)
+						{
+							png->color_key[i] = (u16)((chunk[i * 2] << 8) | chunk[i * 2 + 1]);
+						}
+						png->b_has_color_key = true;
+					}
+				}
+				else if (type == ChunkType("IEND"))
+				{
+					break;
+				}
+
+				// Skip the CRC, it isn't checked.
+				pos += 12 + (u64)length;
+			}
+
+			if (!b_has_header || png->compressed_size == 0 || (png->color_type == ColorType::Palette && png->palette_size == 0))
+			{
+				return false;
+			}
+
+			decoder->num_ranges = 1;
+
+			// Room for the arena's alignment, see DecodeRange().
+			u64 const joined_size = (png->num_idat_chunks > 1) ? png->compressed_size : 0;
+			decoder->scratch_size = png->inflated_size + joined_size + png->max_row_bytes + 3 * 64;
+			return true;
+		}
+
+		static __forceinline u8 Paeth(u8 a, u8 b, u8 c)
+		{
+			s32 const p = (s32)a + b - c;
+			s32 const pa = abs(p - a);
+			s32 const pb = abs(p - b);
+			s32 const pc = abs(p - c);
+			if (pa <= pb && pa <= pc)
+			{
+				return a;
+			}
+			return (pb <= pc) ? b : c;
+		}
+
+		// In place, prior is the already unfiltered row above (zeros for the first one).
+		static bool UnfilterRow(u8 filter, u8* row, u8 const* prior, u64 row_bytes, u32 bpp)
+		{
+			switch (filter)
+			{
+			case 0: // None
+				break;
+			case 1: // Sub
+				for (u64 i = bpp; i < row_bytes; ++i)
+				{
+					row[i] = (u8)(row[i] + row[i - bpp]);
+				}
+				break;
+			case 2: // Up
+				for (u64 i = 0; i < row_bytes; ++i)
+				{
+					row[i] = (u8)(row[i] + prior[i]);
+				}
+				break;
+			case 3: // Average
+				for (u64 i = 0; i < bpp; ++i)
+				{
+					row[i] = (u8)(row[i] + (prior[i] >> 1));
+				}
+				for (u64 i = bpp; i < row_bytes; ++i)
+				{
+					row[i] = (u8)(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+				}
+				break;
+			case 4: // Paeth
+				for (u64 i = 0; i < bpp; ++i)
+				{
+					row[i] = (u8)(row[i] + prior[i]);
+				}
+				for (u64 i = bpp; i < row_bytes; ++i)
+				{
+					row[i] = (u8)(row[i] + Paeth(row[i - bpp], prior[i], prior[i - bpp]));
+				}
+				break;
+			default:
+				return false;
+			}
+			return true;
+		}
+
+		// Sample index counts channels, not pixels.
+		static __forceinline u32 ReadSample(u8 const* row, u64 sample_idx, u32 bit_depth)
+		{
+			switch (bit_depth)
+			{
+			case 8:
+				return row[sample_idx];
+			case 16:
+				return (row[sample_idx * 2] << 8) | row[sample_idx * 2 + 1];
+			default:
+			{
+				u64 const bit = sample_idx * bit_depth;
+				u32 const shift = 8 - bit_depth - (u32)(bit & 7);
+				return (row[bit >> 3] >> shift) & ((1u << bit_depth) - 1);
+			}
+			}
+		}
+
+		static __forceinline u8 To8Bit(u32 sample, u32 bit_depth)
+		{
+			switch (bit_depth)
+			{
+			case 1:
+				return (u8)(sample * 0xff);
+			case 2:
+				return (u8)(sample * 0x55);
+			case 4:
+				return (u8)(sample * 0x11);
+			case 16:
+				return (u8)(sample >> 8);
+			default:
+				return (u8)sample;
+			}
+		}
+
+		// Expands one unfiltered row to RGBA8, dst steps pixel_step pixels per source pixel (Adam7).
+		static void ConvertRow(State const* png, u8 const* row, u32 width, u8* dst, u32 pixel_step)
+		{
+			u32 const bit_depth = png->bit_depth;
+			u64 const dst_step = (u64)pixel_step * 4;
+
+			// The common layouts, everything else goes through the sample readers.
+			if (bit_depth == 8 && !png->b_has_color_key)
+			{
+				switch (png->color_type)
+				{
+				case ColorType::Rgba:
+					if (pixel_step == 1)
+					{
+						memcpy(dst, row, (u64)width * 4);
+						return;
+					}
+					for (u32 x = 0; x < width; ++x, dst += dst_step, row += 4)
+					{
+						memcpy(dst, row, 4);
+					}
+					return;
+				case ColorType::Rgb:
+					for (u32 x = 0; x < width; ++x, dst += dst_step, row += 3)
+					{
+						dst[0] = row[0];
+						dst[1] = row[1];
+						dst[2] = row[2];
+						dst[3] = 0xff;
+					}
+					return;
+				case ColorType::Palette:
+					for (u32 x = 0; x < width; ++x, dst += dst_step)
+					{
+						memcpy(dst, png->palette[row[x]], 4);
+					}
+					return;
+				}
+			}
+
+			for (u32 x = 0; x < width; ++x, dst += dst_step)
+			{
+				switch (png->color_type)
+				{
+				case ColorType::Gray:
+				{
+					u32 const gray = ReadSample(row, x, bit_depth);
+					dst[0] = dst[1] = dst[2] = To8Bit(gray, bit_depth);
+					dst[3] = (png->b_has_color_key && gray == png->color_key[0]) ? 0 : 0xff;
+					break;
+				}
+				case ColorType::Rgb:
+				{
+					u32 const r = ReadSample(row, (u64)x * 3 + 0, bit_depth);
+					u32 const g = ReadSample(row, (u64)x * 3 + 1, bit_depth);
+					u32 const b = ReadSample(row, (u64)x * 3 + 2, bit_depth);
+					dst[0] = To8Bit(r, bit_depth);
+					dst[1] = To8Bit(g, bit_depth);
+					dst[2] = To8Bit(b, bit_depth);
+					bool const b_keyed = png->b_has_color_key && r == png->color_key[0] && g == png->color_key[1] && b == png->color_key[2];
+					dst[3] = b_keyed ? 0 : 0xff;
+					break;
+				}
+				case ColorType::Palette:
+					// Out of range indices read the opaque white default.
+					memcpy(dst, png->palette[ReadSample(row, x, bit_depth)], 4);
+					break;
+				case ColorType::GrayAlpha:
+					dst[0] = dst[1] = dst[2] = To8Bit(ReadSample(row, (u64)x * 2 + 0, bit_depth), bit_depth);
+					dst[3] = To8Bit(ReadSample(row, (u64)x * 2 + 1, bit_depth), bit_depth);
+					break;
+				case ColorType::Rgba:
+					for (u32 c = 0; c < 4; ++c)
+					{
+						dst[c] = To8Bit(ReadSample(row, (u64)x * 4 + c, bit_depth), bit_depth);
+					}
+					break;
+				}
+			}
+		}
+
+		bool DecodeRange(Decoder const* decoder, u32 range, u8* pixels, Memory::Arena* scratch_memory)
+		{
+			// Always a single range, see Open().
+			ASSERT(range == 0);
+			UNUSED(range);
+
+			State const* png = static_cast<State const*>(decoder->state);
+
+			Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+			ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+			// The zlib stream is split across IDAT chunks, inflate wants it in one piece.
+			u8 const* compressed = decoder->data + png->first_idat_chunk + 8;
+			if (png->num_idat_chunks > 1)
+			{
+				u8* joined = (u8*)Memory::PushSize(scratch_memory, png->compressed_size);
+				u64 pos = png->first_idat_chunk;
+				u64 joined_size = 0;
+				for (u32 chunk_idx = 0; chunk_idx < png->num_idat_chunks; ++chunk_idx)
+				{
+					u32 const length = ReadU32BE(decoder->data + pos);
+					memcpy(joined + joined_size, decoder->data + pos + 8, length);
+					joined_size += length;
+					pos += 12 + (u64)length;
+				}
+				compressed = joined;
+			}
+
+			u8* inflated = (u8*)Memory::PushSize(scratch_memory, png->inflated_size);
+			u64 inflated_size = 0;
+			if (!Inflate::DecodeZlib(inflated, png->inflated_size, compressed, png->compressed_size, &inflated_size) ||
+				inflated_size != png->inflated_size)
+			{
+				return false;
+			}
+
+			u8* zero_row = (u8*)Memory::PushSize(scratch_memory, png->max_row_bytes, Memory::ZeroPush());
+
+			u64 const dst_row_pitch = (u64)decoder->width * 4;
+			u8* row = inflated;
+			for (u32 pass_idx = 0; pass_idx < png->num_passes; ++pass_idx)
+			{
+				Pass const& pass = png->passes[pass_idx];
+				u64 const row_bytes = RowBytes(png, pass.width);
+
+				u8 const* prior = zero_row;
+				for (u32 y = 0; y < pass.height; ++y)
+				{
+					u8 const filter = row[0];
+					u8* row_data = row + 1;
+					if (!UnfilterRow(filter, row_data, prior, row_bytes, png->bytes_per_pixel))
+					{
+						return false;
+					}
+
+					u8* dst = pixels + (pass.start_y + (u64)y * pass.step_y) * dst_row_pitch + (u64)pass.start_x * 4;
+					ConvertRow(png, row_data, pass.width, dst, pass.step_x);
+
+					prior = row_data;
+					row += 1 + row_bytes;
+				}
+			}
+
+			return true;
+		}
+	}
+}
\ No newline at end of file
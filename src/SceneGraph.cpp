@@ -0,0 +1,209 @@
+#include "SceneGraph.h"
+#include "Jobs.h"
+
+namespace Scene
+{
+	static constexpr u64 PARALLEL_BATCH_SIZE = 1024;
+
+	Transform IdentityTransform()
+	{
+		Transform transform;
+		transform.translation = vec3(0.0f, 0.0f, 0.0f);
+		transform.rotation = Math::QuatIdentity();
+		transform.scale = vec3(1.0f, 1.0f, 1.0f);
+		return transform;
+	}
+
+	Transform DecomposeTransform(mat44 const& mat)
+	{
+		vec3 const x_axis(mat(0, 0), mat(1, 0), mat(2, 0));
+		vec3 const y_axis(mat(0, 1), mat(1, 1), mat(2, 1));
+		vec3 const z_axis(mat(0, 2), mat(1, 2), mat(2, 2));
+
+		Transform transform;
+		transform.translation = vec3(mat(0, 3), mat(1, 3), mat(2, 3));
+		transform.scale = vec3(Math::Length(x_axis), Math::Length(y_axis), Math::Length(z_axis));
+
+		// A negative determinant can't be expressed by a rotation.
+		mat44 rotation = mat;
+		if (Math::Dot(Math::Cross(x_axis, y_axis), z_axis) < 0.0f)
+		{
+			transform.scale.x = -transform.scale.x;
+			rotation(0, 0) = -rotation(0, 0);
+			rotation(1, 0) = -rotation(1, 0);
+			rotation(2, 0) = -rotation(2, 0);
+		}
+		transform.rotation = Math::QuatFromMatrix(rotation);
+		return transform;
+	}
+
+	void BuildHierarchy(Hierarchy* hierarchy, Memory::Arena* arena,
+		u32 const* parents, Transform const* locals, u32 count, u32* out_remap)
+	{
+		MemZeroSafe(hierarchy);
+		hierarchy->num_nodes = count;
+		hierarchy->locals = Memory::PushType<Transform>(arena, count);
+		hierarchy->worlds = Memory::PushType<mat34>(arena, count, Memory::AlignPush(16));
+		hierarchy->parents = Memory::PushType<u32>(arena, count);
+		hierarchy->flags = Memory::PushType<u8>(arena, count);
+
+		// Sized for the worst case (a single chain), the depth is only known further down
+		// and has to be allocated before the scratch memory below.
+		hierarchy->level_offsets = Memory::PushType<u32>(arena, count + 1);
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = Memory::BeginTemporaryAlloc(arena);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(arena, alloc, false));
+
+		static constexpr u32 UNKNOWN_DEPTH = ~0u;
+
+		u32* depths = Memory::PushType<u32>(arena, count);
+		for (u32 i = 0; i < count; ++i)
+		{
+			depths[i] = UNKNOWN_DEPTH;
+		}
+
+		// Walk up until we hit a node with known depth, then assign depths on the way back down.
+		// One more than a chain can be long, it's reused for the num_levels + 1 level counts below.
+		u32* chain = Memory::PushType<u32>(arena, count + 1);
+		u32 max_depth = 0;
+		for (u32 i = 0; i < count; ++i)
+		{
+			u32 chain_len = 0;
+			u32 node = i;
+			while (node != INVALID_NODE && depths[node] == UNKNOWN_DEPTH)
+			{
+				ASSERT_F(chain_len < count, "Node hierarchy contains a cycle!");
+				ASSERT(node < count);
+				chain[chain_len++] = node;
+				node = parents[node];
+			}
+
+			u32 depth = (node == INVALID_NODE) ? 0 : depths[node] + 1;
+			while (chain_len > 0)
+			{
+				depths[chain[--chain_len]] = depth++;
+			}
+
+			max_depth = max(max_depth, depths[i]);
+		}
+
+		// Counting sort by depth, stable so siblings keep their input order.
+		hierarchy->num_levels = max_depth + 1;
+
+		// The chain isn't needed anymore, reuse it for counting.
+		u32* level_counts = chain;
+		memzero(level_counts, sizeof(u32) * (hierarchy->num_levels + 1));
+		for (u32 i = 0; i < count; ++i)
+		{
+			level_counts[depths[i] + 1]++;
+		}
+		for (u32 level = 0; level < hierarchy->num_levels; ++level)
+		{
+			level_counts[level + 1] += level_counts[level];
+		}
+
+		u32* remap = (out_remap != nullptr) ? out_remap : Memory::PushType<u32>(arena, count);
+		for (u32 i = 0; i < count; ++i)
+		{
+			remap[i] = level_counts[depths[i]]++;
+		}
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			u32 const new_idx = remap[i];
+			hierarchy->locals[new_idx] = locals[i];
+			hierarchy->parents[new_idx] = (parents[i] == INVALID_NODE) ? INVALID_NODE : remap[parents[i]];
+			hierarchy->flags[new_idx] = NodeFlags::LocalDirty;
+		}
+		hierarchy->b_any_dirty = true;
+
+		// After the scatter above each level count was advanced to the start of the next level.
+		hierarchy->level_offsets[0] = 0;
+		for (u32 level = 0; level < hierarchy->num_levels; ++level)
+		{
+			hierarchy->level_offsets[level + 1] = level_counts[level];
+		}
+
+		UpdateWorldTransforms(hierarchy);
+	}
+
+	void SetLocalTransform(Hierarchy* hierarchy, u32 node, Transform const& local)
+	{
+		ASSERT(node < hierarchy->num_nodes);
+		hierarchy->locals[node] = local;
+		hierarchy->flags[node] |= NodeFlags::LocalDirty;
+		hierarchy->b_any_dirty = true;
+	}
+
+	static void UpdateNodeRange(Hierarchy* hierarchy, u32 begin, u32 end)
+	{
+		Transform const* locals = hierarchy->locals;
+		mat34* worlds = hierarchy->worlds;
+		u32 const* parents = hierarchy->parents;
+		u8* flags = hierarchy->flags;
+
+		for (u32 i = begin; i < end; ++i)
+		{
+			u32 const parent = parents[i];
+			bool const b_parent_changed = (parent != INVALID_NODE) && (flags[parent] & NodeFlags::WorldChanged);
+
+			if (!b_parent_changed && !(flags[i] & NodeFlags::LocalDirty))
+			{
+				flags[i] = NodeFlags::None;
+				continue;
+			}
+
+			Transform const& local = locals[i];
+			mat34 const local_mat = Math::TRS<mat34>(local.translation, local.rotation, local.scale);
+			worlds[i] = (parent != INVALID_NODE) ? worlds[parent] * local_mat : local_mat;
+			flags[i] = NodeFlags::WorldChanged;
+		}
+	}
+
+	struct LevelTask
+	{
+		Hierarchy* hierarchy;
+		u32 level_begin;
+	};
+
+	static void UpdateLevelBatch(void* user_data, u64 begin, u64 end)
+	{
+		LevelTask* task = static_cast<LevelTask*>(user_data);
+		UpdateNodeRange(task->hierarchy, task->level_begin + (u32)begin, task->level_begin + (u32)end);
+	}
+
+	void UpdateWorldTransforms(Hierarchy* hierarchy)
+	{
+		if (!hierarchy->b_any_dirty)
+		{
+			// Nothing moved, but the WorldChanged bits of the last update are stale now.
+			memzero(hierarchy->flags, hierarchy->num_nodes);
+			return;
+		}
+
+		for (u32 level = 0; level < hierarchy->num_levels; ++level)
+		{
+			u32 const level_begin = hierarchy->level_offsets[level];
+			u32 const level_end = hierarchy->level_offsets[level + 1];
+			u32 const level_size = level_end - level_begin;
+
+			if (level_size < PARALLEL_MIN_LEVEL_NODES)
+			{
+				UpdateNodeRange(hierarchy, level_begin, level_end);
+				continue;
+			}
+
+			LevelTask task;
+			task.hierarchy = hierarchy;
+			task.level_begin = level_begin;
+			Jobs::ParallelFor(level_size, PARALLEL_BATCH_SIZE, &UpdateLevelBatch, &task);
+		}
+
+		hierarchy->b_any_dirty = false;
+	}
+}
\ No newline at end of file
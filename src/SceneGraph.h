@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+#include "Memory.h"
+
+// ====================================
+//  Scene Graph
+//  Notes:
+//  *) World transforms are affine mat34, a quarter smaller than mat44.
+//  *) Nodes are stored as flat arrays sorted by depth, so a parent
+//     always comes before its children and every depth level is a
+//     contiguous range. Updating world transforms is a linear sweep.
+//  *) Levels are processed one after another, the nodes within a
+//     level are independent and get split across the job system.
+//  *) Only nodes whose local transform changed, and their subtrees,
+//     are recomputed.
+// ====================================
+
+namespace Scene
+{
+	static constexpr u32 INVALID_NODE = ~0u;
+
+	struct Transform
+	{
+		vec3 translation;
+		quat rotation;
+		vec3 scale;
+	};
+
+	Transform IdentityTransform();
+
+	// Splits an affine matrix into translation, rotation and scale. Shear is lost. Mirroring
+	// matrices keep a negative x scale, the rotation is taken from the unmirrored axes.
+	Transform DecomposeTransform(mat44 const& mat);
+
+	struct NodeFlags
+	{
+		enum Enum : u8
+		{
+			None = 0,
+			LocalDirty   = 1 << 0, // Set by SetLocalTransform, consumed by UpdateWorldTransforms.
+			WorldChanged = 1 << 1, // World transform was recomputed during the last update.
+		};
+	};
+
+	struct Hierarchy
+	{
+		u32 num_nodes;
+
+		// Indexed by node. parents[i] < i, or INVALID_NODE for roots.
+		Transform* locals;
+		mat34* worlds;
+		u32* parents;
+		u8* flags;
+
+		// Nodes of depth d are [level_offsets[d], level_offsets[d + 1]).
+		u32* level_offsets;
+		u32 num_levels;
+
+		bool b_any_dirty;
+	};
+
+	// Builds a hierarchy from nodes in arbitrary order. parents index into the same input
+	// arrays. out_remap (optional, count entries) receives the new index of each input node.
+	void BuildHierarchy(Hierarchy* hierarchy, Memory::Arena* arena,
+		u32 const* parents, Transform const* locals, u32 count, u32* out_remap);
+
+	void SetLocalTransform(Hierarchy* hierarchy, u32 node, Transform const& local);
+
+	// Levels with fewer nodes than this are updated on the calling thread.
+	static constexpr u32 PARALLEL_MIN_LEVEL_NODES = 4 * 1024;
+
+	void UpdateWorldTransforms(Hierarchy* hierarchy);
+
+	inline mat34 const& GetWorldTransform(Hierarchy const* hierarchy, u32 node)
+	{
+		ASSERT(node < hierarchy->num_nodes);
+		return hierarchy->worlds[node];
+	}
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
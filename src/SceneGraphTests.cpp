@@ -0,0 +1,151 @@
+#include "SceneGraph.h"
+#include "TestUtils.h"
+
+namespace Scene
+{
+namespace Test
+{
+	static bool NearlyEqualMatrix(mat44 const& a, mat44 const& b, f32 epsilon)
+	{
+		for (u32 i = 0; i < 16; ++i)
+		{
+			if (!NearlyEqual(a.data[i], b.data[i], epsilon))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static Transform Translation(f32 x, f32 y, f32 z)
+	{
+		Transform transform = IdentityTransform();
+		transform.translation = vec3(x, y, z);
+		return transform;
+	}
+
+	// A single chain has as many levels as nodes, the most the level counts ever need. The nodes
+	// are passed leaf first, so every one of them moves, and no remap is passed in.
+	void DeepChain()
+	{
+		static constexpr u32 NUM_NODES = 1000;
+
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		u32 parents[NUM_NODES];
+		Transform locals[NUM_NODES];
+		for (u32 i = 0; i < NUM_NODES; ++i)
+		{
+			parents[i] = (i + 1 < NUM_NODES) ? i + 1 : INVALID_NODE;
+			locals[i] = Translation(1.0f, 0.0f, 0.0f);
+		}
+
+		Hierarchy hierarchy;
+		BuildHierarchy(&hierarchy, &arena, parents, locals, NUM_NODES, nullptr);
+
+		ASSERT(hierarchy.num_levels == NUM_NODES);
+		for (u32 level = 0; level <= NUM_NODES; ++level)
+		{
+			ASSERT(hierarchy.level_offsets[level] == level);
+		}
+
+		for (u32 i = 0; i < NUM_NODES; ++i)
+		{
+			ASSERT(hierarchy.parents[i] == (i == 0 ? INVALID_NODE : i - 1));
+			ASSERT(GetWorldTransform(&hierarchy, i)(0, 3) == (f32)(i + 1));
+		}
+	}
+
+	// One level wide enough to be split across the job system.
+	void WideFan()
+	{
+		static constexpr u32 NUM_NODES = PARALLEL_MIN_LEVEL_NODES * 3 + 1;
+
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		u32* parents = Memory::PushType<u32>(&arena, NUM_NODES);
+		Transform* locals = Memory::PushType<Transform>(&arena, NUM_NODES);
+		u32* remap = Memory::PushType<u32>(&arena, NUM_NODES);
+
+		// The root comes last in the input.
+		u32 const root = NUM_NODES - 1;
+		for (u32 i = 0; i < NUM_NODES; ++i)
+		{
+			parents[i] = (i == root) ? INVALID_NODE : root;
+			locals[i] = Translation(0.0f, (f32)i, 0.0f);
+		}
+		locals[root] = Translation(0.0f, 0.0f, 2.0f);
+
+		Hierarchy hierarchy;
+		BuildHierarchy(&hierarchy, &arena, parents, locals, NUM_NODES, remap);
+
+		ASSERT(hierarchy.num_levels == 2);
+		ASSERT(hierarchy.level_offsets[0] == 0 && hierarchy.level_offsets[1] == 1 && hierarchy.level_offsets[2] == NUM_NODES);
+		ASSERT(remap[root] == 0);
+
+		for (u32 i = 0; i < root; ++i)
+		{
+			// Siblings keep their input order.
+			ASSERT(remap[i] == i + 1);
+			mat34 const& world = GetWorldTransform(&hierarchy, remap[i]);
+			ASSERT(world(1, 3) == (f32)i && world(2, 3) == 2.0f);
+		}
+
+		// Moving the root recomputes the whole fan, the next update without changes none of it.
+		SetLocalTransform(&hierarchy, 0, Translation(0.0f, 0.0f, -1.0f));
+		UpdateWorldTransforms(&hierarchy);
+		for (u32 i = 0; i < NUM_NODES; ++i)
+		{
+			ASSERT(hierarchy.flags[i] == NodeFlags::WorldChanged);
+			ASSERT(GetWorldTransform(&hierarchy, i)(2, 3) == -1.0f);
+		}
+
+		UpdateWorldTransforms(&hierarchy);
+		for (u32 i = 0; i < NUM_NODES; ++i)
+		{
+			ASSERT(hierarchy.flags[i] == NodeFlags::None);
+		}
+
+		// Only the moved node is recomputed, its siblings are left alone.
+		SetLocalTransform(&hierarchy, 5, Translation(7.0f, 0.0f, 0.0f));
+		UpdateWorldTransforms(&hierarchy);
+		ASSERT(hierarchy.flags[0] == NodeFlags::None && hierarchy.flags[4] == NodeFlags::None);
+		ASSERT(hierarchy.flags[5] == NodeFlags::WorldChanged);
+		ASSERT(GetWorldTransform(&hierarchy, 5)(0, 3) == 7.0f);
+	}
+
+	// Decomposing and recomposing has to give back the matrix, mirrored or not.
+	void DecomposeRoundTrip()
+	{
+		TestUtils::Random random;
+		vec3 const scales[] = { vec3(1.0f, 2.0f, 0.5f), vec3(-2.0f, 3.0f, 4.0f), vec3(1.5f, -1.0f, 1.0f), vec3(1.0f, 1.0f, -3.0f), vec3(-1.0f, -1.0f, -1.0f) };
+
+		for (vec3 const& scale : scales)
+		{
+			vec3 const axis = Math::Normalize(vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f)));
+			quat const rotation = Math::QuatAxisAngle(axis, Math::Rad(random.Float(-3.0f, 3.0f)));
+			vec3 const translation(random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f));
+
+			mat44 const mat = Math::TRS<mat44>(translation, rotation, scale);
+			Transform const transform = DecomposeTransform(mat);
+
+			ASSERT(NearlyEqualMatrix(Math::TRS<mat44>(transform.translation, transform.rotation, transform.scale), mat, 1e-5f));
+
+			// Only an odd number of mirrored axes survives, as a mirrored x.
+			bool const b_mirrored = ((scale.x < 0.0f) != (scale.y < 0.0f)) != (scale.z < 0.0f);
+			ASSERT((transform.scale.x < 0.0f) == b_mirrored && transform.scale.y > 0.0f && transform.scale.z > 0.0f);
+		}
+	}
+
+	void Run()
+	{
+		DeepChain();
+		WideFan();
+		DecomposeRoundTrip();
+	}
+}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// ====================================
+//  SIMD Helpers
+//  Notes:
+//  *) SSE4.1 is assumed as the baseline, everything
+//     past that (F16C, AVX2) is dispatched at runtime.
+//  *) MSVC compiles any intrinsic anywhere, GCC and Clang only in
+//     functions that target the instruction set. Dispatched paths
+//     mark their entry points with SIMD_TARGET_AVX2 (or _F16C), which
+//     also flattens every call into them, and their helpers with
+//     SIMD_INLINE_AVX2. Helpers can't force inlining on GCC, templates
+//     shared with the SSE paths would have to inline them too.
+// ====================================
+
+#ifdef _MSC_VER
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_F16C
+#define SIMD_INLINE_AVX2 MM_FORCEINL
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma"), flatten))
+#define SIMD_TARGET_F16C __attribute__((target("f16c")))
+#define SIMD_INLINE_AVX2 inline __attribute__((target("avx2,fma")))
+#endif
+
+namespace Simd
+{
+	struct CpuFeatures
+	{
+		bool f16c;
+		bool avx2;
+		bool fma;
+	};
+
+	// Subleaf 0 of leaf.
+	inline void Cpuid(s32 info[4], s32 leaf)
+	{
+#ifdef _MSC_VER
+		__cpuidex(info, leaf, 0);
+#else
+		__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+	}
+
+	// Register state the OS saves on context switches.
+	inline u64 ReadXcr0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		u32 eax, edx;
+		__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((u64)edx << 32) | eax;
+#endif
+	}
+
+	inline CpuFeatures QueryCpuFeatures()
+	{
+		CpuFeatures features;
+		MemZeroSafe(features);
+
+		s32 info[4];
+		Cpuid(info, 0);
+		s32 const max_leaf = info[0];
+
+		Cpuid(info, 1);
+		bool const has_osxsave = (info[2] & (1 << 27)) != 0;
+		bool const has_avx = (info[2] & (1 << 28)) != 0;
+
+		// The OS has to save the ymm registers on context switches, otherwise
+		// we can't touch anything wider than 128 bit.
+		bool const os_saves_ymm = has_osxsave && ((ReadXcr0() & 0x6) == 0x6);
+		if (!has_avx || !os_saves_ymm)
+		{
+			return features;
+		}
+
+		features.f16c = (info[2] & (1 << 29)) != 0;
+		features.fma = (info[2] & (1 << 12)) != 0;
+
+		if (max_leaf >= 7)
+		{
+			Cpuid(info, 7);
+			features.avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		return features;
+	}
+
+	inline CpuFeatures& GetMutableCpuFeatures()
+	{
+		static CpuFeatures s_features = QueryCpuFeatures();
+		return s_features;
+	}
+
+	inline CpuFeatures const& GetCpuFeatures()
+	{
+		return GetMutableCpuFeatures();
+	}
+
+	// Runs func once on the SSE4.1 baseline and once with everything the CPU has, so tests can hold the
+	// dispatched paths against each other. Not thread safe, nothing else may be running meanwhile.
+	template <typename Func>
+	void ForEachDispatchPath(Func func)
+	{
+		CpuFeatures const detected = QueryCpuFeatures();
+
+		MemZeroSafe(GetMutableCpuFeatures());
+		func();
+
+		GetMutableCpuFeatures() = detected;
+		func();
+	}
+
+	// Loads 4 consecutive vec3 (AoS) and transposes them to x,y,z lanes (SoA).
+	static MM_FORCEINL void MM_VECTORCALL LoadVec3x4(vec3 const* src, __m128& x, __m128& y, __m128& z)
+	{
+		f32 const* floats = src->data;
+
+		__m128 a = _mm_loadu_ps(floats + 0); // x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(floats + 4); // y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(floats + 8); // z2 x3 y3 z3
+
+		__m128 b2b3c1c2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+		x = _mm_shuffle_ps(a, b2b3c1c2, _MM_SHUFFLE(2, 0, 3, 0));
+
+		__m128 a1a1b0b0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		y = _mm_shuffle_ps(a1a1b0b0, b2b3c1c2, _MM_SHUFFLE(3, 1, 2, 0));
+
+		__m128 a2a2b1b1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 c0c0c3c3 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		z = _mm_shuffle_ps(a2a2b1b1, c0c0c3c3, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	// Inverse of LoadVec3x4, writes 4 consecutive vec3 from x,y,z lanes.
+	static MM_FORCEINL void MM_VECTORCALL StoreVec3x4(vec3* dst, __m128 x, __m128 y, __m128 z)
+	{
+		f32* floats = dst->data;
+
+		__m128 x0y0x1y1 = _mm_unpacklo_ps(x, y);
+		__m128 x2y2x3y3 = _mm_unpackhi_ps(x, y);
+
+		__m128 z0z0x1x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+		__m128 a = _mm_shuffle_ps(x0y0x1y1, z0z0x1x1, _MM_SHUFFLE(2, 0, 1, 0));
+
+		__m128 y1y1z1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 b = _mm_shuffle_ps(y1y1z1z1, x2y2x3y3, _MM_SHUFFLE(1, 0, 2, 0));
+
+		__m128 x3y3z2z3 = _mm_shuffle_ps(x2y2x3y3, z, _MM_SHUFFLE(3, 2, 3, 2));
+		__m128 c = _mm_shuffle_ps(x3y3z2z3, x3y3z2z3, _MM_SHUFFLE(3, 1, 0, 2));
+
+		_mm_storeu_ps(floats + 0, a);
+		_mm_storeu_ps(floats + 4, b);
+		_mm_storeu_ps(floats + 8, c);
+	}
+
+	// The 8 wide helpers need AVX2 and FMA, callers check GetCpuFeatures() first.
+	static SIMD_INLINE_AVX2 void MM_VECTORCALL LoadVec3x8(vec3 const* src, __m256& x, __m256& y, __m256& z)
+	{
+		__m128 x0, y0, z0, x1, y1, z1;
+		LoadVec3x4(src, x0, y0, z0);
+		LoadVec3x4(src + 4, x1, y1, z1);
+
+		x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+		y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+		z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+	}
+
+	static SIMD_INLINE_AVX2 void MM_VECTORCALL StoreVec3x8(vec3* dst, __m256 x, __m256 y, __m256 z)
+	{
+		StoreVec3x4(dst, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+		StoreVec3x4(dst + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+	}
+
+	// Zero vectors stay zero instead of turning into NaN.
+	static SIMD_INLINE_AVX2 void MM_VECTORCALL NormalizeVec3x8(__m256& x, __m256& y, __m256& z)
+	{
+		__m256 length_sq = _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)));
+		length_sq = _mm256_max_ps(length_sq, _mm256_set1_ps(1e-30f));
+
+		__m256 const inv_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length_sq));
+		x = _mm256_mul_ps(x, inv_length);
+		y = _mm256_mul_ps(y, inv_length);
+		z = _mm256_mul_ps(z, inv_length);
+	}
+
+	static MM_FORCEINL f32 MM_VECTORCALL HorizontalMin(__m128 v)
+	{
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	static MM_FORCEINL f32 MM_VECTORCALL HorizontalMax(__m128 v)
+	{
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,524 @@
+#include "Skinning.h"
+#include "Jobs.h"
+#include "Simd.h"
+
+namespace Skinning
+{
+	static constexpr u64 PARALLEL_BATCH_SIZE = 4 * 1024;
+
+	void ComputeJointMatrices(mat34* out_matrices, Scene::Hierarchy const* hierarchy, u32 const* joint_nodes,
+		mat34 const* inverse_bind_matrices, u32 num_joints, u32 mesh_node)
+	{
+		mat34 const mesh_from_world = (mesh_node != Scene::INVALID_NODE) ? Math::Inverse(Scene::GetWorldTransform(hierarchy, mesh_node)) : mat34::Identity();
+
+		for (u32 i = 0; i < num_joints; ++i)
+		{
+			mat34 const& world = Scene::GetWorldTransform(hierarchy, joint_nodes[i]);
+			out_matrices[i] = Math::Mul(Math::Mul(mesh_from_world, world), inverse_bind_matrices[i]);
+		}
+	}
+
+	void ComputeJointDualQuats(DualQuat* out_dual_quats, mat34 const* joint_matrices, u32 num_joints)
+	{
+		for (u32 i = 0; i < num_joints; ++i)
+		{
+			mat34 const& mat = joint_matrices[i];
+			quat const r = Math::QuatFromMatrix(Math::ToMat44(mat));
+			vec3 const t(mat(0, 3), mat(1, 3), mat(2, 3));
+
+			// 0.5 * (t, 0) * r, written out.
+			DualQuat& dq = out_dual_quats[i];
+			dq.real = r;
+			dq.dual.x = 0.5f * (r.w * t.x + t.y * r.z - t.z * r.y);
+			dq.dual.y = 0.5f * (r.w * t.y + t.z * r.x - t.x * r.z);
+			dq.dual.z = 0.5f * (r.w * t.z + t.x * r.y - t.y * r.x);
+			dq.dual.w = -0.5f * (t.x * r.x + t.y * r.y + t.z * r.z);
+		}
+	}
+
+	// Exactly 12 bytes, the streams are tightly packed and the last vertex may end the buffer.
+	static MM_FORCEINL __m128 MM_VECTORCALL LoadVec3(f32 const* src)
+	{
+		__m128 const xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const*>(src)));
+		return _mm_insert_ps(xy, _mm_load_ss(src + 2), 0x20);
+	}
+
+	// Exactly 12 bytes, the next vertex may belong to a batch on another thread.
+	static MM_FORCEINL void MM_VECTORCALL StoreVec3(f32* dst, __m128 v)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+		_mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+	}
+
+	static MM_FORCEINL __m128 MM_VECTORCALL NormalizeVec3(__m128 v)
+	{
+		// Primitives without normals have zeroed ones in a shared stream, keep them at zero instead of NaN.
+		__m128 const length_sq = _mm_max_ps(_mm_dp_ps(v, v, 0x7F), _mm_set1_ps(1e-30f));
+		return _mm_div_ps(v, _mm_sqrt_ps(length_sq));
+	}
+
+	// ====================================
+	//  Linear Blend
+	// ====================================
+
+	// Position p (w = 1) and normal n (w = 0) through the rows of an affine matrix.
+	static MM_FORCEINL void MM_VECTORCALL TransformRows(__m128 row0, __m128 row1, __m128 row2, __m128 p, __m128 n,
+		__m128& out_p, __m128& out_n)
+	{
+		__m128 const p01 = _mm_hadd_ps(_mm_mul_ps(row0, p), _mm_mul_ps(row1, p));
+		__m128 const p2n0 = _mm_hadd_ps(_mm_mul_ps(row2, p), _mm_mul_ps(row0, n));
+		__m128 const n12 = _mm_hadd_ps(_mm_mul_ps(row1, n), _mm_mul_ps(row2, n));
+
+		out_p = _mm_hadd_ps(p01, p2n0);
+		__m128 const n_shifted = _mm_hadd_ps(p2n0, n12);
+		out_n = _mm_shuffle_ps(n_shifted, n_shifted, _MM_SHUFFLE(3, 3, 2, 1));
+	}
+
+	// Weighted sum of one row of the 4 joint matrices. The joints are summed in two independent pairs, which
+	// keeps the dependency chains short, here and in the other blends.
+	static MM_FORCEINL __m128 MM_VECTORCALL BlendRowSSE(mat34 const* matrices, Gfx::Joints_t const& joints, f32 const* weights, u32 offset)
+	{
+		__m128 const a = _mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(matrices[joints.index[0]].data + offset)),
+			_mm_mul_ps(_mm_set1_ps(weights[1]), _mm_loadu_ps(matrices[joints.index[1]].data + offset)));
+		__m128 const b = _mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(weights[2]), _mm_loadu_ps(matrices[joints.index[2]].data + offset)),
+			_mm_mul_ps(_mm_set1_ps(weights[3]), _mm_loadu_ps(matrices[joints.index[3]].data + offset)));
+		return _mm_add_ps(a, b);
+	}
+
+	template <bool HAS_NORMALS>
+	static void SkinLinearSSE(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		mat34 const* matrices, u64 begin, u64 end)
+	{
+		__m128 const one_w = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		__m128 n = _mm_setzero_ps();
+
+		for (u64 i = begin; i < end; ++i)
+		{
+			Gfx::Joints_t const& joints = vertices.joints[i];
+			f32 const* weights = vertices.weights[i].data;
+
+			__m128 const row0 = BlendRowSSE(matrices, joints, weights, 0);
+			__m128 const row1 = BlendRowSSE(matrices, joints, weights, 4);
+			__m128 const row2 = BlendRowSSE(matrices, joints, weights, 8);
+
+			__m128 const p = _mm_or_ps(LoadVec3(vertices.positions[i].data), one_w);
+			if (HAS_NORMALS)
+			{
+				n = LoadVec3(vertices.normals[i].data);
+			}
+
+			__m128 skinned_p, skinned_n;
+			TransformRows(row0, row1, row2, p, n, skinned_p, skinned_n);
+
+			StoreVec3(out_positions[i].data, skinned_p);
+			if (HAS_NORMALS)
+			{
+				StoreVec3(out_normals[i].data, NormalizeVec3(skinned_n));
+			}
+		}
+	}
+
+	// ====================================
+	//  Dual Quaternion Blend
+	// ====================================
+
+	// Sign bit of dot(a, b) in every lane.
+	static MM_FORCEINL __m128 MM_VECTORCALL DotSign(__m128 a, __m128 b)
+	{
+		return _mm_and_ps(_mm_dp_ps(a, b, 0xFF), _mm_set1_ps(-0.0f));
+	}
+
+	// Rotates and translates p (w = 0) by the blended dual quaternion, rotates n.
+	static MM_FORCEINL void MM_VECTORCALL TransformDualQuat(__m128 real, __m128 dual, __m128 p, __m128 n,
+		__m128& out_p, __m128& out_n)
+	{
+		// Blending leaves the real part unnormalized, both parts are scaled by its inverse length. Vertices
+		// without weights end up with zero in both and keep their bind pose.
+		__m128 const length_sq = _mm_max_ps(_mm_dp_ps(real, real, 0xFF), _mm_set1_ps(1e-30f));
+		__m128 const inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));
+		real = _mm_mul_ps(real, inv_length);
+		dual = _mm_mul_ps(dual, inv_length);
+
+		__m128 const two = _mm_set1_ps(2.0f);
+		__m128 const real_w = _mm_shuffle_ps(real, real, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 const dual_w = _mm_shuffle_ps(dual, dual, _MM_SHUFFLE(3, 3, 3, 3));
+
+		// v' = v + 2 * r.xyz x (r.xyz x v + r.w * v), the cross products keep w at 0.
+		__m128 const p_inner = _mm_add_ps(Math::Cross(real, p), _mm_mul_ps(real_w, p));
+		__m128 const n_inner = _mm_add_ps(Math::Cross(real, n), _mm_mul_ps(real_w, n));
+
+		// t = 2 * (r.w * d.xyz - d.w * r.xyz + r.xyz x d.xyz), the vector part of 2 * dual * conjugate(real).
+		__m128 const translation = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(real_w, dual), _mm_mul_ps(dual_w, real)), Math::Cross(real, dual));
+
+		out_p = _mm_add_ps(p, _mm_mul_ps(two, _mm_add_ps(Math::Cross(real, p_inner), translation)));
+		out_n = _mm_add_ps(n, _mm_mul_ps(two, Math::Cross(real, n_inner)));
+	}
+
+	// q and -q are the same rotation, every joint is blended in the hemisphere of the first one.
+	static MM_FORCEINL void MM_VECTORCALL BlendDualQuatsSSE(DualQuat const* dual_quats, Gfx::Joints_t const& joints, f32 const* weights,
+		__m128& out_real, __m128& out_dual)
+	{
+		DualQuat const& dq0 = dual_quats[joints.index[0]];
+		DualQuat const& dq1 = dual_quats[joints.index[1]];
+		DualQuat const& dq2 = dual_quats[joints.index[2]];
+		DualQuat const& dq3 = dual_quats[joints.index[3]];
+
+		__m128 const r0 = _mm_loadu_ps(dq0.real.data);
+		__m128 const r1 = _mm_loadu_ps(dq1.real.data);
+		__m128 const r2 = _mm_loadu_ps(dq2.real.data);
+		__m128 const r3 = _mm_loadu_ps(dq3.real.data);
+
+		__m128 const w0 = _mm_set1_ps(weights[0]);
+		__m128 const w1 = _mm_xor_ps(_mm_set1_ps(weights[1]), DotSign(r1, r0));
+		__m128 const w2 = _mm_xor_ps(_mm_set1_ps(weights[2]), DotSign(r2, r0));
+		__m128 const w3 = _mm_xor_ps(_mm_set1_ps(weights[3]), DotSign(r3, r0));
+
+		out_real = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, r0), _mm_mul_ps(w1, r1)), _mm_add_ps(_mm_mul_ps(w2, r2), _mm_mul_ps(w3, r3)));
+		out_dual = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(w0, _mm_loadu_ps(dq0.dual.data)), _mm_mul_ps(w1, _mm_loadu_ps(dq1.dual.data))),
+			_mm_add_ps(_mm_mul_ps(w2, _mm_loadu_ps(dq2.dual.data)), _mm_mul_ps(w3, _mm_loadu_ps(dq3.dual.data))));
+	}
+
+	template <bool HAS_NORMALS>
+	static void SkinDualQuatSSE(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		DualQuat const* dual_quats, u64 begin, u64 end)
+	{
+		__m128 n = _mm_setzero_ps();
+
+		for (u64 i = begin; i < end; ++i)
+		{
+			Gfx::Joints_t const& joints = vertices.joints[i];
+			f32 const* weights = vertices.weights[i].data;
+
+			__m128 real, dual;
+			BlendDualQuatsSSE(dual_quats, joints, weights, real, dual);
+
+			__m128 const p = LoadVec3(vertices.positions[i].data);
+			if (HAS_NORMALS)
+			{
+				n = LoadVec3(vertices.normals[i].data);
+			}
+
+			__m128 skinned_p, skinned_n;
+			TransformDualQuat(real, dual, p, n, skinned_p, skinned_n);
+
+			StoreVec3(out_positions[i].data, skinned_p);
+			if (HAS_NORMALS)
+			{
+				StoreVec3(out_normals[i].data, NormalizeVec3(skinned_n));
+			}
+		}
+	}
+
+	// ====================================
+	//  8 Wide (AVX2)
+	// ====================================
+
+	// Joints are still blended one vertex at a time. The blended transforms of 8 vertices are then transposed, so
+	// every register holds one element of all 8, and the vertices are transformed without any horizontal math.
+
+	// rows[v] holds 8 floats of vertex v, afterwards rows[e] holds element e of all 8 vertices.
+	static SIMD_INLINE_AVX2 void Transpose8x8(__m256* rows)
+	{
+		__m256 const t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		__m256 const t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		__m256 const t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		__m256 const t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+		__m256 const t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+		__m256 const t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+		__m256 const t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+		__m256 const t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+		__m256 const s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 const s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 const s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 const s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 const s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 const s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 const s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 const s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+		rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+		rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+		rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+		rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+		rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+		rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+		rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+	}
+
+	// rows[v] holds 4 floats of vertex v and 4 of vertex v + 4, afterwards rows[e] holds element e of all 8 vertices.
+	static SIMD_INLINE_AVX2 void Transpose4x8(__m256* rows)
+	{
+		__m256 const t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		__m256 const t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		__m256 const t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		__m256 const t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+
+		rows[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		rows[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		rows[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		rows[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	static SIMD_INLINE_AVX2 void MM_VECTORCALL Cross8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz,
+		__m256& out_x, __m256& out_y, __m256& out_z)
+	{
+		out_x = _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by));
+		out_y = _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz));
+		out_z = _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx));
+	}
+
+	static SIMD_INLINE_AVX2 void MM_VECTORCALL BlendMatricesAVX2(mat34 const* matrices, Gfx::Joints_t const& joints, f32 const* weights,
+		__m256& out_row01, __m128& out_row2)
+	{
+		f32 const* m0 = matrices[joints.index[0]].data;
+		f32 const* m1 = matrices[joints.index[1]].data;
+		f32 const* m2 = matrices[joints.index[2]].data;
+		f32 const* m3 = matrices[joints.index[3]].data;
+
+		__m256 const w0 = _mm256_broadcast_ss(weights + 0);
+		__m256 const w1 = _mm256_broadcast_ss(weights + 1);
+		__m256 const w2 = _mm256_broadcast_ss(weights + 2);
+		__m256 const w3 = _mm256_broadcast_ss(weights + 3);
+
+		__m256 const a01 = _mm256_fmadd_ps(w1, _mm256_loadu_ps(m1), _mm256_mul_ps(w0, _mm256_loadu_ps(m0)));
+		__m256 const b01 = _mm256_fmadd_ps(w3, _mm256_loadu_ps(m3), _mm256_mul_ps(w2, _mm256_loadu_ps(m2)));
+		__m128 const a2 = _mm_fmadd_ps(_mm256_castps256_ps128(w1), _mm_loadu_ps(m1 + 8), _mm_mul_ps(_mm256_castps256_ps128(w0), _mm_loadu_ps(m0 + 8)));
+		__m128 const b2 = _mm_fmadd_ps(_mm256_castps256_ps128(w3), _mm_loadu_ps(m3 + 8), _mm_mul_ps(_mm256_castps256_ps128(w2), _mm_loadu_ps(m2 + 8)));
+
+		out_row01 = _mm256_add_ps(a01, b01);
+		out_row2 = _mm_add_ps(a2, b2);
+	}
+
+	// Real and dual part of a joint are one register, and blend together.
+	static SIMD_INLINE_AVX2 __m256 MM_VECTORCALL BlendDualQuatsAVX2(DualQuat const* dual_quats, Gfx::Joints_t const& joints, f32 const* weights)
+	{
+		__m256 const dq0 = _mm256_loadu_ps(dual_quats[joints.index[0]].real.data);
+		__m256 const dq1 = _mm256_loadu_ps(dual_quats[joints.index[1]].real.data);
+		__m256 const dq2 = _mm256_loadu_ps(dual_quats[joints.index[2]].real.data);
+		__m256 const dq3 = _mm256_loadu_ps(dual_quats[joints.index[3]].real.data);
+
+		__m128 const pivot = _mm256_castps256_ps128(dq0);
+		__m256 const w0 = _mm256_broadcast_ss(weights + 0);
+		__m256 const w1 = _mm256_broadcastss_ps(_mm_xor_ps(_mm_broadcast_ss(weights + 1), DotSign(_mm256_castps256_ps128(dq1), pivot)));
+		__m256 const w2 = _mm256_broadcastss_ps(_mm_xor_ps(_mm_broadcast_ss(weights + 2), DotSign(_mm256_castps256_ps128(dq2), pivot)));
+		__m256 const w3 = _mm256_broadcastss_ps(_mm_xor_ps(_mm_broadcast_ss(weights + 3), DotSign(_mm256_castps256_ps128(dq3), pivot)));
+
+		return _mm256_add_ps(_mm256_fmadd_ps(w1, dq1, _mm256_mul_ps(w0, dq0)), _mm256_fmadd_ps(w3, dq3, _mm256_mul_ps(w2, dq2)));
+	}
+
+	template <bool HAS_NORMALS>
+	static SIMD_TARGET_AVX2 void SkinLinearAVX2(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		mat34 const* matrices, u64 begin, u64 end)
+	{
+		u64 i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			// The first two rows of a matrix are one register, the third one is paired with the one of vertex v + 4.
+			__m256 m01[8];
+			__m128 row2s[8];
+			for (u32 v = 0; v < 8; ++v)
+			{
+				BlendMatricesAVX2(matrices, vertices.joints[i + v], vertices.weights[i + v].data, m01[v], row2s[v]);
+			}
+
+			__m256 m2[4];
+			for (u32 v = 0; v < 4; ++v)
+			{
+				m2[v] = _mm256_insertf128_ps(_mm256_castps128_ps256(row2s[v]), row2s[v + 4], 1);
+			}
+
+			Transpose8x8(m01);
+			Transpose4x8(m2);
+
+			__m256 px, py, pz;
+			Simd::LoadVec3x8(vertices.positions + i, px, py, pz);
+			__m256 const x = _mm256_fmadd_ps(m01[0], px, _mm256_fmadd_ps(m01[1], py, _mm256_fmadd_ps(m01[2], pz, m01[3])));
+			__m256 const y = _mm256_fmadd_ps(m01[4], px, _mm256_fmadd_ps(m01[5], py, _mm256_fmadd_ps(m01[6], pz, m01[7])));
+			__m256 const z = _mm256_fmadd_ps(m2[0], px, _mm256_fmadd_ps(m2[1], py, _mm256_fmadd_ps(m2[2], pz, m2[3])));
+			Simd::StoreVec3x8(out_positions + i, x, y, z);
+
+			if (HAS_NORMALS)
+			{
+				__m256 nx, ny, nz;
+				Simd::LoadVec3x8(vertices.normals + i, nx, ny, nz);
+				__m256 tx = _mm256_fmadd_ps(m01[0], nx, _mm256_fmadd_ps(m01[1], ny, _mm256_mul_ps(m01[2], nz)));
+				__m256 ty = _mm256_fmadd_ps(m01[4], nx, _mm256_fmadd_ps(m01[5], ny, _mm256_mul_ps(m01[6], nz)));
+				__m256 tz = _mm256_fmadd_ps(m2[0], nx, _mm256_fmadd_ps(m2[1], ny, _mm256_mul_ps(m2[2], nz)));
+				Simd::NormalizeVec3x8(tx, ty, tz);
+				Simd::StoreVec3x8(out_normals + i, tx, ty, tz);
+			}
+		}
+
+		SkinLinearSSE<HAS_NORMALS>(out_positions, out_normals, vertices, matrices, i, end);
+	}
+
+	template <bool HAS_NORMALS>
+	static SIMD_TARGET_AVX2 void SkinDualQuatAVX2(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		DualQuat const* dual_quats, u64 begin, u64 end)
+	{
+		static_assert(sizeof(DualQuat) == sizeof(__m256), "A dual quaternion should be 8 floats!");
+
+		u64 i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 blended[8];
+			for (u32 v = 0; v < 8; ++v)
+			{
+				blended[v] = BlendDualQuatsAVX2(dual_quats, vertices.joints[i + v], vertices.weights[i + v].data);
+			}
+
+			Transpose8x8(blended);
+
+			__m256 length_sq = _mm256_fmadd_ps(blended[0], blended[0], _mm256_fmadd_ps(blended[1], blended[1],
+				_mm256_fmadd_ps(blended[2], blended[2], _mm256_mul_ps(blended[3], blended[3]))));
+			length_sq = _mm256_max_ps(length_sq, _mm256_set1_ps(1e-30f));
+			__m256 const inv_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length_sq));
+
+			__m256 const rx = _mm256_mul_ps(blended[0], inv_length);
+			__m256 const ry = _mm256_mul_ps(blended[1], inv_length);
+			__m256 const rz = _mm256_mul_ps(blended[2], inv_length);
+			__m256 const rw = _mm256_mul_ps(blended[3], inv_length);
+			__m256 const dx = _mm256_mul_ps(blended[4], inv_length);
+			__m256 const dy = _mm256_mul_ps(blended[5], inv_length);
+			__m256 const dz = _mm256_mul_ps(blended[6], inv_length);
+			__m256 const dw = _mm256_mul_ps(blended[7], inv_length);
+
+			__m256 const two = _mm256_set1_ps(2.0f);
+
+			// Same math as TransformDualQuat().
+			__m256 cx, cy, cz;
+			Cross8(rx, ry, rz, dx, dy, dz, cx, cy, cz);
+			__m256 const tx = _mm256_fmadd_ps(rw, dx, _mm256_fnmadd_ps(dw, rx, cx));
+			__m256 const ty = _mm256_fmadd_ps(rw, dy, _mm256_fnmadd_ps(dw, ry, cy));
+			__m256 const tz = _mm256_fmadd_ps(rw, dz, _mm256_fnmadd_ps(dw, rz, cz));
+
+			__m256 px, py, pz;
+			Simd::LoadVec3x8(vertices.positions + i, px, py, pz);
+			Cross8(rx, ry, rz, px, py, pz, cx, cy, cz);
+			Cross8(rx, ry, rz, _mm256_fmadd_ps(rw, px, cx), _mm256_fmadd_ps(rw, py, cy), _mm256_fmadd_ps(rw, pz, cz), cx, cy, cz);
+			Simd::StoreVec3x8(out_positions + i,
+				_mm256_fmadd_ps(two, _mm256_add_ps(cx, tx), px),
+				_mm256_fmadd_ps(two, _mm256_add_ps(cy, ty), py),
+				_mm256_fmadd_ps(two, _mm256_add_ps(cz, tz), pz));
+
+			if (HAS_NORMALS)
+			{
+				__m256 nx, ny, nz;
+				Simd::LoadVec3x8(vertices.normals + i, nx, ny, nz);
+				Cross8(rx, ry, rz, nx, ny, nz, cx, cy, cz);
+				Cross8(rx, ry, rz, _mm256_fmadd_ps(rw, nx, cx), _mm256_fmadd_ps(rw, ny, cy), _mm256_fmadd_ps(rw, nz, cz), cx, cy, cz);
+				nx = _mm256_fmadd_ps(two, cx, nx);
+				ny = _mm256_fmadd_ps(two, cy, ny);
+				nz = _mm256_fmadd_ps(two, cz, nz);
+				Simd::NormalizeVec3x8(nx, ny, nz);
+				Simd::StoreVec3x8(out_normals + i, nx, ny, nz);
+			}
+		}
+
+		SkinDualQuatSSE<HAS_NORMALS>(out_positions, out_normals, vertices, dual_quats, i, end);
+	}
+
+	// ====================================
+	//  Jobs
+	// ====================================
+
+	typedef void (*SkinRangeFunc)(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		void const* joint_transforms, u64 begin, u64 end);
+
+	struct SkinTask
+	{
+		Gfx::Position_t* out_positions;
+		Gfx::Normal_t* out_normals;
+		SkinnedVertices vertices;
+		void const* joint_transforms;
+		SkinRangeFunc func;
+	};
+
+	static void SkinBatch(void* user_data, u64 begin, u64 end)
+	{
+		SkinTask const* task = static_cast<SkinTask const*>(user_data);
+		task->func(task->out_positions, task->out_normals, task->vertices, task->joint_transforms, begin, end);
+	}
+
+	template <typename Transform, void (*KERNEL)(Gfx::Position_t*, Gfx::Normal_t*, SkinnedVertices const&, Transform const*, u64, u64)>
+	static void SkinRange(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		void const* joint_transforms, u64 begin, u64 end)
+	{
+		KERNEL(out_positions, out_normals, vertices, static_cast<Transform const*>(joint_transforms), begin, end);
+	}
+
+	static void Skin(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		void const* joint_transforms, u32 num_joints, SkinRangeFunc func)
+	{
+#ifdef _DEBUG
+		for (u32 i = 0; i < vertices.num_vertices; ++i)
+		{
+			Gfx::Joints_t const& joints = vertices.joints[i];
+			ASSERT_F(max(max(joints.index[0], joints.index[1]), max(joints.index[2], joints.index[3])) < num_joints,
+				"Vertex %u uses a joint the skin doesn't have!", i);
+		}
+#else
+		UNUSED(num_joints);
+#endif
+
+		SkinTask task;
+		task.out_positions = out_positions;
+		task.out_normals = out_normals;
+		task.vertices = vertices;
+		task.joint_transforms = joint_transforms;
+		task.func = func;
+
+		if (vertices.num_vertices < PARALLEL_MIN_VERTICES || Jobs::GetThreadCount() == 1)
+		{
+			SkinBatch(&task, 0, vertices.num_vertices);
+			return;
+		}
+
+		Jobs::ParallelFor(vertices.num_vertices, PARALLEL_BATCH_SIZE, &SkinBatch, &task);
+	}
+
+	void SkinLinear(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		mat34 const* joint_matrices, u32 num_joints)
+	{
+		Simd::CpuFeatures const& features = Simd::GetCpuFeatures();
+		bool const use_avx2 = features.avx2 && features.fma;
+		bool const has_normals = vertices.normals != nullptr && out_normals != nullptr;
+
+		SkinRangeFunc func;
+		if (use_avx2)
+		{
+			func = has_normals ? &SkinRange<mat34, &SkinLinearAVX2<true>> : &SkinRange<mat34, &SkinLinearAVX2<false>>;
+		}
+		else
+		{
+			func = has_normals ? &SkinRange<mat34, &SkinLinearSSE<true>> : &SkinRange<mat34, &SkinLinearSSE<false>>;
+		}
+
+		Skin(out_positions, out_normals, vertices, joint_matrices, num_joints, func);
+	}
+
+	void SkinDualQuat(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		DualQuat const* joint_dual_quats, u32 num_joints)
+	{
+		Simd::CpuFeatures const& features = Simd::GetCpuFeatures();
+		bool const use_avx2 = features.avx2 && features.fma;
+		bool const has_normals = vertices.normals != nullptr && out_normals != nullptr;
+
+		SkinRangeFunc func;
+		if (use_avx2)
+		{
+			func = has_normals ? &SkinRange<DualQuat, &SkinDualQuatAVX2<true>> : &SkinRange<DualQuat, &SkinDualQuatAVX2<false>>;
+		}
+		else
+		{
+			func = has_normals ? &SkinRange<DualQuat, &SkinDualQuatSSE<true>> : &SkinRange<DualQuat, &SkinDualQuatSSE<false>>;
+		}
+
+		Skin(out_positions, out_normals, vertices, joint_dual_quats, num_joints, func);
+	}
+}
\ No newline at end of file
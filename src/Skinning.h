@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Core.h"
+#include "GfxTypes.h"
+#include "Math.h"
+#include "SceneGraph.h"
+
+// ====================================
+//  CPU Skinning
+//  Notes:
+//  *) Poses the vertices of glTF skins on the CPU, for headless
+//     servers that need skinned bounds or hit tests, and for
+//     streams that are uploaded with UpdateBuffer.
+//  *) Linear blend skinning (LBS) blends the joint matrices. It
+//     keeps scale, but loses volume at twisting joints.
+//  *) Dual quaternion skinning (DQS) blends rigid transforms, see
+//     Kavan et al., "Skinning with Dual Quaternions" (2007). No
+//     candy wrapper artifacts, but joint scale is dropped.
+//  *) Normals go through the blended rotation (and scale, with
+//     LBS) and are normalized again, non-uniform scale skews them.
+//  *) Jobs split the vertices into ranges, the kernels are AVX2
+//     and FMA when available and SSE4.1 otherwise.
+// ====================================
+
+namespace Skinning
+{
+	// Rigid transform, rotation in real and translation t in dual = 0.5 * (t, 0) * real.
+	struct DualQuat
+	{
+		quat real;
+		quat dual;
+	};
+
+	// Vertices of one skinned instance, e.g. the streams of a MeshImport from a submesh's base vertex on.
+	struct SkinnedVertices
+	{
+		Gfx::Position_t const* positions;
+		Gfx::Normal_t const* normals; // Optional.
+		Gfx::Joints_t const* joints;
+		Gfx::Weights_t const* weights;
+		u32 num_vertices;
+	};
+
+	// Joint matrix i takes bind pose vertices to where joint_nodes[i] has them now, world transform times inverse
+	// bind matrix. glTF skins end up in world space, pass the node of the instance as mesh_node to get them relative
+	// to it instead, so they can be drawn with the instance transform. Scene::INVALID_NODE keeps world space.
+	void ComputeJointMatrices(mat34* out_matrices, Scene::Hierarchy const* hierarchy, u32 const* joint_nodes,
+		mat34 const* inverse_bind_matrices, u32 num_joints, u32 mesh_node);
+
+	// Rigid part of the joint matrices, scale and shear are dropped.
+	void ComputeJointDualQuats(DualQuat* out_dual_quats, mat34 const* joint_matrices, u32 num_joints);
+
+	// Below this many vertices the kernels stay on the calling thread.
+	static constexpr u32 PARALLEL_MIN_VERTICES = 16 * 1024;
+
+	// Write tightly packed streams, which may not alias the inputs. out_normals is ignored without source normals.
+	// Every joint index has to be below num_joints, unused joints included. Blocks until all vertices are done.
+	void SkinLinear(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		mat34 const* joint_matrices, u32 num_joints);
+
+	void SkinDualQuat(Gfx::Position_t* out_positions, Gfx::Normal_t* out_normals, SkinnedVertices const& vertices,
+		DualQuat const* joint_dual_quats, u32 num_joints);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "Skinning.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+namespace Skinning
+{
+namespace Test
+{
+	static constexpr u32 NUM_JOINTS = 7;
+	static constexpr f32 GUARD = 12345.0f;
+
+	struct Mesh
+	{
+		Gfx::Position_t* positions;
+		Gfx::Normal_t* normals;
+		Gfx::Joints_t* joints;
+		Gfx::Weights_t* weights;
+		u32 num_vertices;
+	};
+
+	// Unit normals, except for every 13th vertex that has none (zero). Every 17th vertex has no weights
+	// at all, the others use 1 to 4 joints.
+	static void InitMesh(Mesh* mesh, u32 num_vertices, TestUtils::Random& random)
+	{
+		mesh->positions = new Gfx::Position_t[num_vertices];
+		mesh->normals = new Gfx::Normal_t[num_vertices];
+		mesh->joints = new Gfx::Joints_t[num_vertices];
+		mesh->weights = new Gfx::Weights_t[num_vertices];
+		mesh->num_vertices = num_vertices;
+
+		for (u32 i = 0; i < num_vertices; ++i)
+		{
+			mesh->positions[i] = vec3(random.Float(-2.0f, 2.0f), random.Float(-2.0f, 2.0f), random.Float(-2.0f, 2.0f));
+			vec3 const normal(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f) + 2.0f);
+			mesh->normals[i] = (i % 13 == 0) ? vec3(0.0f, 0.0f, 0.0f) : Math::Normalize(normal);
+
+			u32 const num_used = 1 + random.Index(4);
+			f32 sum = 0.0f;
+			for (u32 j = 0; j < 4; ++j)
+			{
+				mesh->joints[i].index[j] = (u16)random.Index(NUM_JOINTS);
+				mesh->weights[i].data[j] = (j < num_used && i % 17 != 0) ? random.Float(0.05f, 1.0f) : 0.0f;
+				sum += mesh->weights[i].data[j];
+			}
+			for (u32 j = 0; j < 4 && sum > 0.0f; ++j)
+			{
+				mesh->weights[i].data[j] /= sum;
+			}
+		}
+	}
+
+	static void FreeMesh(Mesh* mesh)
+	{
+		delete[] mesh->positions;
+		delete[] mesh->normals;
+		delete[] mesh->joints;
+		delete[] mesh->weights;
+	}
+
+	static SkinnedVertices GetVertices(Mesh const& mesh, u32 num_vertices)
+	{
+		return { mesh.positions, mesh.normals, mesh.joints, mesh.weights, num_vertices };
+	}
+
+	// Rigid, so the dual quaternions describe the same transforms. With b_scaled the matrices get a
+	// non uniform scale, only linear blending supports that.
+	static void InitJoints(mat34* matrices, TestUtils::Random& random, bool b_scaled)
+	{
+		for (u32 i = 0; i < NUM_JOINTS; ++i)
+		{
+			vec3 const axis = Math::Normalize(vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(0.1f, 1.0f)));
+			quat const rotation = Math::QuatAxisAngle(axis, Math::Rad(random.Float(-3.0f, 3.0f)));
+			vec3 const translation(random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f));
+			vec3 const scale = b_scaled ? vec3(random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f), random.Float(0.5f, 2.0f)) : vec3(1.0f, 1.0f, 1.0f);
+			matrices[i] = Math::TRS<mat34>(translation, rotation, scale);
+		}
+	}
+
+	static vec3 TransformPoint(mat34 const& mat, vec3 p, f32 w)
+	{
+		return vec3(
+			mat(0, 0) * p.x + mat(0, 1) * p.y + mat(0, 2) * p.z + mat(0, 3) * w,
+			mat(1, 0) * p.x + mat(1, 1) * p.y + mat(1, 2) * p.z + mat(1, 3) * w,
+			mat(2, 0) * p.x + mat(2, 1) * p.y + mat(2, 2) * p.z + mat(2, 3) * w);
+	}
+
+	// Zero stays zero, like in the kernels.
+	static vec3 NormalizeOrZero(vec3 v)
+	{
+		f32 const length = Math::Length(v);
+		return length > 0.0f ? vec3(v.x / length, v.y / length, v.z / length) : v;
+	}
+
+	static bool Near(vec3 a, vec3 b)
+	{
+		for (u32 i = 0; i < 3; ++i)
+		{
+			if (fabsf(a.data[i] - b.data[i]) > 1e-4f * (1.0f + fabsf(b.data[i])))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Scalar reference: the weighted sum of the matrices applied to the position and normal.
+	static void SkinLinearScalar(vec3* out_p, vec3* out_n, Mesh const& mesh, u32 i, mat34 const* matrices)
+	{
+		mat34 blended;
+		for (u32 e = 0; e < 12; ++e)
+		{
+			blended.data[e] = 0.0f;
+			for (u32 j = 0; j < 4; ++j)
+			{
+				blended.data[e] += mesh.weights[i].data[j] * matrices[mesh.joints[i].index[j]].data[e];
+			}
+		}
+
+		*out_p = TransformPoint(blended, mesh.positions[i], 1.0f);
+		*out_n = NormalizeOrZero(TransformPoint(blended, mesh.normals[i], 0.0f));
+	}
+
+	// Scalar reference, written differently from the kernels: the blended and normalized dual quaternion is
+	// turned into a rotation matrix and the translation 2 * dual * conjugate(real).
+	static void SkinDualQuatScalar(vec3* out_p, vec3* out_n, Mesh const& mesh, u32 i, DualQuat const* dual_quats)
+	{
+		quat const& first = dual_quats[mesh.joints[i].index[0]].real;
+		f32 real[4] = {};
+		f32 dual[4] = {};
+		for (u32 j = 0; j < 4; ++j)
+		{
+			DualQuat const& dq = dual_quats[mesh.joints[i].index[j]];
+			f32 const hemisphere = (dq.real.x * first.x + dq.real.y * first.y + dq.real.z * first.z + dq.real.w * first.w) < 0.0f ? -1.0f : 1.0f;
+			for (u32 e = 0; e < 4; ++e)
+			{
+				real[e] += hemisphere * mesh.weights[i].data[j] * dq.real.data[e];
+				dual[e] += hemisphere * mesh.weights[i].data[j] * dq.dual.data[e];
+			}
+		}
+
+		f32 const length = sqrtf(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+		f32 const inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+		quat const r(real[0] * inv_length, real[1] * inv_length, real[2] * inv_length, real[3] * inv_length);
+		quat const d(dual[0] * inv_length, dual[1] * inv_length, dual[2] * inv_length, dual[3] * inv_length);
+
+		// Without weights r is zero, which Rotation() turns into the identity.
+		mat34 mat = Math::Rotation<mat34>(r);
+		vec3 const r_xyz(r.x, r.y, r.z);
+		vec3 const d_xyz(d.x, d.y, d.z);
+		vec3 const r_cross_d = Math::Cross(r_xyz, d_xyz);
+		mat(0, 3) = 2.0f * (r.w * d.x - d.w * r.x + r_cross_d.x);
+		mat(1, 3) = 2.0f * (r.w * d.y - d.w * r.y + r_cross_d.y);
+		mat(2, 3) = 2.0f * (r.w * d.z - d.w * r.z + r_cross_d.z);
+
+		*out_p = TransformPoint(mat, mesh.positions[i], 1.0f);
+		*out_n = NormalizeOrZero(TransformPoint(mat, mesh.normals[i], 0.0f));
+	}
+
+	// The outputs have one guard vertex past the end, the kernels store exactly 12 bytes per vertex.
+	template <typename Transform, typename SkinFunc, typename ScalarFunc>
+	static void CheckAgainstScalar(Mesh const& mesh, Transform const* transforms, SkinFunc skin, ScalarFunc scalar)
+	{
+		u32 const max_vertices = mesh.num_vertices - 1;
+		vec3* out_positions = new vec3[max_vertices + 1];
+		vec3* out_normals = new vec3[max_vertices + 1];
+		ON_SCOPE_EXIT(delete[] out_positions; delete[] out_normals);
+
+		// Every count up to a few 8 wide steps covers the AVX2 tails, the last one the parallel path.
+		u32 counts[41];
+		for (u32 i = 0; i < 40; ++i)
+		{
+			counts[i] = i;
+		}
+		counts[40] = max_vertices;
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			for (u32 num_vertices : counts)
+			{
+				for (bool b_normals : { true, false })
+				{
+					for (u32 i = 0; i <= num_vertices; ++i)
+					{
+						out_positions[i] = out_normals[i] = vec3(GUARD, GUARD, GUARD);
+					}
+
+					SkinnedVertices vertices = GetVertices(mesh, num_vertices);
+					vertices.normals = b_normals ? mesh.normals : nullptr;
+					skin(out_positions, b_normals ? out_normals : nullptr, vertices, transforms, NUM_JOINTS);
+
+					for (u32 i = 0; i < num_vertices; ++i)
+					{
+						vec3 expected_p, expected_n;
+						scalar(&expected_p, &expected_n, mesh, i, transforms);
+						ASSERT(Near(out_positions[i], expected_p));
+						ASSERT(b_normals ? Near(out_normals[i], expected_n) : out_normals[i].x == GUARD);
+					}
+					ASSERT(out_positions[num_vertices].x == GUARD && out_positions[num_vertices].z == GUARD);
+					ASSERT(out_normals[num_vertices].x == GUARD && out_normals[num_vertices].z == GUARD);
+				}
+			}
+		});
+	}
+
+	void LinearMatchesScalar()
+	{
+		TestUtils::Random random;
+		Mesh mesh;
+		InitMesh(&mesh, PARALLEL_MIN_VERTICES * 2 + 6, random);
+		ON_SCOPE_EXIT(FreeMesh(&mesh));
+
+		mat34 matrices[NUM_JOINTS];
+		InitJoints(matrices, random, true);
+		CheckAgainstScalar(mesh, matrices, &SkinLinear, &SkinLinearScalar);
+	}
+
+	void DualQuatMatchesScalar()
+	{
+		TestUtils::Random random;
+		Mesh mesh;
+		InitMesh(&mesh, PARALLEL_MIN_VERTICES * 2 + 6, random);
+		ON_SCOPE_EXIT(FreeMesh(&mesh));
+
+		mat34 matrices[NUM_JOINTS];
+		DualQuat dual_quats[NUM_JOINTS];
+		InitJoints(matrices, random, false);
+		ComputeJointDualQuats(dual_quats, matrices, NUM_JOINTS);
+
+		// Flips some of them into the other hemisphere, which is the same transform.
+		for (u32 i = 1; i < NUM_JOINTS; i += 2)
+		{
+			for (u32 e = 0; e < 4; ++e)
+			{
+				dual_quats[i].real.data[e] = -dual_quats[i].real.data[e];
+				dual_quats[i].dual.data[e] = -dual_quats[i].dual.data[e];
+			}
+		}
+		CheckAgainstScalar(mesh, dual_quats, &SkinDualQuat, &SkinDualQuatScalar);
+	}
+
+	// A single joint with full weight is a rigid transform, both blends have to agree with the matrix.
+	void SingleJointMatchesMatrix()
+	{
+		static constexpr u32 NUM_VERTICES = 37;
+		TestUtils::Random random;
+		Mesh mesh;
+		InitMesh(&mesh, NUM_VERTICES, random);
+		ON_SCOPE_EXIT(FreeMesh(&mesh));
+
+		mat34 matrices[NUM_JOINTS];
+		DualQuat dual_quats[NUM_JOINTS];
+		InitJoints(matrices, random, false);
+		ComputeJointDualQuats(dual_quats, matrices, NUM_JOINTS);
+
+		for (u32 i = 0; i < NUM_VERTICES; ++i)
+		{
+			mesh.joints[i].index[0] = (u16)(i % NUM_JOINTS);
+			mesh.weights[i] = vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		}
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			vec3 linear_p[NUM_VERTICES], linear_n[NUM_VERTICES];
+			vec3 dual_quat_p[NUM_VERTICES], dual_quat_n[NUM_VERTICES];
+			SkinnedVertices const vertices = GetVertices(mesh, NUM_VERTICES);
+			SkinLinear(linear_p, linear_n, vertices, matrices, NUM_JOINTS);
+			SkinDualQuat(dual_quat_p, dual_quat_n, vertices, dual_quats, NUM_JOINTS);
+
+			for (u32 i = 0; i < NUM_VERTICES; ++i)
+			{
+				mat34 const& mat = matrices[i % NUM_JOINTS];
+				vec3 const expected_p = TransformPoint(mat, mesh.positions[i], 1.0f);
+				vec3 const expected_n = TransformPoint(mat, mesh.normals[i], 0.0f);
+				ASSERT(Near(linear_p[i], expected_p) && Near(linear_n[i], expected_n));
+				ASSERT(Near(dual_quat_p[i], expected_p) && Near(dual_quat_n[i], expected_n));
+			}
+		});
+	}
+
+	void Run()
+	{
+		LinearMatchesScalar();
+		DualQuatMatchesScalar();
+		SingleJointMatchesMatrix();
+	}
+}
+}
@@ -0,0 +1,459 @@
+#include "StreamCopy.h"
+#include "Simd.h"
+
+#include <float.h>
+
+namespace StreamCopy
+{
+	static void DeinterleaveScalar(u8* dst, u8 const* src, u64 count, u32 element_size, u32 src_stride)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			memcpy(dst + i * element_size, src + i * src_stride, element_size);
+		}
+	}
+
+	// Loads 16 bytes per element and packs 4 elements into 3 stores. The over-read stays inside
+	// the element's stride, except for the very last element, which is left to the scalar tail.
+	template <u32 StaticStride>
+	static void Deinterleave12(u8* dst, u8 const* src, u64 count, u32 src_stride)
+	{
+		u64 const stride = StaticStride ? StaticStride : src_stride;
+		ASSERT(stride >= 16);
+
+		u64 i = 0;
+		for (; i + 4 < count; i += 4)
+		{
+			u8 const* block = src + i * stride;
+
+			__m128 e0 = _mm_loadu_ps(reinterpret_cast<f32 const*>(block + 0 * stride)); // x0 y0 z0 --
+			__m128 e1 = _mm_loadu_ps(reinterpret_cast<f32 const*>(block + 1 * stride)); // x1 y1 z1 --
+			__m128 e2 = _mm_loadu_ps(reinterpret_cast<f32 const*>(block + 2 * stride)); // x2 y2 z2 --
+			__m128 e3 = _mm_loadu_ps(reinterpret_cast<f32 const*>(block + 3 * stride)); // x3 y3 z3 --
+
+			__m128 a = _mm_blend_ps(e0, _mm_shuffle_ps(e1, e1, _MM_SHUFFLE(0, 0, 0, 0)), 0x8); // x0 y0 z0 x1
+			__m128 b = _mm_shuffle_ps(e1, e2, _MM_SHUFFLE(1, 0, 2, 1));                         // y1 z1 x2 y2
+			__m128 c = _mm_blend_ps(_mm_shuffle_ps(e3, e3, _MM_SHUFFLE(2, 1, 0, 0)),
+				_mm_shuffle_ps(e2, e2, _MM_SHUFFLE(2, 2, 2, 2)), 0x1);                          // z2 x3 y3 z3
+
+			f32* out = reinterpret_cast<f32*>(dst + i * 12);
+			_mm_storeu_ps(out + 0, a);
+			_mm_storeu_ps(out + 4, b);
+			_mm_storeu_ps(out + 8, c);
+		}
+
+		DeinterleaveScalar(dst + i * 12, src + i * stride, count - i, 12, (u32)stride);
+	}
+
+	static void Deinterleave8(u8* dst, u8 const* src, u64 count, u32 src_stride)
+	{
+		u64 i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			__m128i e0 = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + (i + 0) * src_stride));
+			__m128i e1 = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + (i + 1) * src_stride));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8), _mm_unpacklo_epi64(e0, e1));
+		}
+
+		DeinterleaveScalar(dst + i * 8, src + i * src_stride, count - i, 8, src_stride);
+	}
+
+	static void Deinterleave16(u8* dst, u8 const* src, u64 count, u32 src_stride)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			__m128i e = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * src_stride));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 16), e);
+		}
+	}
+
+	void Deinterleave(void* dst, void const* src, u64 count, u32 element_size, u32 src_stride)
+	{
+		u8* dst_bytes = static_cast<u8*>(dst);
+		u8 const* src_bytes = static_cast<u8 const*>(src);
+
+		ASSERT(src_stride >= element_size);
+
+		if (src_stride == element_size)
+		{
+			memcpy(dst_bytes, src_bytes, count * element_size);
+			return;
+		}
+
+		switch (element_size)
+		{
+		case 8:
+			Deinterleave8(dst_bytes, src_bytes, count, src_stride);
+			return;
+		case 12:
+			switch (src_stride)
+			{
+			case 20: Deinterleave12<20>(dst_bytes, src_bytes, count, src_stride); return;
+			case 32: Deinterleave12<32>(dst_bytes, src_bytes, count, src_stride); return;
+			case 48: Deinterleave12<48>(dst_bytes, src_bytes, count, src_stride); return;
+			default:
+				if (src_stride >= 16)
+				{
+					Deinterleave12<0>(dst_bytes, src_bytes, count, src_stride);
+					return;
+				}
+				break;
+			}
+			break;
+		case 16:
+			Deinterleave16(dst_bytes, src_bytes, count, src_stride);
+			return;
+		}
+
+		DeinterleaveScalar(dst_bytes, src_bytes, count, element_size, src_stride);
+	}
+
+	template <u32 ElementSize>
+	static void GatherFixed(u8* dst, u8 const* src, u32 const* src_elements, u64 count, u32 src_stride)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			memcpy(dst + i * ElementSize, src + (u64)src_elements[i] * src_stride, ElementSize);
+		}
+	}
+
+	void Gather(void* dst, void const* src, u32 const* src_elements, u64 count, u32 element_size, u32 src_stride)
+	{
+		u8* dst_bytes = static_cast<u8*>(dst);
+		u8 const* src_bytes = static_cast<u8 const*>(src);
+
+		ASSERT(src_stride >= element_size);
+
+		// Fixed sizes let the copies compile to plain loads and stores.
+		switch (element_size)
+		{
+		case 8:  GatherFixed<8>(dst_bytes, src_bytes, src_elements, count, src_stride); return;
+		case 12: GatherFixed<12>(dst_bytes, src_bytes, src_elements, count, src_stride); return;
+		case 16: GatherFixed<16>(dst_bytes, src_bytes, src_elements, count, src_stride); return;
+		default:
+			for (u64 i = 0; i < count; ++i)
+			{
+				memcpy(dst_bytes + i * element_size, src_bytes + (u64)src_elements[i] * src_stride, element_size);
+			}
+			return;
+		}
+	}
+
+	static constexpr u32 COMPONENT_SIZES[ComponentType::EnumCount] = { 1, 1, 2, 2, 4, 4 };
+
+	u32 GetComponentSize(ComponentType::Enum type)
+	{
+		ASSERT(type < ComponentType::EnumCount);
+		return COMPONENT_SIZES[type];
+	}
+
+	// Loads exactly Size bytes into the low end of a register, the rest is zero. Odd sizes are put together
+	// from scalar loads, going through memory would stall on store forwarding.
+	template <u32 Size>
+	static MM_FORCEINL __m128i LoadElement(u8 const* src)
+	{
+		u32 dword = 0;
+		u16 word = 0;
+		switch (Size)
+		{
+		case 16:
+			return _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+		case 12:
+		{
+			u32 z;
+			memcpy(&z, src + 8, sizeof(z));
+			return _mm_insert_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src)), (s32)z, 2);
+		}
+		case 8:
+			return _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src));
+		case 6:
+			memcpy(&dword, src, sizeof(dword));
+			memcpy(&word, src + 4, sizeof(word));
+			return _mm_insert_epi16(_mm_cvtsi32_si128((s32)dword), word, 2);
+		case 4:
+			memcpy(&dword, src, sizeof(dword));
+			return _mm_cvtsi32_si128((s32)dword);
+		case 3:
+			memcpy(&word, src, sizeof(word));
+			return _mm_cvtsi32_si128((s32)(word | ((u32)src[2] << 16)));
+		case 2:
+			memcpy(&word, src, sizeof(word));
+			return _mm_cvtsi32_si128(word);
+		default:
+			ASSERT(Size == 1);
+			return _mm_cvtsi32_si128(src[0]);
+		}
+	}
+
+	template <u32 Size>
+	static MM_FORCEINL void StoreElement(u8* dst, __m128i v)
+	{
+		switch (Size)
+		{
+		case 16:
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+			return;
+		case 12:
+		{
+			u32 const z = (u32)_mm_extract_epi32(v, 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), v);
+			memcpy(dst + 8, &z, sizeof(z));
+			return;
+		}
+		case 8:
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), v);
+			return;
+		default:
+		{
+			u64 const bits = (u64)_mm_cvtsi128_si64(v);
+			memcpy(dst, &bits, Size);
+			return;
+		}
+		}
+	}
+
+	// Components in the low lanes, as floats with their integer value.
+	template <ComponentType::Enum Type>
+	static MM_FORCEINL __m128 WidenToFloat(__m128i v)
+	{
+		switch (Type)
+		{
+		case ComponentType::S8:  return _mm_cvtepi32_ps(_mm_cvtepi8_epi32(v));
+		case ComponentType::U8:  return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v));
+		case ComponentType::S16: return _mm_cvtepi32_ps(_mm_cvtepi16_epi32(v));
+		case ComponentType::U16: return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v));
+		case ComponentType::U32:
+		{
+			// There is no unsigned conversion before AVX-512, both halves convert exactly and the sum rounds once.
+			__m128 const hi = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+			__m128 const lo = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xffff)));
+			return _mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.0f)), lo);
+		}
+		default:
+			return _mm_castsi128_ps(v);
+		}
+	}
+
+	// Rounds the (already clamped) floats and packs them to the components of the type.
+	template <ComponentType::Enum Type>
+	static MM_FORCEINL __m128i NarrowFromFloat(__m128 v)
+	{
+		switch (Type)
+		{
+		case ComponentType::S8:
+		{
+			__m128i const words = _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+			return _mm_packs_epi16(words, _mm_setzero_si128());
+		}
+		case ComponentType::U8:
+		{
+			__m128i const words = _mm_packus_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+			return _mm_packus_epi16(words, _mm_setzero_si128());
+		}
+		case ComponentType::S16: return _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+		case ComponentType::U16: return _mm_packus_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+		case ComponentType::U32:
+		{
+			// Values from 2^31 up are converted 2^32 lower, which leaves the same bits as the unsigned value.
+			__m128 const b_high = _mm_cmpge_ps(v, _mm_set1_ps(2147483648.0f));
+			return _mm_cvtps_epi32(_mm_sub_ps(v, _mm_and_ps(b_high, _mm_set1_ps(4294967296.0f))));
+		}
+		default:
+			return _mm_castps_si128(v);
+		}
+	}
+
+	// Scale and lower bound (for signed normalized values) of the integer value, and the sign bits of negate_mask.
+	struct ConversionParams
+	{
+		__m128 scale;
+		__m128 minimum;
+		__m128 maximum;
+		__m128 sign_mask;
+	};
+
+	static ConversionParams GetConversionParams(ComponentType::Enum type, bool b_normalized, u32 negate_mask, bool b_read)
+	{
+		// Range of the integer value, or of the normalized one for normalized types.
+		static constexpr f32 RANGES[ComponentType::EnumCount][2] =
+		{
+			{ -128.0f, 127.0f },
+			{ 0.0f, 255.0f },
+			{ -32768.0f, 32767.0f },
+			{ 0.0f, 65535.0f },
+			{ 0.0f, 4294967040.0f }, // The largest float below 2^32.
+			{ -FLT_MAX, FLT_MAX },
+		};
+
+		ASSERT_F(!b_normalized || (type != ComponentType::U32 && type != ComponentType::F32), "Only 8 and 16 bit components can be normalized!");
+
+		f32 scale = 1.0f;
+		f32 minimum = RANGES[type][0];
+		f32 const maximum = RANGES[type][1];
+		if (b_normalized && type < ComponentType::U32)
+		{
+			// Signed values use the symmetric range, the lowest integer maps to -1 as well.
+			scale = b_read ? 1.0f / maximum : maximum;
+			minimum = b_read ? max(minimum * scale, -1.0f) : -maximum;
+		}
+
+		ConversionParams params;
+		params.scale = _mm_set1_ps(scale);
+		params.minimum = _mm_set1_ps(minimum);
+		params.maximum = _mm_set1_ps(maximum);
+		params.sign_mask = _mm_castsi128_ps(_mm_setr_epi32((negate_mask & 1) ? 0x80000000 : 0, (negate_mask & 2) ? 0x80000000 : 0,
+			(negate_mask & 4) ? 0x80000000 : 0, (negate_mask & 8) ? 0x80000000 : 0));
+		return params;
+	}
+
+	// Full 4 lane stores run into the next element, which is written right after. Only the elements at
+	// the end, where that would go past dst, are stored exactly.
+	template <ComponentType::Enum Type, u32 NumComponents, bool Gather>
+	static void ReadKernel(f32* dst, u8 const* src, u32 const* src_elements, u64 count, u32 src_stride, ConversionParams const& params)
+	{
+		static constexpr u32 ELEMENT_SIZE = COMPONENT_SIZES[Type] * NumComponents;
+
+		__m128 const scale = params.scale;
+		__m128 const minimum = params.minimum;
+		__m128 const sign_mask = params.sign_mask;
+
+		u64 const num_full_stores = count - min<u64>(count, (4 + NumComponents - 1) / NumComponents - 1);
+		for (u64 i = 0; i < count; ++i)
+		{
+			u64 const element = Gather ? src_elements[i] : i;
+			__m128 v = WidenToFloat<Type>(LoadElement<ELEMENT_SIZE>(src + element * src_stride));
+			if (Type != ComponentType::F32)
+			{
+				v = _mm_max_ps(_mm_mul_ps(v, scale), minimum);
+			}
+			v = _mm_xor_ps(v, sign_mask);
+
+			if (i < num_full_stores)
+			{
+				_mm_storeu_ps(dst + i * NumComponents, v);
+			}
+			else
+			{
+				StoreElement<NumComponents * sizeof(f32)>(reinterpret_cast<u8*>(dst + i * NumComponents), _mm_castps_si128(v));
+			}
+		}
+	}
+
+	template <ComponentType::Enum Type, u32 NumComponents>
+	static void WriteKernel(u8* dst, f32 const* src, u64 count, u32 dst_stride, ConversionParams const& params)
+	{
+		static constexpr u32 ELEMENT_SIZE = COMPONENT_SIZES[Type] * NumComponents;
+
+		__m128 const scale = params.scale;
+		__m128 const minimum = params.minimum;
+		__m128 const maximum = params.maximum;
+		__m128 const sign_mask = params.sign_mask;
+
+		for (u64 i = 0; i < count; ++i)
+		{
+			__m128 v = _mm_castsi128_ps(LoadElement<NumComponents * sizeof(f32)>(reinterpret_cast<u8 const*>(src + i * NumComponents)));
+			v = _mm_xor_ps(v, sign_mask);
+			if (Type != ComponentType::F32)
+			{
+				v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(v, scale), minimum), maximum);
+			}
+			StoreElement<ELEMENT_SIZE>(dst + i * dst_stride, NarrowFromFloat<Type>(v));
+		}
+	}
+
+	using ReadFunc = void (*)(f32*, u8 const*, u32 const*, u64, u32, ConversionParams const&);
+	using WriteFunc = void (*)(u8*, f32 const*, u64, u32, ConversionParams const&);
+
+	template <ComponentType::Enum Type, bool Gather>
+	static ReadFunc GetReadKernel(u32 num_components)
+	{
+		switch (num_components)
+		{
+		case 1:  return &ReadKernel<Type, 1, Gather>;
+		case 2:  return &ReadKernel<Type, 2, Gather>;
+		case 3:  return &ReadKernel<Type, 3, Gather>;
+		default: return &ReadKernel<Type, 4, Gather>;
+		}
+	}
+
+	template <bool Gather>
+	static ReadFunc GetReadKernel(ComponentType::Enum type, u32 num_components)
+	{
+		switch (type)
+		{
+		case ComponentType::S8:  return GetReadKernel<ComponentType::S8, Gather>(num_components);
+		case ComponentType::U8:  return GetReadKernel<ComponentType::U8, Gather>(num_components);
+		case ComponentType::S16: return GetReadKernel<ComponentType::S16, Gather>(num_components);
+		case ComponentType::U16: return GetReadKernel<ComponentType::U16, Gather>(num_components);
+		case ComponentType::U32: return GetReadKernel<ComponentType::U32, Gather>(num_components);
+		default:                 return GetReadKernel<ComponentType::F32, Gather>(num_components);
+		}
+	}
+
+	template <ComponentType::Enum Type>
+	static WriteFunc GetWriteKernel(u32 num_components)
+	{
+		switch (num_components)
+		{
+		case 1:  return &WriteKernel<Type, 1>;
+		case 2:  return &WriteKernel<Type, 2>;
+		case 3:  return &WriteKernel<Type, 3>;
+		default: return &WriteKernel<Type, 4>;
+		}
+	}
+
+	void ReadComponents(f32* dst, void const* src, u32 const* src_elements, u64 count, u32 num_components,
+		ComponentType::Enum type, bool b_normalized, u32 src_stride, u32 negate_mask)
+	{
+		ASSERT(num_components >= 1 && num_components <= 4 && type < ComponentType::EnumCount);
+		ASSERT(src_stride >= GetComponentSize(type) * num_components);
+
+		ConversionParams const params = GetConversionParams(type, b_normalized, negate_mask, true);
+		ReadFunc const func = src_elements ? GetReadKernel<true>(type, num_components) : GetReadKernel<false>(type, num_components);
+		func(dst, static_cast<u8 const*>(src), src_elements, count, src_stride, params);
+	}
+
+	void WriteComponents(void* dst, f32 const* src, u64 count, u32 num_components, ComponentType::Enum type, bool b_normalized,
+		u32 dst_stride, u32 negate_mask)
+	{
+		ASSERT(num_components >= 1 && num_components <= 4 && type < ComponentType::EnumCount);
+		ASSERT(dst_stride >= GetComponentSize(type) * num_components);
+
+		WriteFunc func = nullptr;
+		switch (type)
+		{
+		case ComponentType::S8:  func = GetWriteKernel<ComponentType::S8>(num_components); break;
+		case ComponentType::U8:  func = GetWriteKernel<ComponentType::U8>(num_components); break;
+		case ComponentType::S16: func = GetWriteKernel<ComponentType::S16>(num_components); break;
+		case ComponentType::U16: func = GetWriteKernel<ComponentType::U16>(num_components); break;
+		case ComponentType::U32: func = GetWriteKernel<ComponentType::U32>(num_components); break;
+		default:                 func = GetWriteKernel<ComponentType::F32>(num_components); break;
+		}
+
+		ConversionParams const params = GetConversionParams(type, b_normalized, negate_mask, false);
+		func(static_cast<u8*>(dst), src, count, dst_stride, params);
+	}
+
+	void CopyFlippedWinding(u16* dst, u16 const* src, u64 num_indices)
+	{
+		ASSERT(num_indices % 3 == 0);
+
+		// Two triangles per 16 byte load, the last two indices are stored as is and rewritten by the next step.
+		__m128i const swap = _mm_setr_epi8(0, 1, 4, 5, 2, 3, 6, 7, 10, 11, 8, 9, 12, 13, 14, 15);
+
+		u64 i = 0;
+		for (; i + 8 <= num_indices; i += 6)
+		{
+			__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, swap));
+		}
+
+		for (; i < num_indices; i += 3)
+		{
+			u16 const second = src[i + 1];
+			dst[i + 0] = src[i + 0];
+			dst[i + 1] = src[i + 2];
+			dst[i + 2] = second;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Core.h"
+
+// ====================================
+//  Vertex Stream Copies
+//  Notes:
+//  *) Kernels for moving vertex data between (possibly interleaved)
+//     source buffers and tightly packed destination streams.
+//  *) Component conversions go through one SSE register per element,
+//     widened to f32 and scaled, with any sign flips of a change of
+//     basis applied in the same pass. Every pair of component type and
+//     component count has its own kernel.
+// ====================================
+
+namespace StreamCopy
+{
+	// Copies count elements of element_size bytes, that are src_stride bytes apart in src,
+	// into a tightly packed dst. Never reads past the last source element.
+	// 8, 12 and 16 byte elements have SIMD kernels, 12 byte elements (vec3) are specialized
+	// for the common 20, 32 and 48 byte strides.
+	void Deinterleave(void* dst, void const* src, u64 count, u32 element_size, u32 src_stride);
+
+	// Same as Deinterleave, but copies the elements listed in src_elements, in that order.
+	void Gather(void* dst, void const* src, u32 const* src_elements, u64 count, u32 element_size, u32 src_stride);
+
+	// Component types of glTF accessors.
+	struct ComponentType
+	{
+		enum Enum : u32
+		{
+			S8,
+			U8,
+			S16,
+			U16,
+			U32,
+			F32,
+			EnumCount
+		};
+	};
+
+	u32 GetComponentSize(ComponentType::Enum type);
+
+	// Converts count elements of num_components (1 to 4) components to tightly packed f32s. Normalized
+	// integers map to [0, 1], or [-1, 1] for signed ones, as glTF defines it. Components with their bit
+	// set in negate_mask change sign. With src_elements, only the listed elements are converted, in that order.
+	void ReadComponents(f32* dst, void const* src, u32 const* src_elements, u64 count, u32 num_components,
+		ComponentType::Enum type, bool b_normalized, u32 src_stride, u32 negate_mask);
+
+	// The inverse of ReadComponents, from tightly packed f32s to elements dst_stride bytes apart. Integers
+	// are rounded to nearest and clamped to the range of the type.
+	void WriteComponents(void* dst, f32 const* src, u64 count, u32 num_components, ComponentType::Enum type, bool b_normalized,
+		u32 dst_stride, u32 negate_mask);
+
+	// Copies a triangle list, swapping the last two indices of every triangle.
+	void CopyFlippedWinding(u16* dst, u16 const* src, u64 num_indices);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "StreamCopy.h"
+#include "TestUtils.h"
+
+namespace StreamCopy
+{
+namespace Test
+{
+	static constexpr u8 GUARD = 0xCD;
+	static constexpr u32 MAX_COUNT = 67;
+
+	static void FillRandom(u8* bytes, u64 size, TestUtils::Random& random)
+	{
+		for (u64 i = 0; i < size; ++i)
+		{
+			bytes[i] = (u8)random.Next();
+		}
+	}
+
+	static bool IsGuard(u8 const* bytes, u64 size)
+	{
+		for (u64 i = 0; i < size; ++i)
+		{
+			if (bytes[i] != GUARD)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Every SIMD path (8, 12 with the specialized strides and 16 bytes) with every tail length, and
+	// nothing may be written past the packed elements.
+	void DeinterleaveMatchesScalar()
+	{
+		static constexpr u32 ELEMENT_SIZES[] = { 4, 6, 8, 12, 16 };
+		static constexpr u32 STRIDE_PADDING[] = { 0, 4, 8, 20, 36 };
+
+		static constexpr u32 MAX_STRIDE = 16 + 36;
+		u8 src[MAX_COUNT * MAX_STRIDE];
+		u8 dst[MAX_COUNT * 16 + 16];
+		u8 expected[MAX_COUNT * 16];
+
+		TestUtils::Random random;
+		FillRandom(src, sizeof(src), random);
+
+		for (u32 element_size : ELEMENT_SIZES)
+		{
+			for (u32 padding : STRIDE_PADDING)
+			{
+				u32 const stride = element_size + padding;
+				for (u32 count = 0; count <= MAX_COUNT; ++count)
+				{
+					for (u32 i = 0; i < count; ++i)
+					{
+						memcpy(expected + i * element_size, src + i * stride, element_size);
+					}
+
+					memset(dst, GUARD, sizeof(dst));
+					Deinterleave(dst, src, count, element_size, stride);
+					ASSERT(memcmp(dst, expected, count * element_size) == 0);
+					ASSERT(IsGuard(dst + count * element_size, 16));
+				}
+			}
+		}
+	}
+
+	void GatherMatchesScalar()
+	{
+		static constexpr u32 ELEMENT_SIZES[] = { 4, 8, 12, 16 };
+		static constexpr u32 STRIDE = 24;
+
+		u8 src[MAX_COUNT * STRIDE];
+		u8 dst[MAX_COUNT * 16 + 16];
+		u32 elements[MAX_COUNT];
+
+		TestUtils::Random random;
+		FillRandom(src, sizeof(src), random);
+		for (u32 i = 0; i < MAX_COUNT; ++i)
+		{
+			elements[i] = random.Index(MAX_COUNT);
+		}
+
+		for (u32 element_size : ELEMENT_SIZES)
+		{
+			memset(dst, GUARD, sizeof(dst));
+			Gather(dst, src, elements, MAX_COUNT, element_size, STRIDE);
+			for (u32 i = 0; i < MAX_COUNT; ++i)
+			{
+				ASSERT(memcmp(dst + i * element_size, src + elements[i] * STRIDE, element_size) == 0);
+			}
+			ASSERT(IsGuard(dst + MAX_COUNT * element_size, 16));
+		}
+	}
+
+	static f64 ReadInteger(u8 const* src, ComponentType::Enum type)
+	{
+		switch (type)
+		{
+		case ComponentType::S8:  { s8 v; memcpy(&v, src, sizeof(v)); return v; }
+		case ComponentType::U8:  { u8 v; memcpy(&v, src, sizeof(v)); return v; }
+		case ComponentType::S16: { s16 v; memcpy(&v, src, sizeof(v)); return v; }
+		case ComponentType::U16: { u16 v; memcpy(&v, src, sizeof(v)); return v; }
+		case ComponentType::U32: { u32 v; memcpy(&v, src, sizeof(v)); return v; }
+		default:                 { f32 v; memcpy(&v, src, sizeof(v)); return v; }
+		}
+	}
+
+	static f32 GetMaximum(ComponentType::Enum type)
+	{
+		static constexpr f32 MAXIMUMS[ComponentType::EnumCount] = { 127.0f, 255.0f, 32767.0f, 65535.0f, 4294967040.0f, 0.0f };
+		return MAXIMUMS[type];
+	}
+
+	// Scalar glTF conversion: normalized values are c / max, and no lower than -1.
+	static f32 ReadComponentScalar(u8 const* src, ComponentType::Enum type, bool b_normalized, bool b_negate)
+	{
+		f32 value = (f32)ReadInteger(src, type);
+		if (b_normalized)
+		{
+			value = max(value * (1.0f / GetMaximum(type)), -1.0f);
+		}
+		return b_negate ? -value : value;
+	}
+
+	void ReadComponentsMatchesScalar()
+	{
+		static constexpr u32 STRIDE = 20;
+		static constexpr u32 COUNT = 37;
+
+		u8 src[COUNT * STRIDE];
+		f32 dst[COUNT * 4 + 4];
+		u32 elements[COUNT];
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < COUNT; ++i)
+		{
+			elements[i] = random.Index(COUNT);
+		}
+
+		for (u32 type_idx = 0; type_idx < ComponentType::EnumCount; ++type_idx)
+		{
+			ComponentType::Enum const type = (ComponentType::Enum)type_idx;
+			u32 const component_size = GetComponentSize(type);
+
+			FillRandom(src, sizeof(src), random);
+			if (type == ComponentType::F32)
+			{
+				for (u32 i = 0; i < COUNT * STRIDE / 4; ++i)
+				{
+					f32 const value = random.Float(-100.0f, 100.0f);
+					memcpy(src + i * 4, &value, 4);
+				}
+			}
+
+			for (u32 normalized = 0; normalized < 2; ++normalized)
+			{
+				bool const b_normalized = normalized != 0;
+				if (b_normalized && type >= ComponentType::U32)
+				{
+					continue;
+				}
+
+				for (u32 num_components = 1; num_components <= 4; ++num_components)
+				{
+					for (u32 gather = 0; gather < 2; ++gather)
+					{
+						u32 const negate_mask = random.Index(16);
+						u32 const* src_elements = gather ? elements : nullptr;
+
+						memset(dst, GUARD, sizeof(dst));
+						ReadComponents(dst, src, src_elements, COUNT, num_components, type, b_normalized, STRIDE, negate_mask);
+
+						for (u32 i = 0; i < COUNT; ++i)
+						{
+							u32 const element = gather ? elements[i] : i;
+							for (u32 c = 0; c < num_components; ++c)
+							{
+								f32 const expected = ReadComponentScalar(src + element * STRIDE + c * component_size, type, b_normalized,
+									(negate_mask >> c) & 1);
+								ASSERT(memcmp(&dst[i * num_components + c], &expected, sizeof(f32)) == 0);
+							}
+						}
+						ASSERT(IsGuard(reinterpret_cast<u8*>(dst + COUNT * num_components), 16));
+					}
+				}
+			}
+		}
+	}
+
+	// Writing rounds to nearest and clamps, the gaps between the elements are left alone.
+	void WriteComponentsMatchesScalar()
+	{
+		static constexpr u32 STRIDE = 20;
+		static constexpr u32 COUNT = 29;
+
+		f32 src[COUNT * 4];
+		u8 dst[COUNT * STRIDE];
+		u8 expected[COUNT * STRIDE];
+
+		TestUtils::Random random;
+		for (u32 type_idx = 0; type_idx < ComponentType::EnumCount; ++type_idx)
+		{
+			ComponentType::Enum const type = (ComponentType::Enum)type_idx;
+			u32 const component_size = GetComponentSize(type);
+
+			for (u32 normalized = 0; normalized < 2; ++normalized)
+			{
+				bool const b_normalized = normalized != 0;
+				if (b_normalized && type >= ComponentType::U32)
+				{
+					continue;
+				}
+
+				// A bit past the range of the type, so clamping is hit on both ends.
+				f32 const range = b_normalized ? 1.25f : (type == ComponentType::F32 ? 1000.0f : GetMaximum(type) * 1.25f);
+				for (u32 i = 0; i < COUNT * 4; ++i)
+				{
+					src[i] = random.Float(-range, range);
+				}
+
+				for (u32 num_components = 1; num_components <= 4; ++num_components)
+				{
+					u32 const negate_mask = random.Index(16);
+
+					memset(expected, GUARD, sizeof(expected));
+					for (u32 i = 0; i < COUNT; ++i)
+					{
+						for (u32 c = 0; c < num_components; ++c)
+						{
+							u8* out = expected + i * STRIDE + c * component_size;
+							f32 value = ((negate_mask >> c) & 1) ? -src[i * num_components + c] : src[i * num_components + c];
+							if (type == ComponentType::F32)
+							{
+								memcpy(out, &value, sizeof(f32));
+								continue;
+							}
+
+							f32 const maximum = GetMaximum(type);
+							f32 const minimum = (type == ComponentType::S8 || type == ComponentType::S16) ? (b_normalized ? -maximum : -maximum - 1.0f) : 0.0f;
+							value = rintf(min(max(b_normalized ? value * maximum : value, minimum), maximum));
+							switch (type)
+							{
+							case ComponentType::S8:  { s8 v = (s8)value; memcpy(out, &v, sizeof(v)); break; }
+							case ComponentType::U8:  { u8 v = (u8)value; memcpy(out, &v, sizeof(v)); break; }
+							case ComponentType::S16: { s16 v = (s16)value; memcpy(out, &v, sizeof(v)); break; }
+							case ComponentType::U16: { u16 v = (u16)value; memcpy(out, &v, sizeof(v)); break; }
+							default:                 { u32 v = (u32)(u64)value; memcpy(out, &v, sizeof(v)); break; }
+							}
+						}
+					}
+
+					memset(dst, GUARD, sizeof(dst));
+					WriteComponents(dst, src, COUNT, num_components, type, b_normalized, STRIDE, negate_mask);
+					ASSERT(memcmp(dst, expected, sizeof(dst)) == 0);
+				}
+			}
+		}
+	}
+
+	void FlippedWindingMatchesScalar()
+	{
+		static constexpr u32 MAX_INDICES = 3 * 23;
+		u16 src[MAX_INDICES];
+		u16 dst[MAX_INDICES + 8];
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < MAX_INDICES; ++i)
+		{
+			src[i] = (u16)random.Next();
+		}
+
+		for (u32 num_indices = 0; num_indices <= MAX_INDICES; num_indices += 3)
+		{
+			memset(dst, GUARD, sizeof(dst));
+			CopyFlippedWinding(dst, src, num_indices);
+			for (u32 i = 0; i < num_indices; i += 3)
+			{
+				ASSERT(dst[i] == src[i] && dst[i + 1] == src[i + 2] && dst[i + 2] == src[i + 1]);
+			}
+			ASSERT(IsGuard(reinterpret_cast<u8*>(dst + num_indices), 16));
+		}
+	}
+
+	void Run()
+	{
+		DeinterleaveMatchesScalar();
+		GatherMatchesScalar();
+		ReadComponentsMatchesScalar();
+		WriteComponentsMatchesScalar();
+		FlippedWindingMatchesScalar();
+	}
+}
+}
@@ -0,0 +1,339 @@
+#include "TangentSpace.h"
+#include "Jobs.h"
+#include "MeshOptimize.h"
+
+namespace TangentSpace
+{
+	static constexpr u64 PARALLEL_BATCH_SIZE = 4 * 1024;
+
+	// Corners (positions in the index list) around each vertex, as ranges into one shared list.
+	// Vertex v owns corners[offsets[v]...offsets[v + 1]].
+	struct CornerAdjacency
+	{
+		u32* offsets;
+		u32* corners;
+	};
+
+	// With vertex_remap, corners are listed under remap[vertex] instead of the vertex itself.
+	static void BuildCornerAdjacency(CornerAdjacency* adjacency, u32 const* indices, u32 num_indices, u32 const* vertex_remap,
+		u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		adjacency->offsets = Memory::PushType<u32>(scratch_memory, num_vertices + 1, Memory::ZeroPush());
+		adjacency->corners = (num_indices > 0) ? Memory::PushType<u32>(scratch_memory, num_indices) : nullptr;
+
+		u32* offsets = adjacency->offsets;
+		for (u32 i = 0; i < num_indices; ++i)
+		{
+			ASSERT(indices[i] < num_vertices);
+			u32 const vertex = vertex_remap ? vertex_remap[indices[i]] : indices[i];
+			offsets[vertex]++;
+		}
+
+		u32 offset = 0;
+		for (u32 vertex = 0; vertex <= num_vertices; ++vertex)
+		{
+			u32 const count = offsets[vertex];
+			offsets[vertex] = offset;
+			offset += count;
+		}
+
+		// Use the offsets as write cursors, each ends up at the start of the next vertex's range.
+		for (u32 i = 0; i < num_indices; ++i)
+		{
+			u32 const vertex = vertex_remap ? vertex_remap[indices[i]] : indices[i];
+			adjacency->corners[offsets[vertex]++] = i;
+		}
+		for (u32 vertex = num_vertices; vertex > 0; --vertex)
+		{
+			offsets[vertex] = offsets[vertex - 1];
+		}
+		offsets[0] = 0;
+	}
+
+	static MM_FORCEINL vec3 Sub(vec3 const& a, vec3 const& b)
+	{
+		return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	static MM_FORCEINL vec3 Scale(vec3 const& v, f32 s)
+	{
+		return vec3(v.x * s, v.y * s, v.z * s);
+	}
+
+	// v with the part along the unit vector n removed.
+	static MM_FORCEINL vec3 ProjectOntoPlane(vec3 const& v, vec3 const& n)
+	{
+		f32 const d = Math::Dot(v, n);
+		return vec3(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+	}
+
+	// acos() to within 7e-5 radians (Abramowitz & Stegun 4.4.45), plenty for weights.
+	static MM_FORCEINL f32 FastAcos(f32 x)
+	{
+		f32 const a = fabsf(x);
+		f32 const r = (((-0.0187293f * a + 0.0742610f) * a - 0.2121144f) * a + 1.5707288f) * sqrtf(1.0f - a);
+		return (x < 0.0f) ? 3.14159265f - r : r;
+	}
+
+	// Interior angles of a triangle at its three corners, 0 at corners with a degenerate edge.
+	static void GetCornerAngles(vec3 const& p0, vec3 const& p1, vec3 const& p2, f32* out_angles)
+	{
+		vec3 const edges[3] = { Sub(p1, p0), Sub(p2, p1), Sub(p0, p2) };
+		f32 const lengths[3] = { Math::Length(edges[0]), Math::Length(edges[1]), Math::Length(edges[2]) };
+
+		// Corner i sits between the outgoing edge i and the incoming edge i - 1.
+		for (u32 i = 0; i < 3; ++i)
+		{
+			u32 const prev = (i + 2) % 3;
+			f32 const length_product = lengths[i] * lengths[prev];
+			if (length_product <= 0.0f)
+			{
+				out_angles[i] = 0.0f;
+				continue;
+			}
+			out_angles[i] = FastAcos(Clamp(-Math::Dot(edges[i], edges[prev]) / length_product, -1.0f, 1.0f));
+		}
+	}
+
+	// ====================================
+	//  Normals
+	// ====================================
+
+	struct NormalTask
+	{
+		vec3* out_normals;
+		u32 const* indices;
+		vec3 const* positions;
+		u32 const* position_remap; // First vertex with the same position, corners are listed under it.
+		CornerAdjacency adjacency;
+
+		vec3* corner_normals; // Unit face normal times the corner angle.
+	};
+
+	static void ComputeCornerNormalsBatch(void* user_data, u64 begin, u64 end)
+	{
+		NormalTask const* task = static_cast<NormalTask const*>(user_data);
+
+		for (u64 triangle = begin; triangle < end; ++triangle)
+		{
+			u32 const* tri = task->indices + triangle * 3;
+			vec3 const p0 = task->positions[tri[0]];
+			vec3 const p1 = task->positions[tri[1]];
+			vec3 const p2 = task->positions[tri[2]];
+
+			vec3* corner_normals = task->corner_normals + triangle * 3;
+
+			vec3 const face_normal = Math::Cross(Sub(p1, p0), Sub(p2, p0));
+			f32 const length = Math::Length(face_normal);
+			if (length <= 0.0f)
+			{
+				corner_normals[0] = corner_normals[1] = corner_normals[2] = vec3(0.0f, 0.0f, 0.0f);
+				continue;
+			}
+
+			f32 angles[3];
+			GetCornerAngles(p0, p1, p2, angles);
+
+			vec3 const n = Scale(face_normal, 1.0f / length);
+			corner_normals[0] = Scale(n, angles[0]);
+			corner_normals[1] = Scale(n, angles[1]);
+			corner_normals[2] = Scale(n, angles[2]);
+		}
+	}
+
+	static void GatherNormalsBatch(void* user_data, u64 begin, u64 end)
+	{
+		NormalTask const* task = static_cast<NormalTask const*>(user_data);
+
+		for (u64 vertex = begin; vertex < end; ++vertex)
+		{
+			u32 const shared = task->position_remap[vertex];
+			u32 const corner_begin = task->adjacency.offsets[shared];
+			u32 const corner_end = task->adjacency.offsets[shared + 1];
+
+			vec3 sum = vec3(0.0f, 0.0f, 0.0f);
+			for (u32 i = corner_begin; i < corner_end; ++i)
+			{
+				vec3 const& n = task->corner_normals[task->adjacency.corners[i]];
+				sum = vec3(sum.x + n.x, sum.y + n.y, sum.z + n.z);
+			}
+
+			// Unreferenced vertices and those only used by degenerate triangles.
+			f32 const length = Math::Length(sum);
+			task->out_normals[vertex] = (length > 0.0f) ? Scale(sum, 1.0f / length) : vec3(0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	void GenerateNormals(vec3* out_normals, u32 const* indices, u32 num_indices, vec3 const* positions, u32 num_vertices,
+		Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+		if (num_vertices == 0)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		MeshOpt::VertexStream stream;
+		stream.data = positions;
+		stream.size = sizeof(vec3);
+		stream.stride = sizeof(vec3);
+
+		u32* position_remap = Memory::PushType<u32>(scratch_memory, num_vertices);
+		MeshOpt::FindDuplicateVertices(position_remap, &stream, 1, num_vertices, scratch_memory);
+
+		NormalTask task;
+		task.out_normals = out_normals;
+		task.indices = indices;
+		task.positions = positions;
+		task.position_remap = position_remap;
+		task.corner_normals = (num_indices > 0) ? Memory::PushType<vec3>(scratch_memory, num_indices) : nullptr;
+		BuildCornerAdjacency(&task.adjacency, indices, num_indices, position_remap, num_vertices, scratch_memory);
+
+		Jobs::ParallelFor(num_indices / 3, PARALLEL_BATCH_SIZE, &ComputeCornerNormalsBatch, &task);
+		Jobs::ParallelFor(num_vertices, PARALLEL_BATCH_SIZE, &GatherNormalsBatch, &task);
+	}
+
+	// ====================================
+	//  Tangents
+	// ====================================
+
+	// dP/du and dP/dv of a triangle, scaled by the same positive factor, zero for triangles without UV area.
+	struct TriangleTangents
+	{
+		vec3 tangent;
+		vec3 bitangent;
+	};
+
+	struct TangentTask
+	{
+		vec4* out_tangents;
+		u32 const* indices;
+		vec3 const* positions;
+		vec3 const* normals;
+		vec2 const* texcoords;
+		CornerAdjacency adjacency;
+
+		TriangleTangents* triangle_tangents;
+		f32* corner_angles;
+	};
+
+	static void ComputeTriangleTangentsBatch(void* user_data, u64 begin, u64 end)
+	{
+		TangentTask const* task = static_cast<TangentTask const*>(user_data);
+
+		for (u64 triangle = begin; triangle < end; ++triangle)
+		{
+			u32 const* tri = task->indices + triangle * 3;
+			vec3 const p0 = task->positions[tri[0]];
+			vec3 const p1 = task->positions[tri[1]];
+			vec3 const p2 = task->positions[tri[2]];
+
+			GetCornerAngles(p0, p1, p2, task->corner_angles + triangle * 3);
+
+			vec3 const e1 = Sub(p1, p0);
+			vec3 const e2 = Sub(p2, p0);
+
+			vec2 const uv0 = task->texcoords[tri[0]];
+			f32 const s1 = task->texcoords[tri[1]].x - uv0.x;
+			f32 const t1 = task->texcoords[tri[1]].y - uv0.y;
+			f32 const s2 = task->texcoords[tri[2]].x - uv0.x;
+			f32 const t2 = task->texcoords[tri[2]].y - uv0.y;
+
+			// Twice the signed UV area. The derivatives are only scaled by its sign, they get normalized per corner.
+			f32 const uv_area = s1 * t2 - s2 * t1;
+			f32 const sign = (uv_area > 0.0f) ? 1.0f : ((uv_area < 0.0f) ? -1.0f : 0.0f);
+
+			TriangleTangents& tangents = task->triangle_tangents[triangle];
+			tangents.tangent = vec3((e1.x * t2 - e2.x * t1) * sign, (e1.y * t2 - e2.y * t1) * sign, (e1.z * t2 - e2.z * t1) * sign);
+			tangents.bitangent = vec3((e2.x * s1 - e1.x * s2) * sign, (e2.y * s1 - e1.y * s2) * sign, (e2.z * s1 - e1.z * s2) * sign);
+		}
+	}
+
+	// Any unit vector orthogonal to n.
+	static vec3 GetOrthogonal(vec3 const& n)
+	{
+		vec3 const axis = (fabsf(n.x) < 0.9f) ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+		return Math::Normalize(ProjectOntoPlane(axis, n));
+	}
+
+	static void GatherTangentsBatch(void* user_data, u64 begin, u64 end)
+	{
+		TangentTask const* task = static_cast<TangentTask const*>(user_data);
+
+		for (u64 vertex = begin; vertex < end; ++vertex)
+		{
+			vec3 const n = task->normals[vertex];
+			u32 const corner_begin = task->adjacency.offsets[vertex];
+			u32 const corner_end = task->adjacency.offsets[vertex + 1];
+
+			vec3 tangent_sum = vec3(0.0f, 0.0f, 0.0f);
+			vec3 bitangent_sum = vec3(0.0f, 0.0f, 0.0f);
+			for (u32 i = corner_begin; i < corner_end; ++i)
+			{
+				u32 const corner = task->adjacency.corners[i];
+				TriangleTangents const& tangents = task->triangle_tangents[corner / 3];
+
+				// Flattened onto the vertex's tangent plane, then weighted by the corner angle.
+				vec3 const tangent = ProjectOntoPlane(tangents.tangent, n);
+				vec3 const bitangent = ProjectOntoPlane(tangents.bitangent, n);
+
+				f32 const tangent_length = Math::Length(tangent);
+				f32 const bitangent_length = Math::Length(bitangent);
+				if (tangent_length <= 0.0f || bitangent_length <= 0.0f)
+				{
+					continue;
+				}
+
+				f32 const angle = task->corner_angles[corner];
+				vec3 const weighted_tangent = Scale(tangent, angle / tangent_length);
+				vec3 const weighted_bitangent = Scale(bitangent, angle / bitangent_length);
+				tangent_sum = vec3(tangent_sum.x + weighted_tangent.x, tangent_sum.y + weighted_tangent.y, tangent_sum.z + weighted_tangent.z);
+				bitangent_sum = vec3(bitangent_sum.x + weighted_bitangent.x, bitangent_sum.y + weighted_bitangent.y, bitangent_sum.z + weighted_bitangent.z);
+			}
+
+			// The sum is already orthogonal to n, this only removes the rounding error.
+			vec3 const tangent = ProjectOntoPlane(tangent_sum, n);
+			f32 const length = Math::Length(tangent);
+			if (length <= 1e-12f)
+			{
+				vec3 const fallback = GetOrthogonal(n);
+				task->out_tangents[vertex] = vec4(fallback.x, fallback.y, fallback.z, 1.0f);
+				continue;
+			}
+
+			// bitangent_sum is dP/dv, which points down the texture.
+			vec3 const unit_tangent = Scale(tangent, 1.0f / length);
+			f32 const handedness = (Math::Dot(Math::Cross(n, unit_tangent), bitangent_sum) > 0.0f) ? -1.0f : 1.0f;
+			task->out_tangents[vertex] = vec4(unit_tangent.x, unit_tangent.y, unit_tangent.z, handedness);
+		}
+	}
+
+	void GenerateTangents(vec4* out_tangents, u32 const* indices, u32 num_indices, vec3 const* positions, vec3 const* normals,
+		vec2 const* texcoords, u32 num_vertices, Memory::Arena* scratch_memory)
+	{
+		ASSERT(num_indices % 3 == 0);
+		if (num_vertices == 0)
+		{
+			return;
+		}
+
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		TangentTask task;
+		task.out_tangents = out_tangents;
+		task.indices = indices;
+		task.positions = positions;
+		task.normals = normals;
+		task.texcoords = texcoords;
+		task.triangle_tangents = (num_indices > 0) ? Memory::PushType<TriangleTangents>(scratch_memory, num_indices / 3) : nullptr;
+		task.corner_angles = (num_indices > 0) ? Memory::PushType<f32>(scratch_memory, num_indices) : nullptr;
+		BuildCornerAdjacency(&task.adjacency, indices, num_indices, nullptr, num_vertices, scratch_memory);
+
+		Jobs::ParallelFor(num_indices / 3, PARALLEL_BATCH_SIZE, &ComputeTriangleTangentsBatch, &task);
+		Jobs::ParallelFor(num_vertices, PARALLEL_BATCH_SIZE, &GatherTangentsBatch, &task);
+	}
+}
\ No newline at end of file
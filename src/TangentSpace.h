@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+#include "Memory.h"
+
+// ====================================
+//  Tangent Space Generation
+//  Notes:
+//  *) Normals are the corner angle weighted average of the face normals
+//     around a vertex. Vertices at the same position share their normal,
+//     so normals stay smooth across UV seams.
+//  *) Tangents follow MikkTSpace (Mikkelsen 2008): per corner, the
+//     triangle's texture space derivatives are projected onto the plane of
+//     the vertex normal, normalized and weighted by the corner angle.
+//     Tangents of vertices that are split by UV seams stay separate.
+//  *) Tangents point along +u, w holds the handedness. Texcoords have
+//     their origin at the top left (glTF, D3D), so the bitangent
+//     cross(normal, tangent.xyz) * w points towards -v, up in the
+//     texture, and w is +1 unless the UVs are mirrored.
+//  *) Every vertex gathers from the triangles around it, so both run in
+//     parallel over vertices without any synchronization, and the result
+//     doesn't depend on the number of threads.
+//  *) Works on 32 bit indexed source meshes, cross(b - a, c - a) facing
+//     outwards.
+// ====================================
+
+namespace TangentSpace
+{
+	void GenerateNormals(vec3* out_normals, u32 const* indices, u32 num_indices, vec3 const* positions, u32 num_vertices,
+		Memory::Arena* scratch_memory);
+
+	// Normals are expected to be normalized. Vertices without usable texcoords get some tangent orthogonal to their normal.
+	void GenerateTangents(vec4* out_tangents, u32 const* indices, u32 num_indices, vec3 const* positions, vec3 const* normals,
+		vec2 const* texcoords, u32 num_vertices, Memory::Arena* scratch_memory);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
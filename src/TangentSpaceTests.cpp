@@ -0,0 +1,219 @@
+#include "TangentSpace.h"
+#include "Jobs.h"
+#include "TestUtils.h"
+
+namespace TangentSpace
+{
+namespace Test
+{
+	// Unit sphere with a row of vertices at each pole and a seam column, like an exported UV sphere. u runs
+	// against the longitude, so the mapping isn't mirrored seen from outside, v from the top pole down.
+	struct TestSphere
+	{
+		u32* indices;
+		vec3* positions;
+		vec2* texcoords;
+		u32 num_indices;
+		u32 num_vertices;
+		u32 segments;
+		u32 rings;
+	};
+
+	static void BuildSphere(TestSphere* sphere, u32 segments, u32 rings, Memory::Arena* arena)
+	{
+		sphere->segments = segments;
+		sphere->rings = rings;
+		sphere->num_vertices = (segments + 1) * (rings + 1);
+		sphere->num_indices = segments * rings * 6;
+		sphere->indices = Memory::PushType<u32>(arena, sphere->num_indices);
+		sphere->positions = Memory::PushType<vec3>(arena, sphere->num_vertices);
+		sphere->texcoords = Memory::PushType<vec2>(arena, sphere->num_vertices);
+
+		for (u32 ring = 0; ring <= rings; ++ring)
+		{
+			f32 const theta = Math::Pi * ring / rings;
+			for (u32 segment = 0; segment <= segments; ++segment)
+			{
+				// The seam column and the pole rows get the same position for every copy, bit for bit.
+				f32 const phi = 2.0f * Math::Pi * (segment % segments) / segments;
+				u32 const vertex = ring * (segments + 1) + segment;
+				bool const b_pole = ring == 0 || ring == rings;
+				sphere->positions[vertex] = b_pole ? vec3(0.0f, ring == 0 ? 1.0f : -1.0f, 0.0f) :
+					vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				sphere->texcoords[vertex] = vec2(1.0f - (f32)segment / segments, (f32)ring / rings);
+			}
+		}
+
+		// cross(b - a, c - a) faces outwards. Triangles at the poles have two corners in the same place.
+		u32* index = sphere->indices;
+		for (u32 ring = 0; ring < rings; ++ring)
+		{
+			for (u32 segment = 0; segment < segments; ++segment)
+			{
+				u32 const a = ring * (segments + 1) + segment;
+				u32 const b = a + 1;
+				u32 const c = a + segments + 1;
+				u32 const d = c + 1;
+				*index++ = a; *index++ = b; *index++ = c;
+				*index++ = c; *index++ = b; *index++ = d;
+			}
+		}
+	}
+
+	static bool IsPole(TestSphere const& sphere, u32 vertex)
+	{
+		u32 const ring = vertex / (sphere.segments + 1);
+		return ring == 0 || ring == sphere.rings;
+	}
+
+	// Angle weighted normals of a finely tessellated sphere are the analytic ones to within a fraction of a
+	// degree, poles included. Both copies of a seam vertex share their normal.
+	void NormalsMatchTheSphere()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestSphere sphere;
+		BuildSphere(&sphere, 64, 32, &arena);
+
+		vec3* normals = Memory::PushType<vec3>(&arena, sphere.num_vertices);
+		GenerateNormals(normals, sphere.indices, sphere.num_indices, sphere.positions, sphere.num_vertices, &arena);
+
+		for (u32 vertex = 0; vertex < sphere.num_vertices; ++vertex)
+		{
+			ASSERT(fabsf(Math::Length(normals[vertex]) - 1.0f) < 1e-5f);
+			ASSERT(Math::Dot(normals[vertex], sphere.positions[vertex]) > 0.9999f);
+		}
+
+		for (u32 ring = 0; ring <= sphere.rings; ++ring)
+		{
+			u32 const first = ring * (sphere.segments + 1);
+			ASSERT(memcmp(&normals[first], &normals[first + sphere.segments], sizeof(vec3)) == 0);
+		}
+	}
+
+	// Tangents are unit length and orthogonal to the normals, w is exactly +1 or -1. Away from the poles,
+	// where u has no direction, they point along +u and the bitangent cross(normal, tangent) * w towards
+	// the top of the texture.
+	void TangentsFollowTheTexcoords()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(4));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestSphere sphere;
+		BuildSphere(&sphere, 64, 32, &arena);
+
+		vec3* normals = Memory::PushType<vec3>(&arena, sphere.num_vertices);
+		vec4* tangents = Memory::PushType<vec4>(&arena, sphere.num_vertices);
+		GenerateNormals(normals, sphere.indices, sphere.num_indices, sphere.positions, sphere.num_vertices, &arena);
+		GenerateTangents(tangents, sphere.indices, sphere.num_indices, sphere.positions, normals, sphere.texcoords,
+			sphere.num_vertices, &arena);
+
+		for (u32 vertex = 0; vertex < sphere.num_vertices; ++vertex)
+		{
+			vec3 const tangent = tangents[vertex].xyz;
+			ASSERT(fabsf(Math::Length(tangent) - 1.0f) < 1e-5f);
+			ASSERT(fabsf(Math::Dot(tangent, normals[vertex])) < 1e-4f);
+			ASSERT(tangents[vertex].w == 1.0f || tangents[vertex].w == -1.0f);
+
+			if (IsPole(sphere, vertex))
+			{
+				continue;
+			}
+
+			// u grows against the longitude, towards -d/dphi. The top of the texture is the north pole. Seam
+			// vertices only see the triangles on their side of it, which turns them by half a segment.
+			vec3 const p = sphere.positions[vertex];
+			f32 const radius = sqrtf(p.x * p.x + p.z * p.z);
+			vec3 const along_u = vec3(p.z / radius, 0.0f, -p.x / radius);
+			ASSERT(Math::Dot(tangent, along_u) > cosf(1.1f * Math::Pi / sphere.segments));
+
+			vec3 const bitangent = Math::Cross(normals[vertex], tangent);
+			ASSERT(bitangent.y * tangents[vertex].w > 0.0f && tangents[vertex].w == 1.0f);
+		}
+	}
+
+	// Two quads facing +z, texcoords with the origin at the top left. The left one maps u along +x, the right
+	// one is its mirror image: same v, u along -x. glTF wants w = -1 there, so the bitangent still points up.
+	void MirroredTexcoordsFlipHandedness()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(1));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		vec3 const positions[8] =
+		{
+			vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 1.0f, 0.0f),
+			vec3(2.0f, 0.0f, 0.0f), vec3(3.0f, 0.0f, 0.0f), vec3(2.0f, 1.0f, 0.0f), vec3(3.0f, 1.0f, 0.0f),
+		};
+		vec2 const texcoords[8] =
+		{
+			vec2(0.0f, 1.0f), vec2(1.0f, 1.0f), vec2(0.0f, 0.0f), vec2(1.0f, 0.0f),
+			vec2(1.0f, 1.0f), vec2(0.0f, 1.0f), vec2(1.0f, 0.0f), vec2(0.0f, 0.0f),
+		};
+		u32 const indices[12] = { 0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7 };
+
+		vec3 normals[8];
+		vec4 tangents[8];
+		GenerateNormals(normals, indices, 12, positions, 8, &arena);
+		GenerateTangents(tangents, indices, 12, positions, normals, texcoords, 8, &arena);
+
+		for (u32 vertex = 0; vertex < 8; ++vertex)
+		{
+			bool const b_mirrored = vertex >= 4;
+			ASSERT(normals[vertex].z > 0.9999f);
+			ASSERT(tangents[vertex].x * (b_mirrored ? -1.0f : 1.0f) > 0.9999f && fabsf(tangents[vertex].z) < 1e-5f);
+			ASSERT(tangents[vertex].w == (b_mirrored ? -1.0f : 1.0f));
+
+			vec3 const bitangent = Math::Cross(normals[vertex], tangents[vertex].xyz);
+			ASSERT(bitangent.y * tangents[vertex].w > 0.9999f);
+		}
+	}
+
+	// A sphere with several times TangentSpace.cpp's batch size of 4096 triangles and vertices. Without a job
+	// system ParallelFor runs inline, with three workers it splits into batches. Results are the same bits.
+	void ParallelMatchesInline()
+	{
+		Memory::Arena arena;
+		Memory::InitArena(&arena, Megabyte(16));
+		ON_SCOPE_EXIT(Memory::FreeArena(&arena));
+
+		TestSphere sphere;
+		BuildSphere(&sphere, 192, 96, &arena);
+		ASSERT(sphere.num_vertices > 4 * 4096);
+
+		vec3* normals[2];
+		vec4* tangents[2];
+		for (u32 run = 0; run < 2; ++run)
+		{
+			Jobs::Exit();
+			if (run == 1)
+			{
+				Jobs::Init(3);
+				ASSERT(Jobs::GetThreadCount() == 4);
+			}
+
+			normals[run] = Memory::PushType<vec3>(&arena, sphere.num_vertices);
+			tangents[run] = Memory::PushType<vec4>(&arena, sphere.num_vertices);
+			GenerateNormals(normals[run], sphere.indices, sphere.num_indices, sphere.positions, sphere.num_vertices, &arena);
+			GenerateTangents(tangents[run], sphere.indices, sphere.num_indices, sphere.positions, normals[run], sphere.texcoords,
+				sphere.num_vertices, &arena);
+		}
+		Jobs::Exit();
+		Jobs::Init();
+
+		ASSERT(memcmp(normals[0], normals[1], sizeof(vec3) * sphere.num_vertices) == 0);
+		ASSERT(memcmp(tangents[0], tangents[1], sizeof(vec4) * sphere.num_vertices) == 0);
+	}
+
+	void Run()
+	{
+		NormalsMatchTheSphere();
+		TangentsFollowTheTexcoords();
+		MirroredTexcoordsFlipHandedness();
+		ParallelMatchesInline();
+	}
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Core.h"
+
+#include <math.h>
+
+// ====================================
+//  Test Helpers
+//  Notes:
+//  *) Shared by the *Tests.cpp files. Inputs are generated
+//     from a fixed seed, so a failing test fails every time.
+// ====================================
+
+namespace TestUtils
+{
+	// xorshift32, good enough for test data.
+	struct Random
+	{
+		u32 state = 0x9E3779B9u;
+
+		u32 Next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		// [lo, hi)
+		f32 Float(f32 lo, f32 hi)
+		{
+			return lo + (hi - lo) * ((Next() >> 8) * (1.0f / 16777216.0f));
+		}
+
+		// [0, count)
+		u32 Index(u32 count)
+		{
+			return (u32)(((u64)Next() * count) >> 32);
+		}
+	};
+
+	// Something like a photo: smooth gradients, a few hard edged shapes and some noise.
+	// Alpha is a gradient too, unless b_opaque.
+	inline void FillImage(u8* rgba, u32 width, u32 height, bool b_opaque, Random& random)
+	{
+		for (u32 y = 0; y < height; ++y)
+		{
+			for (u32 x = 0; x < width; ++x)
+			{
+				f32 const u = (f32)x / (f32)width;
+				f32 const v = (f32)y / (f32)height;
+				bool const b_inside = ((x / 24) + (y / 40)) % 5 == 0;
+				f32 const noise = random.Float(-6.0f, 6.0f);
+
+				u8* texel = rgba + ((u64)y * width + x) * 4;
+				texel[0] = (u8)Clamp(40.0f + 170.0f * u + noise + (b_inside ? 60.0f : 0.0f), 0.0f, 255.0f);
+				texel[1] = (u8)Clamp(200.0f - 120.0f * v + noise, 0.0f, 255.0f);
+				texel[2] = (u8)Clamp(128.0f + 100.0f * sinf(6.0f * u + 4.0f * v) + noise - (b_inside ? 80.0f : 0.0f), 0.0f, 255.0f);
+				texel[3] = b_opaque ? 255 : (u8)Clamp(255.0f * (1.0f - u * v) + noise, 0.0f, 255.0f);
+			}
+		}
+	}
+
+	// Peak signal to noise ratio in dB, from the summed squared error of num_samples 8 bit values.
+	inline f64 Psnr(f64 squared_error, u64 num_samples)
+	{
+		f64 const mse = squared_error / (f64)num_samples;
+		return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+	}
+}
@@ -0,0 +1,327 @@
+#include "VertexQuantization.h"
+#include "Simd.h"
+
+namespace Quantize
+{
+	static MM_FORCEINL u32 AsUint(f32 value)
+	{
+		u32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static MM_FORCEINL f32 AsFloat(u32 bits)
+	{
+		f32 value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Round to nearest even, see https://gist.github.com/rygorous/2156668
+	u16 FloatToHalf(f32 value)
+	{
+		u32 const f32_infinity = 255u << 23;
+		u32 const f16_overflow = (127u + 16u) << 23;
+		u32 const f16_min_normal = 113u << 23;
+		u32 const denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+		u32 bits = AsUint(value);
+		u32 const sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		u16 result = 0;
+		if (bits >= f16_overflow)
+		{
+			// Inf stays inf, NaN becomes a quiet NaN.
+			result = (bits > f32_infinity) ? 0x7e00 : 0x7c00;
+		}
+		else if (bits < f16_min_normal)
+		{
+			// Let the fpu do the rounding for denormals by shifting the mantissa into place.
+			bits = AsUint(AsFloat(bits) + AsFloat(denorm_magic));
+			result = static_cast<u16>(bits - denorm_magic);
+		}
+		else
+		{
+			u32 const mantissa_odd = (bits >> 13) & 1;
+			bits += (static_cast<u32>(15 - 127) << 23) + 0xfff;
+			bits += mantissa_odd;
+			result = static_cast<u16>(bits >> 13);
+		}
+
+		return result | static_cast<u16>(sign >> 16);
+	}
+
+	f32 HalfToFloat(u16 value)
+	{
+		u32 const shifted_exponent = 0x7c00u << 13;
+
+		u32 bits = (value & 0x7fffu) << 13;
+		u32 const exponent = bits & shifted_exponent;
+		bits += (127u - 15u) << 23;
+
+		if (exponent == shifted_exponent)
+		{
+			bits += (128u - 16u) << 23; // Inf/NaN
+		}
+		else if (exponent == 0)
+		{
+			bits += 1u << 23; // Denormal, renormalize
+			bits = AsUint(AsFloat(bits) - AsFloat(113u << 23));
+		}
+
+		bits |= (value & 0x8000u) << 16;
+		return AsFloat(bits);
+	}
+
+	// Converts whole groups of 8, returns how many values that were.
+	static SIMD_TARGET_F16C u64 FloatToHalfF16C(f32 const* src, u16* dst, u64 count)
+	{
+		u64 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128 lo = _mm_loadu_ps(src + i);
+			__m128 hi = _mm_loadu_ps(src + i + 4);
+
+			__m128i lo_half = _mm_cvtps_ph(lo, _MM_FROUND_TO_NEAREST_INT);
+			__m128i hi_half = _mm_cvtps_ph(hi, _MM_FROUND_TO_NEAREST_INT);
+
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi64(lo_half, hi_half));
+		}
+		return i;
+	}
+
+	static SIMD_TARGET_F16C u64 HalfToFloatF16C(u16 const* src, f32* dst, u64 count)
+	{
+		u64 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i halves = _mm_loadu_si128((__m128i const*)(src + i));
+
+			_mm_storeu_ps(dst + i, _mm_cvtph_ps(halves));
+			_mm_storeu_ps(dst + i + 4, _mm_cvtph_ps(_mm_srli_si128(halves, 8)));
+		}
+		return i;
+	}
+
+	void FloatToHalf(f32 const* src, u16* dst, u64 count)
+	{
+		u64 i = Simd::GetCpuFeatures().f16c ? FloatToHalfF16C(src, dst, count) : 0;
+
+		for (; i < count; ++i)
+		{
+			dst[i] = FloatToHalf(src[i]);
+		}
+	}
+
+	void HalfToFloat(u16 const* src, f32* dst, u64 count)
+	{
+		u64 i = Simd::GetCpuFeatures().f16c ? HalfToFloatF16C(src, dst, count) : 0;
+
+		for (; i < count; ++i)
+		{
+			dst[i] = HalfToFloat(src[i]);
+		}
+	}
+
+	static MM_FORCEINL s16 FloatToSnorm16(f32 value)
+	{
+		value = Clamp(value, -1.0f, 1.0f);
+		return static_cast<s16>(rintf(value * 32767.0f));
+	}
+
+	static MM_FORCEINL f32 Snorm16ToFloat(s16 value)
+	{
+		return max(static_cast<f32>(value) / 32767.0f, -1.0f);
+	}
+
+	static MM_FORCEINL s8 FloatToSnorm8(f32 value)
+	{
+		value = Clamp(value, -1.0f, 1.0f);
+		return static_cast<s8>(rintf(value * 127.0f));
+	}
+
+	static MM_FORCEINL f32 SignNotZero(f32 value)
+	{
+		return (value >= 0.0f) ? 1.0f : -1.0f;
+	}
+
+	static snorm16x2 EncodeOctahedral(vec3 n)
+	{
+		f32 const l1_norm = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+		f32 const inv_norm = (l1_norm > 0.0f) ? 1.0f / l1_norm : 0.0f;
+
+		f32 x = n.x * inv_norm;
+		f32 y = n.y * inv_norm;
+
+		// Fold the lower hemisphere over the diagonals.
+		if (n.z < 0.0f)
+		{
+			f32 const folded_x = (1.0f - fabsf(y)) * SignNotZero(x);
+			f32 const folded_y = (1.0f - fabsf(x)) * SignNotZero(y);
+			x = folded_x;
+			y = folded_y;
+		}
+
+		snorm16x2 encoded;
+		encoded.x = FloatToSnorm16(x);
+		encoded.y = FloatToSnorm16(y);
+		return encoded;
+	}
+
+	void EncodeOctahedral(vec3 const* normals, snorm16x2* dst, u64 count)
+	{
+		__m128 const sign_mask = _mm_set1_ps(-0.0f);
+		__m128 const one = _mm_set1_ps(1.0f);
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const min_norm = _mm_set1_ps(1e-20f);
+		__m128 const snorm_scale = _mm_set1_ps(32767.0f);
+
+		u64 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			Simd::LoadVec3x4(normals + i, x, y, z);
+
+			__m128 l1_norm = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, x), _mm_andnot_ps(sign_mask, y)), _mm_andnot_ps(sign_mask, z));
+			__m128 inv_norm = _mm_div_ps(one, _mm_max_ps(l1_norm, min_norm));
+
+			x = _mm_mul_ps(x, inv_norm);
+			y = _mm_mul_ps(y, inv_norm);
+
+			// (1 - |y|) is never negative, so or-ing in the sign of x is enough.
+			__m128 folded_x = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, y)), _mm_and_ps(x, sign_mask));
+			__m128 folded_y = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, x)), _mm_and_ps(y, sign_mask));
+
+			__m128 lower_hemisphere = _mm_cmplt_ps(z, zero);
+			x = _mm_blendv_ps(x, folded_x, lower_hemisphere);
+			y = _mm_blendv_ps(y, folded_y, lower_hemisphere);
+
+			// Packing saturates, so the clamp to [-1, 1] comes for free.
+			__m128i xi = _mm_cvtps_epi32(_mm_mul_ps(x, snorm_scale));
+			__m128i yi = _mm_cvtps_epi32(_mm_mul_ps(y, snorm_scale));
+			__m128i x4y4 = _mm_packs_epi32(xi, yi);
+			__m128i xy = _mm_unpacklo_epi16(x4y4, _mm_srli_si128(x4y4, 8));
+
+			_mm_storeu_si128((__m128i*)(dst + i), xy);
+		}
+
+		for (; i < count; ++i)
+		{
+			dst[i] = EncodeOctahedral(normals[i]);
+		}
+	}
+
+	void DecodeOctahedral(snorm16x2 const* src, vec3* normals, u64 count)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			f32 x = Snorm16ToFloat(src[i].x);
+			f32 y = Snorm16ToFloat(src[i].y);
+			f32 const z = 1.0f - fabsf(x) - fabsf(y);
+
+			if (z < 0.0f)
+			{
+				f32 const unfolded_x = (1.0f - fabsf(y)) * SignNotZero(x);
+				f32 const unfolded_y = (1.0f - fabsf(x)) * SignNotZero(y);
+				x = unfolded_x;
+				y = unfolded_y;
+			}
+
+			normals[i] = Math::Normalize(vec3(x, y, z));
+		}
+	}
+
+	void EncodeSnorm8(vec4 const* src, snorm8x4* dst, u64 count)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			dst[i].x = FloatToSnorm8(src[i].x);
+			dst[i].y = FloatToSnorm8(src[i].y);
+			dst[i].z = FloatToSnorm8(src[i].z);
+			dst[i].w = FloatToSnorm8(src[i].w);
+		}
+	}
+
+	static MM_FORCEINL f32 InvExtent(f32 min, f32 max)
+	{
+		f32 const extent = max - min;
+		return (extent > 0.0f) ? 1.0f / extent : 0.0f;
+	}
+
+	void QuantizePositions(vec3 const* src, unorm16x4* dst, u64 count, AABB const& bounds)
+	{
+		vec3 const scale(
+			InvExtent(bounds.min.x, bounds.max.x) * 65535.0f,
+			InvExtent(bounds.min.y, bounds.max.y) * 65535.0f,
+			InvExtent(bounds.min.z, bounds.max.z) * 65535.0f);
+
+		__m128 const min_x = _mm_set1_ps(bounds.min.x);
+		__m128 const min_y = _mm_set1_ps(bounds.min.y);
+		__m128 const min_z = _mm_set1_ps(bounds.min.z);
+		__m128 const scale_x = _mm_set1_ps(scale.x);
+		__m128 const scale_y = _mm_set1_ps(scale.y);
+		__m128 const scale_z = _mm_set1_ps(scale.z);
+
+		u64 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			Simd::LoadVec3x4(src + i, x, y, z);
+
+			__m128i xi = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(x, min_x), scale_x));
+			__m128i yi = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(y, min_y), scale_y));
+			__m128i zi = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(z, min_z), scale_z));
+			__m128i wi = _mm_setzero_si128();
+
+			// Transpose back to one xyzw per lane, packus clamps to [0, 65535].
+			__m128i x0y0x1y1 = _mm_unpacklo_epi32(xi, yi);
+			__m128i z0w0z1w1 = _mm_unpacklo_epi32(zi, wi);
+			__m128i x2y2x3y3 = _mm_unpackhi_epi32(xi, yi);
+			__m128i z2w2z3w3 = _mm_unpackhi_epi32(zi, wi);
+
+			__m128i v01 = _mm_packus_epi32(_mm_unpacklo_epi64(x0y0x1y1, z0w0z1w1), _mm_unpackhi_epi64(x0y0x1y1, z0w0z1w1));
+			__m128i v23 = _mm_packus_epi32(_mm_unpacklo_epi64(x2y2x3y3, z2w2z3w3), _mm_unpackhi_epi64(x2y2x3y3, z2w2z3w3));
+
+			_mm_storeu_si128((__m128i*)(dst + i), v01);
+			_mm_storeu_si128((__m128i*)(dst + i + 2), v23);
+		}
+
+		for (; i < count; ++i)
+		{
+			vec3 const p = src[i];
+			dst[i].x = static_cast<u16>(Clamp(rintf((p.x - bounds.min.x) * scale.x), 0.0f, 65535.0f));
+			dst[i].y = static_cast<u16>(Clamp(rintf((p.y - bounds.min.y) * scale.y), 0.0f, 65535.0f));
+			dst[i].z = static_cast<u16>(Clamp(rintf((p.z - bounds.min.z) * scale.z), 0.0f, 65535.0f));
+			dst[i].w = 0;
+		}
+	}
+
+	void DequantizePositions(unorm16x4 const* src, vec3* dst, u64 count, AABB const& bounds)
+	{
+		vec3 const extent(
+			bounds.max.x - bounds.min.x,
+			bounds.max.y - bounds.min.y,
+			bounds.max.z - bounds.min.z);
+
+		for (u64 i = 0; i < count; ++i)
+		{
+			dst[i].x = bounds.min.x + (src[i].x / 65535.0f) * extent.x;
+			dst[i].y = bounds.min.y + (src[i].y / 65535.0f) * extent.y;
+			dst[i].z = bounds.min.z + (src[i].z / 65535.0f) * extent.z;
+		}
+	}
+
+	mat34 DequantizeTransform(AABB const& bounds)
+	{
+		vec3 const extent(
+			bounds.max.x - bounds.min.x,
+			bounds.max.y - bounds.min.y,
+			bounds.max.z - bounds.min.z);
+
+		mat34 translate = Math::Translation<mat34>(bounds.min.x, bounds.min.y, bounds.min.z);
+		mat34 scale = Math::Scale<mat34>(extent.x, extent.y, extent.z);
+
+		return translate * scale;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core.h"
+#include "Math.h"
+
+// ====================================
+//  Packed vertex element types
+//  Notes:
+//  *) Named after the layout the GPU reads them as,
+//     see Gfx::GetVertexAttribFormat for the DXGI formats.
+// ====================================
+
+struct unorm16x4
+{
+	u16 x, y, z, w;
+};
+
+struct snorm16x2
+{
+	s16 x, y;
+};
+
+struct snorm8x4
+{
+	s8 x, y, z, w;
+};
+
+struct half2
+{
+	u16 x, y;
+};
+
+namespace Quantize
+{
+	u16 FloatToHalf(f32 value);
+	f32 HalfToFloat(u16 value);
+
+	// Bulk fp32 <-> fp16 conversion, uses F16C when available.
+	void FloatToHalf(f32 const* src, u16* dst, u64 count);
+	void HalfToFloat(u16 const* src, f32* dst, u64 count);
+
+	// Octahedral encoding of unit vectors into 2x16 bit snorm.
+	void EncodeOctahedral(vec3 const* normals, snorm16x2* dst, u64 count);
+	void DecodeOctahedral(snorm16x2 const* src, vec3* normals, u64 count);
+
+	// Writes all four components as 8 bit snorm, e.g. tangents with their handedness in w.
+	void EncodeSnorm8(vec4 const* src, snorm8x4* dst, u64 count);
+
+	// Positions are stored as 16 bit unorm relative to the bounds of the mesh.
+	void QuantizePositions(vec3 const* src, unorm16x4* dst, u64 count, AABB const& bounds);
+	void DequantizePositions(unorm16x4 const* src, vec3* dst, u64 count, AABB const& bounds);
+
+	// Maps quantized [0,1] positions back into the bounds they were quantized against.
+	// Meant to be folded into the object transform, so the vertex shader doesn't need to know.
+	mat34 DequantizeTransform(AABB const& bounds);
+
+	namespace Test
+	{
+		void Run();
+	}
+}
\ No newline at end of file
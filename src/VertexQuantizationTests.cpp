@@ -0,0 +1,172 @@
+#include "VertexQuantization.h"
+#include "Simd.h"
+#include "TestUtils.h"
+
+namespace Quantize
+{
+namespace Test
+{
+	static bool SameFloat(f32 a, f32 b)
+	{
+		return (a != a && b != b) || memcmp(&a, &b, sizeof(f32)) == 0;
+	}
+
+	// Every half there is, the bulk conversion has to match the scalar one bit for bit.
+	void HalfToFloatMatchesScalar()
+	{
+		static constexpr u32 NUM_HALVES = 65536;
+		u16* halves = new u16[NUM_HALVES];
+		f32* floats = new f32[NUM_HALVES];
+		ON_SCOPE_EXIT(delete[] halves; delete[] floats);
+
+		for (u32 i = 0; i < NUM_HALVES; ++i)
+		{
+			halves[i] = (u16)i;
+		}
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			HalfToFloat(halves, floats, NUM_HALVES);
+			for (u32 i = 0; i < NUM_HALVES; ++i)
+			{
+				ASSERT(SameFloat(floats[i], HalfToFloat(halves[i])));
+			}
+		});
+	}
+
+	// Random bit patterns cover every exponent, the specials cover rounding ties, overflow and denormals.
+	void FloatToHalfMatchesScalar()
+	{
+		static constexpr u32 NUM_FLOATS = 4099;
+		f32 floats[NUM_FLOATS];
+		u16 halves[NUM_FLOATS];
+
+		f32 const specials[] = { 0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, 65520.0f, 1e10f, -1e10f, 1.0f + 1.0f / 2048.0f,
+			1.0f + 3.0f / 2048.0f, 6.1e-5f, 5.96e-8f, 2.98e-8f, 1e-10f, INFINITY, -INFINITY };
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < NUM_FLOATS; ++i)
+		{
+			u32 bits = random.Next();
+			if (((bits >> 23) & 0xFF) == 0xFF)
+			{
+				bits &= ~(1u << 23); // No NaNs, their payloads differ between the paths.
+			}
+			memcpy(&floats[i], &bits, sizeof(f32));
+		}
+		memcpy(floats, specials, sizeof(specials));
+
+		Simd::ForEachDispatchPath([&]()
+		{
+			FloatToHalf(floats, halves, NUM_FLOATS);
+			for (u32 i = 0; i < NUM_FLOATS; ++i)
+			{
+				ASSERT(halves[i] == FloatToHalf(floats[i]));
+			}
+		});
+	}
+
+	// The SIMD loop handles groups of 4, a count of 1 goes through the scalar tail.
+	void OctahedralMatchesScalar()
+	{
+		static constexpr u32 NUM_NORMALS = 1027;
+		vec3 normals[NUM_NORMALS];
+		snorm16x2 encoded[NUM_NORMALS];
+		vec3 decoded[NUM_NORMALS];
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < NUM_NORMALS; ++i)
+		{
+			normals[i] = Math::Normalize(vec3(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f)));
+		}
+		normals[0] = vec3(0.0f, 0.0f, 1.0f);
+		normals[1] = vec3(0.0f, 0.0f, -1.0f);
+		normals[2] = vec3(1.0f, 0.0f, 0.0f);
+		normals[3] = vec3(0.0f, -1.0f, 0.0f);
+
+		EncodeOctahedral(normals, encoded, NUM_NORMALS);
+		DecodeOctahedral(encoded, decoded, NUM_NORMALS);
+
+		for (u32 i = 0; i < NUM_NORMALS; ++i)
+		{
+			snorm16x2 scalar;
+			EncodeOctahedral(&normals[i], &scalar, 1);
+			ASSERT(abs(scalar.x - encoded[i].x) <= 1 && abs(scalar.y - encoded[i].y) <= 1);
+
+			// 16 bits per axis keep the direction to well within 0.01 degrees.
+			ASSERT(Math::Dot(normals[i], decoded[i]) > 0.99999f);
+		}
+	}
+
+	void QuantizePositionsMatchesScalar()
+	{
+		static constexpr u32 NUM_POSITIONS = 1030;
+		vec3 positions[NUM_POSITIONS];
+		unorm16x4 quantized[NUM_POSITIONS];
+		vec3 dequantized[NUM_POSITIONS];
+
+		AABB bounds;
+		bounds.min = vec3(-3.0f, 0.5f, -100.0f);
+		bounds.max = vec3(5.0f, 0.75f, 100.0f);
+
+		TestUtils::Random random;
+		for (u32 i = 0; i < NUM_POSITIONS; ++i)
+		{
+			positions[i] = vec3(random.Float(bounds.min.x, bounds.max.x), random.Float(bounds.min.y, bounds.max.y),
+				random.Float(bounds.min.z, bounds.max.z));
+		}
+		positions[0] = bounds.min;
+		positions[1] = bounds.max;
+
+		// Outside of the bounds clamps.
+		positions[2] = vec3(-4.0f, 1.0f, 0.0f);
+
+		QuantizePositions(positions, quantized, NUM_POSITIONS, bounds);
+		DequantizePositions(quantized, dequantized, NUM_POSITIONS, bounds);
+
+		ASSERT(quantized[0].x == 0 && quantized[0].y == 0 && quantized[0].z == 0);
+		ASSERT(quantized[1].x == 65535 && quantized[1].y == 65535 && quantized[1].z == 65535);
+		ASSERT(quantized[2].x == 0 && quantized[2].y == 65535);
+
+		vec3 const half_step((bounds.max.x - bounds.min.x) / 65535.0f * 0.501f, (bounds.max.y - bounds.min.y) / 65535.0f * 0.501f,
+			(bounds.max.z - bounds.min.z) / 65535.0f * 0.501f);
+
+		for (u32 i = 0; i < NUM_POSITIONS; ++i)
+		{
+			unorm16x4 scalar;
+			QuantizePositions(&positions[i], &scalar, 1, bounds);
+			ASSERT(memcmp(&scalar, &quantized[i], sizeof(unorm16x4)) == 0);
+
+			if (i != 2)
+			{
+				ASSERT(fabsf(dequantized[i].x - positions[i].x) <= half_step.x);
+				ASSERT(fabsf(dequantized[i].y - positions[i].y) <= half_step.y);
+				ASSERT(fabsf(dequantized[i].z - positions[i].z) <= half_step.z);
+			}
+		}
+	}
+
+	void DequantizeTransformMapsUnitCube()
+	{
+		AABB bounds;
+		bounds.min = vec3(-1.0f, 2.0f, -3.0f);
+		bounds.max = vec3(4.0f, 2.5f, 7.0f);
+
+		mat34 const transform = DequantizeTransform(bounds);
+		for (u32 row = 0; row < 3; ++row)
+		{
+			ASSERT(NearlyEqual(transform(row, 3), bounds.min.data[row], 1e-6f));
+			ASSERT(NearlyEqual(transform(row, 0) + transform(row, 1) + transform(row, 2) + transform(row, 3), bounds.max.data[row], 1e-6f));
+		}
+	}
+
+	void Run()
+	{
+		HalfToFloatMatchesScalar();
+		FloatToHalfMatchesScalar();
+		OctahedralMatchesScalar();
+		QuantizePositionsMatchesScalar();
+		DequantizeTransformMapsUnitCube();
+	}
+}
+}
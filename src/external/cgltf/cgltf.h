@@ -822,7 +822,9 @@ typedef struct {
 	int toksuper; /* superior token node, e.g parent object or array */
 } jsmn_parser;
 static void jsmn_init(jsmn_parser *parser);
+#ifndef CGLTF_JSON_PARSE
 static int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, size_t num_tokens);
+#endif
 /*
  * -- jsmn.h end --
  */
@@ -847,6 +849,12 @@ static const uint32_t GlbMagicBinChunk = 0x004E4942;
 #ifndef CGLTF_ATOF
 #define CGLTF_ATOF(str) atof(str)
 #endif
+/* Replaces the tokenizer, must produce the same tokens as jsmn_parse. jsmn's parser is left out then. */
+#ifdef CGLTF_JSON_PARSE
+#define CGLTF_JSMN_PARSE_REPLACED
+#else
+#define CGLTF_JSON_PARSE(parser, js, len, tokens, num_tokens) jsmn_parse(parser, js, len, tokens, num_tokens)
+#endif
 
 static void* cgltf_default_alloc(void* user, cgltf_size size)
 {
@@ -5439,7 +5447,7 @@ cgltf_result cgltf_parse_json(cgltf_options* options, const uint8_t* json_chunk,
 
 	if (options->json_token_count == 0)
 	{
-		int token_count = jsmn_parse(&parser, (const char*)json_chunk, size, NULL, 0);
+		int token_count = CGLTF_JSON_PARSE(&parser, (const char*)json_chunk, size, NULL, 0);
 
 		if (token_count <= 0)
 		{
@@ -5458,7 +5466,7 @@ cgltf_result cgltf_parse_json(cgltf_options* options, const uint8_t* json_chunk,
 
 	jsmn_init(&parser);
 
-	int token_count = jsmn_parse(&parser, (const char*)json_chunk, size, tokens, options->json_token_count);
+	int token_count = CGLTF_JSON_PARSE(&parser, (const char*)json_chunk, size, tokens, options->json_token_count);
 
 	if (token_count <= 0)
 	{
@@ -5701,6 +5709,7 @@ static int cgltf_fixup_pointers(cgltf_data* data)
  * THE SOFTWARE.
  */
 
+#ifndef CGLTF_JSMN_PARSE_REPLACED
 /**
  * Allocates a fresh unused token from the token pull.
  */
@@ -6002,6 +6011,7 @@ static int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 
 	return count;
 }
+#endif /* #ifndef CGLTF_JSMN_PARSE_REPLACED */
 
 /**
  * Creates a new parser based over a given  buffer with an array of tokens
@@ -7,6 +7,24 @@
 #include "Math.h"
 #include "Memory.h"
 #include "IO.h"
+#include "Jobs.h"
+#include "VertexQuantization.h"
+#include "Bounds.h"
+#include "MeshFile.h"
+#include "SceneGraph.h"
+#include "StreamCopy.h"
+#include "Base64.h"
+#include "ImageDecode.h"
+#include "BlockCompression.h"
+#include "MipGeneration.h"
+#include "Skinning.h"
+#include "Animation.h"
+#include "Morph.h"
+#include "Json.h"
+#include "TangentSpace.h"
+#include "Meshlets.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
 
 void AppthreadMain(BaseApp* app)
 {
@@ -29,8 +47,29 @@ INT WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 	LOG(Log::Default, "Initing File System");
 	IO::FileSysInit("C:\\Users\\Philipp\\Documents\\work\\mini3"); // TODO(): Get this from a cvar
 
+	LOG(Log::Default, "Initing Job System");
+	Jobs::Init();
+
 	LOG(Log::Default, "Running Unit Tests");
 	Math::Test::Run();
+	Quantize::Test::Run();
+	Bounds::Test::Run();
+	MeshFile::Test::Run();
+	Scene::Test::Run();
+	StreamCopy::Test::Run();
+	Base64::Test::Run();
+	Image::Test::Run();
+	BlockCompression::Test::Run();
+	MipGeneration::Test::Run();
+	Skinning::Test::Run();
+	Animation::Test::Run();
+	Morph::Test::Run();
+	Json::Test::Run();
+	IO::Test::Run();
+	MeshOpt::Test::Run();
+	Meshlets::Test::Run();
+	TangentSpace::Test::Run();
+	MeshOpt::Test::RunSimplify();
 
 	LOG(Log::Default, "Initializing mini3");
 
@@ -72,6 +111,7 @@ INT WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 	appthread.join();
 	window.Exit();
 
+	Jobs::Exit();
 	IO::FileSysExit();
 
 	return 0;
@@ -1,11 +1,48 @@
+#ifdef COMPRESSED_VERTEX_STREAMS
+
+// Positions are unorm relative to the mesh bounds, the dequantization
+// is folded into g_model on the cpu (see Quantize::DequantizeTransform).
+struct VertexIn
+{
+	float4 pos_local  : POSITION;
+	float2 normal_oct : NORMAL;
+	float2 uv		  : TEXCOORD;
+	float4 tangent	  : TANGENT;
+};
+
+float3 DecodeOctahedral(float2 oct)
+{
+	float3 n = float3(oct.x, oct.y, 1.0f - abs(oct.x) - abs(oct.y));
+	float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0f) ? -t : t;
+	return normalize(n);
+}
+
+#else
+
 struct VertexIn
 {
 	float3 pos_local : POSITION;
 	float3 normal	 : NORMAL;
 	float2 uv		 : TEXCOORD;
-	float3 tangent	 : TANGENT;
+	float4 tangent	 : TANGENT;
 };
 
+#endif // COMPRESSED_VERTEX_STREAMS
+
+#ifdef INSTANCED
+
+// Rows of the instance's model matrix, streamed per instance. Like g_model
+// it includes the dequantization of compressed positions.
+struct InstanceIn
+{
+	float4 model_row0 : INSTANCE_TRANSFORM0;
+	float4 model_row1 : INSTANCE_TRANSFORM1;
+	float4 model_row2 : INSTANCE_TRANSFORM2;
+};
+
+#endif // INSTANCED
+
 struct VertexOut
 {
 	float4 pos_sp : SV_POSITION;
@@ -21,18 +58,36 @@ cbuffer cbPerFrame : register(b0)
 
 cbuffer cbPerObject : register(b1)
 {
-	float4x4 g_model;
+	row_major float3x4 g_model; // Affine, matches mat34 on the cpu.
 };
 
+#ifdef INSTANCED
+VertexOut vs_main(VertexIn vsIn, InstanceIn instIn)
+#else
 VertexOut vs_main(VertexIn vsIn)
+#endif
 {
 	VertexOut vsOut;
 
-	float4x4 mvp = mul(g_view_proj, g_model);
-	float4 pos_sp = mul(mvp, float4(vsIn.pos_local, 1.0f));
+#ifdef INSTANCED
+	float3x4 model = float3x4(instIn.model_row0, instIn.model_row1, instIn.model_row2);
+#else
+	float3x4 model = g_model;
+#endif
+
+#ifdef COMPRESSED_VERTEX_STREAMS
+	float3 pos_local = vsIn.pos_local.xyz;
+	float3 normal = DecodeOctahedral(vsIn.normal_oct);
+#else
+	float3 pos_local = vsIn.pos_local;
+	float3 normal = vsIn.normal;
+#endif
+
+	float3 pos_world = mul(model, float4(pos_local, 1.0f));
+	float4 pos_sp = mul(g_view_proj, float4(pos_world, 1.0f));
 
 	vsOut.pos_sp = pos_sp;
-	vsOut.color = float4(abs(vsIn.normal), 1.0f);
+	vsOut.color = float4(abs(normal), 1.0f);
 
 	return vsOut;
 }
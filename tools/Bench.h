@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Core.h"
+#include "FrameTimer.h"
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+// ====================================
+//  Benchmark Helpers
+//  Notes:
+//  *) Shared by the tools/Bench*.cpp programs. Every measurement is
+//     the best of a few runs, the first one also warms the caches.
+//  *) Inputs are synthetic and generated from the fixed seed of
+//     TestUtils::Random, so runs on different machines measure the
+//     same work.
+// ====================================
+
+namespace Bench
+{
+	static constexpr u32 DEFAULT_RUNS = 5;
+
+	// Best wall time of func() in milliseconds.
+	template <typename Func>
+	f64 BestOfMs(u32 num_runs, Func func)
+	{
+		f64 best = 1e30;
+		for (u32 run = 0; run < num_runs; ++run)
+		{
+			FrameTimer timer;
+			ResetTimer(timer);
+			func();
+			TickTimer(timer);
+			best = min<f64>(best, GetTotalTimeS(timer) * 1000.0);
+		}
+		return best;
+	}
+
+	inline f64 MegabytesPerSecond(u64 num_bytes, f64 ms)
+	{
+		return (f64)num_bytes / (1024.0 * 1024.0) / (ms / 1000.0);
+	}
+}
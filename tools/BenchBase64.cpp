@@ -0,0 +1,102 @@
+#include "Bench.h"
+#include "GLTFImport.h"
+#include "Simd.h"
+
+// ====================================
+//  Base64 Decode Benchmark
+//  Notes:
+//  *) Decodes a buffer of random bytes the way a glTF data uri holds
+//     it, once with cgltf_load_buffer_base64 (what cgltf_load_buffers
+//     does for data uris) and once with Base64::Decode, on the SSE4.1
+//     baseline and with everything the CPU has, and prints the best of
+//     a few runs of each.
+//  *) Every result is compared against the input, a decoder that bails
+//     out early would otherwise look fast.
+//  *) Usage: bench_base64 [megabytes]
+// ====================================
+
+namespace BenchBase64
+{
+	static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	// With padding, like a data uri.
+	static u64 Encode(char* dst, u8 const* src, u64 num_bytes)
+	{
+		u64 length = 0;
+		for (u64 i = 0; i < num_bytes; i += 3)
+		{
+			u32 const remaining = (u32)min<u64>(num_bytes - i, 3);
+			u32 bits = (u32)src[i] << 16;
+			bits |= remaining > 1 ? (u32)src[i + 1] << 8 : 0;
+			bits |= remaining > 2 ? (u32)src[i + 2] : 0;
+
+			for (u32 j = 0; j < 4; ++j)
+			{
+				dst[length++] = j <= remaining ? ALPHABET[(bits >> (18 - 6 * j)) & 63] : '=';
+			}
+		}
+		return length;
+	}
+
+	static int Run(u64 num_bytes)
+	{
+		u8* original = new u8[num_bytes];
+		u8* decoded = new u8[num_bytes];
+		char* encoded = new char[(num_bytes + 2) / 3 * 4 + 1];
+		ON_SCOPE_EXIT(delete[] original; delete[] decoded; delete[] encoded);
+
+		TestUtils::Random random;
+		for (u64 i = 0; i < num_bytes; ++i)
+		{
+			original[i] = (u8)random.Next();
+		}
+		u64 const length = Encode(encoded, original, num_bytes);
+		encoded[length] = '\0';
+
+		Jobs::Init();
+		ON_SCOPE_EXIT(Jobs::Exit());
+
+		printf("Input: %.1f MB decoded, %.1f MB encoded\n", num_bytes / (1024.0 * 1024.0), length / (1024.0 * 1024.0));
+
+		// The checks stay out of the timed part, but run after every decoder.
+		bool valid = true;
+		cgltf_options options = {};
+		void* cgltf_data = nullptr;
+		f64 const cgltf_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]()
+		{
+			free(cgltf_data);
+			cgltf_data = nullptr;
+			valid &= cgltf_load_buffer_base64(&options, num_bytes, encoded, &cgltf_data) == cgltf_result_success;
+		});
+		valid = valid && memcmp(cgltf_data, original, num_bytes) == 0;
+		free(cgltf_data);
+
+		Simd::CpuFeatures const detected = Simd::GetCpuFeatures();
+		MemZeroSafe(Simd::GetMutableCpuFeatures());
+		f64 const sse_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]() { valid &= Base64::Decode(decoded, num_bytes, encoded, length); });
+		valid = valid && memcmp(decoded, original, num_bytes) == 0;
+
+		Simd::GetMutableCpuFeatures() = detected;
+		memset(decoded, 0, num_bytes);
+		f64 const best_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]() { valid &= Base64::Decode(decoded, num_bytes, encoded, length); });
+		valid = valid && memcmp(decoded, original, num_bytes) == 0;
+
+		if (!valid)
+		{
+			fprintf(stderr, "Decoding failed\n");
+			return 1;
+		}
+
+		printf("cgltf:                    %8.1f ms  %8.1f MB/s\n", cgltf_ms, Bench::MegabytesPerSecond(num_bytes, cgltf_ms));
+		printf("Base64 (SSE4.1):          %8.1f ms  %8.1f MB/s\n", sse_ms, Bench::MegabytesPerSecond(num_bytes, sse_ms));
+		printf("Base64 (%-6s, %2u threads): %8.1f ms  %8.1f MB/s\n", detected.avx2 ? "AVX2" : "SSE4.1", Jobs::GetThreadCount(), best_ms,
+			Bench::MegabytesPerSecond(num_bytes, best_ms));
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	u64 const megabytes = argc > 1 ? (u64)atoi(argv[1]) : 100;
+	return BenchBase64::Run(max<u64>(megabytes, 1) * 1024 * 1024);
+}
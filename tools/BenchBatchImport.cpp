@@ -0,0 +1,287 @@
+#include "Bench.h"
+#include "GLTFImport.h"
+
+// ====================================
+//  Batch Import Benchmark
+//  Notes:
+//  *) Imports a synthetic corpus of .glb files once file by file on
+//     the calling thread, and once with Mini::BatchImport on the job
+//     system, and prints the best of a few runs of each.
+//  *) The corpus is written to the given directory on the first run:
+//     every file holds 4 UV spheres with positions, normals, texcoords
+//     and 32 bit indices. Runs after that measure warm file caches.
+//  *) Usage: bench_batch_import <corpus_dir> [num_files] [vertices_per_file]
+// ====================================
+
+namespace BenchBatchImport
+{
+	static constexpr u32 SUBMESHES_PER_FILE = 4;
+	static constexpr u32 MAX_JSON_SIZE = 16 * 1024;
+
+	static constexpr u64 SCRATCH_MEMORY_SIZE = Megabyte(256);
+	static constexpr u64 MESH_MEMORY_SIZE = Gigabyte(4);
+
+	struct Corpus
+	{
+		char (*paths)[512];
+		u32 num_files;
+		u64 num_bytes;
+		u64 num_vertices;
+	};
+
+	// Appends to a fixed size JSON buffer.
+	static void Append(char* json, u32* length, char const* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		s32 const written = vsnprintf(json + *length, MAX_JSON_SIZE - *length, format, args);
+		va_end(args);
+		ASSERT(written >= 0 && *length + written < MAX_JSON_SIZE);
+		*length += (u32)written;
+	}
+
+	// Writes a .glb with SUBMESHES_PER_FILE spheres of rings x rings quads each, and returns its size.
+	static u64 WriteSphereFile(char const* path, u32 rings, TestUtils::Random& random)
+	{
+		u32 const num_vertices = (rings + 1) * (rings + 1);
+		u32 const num_indices = rings * rings * 6;
+
+		u64 const positions_size = (u64)num_vertices * sizeof(vec3);
+		u64 const normals_size = positions_size;
+		u64 const texcoords_size = (u64)num_vertices * sizeof(vec2);
+		u64 const indices_size = (u64)num_indices * sizeof(u32);
+		u64 const submesh_size = positions_size + normals_size + texcoords_size + indices_size;
+		u64 const bin_size = submesh_size * SUBMESHES_PER_FILE;
+
+		u8* bin = new u8[bin_size];
+		ON_SCOPE_EXIT(delete[] bin);
+
+		char json[MAX_JSON_SIZE];
+		u32 json_length = 0;
+		Append(json, &json_length, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],");
+		Append(json, &json_length, "\"buffers\":[{\"byteLength\":%llu}],\"bufferViews\":[", (unsigned long long)bin_size);
+
+		for (u32 submesh = 0; submesh < SUBMESHES_PER_FILE; ++submesh)
+		{
+			u64 const base = submesh * submesh_size;
+			vec3* positions = reinterpret_cast<vec3*>(bin + base);
+			vec3* normals = reinterpret_cast<vec3*>(bin + base + positions_size);
+			vec2* texcoords = reinterpret_cast<vec2*>(bin + base + positions_size + normals_size);
+			u32* indices = reinterpret_cast<u32*>(bin + base + positions_size + normals_size + texcoords_size);
+
+			f32 const radius = 0.5f + (random.Next() & 0xFF) / 256.0f;
+			vec3 const center((f32)submesh * 3.0f, 0.0f, 0.0f);
+			for (u32 ring = 0; ring <= rings; ++ring)
+			{
+				f32 const theta = Math::Pi * ring / rings;
+				for (u32 segment = 0; segment <= rings; ++segment)
+				{
+					f32 const phi = 2.0f * Math::Pi * segment / rings;
+					u32 const vertex = ring * (rings + 1) + segment;
+					vec3 const normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+					normals[vertex] = normal;
+					positions[vertex] = vec3(center.x + normal.x * radius, center.y + normal.y * radius, center.z + normal.z * radius);
+					texcoords[vertex] = vec2((f32)segment / rings, (f32)ring / rings);
+				}
+			}
+
+			u32* index = indices;
+			for (u32 ring = 0; ring < rings; ++ring)
+			{
+				for (u32 segment = 0; segment < rings; ++segment)
+				{
+					u32 const a = ring * (rings + 1) + segment;
+					u32 const b = a + rings + 1;
+					*index++ = a; *index++ = b; *index++ = a + 1;
+					*index++ = a + 1; *index++ = b; *index++ = b + 1;
+				}
+			}
+
+			Append(json, &json_length, "%s{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},", submesh == 0 ? "" : ",",
+				(unsigned long long)base, (unsigned long long)positions_size);
+			Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},",
+				(unsigned long long)(base + positions_size), (unsigned long long)normals_size);
+			Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},",
+				(unsigned long long)(base + positions_size + normals_size), (unsigned long long)texcoords_size);
+			Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}",
+				(unsigned long long)(base + positions_size + normals_size + texcoords_size), (unsigned long long)indices_size);
+		}
+
+		Append(json, &json_length, "],\"accessors\":[");
+		for (u32 submesh = 0; submesh < SUBMESHES_PER_FILE; ++submesh)
+		{
+			u32 const view = submesh * 4;
+			f32 const min_x = (f32)submesh * 3.0f - 2.0f;
+			Append(json, &json_length, "%s{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\","
+				"\"min\":[%g,-2,-2],\"max\":[%g,2,2]},", submesh == 0 ? "" : ",", view, num_vertices, min_x, min_x + 4.0f);
+			Append(json, &json_length, "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},", view + 1, num_vertices);
+			Append(json, &json_length, "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},", view + 2, num_vertices);
+			Append(json, &json_length, "{\"bufferView\":%u,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}", view + 3, num_indices);
+		}
+
+		Append(json, &json_length, "],\"meshes\":[{\"primitives\":[");
+		for (u32 submesh = 0; submesh < SUBMESHES_PER_FILE; ++submesh)
+		{
+			u32 const accessor = submesh * 4;
+			Append(json, &json_length, "%s{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u}",
+				submesh == 0 ? "" : ",", accessor, accessor + 1, accessor + 2, accessor + 3);
+		}
+		Append(json, &json_length, "]}]}");
+
+		while (json_length % 4 != 0)
+		{
+			json[json_length++] = ' ';
+		}
+
+		u32 const header[3] = { 0x46546C67, 2, (u32)(12 + 8 + json_length + 8 + bin_size) };
+		u32 const json_chunk[2] = { json_length, 0x4E4F534A };
+		u32 const bin_chunk[2] = { (u32)bin_size, 0x004E4942 };
+
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+		{
+			return 0;
+		}
+		fwrite(header, sizeof(header), 1, file);
+		fwrite(json_chunk, sizeof(json_chunk), 1, file);
+		fwrite(json, json_length, 1, file);
+		fwrite(bin_chunk, sizeof(bin_chunk), 1, file);
+		fwrite(bin, bin_size, 1, file);
+		fclose(file);
+
+		return header[2];
+	}
+
+	static bool PrepareCorpus(char const* dir, u32 num_files, u32 vertices_per_file, Corpus* out_corpus)
+	{
+		u32 const rings = max<u32>(2, (u32)sqrtf((f32)vertices_per_file / SUBMESHES_PER_FILE)) - 1;
+
+		out_corpus->paths = new char[num_files][512];
+		out_corpus->num_files = num_files;
+		out_corpus->num_bytes = 0;
+		out_corpus->num_vertices = (u64)num_files * SUBMESHES_PER_FILE * (rings + 1) * (rings + 1);
+
+		TestUtils::Random random;
+		u32 num_written = 0;
+		for (u32 i = 0; i < num_files; ++i)
+		{
+			snprintf(out_corpus->paths[i], sizeof(out_corpus->paths[i]), "%s/corpus_%u_%04u.glb", dir, rings, i);
+
+			IO::MappedFile existing;
+			if (IO::MapFile(out_corpus->paths[i], &existing))
+			{
+				out_corpus->num_bytes += existing.size;
+				IO::UnmapFile(&existing);
+				continue;
+			}
+
+			u64 const size = WriteSphereFile(out_corpus->paths[i], rings, random);
+			if (size == 0)
+			{
+				fprintf(stderr, "Can't write %s\n", out_corpus->paths[i]);
+				return false;
+			}
+			out_corpus->num_bytes += size;
+			++num_written;
+		}
+
+		if (num_written > 0)
+		{
+			printf("Wrote %u corpus files to %s\n", num_written, dir);
+		}
+		return true;
+	}
+
+	static void ImportSerial(Corpus const& corpus, Mini::SceneImporter* importers, Memory::Arena* scratch_memory, Memory::Arena* mesh_memory)
+	{
+		Memory::ClearArena(mesh_memory, false);
+		for (u32 i = 0; i < corpus.num_files; ++i)
+		{
+			Memory::TemporaryAllocation scratch = Memory::BeginTemporaryAlloc(scratch_memory);
+			importers[i].scratch_memory = scratch_memory;
+			importers[i].shared_memory_lock = nullptr;
+			Mini::Import(&importers[i]);
+			Memory::RewindTemporaryAlloc(scratch_memory, scratch, false);
+		}
+	}
+
+	static void ImportBatch(Corpus const& corpus, Mini::SceneImporter* importers, Mini::MeshImport* results, Memory::Arena* mesh_memory)
+	{
+		Memory::ClearArena(mesh_memory, false);
+
+		Mini::BatchImport* batch = new Mini::BatchImport();
+		ON_SCOPE_EXIT(delete batch);
+		batch->importers = importers;
+		batch->results = results;
+		batch->count = corpus.num_files;
+		batch->scratch_size_per_thread = SCRATCH_MEMORY_SIZE;
+
+		Mini::BeginBatchImport(batch);
+		Mini::WaitForBatchImport(batch);
+	}
+
+	static int Run(char const* dir, u32 num_files, u32 vertices_per_file)
+	{
+		Corpus corpus;
+		if (!PrepareCorpus(dir, num_files, vertices_per_file, &corpus))
+		{
+			return 1;
+		}
+		ON_SCOPE_EXIT(delete[] corpus.paths);
+
+		Memory::Arena scratch_memory;
+		Memory::Arena mesh_memory;
+		Memory::InitArena(&scratch_memory, SCRATCH_MEMORY_SIZE);
+		Memory::InitArena(&mesh_memory, MESH_MEMORY_SIZE);
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch_memory); Memory::FreeArena(&mesh_memory));
+
+		Mini::SceneImporter* importers = new Mini::SceneImporter[num_files];
+		Mini::MeshImport* results = new Mini::MeshImport[num_files];
+		ON_SCOPE_EXIT(delete[] importers; delete[] results);
+
+		for (u32 i = 0; i < num_files; ++i)
+		{
+			importers[i].file_path = corpus.paths[i];
+			importers[i].mesh_memory = &mesh_memory;
+			importers[i].scene_memory = nullptr;
+			importers[i].flags = Mini::ImportFlags::CompressVertexStreams;
+		}
+
+		Jobs::Init();
+		ON_SCOPE_EXIT(Jobs::Exit());
+
+		printf("Corpus: %u files, %.1f MB, %.2fM vertices, %u submeshes each\n", num_files,
+			corpus.num_bytes / (1024.0 * 1024.0), corpus.num_vertices / 1e6, SUBMESHES_PER_FILE);
+
+		f64 const serial_ms = Bench::BestOfMs(3, [&]() { ImportSerial(corpus, importers, &scratch_memory, &mesh_memory); });
+		f64 const batch_ms = Bench::BestOfMs(3, [&]() { ImportBatch(corpus, importers, results, &mesh_memory); });
+
+		// A failed import is fast, make sure nothing was skipped.
+		for (u32 i = 0; i < num_files; ++i)
+		{
+			if (results[i].num_submeshes != SUBMESHES_PER_FILE)
+			{
+				fprintf(stderr, "Importing %s failed\n", corpus.paths[i]);
+				return 1;
+			}
+		}
+
+		printf("serial:              %8.1f ms  %7.1f MB/s\n", serial_ms, Bench::MegabytesPerSecond(corpus.num_bytes, serial_ms));
+		printf("batch (%2u threads):  %8.1f ms  %7.1f MB/s\n", Jobs::GetThreadCount(), batch_ms,
+			Bench::MegabytesPerSecond(corpus.num_bytes, batch_ms));
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <corpus_dir> [num_files] [vertices_per_file]\n", argv[0]);
+		return 1;
+	}
+
+	u32 const num_files = argc > 2 ? (u32)atoi(argv[2]) : 200;
+	u32 const vertices_per_file = argc > 3 ? (u32)atoi(argv[3]) : 32 * 1024;
+	return BenchBatchImport::Run(argv[1], max<u32>(num_files, 1), vertices_per_file);
+}
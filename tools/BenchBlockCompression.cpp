@@ -0,0 +1,107 @@
+#include "Bench.h"
+#include "BlockCompression.h"
+#include "Jobs.h"
+
+// ====================================
+//  Block Compression Benchmark
+//  Notes:
+//  *) Compresses a synthetic image (TestUtils::FillImage, gradients,
+//     hard edges and noise) to every BCn format and BC7 quality on the
+//     job system, and prints the best of a few runs with the PSNR of
+//     the decoded result.
+//  *) PSNR is over RGB for BC1 and opaque BC7, RGBA for BC3 and BC7
+//     with alpha, and over the channels that are stored for BC4/BC5.
+//  *) Usage: bench_block_compression [size]
+// ====================================
+
+namespace BenchBlockCompression
+{
+	struct Config
+	{
+		char const* name;
+		Gfx::TextureFormat::Enum format;
+		BlockCompression::Quality::Enum quality;
+		bool b_opaque;
+		u32 num_channels;
+	};
+
+	static Config const CONFIGS[] =
+	{
+		{ "BC1", Gfx::TextureFormat::BC1, BlockCompression::Quality::Normal, true, 3 },
+		{ "BC3", Gfx::TextureFormat::BC3, BlockCompression::Quality::Normal, false, 4 },
+		{ "BC4", Gfx::TextureFormat::BC4, BlockCompression::Quality::Normal, true, 1 },
+		{ "BC5", Gfx::TextureFormat::BC5, BlockCompression::Quality::Normal, true, 2 },
+		{ "BC7 fast", Gfx::TextureFormat::BC7, BlockCompression::Quality::Fast, true, 3 },
+		{ "BC7 normal", Gfx::TextureFormat::BC7, BlockCompression::Quality::Normal, true, 3 },
+		{ "BC7 high", Gfx::TextureFormat::BC7, BlockCompression::Quality::High, true, 3 },
+		{ "BC7 fast alpha", Gfx::TextureFormat::BC7, BlockCompression::Quality::Fast, false, 4 },
+		{ "BC7 normal alpha", Gfx::TextureFormat::BC7, BlockCompression::Quality::Normal, false, 4 },
+		{ "BC7 high alpha", Gfx::TextureFormat::BC7, BlockCompression::Quality::High, false, 4 },
+	};
+
+	// The size is a multiple of 4, every block is a full one.
+	static f64 ComputePsnr(Image::Surface const& surface, u8 const* compressed, Config const& config)
+	{
+		u32 const block_size = BlockCompression::GetBlockSize(config.format);
+		u32 const blocks_x = surface.width / 4;
+		u32 const blocks_y = surface.height / 4;
+
+		f64 squared_error = 0.0;
+		for (u32 block_y = 0; block_y < blocks_y; ++block_y)
+		{
+			for (u32 block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				u8 decoded[64];
+				BlockCompression::DecompressBlock(decoded, compressed + ((u64)block_y * blocks_x + block_x) * block_size, config.format);
+
+				for (u32 i = 0; i < 16; ++i)
+				{
+					u8 const* original = surface.pixels + ((u64)(block_y * 4 + i / 4) * surface.width + block_x * 4 + i % 4) * 4;
+					for (u32 c = 0; c < config.num_channels; ++c)
+					{
+						f64 const diff = (f64)decoded[i * 4 + c] - (f64)original[c];
+						squared_error += diff * diff;
+					}
+				}
+			}
+		}
+
+		return TestUtils::Psnr(squared_error, (u64)surface.width * surface.height * config.num_channels);
+	}
+
+	static int Run(u32 size)
+	{
+		u64 const num_pixels = (u64)size * size;
+		u8* opaque = new u8[num_pixels * 4];
+		u8* translucent = new u8[num_pixels * 4];
+		u8* compressed = new u8[num_pixels];
+		ON_SCOPE_EXIT(delete[] opaque; delete[] translucent; delete[] compressed);
+
+		TestUtils::Random random;
+		TestUtils::FillImage(opaque, size, size, true, random);
+		TestUtils::FillImage(translucent, size, size, false, random);
+
+		Jobs::Init();
+		ON_SCOPE_EXIT(Jobs::Exit());
+
+		printf("Image: %ux%u, %u threads\n", size, size, Jobs::GetThreadCount());
+		for (Config const& config : CONFIGS)
+		{
+			Image::Surface const surface = { config.b_opaque ? opaque : translucent, size, size };
+
+			// BC7 high takes a while, a single run of it is plenty.
+			u32 const num_runs = config.quality == BlockCompression::Quality::High ? 1 : Bench::DEFAULT_RUNS;
+			f64 const ms = Bench::BestOfMs(num_runs, [&]() { BlockCompression::Compress(compressed, &surface, 1, config.format, config.quality); });
+
+			printf("%-18s %9.1f ms  %8.2f Mpixels/s  %6.2f dB\n", config.name, ms, num_pixels / 1e6 / (ms / 1000.0),
+				ComputePsnr(surface, compressed, config));
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	u32 const size = argc > 1 ? (u32)atoi(argv[1]) : 1024;
+	return BenchBlockCompression::Run(max<u32>(size & ~3u, 4));
+}
@@ -0,0 +1,179 @@
+#include "Bench.h"
+#include "Json.h"
+#include "Simd.h"
+
+// Without the CGLTF_JSON_PARSE override, so jsmn_parse is compiled.
+#define CGLTF_IMPLEMENTATION
+#include "external/cgltf/cgltf.h"
+
+// ====================================
+//  JSON Tokenizer Benchmark
+//  Notes:
+//  *) Generates a .gltf document of about the given size, mostly nodes
+//     and accessors like a large scene export, and tokenizes it with
+//     jsmn_parse (what cgltf uses) and with Json::Tokenize, on the
+//     SSE4.1 baseline and with everything the CPU has. Prints the best
+//     of a few runs of the count pass and the token pass of each.
+//  *) Every token array is compared against jsmn's, a tokenizer that
+//     bails out early would otherwise look fast.
+//  *) Usage: bench_json [megabytes]
+// ====================================
+
+namespace BenchJson
+{
+	struct Writer
+	{
+		char* data;
+		u64 length;
+		u64 capacity;
+	};
+
+	template <typename... Args>
+	static void Append(Writer* writer, char const* format, Args... args)
+	{
+		s32 const written = snprintf(writer->data + writer->length, writer->capacity - writer->length, format, args...);
+		writer->length = min<u64>(writer->length + (u64)max(written, 0), writer->capacity - 1);
+	}
+
+	static void AppendNode(Writer* writer, u32 node, u32 num_meshes, TestUtils::Random& random)
+	{
+		// Some names need escapes, some nodes have children.
+		Append(writer, node % 7 == 0 ? "{\"name\":\"node \\\"%u\\\"\"" : "{\"name\":\"node_%u\"", node);
+		Append(writer, ",\"mesh\":%u", random.Index(num_meshes));
+		Append(writer, ",\"translation\":[%.4f,%.4f,%.4f]", random.Float(-100.0f, 100.0f), random.Float(-100.0f, 100.0f), random.Float(-100.0f, 100.0f));
+		Append(writer, ",\"rotation\":[%.6f,%.6f,%.6f,%.6f]", random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+		Append(writer, ",\"scale\":[1,1,1]");
+		if (node % 3 == 0)
+		{
+			Append(writer, ",\"children\":[%u,%u]", node + 1, node + 2);
+		}
+		Append(writer, "}");
+	}
+
+	static void AppendAccessor(Writer* writer, u32 accessor, TestUtils::Random& random)
+	{
+		Append(writer, "{\"bufferView\":%u,\"byteOffset\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"", accessor, 1 + random.Index(65536));
+		Append(writer, ",\"min\":[%.5f,%.5f,%.5f]", random.Float(-10.0f, 0.0f), random.Float(-10.0f, 0.0f), random.Float(-10.0f, 0.0f));
+		Append(writer, ",\"max\":[%.5f,%.5f,%.5f]}", random.Float(0.0f, 10.0f), random.Float(0.0f, 10.0f), random.Float(0.0f, 10.0f));
+	}
+
+	// About half nodes, the rest accessors with a buffer view each, and a few meshes.
+	static u64 GenerateGltf(char* data, u64 capacity, u64 target_size)
+	{
+		static constexpr u32 NUM_MESHES = 1000;
+		TestUtils::Random random;
+		Writer writer = { data, 0, capacity };
+
+		Append(&writer, "{\n\"asset\":{\"version\":\"2.0\",\"generator\":\"bench_json\"},\n\"scene\":0,\n\"scenes\":[{\"nodes\":[0]}],\n\"nodes\":[\n");
+		u32 num_nodes = 0;
+		while (writer.length < target_size / 2)
+		{
+			Append(&writer, num_nodes > 0 ? ",\n" : "");
+			AppendNode(&writer, num_nodes++, NUM_MESHES, random);
+		}
+
+		Append(&writer, "\n],\n\"meshes\":[\n");
+		for (u32 mesh = 0; mesh < NUM_MESHES; ++mesh)
+		{
+			Append(&writer, "%s{\"primitives\":[{\"attributes\":{\"POSITION\":%u},\"mode\":4}]}", mesh > 0 ? ",\n" : "", mesh);
+		}
+
+		Append(&writer, "\n],\n\"accessors\":[\n");
+		u32 num_accessors = 0;
+		while (writer.length < target_size * 7 / 8)
+		{
+			Append(&writer, num_accessors > 0 ? ",\n" : "");
+			AppendAccessor(&writer, num_accessors++, random);
+		}
+
+		Append(&writer, "\n],\n\"bufferViews\":[\n");
+		for (u32 view = 0; view < num_accessors; ++view)
+		{
+			Append(&writer, "%s{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u}", view > 0 ? ",\n" : "", view * 1024, 1024);
+		}
+		Append(&writer, "\n],\n\"buffers\":[{\"byteLength\":%u,\"uri\":\"scene.bin\"}]\n}\n", num_accessors * 1024);
+		return writer.length;
+	}
+
+	static int Run(u64 target_size)
+	{
+		u64 const capacity = target_size + target_size / 2 + 4096;
+		char* json = new char[capacity];
+		ON_SCOPE_EXIT(delete[] json);
+		u64 const length = GenerateGltf(json, capacity, target_size);
+
+		jsmn_parser parser;
+		jsmn_init(&parser);
+		s32 const num_tokens = jsmn_parse(&parser, json, length, nullptr, 0);
+		if (num_tokens <= 0)
+		{
+			fprintf(stderr, "jsmn failed to count the tokens (%d)\n", num_tokens);
+			return 1;
+		}
+
+		jsmntok_t* jsmn_tokens = new jsmntok_t[num_tokens];
+		Json::Token* tokens = new Json::Token[num_tokens];
+		ON_SCOPE_EXIT(delete[] jsmn_tokens; delete[] tokens);
+
+		printf("Input: %.1f MB, %d tokens\n", length / (1024.0 * 1024.0), num_tokens);
+
+		// The checks stay out of the timed part, but run after every tokenizer.
+		bool valid = true;
+		s32 result = 0;
+		f64 const jsmn_count_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]()
+		{
+			jsmn_init(&parser);
+			result = jsmn_parse(&parser, json, length, nullptr, 0);
+		});
+		valid &= result == num_tokens;
+
+		f64 const jsmn_token_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]()
+		{
+			jsmn_init(&parser);
+			result = jsmn_parse(&parser, json, length, jsmn_tokens, num_tokens);
+		});
+		valid &= result == num_tokens;
+
+		static_assert(sizeof(jsmntok_t) == sizeof(Json::Token), "Json::Token has to match cgltf's jsmn tokens!");
+		auto measure = [&](f64* out_count_ms, f64* out_token_ms)
+		{
+			*out_count_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]() { result = Json::Tokenize(json, length, nullptr, 0); });
+			valid &= result == num_tokens;
+
+			memset(tokens, 0, sizeof(Json::Token) * num_tokens);
+			*out_token_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]() { result = Json::Tokenize(json, length, tokens, num_tokens); });
+			valid &= result == num_tokens && memcmp(tokens, jsmn_tokens, sizeof(Json::Token) * num_tokens) == 0;
+		};
+
+		Simd::CpuFeatures const detected = Simd::GetCpuFeatures();
+		MemZeroSafe(Simd::GetMutableCpuFeatures());
+		f64 sse_count_ms, sse_token_ms;
+		measure(&sse_count_ms, &sse_token_ms);
+
+		Simd::GetMutableCpuFeatures() = detected;
+		f64 best_count_ms, best_token_ms;
+		measure(&best_count_ms, &best_token_ms);
+
+		if (!valid)
+		{
+			fprintf(stderr, "Tokenizing failed or didn't match jsmn\n");
+			return 1;
+		}
+
+		char const* best_name = detected.avx2 ? "AVX2" : "SSE4.1";
+		printf("                      count pass             token pass\n");
+		printf("jsmn:            %8.1f ms %7.1f MB/s  %8.1f ms %7.1f MB/s\n", jsmn_count_ms, Bench::MegabytesPerSecond(length, jsmn_count_ms),
+			jsmn_token_ms, Bench::MegabytesPerSecond(length, jsmn_token_ms));
+		printf("Json (SSE4.1):   %8.1f ms %7.1f MB/s  %8.1f ms %7.1f MB/s\n", sse_count_ms, Bench::MegabytesPerSecond(length, sse_count_ms),
+			sse_token_ms, Bench::MegabytesPerSecond(length, sse_token_ms));
+		printf("Json (%-6s):   %8.1f ms %7.1f MB/s  %8.1f ms %7.1f MB/s\n", best_name, best_count_ms, Bench::MegabytesPerSecond(length, best_count_ms),
+			best_token_ms, Bench::MegabytesPerSecond(length, best_token_ms));
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	u64 const megabytes = argc > 1 ? (u64)atoi(argv[1]) : 64;
+	return BenchJson::Run(max<u64>(megabytes, 1) * 1024 * 1024);
+}
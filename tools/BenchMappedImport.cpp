@@ -0,0 +1,323 @@
+#include "Bench.h"
+#include "GLTFImport.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ====================================
+//  Mapped Import Benchmark
+//  Notes:
+//  *) Loads a synthetic .gltf with one large external .bin the way
+//     Mini::Import does (cgltf_parse_file, cgltf_load_buffers and a copy
+//     of every accessor), once through the IO::MapFile callbacks and once
+//     reading every file into a zeroed arena allocation, like the import
+//     did before. Prints the best of a few runs of each.
+//  *) Cold runs drop the files from the page cache before every run with
+//     posix_fadvise, so this is Linux only. Warm runs follow right after.
+//  *) The corpus is written to the given directory on the first run.
+//  *) Usage: bench_mapped_import <corpus_dir> [megabytes]
+// ====================================
+
+namespace BenchMappedImport
+{
+	static constexpr u32 VERTICES_PER_MESH = 64 * 1024;
+	static constexpr u64 MESH_SIZE = (u64)VERTICES_PER_MESH * (sizeof(vec3) * 2 + sizeof(vec2) + sizeof(u32) * 3);
+	static constexpr u32 MAX_JSON_SIZE = 256 * 1024;
+
+	static constexpr u64 SCRATCH_MEMORY_SIZE = Gigabyte(2);
+
+	struct Corpus
+	{
+		char gltf_path[512];
+		char bin_path[512];
+		u32 num_meshes;
+		u64 bin_size;
+	};
+
+	// Appends to a fixed size JSON buffer.
+	static void Append(char* json, u32* length, char const* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		s32 const written = vsnprintf(json + *length, MAX_JSON_SIZE - *length, format, args);
+		va_end(args);
+		ASSERT(written >= 0 && *length + written < MAX_JSON_SIZE);
+		*length += (u32)written;
+	}
+
+	// Every mesh has positions, normals, texcoords and 32 bit indices, back to back in the .bin.
+	static bool WriteCorpus(Corpus const& corpus, char const* bin_name)
+	{
+		char* json = new char[MAX_JSON_SIZE];
+		u8* mesh = new u8[MESH_SIZE];
+		ON_SCOPE_EXIT(delete[] json; delete[] mesh);
+
+		u32 length = 0;
+		Append(json, &length, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],");
+		Append(json, &length, "\"buffers\":[{\"byteLength\":%llu,\"uri\":\"%s\"}],\"bufferViews\":[", (unsigned long long)corpus.bin_size, bin_name);
+
+		u64 const element_sizes[4] = { sizeof(vec3), sizeof(vec3), sizeof(vec2), sizeof(u32) * 3 };
+		u64 offset = 0;
+		for (u32 i = 0; i < corpus.num_meshes * 4; ++i)
+		{
+			u64 const size = VERTICES_PER_MESH * element_sizes[i % 4];
+			Append(json, &length, "%s{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}", i == 0 ? "" : ",",
+				(unsigned long long)offset, (unsigned long long)size);
+			offset += size;
+		}
+
+		Append(json, &length, "],\"accessors\":[");
+		for (u32 i = 0; i < corpus.num_meshes; ++i)
+		{
+			Append(json, &length, "%s{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,1,1]},",
+				i == 0 ? "" : ",", i * 4, VERTICES_PER_MESH);
+			Append(json, &length, "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},", i * 4 + 1, VERTICES_PER_MESH);
+			Append(json, &length, "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},", i * 4 + 2, VERTICES_PER_MESH);
+			Append(json, &length, "{\"bufferView\":%u,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}", i * 4 + 3, VERTICES_PER_MESH * 3);
+		}
+
+		Append(json, &length, "],\"meshes\":[{\"primitives\":[");
+		for (u32 i = 0; i < corpus.num_meshes; ++i)
+		{
+			Append(json, &length, "%s{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u}",
+				i == 0 ? "" : ",", i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3);
+		}
+		Append(json, &length, "]}]}");
+
+		if (!IO::SaveFile(corpus.gltf_path, json, length))
+		{
+			return false;
+		}
+
+		FILE* file = fopen(corpus.bin_path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		ON_SCOPE_EXIT(fclose(file));
+
+		// Only the bytes matter here, nothing is decoded.
+		TestUtils::Random random;
+		for (u32 i = 0; i < corpus.num_meshes; ++i)
+		{
+			for (u64 word = 0; word < MESH_SIZE / sizeof(u32); ++word)
+			{
+				u32 const value = random.Next();
+				memcpy(mesh + word * sizeof(u32), &value, sizeof(u32));
+			}
+			if (fwrite(mesh, MESH_SIZE, 1, file) != 1)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool PrepareCorpus(char const* dir, u32 megabytes, Corpus* out_corpus)
+	{
+		out_corpus->num_meshes = max<u32>(1, (u32)(Megabyte(megabytes) / MESH_SIZE));
+		out_corpus->bin_size = out_corpus->num_meshes * MESH_SIZE;
+
+		char bin_name[64];
+		snprintf(bin_name, sizeof(bin_name), "mapped_import_%u.bin", out_corpus->num_meshes);
+		snprintf(out_corpus->gltf_path, sizeof(out_corpus->gltf_path), "%s/mapped_import_%u.gltf", dir, out_corpus->num_meshes);
+		snprintf(out_corpus->bin_path, sizeof(out_corpus->bin_path), "%s/%s", dir, bin_name);
+
+		IO::MappedFile existing;
+		if (IO::MapFile(out_corpus->bin_path, &existing))
+		{
+			bool const b_complete = existing.size == out_corpus->bin_size;
+			IO::UnmapFile(&existing);
+			if (b_complete)
+			{
+				return true;
+			}
+		}
+
+		if (!WriteCorpus(*out_corpus, bin_name))
+		{
+			fprintf(stderr, "Can't write the corpus to %s\n", dir);
+			return false;
+		}
+		printf("Wrote %s\n", out_corpus->gltf_path);
+		return true;
+	}
+
+	// Written pages are flushed first, dirty pages can't be dropped.
+	static void DropFromPageCache(char const* path)
+	{
+		s32 const fd = open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return;
+		}
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+
+	// The import before mapping: a zeroed allocation in scratch memory, then read.
+	static cgltf_result ReadFileIntoArena(cgltf_memory_options const* memory_options, cgltf_file_options const* file_options,
+		char const* path, cgltf_size* size, void** data)
+	{
+		UNUSED(memory_options);
+
+		s32 const fd = open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return cgltf_result_file_not_found;
+		}
+		ON_SCOPE_EXIT(close(fd));
+
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			return cgltf_result_io_error;
+		}
+
+		Memory::Arena* arena = static_cast<Memory::Arena*>(file_options->user_data);
+		u8* bytes = (u8*)Memory::PushSize(arena, file_stat.st_size, Memory::ZeroPush());
+		u64 num_read = 0;
+		while (num_read < (u64)file_stat.st_size)
+		{
+			ssize_t const result = read(fd, bytes + num_read, file_stat.st_size - num_read);
+			if (result <= 0)
+			{
+				return cgltf_result_io_error;
+			}
+			num_read += result;
+		}
+
+		*size = file_stat.st_size;
+		*data = bytes;
+		return cgltf_result_success;
+	}
+
+	static void ReleaseNothing(cgltf_memory_options const* memory_options, cgltf_file_options const* file_options, void* data)
+	{
+		// The scratch arena is rewound as a whole.
+		UNUSED(memory_options);
+		UNUSED(file_options);
+		UNUSED(data);
+	}
+
+	static void* AllocFromArena(void* user, u64 size)
+	{
+		return Memory::PushSize(static_cast<Memory::Arena*>(user), size);
+	}
+
+	static void FreeFromArena(void* user, void* data)
+	{
+		UNUSED(user);
+		UNUSED(data);
+	}
+
+	// Parses, loads the buffers and copies every accessor to dst. Returns the number of bytes copied, 0 on failure.
+	static u64 LoadAccessors(char const* path, bool b_mapped, Memory::Arena* scratch_memory, u8* dst)
+	{
+		Memory::TemporaryAllocation scratch = Memory::BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, scratch, false));
+
+		Mini::MappedFiles mapped_files;
+		ON_SCOPE_EXIT(Mini::UnmapAllFiles(&mapped_files));
+
+		cgltf_options options;
+		MemZeroSafe(options);
+		options.memory.alloc = &AllocFromArena;
+		options.memory.free = &FreeFromArena;
+		options.memory.user_data = scratch_memory;
+		options.file.read = b_mapped ? &Mini::MapFileForCgltf : &ReadFileIntoArena;
+		options.file.release = b_mapped ? &Mini::ReleaseFileForCgltf : &ReleaseNothing;
+		options.file.user_data = b_mapped ? (void*)&mapped_files : (void*)scratch_memory;
+
+		cgltf_data* data;
+		if (cgltf_parse_file(&options, path, &data) != cgltf_result_success)
+		{
+			return 0;
+		}
+		ON_SCOPE_EXIT(cgltf_free(data));
+
+		if (cgltf_load_buffers(&options, data, path) != cgltf_result_success)
+		{
+			return 0;
+		}
+
+		u64 num_copied = 0;
+		for (cgltf_size i = 0; i < data->accessors_count; ++i)
+		{
+			cgltf_accessor const& accessor = data->accessors[i];
+			u8 const* src = static_cast<u8 const*>(accessor.buffer_view->buffer->data) + accessor.buffer_view->offset + accessor.offset;
+			u64 const size = accessor.count * accessor.stride;
+			memcpy(dst + num_copied, src, size);
+			num_copied += size;
+		}
+		return num_copied;
+	}
+
+	static int Run(char const* dir, u32 megabytes)
+	{
+		Corpus corpus;
+		if (!PrepareCorpus(dir, megabytes, &corpus))
+		{
+			return 1;
+		}
+
+		Memory::Arena scratch_memory;
+		Memory::InitArena(&scratch_memory, SCRATCH_MEMORY_SIZE);
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch_memory));
+
+		u8* copied[2];
+		copied[0] = new u8[corpus.bin_size];
+		copied[1] = new u8[corpus.bin_size];
+		ON_SCOPE_EXIT(delete[] copied[0]; delete[] copied[1]);
+
+		printf("Corpus: %.1f MB .bin, %u meshes, %u accessors\n", corpus.bin_size / (1024.0 * 1024.0), corpus.num_meshes, corpus.num_meshes * 4);
+
+		bool valid = true;
+		f64 cold_ms[2];
+		f64 warm_ms[2];
+		for (u32 mapped = 0; mapped < 2; ++mapped)
+		{
+			auto load = [&]() { valid &= LoadAccessors(corpus.gltf_path, mapped != 0, &scratch_memory, copied[mapped]) == corpus.bin_size; };
+
+			cold_ms[mapped] = 1e30;
+			for (u32 run = 0; run < Bench::DEFAULT_RUNS; ++run)
+			{
+				DropFromPageCache(corpus.gltf_path);
+				DropFromPageCache(corpus.bin_path);
+				cold_ms[mapped] = min(cold_ms[mapped], Bench::BestOfMs(1, load));
+			}
+			warm_ms[mapped] = Bench::BestOfMs(Bench::DEFAULT_RUNS, load);
+		}
+
+		// Every accessor is a whole buffer view, so both copies are the .bin.
+		if (!valid || memcmp(copied[0], copied[1], corpus.bin_size) != 0)
+		{
+			fprintf(stderr, "Loading %s failed or didn't match\n", corpus.gltf_path);
+			return 1;
+		}
+
+		char const* names[2] = { "read:  ", "mapped:" };
+		printf("                 cold                      warm\n");
+		for (u32 mapped = 0; mapped < 2; ++mapped)
+		{
+			printf("%s  %8.1f ms  %7.1f MB/s  %8.1f ms  %7.1f MB/s\n", names[mapped],
+				cold_ms[mapped], Bench::MegabytesPerSecond(corpus.bin_size, cold_ms[mapped]),
+				warm_ms[mapped], Bench::MegabytesPerSecond(corpus.bin_size, warm_ms[mapped]));
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <corpus_dir> [megabytes]\n", argv[0]);
+		return 1;
+	}
+
+	u32 const megabytes = argc > 2 ? (u32)atoi(argv[2]) : 192;
+	return BenchMappedImport::Run(argv[1], max<u32>(megabytes, 1));
+}
@@ -0,0 +1,326 @@
+#include "Bench.h"
+#include "GLTFImport.h"
+#include "MeshFile.h"
+
+// ====================================
+//  Mesh File Load Benchmark
+//  Notes:
+//  *) Writes a synthetic corpus of .glb files, cooks each one to a
+//     .mmesh with the import flags below, and then loads the corpus
+//     with Mini::Import from the .glb files and with MeshFile::Load
+//     from the .mmesh files. Prints the best of a few runs of each.
+//  *) Every load is followed by a pass over the index and vertex
+//     streams, like the GPU upload would do. A mapped file is only
+//     read from disk on that pass, so both paths include it. The sums
+//     also check that both loads produced the same mesh.
+//  *) The corpus is written and cooked on the first run, all runs
+//     measure warm file caches.
+//  *) Usage: bench_mesh_file_load <corpus_dir> [num_files] [vertices_per_file]
+// ====================================
+
+namespace BenchMeshFileLoad
+{
+	static constexpr u32 MAX_JSON_SIZE = 4 * 1024;
+	static constexpr u32 COOK_FLAGS = Mini::ImportFlags::CompressVertexStreams | Mini::ImportFlags::OptimizeVertexOrder |
+		Mini::ImportFlags::BuildMeshlets;
+
+	static constexpr u64 SCRATCH_MEMORY_SIZE = Megabyte(512);
+	static constexpr u64 MESH_MEMORY_SIZE = Gigabyte(4);
+
+	struct Corpus
+	{
+		char (*gltf_paths)[512];
+		char (*mesh_paths)[512];
+		u32 num_files;
+		u64 gltf_bytes;
+		u64 mesh_bytes;
+	};
+
+	// Appends to a fixed size JSON buffer.
+	static void Append(char* json, u32* length, char const* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		s32 const written = vsnprintf(json + *length, MAX_JSON_SIZE - *length, format, args);
+		va_end(args);
+		ASSERT(written >= 0 && *length + written < MAX_JSON_SIZE);
+		*length += (u32)written;
+	}
+
+	// Writes a .glb with a UV sphere of rings x rings quads, with positions, normals, texcoords and 32 bit indices.
+	static bool WriteSphereFile(char const* path, u32 rings, TestUtils::Random& random)
+	{
+		u32 const num_vertices = (rings + 1) * (rings + 1);
+		u32 const num_indices = rings * rings * 6;
+
+		u64 const positions_size = (u64)num_vertices * sizeof(vec3);
+		u64 const texcoords_size = (u64)num_vertices * sizeof(vec2);
+		u64 const indices_size = (u64)num_indices * sizeof(u32);
+		u64 const bin_size = positions_size * 2 + texcoords_size + indices_size;
+
+		u8* bin = new u8[bin_size];
+		ON_SCOPE_EXIT(delete[] bin);
+
+		vec3* positions = reinterpret_cast<vec3*>(bin);
+		vec3* normals = reinterpret_cast<vec3*>(bin + positions_size);
+		vec2* texcoords = reinterpret_cast<vec2*>(bin + positions_size * 2);
+		u32* indices = reinterpret_cast<u32*>(bin + positions_size * 2 + texcoords_size);
+
+		f32 const radius = 0.5f + (random.Next() & 0xFF) / 256.0f;
+		for (u32 ring = 0; ring <= rings; ++ring)
+		{
+			f32 const theta = Math::Pi * ring / rings;
+			for (u32 segment = 0; segment <= rings; ++segment)
+			{
+				f32 const phi = 2.0f * Math::Pi * segment / rings;
+				u32 const vertex = ring * (rings + 1) + segment;
+				vec3 const normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				normals[vertex] = normal;
+				positions[vertex] = vec3(normal.x * radius, normal.y * radius, normal.z * radius);
+				texcoords[vertex] = vec2((f32)segment / rings, (f32)ring / rings);
+			}
+		}
+
+		u32* index = indices;
+		for (u32 ring = 0; ring < rings; ++ring)
+		{
+			for (u32 segment = 0; segment < rings; ++segment)
+			{
+				u32 const a = ring * (rings + 1) + segment;
+				u32 const b = a + rings + 1;
+				*index++ = a; *index++ = b; *index++ = a + 1;
+				*index++ = a + 1; *index++ = b; *index++ = b + 1;
+			}
+		}
+
+		char json[MAX_JSON_SIZE];
+		u32 json_length = 0;
+		Append(json, &json_length, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],");
+		Append(json, &json_length, "\"buffers\":[{\"byteLength\":%llu}],\"bufferViews\":[", (unsigned long long)bin_size);
+		Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%llu},", (unsigned long long)positions_size);
+		Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},",
+			(unsigned long long)positions_size, (unsigned long long)positions_size);
+		Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},",
+			(unsigned long long)(positions_size * 2), (unsigned long long)texcoords_size);
+		Append(json, &json_length, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}],",
+			(unsigned long long)(positions_size * 2 + texcoords_size), (unsigned long long)indices_size);
+		Append(json, &json_length, "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\","
+			"\"min\":[-2,-2,-2],\"max\":[2,2,2]},", num_vertices);
+		Append(json, &json_length, "{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},", num_vertices);
+		Append(json, &json_length, "{\"bufferView\":2,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},", num_vertices);
+		Append(json, &json_length, "{\"bufferView\":3,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}],", num_indices);
+		Append(json, &json_length, "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}]}");
+
+		while (json_length % 4 != 0)
+		{
+			json[json_length++] = ' ';
+		}
+
+		u32 const header[3] = { 0x46546C67, 2, (u32)(12 + 8 + json_length + 8 + bin_size) };
+		u32 const json_chunk[2] = { json_length, 0x4E4F534A };
+		u32 const bin_chunk[2] = { (u32)bin_size, 0x004E4942 };
+
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		fwrite(header, sizeof(header), 1, file);
+		fwrite(json_chunk, sizeof(json_chunk), 1, file);
+		fwrite(json, json_length, 1, file);
+		fwrite(bin_chunk, sizeof(bin_chunk), 1, file);
+		fwrite(bin, bin_size, 1, file);
+		fclose(file);
+		return true;
+	}
+
+	static u64 GetFileSize(char const* path)
+	{
+		IO::MappedFile file;
+		if (!IO::MapFile(path, &file))
+		{
+			return 0;
+		}
+		u64 const size = file.size;
+		IO::UnmapFile(&file);
+		return size;
+	}
+
+	static void ImportWithFlags(Mini::SceneImporter* importer, char const* path, u32 flags, Memory::Arena* scratch_memory,
+		Memory::Arena* mesh_memory)
+	{
+		importer->file_path = path;
+		importer->scratch_memory = scratch_memory;
+		importer->mesh_memory = mesh_memory;
+		importer->scene_memory = nullptr;
+		importer->flags = flags;
+	}
+
+	// Writes the .glb files and cooks them, both only if they don't exist yet.
+	static bool PrepareCorpus(char const* dir, u32 num_files, u32 vertices_per_file, Memory::Arena* scratch_memory,
+		Memory::Arena* mesh_memory, Corpus* out_corpus)
+	{
+		u32 const rings = max<u32>(2, (u32)sqrtf((f32)vertices_per_file)) - 1;
+
+		out_corpus->gltf_paths = new char[num_files][512];
+		out_corpus->mesh_paths = new char[num_files][512];
+		out_corpus->num_files = num_files;
+		out_corpus->gltf_bytes = 0;
+		out_corpus->mesh_bytes = 0;
+
+		TestUtils::Random random;
+		u32 num_cooked = 0;
+		for (u32 i = 0; i < num_files; ++i)
+		{
+			snprintf(out_corpus->gltf_paths[i], sizeof(out_corpus->gltf_paths[i]), "%s/mesh_file_%u_%04u.glb", dir, rings, i);
+			snprintf(out_corpus->mesh_paths[i], sizeof(out_corpus->mesh_paths[i]), "%s/mesh_file_%u_%04u.mmesh", dir, rings, i);
+
+			u64 gltf_size = GetFileSize(out_corpus->gltf_paths[i]);
+			if (gltf_size == 0)
+			{
+				if (!WriteSphereFile(out_corpus->gltf_paths[i], rings, random))
+				{
+					fprintf(stderr, "Can't write %s\n", out_corpus->gltf_paths[i]);
+					return false;
+				}
+				gltf_size = GetFileSize(out_corpus->gltf_paths[i]);
+			}
+
+			u64 mesh_size = GetFileSize(out_corpus->mesh_paths[i]);
+			if (mesh_size == 0)
+			{
+				Memory::ClearArena(mesh_memory, false);
+				Mini::SceneImporter importer;
+				ImportWithFlags(&importer, out_corpus->gltf_paths[i], COOK_FLAGS, scratch_memory, mesh_memory);
+				Mini::MeshImport const imported = Mini::Import(&importer);
+				if (imported.num_submeshes == 0 || !MeshFile::Write(out_corpus->mesh_paths[i], &imported, scratch_memory))
+				{
+					fprintf(stderr, "Can't cook %s\n", out_corpus->gltf_paths[i]);
+					return false;
+				}
+				mesh_size = GetFileSize(out_corpus->mesh_paths[i]);
+				++num_cooked;
+			}
+
+			out_corpus->gltf_bytes += gltf_size;
+			out_corpus->mesh_bytes += mesh_size;
+		}
+
+		if (num_cooked > 0)
+		{
+			printf("Cooked %u corpus files in %s\n", num_cooked, dir);
+		}
+		return true;
+	}
+
+	static u64 SumBytes(void const* data, u64 size)
+	{
+		u8 const* bytes = static_cast<u8 const*>(data);
+		u64 sum = 0;
+		for (u64 i = 0; i < size; ++i)
+		{
+			sum += bytes[i];
+		}
+		return sum;
+	}
+
+	// What the upload reads, see the notes at the top.
+	static u64 SumStreams(Mini::MeshImport const& imported)
+	{
+		u64 sum = SumBytes(imported.index_buffer, (u64)imported.num_indices * sizeof(u16));
+		sum += SumBytes(imported.compressed_position_buffer, (u64)imported.num_vertices * sizeof(Gfx::CompressedPosition_t));
+		sum += SumBytes(imported.compressed_normal_buffer, (u64)imported.num_vertices * sizeof(Gfx::CompressedNormal_t));
+		sum += SumBytes(imported.compressed_texcoord_buffer, (u64)imported.num_vertices * sizeof(Gfx::CompressedTexCoord_t));
+		return sum + imported.num_submeshes + imported.num_meshlets;
+	}
+
+	static u64 ImportCorpus(Corpus const& corpus, u32 flags, Memory::Arena* scratch_memory, Memory::Arena* mesh_memory)
+	{
+		Memory::ClearArena(mesh_memory, false);
+
+		u64 sum = 0;
+		for (u32 i = 0; i < corpus.num_files; ++i)
+		{
+			Mini::SceneImporter importer;
+			ImportWithFlags(&importer, corpus.gltf_paths[i], flags, scratch_memory, mesh_memory);
+			Mini::MeshImport const imported = Mini::Import(&importer);
+			sum += imported.num_submeshes > 0 ? SumStreams(imported) : 0;
+		}
+		return sum;
+	}
+
+	static u64 LoadCorpus(Corpus const& corpus)
+	{
+		u64 sum = 0;
+		for (u32 i = 0; i < corpus.num_files; ++i)
+		{
+			Mini::MeshImport loaded;
+			IO::MappedFile mapping;
+			if (MeshFile::Load(corpus.mesh_paths[i], &loaded, &mapping, nullptr))
+			{
+				sum += SumStreams(loaded);
+				IO::UnmapFile(&mapping);
+			}
+		}
+		return sum;
+	}
+
+	static int Run(char const* dir, u32 num_files, u32 vertices_per_file)
+	{
+		Memory::Arena scratch_memory;
+		Memory::Arena mesh_memory;
+		Memory::InitArena(&scratch_memory, SCRATCH_MEMORY_SIZE);
+		Memory::InitArena(&mesh_memory, MESH_MEMORY_SIZE);
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch_memory); Memory::FreeArena(&mesh_memory));
+
+		Jobs::Init();
+		ON_SCOPE_EXIT(Jobs::Exit());
+
+		Corpus corpus;
+		if (!PrepareCorpus(dir, num_files, vertices_per_file, &scratch_memory, &mesh_memory, &corpus))
+		{
+			return 1;
+		}
+		ON_SCOPE_EXIT(delete[] corpus.gltf_paths; delete[] corpus.mesh_paths);
+
+		printf("Corpus: %u files, %.1f MB .glb, %.1f MB .mmesh\n", num_files, corpus.gltf_bytes / (1024.0 * 1024.0),
+			corpus.mesh_bytes / (1024.0 * 1024.0));
+
+		// Plain means compressed streams only, the least work an import can do for the same GPU layout.
+		u64 import_sum = 0;
+		u64 load_sum = 0;
+		u64 plain_sum = 0;
+		f64 const import_ms = Bench::BestOfMs(3, [&]() { import_sum = ImportCorpus(corpus, COOK_FLAGS, &scratch_memory, &mesh_memory); });
+		f64 const plain_ms = Bench::BestOfMs(3, [&]()
+		{
+			plain_sum = ImportCorpus(corpus, Mini::ImportFlags::CompressVertexStreams, &scratch_memory, &mesh_memory);
+		});
+		f64 const load_ms = Bench::BestOfMs(Bench::DEFAULT_RUNS, [&]() { load_sum = LoadCorpus(corpus); });
+
+		// A failed load is fast, and a file that doesn't match its source isn't a fair comparison.
+		if (import_sum == 0 || plain_sum == 0 || load_sum != import_sum)
+		{
+			fprintf(stderr, "Loading the corpus failed or the .mmesh files don't match the .glb files\n");
+			return 1;
+		}
+
+		printf("glTF import (cook flags):  %8.1f ms  %8.2f ms/file\n", import_ms, import_ms / num_files);
+		printf("glTF import (plain):       %8.1f ms  %8.2f ms/file\n", plain_ms, plain_ms / num_files);
+		printf("MeshFile::Load:            %8.1f ms  %8.2f ms/file  %7.1f MB/s\n", load_ms, load_ms / num_files,
+			Bench::MegabytesPerSecond(corpus.mesh_bytes, load_ms));
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <corpus_dir> [num_files] [vertices_per_file]\n", argv[0]);
+		return 1;
+	}
+
+	u32 const num_files = argc > 2 ? (u32)atoi(argv[2]) : 64;
+	u32 const vertices_per_file = argc > 3 ? (u32)atoi(argv[3]) : 32 * 1024;
+	return BenchMeshFileLoad::Run(argv[1], max<u32>(num_files, 1), vertices_per_file);
+}
@@ -0,0 +1,1242 @@
+#include "GLTFImport.h"
+
+// cgltf_write.h includes cgltf.h again, whose implementation has no include guard.
+#undef CGLTF_IMPLEMENTATION
+#define CGLTF_WRITE_IMPLEMENTATION
+#ifdef __GNUC__
+// cgltf_write() measures its output by printing into a null buffer of size 0.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#endif
+#include "external/cgltf/cgltf_write.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <float.h>
+
+// ====================================
+//  glTF Optimizer
+//  Notes:
+//  *) Offline tool that pre-optimizes assets, so loading them at
+//     runtime does less work. Geometry goes through Mini::Import()
+//     with welding, vertex order optimization and instance batching,
+//     the result is written back as glTF or GLB with cgltf_write().
+//  *) Attributes are quantized as KHR_mesh_quantization allows:
+//     16 bit positions relative to the bounds of their mesh, with the
+//     dequantization folded into the node transform, 8 bit normals and
+//     tangents, and 16 bit texcoords where they fit into [0, 1].
+//  *) Every attribute has a buffer view of its own, tightly packed with
+//     a stride that is a multiple of 4, and indices have one as well.
+//     That is the layout EXT_meshopt_compression encodes, so a meshopt
+//     encoder can run over the views as they are. The codec itself is
+//     not part of this tool.
+//  *) Instance batches become a single node with EXT_mesh_gpu_instancing.
+//     cgltf_write() knows neither extension, both are added to its
+//     output with the help of Json::Tokenize(), which is minified on
+//     the way.
+//  *) Static scenes only, skins, morph targets and animations are
+//     rejected. Materials, samplers, cameras and lights are written as
+//     they are, images are embedded into the binary buffer.
+//  *) --verify imports the output once more and compares what it
+//     draws with the source: the same number of triangles, within
+//     the same world space bounds up to the position quantization.
+//     make test runs it over tools/data/.
+//  *) Builds with GCC or Clang, see tools/Makefile. Like the engine
+//     it targets SSE4.1 and picks the AVX2 and F16C paths at runtime.
+// ====================================
+
+namespace GltfOptimize
+{
+	static constexpr u64 SCRATCH_MEMORY_SIZE = Gigabyte(2);
+	static constexpr u64 MESH_MEMORY_SIZE = Gigabyte(2);
+	static constexpr u64 SCENE_MEMORY_SIZE = Megabyte(256);
+	static constexpr u64 OUTPUT_MEMORY_SIZE = Gigabyte(2);
+
+	static constexpr u32 MESH_NONE = ~0u;
+
+	// Longest text added to the JSON in one place.
+	static constexpr u64 MAX_JSON_INSERT = 256;
+
+	// Texcoords within this distance of [0, 1] are clamped into it and stored as unorm16.
+	static constexpr f32 TEXCOORD_UNORM_TOLERANCE = 0.5f / 65535.0f;
+
+	// Bounds of the output may move this much relative to the largest extent of the scene. A 16 bit position is at
+	// most half a step off, relative to the bounds of its mesh, which fit into the scene.
+	static constexpr f32 VERIFY_BOUNDS_TOLERANCE = 1e-4f;
+
+	struct StreamType
+	{
+		enum Enum : u32
+		{
+			Indices,
+			Positions,
+			Normals,
+			Tangents,
+			TexCoords16,
+			TexCoords32,
+			Instances,
+			Images,
+
+			EnumCount
+		};
+	};
+
+	// Tightly packed data of one kind, becomes one buffer view. Images get a view each instead.
+	struct Stream
+	{
+		u8* data;
+		u64 size;
+		u64 capacity;
+		u32 stride; // Written as byteStride, 0 for indices, instances and images.
+	};
+
+	struct Options
+	{
+		char const* input_path = nullptr;
+		char const* output_path = nullptr;
+		u32 import_flags = Mini::ImportFlags::WeldVertices | Mini::ImportFlags::OptimizeVertexOrder | Mini::ImportFlags::InstanceMeshes;
+		bool b_glb = false;
+		bool b_verify = false;
+	};
+
+	// What an import draws, every instance and batch instance with its world transform.
+	struct SceneStats
+	{
+		AABB bounds;
+		u64 num_triangles;
+	};
+
+	// Text to insert into the JSON that cgltf_write() produced, at a byte offset of it.
+	struct JsonInsert
+	{
+		u64 offset;
+		char const* text;
+	};
+
+	struct Output
+	{
+		cgltf_data data;
+		Stream streams[StreamType::EnumCount];
+
+		// Upper bounds, the arrays of data are allocated for these.
+		u32 max_accessors;
+		u32 max_views;
+		u32 max_meshes;
+		u32 max_nodes;
+
+		// Maps [0, 1] positions of a mesh back into its bounds, in glTF space.
+		mat44* mesh_dequantize;
+
+		// Out mesh of the submesh range starting at a submesh, MESH_NONE if it wasn't written yet.
+		u32* submesh_meshes;
+
+		// Every node that got EXT_mesh_gpu_instancing, and its translation accessor. Rotation and scale follow it.
+		u32* instanced_nodes;
+		u32* instanced_accessors;
+		u32 num_instanced_nodes;
+
+		// Image views point at the source data until the buffer is assembled.
+		u8 const** image_data;
+	};
+
+	static void* AllocFromArena(void* user, cgltf_size size)
+	{
+		return Memory::PushSize(static_cast<Memory::Arena*>(user), size);
+	}
+
+	static void FreeFromArena(void* user, void* data)
+	{
+		UNUSED(user);
+		UNUSED(data);
+		/* NO-OP */
+	}
+
+	static bool ParseArgs(int argc, char** argv, Options* out_options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			char const* arg = argv[i];
+			if (strcmp(arg, "--tangents") == 0)
+			{
+				out_options->import_flags |= Mini::ImportFlags::GenerateTangents;
+			}
+			else if (strcmp(arg, "--no-instancing") == 0)
+			{
+				out_options->import_flags &= ~Mini::ImportFlags::InstanceMeshes;
+			}
+			else if (strcmp(arg, "--verify") == 0)
+			{
+				out_options->b_verify = true;
+			}
+			else if (arg[0] == '-')
+			{
+				return false;
+			}
+			else if (out_options->input_path == nullptr)
+			{
+				out_options->input_path = arg;
+			}
+			else if (out_options->output_path == nullptr)
+			{
+				out_options->output_path = arg;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (out_options->input_path == nullptr || out_options->output_path == nullptr)
+		{
+			return false;
+		}
+
+		u64 const length = strlen(out_options->output_path);
+		out_options->b_glb = length >= 4 && strcmp(out_options->output_path + length - 4, ".glb") == 0;
+		return true;
+	}
+
+	// Everything cgltf_write() can't express, or that Mini::Import() doesn't bring along.
+	static bool IsSupported(cgltf_data const* src, char const* path)
+	{
+		if (src->skins_count > 0 || src->animations_count > 0)
+		{
+			fprintf(stderr, "%s: skins and animations are not supported\n", path);
+			return false;
+		}
+
+		for (u64 mesh_idx = 0; mesh_idx < src->meshes_count; ++mesh_idx)
+		{
+			cgltf_mesh const* mesh = &src->meshes[mesh_idx];
+			for (u64 prim_idx = 0; prim_idx < mesh->primitives_count; ++prim_idx)
+			{
+				if (mesh->primitives[prim_idx].targets_count > 0)
+				{
+					fprintf(stderr, "%s: morph targets are not supported\n", path);
+					return false;
+				}
+
+				if (!Mini::IsImportable(&mesh->primitives[prim_idx]))
+				{
+					fprintf(stderr, "%s: mesh %u primitive %u is not a triangle list, it is dropped\n", path, (u32)mesh_idx, (u32)prim_idx);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static void InitStream(Stream* stream, Memory::Arena* arena, u64 capacity, u32 stride)
+	{
+		stream->data = (u8*)Memory::PushSize(arena, max(capacity, (u64)4), Memory::AlignPush(16));
+		stream->size = 0;
+		stream->capacity = capacity;
+		stream->stride = stride;
+	}
+
+	// Memory::AlignValue() always advances, sizes that are aligned already have to stay as they are.
+	static u64 Align4(u64 size)
+	{
+		return (size + 3) & ~(u64)3;
+	}
+
+	// Reserves size bytes at the end of the stream, aligned to 4 for the accessor that reads them.
+	static u8* PushStream(Stream* stream, u64 size, u64* out_offset)
+	{
+		ASSERT(stream->size + size <= stream->capacity);
+		*out_offset = stream->size;
+		u8* data = stream->data + stream->size;
+		stream->size = Align4(stream->size + size);
+		return data;
+	}
+
+	static cgltf_accessor* PushAccessor(Output* out, StreamType::Enum stream, u64 offset, u64 count, cgltf_type type,
+		cgltf_component_type component_type, bool b_normalized)
+	{
+		ASSERT(out->data.accessors_count < out->max_accessors);
+		cgltf_accessor* accessor = &out->data.accessors[out->data.accessors_count++];
+		MemZeroSafe(accessor);
+		accessor->component_type = component_type;
+		accessor->normalized = b_normalized;
+		accessor->type = type;
+		accessor->offset = offset;
+		accessor->count = count;
+		accessor->buffer_view = &out->data.buffer_views[stream];
+		return accessor;
+	}
+
+	static void PushAttribute(cgltf_primitive* prim, char const* name, cgltf_attribute_type type, cgltf_accessor* accessor)
+	{
+		cgltf_attribute* attrib = &prim->attributes[prim->attributes_count++];
+		MemZeroSafe(attrib);
+		attrib->name = const_cast<char*>(name);
+		attrib->type = type;
+		attrib->data = accessor;
+	}
+
+	// By value, the change of basis leaves negative zeros behind.
+	static bool IsAllZero(f32 const* values, u64 count)
+	{
+		for (u64 i = 0; i < count; ++i)
+		{
+			if (values[i] != 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool FitsUnorm(vec2 const* texcoords, u64 count)
+	{
+		f32 const low = -TEXCOORD_UNORM_TOLERANCE;
+		f32 const high = 1.0f + TEXCOORD_UNORM_TOLERANCE;
+		for (u64 i = 0; i < count; ++i)
+		{
+			if (!(texcoords[i].x >= low && texcoords[i].x <= high && texcoords[i].y >= low && texcoords[i].y <= high))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Mini::Import() mirrors z and the winding into engine space, glTF wants both back. Indices are flipped while they are copied.
+	static void ChangeBasisToGltf(Mini::MeshImport* imported)
+	{
+		Mini::InvertZ(imported->position_buffer, imported->num_vertices);
+		if (imported->normal_buffer)
+		{
+			Mini::InvertZ(imported->normal_buffer, imported->num_vertices);
+		}
+		if (imported->tangent_buffer)
+		{
+			Mini::ChangeTangentBasisStrided((u8*)imported->tangent_buffer, imported->num_vertices, sizeof(Gfx::Tangent_t));
+		}
+	}
+
+	// Quantization bounds, flat axes get an extent of 1 so the dequantization stays invertible.
+	static AABB GetQuantizationBounds(vec3 const* positions, u64 count)
+	{
+		AABB bounds = Bounds::ComputeAABB(positions, count);
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			if (!(bounds.max.data[axis] > bounds.min.data[axis]))
+			{
+				bounds.max.data[axis] = bounds.min.data[axis] + 1.0f;
+			}
+		}
+		return bounds;
+	}
+
+	static void WriteSubMesh(Output* out, Mini::MeshImport const* imported, u32 submesh_idx, AABB const& bounds, cgltf_primitive* prim,
+		Memory::Arena* output_memory, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		Gfx::SubMesh const& submesh = imported->submeshes[submesh_idx];
+		u32 const base = submesh.base_vertex_location;
+		u32 const count = Mini::GetSubMeshVertexCount(imported, submesh_idx);
+
+		MemZeroSafe(prim);
+		prim->type = cgltf_primitive_type_triangles;
+		prim->attributes = Memory::PushType<cgltf_attribute>(output_memory, 4);
+
+		u32 const material = imported->submesh_materials[submesh_idx];
+		prim->material = (material != Mini::MATERIAL_NONE) ? &out->data.materials[material] : nullptr;
+
+		// Indices stay 16 bit and relative to the submesh, every accessor starts at the submesh's first vertex.
+		{
+			u64 offset;
+			u16* dst = (u16*)PushStream(&out->streams[StreamType::Indices], sizeof(u16) * submesh.num_indices, &offset);
+			StreamCopy::CopyFlippedWinding(dst, imported->index_buffer + submesh.first_index_location, submesh.num_indices);
+			prim->indices = PushAccessor(out, StreamType::Indices, offset, submesh.num_indices, cgltf_type_scalar, cgltf_component_type_r_16u, false);
+		}
+
+		{
+			u64 offset;
+			unorm16x4* dst = (unorm16x4*)PushStream(&out->streams[StreamType::Positions], sizeof(unorm16x4) * count, &offset);
+			Quantize::QuantizePositions(imported->position_buffer + base, dst, count, bounds);
+
+			cgltf_accessor* accessor = PushAccessor(out, StreamType::Positions, offset, count, cgltf_type_vec3, cgltf_component_type_r_16u, true);
+			accessor->has_min = true;
+			accessor->has_max = true;
+			accessor->min[0] = accessor->min[1] = accessor->min[2] = 65535.0f;
+			for (u32 i = 0; i < count; ++i)
+			{
+				accessor->min[0] = min(accessor->min[0], (f32)dst[i].x);
+				accessor->min[1] = min(accessor->min[1], (f32)dst[i].y);
+				accessor->min[2] = min(accessor->min[2], (f32)dst[i].z);
+				accessor->max[0] = max(accessor->max[0], (f32)dst[i].x);
+				accessor->max[1] = max(accessor->max[1], (f32)dst[i].y);
+				accessor->max[2] = max(accessor->max[2], (f32)dst[i].z);
+			}
+			PushAttribute(prim, "POSITION", cgltf_attribute_type_position, accessor);
+		}
+
+		// Primitives without normals or tangents of their own have zeros in the shared streams.
+		if (imported->normal_buffer && !IsAllZero(&imported->normal_buffer[base].x, count * 3))
+		{
+			vec4* normals = Memory::PushType<vec4>(scratch_memory, count);
+			for (u32 i = 0; i < count; ++i)
+			{
+				vec3 const& n = imported->normal_buffer[base + i];
+				normals[i] = vec4(n.x, n.y, n.z, 0.0f);
+			}
+
+			u64 offset;
+			snorm8x4* dst = (snorm8x4*)PushStream(&out->streams[StreamType::Normals], sizeof(snorm8x4) * count, &offset);
+			Quantize::EncodeSnorm8(normals, dst, count);
+			PushAttribute(prim, "NORMAL", cgltf_attribute_type_normal,
+				PushAccessor(out, StreamType::Normals, offset, count, cgltf_type_vec3, cgltf_component_type_r_8, true));
+		}
+
+		if (imported->tangent_buffer && !IsAllZero(&imported->tangent_buffer[base].x, count * 4))
+		{
+			u64 offset;
+			snorm8x4* dst = (snorm8x4*)PushStream(&out->streams[StreamType::Tangents], sizeof(snorm8x4) * count, &offset);
+			Quantize::EncodeSnorm8(imported->tangent_buffer + base, dst, count);
+			PushAttribute(prim, "TANGENT", cgltf_attribute_type_tangent,
+				PushAccessor(out, StreamType::Tangents, offset, count, cgltf_type_vec4, cgltf_component_type_r_8, true));
+		}
+
+		if (imported->texcoord_buffer)
+		{
+			vec2 const* texcoords = imported->texcoord_buffer + base;
+			cgltf_accessor* accessor;
+			if (FitsUnorm(texcoords, count))
+			{
+				u64 offset;
+				u16* dst = (u16*)PushStream(&out->streams[StreamType::TexCoords16], sizeof(u16) * 2 * count, &offset);
+				for (u32 i = 0; i < count; ++i)
+				{
+					dst[i * 2 + 0] = (u16)(Clamp(texcoords[i].x, 0.0f, 1.0f) * 65535.0f + 0.5f);
+					dst[i * 2 + 1] = (u16)(Clamp(texcoords[i].y, 0.0f, 1.0f) * 65535.0f + 0.5f);
+				}
+				accessor = PushAccessor(out, StreamType::TexCoords16, offset, count, cgltf_type_vec2, cgltf_component_type_r_16u, true);
+			}
+			else
+			{
+				u64 offset;
+				vec2* dst = (vec2*)PushStream(&out->streams[StreamType::TexCoords32], sizeof(vec2) * count, &offset);
+				memcpy(dst, texcoords, sizeof(vec2) * count);
+				accessor = PushAccessor(out, StreamType::TexCoords32, offset, count, cgltf_type_vec2, cgltf_component_type_r_32f, false);
+			}
+			PushAttribute(prim, "TEXCOORD_0", cgltf_attribute_type_texcoord, accessor);
+		}
+	}
+
+	// Writes the submesh range as one mesh, or returns the mesh it was written as before.
+	static u32 WriteMesh(Output* out, Mini::MeshImport const* imported, u32 first_submesh, u32 num_submeshes, char* name,
+		Memory::Arena* output_memory, Memory::Arena* scratch_memory)
+	{
+		if (out->submesh_meshes[first_submesh] != MESH_NONE)
+		{
+			return out->submesh_meshes[first_submesh];
+		}
+
+		Gfx::SubMesh const& last = imported->submeshes[first_submesh + num_submeshes - 1];
+		u32 const first_vertex = imported->submeshes[first_submesh].base_vertex_location;
+		u32 const num_vertices = last.base_vertex_location + Mini::GetSubMeshVertexCount(imported, first_submesh + num_submeshes - 1) - first_vertex;
+		AABB const bounds = GetQuantizationBounds(imported->position_buffer + first_vertex, num_vertices);
+
+		u32 const mesh_idx = (u32)out->data.meshes_count++;
+		ASSERT(mesh_idx < out->max_meshes);
+		cgltf_mesh* mesh = &out->data.meshes[mesh_idx];
+		MemZeroSafe(mesh);
+		mesh->name = name;
+		mesh->primitives = Memory::PushType<cgltf_primitive>(output_memory, num_submeshes);
+		mesh->primitives_count = num_submeshes;
+
+		for (u32 i = 0; i < num_submeshes; ++i)
+		{
+			WriteSubMesh(out, imported, first_submesh + i, bounds, &mesh->primitives[i], output_memory, scratch_memory);
+		}
+
+		vec3 const extent(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z);
+		out->mesh_dequantize[mesh_idx] = mat44(
+			extent.x, 0.0f, 0.0f, bounds.min.x,
+			0.0f, extent.y, 0.0f, bounds.min.y,
+			0.0f, 0.0f, extent.z, bounds.min.z,
+			0.0f, 0.0f, 0.0f, 1.0f);
+
+		out->submesh_meshes[first_submesh] = mesh_idx;
+		return mesh_idx;
+	}
+
+	static cgltf_node* PushNode(Output* out)
+	{
+		ASSERT(out->data.nodes_count < out->max_nodes);
+		cgltf_node* node = &out->data.nodes[out->data.nodes_count++];
+		MemZeroSafe(node);
+		return node;
+	}
+
+	// The dequantization goes into the node's own transform if nothing else depends on it,
+	// otherwise the mesh moves to a new child node.
+	static void PlaceMesh(Output* out, u32 node_idx, u32 mesh_idx, Memory::Arena* output_memory)
+	{
+		cgltf_node* node = &out->data.nodes[node_idx];
+		mat44 const& dequantize = out->mesh_dequantize[mesh_idx];
+
+		if (node->children_count == 0 && node->camera == nullptr && node->light == nullptr)
+		{
+			mat44 local;
+			cgltf_node_transform_local(node, local.data);
+			mat44 const transform = local * dequantize;
+
+			memcpy(node->matrix, transform.data, sizeof(node->matrix));
+			node->has_matrix = true;
+			node->has_translation = false;
+			node->has_rotation = false;
+			node->has_scale = false;
+			node->mesh = &out->data.meshes[mesh_idx];
+			return;
+		}
+
+		cgltf_node* child = PushNode(out);
+		child->mesh = &out->data.meshes[mesh_idx];
+		memcpy(child->matrix, dequantize.data, sizeof(child->matrix));
+		child->has_matrix = true;
+
+		cgltf_node** children = Memory::PushType<cgltf_node*>(output_memory, (u32)node->children_count + 1);
+		memcpy(children, node->children, sizeof(cgltf_node*) * node->children_count);
+		children[node->children_count] = child;
+		node->children = children;
+		node->children_count++;
+	}
+
+	static mat44 ToMat44(mat34 const& mat)
+	{
+		return mat44(
+			mat(0, 0), mat(0, 1), mat(0, 2), mat(0, 3),
+			mat(1, 0), mat(1, 1), mat(1, 2), mat(1, 3),
+			mat(2, 0), mat(2, 1), mat(2, 2), mat(2, 3),
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	static cgltf_node* FindRoot(cgltf_node* node)
+	{
+		while (node->parent != nullptr)
+		{
+			node = node->parent;
+		}
+		return node;
+	}
+
+	// One node per batch carries all of its instances, in world space. Their source nodes lose the mesh.
+	static void WriteInstanceBatch(Output* out, cgltf_data const* src, Mini::MeshImport const* imported, Gfx::InstanceBatch const& batch,
+		u32 const* hierarchy_to_source, Memory::Arena* output_memory, Memory::Arena* scratch_memory)
+	{
+		cgltf_node* first_node = &src->nodes[hierarchy_to_source[imported->batch_instance_nodes[batch.first_instance]]];
+		u32 const mesh_idx = WriteMesh(out, imported, batch.first_submesh, batch.num_submeshes, first_node->mesh->name,
+			output_memory, scratch_memory);
+		mat44 const& dequantize = out->mesh_dequantize[mesh_idx];
+
+		u32 const count = batch.num_instances;
+		u64 translation_offset, rotation_offset, scale_offset;
+		Stream* stream = &out->streams[StreamType::Instances];
+		vec3* translations = (vec3*)PushStream(stream, sizeof(vec3) * count, &translation_offset);
+		quat* rotations = (quat*)PushStream(stream, sizeof(quat) * count, &rotation_offset);
+		vec3* scales = (vec3*)PushStream(stream, sizeof(vec3) * count, &scale_offset);
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			u32 const source_node = hierarchy_to_source[imported->batch_instance_nodes[batch.first_instance + i]];
+			out->data.nodes[source_node].mesh = nullptr;
+
+			// Instance transforms are relative to their node, and in engine space like everything the importer produces.
+			mat44 world;
+			cgltf_node_transform_world(&src->nodes[source_node], world.data);
+			mat34 const instance = Mini::ChangeBasis(imported->batch_instance_transforms[batch.first_instance + i]);
+
+			Scene::Transform const transform = Scene::DecomposeTransform(world * ToMat44(instance) * dequantize);
+			translations[i] = transform.translation;
+			rotations[i] = transform.rotation;
+			scales[i] = transform.scale;
+		}
+
+		u32 const translation_accessor = (u32)out->data.accessors_count;
+		PushAccessor(out, StreamType::Instances, translation_offset, count, cgltf_type_vec3, cgltf_component_type_r_32f, false);
+		PushAccessor(out, StreamType::Instances, rotation_offset, count, cgltf_type_vec4, cgltf_component_type_r_32f, false);
+		PushAccessor(out, StreamType::Instances, scale_offset, count, cgltf_type_vec3, cgltf_component_type_r_32f, false);
+
+		cgltf_node* node = PushNode(out);
+		node->name = first_node->mesh->name;
+		node->mesh = &out->data.meshes[mesh_idx];
+
+		u32 const node_idx = (u32)(node - out->data.nodes);
+		out->instanced_nodes[out->num_instanced_nodes] = node_idx;
+		out->instanced_accessors[out->num_instanced_nodes] = translation_accessor;
+		out->num_instanced_nodes++;
+
+		// The batch node joins the scene its first instance is in.
+		cgltf_node const* root = FindRoot(first_node);
+		for (u64 scene_idx = 0; scene_idx < src->scenes_count; ++scene_idx)
+		{
+			cgltf_scene const* src_scene = &src->scenes[scene_idx];
+			for (u64 i = 0; i < src_scene->nodes_count; ++i)
+			{
+				if (src_scene->nodes[i] == root)
+				{
+					cgltf_scene* scene = &out->data.scenes[scene_idx];
+					scene->nodes[scene->nodes_count++] = node;
+					return;
+				}
+			}
+		}
+	}
+
+	static char const* GetImageMimeType(u8 const* data, u64 size)
+	{
+		if (size >= 8 && memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0)
+		{
+			return "image/png";
+		}
+		if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+		{
+			return "image/jpeg";
+		}
+		return nullptr;
+	}
+
+	// Images that can be read move into the binary buffer, the rest keep their uri. Images are
+	// shared with the source, their views are rebased onto the output.
+	static void EmbedImages(Output* out, cgltf_data* src, cgltf_options const* options, char const* input_path, Memory::Arena* scratch_memory)
+	{
+		Stream* stream = &out->streams[StreamType::Images];
+		for (u64 image_idx = 0; image_idx < src->images_count; ++image_idx)
+		{
+			cgltf_image* image = &src->images[image_idx];
+
+			u8 const* data = nullptr;
+			u64 size = 0;
+			if (!Mini::ReadImageData(image, options, input_path, scratch_memory, &data, &size))
+			{
+				image->buffer_view = nullptr;
+				fprintf(stderr, "%s: image %u can't be read, it keeps its uri\n", input_path, (u32)image_idx);
+				continue;
+			}
+
+			char const* mime_type = image->mime_type ? image->mime_type : GetImageMimeType(data, size);
+			if (mime_type == nullptr)
+			{
+				image->buffer_view = nullptr;
+				fprintf(stderr, "%s: image %u has an unknown type, it keeps its uri\n", input_path, (u32)image_idx);
+				continue;
+			}
+
+			u32 const view_idx = (u32)out->data.buffer_views_count++;
+			ASSERT(view_idx < out->max_views);
+			cgltf_buffer_view* view = &out->data.buffer_views[view_idx];
+			MemZeroSafe(view);
+			view->buffer = &out->data.buffers[0];
+			view->offset = stream->size;
+			view->size = size;
+
+			out->image_data[view_idx] = data;
+			stream->size = Align4(stream->size + size);
+
+			image->buffer_view = view;
+			image->uri = nullptr;
+			image->mime_type = const_cast<char*>(mime_type);
+		}
+	}
+
+	// Views of the streams come first and are in StreamType order, the image views follow.
+	static u8* AssembleBuffer(Output* out, Memory::Arena* output_memory)
+	{
+		u64 size = 0;
+		for (u32 type = 0; type < StreamType::Images; ++type)
+		{
+			cgltf_buffer_view* view = &out->data.buffer_views[type];
+			view->offset = size;
+			view->size = out->streams[type].size;
+			size += view->size;
+		}
+
+		u64 const images_offset = size;
+		size += out->streams[StreamType::Images].size;
+
+		u8* buffer = (u8*)Memory::PushSize(output_memory, max(size, (u64)4), Memory::ZeroAndAlignPush(16));
+		for (u32 type = 0; type < StreamType::Images; ++type)
+		{
+			memcpy(buffer + out->data.buffer_views[type].offset, out->streams[type].data, out->streams[type].size);
+		}
+
+		for (u64 view_idx = StreamType::Images; view_idx < out->data.buffer_views_count; ++view_idx)
+		{
+			cgltf_buffer_view* view = &out->data.buffer_views[view_idx];
+			view->offset += images_offset;
+			memcpy(buffer + view->offset, out->image_data[view_idx], view->size);
+		}
+
+		out->data.buffers[0].size = size;
+		return buffer;
+	}
+
+	// Views without data are dropped, everything that points at the views is rebased.
+	static void RemoveEmptyViews(Output* out, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u32* remap = Memory::PushType<u32>(scratch_memory, (u32)out->data.buffer_views_count);
+		u32 num_views = 0;
+		for (u64 view_idx = 0; view_idx < out->data.buffer_views_count; ++view_idx)
+		{
+			remap[view_idx] = num_views;
+			if (out->data.buffer_views[view_idx].size > 0)
+			{
+				out->data.buffer_views[num_views++] = out->data.buffer_views[view_idx];
+			}
+		}
+
+		cgltf_buffer_view* views = out->data.buffer_views;
+		for (u64 i = 0; i < out->data.accessors_count; ++i)
+		{
+			out->data.accessors[i].buffer_view = &views[remap[out->data.accessors[i].buffer_view - views]];
+		}
+		for (u64 i = 0; i < out->data.images_count; ++i)
+		{
+			if (out->data.images[i].buffer_view != nullptr)
+			{
+				out->data.images[i].buffer_view = &views[remap[out->data.images[i].buffer_view - views]];
+			}
+		}
+		out->data.buffer_views_count = num_views;
+	}
+
+	static void AddArrayItems(JsonInsert* inserts, u32* num_inserts, char const* json, Json::Token const* tokens, s32 num_tokens,
+		char const* key, char const* items, Memory::Arena* arena)
+	{
+		s32 const array = Json::FindValue(json, tokens, num_tokens, 0, key);
+		char* text = Memory::PushType<char>(arena, MAX_JSON_INSERT);
+		if (array >= 0 && tokens[array].type == Json::TokenType::Array)
+		{
+			MiniPrintf(text, MAX_JSON_INSERT, "%s%s", false, items, tokens[array].size > 0 ? ", " : "");
+			inserts[(*num_inserts)++] = { (u64)tokens[array].start + 1, text };
+		}
+		else
+		{
+			MiniPrintf(text, MAX_JSON_INSERT, "\"%s\": [%s], ", false, key, items);
+			inserts[(*num_inserts)++] = { (u64)tokens[0].start + 1, text };
+		}
+	}
+
+	// cgltf_write() indents its output, whitespace outside of strings is dropped while copying. b_in_string carries over
+	// between calls. Returns the number of bytes written.
+	static u64 CopyMinified(char* dst, char const* src, u64 size, bool* b_in_string)
+	{
+		u64 dst_size = 0;
+		for (u64 i = 0; i < size; ++i)
+		{
+			char const c = src[i];
+			if (*b_in_string)
+			{
+				dst[dst_size++] = c;
+				if (c == '\\' && i + 1 < size)
+				{
+					dst[dst_size++] = src[++i];
+				}
+				else if (c == '"')
+				{
+					*b_in_string = false;
+				}
+			}
+			else if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+			{
+				dst[dst_size++] = c;
+				*b_in_string = (c == '"');
+			}
+		}
+		return dst_size;
+	}
+
+	// cgltf_write() knows neither KHR_mesh_quantization nor EXT_mesh_gpu_instancing, they are added to its output. Returns
+	// the minified JSON with its length, without a null terminator.
+	static char* AddExtensions(Output const* out, char const* json, u64 length, u64* out_length, Memory::Arena* output_memory,
+		Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		s32 const num_tokens = Json::Tokenize(json, length, nullptr, 0);
+		ASSERT(num_tokens > 0);
+		Json::Token* tokens = Memory::PushType<Json::Token>(scratch_memory, (u32)num_tokens);
+		Json::Tokenize(json, length, tokens, (u64)num_tokens);
+
+		JsonInsert* inserts = Memory::PushType<JsonInsert>(scratch_memory, out->num_instanced_nodes + 2);
+		u32 num_inserts = 0;
+
+		char const* items = (out->num_instanced_nodes > 0) ? "\"KHR_mesh_quantization\", \"EXT_mesh_gpu_instancing\"" : "\"KHR_mesh_quantization\"";
+		AddArrayItems(inserts, &num_inserts, json, tokens, num_tokens, "extensionsUsed", items, scratch_memory);
+		AddArrayItems(inserts, &num_inserts, json, tokens, num_tokens, "extensionsRequired", items, scratch_memory);
+
+		// Array elements are the tokens whose parent is the array, in order.
+		s32 const nodes = Json::FindValue(json, tokens, num_tokens, 0, "nodes");
+		u32 node_idx = 0;
+		u32 next_instanced = 0;
+		for (s32 token = nodes + 1; nodes >= 0 && token < num_tokens && next_instanced < out->num_instanced_nodes; ++token)
+		{
+			if (tokens[token].parent != nodes)
+			{
+				continue;
+			}
+
+			if (node_idx++ == out->instanced_nodes[next_instanced])
+			{
+				u32 const accessor = out->instanced_accessors[next_instanced++];
+				char* text = Memory::PushType<char>(scratch_memory, MAX_JSON_INSERT);
+				MiniPrintf(text, MAX_JSON_INSERT, "\"extensions\": { \"EXT_mesh_gpu_instancing\": { \"attributes\": "
+					"{ \"TRANSLATION\": %u, \"ROTATION\": %u, \"SCALE\": %u } } }, ", false, accessor, accessor + 1, accessor + 2);
+				inserts[num_inserts++] = { (u64)tokens[token].start + 1, text };
+			}
+		}
+		ASSERT(next_instanced == out->num_instanced_nodes);
+
+		// Stable, the two arrays may both go to the start of the root object.
+		for (u32 i = 1; i < num_inserts; ++i)
+		{
+			JsonInsert const insert = inserts[i];
+			u32 j = i;
+			for (; j > 0 && inserts[j - 1].offset > insert.offset; --j)
+			{
+				inserts[j] = inserts[j - 1];
+			}
+			inserts[j] = insert;
+		}
+
+		u64 total = length;
+		for (u32 i = 0; i < num_inserts; ++i)
+		{
+			total += strlen(inserts[i].text);
+		}
+
+		char* result = (char*)Memory::PushSize(output_memory, total + 1);
+		u64 src_offset = 0;
+		u64 dst_offset = 0;
+		bool b_in_string = false;
+		for (u32 i = 0; i <= num_inserts; ++i)
+		{
+			u64 const end = (i < num_inserts) ? inserts[i].offset : length;
+			dst_offset += CopyMinified(result + dst_offset, json + src_offset, end - src_offset, &b_in_string);
+			src_offset = end;
+
+			if (i < num_inserts)
+			{
+				dst_offset += CopyMinified(result + dst_offset, inserts[i].text, strlen(inserts[i].text), &b_in_string);
+			}
+		}
+		result[dst_offset] = '\0';
+
+		*out_length = dst_offset;
+		return result;
+	}
+
+	// Header and a JSON chunk padded with spaces, then the binary chunk padded with zeros.
+	static bool SaveGlb(char const* path, char const* json, u64 json_length, u8 const* bin, u64 bin_size, Memory::Arena* scratch_memory)
+	{
+		Memory::TemporaryAllocation alloc = BeginTemporaryAlloc(scratch_memory);
+		ON_SCOPE_EXIT(Memory::RewindTemporaryAlloc(scratch_memory, alloc, false));
+
+		u64 const json_chunk_size = Align4(json_length);
+		u64 const bin_chunk_size = Align4(bin_size);
+		u64 const size = GlbHeaderSize + GlbChunkHeaderSize + json_chunk_size + (bin_size > 0 ? GlbChunkHeaderSize + bin_chunk_size : 0);
+
+		u8* file = (u8*)Memory::PushSize(scratch_memory, size, Memory::ZeroAndAlignPush(4));
+		u32* header = (u32*)file;
+		header[0] = GlbMagic;
+		header[1] = GlbVersion;
+		header[2] = (u32)size;
+		header[3] = (u32)json_chunk_size;
+		header[4] = GlbMagicJsonChunk;
+
+		u8* json_chunk = file + GlbHeaderSize + GlbChunkHeaderSize;
+		memset(json_chunk, ' ', json_chunk_size);
+		memcpy(json_chunk, json, json_length);
+
+		if (bin_size > 0)
+		{
+			u32* bin_header = (u32*)(json_chunk + json_chunk_size);
+			bin_header[0] = (u32)bin_chunk_size;
+			bin_header[1] = GlbMagicBinChunk;
+			memcpy(bin_header + 2, bin, bin_size);
+		}
+
+		return IO::SaveFile(path, file, size);
+	}
+
+	// The binary buffer of a .gltf goes next to it, with the extension swapped for .bin.
+	static void GetBinPath(char const* gltf_path, char* out_path, u64 path_size, char const** out_uri)
+	{
+		MiniPrintf(out_path, path_size, "%s", false, gltf_path);
+		char* extension = strrchr(out_path, '.');
+		char const* separator = max(strrchr(out_path, '/'), strrchr(out_path, '\\'));
+		if (extension == nullptr || extension < separator)
+		{
+			extension = out_path + strlen(out_path);
+		}
+		MiniPrintf(extension, path_size - (extension - out_path), ".bin", false);
+
+		separator = max(strrchr(out_path, '/'), strrchr(out_path, '\\'));
+		*out_uri = separator ? separator + 1 : out_path;
+	}
+
+	static void AddDrawnSubMeshes(SceneStats* stats, Mini::MeshImport const* imported, u32 first_submesh, u32 num_submeshes,
+		mat34 const& world)
+	{
+		for (u32 submesh_idx = first_submesh; submesh_idx < first_submesh + num_submeshes; ++submesh_idx)
+		{
+			Gfx::SubMesh const& submesh = imported->submeshes[submesh_idx];
+			vec3 const* positions = imported->position_buffer + submesh.base_vertex_location;
+			u32 const count = Mini::GetSubMeshVertexCount(imported, submesh_idx);
+			for (u32 i = 0; i < count; ++i)
+			{
+				vec4 const position = Math::Mul(world, vec4(positions[i].x, positions[i].y, positions[i].z, 1.0f));
+				for (u32 axis = 0; axis < 3; ++axis)
+				{
+					stats->bounds.min.data[axis] = min(stats->bounds.min.data[axis], position.data[axis]);
+					stats->bounds.max.data[axis] = max(stats->bounds.max.data[axis], position.data[axis]);
+				}
+			}
+			stats->num_triangles += submesh.num_indices / 3;
+		}
+	}
+
+	// In engine space, so the source is measured before ChangeBasisToGltf().
+	static SceneStats MeasureScene(Mini::MeshImport const* imported)
+	{
+		SceneStats stats;
+		stats.bounds.min = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		stats.bounds.max = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		stats.num_triangles = 0;
+
+		for (u32 i = 0; i < imported->num_instances; ++i)
+		{
+			Gfx::MeshInstance const& instance = imported->instances[i];
+			AddDrawnSubMeshes(&stats, imported, instance.first_submesh, instance.num_submeshes,
+				Scene::GetWorldTransform(&imported->hierarchy, instance.node));
+		}
+
+		for (u32 batch_idx = 0; batch_idx < imported->num_instance_batches; ++batch_idx)
+		{
+			Gfx::InstanceBatch const& batch = imported->instance_batches[batch_idx];
+			for (u32 i = batch.first_instance; i < batch.first_instance + batch.num_instances; ++i)
+			{
+				mat34 const& node_world = Scene::GetWorldTransform(&imported->hierarchy, imported->batch_instance_nodes[i]);
+				AddDrawnSubMeshes(&stats, imported, batch.first_submesh, batch.num_submeshes, node_world * imported->batch_instance_transforms[i]);
+			}
+		}
+
+		return stats;
+	}
+
+	// Imports the output as it is, without any flags, and compares it with what the source draws.
+	static bool VerifyOutput(char const* path, SceneStats const& expected, Memory::Arena* scratch_memory, Memory::Arena* mesh_memory,
+		Memory::Arena* scene_memory)
+	{
+		Mini::SceneImporter importer;
+		importer.file_path = path;
+		importer.scratch_memory = scratch_memory;
+		importer.mesh_memory = mesh_memory;
+		importer.scene_memory = scene_memory;
+		importer.flags = 0;
+
+		Mini::MeshImport const reimported = Mini::Import(&importer);
+		if (reimported.num_submeshes == 0 || reimported.position_buffer == nullptr)
+		{
+			fprintf(stderr, "%s: failed to import the output again\n", path);
+			return false;
+		}
+
+		SceneStats const stats = MeasureScene(&reimported);
+		if (stats.num_triangles != expected.num_triangles)
+		{
+			fprintf(stderr, "%s: draws %llu triangles, the source %llu\n", path, (unsigned long long)stats.num_triangles,
+				(unsigned long long)expected.num_triangles);
+			return false;
+		}
+
+		f32 extent = 0.0f;
+		f32 difference = 0.0f;
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			extent = max(extent, expected.bounds.max.data[axis] - expected.bounds.min.data[axis]);
+			difference = max(difference, fabsf(stats.bounds.min.data[axis] - expected.bounds.min.data[axis]));
+			difference = max(difference, fabsf(stats.bounds.max.data[axis] - expected.bounds.max.data[axis]));
+		}
+
+		if (expected.num_triangles > 0 && !(difference <= extent * VERIFY_BOUNDS_TOLERANCE))
+		{
+			fprintf(stderr, "%s: world space bounds are %g off the source's, more than %g of its extent %g\n", path, difference,
+				VERIFY_BOUNDS_TOLERANCE, extent);
+			return false;
+		}
+
+		printf("%s: verified, %llu triangles, bounds within %g of the source\n", path, (unsigned long long)stats.num_triangles, difference);
+		return true;
+	}
+
+	static int Run(Options const& options)
+	{
+		Memory::Arena scratch_memory, mesh_memory, scene_memory, output_memory;
+		Memory::InitArena(&scratch_memory, SCRATCH_MEMORY_SIZE);
+		Memory::InitArena(&mesh_memory, MESH_MEMORY_SIZE);
+		Memory::InitArena(&scene_memory, SCENE_MEMORY_SIZE);
+		Memory::InitArena(&output_memory, OUTPUT_MEMORY_SIZE);
+		ON_SCOPE_EXIT(Memory::FreeArena(&scratch_memory); Memory::FreeArena(&mesh_memory); Memory::FreeArena(&scene_memory);
+			Memory::FreeArena(&output_memory));
+
+		FrameTimer timer;
+		ResetTimer(timer);
+
+		// The source is parsed once more next to the import, for everything that is written as it is and for the node order.
+		Mini::MappedFiles mapped_files;
+		ON_SCOPE_EXIT(Mini::UnmapAllFiles(&mapped_files));
+
+		cgltf_options parse_options;
+		MemZeroSafe(parse_options);
+		parse_options.memory.alloc = &AllocFromArena;
+		parse_options.memory.free = &FreeFromArena;
+		parse_options.memory.user_data = &output_memory;
+		parse_options.file.read = &Mini::MapFileForCgltf;
+		parse_options.file.release = &Mini::ReleaseFileForCgltf;
+		parse_options.file.user_data = &mapped_files;
+
+		cgltf_data* src;
+		if (cgltf_parse_file(&parse_options, options.input_path, &src) != cgltf_result_success)
+		{
+			fprintf(stderr, "%s: failed to parse\n", options.input_path);
+			return 1;
+		}
+
+		if (Mini::DecodeDataUris(src, &output_memory) != cgltf_result_success ||
+			cgltf_load_buffers(&parse_options, src, options.input_path) != cgltf_result_success)
+		{
+			fprintf(stderr, "%s: failed to load buffers\n", options.input_path);
+			return 1;
+		}
+
+		if (!IsSupported(src, options.input_path))
+		{
+			return 1;
+		}
+
+		Mini::SceneImporter importer;
+		importer.file_path = options.input_path;
+		importer.scratch_memory = &scratch_memory;
+		importer.mesh_memory = &mesh_memory;
+		importer.scene_memory = &scene_memory;
+		importer.flags = options.import_flags;
+
+		Mini::MeshImport imported = Mini::Import(&importer);
+		if (imported.num_submeshes == 0 || imported.position_buffer == nullptr)
+		{
+			fprintf(stderr, "%s: no triangles to optimize\n", options.input_path);
+			return 1;
+		}
+
+		SceneStats const source_stats = options.b_verify ? MeasureScene(&imported) : SceneStats();
+		ChangeBasisToGltf(&imported);
+
+		// Same hierarchy as the importer builds, its remap leads from instance nodes back to source nodes.
+		Scene::Hierarchy hierarchy;
+		u32* node_remap = Memory::PushType<u32>(&output_memory, (u32)src->nodes_count + 1);
+		Mini::ImportHierarchy(src, &scratch_memory, &scratch_memory, &hierarchy, node_remap);
+
+		u32* hierarchy_to_source = Memory::PushType<u32>(&output_memory, (u32)src->nodes_count + 1);
+		for (u32 node_idx = 0; node_idx < src->nodes_count; ++node_idx)
+		{
+			hierarchy_to_source[node_remap[node_idx]] = node_idx;
+		}
+
+		Output out;
+		MemZeroSafe(out);
+		out.max_accessors = imported.num_submeshes * 5 + imported.num_instance_batches * 3;
+		out.max_views = StreamType::Images + (u32)src->images_count;
+		out.max_meshes = imported.num_submeshes;
+		out.max_nodes = (u32)src->nodes_count * 2 + imported.num_instance_batches;
+
+		u64 const num_vertices = imported.num_vertices;
+		InitStream(&out.streams[StreamType::Indices], &output_memory, sizeof(u16) * (imported.num_indices + imported.num_submeshes), 0);
+		InitStream(&out.streams[StreamType::Positions], &output_memory, sizeof(unorm16x4) * num_vertices, sizeof(unorm16x4));
+		InitStream(&out.streams[StreamType::Normals], &output_memory, sizeof(snorm8x4) * num_vertices, sizeof(snorm8x4));
+		InitStream(&out.streams[StreamType::Tangents], &output_memory, sizeof(snorm8x4) * num_vertices, sizeof(snorm8x4));
+		InitStream(&out.streams[StreamType::TexCoords16], &output_memory, sizeof(u16) * 2 * num_vertices, sizeof(u16) * 2);
+		InitStream(&out.streams[StreamType::TexCoords32], &output_memory, sizeof(vec2) * num_vertices, sizeof(vec2));
+		InitStream(&out.streams[StreamType::Instances], &output_memory, (sizeof(vec3) * 2 + sizeof(quat)) * imported.num_batch_instances, 0);
+
+		out.mesh_dequantize = Memory::PushType<mat44>(&output_memory, out.max_meshes);
+		out.submesh_meshes = Memory::PushType<u32>(&output_memory, imported.num_submeshes);
+		memset(out.submesh_meshes, 0xFF, sizeof(u32) * imported.num_submeshes);
+		out.instanced_nodes = Memory::PushType<u32>(&output_memory, max(imported.num_instance_batches, 1u));
+		out.instanced_accessors = Memory::PushType<u32>(&output_memory, max(imported.num_instance_batches, 1u));
+		out.image_data = Memory::PushType<u8 const*>(&output_memory, out.max_views);
+
+		cgltf_data* data = &out.data;
+		data->asset.version = const_cast<char*>("2.0");
+		data->asset.generator = const_cast<char*>("GltfOptimize");
+		data->asset.copyright = src->asset.copyright;
+
+		// Extras are written from the source JSON, their offsets are relative to it.
+		data->file_data = const_cast<char*>(src->json);
+
+		data->materials = src->materials;
+		data->materials_count = src->materials_count;
+		data->textures = src->textures;
+		data->textures_count = src->textures_count;
+		data->images = src->images;
+		data->images_count = src->images_count;
+		data->samplers = src->samplers;
+		data->samplers_count = src->samplers_count;
+		data->cameras = src->cameras;
+		data->cameras_count = src->cameras_count;
+		data->lights = src->lights;
+		data->lights_count = src->lights_count;
+
+		char bin_path[IO::s_max_path];
+		data->buffers = Memory::PushType<cgltf_buffer>(&output_memory, 1, Memory::ZeroPush());
+		data->buffers_count = 1;
+		if (!options.b_glb)
+		{
+			char const* bin_uri;
+			GetBinPath(options.output_path, bin_path, sizeof(bin_path), &bin_uri);
+			data->buffers[0].uri = const_cast<char*>(bin_uri);
+		}
+
+		data->buffer_views = Memory::PushType<cgltf_buffer_view>(&output_memory, out.max_views, Memory::ZeroPush());
+		data->buffer_views_count = StreamType::Images;
+		for (u32 type = 0; type < StreamType::Images; ++type)
+		{
+			cgltf_buffer_view* view = &data->buffer_views[type];
+			view->buffer = &data->buffers[0];
+			view->stride = out.streams[type].stride;
+			view->type = (type == StreamType::Indices) ? cgltf_buffer_view_type_indices : cgltf_buffer_view_type_vertices;
+		}
+
+		data->accessors = Memory::PushType<cgltf_accessor>(&output_memory, out.max_accessors);
+		data->meshes = Memory::PushType<cgltf_mesh>(&output_memory, out.max_meshes);
+
+		// Source nodes keep their index, meshes are placed on them below.
+		data->nodes = Memory::PushType<cgltf_node>(&output_memory, out.max_nodes);
+		data->nodes_count = src->nodes_count;
+		for (u64 node_idx = 0; node_idx < src->nodes_count; ++node_idx)
+		{
+			cgltf_node const* src_node = &src->nodes[node_idx];
+			cgltf_node* node = &data->nodes[node_idx];
+			*node = *src_node;
+			node->mesh = nullptr;
+			node->parent = src_node->parent ? &data->nodes[src_node->parent - src->nodes] : nullptr;
+
+			// cgltf_write() writes an empty children array for a non-null pointer.
+			if (src_node->children_count > 0)
+			{
+				node->children = Memory::PushType<cgltf_node*>(&output_memory, (u32)src_node->children_count);
+				for (u64 i = 0; i < src_node->children_count; ++i)
+				{
+					node->children[i] = &data->nodes[src_node->children[i] - src->nodes];
+				}
+			}
+		}
+
+		data->scenes = Memory::PushType<cgltf_scene>(&output_memory, max((u32)src->scenes_count, 1u));
+		data->scenes_count = src->scenes_count;
+		for (u64 scene_idx = 0; scene_idx < src->scenes_count; ++scene_idx)
+		{
+			cgltf_scene const* src_scene = &src->scenes[scene_idx];
+			cgltf_scene* scene = &data->scenes[scene_idx];
+			*scene = *src_scene;
+
+			// Room for the node of every batch.
+			scene->nodes = Memory::PushType<cgltf_node*>(&output_memory, (u32)src_scene->nodes_count + imported.num_instance_batches + 1);
+			for (u64 i = 0; i < src_scene->nodes_count; ++i)
+			{
+				scene->nodes[i] = &data->nodes[src_scene->nodes[i] - src->nodes];
+			}
+		}
+		data->scene = src->scene ? &data->scenes[src->scene - src->scenes] : nullptr;
+
+		for (u32 i = 0; i < imported.num_instances; ++i)
+		{
+			Gfx::MeshInstance const& instance = imported.instances[i];
+			u32 const node_idx = hierarchy_to_source[instance.node];
+			u32 const mesh_idx = WriteMesh(&out, &imported, instance.first_submesh, instance.num_submeshes, src->nodes[node_idx].mesh->name,
+				&output_memory, &scratch_memory);
+			PlaceMesh(&out, node_idx, mesh_idx, &output_memory);
+		}
+
+		for (u32 i = 0; i < imported.num_instance_batches; ++i)
+		{
+			WriteInstanceBatch(&out, src, &imported, imported.instance_batches[i], hierarchy_to_source, &output_memory, &scratch_memory);
+		}
+
+		EmbedImages(&out, src, &parse_options, options.input_path, &scratch_memory);
+		u8 const* bin = AssembleBuffer(&out, &output_memory);
+		u64 const bin_size = data->buffers[0].size;
+		RemoveEmptyViews(&out, &scratch_memory);
+
+		cgltf_options write_options;
+		MemZeroSafe(write_options);
+		cgltf_size const written_size = cgltf_write(&write_options, nullptr, 0, data);
+		char* written = (char*)Memory::PushSize(&output_memory, written_size);
+		cgltf_write(&write_options, written, written_size, data);
+
+		u64 json_length;
+		char const* json = AddExtensions(&out, written, written_size - 1, &json_length, &output_memory, &scratch_memory);
+
+		bool b_saved;
+		if (options.b_glb)
+		{
+			b_saved = SaveGlb(options.output_path, json, json_length, bin, bin_size, &scratch_memory);
+		}
+		else
+		{
+			b_saved = IO::SaveFile(options.output_path, json, json_length) && IO::SaveFile(bin_path, bin, bin_size);
+		}
+
+		if (!b_saved)
+		{
+			fprintf(stderr, "%s: failed to write\n", options.output_path);
+			return 1;
+		}
+
+		u64 src_buffer_size = 0;
+		for (u64 i = 0; i < src->buffers_count; ++i)
+		{
+			src_buffer_size += src->buffers[i].size;
+		}
+
+		TickTimer(timer);
+		printf("%s -> %s: %u meshes, %u vertices, %u triangles, %u batches of %u instances, buffers %llu -> %llu bytes, %.2f ms\n",
+			options.input_path, options.output_path, (u32)data->meshes_count, imported.num_vertices, imported.num_indices / 3,
+			imported.num_instance_batches, imported.num_batch_instances, (unsigned long long)src_buffer_size,
+			(unsigned long long)bin_size, GetTotalTimeS(timer) * 1000.0f);
+
+		if (options.b_verify && !VerifyOutput(options.output_path, source_stats, &scratch_memory, &mesh_memory, &scene_memory))
+		{
+			return 1;
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	GltfOptimize::Options options;
+	if (!GltfOptimize::ParseArgs(argc, argv, &options))
+	{
+		fprintf(stderr,
+			"Usage: %s [--tangents] [--no-instancing] [--verify] <input.gltf|glb> <output.gltf|glb>\n"
+			"  --tangents       Generate missing normals and tangents.\n"
+			"  --no-instancing  Keep one node per mesh instance instead of EXT_mesh_gpu_instancing batches.\n"
+			"  --verify         Import the output again, fail if it draws other triangle counts or bounds than the source.\n",
+			argv[0]);
+		return 1;
+	}
+
+	return GltfOptimize::Run(options);
+}
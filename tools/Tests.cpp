@@ -0,0 +1,62 @@
+#include "Animation.h"
+#include "Base64.h"
+#include "BlockCompression.h"
+#include "Bounds.h"
+#include "ImageDecode.h"
+#include "IO.h"
+#include "Json.h"
+#include "Jobs.h"
+#include "Math.h"
+#include "MeshFile.h"
+#include "MeshImport.h"
+#include "Meshlets.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "MipGeneration.h"
+#include "Morph.h"
+#include "SceneGraph.h"
+#include "Skinning.h"
+#include "StreamCopy.h"
+#include "TangentSpace.h"
+#include "VertexQuantization.h"
+
+// ====================================
+//  Unit Test Runner
+//  Notes:
+//  *) Runs the same Test::Run() functions the engine runs at startup,
+//     without a window. ASSERT only fires with _DEBUG, see the test
+//     target in tools/Makefile.
+//  *) Every SIMD kernel is checked against its scalar reference, on
+//     the SSE4.1 baseline and on whatever the CPU has on top of it.
+// ====================================
+
+int main()
+{
+	Jobs::Init();
+
+	Math::Test::Run();
+	Quantize::Test::Run();
+	Bounds::Test::Run();
+	MeshFile::Test::Run();
+	Scene::Test::Run();
+	StreamCopy::Test::Run();
+	Base64::Test::Run();
+	Image::Test::Run();
+	BlockCompression::Test::Run();
+	MipGeneration::Test::Run();
+	Skinning::Test::Run();
+	Animation::Test::Run();
+	Morph::Test::Run();
+	Json::Test::Run();
+	IO::Test::Run();
+	Mini::Test::Run();
+	MeshOpt::Test::Run();
+	Meshlets::Test::Run();
+	TangentSpace::Test::Run();
+	MeshOpt::Test::RunSimplify();
+
+	Jobs::Exit();
+
+	printf("All unit tests passed\n");
+	return 0;
+}